@@ -68,7 +68,7 @@ void dynamic_array_push_back(Dynamic_Array* array, void const* value)
         dynamic_array_reserve(array, array->capacity * 2);
     }
 
-    memory_system_copy((char)array->data + array->size * array->stride, value, array->stride);
+    memory_system_copy((char*)array->data + array->size * array->stride, value, array->stride);
     array->size++;
 }
 
@@ -76,8 +76,11 @@ void dynamic_array_pop(Dynamic_Array* array, void* value)
 {
     if (array->size > 0)
     {
-        memory_system_copy(value, (char)array->data + array->size * array->stride - 1, array->stride);
         array->size--;
+        if (value)
+        {
+            memory_system_copy(value, (char*)array->data + array->size * array->stride, array->stride);
+        }
     }
     else
     {
@@ -90,7 +93,7 @@ void* dynamic_array_at(Dynamic_Array* array, u32 pos)
 {
     if (pos < array->size)
     {
-        return (char)array->data + pos * array->stride;
+        return (char*)array->data + pos * array->stride;
     }
 
     LOG_FATAL("dynamic_array_at: Range check failed");
@@ -64,27 +64,67 @@ bool freelist_free(Freelist* list, u32 offset, u32 size)
     new_entry.size = size;
 
     Linked_List_Node* prev = 0;
-    for (Linked_List_Node** head = list->nodes->head; (*head); head = &(*head)->next)
+    Linked_List_Node* node = *list->nodes->head;
+    for (; node; node = node->next)
     {
-        if (((Freelist_Entry*)*head)->offset > offset)
+        if (((Freelist_Entry*)node->data)->offset > offset)
         {
-            linked_list_insert_after(list->nodes, prev, &new_entry);
-            coalesce(list->nodes, prev);
-            return true;
+            break;
         }
 
-        prev = *head;
+        prev = node;
+    }
+
+    if (!node && (new_entry.offset + new_entry.size) > list->total_size)
+    {
+        LOG_WARNING("freelist_free: Failed to free block at required offset");
+        return false;
     }
 
-    if ((new_entry.offset + new_entry.size) <= list->total_size)
+    linked_list_insert_after(list->nodes, prev, &new_entry);
+    coalesce(list->nodes, prev ? prev : *list->nodes->head);
+    return true;
+}
+
+bool freelist_resize(Freelist* list, u32 new_size)
+{
+    if (new_size < list->total_size)
+    {
+        LOG_WARNING("freelist_resize: Failed to shrink the list");
+        return false;
+    }
+
+    if (new_size == list->total_size)
     {
-        linked_list_insert_after(list->nodes, prev, &new_entry);
-        coalesce(list->nodes, prev);
         return true;
     }
 
-    LOG_WARNING("freelist_free: Failed to free block at required offset");
-    return false;
+    u32 old_size = list->total_size;
+    list->total_size = new_size;
+    return freelist_free(list, old_size, new_size - old_size);
+}
+
+u32 freelist_free_space(Freelist const* list)
+{
+    u32 free_space = 0;
+    for (Linked_List_Node const* node = *list->nodes->head; node; node = node->next)
+    {
+        free_space += ((Freelist_Entry*)node->data)->size;
+    }
+
+    return free_space;
+}
+
+u32 freelist_largest_free_block(Freelist const* list)
+{
+    u32 largest = 0;
+    for (Linked_List_Node const* node = *list->nodes->head; node; node = node->next)
+    {
+        u32 size = ((Freelist_Entry*)node->data)->size;
+        largest = size > largest ? size : largest;
+    }
+
+    return largest;
 }
 
 void* insert(void const* data)
@@ -107,6 +147,11 @@ bool compare(void const* node_data, void const* offset)
 void coalesce(Linked_List const* nodes, Linked_List_Node* first)
 {
     Linked_List_Node* second = first->next;
+    if (!second)
+    {
+        return;
+    }
+
     Linked_List_Node* third = second->next;
 
     Freelist_Entry* first_entry = first->data;
@@ -16,3 +16,19 @@ LIB_API Freelist* freelist_create(u32 size);
 LIB_API void freelist_destroy(Freelist* list);
 LIB_API bool freelist_allocate(Freelist* list, u32 required_size, u32* offset);
 LIB_API bool freelist_free(Freelist* list, u32 offset, u32 size);
+
+/**
+ * @brief Grows the list to _new_size_. The space added is free and joins a free block ending where the list did.
+ * @return false if _new_size_ is smaller than the current size.
+ */
+LIB_API bool freelist_resize(Freelist* list, u32 new_size);
+
+/**
+ * @return The size of all free blocks together.
+ */
+LIB_API u32 freelist_free_space(Freelist const* list);
+
+/**
+ * @return The size of the largest free block, which is the most that freelist_allocate can hand out at once.
+ */
+LIB_API u32 freelist_largest_free_block(Freelist const* list);
@@ -7,20 +7,67 @@
 #include "logger.h"
 #include "math/math_types.h"
 #include "memory/linear_allocator.h"
+#include "platform/filesystem.h"
 #include "platform/platform.h"
+#include "resources/image_cache.h"
+#include "resources/loaders/image_loader.h"
 #include "renderer/renderer_frontend.h"
 #include "systems/geometry_system.h"
-#include "systems/resource_system.h"
+#include "systems/resource_manager.h"
+#include "systems/streaming_system.h"
 #include "systems/material_system.h"
 #include "systems/memory_system.h"
 #include "systems/texture_system.h"
 
 
 #include "systems/shader_system.h"
+#include "systems/job_system.h"
 
 
 #include "string_utils.h"
 
+#include <stdlib.h>
+
+/**
+ * @brief Steps of application startup. Each stage declares the stages it depends on, and independent stages run in parallel on the job system.
+ */
+typedef enum Startup_Stage_Id
+{
+    STARTUP_STAGE_EVENT,
+    STARTUP_STAGE_LOGGER,
+    STARTUP_STAGE_INPUT,
+    STARTUP_STAGE_PLATFORM,
+    STARTUP_STAGE_RESOURCE,
+    STARTUP_STAGE_STREAMING,
+    STARTUP_STAGE_SHADER,
+    STARTUP_STAGE_RENDERER,
+    STARTUP_STAGE_TEXTURE,
+    STARTUP_STAGE_TEXTURE_PRELOAD,
+    STARTUP_STAGE_TEXTURE_UPLOAD,
+    STARTUP_STAGE_MATERIAL,
+    STARTUP_STAGE_GEOMETRY,
+    STARTUP_STAGE_ENUM_COUNT
+} Startup_Stage_Id;
+
+#define STARTUP_DEPENDENCY(stage) (1u << (stage))
+
+typedef struct Startup_Stage
+{
+    char const* name;
+    u32 dependencies;
+    // Window and GPU work stays on the main thread.
+    b8 main_thread;
+    b8 (* startup)(void);
+
+    b8 result;
+    i64 volatile finished;
+    u64 thread_id;
+    f64 start_time;
+    f64 end_time;
+} Startup_Stage;
+
+#define MAX_PRELOAD_TEXTURE_COUNT 32
+
 typedef struct application_state
 {
     game_instance* instance;
@@ -58,6 +105,12 @@ typedef struct application_state
         void* block;
     } resource_system;
 
+    struct
+    {
+        u64 required_memory;
+        void* block;
+    } streaming_system;
+
     struct
     {
         u64 required_memory;
@@ -102,6 +155,28 @@ typedef struct application_state
         void* block;
     } geometry_system;
 
+    struct
+    {
+        u64 required_memory;
+        void* block;
+    } job_system;
+
+    // Guards systems_allocator while systems start up in parallel.
+    platform_mutex systems_allocator_mutex;
+    renderer_backend_type renderer_backend;
+
+    Startup_Stage startup_stages[STARTUP_STAGE_ENUM_COUNT];
+    // Textures from application_config.preload_texture_names, decoded in parallel during startup.
+    char const* const* preload_texture_names;
+    u32 preload_texture_count;
+    File_Read_Request preload_reads[MAX_PRELOAD_TEXTURE_COUNT];
+    File_View preload_views[MAX_PRELOAD_TEXTURE_COUNT];
+    Resource_Data preloaded_textures[MAX_PRELOAD_TEXTURE_COUNT];
+    b8 preloaded_texture_results[MAX_PRELOAD_TEXTURE_COUNT];
+
+    f64 init_start_time;
+    u64 frame_count;
+
     // TODO: temp
     Geometry* test_geometry;
     Geometry* test_ui_geometry;
@@ -114,6 +189,26 @@ b8 application_on_event(u16 code, void const* sender, void const* listener, even
 b8 application_on_key(u16 code, void const* sender, void const* listener, event_context context);
 b8 application_on_resize(u16 code, void const* sender, void const* listener, event_context context);
 
+static void* allocate_system_block(u64 required_memory);
+static b8 run_startup_graph();
+static void startup_stage_job(void* params);
+static void run_startup_stage(Startup_Stage* stage);
+static void preload_texture_job(void* params);
+
+static b8 event_stage_startup();
+static b8 logger_stage_startup();
+static b8 input_stage_startup();
+static b8 platform_stage_startup();
+static b8 resource_stage_startup();
+static b8 streaming_stage_startup();
+static b8 shader_stage_startup();
+static b8 renderer_stage_startup();
+static b8 texture_stage_startup();
+static b8 texture_preload_stage_startup();
+static b8 texture_upload_stage_startup();
+static b8 material_stage_startup();
+static b8 geometry_stage_startup();
+
 b8 application_init(game_instance* instance)
 {
     if (instance->application_block)
@@ -122,6 +217,8 @@ b8 application_init(game_instance* instance)
         return FALSE;
     }
 
+    f64 init_start_time = platform_get_absolute_time();
+
     memory_system_configuration memory_system_config = {};
     memory_system_config.tracked_memory = GIBIBYTES(1);
     if (!memory_system_startup(memory_system_config))
@@ -136,108 +233,78 @@ b8 application_init(game_instance* instance)
     state->instance = instance;
     state->running = FALSE;
     state->suspended = FALSE;
+    state->init_start_time = init_start_time;
+    state->frame_count = 0;
 
-    u64 systems_allocator_requered_memory = MEBIBYTES(64);
-    linear_allocator_create(systems_allocator_requered_memory, 0, &state->systems_allocator);
-
-    event_system_startup(&state->event_system.required_memory, 0);
-    state->event_system.block = linear_allocator_allocate(&state->systems_allocator, state->event_system.required_memory);
-    if (!event_system_startup(&state->event_system.required_memory, state->event_system.block))
-    {
-        LOG_FATAL("application_init: Failed to startup event system");
-        return FALSE;
-    }
-
-    logger_system_startup(&state->logger_system.required_memory, 0);
-    state->logger_system.block = linear_allocator_allocate(&state->systems_allocator, state->logger_system.required_memory);
-    if (!logger_system_startup(&state->logger_system.required_memory, state->logger_system.block))
-    {
-        LOG_FATAL("application_init: Failed to startup logger system");
-        return FALSE;
-    }
-
-    input_system_startup(&state->input_system.required_memory, 0);
-    state->input_system.block = linear_allocator_allocate(&state->systems_allocator, state->input_system.required_memory);
-    if (!input_system_startup(&state->input_system.required_memory, state->input_system.block))
-    {
-        LOG_FATAL("application_init: Failed to startup input system");
-        return FALSE;
-    }
-
-    platform_system_startup(&state->platform_system.required_memory, 0, 0, 0, 0, 0, 0, 0);
-    state->platform_system.block = linear_allocator_allocate(&state->systems_allocator, state->platform_system.required_memory);
-    if (!platform_system_startup(&state->platform_system.required_memory, state->platform_system.block, &state->platform, state->instance->application_config.name, state->instance->application_config.x, state->instance->application_config.y, state->instance->application_config.width, state->instance->application_config.height))
+    state->preload_texture_names = instance->application_config.preload_texture_names;
+    state->preload_texture_count = instance->application_config.preload_texture_count;
+    if (state->preload_texture_count > MAX_PRELOAD_TEXTURE_COUNT)
     {
-        LOG_FATAL("application_init: Failed to startup platform system");
-        return FALSE;
+        LOG_WARNING("application_init: Only the first %u of %u textures are preloaded", MAX_PRELOAD_TEXTURE_COUNT, state->preload_texture_count);
+        state->preload_texture_count = MAX_PRELOAD_TEXTURE_COUNT;
     }
 
-    Resource_System_Config resource_system_config;
-    resource_system_config.asset_folder_path = ASSETS_DIR;
-    resource_system_config.max_loader_count = 32;
-    resource_system_startup(&state->resource_system.required_memory, 0, resource_system_config);
-    state->resource_system.block = linear_allocator_allocate(&state->systems_allocator, state->resource_system.required_memory);
-    if(!resource_system_startup(&state->resource_system.required_memory, state->resource_system.block, resource_system_config))
-    {
-        LOG_FATAL("application_init: Failed to startup resource system");
-        return FALSE;
-    }
+    u64 systems_allocator_requered_memory = MEBIBYTES(64);
+    linear_allocator_create(systems_allocator_requered_memory, 0, &state->systems_allocator);
+    platform_mutex_create(&state->systems_allocator_mutex);
 
-    // Shader system
+    // ENGINE_RENDERER=null overrides the game's choice, so any executable can be run headless
+    state->renderer_backend = instance->application_config.renderer_backend;
+    char const* backend_override = getenv("ENGINE_RENDERER");
+    if (backend_override && string_equali(backend_override, "null"))
     {
-        Shader_System_Config config = {};
-        config.max_shader_count = 1024;
-        config.max_uniform_buffer_count = 128;
-        config.max_global_texture_count = 31;
-        config.max_instance_texture_count = 31;
-        if (!shader_system_startup(&state->shader_system.required_memory, 0, &config))
-        {
-            LOG_FATAL("application_init: Failed to startup shader system");
-            return FALSE;
-        }
-
-        state->shader_system.block = linear_allocator_allocate(&state->systems_allocator, state->shader_system.required_memory);
-        if (!shader_system_startup(&state->shader_system.required_memory, state->shader_system.block, &config))
-        {
-            LOG_FATAL("application_init: Failed to startup shader system");
-            return FALSE;
-        }
+        state->renderer_backend = RENDERER_BACKEND_TYPE_NULL;
     }
 
-    renderer_system_startup(&state->renderer_system.required_memory, 0, 0);
-    state->renderer_system.block = linear_allocator_allocate(&state->systems_allocator, state->renderer_system.required_memory);
-    if (!renderer_system_startup(&state->renderer_system.required_memory, state->renderer_system.block, instance->application_config.name))
+    // Packed assets shadow loose files with the same path.
+    filesystem_mount_directory(ASSETS_DIR);
+    char pack_path[256];
+    string_format(pack_path, "%s/%s", ASSETS_DIR, "assets.pack");
+    u64 pack_size;
+    if (filesystem_size_of(pack_path, &pack_size))
     {
-        LOG_FATAL("application_init: Failed to initialize renderer system");
-        return FALSE;
+        filesystem_mount_pack(pack_path);
     }
 
-    Texture_System_Config texture_system_config;
-    texture_system_config.max_texture_count = 65536;
-    texture_system_startup(&state->texture_system.required_memory, 0, texture_system_config);
-    state->texture_system.block = linear_allocator_allocate(&state->systems_allocator, state->texture_system.required_memory);
-    if (!texture_system_startup(&state->texture_system.required_memory, state->texture_system.block, texture_system_config))
+    // The job system runs the parallel part of startup, so it is brought up first.
+    Job_System_Config job_system_config;
+    u32 processor_count = platform_get_processor_count();
+    job_system_config.worker_count = processor_count > 1 ? processor_count - 1 : 0;
+    job_system_config.max_job_count = 1024;
+    job_system_startup(&state->job_system.required_memory, 0, job_system_config);
+    state->job_system.block = allocate_system_block(state->job_system.required_memory);
+    if (!job_system_startup(&state->job_system.required_memory, state->job_system.block, job_system_config))
     {
-        LOG_FATAL("application_init: Failed to initialize texture system. Shutting down...");
+        LOG_FATAL("application_init: Failed to startup job system");
         return FALSE;
     }
 
-    Material_System_Config material_sys_config;
-    material_sys_config.max_material_count = 4096;
-    material_system_startup(&state->material_system.required_memory, 0, material_sys_config);
-    state->material_system.block = linear_allocator_allocate(&state->systems_allocator, state->material_system.required_memory);
-    if (!material_system_startup(&state->material_system.required_memory, state->material_system.block, material_sys_config)) {
-        LOG_FATAL("application_init: Failed to initialize material_resource system");
-        return FALSE;
-    }
-
-    Geometry_System_Config geometry_system_config;
-    geometry_system_config.max_geometry_count = 4096;
-    geometry_system_startup(&state->geometry_system.required_memory, 0, geometry_system_config);
-    state->geometry_system.block = linear_allocator_allocate(&state->systems_allocator, state->material_system.required_memory);
-    if (!geometry_system_startup(&state->geometry_system.required_memory, state->geometry_system.block, geometry_system_config))
+    Startup_Stage* stages = state->startup_stages;
+    stages[STARTUP_STAGE_EVENT] = (Startup_Stage){ "event", 0, FALSE, event_stage_startup };
+    stages[STARTUP_STAGE_LOGGER] = (Startup_Stage){ "logger", 0, FALSE, logger_stage_startup };
+    stages[STARTUP_STAGE_INPUT] = (Startup_Stage){ "input", STARTUP_DEPENDENCY(STARTUP_STAGE_EVENT), FALSE, input_stage_startup };
+    stages[STARTUP_STAGE_PLATFORM] = (Startup_Stage){ "platform",
+        STARTUP_DEPENDENCY(STARTUP_STAGE_EVENT) | STARTUP_DEPENDENCY(STARTUP_STAGE_LOGGER) | STARTUP_DEPENDENCY(STARTUP_STAGE_INPUT),
+        TRUE, platform_stage_startup };
+    stages[STARTUP_STAGE_RESOURCE] = (Startup_Stage){ "resource", STARTUP_DEPENDENCY(STARTUP_STAGE_LOGGER), FALSE, resource_stage_startup };
+    stages[STARTUP_STAGE_STREAMING] = (Startup_Stage){ "streaming", STARTUP_DEPENDENCY(STARTUP_STAGE_RESOURCE), FALSE, streaming_stage_startup };
+    stages[STARTUP_STAGE_SHADER] = (Startup_Stage){ "shader", STARTUP_DEPENDENCY(STARTUP_STAGE_RESOURCE), FALSE, shader_stage_startup };
+    stages[STARTUP_STAGE_RENDERER] = (Startup_Stage){ "renderer",
+        STARTUP_DEPENDENCY(STARTUP_STAGE_PLATFORM) | STARTUP_DEPENDENCY(STARTUP_STAGE_RESOURCE) | STARTUP_DEPENDENCY(STARTUP_STAGE_SHADER),
+        TRUE, renderer_stage_startup };
+    stages[STARTUP_STAGE_TEXTURE] = (Startup_Stage){ "texture", STARTUP_DEPENDENCY(STARTUP_STAGE_RENDERER), TRUE, texture_stage_startup };
+    stages[STARTUP_STAGE_TEXTURE_PRELOAD] = (Startup_Stage){ "texture_preload", STARTUP_DEPENDENCY(STARTUP_STAGE_RESOURCE), FALSE, texture_preload_stage_startup };
+    stages[STARTUP_STAGE_TEXTURE_UPLOAD] = (Startup_Stage){ "texture_upload",
+        STARTUP_DEPENDENCY(STARTUP_STAGE_TEXTURE) | STARTUP_DEPENDENCY(STARTUP_STAGE_TEXTURE_PRELOAD),
+        TRUE, texture_upload_stage_startup };
+    stages[STARTUP_STAGE_MATERIAL] = (Startup_Stage){ "material",
+        STARTUP_DEPENDENCY(STARTUP_STAGE_TEXTURE_UPLOAD) | STARTUP_DEPENDENCY(STARTUP_STAGE_SHADER) | STARTUP_DEPENDENCY(STARTUP_STAGE_STREAMING),
+        TRUE, material_stage_startup };
+    stages[STARTUP_STAGE_GEOMETRY] = (Startup_Stage){ "geometry", STARTUP_DEPENDENCY(STARTUP_STAGE_MATERIAL), TRUE, geometry_stage_startup };
+
+    if (!run_startup_graph())
     {
-        LOG_FATAL("application_init: Failed to initialize geometry system");
+        LOG_FATAL("application_init: Failed to startup engine systems");
         return FALSE;
     }
 
@@ -337,18 +404,6 @@ b8 application_run(void)
             f64 frameStartTime = platform_get_absolute_time();
 
 
-            if (!state->instance->on_update(state->instance, delta_time)) {
-                LOG_FATAL("Game update failed");
-                state->running = FALSE;
-                break;
-            }
-
-            if (!state->instance->on_render(state->instance, delta_time)) {
-                LOG_FATAL("Game render failed");
-                state->running = FALSE;
-                break;
-            }
-
             // TODO: temporary solution
             render_packet packet;
             packet.delta_time = delta_time;
@@ -365,7 +420,10 @@ b8 application_run(void)
             packet.ui_geometry_count = 0;
             packet.ui_render_data = 0;
 
-            renderer_frontend_draw_frame(&packet);
+            if (!application_step(&packet)) {
+                state->running = FALSE;
+                break;
+            }
 
             f64 frameEndTime = platform_get_absolute_time();
             f64 frameElapsedTime = frameEndTime - frameStartTime;
@@ -380,11 +438,43 @@ b8 application_run(void)
                 frameCount++;
             }
 
-            input_update(delta_time);
             state->lastTime = currentTime;
         }
     }
 
+    application_shutdown();
+    return TRUE;
+}
+
+b8 application_step(render_packet* packet)
+{
+    if (!state->instance->on_update(state->instance, packet->delta_time)) {
+        LOG_FATAL("Game update failed");
+        return FALSE;
+    }
+
+    // Loads requested by the game's update are started, and finished ones handed over, before the frame is rendered.
+    streaming_system_update();
+    texture_system_update();
+
+    if (!state->instance->on_render(state->instance, packet->delta_time)) {
+        LOG_FATAL("Game render failed");
+        return FALSE;
+    }
+
+    renderer_frontend_draw_frame(packet);
+    input_update(packet->delta_time);
+
+    if (state->frame_count++ == 0)
+    {
+        LOG_INFO("Time to first frame: %.3f ms", (platform_get_absolute_time() - state->init_start_time) * 1000.0);
+    }
+
+    return TRUE;
+}
+
+void application_shutdown(void)
+{
     event_unregister(EVENT_CODE_APPLICATION_QUIT, NULL, application_on_event);
     event_unregister(EVENT_CODE_KEY_PRESSED, NULL, application_on_event);
     event_unregister(EVENT_CODE_RESIZE, NULL, application_on_resize);
@@ -393,12 +483,466 @@ b8 application_run(void)
     material_system_shutdown();
     texture_system_shutdown();
     renderer_system_shutdown();
-    resource_system_shutdown();
+    streaming_system_shutdown();
+    job_system_shutdown();
+    resource_manager_shutdown();
+    image_cache_shutdown();
     platform_system_shutdown(&state->platform);
     input_system_shutdown(state->input_system.block);
     logger_system_shutdown(state->logger_system.block);
     event_system_shutdown(state->event_system.block);
+    filesystem_unmount_all();
+    platform_mutex_destroy(&state->systems_allocator_mutex);
     memory_system_shutdown();
+}
+
+void* allocate_system_block(u64 required_memory)
+{
+    platform_mutex_lock(&state->systems_allocator_mutex);
+    void* block = linear_allocator_allocate(&state->systems_allocator, required_memory);
+    platform_mutex_unlock(&state->systems_allocator_mutex);
+    return block;
+}
+
+b8 run_startup_graph()
+{
+    Startup_Stage* stages = state->startup_stages;
+    u32 all_stages = (1u << STARTUP_STAGE_ENUM_COUNT) - 1;
+    u32 started = 0;
+    u32 finished = 0;
+    b8 failed = FALSE;
+
+    while (finished != all_stages)
+    {
+        b8 progressed = FALSE;
+        for (u32 i = 0; i < STARTUP_STAGE_ENUM_COUNT; ++i)
+        {
+            u32 bit = STARTUP_DEPENDENCY(i);
+            if ((finished & bit) == 0 && stages[i].finished)
+            {
+                finished |= bit;
+                progressed = TRUE;
+                if (!stages[i].result)
+                {
+                    LOG_FATAL("run_startup_graph: Stage '%s' failed", stages[i].name);
+                    failed = TRUE;
+                }
+            }
+        }
+
+        // Nothing new is started after a failure. Stages in flight are waited for so no worker touches the state afterwards.
+        if (!failed)
+        {
+            for (u32 i = 0; i < STARTUP_STAGE_ENUM_COUNT; ++i)
+            {
+                u32 bit = STARTUP_DEPENDENCY(i);
+                if ((started & bit) || (stages[i].dependencies & finished) != stages[i].dependencies)
+                {
+                    continue;
+                }
+
+                started |= bit;
+                progressed = TRUE;
+                if (stages[i].main_thread)
+                {
+                    run_startup_stage(&stages[i]);
+                }
+                else
+                {
+                    job_system_submit(startup_stage_job, &stages[i], 0);
+                }
+            }
+        }
+        else if (started == finished)
+        {
+            return FALSE;
+        }
+
+        if (!progressed)
+        {
+            platformSleep(0);
+        }
+    }
+
+    if (failed)
+    {
+        return FALSE;
+    }
+
+    f64 init_start_time = state->init_start_time;
+    f64 serial_time = 0.0;
+    LOG_INFO("System startup timing (ms from init start):");
+    for (u32 i = 0; i < STARTUP_STAGE_ENUM_COUNT; ++i)
+    {
+        f64 duration = stages[i].end_time - stages[i].start_time;
+        serial_time += duration;
+        LOG_INFO("  %-16s %9.3f .. %9.3f  (%8.3f ms) thread %llu",
+            stages[i].name,
+            (stages[i].start_time - init_start_time) * 1000.0,
+            (stages[i].end_time - init_start_time) * 1000.0,
+            duration * 1000.0,
+            stages[i].thread_id);
+    }
+
+    LOG_INFO("System startup: %.3f ms wall, %.3f ms summed over stages",
+        (platform_get_absolute_time() - init_start_time) * 1000.0, serial_time * 1000.0);
+    return TRUE;
+}
+
+void startup_stage_job(void* params)
+{
+    run_startup_stage(params);
+}
+
+void run_startup_stage(Startup_Stage* stage)
+{
+    stage->thread_id = platform_get_current_thread_id();
+    stage->start_time = platform_get_absolute_time();
+    stage->result = stage->startup();
+    stage->end_time = platform_get_absolute_time();
+
+    // Publishes result and timings to the scheduling thread.
+    platform_atomic_add(&stage->finished, 1);
+}
+
+b8 event_stage_startup()
+{
+    event_system_startup(&state->event_system.required_memory, 0);
+    state->event_system.block = allocate_system_block(state->event_system.required_memory);
+    if (!event_system_startup(&state->event_system.required_memory, state->event_system.block))
+    {
+        LOG_FATAL("application_init: Failed to startup event system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 logger_stage_startup()
+{
+    logger_system_startup(&state->logger_system.required_memory, 0);
+    state->logger_system.block = allocate_system_block(state->logger_system.required_memory);
+    if (!logger_system_startup(&state->logger_system.required_memory, state->logger_system.block))
+    {
+        LOG_FATAL("application_init: Failed to startup logger system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 input_stage_startup()
+{
+    input_system_startup(&state->input_system.required_memory, 0);
+    state->input_system.block = allocate_system_block(state->input_system.required_memory);
+    if (!input_system_startup(&state->input_system.required_memory, state->input_system.block))
+    {
+        LOG_FATAL("application_init: Failed to startup input system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 platform_stage_startup()
+{
+    platform_system_startup(&state->platform_system.required_memory, 0, 0, 0, 0, 0, 0, 0);
+    state->platform_system.block = allocate_system_block(state->platform_system.required_memory);
+    if (!platform_system_startup(&state->platform_system.required_memory, state->platform_system.block, &state->platform, state->instance->application_config.name, state->instance->application_config.x, state->instance->application_config.y, state->instance->application_config.width, state->instance->application_config.height))
+    {
+        LOG_FATAL("application_init: Failed to startup platform system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 resource_stage_startup()
+{
+    // Decoded images are kept on disk, so later runs skip decoding. Loading works without the cache, only slower.
+    char image_cache_directory[256];
+    char const* cache_directory = getenv("ENGINE_CACHE_DIR");
+    string_format(image_cache_directory, "%s/images", cache_directory ? cache_directory : CACHE_DIR);
+    Image_Cache_Config image_cache_config = {};
+    image_cache_config.directory = image_cache_directory;
+    image_cache_config.generate_mips = true;
+    image_cache_config.mip_filter = MIP_FILTER_KAISER;
+    image_cache_startup(image_cache_config);
+
+    // Released resources stay cached up to these budgets, so reacquiring them doesn't go back to disk.
+    Resource_System_Config resource_system_config = {};
+    resource_system_config.max_resource_count = 1024;
+    resource_system_config.cache_budgets[RESOURCE_TYPE_TEXT] = MEBIBYTES(4);
+    resource_system_config.cache_budgets[RESOURCE_TYPE_BINARY] = MEBIBYTES(16);
+    resource_system_config.cache_budgets[RESOURCE_TYPE_IMAGE] = MEBIBYTES(256);
+    resource_system_config.cache_budgets[RESOURCE_TYPE_MATERIAL] = MEBIBYTES(1);
+    resource_system_config.cache_budgets[RESOURCE_TYPE_SHADER_CONFIG] = MEBIBYTES(1);
+    resource_system_config.cache_budgets[RESOURCE_TYPE_STATIC_MESH] = MEBIBYTES(64);
+    resource_manager_startup(&state->resource_system.required_memory, 0, resource_system_config);
+    state->resource_system.block = allocate_system_block(state->resource_system.required_memory);
+    if(!resource_manager_startup(&state->resource_system.required_memory, state->resource_system.block, resource_system_config))
+    {
+        LOG_FATAL("application_init: Failed to startup resource system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 streaming_stage_startup()
+{
+    // Per-frame budgets keep streaming from spiking frame times. The upload budget bounds the staging copies of a frame.
+    Streaming_System_Config streaming_system_config = {};
+    streaming_system_config.max_request_count = 4096;
+    streaming_system_config.max_in_flight_count = 64;
+    streaming_system_config.io_budget = MEBIBYTES(8);
+    streaming_system_config.upload_budget = MEBIBYTES(16);
+    streaming_system_startup(&state->streaming_system.required_memory, 0, streaming_system_config);
+    state->streaming_system.block = allocate_system_block(state->streaming_system.required_memory);
+    if (!streaming_system_startup(&state->streaming_system.required_memory, state->streaming_system.block, streaming_system_config))
+    {
+        LOG_FATAL("application_init: Failed to startup streaming system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 shader_stage_startup()
+{
+    Shader_System_Config config = {};
+    config.max_shader_count = 1024;
+    config.max_uniform_buffer_count = 128;
+    config.max_global_texture_count = 31;
+    config.max_instance_texture_count = 31;
+    if (!shader_system_startup(&state->shader_system.required_memory, 0, &config))
+    {
+        LOG_FATAL("application_init: Failed to startup shader system");
+        return FALSE;
+    }
+
+    state->shader_system.block = allocate_system_block(state->shader_system.required_memory);
+    if (!shader_system_startup(&state->shader_system.required_memory, state->shader_system.block, &config))
+    {
+        LOG_FATAL("application_init: Failed to startup shader system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 renderer_stage_startup()
+{
+    char const* name = state->instance->application_config.name;
+    renderer_system_startup(&state->renderer_system.required_memory, 0, 0, state->renderer_backend);
+    state->renderer_system.block = allocate_system_block(state->renderer_system.required_memory);
+    if (!renderer_system_startup(&state->renderer_system.required_memory, state->renderer_system.block, name, state->renderer_backend))
+    {
+        LOG_FATAL("application_init: Failed to initialize renderer system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 texture_stage_startup()
+{
+    Texture_System_Config texture_system_config;
+    texture_system_config.max_texture_count = 65536;
+    // ENGINE_TEXTURE_INGEST=resource uploads every image through an image resource, to compare ingest throughput.
+    char const* ingest_override = getenv("ENGINE_TEXTURE_INGEST");
+    texture_system_config.load_into_staging = !ingest_override || !string_equali(ingest_override, "resource");
+    texture_system_config.generate_mips = TRUE;
+    texture_system_config.mip_filter = MIP_FILTER_KAISER;
+    // Images loaded uncooked stay RGBA8 unless ENGINE_TEXTURE_COMPRESSION=bc1|bc3|bc7 opts into encoding them at load
+    // time. Cooking them is the way to ship compressed textures.
+    char const* compression_override = getenv("ENGINE_TEXTURE_COMPRESSION");
+    texture_system_config.compression = TEXTURE_FORMAT_RGBA8;
+    if (compression_override && string_equali(compression_override, "bc7"))
+    {
+        texture_system_config.compression = TEXTURE_FORMAT_BC7;
+    }
+    else if (compression_override && string_equali(compression_override, "bc1"))
+    {
+        texture_system_config.compression = TEXTURE_FORMAT_BC1;
+    }
+    else if (compression_override && string_equali(compression_override, "bc3"))
+    {
+        texture_system_config.compression = TEXTURE_FORMAT_BC3;
+    }
+    // Load time only affords the fast tier; the cook tool encodes at higher quality.
+    texture_system_config.compression_quality = BLOCK_COMPRESSION_QUALITY_FAST;
+    // Streamed textures show their 64 texel tail first. Each level above it uploads the levels below it again, so the
+    // budget is kept to what a frame can copy.
+    texture_system_config.max_streamed_count = 1024;
+    texture_system_config.stream_tail_size = 64;
+    texture_system_config.stream_upload_budget = MEBIBYTES(16);
+    // Past a GiB of textures the least recently drawn give way, which keeps clear of what most GPUs can hold.
+    texture_system_config.memory_budget = MEBIBYTES(1024);
+    texture_system_startup(&state->texture_system.required_memory, 0, texture_system_config);
+    state->texture_system.block = allocate_system_block(state->texture_system.required_memory);
+    if (!texture_system_startup(&state->texture_system.required_memory, state->texture_system.block, texture_system_config))
+    {
+        LOG_FATAL("application_init: Failed to initialize texture system. Shutting down...");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void preload_texture_job(void* params)
+{
+    u64 index = (u64)params;
+    File_View* file = &state->preload_views[index];
+    state->preloaded_texture_results[index] = image_loader_load_from_memory(file->data, file->size, &state->preloaded_textures[index]);
+    if (!state->preloaded_texture_results[index])
+    {
+        LOG_WARNING("preload_texture_job: Failed to decode image '%s'. It will be loaded on first use instead", state->preload_texture_names[index]);
+    }
+}
+
+b8 texture_preload_stage_startup()
+{
+    // Image reading and decoding do not need the renderer, so they overlap with window and device creation.
+    // Images in a mounted pack are decoded from the pack mapping. Loose files are read in one batch,
+    // and each image is decoded as soon as its read completes.
+    File_Location locations[MAX_PRELOAD_TEXTURE_COUNT];
+    File_Read_Request* reads = state->preload_reads;
+    u32 read_count = 0;
+    for (u32 i = 0; i < state->preload_texture_count; ++i)
+    {
+        char asset_path[256];
+        image_loader_get_path(state->preload_texture_names[i], asset_path);
+        memory_system_zero(&reads[i], sizeof(reads[i]));
+        memory_system_zero(&state->preload_views[i], sizeof(state->preload_views[i]));
+        if (!filesystem_locate(asset_path, &locations[i]))
+        {
+            continue;
+        }
+
+        if (locations[i].in_pack)
+        {
+            filesystem_map_asset(asset_path, &state->preload_views[i]);
+            continue;
+        }
+
+        reads[i].path = locations[i].disk_path;
+        if (filesystem_size_of(reads[i].path, &reads[i].size))
+        {
+            reads[i].buffer = memory_system_allocate(reads[i].size, MEMORY_TAG_RESOURCES);
+            read_count++;
+        }
+    }
+
+    File_Read_Batch batch;
+    filesystem_read_batch_submit(reads, state->preload_texture_count, &batch);
+
+    Job_Counter counter = {};
+    b8 decode_submitted[MAX_PRELOAD_TEXTURE_COUNT] = {};
+    u32 decode_count = 0;
+    while (decode_count < state->preload_texture_count)
+    {
+        filesystem_read_batch_poll(&batch);
+        b8 progressed = FALSE;
+        for (u32 i = 0; i < state->preload_texture_count; ++i)
+        {
+            if (decode_submitted[i] || !reads[i].completed)
+            {
+                continue;
+            }
+
+            decode_submitted[i] = TRUE;
+            decode_count++;
+            progressed = TRUE;
+            if (reads[i].succeeded && reads[i].buffer)
+            {
+                state->preload_views[i].data = reads[i].buffer;
+                state->preload_views[i].size = reads[i].bytes_read;
+            }
+
+            if (state->preload_views[i].data)
+            {
+                job_system_submit(preload_texture_job, (void*)(u64)i, &counter);
+            }
+        }
+
+        if (!progressed)
+        {
+            platformSleep(0);
+        }
+    }
+
+    filesystem_read_batch_wait(&batch);
+    job_system_wait(&counter);
+
+    for (u32 i = 0; i < state->preload_texture_count; ++i)
+    {
+        if (reads[i].buffer)
+        {
+            memory_system_free(reads[i].buffer, reads[i].size, MEMORY_TAG_RESOURCES);
+        }
+        else if (state->preload_views[i].data)
+        {
+            filesystem_unmap(&state->preload_views[i]);
+        }
+    }
+
+    LOG_DEBUG("texture_preload_stage_startup: Read %u of %u images from loose files", read_count, state->preload_texture_count);
+    return TRUE;
+}
+
+b8 texture_upload_stage_startup()
+{
+    for (u32 i = 0; i < state->preload_texture_count; ++i)
+    {
+        if (!state->preloaded_texture_results[i])
+        {
+            continue;
+        }
+
+        Image_Resource* image = (Image_Resource*)state->preloaded_textures[i].data;
+        if (image->format == TEXTURE_FORMAT_RGBA8)
+        {
+            texture_system_acquire_from_pixels(state->preload_texture_names[i], image->width, image->height, 4, image->pixels, FALSE);
+        }
+        else
+        {
+            // Images cooked to a block format can't go through the pixel path, so they are loaded again by name.
+            texture_system_acquire(state->preload_texture_names[i], FALSE);
+        }
+        resource_system_unload(&state->preloaded_textures[i]);
+        state->preloaded_texture_results[i] = FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 material_stage_startup()
+{
+    Material_System_Config material_sys_config;
+    material_sys_config.max_material_count = 4096;
+    material_system_startup(&state->material_system.required_memory, 0, material_sys_config);
+    state->material_system.block = allocate_system_block(state->material_system.required_memory);
+    if (!material_system_startup(&state->material_system.required_memory, state->material_system.block, material_sys_config))
+    {
+        LOG_FATAL("application_init: Failed to initialize material_resource system");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 geometry_stage_startup()
+{
+    Geometry_System_Config geometry_system_config;
+    geometry_system_config.max_geometry_count = 4096;
+    geometry_system_startup(&state->geometry_system.required_memory, 0, geometry_system_config);
+    state->geometry_system.block = allocate_system_block(state->geometry_system.required_memory);
+    if (!geometry_system_startup(&state->geometry_system.required_memory, state->geometry_system.block, geometry_system_config))
+    {
+        LOG_FATAL("application_init: Failed to initialize geometry system");
+        return FALSE;
+    }
 
     return TRUE;
 }
@@ -2,8 +2,20 @@
 
 #include "defines.h"
 #include "game_types.h"
+#include "renderer/renderer_types.h"
 
 LIB_API b8 application_init(game_instance* instance);
 LIB_API b8 application_run(void);
 
+/**
+ * @brief Runs a single frame without processing platform messages: game update, game render and drawing of _packet_.
+ * Allows tools to drive the engine with their own loop instead of application_run().
+ */
+LIB_API b8 application_step(render_packet* packet);
+
+/**
+ * @brief Unregisters application events and shuts down all systems. Called by application_run() on exit.
+ */
+LIB_API void application_shutdown(void);
+
 void applicationGetFramebufferSize(u32* width, u32* height);
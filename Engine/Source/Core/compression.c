@@ -0,0 +1,315 @@
+#include "compression.h"
+
+#include "systems/memory_system.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define COMPRESSION_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define LZ_MIN_MATCH 4
+// The last sequence is literals only, and the last match must end this many bytes before the end of the block.
+#define LZ_LAST_LITERALS 5
+// A match may not start in the last LZ_MATCH_LIMIT bytes of the block.
+#define LZ_MATCH_LIMIT 12
+#define LZ_MAX_OFFSET 65535
+#define LZ_HASH_LOG 14
+// Wild copies may write up to this many bytes past the end of a copy, so they are only used away from the end of the output.
+#define LZ_WILD_COPY_SIZE 16
+
+static u32 read_u32(u8 const* p);
+static u64 read_u64(u8 const* p);
+static u32 hash_sequence(u32 sequence);
+static u32 count_matching(u8 const* p, u8 const* match, u8 const* limit);
+static u8* write_length(u8* op, u64 length);
+static void copy_16(u8* destination, u8 const* source);
+
+u64 compression_lz_bound(u64 size)
+{
+    return size + size / 255 + 16;
+}
+
+u64 compression_lz_compress(void const* source, u64 source_size, void* destination, u64 destination_capacity)
+{
+    if (!source || !destination || destination_capacity < compression_lz_bound(source_size))
+    {
+        return 0;
+    }
+
+    u8 const* base = source;
+    u8 const* ip = base;
+    u8 const* anchor = base;
+    u8 const* iend = base + source_size;
+    u8* op = destination;
+
+    if (source_size > LZ_MATCH_LIMIT)
+    {
+        u8 const* match_limit = iend - LZ_MATCH_LIMIT;
+        u8 const* match_end_limit = iend - LZ_LAST_LITERALS;
+
+        // Positions are stored relative to base. 64 KiB on the stack keeps the codec free of allocations and thread safe.
+        u32 table[1 << LZ_HASH_LOG];
+        memory_system_zero(table, sizeof(table));
+
+        ip++;
+        while (ip < match_limit)
+        {
+            u32 sequence = read_u32(ip);
+            u32 hash = hash_sequence(sequence);
+            u8 const* match = base + table[hash];
+            table[hash] = (u32)(ip - base);
+
+            if (ip - match > LZ_MAX_OFFSET || match >= ip || read_u32(match) != sequence)
+            {
+                // Skip faster through incompressible data.
+                ip += 1 + ((ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && match > base && ip[-1] == match[-1])
+            {
+                --ip;
+                --match;
+            }
+
+            u64 match_length = LZ_MIN_MATCH + count_matching(ip + LZ_MIN_MATCH, match + LZ_MIN_MATCH, match_end_limit);
+            u64 literal_length = ip - anchor;
+
+            u8* token = op++;
+            *token = (u8)((literal_length >= 15 ? 15 : literal_length) << 4);
+            if (literal_length >= 15)
+            {
+                op = write_length(op, literal_length - 15);
+            }
+            memory_system_copy(op, anchor, literal_length);
+            op += literal_length;
+
+            u16 offset = (u16)(ip - match);
+            op[0] = (u8)offset;
+            op[1] = (u8)(offset >> 8);
+            op += 2;
+
+            u64 extra_match_length = match_length - LZ_MIN_MATCH;
+            *token |= (u8)(extra_match_length >= 15 ? 15 : extra_match_length);
+            if (extra_match_length >= 15)
+            {
+                op = write_length(op, extra_match_length - 15);
+            }
+
+            ip += match_length;
+            anchor = ip;
+
+            // Seed the table inside the match, so the next repeat is found sooner.
+            if (ip - 2 > base && ip < match_limit)
+            {
+                table[hash_sequence(read_u32(ip - 2))] = (u32)(ip - 2 - base);
+            }
+        }
+    }
+
+    u64 literal_length = iend - anchor;
+    *op++ = (u8)((literal_length >= 15 ? 15 : literal_length) << 4);
+    if (literal_length >= 15)
+    {
+        op = write_length(op, literal_length - 15);
+    }
+    memory_system_copy(op, anchor, literal_length);
+    op += literal_length;
+
+    return op - (u8*)destination;
+}
+
+bool compression_lz_decompress(void const* source, u64 source_size, void* destination, u64 destination_size)
+{
+    if (!source || !destination)
+    {
+        return false;
+    }
+
+    u8 const* ip = source;
+    u8 const* iend = ip + source_size;
+    u8* op = destination;
+    u8* oend = op + destination_size;
+
+    while (ip < iend)
+    {
+        u8 token = *ip++;
+
+        u64 literal_length = token >> 4;
+        if (literal_length == 15)
+        {
+            u8 byte;
+            do
+            {
+                if (ip >= iend)
+                {
+                    return false;
+                }
+                byte = *ip++;
+                literal_length += byte;
+            } while (byte == 255);
+        }
+
+        if ((u64)(iend - ip) < literal_length || (u64)(oend - op) < literal_length)
+        {
+            return false;
+        }
+
+        if ((u64)(iend - ip) >= literal_length + LZ_WILD_COPY_SIZE && (u64)(oend - op) >= literal_length + LZ_WILD_COPY_SIZE)
+        {
+            for (u64 copied = 0; copied < literal_length; copied += 16)
+            {
+                copy_16(op + copied, ip + copied);
+            }
+        }
+        else
+        {
+            memory_system_copy(op, ip, literal_length);
+        }
+        ip += literal_length;
+        op += literal_length;
+
+        // The last sequence has no match.
+        if (ip == iend)
+        {
+            break;
+        }
+
+        if (iend - ip < 2)
+        {
+            return false;
+        }
+
+        u64 offset = ip[0] | ((u64)ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (u64)(op - (u8*)destination))
+        {
+            return false;
+        }
+
+        u64 match_length = (token & 15);
+        if (match_length == 15)
+        {
+            u8 byte;
+            do
+            {
+                if (ip >= iend)
+                {
+                    return false;
+                }
+                byte = *ip++;
+                match_length += byte;
+            } while (byte == 255);
+        }
+        match_length += LZ_MIN_MATCH;
+
+        if ((u64)(oend - op) < match_length)
+        {
+            return false;
+        }
+
+        u8 const* match = op - offset;
+        if ((u64)(oend - op) >= match_length + LZ_WILD_COPY_SIZE)
+        {
+            // Each 16-byte chunk must only read bytes that are already final. With offsets below 16 the first chunk
+            // is built byte by byte, then copying from a multiple of the offset that is at least 16 repeats the same pattern.
+            u64 distance = offset;
+            u64 copied = 0;
+            if (offset < 16)
+            {
+                for (; copied < 16; ++copied)
+                {
+                    op[copied] = match[copied];
+                }
+                distance = offset * ((16 + offset - 1) / offset);
+            }
+
+            for (; copied < match_length; copied += 16)
+            {
+                copy_16(op + copied, op + copied - distance);
+            }
+        }
+        else
+        {
+            for (u64 i = 0; i < match_length; ++i)
+            {
+                op[i] = match[i];
+            }
+        }
+        op += match_length;
+    }
+
+    return op == oend;
+}
+
+u32 read_u32(u8 const* p)
+{
+    u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+u64 read_u64(u8 const* p)
+{
+    u64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+u32 hash_sequence(u32 sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_LOG);
+}
+
+u32 count_matching(u8 const* p, u8 const* match, u8 const* limit)
+{
+    u8 const* start = p;
+    while (p + 8 <= limit)
+    {
+        u64 difference = read_u64(p) ^ read_u64(match);
+        if (difference)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, difference);
+            return (u32)(p - start) + (index >> 3);
+#else
+            return (u32)(p - start) + (__builtin_ctzll(difference) >> 3);
+#endif
+        }
+        p += 8;
+        match += 8;
+    }
+
+    while (p < limit && *p == *match)
+    {
+        ++p;
+        ++match;
+    }
+
+    return (u32)(p - start);
+}
+
+u8* write_length(u8* op, u64 length)
+{
+    while (length >= 255)
+    {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (u8)length;
+    return op;
+}
+
+void copy_16(u8* destination, u8 const* source)
+{
+#if defined(COMPRESSION_SSE2)
+    _mm_storeu_si128((__m128i*)destination, _mm_loadu_si128((__m128i const*)source));
+#else
+    memcpy(destination, source, 16);
+#endif
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Block compression for cooked asset payloads.
+ * The stream is the LZ4 block format: sequences of [token][literal length][literals][offset][match length],
+ * 64 KiB window, minimum match of 4 bytes. Blocks are self-contained and carry no header; the caller stores both sizes.
+ */
+
+/**
+ * @brief Returns the largest compressed size of _size_ bytes of input. Size destination buffers with this.
+ */
+LIB_API u64 compression_lz_bound(u64 size);
+
+/**
+ * @brief Compresses _source_size_ bytes into _destination_.
+ * @param destination_capacity Must be at least compression_lz_bound(source_size).
+ * @return The compressed size, or 0 on failure.
+ */
+LIB_API u64 compression_lz_compress(void const* source, u64 source_size, void* destination, u64 destination_capacity);
+
+/**
+ * @brief Decompresses a block straight into _destination_, which must be exactly _destination_size_ bytes (the original size).
+ * Malformed input is rejected; no byte outside _destination_ is written.
+ * @return TRUE if the whole block decoded to exactly _destination_size_ bytes; otherwise FALSE.
+ */
+LIB_API bool compression_lz_decompress(void const* source, u64 source_size, void* destination, u64 destination_size);
@@ -0,0 +1,110 @@
+#include "hash.h"
+
+#include <string.h>
+
+#define PRIME_1 0x9E3779B185EBCA87ull
+#define PRIME_2 0xC2B2AE3D27D4EB4Full
+#define PRIME_3 0x165667B19E3779F9ull
+#define PRIME_4 0x85EBCA77C2B2AE63ull
+#define PRIME_5 0x27D4EB2F165667C5ull
+
+static u64 rotate_left(u64 value, u32 count);
+static u64 read_u64(u8 const* p);
+static u32 read_u32(u8 const* p);
+static u64 round_lane(u64 accumulator, u64 lane);
+static u64 merge_lane(u64 hash, u64 accumulator);
+
+u64 hash_bytes(void const* data, u64 size, u64 seed)
+{
+    u8 const* p = data;
+    u8 const* end = p + size;
+    u64 hash;
+
+    if (size >= 32)
+    {
+        // Four independent lanes keep the multiplier pipelines busy.
+        u64 v1 = seed + PRIME_1 + PRIME_2;
+        u64 v2 = seed + PRIME_2;
+        u64 v3 = seed;
+        u64 v4 = seed - PRIME_1;
+        u8 const* limit = end - 32;
+        do
+        {
+            v1 = round_lane(v1, read_u64(p));
+            v2 = round_lane(v2, read_u64(p + 8));
+            v3 = round_lane(v3, read_u64(p + 16));
+            v4 = round_lane(v4, read_u64(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        hash = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+        hash = merge_lane(hash, v1);
+        hash = merge_lane(hash, v2);
+        hash = merge_lane(hash, v3);
+        hash = merge_lane(hash, v4);
+    }
+    else
+    {
+        hash = seed + PRIME_5;
+    }
+
+    hash += size;
+
+    for (; p + 8 <= end; p += 8)
+    {
+        hash ^= round_lane(0, read_u64(p));
+        hash = rotate_left(hash, 27) * PRIME_1 + PRIME_4;
+    }
+
+    if (p + 4 <= end)
+    {
+        hash ^= (u64)read_u32(p) * PRIME_1;
+        hash = rotate_left(hash, 23) * PRIME_2 + PRIME_3;
+        p += 4;
+    }
+
+    for (; p < end; ++p)
+    {
+        hash ^= *p * PRIME_5;
+        hash = rotate_left(hash, 11) * PRIME_1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+u64 rotate_left(u64 value, u32 count)
+{
+    return (value << count) | (value >> (64 - count));
+}
+
+u64 read_u64(u8 const* p)
+{
+    u64 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+u32 read_u32(u8 const* p)
+{
+    u32 value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+u64 round_lane(u64 accumulator, u64 lane)
+{
+    accumulator += lane * PRIME_2;
+    accumulator = rotate_left(accumulator, 31);
+    return accumulator * PRIME_1;
+}
+
+u64 merge_lane(u64 hash, u64 accumulator)
+{
+    hash ^= round_lane(0, accumulator);
+    return hash * PRIME_1 + PRIME_4;
+}
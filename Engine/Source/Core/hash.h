@@ -0,0 +1,10 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * @brief 64-bit content hash of _size_ bytes (XXH64). Fast enough to hash whole assets, and stable across
+ * platforms and runs, so it can be stored on disk to detect changed sources.
+ * @param seed Mixed into the hash. Different seeds give independent hashes of the same data.
+ */
+LIB_API u64 hash_bytes(void const* data, u64 size, u64 seed);
@@ -7,6 +7,7 @@ typedef struct platform_state {
     void* specific;
 } platform_state;
 
+// A width or height of 0 starts the platform without a window (headless).
 b8 platform_system_startup(
     u64* memory_size,
     void* memory,
@@ -30,3 +31,45 @@ void platformWriteConsoleError(char const* message, u8 color);
 
 f64 platform_get_absolute_time();
 void platformSleep(u64 ms);
+
+LIB_API u32 platform_get_processor_count();
+
+typedef struct platform_thread {
+    void* internal;
+    u64 id;
+} platform_thread;
+
+typedef struct platform_mutex {
+    void* internal;
+} platform_mutex;
+
+typedef struct platform_semaphore {
+    void* internal;
+} platform_semaphore;
+
+typedef u32 (* PFN_platform_thread_start)(void* params);
+
+b8 platform_thread_create(PFN_platform_thread_start start, void* params, platform_thread* thread);
+// Waits for the thread to finish and releases it.
+void platform_thread_destroy(platform_thread* thread);
+u64 platform_get_current_thread_id();
+
+b8 platform_mutex_create(platform_mutex* mutex);
+void platform_mutex_destroy(platform_mutex* mutex);
+b8 platform_mutex_lock(platform_mutex* mutex);
+b8 platform_mutex_unlock(platform_mutex* mutex);
+
+b8 platform_semaphore_create(u32 initial_count, platform_semaphore* semaphore);
+void platform_semaphore_destroy(platform_semaphore* semaphore);
+b8 platform_semaphore_signal(platform_semaphore* semaphore);
+b8 platform_semaphore_wait(platform_semaphore* semaphore);
+
+// Atomically adds addend to value and returns the new value.
+i64 platform_atomic_add(i64 volatile* value, i64 addend);
+
+// Atomically stores new_value. Writes made before it are visible to a thread that reads new_value with
+// platform_atomic_load_acquire.
+void platform_atomic_store_release(i32 volatile* value, i32 new_value);
+
+// Atomically loads value. Writes made before the platform_atomic_store_release that stored it are visible after it.
+i32 platform_atomic_load_acquire(i32 volatile* value);
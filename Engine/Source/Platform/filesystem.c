@@ -1,8 +1,98 @@
 #include "filesystem.h"
 
+#include "core/compression.h"
 #include "core/logger.h"
+#include "core/string_utils.h"
+#include "platform/pack_format.h"
+#include "platform/platform.h"
+#include "systems/job_system.h"
 #include "systems/memory_system.h"
 
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+// Bounds the file handles a batch keeps open at once.
+#define MAX_OVERLAPPED_READ_COUNT 64
+#define MAX_READ_CHUNK_SIZE 0x40000000u
+#endif
+
+/**
+ * @brief How one request of a batch is being read.
+ */
+typedef struct Read_State
+{
+#if defined(_WIN32)
+    // First, so that the OVERLAPPED a completion reports is the read it belongs to.
+    OVERLAPPED overlapped;
+    HANDLE file;
+#endif
+    File_Read_Request* request;
+    f64 start_time;
+
+    // Reads handed to the job system. The worker sets job_finished once it is done, and polling publishes the request.
+    bool job_submitted;
+    bool job_succeeded;
+    i32 volatile job_finished;
+} Read_State;
+
+typedef struct File_Read_Batch_State
+{
+    File_Read_Request* requests;
+    Read_State* reads;
+    u32 request_count;
+    // Only changed by the thread that polls the batch, as is every request's completed flag.
+    u32 completed_count;
+
+    Job_Counter counter;
+
+#if defined(_WIN32)
+    // Overlapped reads are issued in request order, at most MAX_OVERLAPPED_READ_COUNT at once.
+    HANDLE port;
+    u32 next_request;
+    u32 in_flight_count;
+#endif
+} File_Read_Batch_State;
+
+#define MAX_MOUNT_COUNT 8
+
+typedef struct Mount
+{
+    bool is_pack;
+    char path[256];
+
+    // Packs only
+    File_View view;
+    Pack_Entry const* entries;
+    u32 entry_count;
+    char const* strings;
+} Mount;
+
+// Mounting happens at startup. Lookups only read this, so they are safe from any thread.
+static Mount mounts[MAX_MOUNT_COUNT];
+static u32 mount_count;
+
+static Pack_Entry const* find_pack_entry(Mount const* mount, char const* path);
+static Mount const* find_pack_owning(void const* data);
+static void* map_anonymous(u64 size);
+
+static void read_request_job(void* params);
+static void submit_read_job(File_Read_Batch_State* batch, u32 request_index);
+static void collect_read_jobs(File_Read_Batch_State* batch);
+static void complete_request(File_Read_Batch_State* batch, File_Read_Request* request, bool succeeded);
+#if defined(_WIN32)
+static void fill_port(File_Read_Batch_State* batch);
+static bool issue_overlapped_read(Read_State* read);
+static bool reap_port(File_Read_Batch_State* batch, DWORD timeout);
+#endif
+
 bool filesystem_open(char const* path, File_Access_Mode mode, File_Handle* file)
 {
     char const* access_mode;
@@ -62,23 +152,769 @@ void filesystem_close(File_Handle* file)
     }
 }
 
-u32 filesystem_size(File_Handle* file)
+u64 filesystem_size(File_Handle* file)
 {
-    fseek(file->handle, 0, SEEK_END);
-    u32 size = ftell(file->handle);
+#if defined(_WIN32)
+    _fseeki64(file->handle, 0, SEEK_END);
+    u64 size = _ftelli64(file->handle);
+#else
+    fseeko(file->handle, 0, SEEK_END);
+    u64 size = ftello(file->handle);
+#endif
     rewind(file->handle);
     return size;
 }
 
-bool filesystem_read(File_Handle* file, void* buffer, u32 size)
+bool filesystem_read(File_Handle* file, void* buffer, u64 size)
 {
         size_t bytes_read = fread(buffer, 1, size, file->handle);
         return bytes_read == size;
 }
 
-bool filesystem_write(File_Handle* file, u32 size, void const* data)
+bool filesystem_write(File_Handle* file, u64 size, void const* data)
 {
         size_t bytes_written = fwrite(data, 1, size, file->handle);
         fflush(file->handle);
         return bytes_written == size;
 }
+
+bool filesystem_map(char const* path, File_View* view)
+{
+    view->data = 0;
+    view->size = 0;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        LOG_ERROR("filesystem_map: Failed to open file %s", path);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        LOG_ERROR("filesystem_map: Failed to get the size of %s", path);
+        CloseHandle(file);
+        return false;
+    }
+
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return true;
+    }
+
+    // The view keeps the mapping object alive, so both handles can be closed right away.
+    HANDLE mapping = CreateFileMappingA(file, 0, PAGE_READONLY, 0, 0, 0);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        LOG_ERROR("filesystem_map: Failed to create a mapping of %s", path);
+        return false;
+    }
+
+    void const* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (!data)
+    {
+        LOG_ERROR("filesystem_map: Failed to map %s", path);
+        return false;
+    }
+
+    view->data = data;
+    view->size = size.QuadPart;
+    return true;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        LOG_ERROR("filesystem_map: Failed to open file %s", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        LOG_ERROR("filesystem_map: Failed to get the size of %s", path);
+        close(fd);
+        return false;
+    }
+
+    if (info.st_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void* data = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        LOG_ERROR("filesystem_map: Failed to map %s", path);
+        return false;
+    }
+
+    view->data = data;
+    view->size = info.st_size;
+    return true;
+#endif
+}
+
+void filesystem_unmap(File_View* view)
+{
+    // Views into a mounted pack share the pack's mapping.
+    if (view->data && !find_pack_owning(view->data))
+    {
+#if defined(_WIN32)
+        UnmapViewOfFile(view->data);
+#else
+        munmap((void*)view->data, view->size);
+#endif
+    }
+
+    view->data = 0;
+    view->size = 0;
+}
+
+bool filesystem_size_of(char const* path, u64* size)
+{
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+    {
+        return false;
+    }
+
+    *size = ((u64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    return true;
+#else
+    struct stat info;
+    if (stat(path, &info) != 0)
+    {
+        return false;
+    }
+
+    *size = info.st_size;
+    return true;
+#endif
+}
+
+bool filesystem_stat(char const* path, u64* size, u64* modified_time)
+{
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data))
+    {
+        return false;
+    }
+
+    *size = ((u64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    *modified_time = ((u64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return true;
+#else
+    struct stat info;
+    if (stat(path, &info) != 0)
+    {
+        return false;
+    }
+
+    *size = info.st_size;
+    *modified_time = (u64)info.st_mtim.tv_sec * 1000000000ull + info.st_mtim.tv_nsec;
+    return true;
+#endif
+}
+
+bool filesystem_create_directories(char const* path)
+{
+    char directory[256];
+    if (string_length(path) >= sizeof(directory))
+    {
+        LOG_ERROR("filesystem_create_directories: Path is too long: %s", path);
+        return false;
+    }
+
+    // Every parent is created on the way. Creating one that exists fails harmlessly; the last check reports real problems.
+    string_copy(directory, path);
+    for (char* c = directory + 1; ; ++c)
+    {
+        if (*c != '/' && *c != '\\' && *c != 0)
+        {
+            continue;
+        }
+
+        char separator = *c;
+        *c = 0;
+#if defined(_WIN32)
+        CreateDirectoryA(directory, 0);
+#else
+        mkdir(directory, 0755);
+#endif
+        *c = separator;
+        if (!separator)
+        {
+            break;
+        }
+    }
+
+#if defined(_WIN32)
+    DWORD attributes = GetFileAttributesA(path);
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+    struct stat info;
+    return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+bool filesystem_replace(char const* source, char const* destination)
+{
+#if defined(_WIN32)
+    return MoveFileExA(source, destination, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(source, destination) == 0;
+#endif
+}
+
+bool filesystem_read_batch_submit(File_Read_Request* requests, u32 count, File_Read_Batch* batch)
+{
+    if (!requests || !batch)
+    {
+        LOG_ERROR("filesystem_read_batch_submit: Invalid parameters");
+        return false;
+    }
+
+    File_Read_Batch_State* state = memory_system_allocate(sizeof(*state), MEMORY_TAG_RESOURCES);
+    memory_system_zero(state, sizeof(*state));
+    state->requests = requests;
+    state->request_count = count;
+    state->reads = memory_system_allocate((count ? count : 1) * sizeof(*state->reads), MEMORY_TAG_RESOURCES);
+    memory_system_zero(state->reads, (count ? count : 1) * sizeof(*state->reads));
+    batch->requests = requests;
+    batch->request_count = count;
+    batch->internal = state;
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        requests[i].bytes_read = 0;
+        requests[i].succeeded = false;
+        requests[i].completed = false;
+        requests[i].seconds = 0.0;
+        requests[i].internal = &state->reads[i];
+        state->reads[i].request = &requests[i];
+    }
+
+#if defined(_WIN32)
+    // One completion port per batch, drained only by the thread that polls it.
+    state->port = count > 0 ? CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 1) : 0;
+    if (state->port)
+    {
+        fill_port(state);
+        return true;
+    }
+#endif
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        submit_read_job(state, i);
+    }
+
+    return true;
+}
+
+u32 filesystem_read_batch_poll(File_Read_Batch* batch)
+{
+    File_Read_Batch_State* state = batch->internal;
+    if (!state)
+    {
+        return batch->request_count;
+    }
+
+#if defined(_WIN32)
+    if (state->port)
+    {
+        reap_port(state, 0);
+        fill_port(state);
+    }
+#endif
+
+    collect_read_jobs(state);
+    return state->completed_count;
+}
+
+bool filesystem_read_batch_wait(File_Read_Batch* batch)
+{
+    File_Read_Batch_State* state = batch->internal;
+    if (!state)
+    {
+        return false;
+    }
+
+#if defined(_WIN32)
+    if (state->port)
+    {
+        while (state->in_flight_count > 0 || state->next_request < state->request_count)
+        {
+            fill_port(state);
+            if (state->in_flight_count > 0 && !reap_port(state, INFINITE))
+            {
+                // The port itself failed, so nothing more will complete through it.
+                LOG_ERROR("filesystem_read_batch_wait: Failed to wait for reads. %u requests are read again", state->in_flight_count);
+                for (u32 i = 0; i < state->request_count; ++i)
+                {
+                    Read_State* read = &state->reads[i];
+                    if (read->file)
+                    {
+                        CancelIoEx(read->file, &read->overlapped);
+                        CloseHandle(read->file);
+                        read->file = 0;
+                        read->request->seconds = platform_get_absolute_time() - read->start_time;
+                        submit_read_job(state, i);
+                    }
+                }
+                state->in_flight_count = 0;
+            }
+        }
+
+        CloseHandle(state->port);
+    }
+#endif
+
+    job_system_wait(&state->counter);
+    collect_read_jobs(state);
+
+    bool succeeded = true;
+    for (u32 i = 0; i < state->request_count; ++i)
+    {
+        succeeded = succeeded && state->requests[i].succeeded;
+    }
+
+    memory_system_free(state->reads, (state->request_count ? state->request_count : 1) * sizeof(*state->reads), MEMORY_TAG_RESOURCES);
+    memory_system_free(state, sizeof(*state), MEMORY_TAG_RESOURCES);
+    batch->internal = 0;
+    return succeeded;
+}
+
+void complete_request(File_Read_Batch_State* batch, File_Read_Request* request, bool succeeded)
+{
+    request->succeeded = succeeded;
+    request->completed = true;
+    batch->completed_count++;
+}
+
+void submit_read_job(File_Read_Batch_State* batch, u32 request_index)
+{
+    batch->reads[request_index].job_submitted = true;
+    job_system_submit(read_request_job, &batch->reads[request_index], &batch->counter);
+}
+
+void collect_read_jobs(File_Read_Batch_State* batch)
+{
+    for (u32 i = 0; i < batch->request_count; ++i)
+    {
+        Read_State* read = &batch->reads[i];
+        if (read->job_submitted && !read->request->completed && platform_atomic_load_acquire(&read->job_finished))
+        {
+            complete_request(batch, read->request, read->job_succeeded);
+        }
+    }
+}
+
+/**
+ * @brief Blocking read of one request, run on a worker thread. Reads on from whatever an earlier attempt has read.
+ */
+void read_request_job(void* params)
+{
+    Read_State* read_state = params;
+    File_Read_Request* request = read_state->request;
+    f64 start_time = platform_get_absolute_time();
+    bool succeeded = false;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(request->path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, 0);
+    if (file != INVALID_HANDLE_VALUE)
+    {
+        succeeded = true;
+        while (request->bytes_read < request->size)
+        {
+            u64 offset = request->offset + request->bytes_read;
+            u64 remaining = request->size - request->bytes_read;
+            DWORD chunk = remaining > MAX_READ_CHUNK_SIZE ? MAX_READ_CHUNK_SIZE : (DWORD)remaining;
+            OVERLAPPED overlapped = {};
+            overlapped.Offset = (DWORD)offset;
+            overlapped.OffsetHigh = (DWORD)(offset >> 32);
+            DWORD read = 0;
+            if (!ReadFile(file, (u8*)request->buffer + request->bytes_read, chunk, &read, &overlapped) || read == 0)
+            {
+                succeeded = false;
+                break;
+            }
+
+            request->bytes_read += read;
+        }
+
+        CloseHandle(file);
+    }
+#else
+    int fd = open(request->path, O_RDONLY);
+    if (fd >= 0)
+    {
+        succeeded = true;
+        while (request->bytes_read < request->size)
+        {
+            ssize_t read = pread(fd, (u8*)request->buffer + request->bytes_read, request->size - request->bytes_read, request->offset + request->bytes_read);
+            if (read < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (read <= 0)
+            {
+                succeeded = false;
+                break;
+            }
+
+            request->bytes_read += read;
+        }
+
+        close(fd);
+    }
+#endif
+
+    if (!succeeded)
+    {
+        LOG_ERROR("read_request_job: Failed to read %llu bytes at %llu from %s", request->size, request->offset, request->path);
+    }
+
+    // Adds to the time of an overlapped read this job took over from.
+    request->seconds += platform_get_absolute_time() - start_time;
+    read_state->job_succeeded = succeeded;
+    platform_atomic_store_release(&read_state->job_finished, 1);
+}
+
+#if defined(_WIN32)
+void fill_port(File_Read_Batch_State* batch)
+{
+    while (batch->in_flight_count < MAX_OVERLAPPED_READ_COUNT && batch->next_request < batch->request_count)
+    {
+        u32 index = batch->next_request++;
+        Read_State* read = &batch->reads[index];
+        File_Read_Request* request = read->request;
+        if (request->size == 0)
+        {
+            complete_request(batch, request, true);
+            continue;
+        }
+
+        read->start_time = platform_get_absolute_time();
+        read->file = CreateFileA(request->path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, 0);
+        if (read->file == INVALID_HANDLE_VALUE)
+        {
+            read->file = 0;
+            LOG_ERROR("fill_port: Failed to open %s", request->path);
+            complete_request(batch, request, false);
+            continue;
+        }
+
+        // Files the port won't take, or reads it won't start, are read by the job system instead.
+        if (!CreateIoCompletionPort(read->file, batch->port, 0, 0) || !issue_overlapped_read(read))
+        {
+            CloseHandle(read->file);
+            read->file = 0;
+            request->seconds = platform_get_absolute_time() - read->start_time;
+            submit_read_job(batch, index);
+            continue;
+        }
+
+        batch->in_flight_count++;
+    }
+}
+
+bool issue_overlapped_read(Read_State* read)
+{
+    File_Read_Request* request = read->request;
+    u64 offset = request->offset + request->bytes_read;
+    u64 remaining = request->size - request->bytes_read;
+    memory_system_zero(&read->overlapped, sizeof(read->overlapped));
+    read->overlapped.Offset = (DWORD)offset;
+    read->overlapped.OffsetHigh = (DWORD)(offset >> 32);
+    DWORD chunk = remaining > MAX_READ_CHUNK_SIZE ? MAX_READ_CHUNK_SIZE : (DWORD)remaining;
+
+    // A read that completes at once is still reported through the port.
+    return ReadFile(read->file, (u8*)request->buffer + request->bytes_read, chunk, 0, &read->overlapped) || GetLastError() == ERROR_IO_PENDING;
+}
+
+/**
+ * @brief Handles the reads that have completed, waiting up to _timeout_ milliseconds for the first one.
+ * @return false if the port failed; a timeout is not a failure.
+ */
+bool reap_port(File_Read_Batch_State* batch, DWORD timeout)
+{
+    OVERLAPPED_ENTRY entries[16];
+    ULONG entry_count = 0;
+    if (!GetQueuedCompletionStatusEx(batch->port, entries, _countof(entries), &entry_count, timeout, FALSE))
+    {
+        return GetLastError() == WAIT_TIMEOUT;
+    }
+
+    for (ULONG i = 0; i < entry_count; ++i)
+    {
+        Read_State* read = (Read_State*)entries[i].lpOverlapped;
+        File_Read_Request* request = read->request;
+        u32 index = (u32)(request - batch->requests);
+
+        DWORD transferred = 0;
+        bool read_succeeded = GetOverlappedResult(read->file, &read->overlapped, &transferred, FALSE) && transferred > 0;
+        if (read_succeeded)
+        {
+            request->bytes_read += transferred;
+            if (request->bytes_read < request->size)
+            {
+                // Short read, or a request larger than one read. The rest goes out with the same handle.
+                if (issue_overlapped_read(read))
+                {
+                    continue;
+                }
+
+                CloseHandle(read->file);
+                read->file = 0;
+                batch->in_flight_count--;
+                request->seconds = platform_get_absolute_time() - read->start_time;
+                submit_read_job(batch, index);
+                continue;
+            }
+        }
+
+        CloseHandle(read->file);
+        read->file = 0;
+        batch->in_flight_count--;
+        request->seconds = platform_get_absolute_time() - read->start_time;
+
+        bool succeeded = request->bytes_read == request->size;
+        if (!succeeded)
+        {
+            LOG_ERROR("reap_port: Failed to read %llu bytes at %llu from %s", request->size, request->offset, request->path);
+        }
+
+        complete_request(batch, request, succeeded);
+    }
+
+    return true;
+}
+#endif
+
+bool filesystem_mount_directory(char const* path)
+{
+    if (mount_count == MAX_MOUNT_COUNT)
+    {
+        LOG_ERROR("filesystem_mount_directory: Too many mounts. %s was not mounted", path);
+        return false;
+    }
+
+    Mount* mount = &mounts[mount_count++];
+    memory_system_zero(mount, sizeof(*mount));
+    string_copy(mount->path, path);
+    return true;
+}
+
+bool filesystem_mount_pack(char const* path)
+{
+    if (mount_count == MAX_MOUNT_COUNT)
+    {
+        LOG_ERROR("filesystem_mount_pack: Too many mounts. %s was not mounted", path);
+        return false;
+    }
+
+    File_View view;
+    if (!filesystem_map(path, &view))
+    {
+        return false;
+    }
+
+    Pack_Header const* header = view.data;
+    if (view.size < sizeof(*header) || header->magic != PACK_MAGIC || header->version != PACK_VERSION
+        || header->toc_offset + (u64)header->entry_count * sizeof(Pack_Entry) > view.size
+        || header->string_table_offset + header->string_table_size > view.size)
+    {
+        LOG_ERROR("filesystem_mount_pack: %s is not a valid version %u pack", path, PACK_VERSION);
+        filesystem_unmap(&view);
+        return false;
+    }
+
+    Mount* mount = &mounts[mount_count++];
+    memory_system_zero(mount, sizeof(*mount));
+    mount->is_pack = true;
+    string_copy(mount->path, path);
+    mount->view = view;
+    mount->entries = (Pack_Entry const*)((u8 const*)view.data + header->toc_offset);
+    mount->entry_count = header->entry_count;
+    mount->strings = (char const*)view.data + header->string_table_offset;
+
+    LOG_INFO("filesystem_mount_pack: Mounted %s (%u entries)", path, header->entry_count);
+    return true;
+}
+
+void filesystem_unmount_all()
+{
+    for (u32 i = 0; i < mount_count; ++i)
+    {
+        if (mounts[i].is_pack)
+        {
+            // Unmapped directly, since filesystem_unmap skips views that belong to a mounted pack.
+#if defined(_WIN32)
+            UnmapViewOfFile(mounts[i].view.data);
+#else
+            munmap((void*)mounts[i].view.data, mounts[i].view.size);
+#endif
+        }
+    }
+
+    memory_system_zero(mounts, sizeof(mounts));
+    mount_count = 0;
+}
+
+bool filesystem_locate(char const* path, File_Location* location)
+{
+    memory_system_zero(location, sizeof(*location));
+    for (u32 i = mount_count; i-- > 0;)
+    {
+        Mount const* mount = &mounts[i];
+        if (mount->is_pack)
+        {
+            Pack_Entry const* entry = find_pack_entry(mount, path);
+            if (!entry)
+            {
+                continue;
+            }
+
+            if (entry->compression > PACK_COMPRESSION_LZ || entry->offset + entry->stored_size > mount->view.size)
+            {
+                LOG_ERROR("filesystem_locate: Entry %s of %s is corrupt", path, mount->path);
+                continue;
+            }
+
+            location->in_pack = true;
+            location->compression = entry->compression;
+            location->size = entry->size;
+            location->view.data = (u8 const*)mount->view.data + entry->offset;
+            location->view.size = entry->stored_size;
+            return true;
+        }
+
+        string_format(location->disk_path, "%s/%s", mount->path, path);
+        if (filesystem_size_of(location->disk_path, &location->size))
+        {
+            return true;
+        }
+    }
+
+    location->disk_path[0] = 0;
+    return false;
+}
+
+bool filesystem_map_asset(char const* path, File_View* view)
+{
+    File_Location location;
+    if (!filesystem_locate(path, &location))
+    {
+        LOG_ERROR("filesystem_map_asset: %s was not found in any mounted directory or pack", path);
+        view->data = 0;
+        view->size = 0;
+        return false;
+    }
+
+    if (location.in_pack && location.compression == PACK_COMPRESSION_NONE)
+    {
+        *view = location.view;
+        return true;
+    }
+
+    if (location.in_pack)
+    {
+        // Anonymous pages are released by filesystem_unmap exactly like a file mapping.
+        void* data = location.size ? map_anonymous(location.size) : 0;
+        if (location.size && (!data || !compression_lz_decompress(location.view.data, location.view.size, data, location.size)))
+        {
+            LOG_ERROR("filesystem_map_asset: Failed to decompress %s", path);
+            view->data = data;
+            view->size = location.size;
+            filesystem_unmap(view);
+            return false;
+        }
+
+        view->data = data;
+        view->size = location.size;
+        return true;
+    }
+
+    return filesystem_map(location.disk_path, view);
+}
+
+void* map_anonymous(u64 size)
+{
+#if defined(_WIN32)
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, 0);
+    if (!mapping)
+    {
+        return 0;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0);
+    CloseHandle(mapping);
+    return data;
+#else
+    void* data = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return data == MAP_FAILED ? 0 : data;
+#endif
+}
+
+Pack_Entry const* find_pack_entry(Mount const* mount, char const* path)
+{
+    u64 hash = pack_hash_path(path);
+    u32 low = 0;
+    u32 high = mount->entry_count;
+    while (low < high)
+    {
+        u32 middle = low + (high - low) / 2;
+        if (mount->entries[middle].path_hash < hash)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    // The packer rejects colliding hashes, but the stored path still guards against a different path with the same hash.
+    if (low < mount->entry_count && mount->entries[low].path_hash == hash)
+    {
+        char const* stored = mount->strings + mount->entries[low].path_offset;
+        char const* c = path;
+        while (*stored && *c && (*stored == *c || (*stored == '/' && *c == '\\')))
+        {
+            ++stored;
+            ++c;
+        }
+
+        if (*stored == 0 && *c == 0)
+        {
+            return &mount->entries[low];
+        }
+    }
+
+    return 0;
+}
+
+Mount const* find_pack_owning(void const* data)
+{
+    for (u32 i = 0; i < mount_count; ++i)
+    {
+        u8 const* base = mounts[i].view.data;
+        if (mounts[i].is_pack && (u8 const*)data >= base && (u8 const*)data < base + mounts[i].view.size)
+        {
+            return &mounts[i];
+        }
+    }
+
+    return 0;
+}
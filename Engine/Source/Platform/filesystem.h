@@ -19,6 +19,61 @@ typedef enum File_Access_Mode
     FILE_ACCESS_MODE_APPEND_BINARY
 } File_Access_Mode;
 
+/**
+ * @brief Read-only view of a whole file mapped into the address space.
+ * The view is not null-terminated. Text must be consumed with _size_.
+ */
+typedef struct File_View
+{
+    void const* data;
+    u64 size;
+} File_View;
+
+/**
+ * @brief Where an asset lives once resolved through the virtual filesystem.
+ * Either _view_ points at the stored bytes in a mounted pack, or _disk_path_ names a loose file.
+ */
+typedef struct File_Location
+{
+    File_View view;
+    bool in_pack;
+    /** @brief Pack_Compression of the stored bytes. Loose files are never compressed. */
+    u32 compression;
+    /** @brief Size of the asset once decompressed. */
+    u64 size;
+    char disk_path[256];
+} File_Location;
+
+/**
+ * @brief One read of an asynchronous batch. The caller fills in the first four fields and owns _buffer_.
+ */
+typedef struct File_Read_Request
+{
+    char const* path;
+    u64 offset;
+    u64 size;
+    void* buffer;
+
+    /** @brief Set by filesystem_read_batch_poll or filesystem_read_batch_wait once the request has completed. */
+    u64 bytes_read;
+    bool succeeded;
+    bool completed;
+    /** @brief Time taken by the read, from it being started until it finished or, for overlapped reads, was collected. */
+    f64 seconds;
+
+    void* internal;
+} File_Read_Request;
+
+/**
+ * @brief A set of reads in flight. Obtained from filesystem_read_batch_submit and released by filesystem_read_batch_wait.
+ */
+typedef struct File_Read_Batch
+{
+    File_Read_Request* requests;
+    u32 request_count;
+    void* internal;
+} File_Read_Batch;
+
 /**
  * Attempt to open file located at path
  * @param path The path of the file to be opened
@@ -40,7 +95,7 @@ LIB_API void filesystem_close(File_Handle* file);
  * @param file A pointer to a file_handle structure
  * @return File size.
  */
-LIB_API u32 filesystem_size(File_Handle* file);
+LIB_API u64 filesystem_size(File_Handle* file);
 
 /** 
  * Reads all bytes of data into buffer
@@ -49,7 +104,7 @@ LIB_API u32 filesystem_size(File_Handle* file);
  * @param bytes_read A pointer to a number which will be populated with the number of bytes actually read from the file.
  * @return TRUE if successful; otherwise FALSE
  */
-LIB_API bool filesystem_read(File_Handle* file, void* buffer, u32 size);
+LIB_API bool filesystem_read(File_Handle* file, void* buffer, u64 size);
 
 /**
  * Writes provided data to the file
@@ -59,4 +114,109 @@ LIB_API bool filesystem_read(File_Handle* file, void* buffer, u32 size);
  * @param bytes_written A pointer to a number which will be populated with the number of bytes actually written to the file.
  * @return TRUE if successful; otherwise FALSE.
  */
-LIB_API bool filesystem_write(File_Handle* file, u32 size, void const* data);
+LIB_API bool filesystem_write(File_Handle* file, u64 size, void const* data);
+
+/**
+ * @brief Maps the whole file located at path for reading. No data is copied; pages are loaded on first access.
+ * An empty file yields a view with zero data and size.
+ * @param path The path of the file to be mapped
+ * @param view A pointer to a view which is populated on success
+ * @return TRUE if mapped successfully; otherwise FALSE
+ */
+LIB_API bool filesystem_map(char const* path, File_View* view);
+
+/**
+ * @brief Releases a view obtained from filesystem_map or filesystem_map_asset. The view is zeroed.
+ * @param view A pointer to the view to be released
+ */
+LIB_API void filesystem_unmap(File_View* view);
+
+/**
+ * @brief Attempts to read the size of the file located at path without opening it for reading.
+ * @param path The path of the file
+ * @param size A pointer to hold the size in bytes
+ * @return TRUE if successful; otherwise FALSE
+ */
+LIB_API bool filesystem_size_of(char const* path, u64* size);
+
+/**
+ * @brief Reads the size and last modification time of the file located at path without opening it.
+ * @param modified_time A pointer to hold the modification time, in platform-specific units that only compare for equality
+ * @return TRUE if successful; otherwise FALSE
+ */
+LIB_API bool filesystem_stat(char const* path, u64* size, u64* modified_time);
+
+/**
+ * @brief Creates the directory located at path along with any missing parents. Existing directories are fine.
+ * @return TRUE if the directory exists afterwards; otherwise FALSE
+ */
+LIB_API bool filesystem_create_directories(char const* path);
+
+/**
+ * @brief Renames a file, replacing _destination_ if it exists. Readers see either the old or the new file, never a partial one.
+ * @return TRUE if successful; otherwise FALSE
+ */
+LIB_API bool filesystem_replace(char const* source, char const* destination);
+
+/**
+ * @brief Starts reading all _requests_ asynchronously. On Windows the reads are overlapped and complete through an I/O
+ * completion port, with at most 64 files open at once; elsewhere, or for files that can't be read that way, they are
+ * blocking reads on the job system's worker threads. The requests array must stay alive until filesystem_read_batch_wait returns.
+ * @param requests The reads to be made
+ * @param count The number of requests
+ * @param batch A pointer to a batch which tracks the reads
+ * @return TRUE if the batch was started; otherwise FALSE and nothing is in flight.
+ */
+LIB_API bool filesystem_read_batch_submit(File_Read_Request* requests, u32 count, File_Read_Batch* batch);
+
+/**
+ * @brief Collects finished reads without blocking and starts queued ones as others finish. Call from the thread that
+ * submitted the batch: requests are only marked as completed here, so their _completed_ flag may be read without
+ * synchronisation and, once set, the request may be consumed right away.
+ * @param batch A pointer to a submitted batch
+ * @return The number of requests completed so far.
+ */
+LIB_API u32 filesystem_read_batch_poll(File_Read_Batch* batch);
+
+/**
+ * @brief Blocks until every request of the batch has completed and releases the batch.
+ * @param batch A pointer to a submitted batch
+ * @return TRUE if every request succeeded; otherwise FALSE
+ */
+LIB_API bool filesystem_read_batch_wait(File_Read_Batch* batch);
+
+/**
+ * @brief Adds a directory of loose files to the virtual filesystem. Assets are looked up in the most recently mounted source first.
+ * @param path The directory that asset paths are relative to
+ * @return TRUE if mounted; otherwise FALSE
+ */
+LIB_API bool filesystem_mount_directory(char const* path);
+
+/**
+ * @brief Maps a pack archive and adds it to the virtual filesystem. Assets are looked up in the most recently mounted source first.
+ * @param path The path of the pack file
+ * @return TRUE if mounted; otherwise FALSE
+ */
+LIB_API bool filesystem_mount_pack(char const* path);
+
+/**
+ * @brief Unmounts every directory and pack. Views into packs must not be used afterwards.
+ */
+LIB_API void filesystem_unmount_all();
+
+/**
+ * @brief Resolves an asset path (e.g. "shaders/spirv/x.spv") through the mounted sources without reading it.
+ * @param path The asset path, relative to the mounted sources
+ * @param location A pointer to the resolved location
+ * @return TRUE if found; otherwise FALSE
+ */
+LIB_API bool filesystem_locate(char const* path, File_Location* location);
+
+/**
+ * @brief Maps an asset resolved through the virtual filesystem. Uncompressed pack entries are returned in place,
+ * compressed ones are decompressed into fresh pages. Release with filesystem_unmap.
+ * @param path The asset path, relative to the mounted sources
+ * @param view A pointer to a view which is populated on success
+ * @return TRUE if found and mapped; otherwise FALSE
+ */
+LIB_API bool filesystem_map_asset(char const* path, File_View* view);
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * On-disk layout of a pack archive:
+ * [Pack_Header][Pack_Entry x entry_count, sorted by path_hash][path strings][payloads, each PACK_ALIGNMENT-aligned]
+ * All offsets are from the start of the file. Paths are relative to the packed directory and use '/' separators.
+ */
+
+#define PACK_MAGIC 0x4B434150 // "PACK"
+#define PACK_VERSION 1
+#define PACK_ALIGNMENT 4096
+
+typedef enum Pack_Compression
+{
+    PACK_COMPRESSION_NONE,
+    /** @brief One LZ block (see core/compression.h) holding the whole file. */
+    PACK_COMPRESSION_LZ
+} Pack_Compression;
+
+typedef struct Pack_Header
+{
+    u32 magic;
+    u32 version;
+    u32 entry_count;
+    u32 alignment;
+    u64 toc_offset;
+    u64 string_table_offset;
+    u64 string_table_size;
+} Pack_Header;
+
+typedef struct Pack_Entry
+{
+    u64 path_hash;
+    u64 offset;
+    /** @brief Size of the file once decompressed. */
+    u64 size;
+    /** @brief Size of the payload in the archive. Equals size for uncompressed entries. */
+    u64 stored_size;
+    u32 compression;
+    /** @brief Offset of the null-terminated path in the string table. */
+    u32 path_offset;
+} Pack_Entry;
+
+/**
+ * @brief 64-bit FNV-1a hash of a path. Backslashes hash like forward slashes, so paths built on Windows match.
+ */
+static inline u64 pack_hash_path(char const* path)
+{
+    u64 hash = 0xcbf29ce484222325ull;
+    for (char const* c = path; *c; ++c)
+    {
+        char ch = *c == '\\' ? '/' : *c;
+        hash ^= (u8)ch;
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
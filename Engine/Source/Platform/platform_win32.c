@@ -39,6 +39,13 @@ b8 platform_system_startup(u64* memory_size, void* memory, platform_state* plat_
     system_state = memory;
     plat_state->specific = system_state;
     system_state->instance = GetModuleHandleA(0);
+    system_state->wnd = 0;
+
+    if (width == 0 || height == 0) {
+        LOG_INFO("Zero sized window requested. Running headless");
+        setup_clock();
+        return TRUE;
+    }
 
     WNDCLASSEXA wc;
     platform_zero_memory(&wc, sizeof(wc));
@@ -182,6 +189,116 @@ void platformSleep(u64 ms)
     Sleep(ms);
 }
 
+u32 platform_get_processor_count()
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+b8 platform_thread_create(PFN_platform_thread_start start, void* params, platform_thread* thread)
+{
+    DWORD id;
+    thread->internal = CreateThread(0, 0, (LPTHREAD_START_ROUTINE)start, params, 0, &id);
+    if (!thread->internal) {
+        LOG_ERROR("platform_thread_create: Failed to create thread");
+        return FALSE;
+    }
+
+    thread->id = id;
+    return TRUE;
+}
+
+void platform_thread_destroy(platform_thread* thread)
+{
+    if (thread->internal) {
+        WaitForSingleObject(thread->internal, INFINITE);
+        CloseHandle(thread->internal);
+        thread->internal = 0;
+        thread->id = 0;
+    }
+}
+
+u64 platform_get_current_thread_id()
+{
+    return GetCurrentThreadId();
+}
+
+b8 platform_mutex_create(platform_mutex* mutex)
+{
+    CRITICAL_SECTION* section = platform_allocate(sizeof(*section), FALSE);
+    InitializeCriticalSection(section);
+    mutex->internal = section;
+    return TRUE;
+}
+
+void platform_mutex_destroy(platform_mutex* mutex)
+{
+    if (mutex->internal) {
+        DeleteCriticalSection(mutex->internal);
+        platform_free(mutex->internal, FALSE);
+        mutex->internal = 0;
+    }
+}
+
+b8 platform_mutex_lock(platform_mutex* mutex)
+{
+    EnterCriticalSection(mutex->internal);
+    return TRUE;
+}
+
+b8 platform_mutex_unlock(platform_mutex* mutex)
+{
+    LeaveCriticalSection(mutex->internal);
+    return TRUE;
+}
+
+b8 platform_semaphore_create(u32 initial_count, platform_semaphore* semaphore)
+{
+    semaphore->internal = CreateSemaphoreA(0, initial_count, 0x7fffffff, 0);
+    if (!semaphore->internal) {
+        LOG_ERROR("platform_semaphore_create: Failed to create semaphore");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+void platform_semaphore_destroy(platform_semaphore* semaphore)
+{
+    if (semaphore->internal) {
+        CloseHandle(semaphore->internal);
+        semaphore->internal = 0;
+    }
+}
+
+b8 platform_semaphore_signal(platform_semaphore* semaphore)
+{
+    return ReleaseSemaphore(semaphore->internal, 1, 0) != 0;
+}
+
+b8 platform_semaphore_wait(platform_semaphore* semaphore)
+{
+    return WaitForSingleObject(semaphore->internal, INFINITE) == WAIT_OBJECT_0;
+}
+
+i64 platform_atomic_add(i64 volatile* value, i64 addend)
+{
+    return InterlockedAdd64(value, addend);
+}
+
+void platform_atomic_store_release(i32 volatile* value, i32 new_value)
+{
+    // Interlocked operations are full barriers, which is stronger than release.
+    InterlockedExchange((LONG volatile*)value, new_value);
+}
+
+i32 platform_atomic_load_acquire(i32 volatile* value)
+{
+    // Interlocked operations are full barriers, which is stronger than acquire.
+    return InterlockedCompareExchange((LONG volatile*)value, 0, 0);
+}
+
 b8 create_vulkan_surface(vulkan_context* context)
 {
     VkWin32SurfaceCreateInfoKHR createInfo = {};
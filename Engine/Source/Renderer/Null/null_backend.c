@@ -0,0 +1,437 @@
+#include "null_backend.h"
+
+#include "containers/dynamic_array.h"
+#include "core/logger.h"
+#include "resources/block_compression.h"
+#include "systems/memory_system.h"
+#include "systems/texture_system.h"
+
+/**
+ * @brief Internal data for a geometry "uploaded" to the null backend.
+ */
+typedef struct Null_Geometry_Data
+{
+    u32 id;
+    u32 generation;
+    u32 vertex_count;
+    u32 vertex_size_in_bytes;
+    u32 index_count;
+    u32 index_size_in_bytes;
+} Null_Geometry_Data;
+
+typedef struct Null_Backend_State
+{
+    Null_Backend_Stats stats;
+
+    bool recording;
+    Dynamic_Array* commands;
+
+    bool in_frame;
+    u8 current_renderpass;
+
+    u32 framebuffer_width;
+    u32 framebuffer_height;
+
+    // Staging memory, so that uploads cost the CPU what they cost with the vulkan backend.
+    u8* staging_memory;
+    Staging_Ring staging_ring;
+
+    bool material_slots_used[NULL_MAX_MATERIAL_COUNT];
+    Null_Geometry_Data geometries[NULL_MAX_GEOMETRY_COUNT];
+} Null_Backend_State;
+
+static Null_Backend_State state;
+
+static void record(Null_Command_Type type, u32 id, u32 count, u64 size);
+
+b8 null_backend_startup(renderer_backend* backend, char const* app_name)
+{
+    memory_system_zero(&state, sizeof(state));
+    state.commands = DYNAMIC_ARRAY_CREATE(Null_Command);
+    state.staging_memory = memory_system_allocate(NULL_STAGING_RING_SIZE, MEMORY_TAG_RENDERER);
+    staging_ring_create(NULL_STAGING_RING_SIZE, 16, &state.staging_ring);
+
+    for (u32 i = 0; i < NULL_MAX_GEOMETRY_COUNT; ++i)
+    {
+        state.geometries[i].id = INVALID_ID;
+        state.geometries[i].generation = INVALID_ID;
+    }
+
+    LOG_INFO("Null renderer initialized ('%s'). Nothing will be presented", app_name ? app_name : "");
+    return TRUE;
+}
+
+void null_backend_shutdown(renderer_backend* backend)
+{
+    if (state.stats.live_texture_count || state.stats.live_material_count || state.stats.live_geometry_count)
+    {
+        LOG_WARNING("null_backend_shutdown: Leaked objects: textures %u, materials %u, geometries %u",
+            state.stats.live_texture_count, state.stats.live_material_count, state.stats.live_geometry_count);
+    }
+
+    if (state.commands)
+    {
+        dynamic_array_destroy(state.commands);
+        state.commands = 0;
+    }
+
+    if (state.staging_memory)
+    {
+        memory_system_free(state.staging_memory, NULL_STAGING_RING_SIZE, MEMORY_TAG_RENDERER);
+        state.staging_memory = 0;
+    }
+}
+
+b8 null_backend_begin_frame(renderer_backend* backend, f64 delta_time)
+{
+    if (state.in_frame)
+    {
+        LOG_ERROR("null_backend_begin_frame: Frame already begun");
+        return FALSE;
+    }
+
+    state.in_frame = true;
+    record(NULL_COMMAND_TYPE_BEGIN_FRAME, 0, 0, 0);
+    return TRUE;
+}
+
+void null_backend_update_global_state(mat4 view, mat4 proj, vec3 view_pos, vec4 ambient_color, i32 mode)
+{
+    record(NULL_COMMAND_TYPE_UPDATE_GLOBAL_STATE, 0, 0, 2 * sizeof(mat4));
+}
+
+void null_backend_update_global_ui_state(mat4 projection, mat4 view, i32 mode)
+{
+    record(NULL_COMMAND_TYPE_UPDATE_GLOBAL_UI_STATE, 0, 0, 2 * sizeof(mat4));
+}
+
+b8 null_backend_end_frame(renderer_backend* backend, f64 delta_time)
+{
+    if (!state.in_frame)
+    {
+        LOG_ERROR("null_backend_end_frame: Frame has not begun");
+        return FALSE;
+    }
+
+    record(NULL_COMMAND_TYPE_END_FRAME, 0, 0, 0);
+    state.in_frame = false;
+    state.stats.frame_count++;
+    return TRUE;
+}
+
+void null_backend_on_resize(renderer_backend* backend, i16 width, i16 height)
+{
+    state.framebuffer_width = width;
+    state.framebuffer_height = height;
+    record(NULL_COMMAND_TYPE_RESIZE, 0, 0, 0);
+}
+
+void null_backend_draw_geometry(geometry_render_data render_data)
+{
+    if (!render_data.geometry || render_data.geometry->internal_id == INVALID_ID)
+    {
+        return;
+    }
+
+    // Textures count as drawn, as they do when the Vulkan backend applies the material, so the texture budget sees the
+    // same use either way.
+    if (render_data.geometry->material)
+    {
+        texture_system_mark_used(render_data.geometry->material->diffuse_map.texture);
+    }
+
+    Null_Geometry_Data* data = &state.geometries[render_data.geometry->internal_id];
+    if (data->index_count > 0)
+    {
+        state.stats.drawn_index_count += data->index_count;
+        record(NULL_COMMAND_TYPE_DRAW_GEOMETRY, data->id, data->index_count, 0);
+    }
+    else
+    {
+        state.stats.drawn_vertex_count += data->vertex_count;
+        record(NULL_COMMAND_TYPE_DRAW_GEOMETRY, data->id, data->vertex_count, 0);
+    }
+}
+
+void null_backend_create_texture(u8 const* pixels, Texture* texture)
+{
+    u64 size = block_compression_chain_size(texture->format, texture->width, texture->height, texture->mip_count);
+    Staging_Region region;
+    if (pixels && null_backend_staging_acquire(size, &region))
+    {
+        memory_system_copy(region.memory, pixels, size);
+        null_backend_create_texture_from_staging(&region, texture);
+        return;
+    }
+
+    // Nothing is allocated, so internal only marks the texture as created by this backend.
+    texture->internal = &state;
+    texture->generation++;
+
+    state.stats.texture_bytes += size;
+    state.stats.live_texture_count++;
+    record(NULL_COMMAND_TYPE_CREATE_TEXTURE, texture->id, 1, size);
+}
+
+b8 null_backend_staging_acquire(u64 size, Staging_Region* region)
+{
+    // Nothing reads staging memory after an upload, so every release is retired at once.
+    return staging_ring_allocate(&state.staging_ring, size, state.staging_memory, region);
+}
+
+void null_backend_staging_cancel(Staging_Region* region)
+{
+    if (staging_ring_release(&state.staging_ring, region) != INVALID_ID)
+    {
+        staging_ring_retire_oldest(&state.staging_ring);
+    }
+}
+
+void null_backend_create_texture_from_staging(Staging_Region* region, Texture* texture)
+{
+    null_backend_staging_cancel(region);
+
+    u64 size = block_compression_chain_size(texture->format, texture->width, texture->height, texture->mip_count);
+    texture->internal = &state;
+    texture->generation++;
+
+    state.stats.texture_bytes += size;
+    state.stats.live_texture_count++;
+    record(NULL_COMMAND_TYPE_CREATE_TEXTURE, texture->id, 1, size);
+}
+
+b8 null_backend_supports_texture_format(Texture_Format format)
+{
+    // Nothing is sampled, so every format is accepted and textures keep the size they would have on a GPU.
+    return TRUE;
+}
+
+void null_backend_destroy_texture(Texture* texture)
+{
+    // Mirrors the vulkan backend, which is also called for never-created textures.
+    if (texture->internal == &state)
+    {
+        state.stats.live_texture_count--;
+    }
+
+    record(NULL_COMMAND_TYPE_DESTROY_TEXTURE, texture->id, 0, 0);
+    memory_system_zero(texture, sizeof(*texture));
+}
+
+void null_backend_update_texture(Texture* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels)
+{
+    u64 size = 0;
+    for (u32 i = 0; i < region_count; ++i)
+    {
+        size += block_compression_level_size(texture->format, regions[i].width, regions[i].height);
+    }
+
+    // The regions are packed into staging memory, as the vulkan backend packs them.
+    Staging_Region region;
+    if (null_backend_staging_acquire(size, &region))
+    {
+        Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+        block_compression_layout(texture->format, texture->width, texture->height, 0, mips);
+        u8* destination = region.memory;
+        for (u32 i = 0; i < region_count; ++i)
+        {
+            Texture_Region const* r = &regions[i];
+            destination += block_compression_copy_region(texture->format, pixels + mips[r->level].offset, mips[r->level].width, r->x, r->y, r->width, r->height, destination);
+        }
+        null_backend_staging_cancel(&region);
+    }
+
+    record(NULL_COMMAND_TYPE_UPDATE_TEXTURE, texture->id, region_count, size);
+}
+
+void null_backend_set_texture_base_level(Texture* texture, u32 base_level)
+{
+    texture->generation++;
+}
+
+b8 null_backend_create_material(Material* material)
+{
+    if (!material)
+    {
+        LOG_ERROR("null_backend_create_material: Called with nullptr. Creation failed");
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < NULL_MAX_MATERIAL_COUNT; ++i)
+    {
+        if (!state.material_slots_used[i])
+        {
+            state.material_slots_used[i] = true;
+            material->backend_id = i;
+            state.stats.live_material_count++;
+            record(NULL_COMMAND_TYPE_CREATE_MATERIAL, i, 0, 0);
+            return TRUE;
+        }
+    }
+
+    LOG_ERROR("null_backend_create_material: Failed to find a free material slot");
+    return FALSE;
+}
+
+void null_backend_destroy_material(Material* material)
+{
+    if (!material || material->backend_id == INVALID_ID || material->backend_id >= NULL_MAX_MATERIAL_COUNT)
+    {
+        LOG_WARNING("null_backend_destroy_material: Invalid material. Nothing was done");
+        return;
+    }
+
+    state.material_slots_used[material->backend_id] = false;
+    state.stats.live_material_count--;
+    record(NULL_COMMAND_TYPE_DESTROY_MATERIAL, material->backend_id, 0, 0);
+    material->backend_id = INVALID_ID;
+}
+
+b8 null_backend_create_geometry(Geometry* geometry, u32 vertex_size_in_bytes, u32 vertex_count, void const* vertices, u32 index_size_in_bytes, u32 index_count, u32 const* indices)
+{
+    if (vertex_count == 0 || !vertices)
+    {
+        LOG_ERROR("null_backend_create_geometry: Requires vertex data, and none was supplied. vertex_count=%d, vertices=%p", vertex_count, vertices);
+        return FALSE;
+    }
+
+    Null_Geometry_Data* data = 0;
+    if (geometry->internal_id != INVALID_ID)
+    {
+        data = &state.geometries[geometry->internal_id];
+    }
+    else
+    {
+        for (u32 i = 0; i < NULL_MAX_GEOMETRY_COUNT; ++i)
+        {
+            if (state.geometries[i].id == INVALID_ID)
+            {
+                geometry->internal_id = i;
+                data = &state.geometries[i];
+                data->id = i;
+                state.stats.live_geometry_count++;
+                break;
+            }
+        }
+    }
+
+    if (!data)
+    {
+        LOG_ERROR("null_backend_create_geometry: Failed to find a free index for a new geometry upload");
+        return FALSE;
+    }
+
+    data->vertex_count = vertex_count;
+    data->vertex_size_in_bytes = vertex_size_in_bytes;
+    data->index_count = indices ? index_count : 0;
+    data->index_size_in_bytes = indices ? index_size_in_bytes : 0;
+    data->generation = data->generation == INVALID_ID ? 0 : data->generation + 1;
+
+    u64 vertex_bytes = (u64)vertex_count * vertex_size_in_bytes;
+    u64 index_bytes = (u64)data->index_count * data->index_size_in_bytes;
+    state.stats.vertex_bytes += vertex_bytes;
+    state.stats.index_bytes += index_bytes;
+    record(NULL_COMMAND_TYPE_CREATE_GEOMETRY, data->id, vertex_count, vertex_bytes + index_bytes);
+    return TRUE;
+}
+
+void null_backend_destroy_geometry(Geometry* geometry)
+{
+    if (!geometry || geometry->internal_id == INVALID_ID)
+    {
+        LOG_WARNING("null_backend_destroy_geometry: Trying to destroy invalid geometry");
+        return;
+    }
+
+    Null_Geometry_Data* data = &state.geometries[geometry->internal_id];
+    record(NULL_COMMAND_TYPE_DESTROY_GEOMETRY, data->id, 0, 0);
+    memory_system_zero(data, sizeof(*data));
+    data->id = INVALID_ID;
+    data->generation = INVALID_ID;
+    state.stats.live_geometry_count--;
+}
+
+b8 null_backend_begin_renderpass(renderer_backend* backend, u8 renderpass_id)
+{
+    if (renderpass_id != BUILTIN_RENDERPASS_WORLD && renderpass_id != BUILTIN_RENDERPASS_UI)
+    {
+        LOG_ERROR("null_backend_begin_renderpass: Unrecognized renderpass id: %#02x", renderpass_id);
+        return FALSE;
+    }
+
+    state.current_renderpass = renderpass_id;
+    record(NULL_COMMAND_TYPE_BEGIN_RENDERPASS, renderpass_id, 0, 0);
+    return TRUE;
+}
+
+b8 null_backend_end_renderpass(renderer_backend* backend, u8 renderpass_id)
+{
+    if (renderpass_id != state.current_renderpass)
+    {
+        LOG_ERROR("null_backend_end_renderpass: Renderpass %#02x is not active", renderpass_id);
+        return FALSE;
+    }
+
+    state.current_renderpass = 0;
+    record(NULL_COMMAND_TYPE_END_RENDERPASS, renderpass_id, 0, 0);
+    return TRUE;
+}
+
+void null_backend_get_stats(Null_Backend_Stats* stats)
+{
+    memory_system_copy(stats, &state.stats, sizeof(*stats));
+}
+
+void null_backend_reset_stats()
+{
+    u32 live_texture_count = state.stats.live_texture_count;
+    u32 live_material_count = state.stats.live_material_count;
+    u32 live_geometry_count = state.stats.live_geometry_count;
+
+    memory_system_zero(&state.stats, sizeof(state.stats));
+    state.stats.live_texture_count = live_texture_count;
+    state.stats.live_material_count = live_material_count;
+    state.stats.live_geometry_count = live_geometry_count;
+}
+
+void null_backend_set_recording(bool enabled)
+{
+    state.recording = enabled;
+}
+
+Null_Command const* null_backend_get_commands(u32* count)
+{
+    if (!state.commands || state.commands->size == 0)
+    {
+        *count = 0;
+        return 0;
+    }
+
+    *count = state.commands->size;
+    return state.commands->data;
+}
+
+void null_backend_clear_commands()
+{
+    if (state.commands)
+    {
+        state.commands->size = 0;
+    }
+}
+
+void record(Null_Command_Type type, u32 id, u32 count, u64 size)
+{
+    state.stats.call_counts[type]++;
+    if (!state.recording || !state.commands)
+    {
+        return;
+    }
+
+    Null_Command command;
+    command.type = type;
+    command.frame = state.stats.frame_count;
+    command.id = id;
+    command.count = count;
+    command.size = size;
+    dynamic_array_push_back(state.commands, &command);
+}
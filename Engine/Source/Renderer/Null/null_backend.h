@@ -0,0 +1,122 @@
+#pragma once
+
+#include "renderer/renderer_backend.h"
+#include "third_party/cglm/cglm.h"
+
+#define NULL_MAX_MATERIAL_COUNT 2048
+#define NULL_MAX_GEOMETRY_COUNT 4096
+#define NULL_STAGING_RING_SIZE MEBIBYTES(32)
+
+/**
+ * @brief Kinds of calls made into the null backend. Also used as the command stream opcode.
+ */
+typedef enum Null_Command_Type
+{
+    NULL_COMMAND_TYPE_BEGIN_FRAME,
+    NULL_COMMAND_TYPE_END_FRAME,
+    NULL_COMMAND_TYPE_RESIZE,
+    NULL_COMMAND_TYPE_UPDATE_GLOBAL_STATE,
+    NULL_COMMAND_TYPE_UPDATE_GLOBAL_UI_STATE,
+    NULL_COMMAND_TYPE_DRAW_GEOMETRY,
+    NULL_COMMAND_TYPE_CREATE_TEXTURE,
+    NULL_COMMAND_TYPE_DESTROY_TEXTURE,
+    NULL_COMMAND_TYPE_UPDATE_TEXTURE,
+    NULL_COMMAND_TYPE_BEGIN_RENDERPASS,
+    NULL_COMMAND_TYPE_END_RENDERPASS,
+    NULL_COMMAND_TYPE_CREATE_MATERIAL,
+    NULL_COMMAND_TYPE_DESTROY_MATERIAL,
+    NULL_COMMAND_TYPE_CREATE_GEOMETRY,
+    NULL_COMMAND_TYPE_DESTROY_GEOMETRY,
+    NULL_COMMAND_TYPE_ENUM_COUNT
+} Null_Command_Type;
+
+/**
+ * @brief A single recorded backend call.
+ * The meaning of _id_ depends on the command: texture id, material backend id, geometry internal id or renderpass id.
+ */
+typedef struct Null_Command
+{
+    Null_Command_Type type;
+    u64 frame;
+    u32 id;
+    u32 count;
+    u64 size;
+} Null_Command;
+
+/**
+ * @brief Counters collected by the null backend.
+ */
+typedef struct Null_Backend_Stats
+{
+    u64 frame_count;
+    u64 call_counts[NULL_COMMAND_TYPE_ENUM_COUNT];
+
+    u64 texture_bytes;
+    u64 vertex_bytes;
+    u64 index_bytes;
+
+    u64 drawn_vertex_count;
+    u64 drawn_index_count;
+
+    u32 live_texture_count;
+    u32 live_material_count;
+    u32 live_geometry_count;
+} Null_Backend_Stats;
+
+b8 null_backend_startup(renderer_backend* backend, char const* app_name);
+void null_backend_shutdown(renderer_backend* backend);
+
+b8 null_backend_begin_frame(renderer_backend* backend, f64 delta_time);
+void null_backend_update_global_state(mat4 view, mat4 proj, vec3 view_pos, vec4 ambient_color, i32 mode);
+void null_backend_update_global_ui_state(mat4 projection, mat4 view, i32 mode);
+b8 null_backend_end_frame(renderer_backend* backend, f64 delta_time);
+
+void null_backend_on_resize(renderer_backend* backend, i16 width, i16 height);
+
+void null_backend_draw_geometry(geometry_render_data render_data);
+
+void null_backend_create_texture(u8 const* pixels, Texture* texture);
+void null_backend_destroy_texture(Texture* texture);
+void null_backend_update_texture(Texture* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels);
+void null_backend_set_texture_base_level(Texture* texture, u32 base_level);
+
+b8 null_backend_staging_acquire(u64 size, Staging_Region* region);
+void null_backend_staging_cancel(Staging_Region* region);
+void null_backend_create_texture_from_staging(Staging_Region* region, Texture* texture);
+b8 null_backend_supports_texture_format(Texture_Format format);
+
+b8 null_backend_create_material(Material* material);
+void null_backend_destroy_material(Material* material);
+
+b8 null_backend_create_geometry(Geometry* geometry, u32 vertex_size_in_bytes, u32 vertex_count, void const* vertices, u32 index_size_in_bytes, u32 index_count, u32 const* indices);
+void null_backend_destroy_geometry(Geometry* geometry);
+
+b8 null_backend_begin_renderpass(renderer_backend* backend, u8 renderpass_id);
+b8 null_backend_end_renderpass(renderer_backend* backend, u8 renderpass_id);
+
+/**
+ * @brief Copies the current counters into _stats_.
+ */
+LIB_API void null_backend_get_stats(Null_Backend_Stats* stats);
+
+/**
+ * @brief Resets call and byte counters. Live object counts are kept.
+ */
+LIB_API void null_backend_reset_stats();
+
+/**
+ * @brief Enables or disables recording of the command stream. Recording is off by default.
+ */
+LIB_API void null_backend_set_recording(bool enabled);
+
+/**
+ * @brief Obtains the recorded command stream.
+ * @param count A pointer to hold the number of recorded commands.
+ * @return A pointer to the first command, or 0 if nothing has been recorded.
+ */
+LIB_API Null_Command const* null_backend_get_commands(u32* count);
+
+/**
+ * @brief Discards all recorded commands.
+ */
+LIB_API void null_backend_clear_commands();
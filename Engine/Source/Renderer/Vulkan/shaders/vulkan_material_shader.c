@@ -343,6 +343,8 @@ void vulkan_material_shader_apply_material(vulkan_context* context, vulkan_mater
             u32* descriptor_generation = &object_state->descriptor_states[descriptor_set_count].generations[current_image];
             u32* descriptor_id = &object_state->descriptor_states[descriptor_set_count].ids[current_image];
 
+            // Stamped even while it isn't loaded, which has it loaded again if it was evicted.
+            texture_system_mark_used(texture);
             if (texture->generation == INVALID_ID)
             {
                 texture = texture_system_get_default_texture();
@@ -10,6 +10,8 @@
 
 #include "systems/texture_system.h"
 
+#include <stddef.h>
+
 #define BUILTIN_SHADER_NAME_UI "Builtin.UIShader"
 
 b8 vulkan_ui_shader_create(vulkan_context* context, vulkan_ui_shader* out_shader) {
@@ -51,10 +53,9 @@ b8 vulkan_ui_shader_create(vulkan_context* context, vulkan_ui_shader* out_shader
     // Sampler uses.
     out_shader->sampler_uses[0] = TEXTURE_USE_MAP_DIFFUSE;
 
-    // Local/Object Descriptors
+    // Local/Object Descriptors. The diffuse colour and uv rect are push constants, so only the texture is left.
     VkDescriptorType descriptor_types[VULKAN_UI_SHADER_DESCRIPTOR_COUNT] = {
-        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,          // Binding 0 - uniform buffer
-        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // Binding 1 - Diffuse sampler layout.
+        VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,  // Binding 0 - Diffuse sampler layout.
     };
     VkDescriptorSetLayoutBinding bindings[VULKAN_UI_SHADER_DESCRIPTOR_COUNT];
     memory_zero(&bindings, sizeof(VkDescriptorSetLayoutBinding) * VULKAN_UI_SHADER_DESCRIPTOR_COUNT);
@@ -70,17 +71,13 @@ b8 vulkan_ui_shader_create(vulkan_context* context, vulkan_ui_shader* out_shader
     layout_info.pBindings = bindings;
     VULKAN_CHECK_RESULT(vkCreateDescriptorSetLayout(context->device.handle, &layout_info, 0, &out_shader->object_descriptor_set_layout));
 
-    // Local/Object descriptor pool: Used for object-specific items like diffuse colour
-    VkDescriptorPoolSize object_pool_sizes[2];
-    // The first section will be used for uniform buffers
-    object_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    object_pool_sizes[0].descriptorCount = VULKAN_MAX_UI_COUNT;
-    // The second section will be used for image samplers.
-    object_pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    object_pool_sizes[1].descriptorCount = VULKAN_UI_SHADER_SAMPLER_COUNT * VULKAN_MAX_UI_COUNT;
+    // Local/Object descriptor pool: Used for object-specific items like the diffuse map
+    VkDescriptorPoolSize object_pool_sizes[1];
+    object_pool_sizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    object_pool_sizes[0].descriptorCount = VULKAN_UI_SHADER_SAMPLER_COUNT * VULKAN_MAX_UI_COUNT;
 
     VkDescriptorPoolCreateInfo object_pool_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-    object_pool_info.poolSizeCount = 2;
+    object_pool_info.poolSizeCount = 1;
     object_pool_info.pPoolSizes = object_pool_sizes;
     object_pool_info.maxSets = VULKAN_MAX_UI_COUNT;
     object_pool_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
@@ -180,17 +177,8 @@ b8 vulkan_ui_shader_create(vulkan_context* context, vulkan_ui_shader* out_shader
     alloc_info.pSetLayouts = global_layouts;
     VULKAN_CHECK_RESULT(vkAllocateDescriptorSets(context->device.handle, &alloc_info, out_shader->global_descriptor_sets));
 
-    // Create the object uniform buffer.
-    if (!vulkan_buffer_create(
-            context,
-            sizeof(vulkan_ui_shader_instance_ubo) * VULKAN_MAX_UI_COUNT,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-            TRUE,
-            &out_shader->object_uniform_buffer)) {
-        LOG_ERROR("UI instance buffer creation failed for shader.");
-        return FALSE;
-    }
+    out_shader->bound_texture = 0;
+    out_shader->bound_texture_generation = INVALID_ID;
 
     return TRUE;
 }
@@ -203,7 +191,6 @@ void vulkan_ui_shader_destroy(vulkan_context* context, struct vulkan_ui_shader*
 
     // Destroy uniform buffers.
     vulkan_buffer_destroy(context, &shader->global_uniform_buffer);
-    vulkan_buffer_destroy(context, &shader->object_uniform_buffer);
 
     // Destroy pipeline.
     vulkan_pipeline_destroy(context, &shader->pipeline);
@@ -224,6 +211,10 @@ void vulkan_ui_shader_destroy(vulkan_context* context, struct vulkan_ui_shader*
 void vulkan_ui_shader_use(vulkan_context* context, struct vulkan_ui_shader* shader) {
     u32 current_image = context->current_image;
     vulkan_pipeline_bind(&context->command_buffers.data[current_image], VK_PIPELINE_BIND_POINT_GRAPHICS, &shader->pipeline);
+
+    // Nothing is bound for the draws that follow yet.
+    shader->bound_texture = 0;
+    shader->bound_texture_generation = INVALID_ID;
 }
 
 void vulkan_ui_shader_update_global_state(vulkan_context* context, struct vulkan_ui_shader* shader, f32 delta_time) {
@@ -263,7 +254,7 @@ void vulkan_ui_shader_set_model(vulkan_context* context, struct vulkan_ui_shader
         u32 current_image = context->current_image;
         VkCommandBuffer command_buffer = context->command_buffers.data[current_image].handle;
 
-        vkCmdPushConstants(command_buffer, shader->pipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(mat4), &model);
+        vkCmdPushConstants(command_buffer, shader->pipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, offsetof(vulkan_ui_shader_push_constants, model), sizeof(mat4), &model);
     }
 }
 
@@ -272,110 +263,77 @@ void vulkan_ui_shader_apply_material(vulkan_context* context, struct vulkan_ui_s
         u32 current_image = context->current_image;
         VkCommandBuffer command_buffer = context->command_buffers.data[current_image].handle;
 
+        // Push the diffuse colour and the part of the diffuse map to draw.
+        vulkan_ui_shader_push_constants push_constants;
+        glm_vec4_copy(material->diffuse_color, push_constants.diffuse_color);
+        glm_vec4_copy(material->diffuse_map.uv_rect, push_constants.uv_rect);
+        u32 push_offset = offsetof(vulkan_ui_shader_push_constants, diffuse_color);
+        vkCmdPushConstants(command_buffer, shader->pipeline.layout, VK_SHADER_STAGE_VERTEX_BIT, push_offset, sizeof(push_constants) - push_offset, &push_constants.diffuse_color);
+
+        // Samplers.
+        Texture* t = 0;
+        switch (shader->sampler_uses[0]) {
+            case TEXTURE_USE_MAP_DIFFUSE:
+                t = material->diffuse_map.texture;
+                break;
+            default:
+                LOG_FATAL("Unable to bind sampler to unknown use.");
+                return;
+        }
+
+        // If the texture hasn't been loaded yet, or was evicted, use the default.
+        texture_system_mark_used(t);
+        b8 use_default = !t || t->generation == INVALID_ID;
+        if (use_default) {
+            t = texture_system_get_default_texture();
+        }
+
+        // The texture is already bound if the previous material drew from it, e.g. from the same atlas.
+        if (t == shader->bound_texture && t->generation == shader->bound_texture_generation) {
+            return;
+        }
+
         // Obtain material data.
         vulkan_ui_shader_instance_state* object_state = &shader->instance_states[material->backend_id];
         VkDescriptorSet object_descriptor_set = object_state->descriptor_sets[current_image];
-
-        // TODO: if needs update
-        VkWriteDescriptorSet descriptor_writes[VULKAN_UI_SHADER_DESCRIPTOR_COUNT];
-        memory_zero(descriptor_writes, sizeof(VkWriteDescriptorSet) * VULKAN_UI_SHADER_DESCRIPTOR_COUNT);
-        u32 descriptor_count = 0;
         u32 descriptor_index = 0;
+        u32* descriptor_generation = &object_state->descriptor_states[descriptor_index].generations[current_image];
+        u32* descriptor_id = &object_state->descriptor_states[descriptor_index].ids[current_image];
 
-        // Descriptor 0 - Uniform buffer
-        u32 range = sizeof(vulkan_ui_shader_instance_ubo);
-        u64 offset = sizeof(vulkan_ui_shader_instance_ubo) * material->backend_id;  // also the index into the array.
-        vulkan_ui_shader_instance_ubo instance_ubo;
-
-        // Get diffuse colour from a material.
-        glm_vec4_copy(material->diffuse_color, instance_ubo.diffuse_color);
+        // Reset the descriptor generation if using the default texture.
+        if (use_default) {
+            *descriptor_generation = INVALID_ID;
+        }
 
-        // Load the data into the buffer.
-        vulkan_buffer_upload_to_host_visible_memory(context, &shader->object_uniform_buffer, offset, range, 0, &instance_ubo);
+        // Check if the descriptor needs updating first.
+        if (*descriptor_id != t->id || *descriptor_generation != t->generation || *descriptor_generation == INVALID_ID) {
+            vulkan_texture_resource* internal_data = (vulkan_texture_resource*)t->internal;
 
-        // Only do this if the descriptor has not yet been updated.
-        u32* global_ubo_generation = &object_state->descriptor_states[descriptor_index].generations[current_image];
-        if (*global_ubo_generation == INVALID_ID || *global_ubo_generation != material->generation) {
-            VkDescriptorBufferInfo buffer_info;
-            buffer_info.buffer = shader->object_uniform_buffer.handle;
-            buffer_info.offset = offset;
-            buffer_info.range = range;
+            // Assign view and sampler.
+            VkDescriptorImageInfo image_info;
+            image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            image_info.imageView = internal_data->image.view;
+            image_info.sampler = internal_data->sampler;
 
             VkWriteDescriptorSet descriptor = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
             descriptor.dstSet = object_descriptor_set;
             descriptor.dstBinding = descriptor_index;
-            descriptor.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            descriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
             descriptor.descriptorCount = 1;
-            descriptor.pBufferInfo = &buffer_info;
-
-            descriptor_writes[descriptor_count] = descriptor;
-            descriptor_count++;
-
-            // Update the frame generation. In this case it is only needed once since this is a buffer.
-            *global_ubo_generation = material->generation;
-        }
-        descriptor_index++;
-
-        // Samplers.
-        const u32 sampler_count = 1;
-        VkDescriptorImageInfo image_infos[1];
-        for (u32 sampler_index = 0; sampler_index < sampler_count; ++sampler_index) {
-            Texture_Use use = shader->sampler_uses[sampler_index];
-            Texture* t = 0;
-            switch (use) {
-                case TEXTURE_USE_MAP_DIFFUSE:
-                    t = material->diffuse_map.texture;
-                    break;
-                default:
-                    LOG_FATAL("Unable to bind sampler to unknown use.");
-                    return;
-            }
-
-            u32* descriptor_generation = &object_state->descriptor_states[descriptor_index].generations[current_image];
-            u32* descriptor_id = &object_state->descriptor_states[descriptor_index].ids[current_image];
-
-            // If the texture hasn't been loaded yet, use the default.
-            if (!t || t->generation == INVALID_ID) {
-                t = texture_system_get_default_texture();
+            descriptor.pImageInfo = &image_info;
+            vkUpdateDescriptorSets(context->device.handle, 1, &descriptor, 0, 0);
 
-                // Reset the descriptor generation if using the default texture.
-                *descriptor_generation = INVALID_ID;
+            // Sync frame generation if not using a default texture.
+            if (!use_default) {
+                *descriptor_generation = t->generation;
+                *descriptor_id = t->id;
             }
-
-            // Check if the descriptor needs updating first.
-            if (t && (*descriptor_id != t->id || *descriptor_generation != t->generation || *descriptor_generation == INVALID_ID)) {
-                vulkan_texture_resource* internal_data = (vulkan_texture_resource*)t->internal;
-
-                // Assign view and sampler.
-                image_infos[sampler_index].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                image_infos[sampler_index].imageView = internal_data->image.view;
-                image_infos[sampler_index].sampler = internal_data->sampler;
-
-                VkWriteDescriptorSet descriptor = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-                descriptor.dstSet = object_descriptor_set;
-                descriptor.dstBinding = descriptor_index;
-                descriptor.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                descriptor.descriptorCount = 1;
-                descriptor.pImageInfo = &image_infos[sampler_index];
-
-                descriptor_writes[descriptor_count] = descriptor;
-                descriptor_count++;
-
-                // Sync frame generation if not using a default texture.
-                if (t->generation != INVALID_ID) {
-                    *descriptor_generation = t->generation;
-                    *descriptor_id = t->id;
-                }
-                descriptor_index++;
-            }
-        }
-
-        if (descriptor_count > 0) {
-            vkUpdateDescriptorSets(context->device.handle, descriptor_count, descriptor_writes, 0, 0);
         }
 
         // Bind the descriptor set to be updated, or in case the shader changed.
         vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, shader->pipeline.layout, 1, 1, &object_descriptor_set, 0, 0);
+        shader->bound_texture = t;
+        shader->bound_texture_generation = t->generation;
     }
 }
 
@@ -11,9 +11,14 @@
 #include "third_party/cglm/cglm.h"
 #include "vulkan_buffer.h"
 #include "vulkan_image.h"
+#include "vulkan_memory.h"
+#include "vulkan_sampler.h"
+#include "vulkan_staging.h"
 #include "math/math_types.h"
+#include "resources/block_compression.h"
 
 #include "containers/darray.h"
+#include "containers/dynamic_array.h"
 
 #include "core/application.h"
 #include "core/logger.h"
@@ -21,6 +26,10 @@
 
 #include "systems/material_system.h"
 
+#include <stdlib.h>
+
+#define TEXTURE_IMAGE_FORMAT VK_FORMAT_R8G8B8A8_SNORM
+
 static vulkan_context context;
 static u32 cached_framebuffer_width;
 static u32 cached_framebuffer_height;
@@ -33,10 +42,26 @@ static i32 find_memory_index(u32 required_types, VkMemoryPropertyFlags required_
 static void createCommandBuffers(renderer_backend* backend);
 static void regenerate_framebuffers();
 static b8 recreate_swapchain(renderer_backend* backend);
+static VkFormat texture_image_format(Texture_Format format);
 
 static b8 create_buffers(vulkan_context* context);
 
+static b8 suballocate_geometry_range(vulkan_buffer* buffer, u64 size, u64* offset);
+static u32 retire_slot(void);
+static void retire_geometry_range(vulkan_buffer* buffer, u64 size, u64 offset);
+static void release_retired(u32 slot);
+static void release_texture(Texture* texture);
+static void destroy_texture_resource(vulkan_texture_resource* data);
+static void defragment_geometry_buffers(void);
+static u64 defragment_geometry(vulkan_buffer* buffer, b8 indices, u64 max_bytes, VkCommandBuffer command_buffer);
+static u64* geometry_range(vulkan_geometry_buffer_data* data, b8 indices, u64* size);
+static int compare_vertex_offsets(void const* a, void const* b);
+static int compare_index_offsets(void const* a, void const* b);
 static b8 upload_data_to_device_local_memory(VkCommandPool pool, VkFence fence, VkQueue queue, vulkan_buffer* buffer, u64* offset, u64 size, void const* data);
+static b8 create_texture_resources(Texture* texture);
+static void record_texture_upload(Texture* texture, vulkan_command_buffer* command_buffer, VkBuffer source, u64 source_offset);
+static void pack_texture_regions(Texture const* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels, u8* destination, u64 destination_offset, VkBufferImageCopy* copies);
+static void record_texture_update(Texture* texture, vulkan_command_buffer* command_buffer, VkBuffer source, VkBufferImageCopy const* copies, u32 copy_count);
 
 b8 vulkan_backend_startup(char const* app_name, u32 width, u32 height)
 {
@@ -168,6 +193,8 @@ b8 vulkan_backend_startup(char const* app_name, u32 width, u32 height)
         return FALSE;
     }
 
+    vulkan_memory_create(&context, &context.memory);
+
     if (!vulkan_swapchain_create(&context, context.framebuffer_width, context.framebuffer_height, &context.swapchain))
     {
         LOG_ERROR("vulkan_backend_startup: Failed to create swapchain");
@@ -241,6 +268,19 @@ b8 vulkan_backend_startup(char const* app_name, u32 width, u32 height)
     }
 
     create_buffers(&context);
+    for (u32 i = 0; i < VULKAN_MAX_FRAME_COUNT; ++i)
+    {
+        context.retired_ranges[i] = DYNAMIC_ARRAY_CREATE(vulkan_retired_range);
+        context.retired_textures[i] = DYNAMIC_ARRAY_CREATE(vulkan_texture_resource*);
+        context.retired_views[i] = DYNAMIC_ARRAY_CREATE(VkImageView);
+    }
+
+    if (!vulkan_staging_create(&context, VULKAN_STAGING_RING_SIZE, &context.staging)) {
+        LOG_ERROR("Failed to create the staging ring");
+        return FALSE;
+    }
+
+    vulkan_sampler_cache_create(&context.sampler_cache);
 
     // Mark all geometries as invalid
     for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i) {
@@ -255,7 +295,23 @@ void vulkan_backend_shutdown(struct renderer_backend* backend)
 {
     vkDeviceWaitIdle(context.device.handle);
 
+    // Retired textures still hold samplers from the cache.
+    for (u32 i = 0; i < VULKAN_MAX_FRAME_COUNT; ++i) {
+        release_retired(i);
+    }
+
+    vulkan_staging_destroy(&context, &context.staging);
+    vulkan_sampler_cache_destroy(&context, &context.sampler_cache);
+
     // Vertex/index buffers
+    for (u32 i = 0; i < VULKAN_MAX_FRAME_COUNT; ++i) {
+        dynamic_array_destroy(context.retired_ranges[i]);
+        context.retired_ranges[i] = 0;
+        dynamic_array_destroy(context.retired_textures[i]);
+        context.retired_textures[i] = 0;
+        dynamic_array_destroy(context.retired_views[i]);
+        context.retired_views[i] = 0;
+    }
     vulkan_buffer_destroy(&context, &context.object_vertex_buffer);
     vulkan_buffer_destroy(&context, &context.object_index_buffer);
 
@@ -295,6 +351,7 @@ void vulkan_backend_shutdown(struct renderer_backend* backend)
 
     // Swapchain
     vulkanSwapchainDestroy(&context, &context.swapchain);
+    vulkan_memory_destroy(&context, &context.memory);
     vulkanDeviceDestroy(&context);
     vkDestroySurfaceKHR(context.instance, context.surface, context.allocator);
 #ifdef _DEBUG
@@ -355,6 +412,10 @@ b8 vulkan_backend_begin_frame(renderer_backend* backend, f64 delta_time)
         return FALSE;
     }
 
+    // The frame last recorded in this slot has completed, and with it everything submitted before it, so nothing reads
+    // the geometry buffers, ranges and textures retired into the slot any more.
+    release_retired(context.current_frame);
+
     if (!vulkan_swapchain_acquire_next_image(
         &context, &context.swapchain, UINT64_MAX,
         context.image_available_semaphors.data[context.current_frame],
@@ -384,6 +445,13 @@ b8 vulkan_backend_begin_frame(renderer_backend* backend, f64 delta_time)
 
     context.main_renderpass.render_area[2] = context.framebuffer_width;
     context.main_renderpass.render_area[3] = context.framebuffer_height;
+    context.frame_in_progress = TRUE;
+
+    // The frame is certain to be submitted from here on, so the ranges compaction moves away from can wait for its fence.
+    if (context.geometry_defrag_pending)
+    {
+        defragment_geometry_buffers();
+    }
     return TRUE;
 }
 
@@ -416,6 +484,7 @@ b8 vulkan_backend_end_frame(struct renderer_backend* backend, f64 deltaTime)
 {
     vulkan_command_buffer* command_buffer = &context.command_buffers.data[context.current_image];
     vulkan_command_buffer_end(command_buffer);
+    context.frame_in_progress = FALSE;
 
     // Make sure the previous frame is not using this image
     if (context.images_in_flight[context.current_frame]) {
@@ -500,7 +569,7 @@ void vulkan_backend_draw_geometry(geometry_render_data data)
             return;
     }
 
-    VkDeviceSize offsets[] = { 0 };
+    VkDeviceSize offsets[] = { buffer_data->vertex_buffer_offset };
     vkCmdBindVertexBuffers(command_buffer->handle, 0, 1, &context.object_vertex_buffer.handle, offsets);
 
     // Draw indexed or non-indexed.
@@ -520,14 +589,23 @@ void vulkan_backend_draw_geometry(geometry_render_data data)
 
 void vulkan_backend_create_texture(u8 const* pixels, Texture* texture)
 {
-    texture->internal = memory_allocate(sizeof(vulkan_texture_resource), MEMORY_TAG_TEXTURE);
-    vulkan_texture_resource* data = texture->internal;
+    // Written later, by vulkan_backend_update_texture.
+    if (!pixels) {
+        create_texture_resources(texture);
+        texture->generation++;
+        return;
+    }
 
-    VkDeviceSize image_size = texture->width * texture->height * texture->channel_count;
+    VkDeviceSize image_size = block_compression_chain_size(texture->format, texture->width, texture->height, texture->mip_count);
 
-    VkFormat image_format = VK_FORMAT_R8G8B8A8_SNORM;
+    Staging_Region region;
+    if (vulkan_staging_acquire(&context, &context.staging, image_size, &region)) {
+        memory_copy(region.memory, pixels, image_size);
+        vulkan_backend_create_texture_from_staging(&region, texture);
+        return;
+    }
 
-    // Staging buffer
+    // Larger than the staging ring, so uploaded through a staging buffer of its own.
     VkBufferUsageFlagBits usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     VkMemoryPropertyFlagBits memory_properties =
         VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
@@ -537,84 +615,130 @@ void vulkan_backend_create_texture(u8 const* pixels, Texture* texture)
 
     vulkan_buffer_upload_to_host_visible_memory(&context, &staging, 0, image_size, 0, pixels);
 
-    vulkan_image_create(
-        &context,
-        VK_IMAGE_TYPE_2D,
-        texture->width,
-        texture->height,
-        image_format,
-        VK_IMAGE_TILING_OPTIMAL,
-        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-        TRUE,
-        VK_IMAGE_ASPECT_COLOR_BIT,
-        &data->image);
-
     VkCommandPool pool = context.device.graphics_command_pool;
     VkQueue queue = context.device.queues.graphics.handle;
     vulkan_command_buffer temp_command_buffer;
 
+    create_texture_resources(texture);
     vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &temp_command_buffer);
-    vulkan_image_transition_layout(
-        &context,
-        &temp_command_buffer,
-        &data->image,
-        image_format,
-        VK_IMAGE_LAYOUT_UNDEFINED,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    vulkan_image_copy_from_buffer(&context, &temp_command_buffer, &data->image, staging.handle);
-
-    vulkan_image_transition_layout(
-        &context,
-        &temp_command_buffer,
-        &data->image,
-        image_format,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    record_texture_upload(texture, &temp_command_buffer, staging.handle, 0);
     vulkan_command_buffer_end_single_use(&context, pool, &temp_command_buffer, queue);
     vulkan_buffer_destroy(&context, &staging);
 
-    VkSamplerCreateInfo sampler_create_info = {};
-    sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-    sampler_create_info.pNext = 0;
-    sampler_create_info.flags = 0;
-    sampler_create_info.magFilter = VK_FILTER_LINEAR;
-    sampler_create_info.minFilter = VK_FILTER_LINEAR;
-    sampler_create_info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-    sampler_create_info.mipLodBias = 0.f;
-    sampler_create_info.anisotropyEnable = VK_TRUE;
-    sampler_create_info.maxAnisotropy = 1.f;
-    sampler_create_info.compareEnable = VK_FALSE;
-    sampler_create_info.compareOp = VK_COMPARE_OP_NEVER;
-    sampler_create_info.minLod = 0.f;
-    sampler_create_info.maxLod = 0.f;
-    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
-    sampler_create_info.unnormalizedCoordinates = VK_FALSE;
-    VULKAN_CHECK_RESULT(vkCreateSampler(context.device.handle, &sampler_create_info, context.allocator, &data->sampler));
-
     texture->generation++;
 }
 
-void vulkan_backend_destroy_texture(Texture* texture)
+void vulkan_backend_update_texture(Texture* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels)
 {
-    vkDeviceWaitIdle(context.device.handle);
+    vulkan_texture_resource* data = texture->internal;
+    if (!data || region_count == 0) {
+        return;
+    }
+
+    u64 size = 0;
+    for (u32 i = 0; i < region_count; ++i) {
+        size += block_compression_level_size(texture->format, regions[i].width, regions[i].height);
+    }
+
+    // The regions are packed one after another, each like a level of its own, and written by one copy command.
+    VkBufferImageCopy* copies = memory_allocate(region_count * sizeof(*copies), MEMORY_TAG_RENDERER);
+    VkCommandPool pool = context.device.graphics_command_pool;
+    vulkan_command_buffer command_buffer;
+    Staging_Region region;
+    if (vulkan_staging_acquire(&context, &context.staging, size, &region)) {
+        // Submitted without waiting, like a texture created from staging.
+        pack_texture_regions(texture, regions, region_count, pixels, region.memory, region.offset, copies);
+        vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &command_buffer);
+        record_texture_update(texture, &command_buffer, context.staging.buffer.handle, copies, region_count);
+        vulkan_staging_submit(&context, &context.staging, &region, &command_buffer);
+    } else {
+        // Larger than the staging ring, so written through a staging buffer of its own.
+        u8* packed = memory_allocate(size, MEMORY_TAG_RENDERER);
+        pack_texture_regions(texture, regions, region_count, pixels, packed, 0, copies);
+
+        vulkan_buffer staging;
+        vulkan_buffer_create(&context, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, TRUE, &staging);
+        vulkan_buffer_upload_to_host_visible_memory(&context, &staging, 0, size, 0, packed);
+        memory_free(packed, size, MEMORY_TAG_RENDERER);
+
+        vulkan_command_buffer_allocate_and_begin_single_use(&context, pool, &command_buffer);
+        record_texture_update(texture, &command_buffer, staging.handle, copies, region_count);
+        vulkan_command_buffer_end_single_use(&context, pool, &command_buffer, context.device.queues.graphics.handle);
+        vulkan_buffer_destroy(&context, &staging);
+    }
+
+    memory_free(copies, region_count * sizeof(*copies), MEMORY_TAG_RENDERER);
+}
 
+void vulkan_backend_set_texture_base_level(Texture* texture, u32 base_level)
+{
     vulkan_texture_resource* data = texture->internal;
+    if (!data) {
+        return;
+    }
 
-    if (data != 0) {
-        vulkan_image_destroy(&context, &data->image);
-        memory_zero(&data->image, sizeof(data->image));
-        vkDestroySampler(context.device.handle, data->sampler, context.allocator);
-        data->sampler = 0;
+    // Frames in flight may still sample through the old view. The new generation has descriptors written again.
+    dynamic_array_push_back(context.retired_views[retire_slot()], &data->image.view);
+    data->image.view = vulkan_image_level_view_create(&context, texture_image_format(texture->format), &data->image, VK_IMAGE_ASPECT_COLOR_BIT, base_level);
+    texture->generation++;
+}
+
+b8 vulkan_backend_staging_acquire(u64 size, Staging_Region* region)
+{
+    return vulkan_staging_acquire(&context, &context.staging, size, region);
+}
+
+void vulkan_backend_staging_cancel(Staging_Region* region)
+{
+    vulkan_staging_cancel(&context, &context.staging, region);
+}
+
+void vulkan_backend_create_texture_from_staging(Staging_Region* region, Texture* texture)
+{
+    // The copy is submitted without waiting; the ring reuses the region once its fence has signalled.
+    vulkan_command_buffer command_buffer;
+    create_texture_resources(texture);
+    vulkan_command_buffer_allocate_and_begin_single_use(&context, context.device.graphics_command_pool, &command_buffer);
+    record_texture_upload(texture, &command_buffer, context.staging.buffer.handle, region->offset);
+    vulkan_staging_submit(&context, &context.staging, region, &command_buffer);
+
+    texture->generation++;
+}
 
-        memory_free(texture->internal, sizeof(vulkan_texture_resource), MEMORY_TAG_TEXTURE);
+b8 vulkan_backend_supports_texture_format(Texture_Format format)
+{
+    if (format == TEXTURE_FORMAT_RGBA8) {
+        return TRUE;
     }
 
-    memory_zero(texture, sizeof(*texture));
+    // Block formats need the textureCompressionBC feature, which covers all of them, and sampling support.
+    if (!context.device.features.textureCompressionBC) {
+        return FALSE;
+    }
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(context.device.physical_device, texture_image_format(format), &properties);
+    return (properties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+}
+
+VkFormat texture_image_format(Texture_Format format)
+{
+    // Sampled without sRGB decoding like the uncompressed format. The block formats have no SNORM form, so UNORM.
+    switch (format) {
+        case TEXTURE_FORMAT_BC1:
+            return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case TEXTURE_FORMAT_BC3:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        case TEXTURE_FORMAT_BC7:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        default:
+            return TEXTURE_IMAGE_FORMAT;
+    }
+}
+
+void vulkan_backend_destroy_texture(Texture* texture)
+{
+    release_texture(texture);
 }
 
 b8 vulkan_backend_create_material(Material* material)
@@ -678,36 +802,22 @@ b8 vulkan_backend_create_geometry(Geometry* geometry, u32 vertex_size_in_bytes,
         return FALSE;
     }
 
+    // A new geometry only claims its slot once its ranges are allocated, so a failure leaves nothing behind.
     b8 reupload = geometry->internal_id != INVALID_ID;
-    vulkan_geometry_buffer_data old_geometry;
-
-    vulkan_geometry_buffer_data* internal_data = 0;
-    if (reupload) {
-        internal_data = &context.geometries[geometry->internal_id];
-
-        // Take a copy of the old range.
-        old_geometry.index_buffer_offset = internal_data->index_buffer_offset;
-        old_geometry.index_count = internal_data->index_count;
-        old_geometry.index_size_in_bytes = internal_data->index_size_in_bytes;
-        old_geometry.vertex_buffer_offset = internal_data->vertex_buffer_offset;
-        old_geometry.vertex_count = internal_data->vertex_count;
-        old_geometry.vertex_size_in_bytes = internal_data->vertex_size_in_bytes;
-    }
-    else
+    u32 internal_id = geometry->internal_id;
+    if (!reupload)
     {
         for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i)
         {
             if (context.geometries[i].id == INVALID_ID)
             {
-                geometry->internal_id = i;
-                context.geometries[i].id = geometry->internal_id;
-                internal_data = &context.geometries[i];
+                internal_id = i;
                 break;
             }
         }
     }
 
-    if (!internal_data)
+    if (internal_id == INVALID_ID)
     {
         LOG_ERROR("vulkan_backend_create_geometry: Failed to find a free index for a new geometry upload");
         return FALSE;
@@ -716,25 +826,47 @@ b8 vulkan_backend_create_geometry(Geometry* geometry, u32 vertex_size_in_bytes,
     VkCommandPool pool = context.device.graphics_command_pool;
     VkQueue queue = context.device.queues.graphics.handle;
 
+    // The new ranges are taken while the old ones are still held, so a reupload that fails leaves the geometry as it was.
+    u64 vertex_buffer_size = (u64)vertex_count * vertex_size_in_bytes;
+    u64 vertex_buffer_offset;
+    if (!suballocate_geometry_range(&context.object_vertex_buffer, vertex_buffer_size, &vertex_buffer_offset))
+    {
+        LOG_ERROR("vulkan_backend_create_geometry: Failed to allocate vertex data");
+        return FALSE;
+    }
+
+    b8 has_indices = index_count != 0 && indices;
+    u64 index_buffer_size = (u64)index_count * index_size_in_bytes;
+    u64 index_buffer_offset = 0;
+    if (has_indices && !suballocate_geometry_range(&context.object_index_buffer, index_buffer_size, &index_buffer_offset))
+    {
+        LOG_ERROR("vulkan_backend_create_geometry: Failed to allocate index data");
+        vulkan_buffer_free(&context.object_vertex_buffer, vertex_buffer_size, vertex_buffer_offset);
+        return FALSE;
+    }
+
+    vulkan_geometry_buffer_data* internal_data = &context.geometries[internal_id];
+    if (!reupload)
+    {
+        geometry->internal_id = internal_id;
+        internal_data->id = internal_id;
+    }
+
+    vulkan_geometry_buffer_data old_geometry = *internal_data;
+
     // Vertex data.
-    internal_data->vertex_buffer_offset = context.geometry_vertex_offset;
+    internal_data->vertex_buffer_offset = vertex_buffer_offset;
     internal_data->vertex_count = vertex_count;
     internal_data->vertex_size_in_bytes = vertex_size_in_bytes;
-    u32 total_size = vertex_count * vertex_size_in_bytes;
-    vulkan_buffer_upload_to_device_local_memory(&context, pool, 0, queue, &context.object_vertex_buffer, internal_data->vertex_buffer_offset, total_size, vertices);
-    // TODO: should maintain a free list instead of this.
-    context.geometry_vertex_offset += total_size;
+    vulkan_buffer_upload_to_device_local_memory(&context, pool, 0, queue, &context.object_vertex_buffer, vertex_buffer_offset, vertex_buffer_size, vertices);
 
     // Index data, if applicable
-    if (index_count != 0 && indices)
+    internal_data->index_buffer_offset = index_buffer_offset;
+    internal_data->index_count = has_indices ? index_count : 0;
+    internal_data->index_size_in_bytes = has_indices ? index_size_in_bytes : 0;
+    if (has_indices)
     {
-        internal_data->index_buffer_offset = context.geometry_index_offset;
-        internal_data->index_count = index_count;
-        internal_data->index_size_in_bytes = index_size_in_bytes;
-        total_size = index_count * index_size_in_bytes;
-        vulkan_buffer_upload_to_device_local_memory(&context, pool, 0, queue, &context.object_index_buffer, internal_data->index_buffer_offset, total_size, indices);
-        // TODO: should maintain a free list instead of this.
-        context.geometry_index_offset += total_size;
+        vulkan_buffer_upload_to_device_local_memory(&context, pool, 0, queue, &context.object_index_buffer, index_buffer_offset, index_buffer_size, indices);
     }
 
     if (internal_data->generation == INVALID_ID)
@@ -746,13 +878,14 @@ b8 vulkan_backend_create_geometry(Geometry* geometry, u32 vertex_size_in_bytes,
         internal_data->generation++;
     }
 
+    // Frames in flight may still draw the old data, so its ranges are only freed once they have completed.
     if (reupload)
     {
-        vulkan_buffer_free_data(&context.object_vertex_buffer, old_geometry.vertex_buffer_offset, old_geometry.vertex_size_in_bytes * old_geometry.vertex_count);
+        retire_geometry_range(&context.object_vertex_buffer, (u64)old_geometry.vertex_size_in_bytes * old_geometry.vertex_count, old_geometry.vertex_buffer_offset);
 
-        if (old_geometry.index_size_in_bytes > 0)
+        if (old_geometry.index_count > 0)
         {
-            vulkan_buffer_free_data(&context.object_index_buffer, old_geometry.index_buffer_offset, old_geometry.index_size_in_bytes * old_geometry.index_count);
+            retire_geometry_range(&context.object_index_buffer, (u64)old_geometry.index_size_in_bytes * old_geometry.index_count, old_geometry.index_buffer_offset);
         }
     }
 
@@ -763,22 +896,24 @@ void vulkan_backend_destroy_geometry(Geometry* geometry)
 {
     if (geometry && geometry->internal_id != INVALID_ID)
     {
-        vkDeviceWaitIdle(context.device.handle);
         vulkan_geometry_buffer_data* internal_data = &context.geometries[geometry->internal_id];
 
-        // Free vertex data
-        vulkan_buffer_free_data(&context.object_vertex_buffer, internal_data->vertex_buffer_offset, internal_data->vertex_size_in_bytes * internal_data->vertex_count);
+        // Free vertex data once the frames in flight, which may have drawn it, have completed
+        retire_geometry_range(&context.object_vertex_buffer, (u64)internal_data->vertex_size_in_bytes * internal_data->vertex_count, internal_data->vertex_buffer_offset);
 
         // Free index data, if applicable
-        if (internal_data->index_size_in_bytes > 0)
+        if (internal_data->index_count > 0)
         {
-            vulkan_buffer_free_data(&context.object_index_buffer, internal_data->index_buffer_offset, internal_data->index_size_in_bytes * internal_data->index_count);
+            retire_geometry_range(&context.object_index_buffer, (u64)internal_data->index_size_in_bytes * internal_data->index_count, internal_data->index_buffer_offset);
         }
 
         // Clean up data.
         memory_zero(internal_data, sizeof(vulkan_geometry_buffer_data));
         internal_data->id = INVALID_ID;
         internal_data->generation = INVALID_ID;
+
+        // The holes left behind once the ranges are freed are closed at the start of later frames.
+        context.geometry_defrag_pending = TRUE;
     }
     else
     {
@@ -870,17 +1005,7 @@ VkBool32 debug_utils_messenger_callback(VkDebugUtilsMessageSeverityFlagBitsEXT m
 
 i32 find_memory_index(u32 required_types, VkMemoryPropertyFlags required_properties)
 {
-    VkPhysicalDeviceMemoryProperties memory_properties;
-    vkGetPhysicalDeviceMemoryProperties(context.device.physical_device, &memory_properties);
-    for (u32 i = 0; i < memory_properties.memoryTypeCount; ++i)
-    {
-        if ((required_types & (1 << i)) && ((memory_properties.memoryTypes[i].propertyFlags & required_properties) == required_properties))
-        {
-            return i;
-        }
-    }
-
-    return -1;
+    return vulkan_memory_find_type(&context, &context.memory, required_types, required_properties);
 }
 
 void createCommandBuffers(renderer_backend* backend)
@@ -945,6 +1070,11 @@ b8 recreate_swapchain(renderer_backend* backend)
     context.recreating_swapchain = TRUE;
     vkDeviceWaitIdle(context.device.handle);
 
+    // The new swapchain starts over at the first slot and may have fewer images, so nothing is left waiting for a slot.
+    for (u32 i = 0; i < VULKAN_MAX_FRAME_COUNT; ++i) {
+        release_retired(i);
+    }
+
     vulkan_device_query_swapchain_support(
         context.device.physical_device,
         context.surface,
@@ -1006,7 +1136,8 @@ b8 create_buffers(vulkan_context* context)
         return FALSE;
     }
 
-    context->geometry_vertex_offset = 0;
+    // Geometry data is placed in the vertex and index buffers through their freelists.
+    vulkan_buffer_enable_suballocation(&context->object_vertex_buffer);
 
     u64 index_buffer_size = 1024 * 1024 * sizeof(u32);
     if (!vulkan_buffer_create(
@@ -1020,12 +1151,367 @@ b8 create_buffers(vulkan_context* context)
         return FALSE;
     }
 
-    context->geometry_index_offset = 0;
+    vulkan_buffer_enable_suballocation(&context->object_index_buffer);
 
     return TRUE;
 }
 
+b8 suballocate_geometry_range(vulkan_buffer* buffer, u64 size, u64* offset)
+{
+    // Geometry can be created while a frame is being recorded, which may have drawn from any range, so the buffer grows
+    // rather than being compacted here. Holes too small for this are closed at the start of the next frames.
+    if (freelist_largest_free_block(buffer->freelist) < size)
+    {
+        if (freelist_free_space(buffer->freelist) >= size)
+        {
+            context.geometry_defrag_pending = TRUE;
+        }
+
+        u32 slot = retire_slot();
+
+        if (context.retired_buffer_counts[slot] == VULKAN_MAX_RETIRED_BUFFERS)
+        {
+            LOG_ERROR("suballocate_geometry_range: Too many geometry buffer resizes within one frame");
+            return FALSE;
+        }
+
+        // Doubling keeps the number of copies of the whole buffer low while geometry keeps coming.
+        u64 new_size = buffer->size * 2;
+        while (new_size - buffer->size < size)
+        {
+            new_size *= 2;
+        }
+
+        // Freelist offsets are 32 bit.
+        if (new_size > INVALID_ID)
+        {
+            LOG_ERROR("suballocate_geometry_range: Geometry buffer can't grow past 4 GiB");
+            return FALSE;
+        }
+
+        // The old buffer is kept for the draws the current frame may have recorded with it.
+        LOG_INFO("Growing geometry buffer from %llu to %llu bytes", buffer->size, new_size);
+        vulkan_buffer* old_buffer = &context.retired_buffers[slot][context.retired_buffer_counts[slot]];
+        if (!vulkan_buffer_resize(&context, buffer, new_size, context.device.graphics_command_pool, context.device.queues.graphics.handle, old_buffer))
+        {
+            return FALSE;
+        }
+        context.retired_buffer_counts[slot]++;
+    }
+
+    return vulkan_buffer_suballocate(buffer, size, offset);
+}
+
+u32 retire_slot(void)
+{
+    // Between frames the frame submitted last is the one to wait for, and it completes after every frame before it.
+    if (!context.frame_in_progress)
+    {
+        return (context.current_frame + context.swapchain.images.size - 1) % context.swapchain.images.size;
+    }
+
+    return context.current_frame;
+}
+
+void retire_geometry_range(vulkan_buffer* buffer, u64 size, u64 offset)
+{
+    vulkan_retired_range range = { buffer, size, offset };
+    dynamic_array_push_back(context.retired_ranges[retire_slot()], &range);
+}
+
+void release_retired(u32 slot)
+{
+    // Ranges go back before buffers are destroyed, as they belong to the buffers in use rather than the retired ones.
+    Dynamic_Array* ranges = context.retired_ranges[slot];
+    for (u32 i = 0; i < ranges->size; ++i)
+    {
+        vulkan_retired_range* range = &DYNAMIC_ARRAY_AT_AS(ranges, i, vulkan_retired_range);
+        vulkan_buffer_free(range->buffer, range->size, range->offset);
+    }
+    dynamic_array_resize(ranges, 0);
+
+    for (u32 i = 0; i < context.retired_buffer_counts[slot]; ++i)
+    {
+        vulkan_buffer_destroy(&context, &context.retired_buffers[slot][i]);
+    }
+    context.retired_buffer_counts[slot] = 0;
+
+    Dynamic_Array* textures = context.retired_textures[slot];
+    for (u32 i = 0; i < textures->size; ++i)
+    {
+        destroy_texture_resource(DYNAMIC_ARRAY_AT_AS(textures, i, vulkan_texture_resource*));
+    }
+    dynamic_array_resize(textures, 0);
+
+    Dynamic_Array* views = context.retired_views[slot];
+    for (u32 i = 0; i < views->size; ++i)
+    {
+        vkDestroyImageView(context.device.handle, DYNAMIC_ARRAY_AT_AS(views, i, VkImageView), context.allocator);
+    }
+    dynamic_array_resize(views, 0);
+
+    if (context.defrag_command_buffers[slot].handle != VK_NULL_HANDLE)
+    {
+        vulkanCommandBufferFree(&context, context.device.graphics_command_pool, &context.defrag_command_buffers[slot]);
+    }
+}
+
+void release_texture(Texture* texture)
+{
+    // Frames in flight may still sample the texture, so it's destroyed once they have completed.
+    vulkan_texture_resource* data = texture->internal;
+    if (data != 0) {
+        dynamic_array_push_back(context.retired_textures[retire_slot()], &data);
+    }
+
+    memory_zero(texture, sizeof(*texture));
+}
+
+void destroy_texture_resource(vulkan_texture_resource* data)
+{
+    vulkan_image_destroy(&context, &data->image);
+    memory_zero(&data->image, sizeof(data->image));
+    vulkan_sampler_release(&context, &context.sampler_cache, data->sampler);
+    data->sampler = 0;
+
+    memory_free(data, sizeof(vulkan_texture_resource), MEMORY_TAG_TEXTURE);
+}
+
+void defragment_geometry_buffers(void)
+{
+    // Submitted on its own, ahead of the frame, and not waited for. The holes it copies into are free, so no frame in
+    // flight reads them, and the ranges it copies from are retired into this frame's slot.
+    vulkan_command_buffer* command_buffer = &context.defrag_command_buffers[context.current_frame];
+    vulkan_command_buffer_allocate_and_begin_single_use(&context, context.device.graphics_command_pool, command_buffer);
+
+    u64 moved_bytes = defragment_geometry(&context.object_vertex_buffer, FALSE, VULKAN_GEOMETRY_DEFRAG_BYTES_PER_PASS, command_buffer->handle);
+    moved_bytes += defragment_geometry(&context.object_index_buffer, TRUE, VULKAN_GEOMETRY_DEFRAG_BYTES_PER_PASS, command_buffer->handle);
+    context.geometry_defrag_pending = moved_bytes > 0;
+    if (moved_bytes == 0)
+    {
+        vulkan_command_buffer_end(command_buffer);
+        vulkanCommandBufferFree(&context, context.device.graphics_command_pool, command_buffer);
+        return;
+    }
+
+    // Covers everything submitted after it, so draws and the copies of a buffer resize see the moved data.
+    VkMemoryBarrier barrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+    vkCmdPipelineBarrier(
+        command_buffer->handle,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 1, &barrier, 0, 0, 0, 0);
+    vulkan_command_buffer_end(command_buffer);
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer->handle;
+    VULKAN_CHECK_RESULT(vkQueueSubmit(context.device.queues.graphics.handle, 1, &submit_info, VK_NULL_HANDLE));
+    vulkanCommandBufferUpdateSubmitted(command_buffer);
+}
+
+u64 defragment_geometry(vulkan_buffer* buffer, b8 indices, u64 max_bytes, VkCommandBuffer command_buffer)
+{
+    // With all free space in one block there are no holes to close.
+    if (freelist_largest_free_block(buffer->freelist) == freelist_free_space(buffer->freelist))
+    {
+        return 0;
+    }
+
+    // Ranges at the end of the buffer are moved first, each into the lowest hole it fits, which leaves the free space
+    // at the end where it joins up.
+    u32 order[VULKAN_MAX_GEOMETRY_COUNT];
+    u32 live_count = 0;
+    for (u32 i = 0; i < VULKAN_MAX_GEOMETRY_COUNT; ++i)
+    {
+        if (context.geometries[i].id == INVALID_ID)
+        {
+            continue;
+        }
+
+        // Geometries without indices have no index range to move.
+        u64 size;
+        geometry_range(&context.geometries[i], indices, &size);
+        if (size > 0)
+        {
+            order[live_count++] = i;
+        }
+    }
+    qsort(order, live_count, sizeof(*order), indices ? compare_index_offsets : compare_vertex_offsets);
+
+    VkBufferCopy regions[VULKAN_GEOMETRY_DEFRAG_MAX_MOVES];
+    u32 moved[VULKAN_GEOMETRY_DEFRAG_MAX_MOVES];
+    u32 move_count = 0;
+    u64 moved_bytes = 0;
+    for (u32 i = 0; i < live_count && move_count < VULKAN_GEOMETRY_DEFRAG_MAX_MOVES && moved_bytes < max_bytes; ++i)
+    {
+        u64 size;
+        u64 offset = *geometry_range(&context.geometries[order[i]], indices, &size);
+        if (freelist_largest_free_block(buffer->freelist) < size)
+        {
+            continue;
+        }
+
+        // The old range is only freed once the frame has completed, so no destination overlaps a source.
+        u64 new_offset;
+        vulkan_buffer_suballocate(buffer, size, &new_offset);
+        if (new_offset > offset)
+        {
+            vulkan_buffer_free(buffer, size, new_offset);
+            continue;
+        }
+
+        regions[move_count].srcOffset = offset;
+        regions[move_count].dstOffset = new_offset;
+        regions[move_count].size = size;
+        moved[move_count] = order[i];
+        move_count++;
+        moved_bytes += size;
+    }
+
+    if (move_count == 0)
+    {
+        return 0;
+    }
+
+    // Frames of other slots may still be drawing from the ranges moved away from, as may the copy itself.
+    vkCmdCopyBuffer(command_buffer, buffer->handle, buffer->handle, move_count, regions);
+    for (u32 i = 0; i < move_count; ++i)
+    {
+        u64 size;
+        *geometry_range(&context.geometries[moved[i]], indices, &size) = regions[i].dstOffset;
+        retire_geometry_range(buffer, regions[i].size, regions[i].srcOffset);
+    }
+
+    LOG_DEBUG("Moved %u geometry ranges, %llu bytes, to close holes", move_count, moved_bytes);
+    return moved_bytes;
+}
+
+u64* geometry_range(vulkan_geometry_buffer_data* data, b8 indices, u64* size)
+{
+    if (indices)
+    {
+        *size = (u64)data->index_count * data->index_size_in_bytes;
+        return &data->index_buffer_offset;
+    }
+
+    *size = (u64)data->vertex_count * data->vertex_size_in_bytes;
+    return &data->vertex_buffer_offset;
+}
+
+int compare_vertex_offsets(void const* a, void const* b)
+{
+    u64 first = context.geometries[*(u32 const*)a].vertex_buffer_offset;
+    u64 second = context.geometries[*(u32 const*)b].vertex_buffer_offset;
+    return (first < second) - (first > second);
+}
+
+int compare_index_offsets(void const* a, void const* b)
+{
+    u64 first = context.geometries[*(u32 const*)a].index_buffer_offset;
+    u64 second = context.geometries[*(u32 const*)b].index_buffer_offset;
+    return (first < second) - (first > second);
+}
+
 b8 upload_data_to_device_local_memory(VkCommandPool pool, VkFence fence, VkQueue queue, vulkan_buffer* buffer, u64* offset, u64 size, void const* data)
 {
     
 }
+
+b8 create_texture_resources(Texture* texture)
+{
+    texture->internal = memory_allocate(sizeof(vulkan_texture_resource), MEMORY_TAG_TEXTURE);
+    vulkan_texture_resource* data = texture->internal;
+
+    vulkan_image_create(
+        &context,
+        VK_IMAGE_TYPE_2D,
+        texture->width,
+        texture->height,
+        texture->mip_count,
+        texture_image_format(texture->format),
+        VK_IMAGE_TILING_OPTIMAL,
+        VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        TRUE,
+        VK_IMAGE_ASPECT_COLOR_BIT,
+        &data->image);
+
+    // Textures share the sampler of their state, as drivers allow only a few thousand samplers.
+    vulkan_sampler_state sampler_state;
+    vulkan_sampler_state_default(&sampler_state);
+    data->sampler = vulkan_sampler_acquire(&context, &context.sampler_cache, &sampler_state);
+    data->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    return TRUE;
+}
+
+void record_texture_upload(Texture* texture, vulkan_command_buffer* command_buffer, VkBuffer source, u64 source_offset)
+{
+    vulkan_texture_resource* data = texture->internal;
+    vulkan_image_transition_layout(
+        &context,
+        command_buffer,
+        &data->image,
+        texture_image_format(texture->format),
+        VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+    // The levels are laid out the way block_compression_layout places them, all uploaded by one copy.
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u64 level_offsets[COOKED_TEXTURE_MAX_MIPS];
+    block_compression_layout(texture->format, texture->width, texture->height, source_offset, mips);
+    for (u32 i = 0; i < texture->mip_count; ++i) {
+        level_offsets[i] = mips[i].offset;
+    }
+
+    vulkan_image_copy_from_buffer(&context, command_buffer, &data->image, source, level_offsets);
+
+    vulkan_image_transition_layout(
+        &context,
+        command_buffer,
+        &data->image,
+        texture_image_format(texture->format),
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    data->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void pack_texture_regions(Texture const* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels, u8* destination, u64 destination_offset, VkBufferImageCopy* copies)
+{
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    block_compression_layout(texture->format, texture->width, texture->height, 0, mips);
+
+    u64 offset = 0;
+    for (u32 i = 0; i < region_count; ++i) {
+        Texture_Region const* r = &regions[i];
+        VkBufferImageCopy* copy = &copies[i];
+        memory_zero(copy, sizeof(*copy));
+        copy->bufferOffset = destination_offset + offset;
+        copy->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy->imageSubresource.mipLevel = r->level;
+        copy->imageSubresource.baseArrayLayer = 0;
+        copy->imageSubresource.layerCount = 1;
+        copy->imageOffset.x = (i32)r->x;
+        copy->imageOffset.y = (i32)r->y;
+        copy->imageExtent.width = r->width;
+        copy->imageExtent.height = r->height;
+        copy->imageExtent.depth = 1;
+
+        offset += block_compression_copy_region(texture->format, pixels + mips[r->level].offset, mips[r->level].width, r->x, r->y, r->width, r->height, destination + offset);
+    }
+}
+
+void record_texture_update(Texture* texture, vulkan_command_buffer* command_buffer, VkBuffer source, VkBufferImageCopy const* copies, u32 copy_count)
+{
+    // Every level moves between layouts together, which keeps what was written before.
+    vulkan_texture_resource* data = texture->internal;
+    VkFormat format = texture_image_format(texture->format);
+    vulkan_image_transition_layout(&context, command_buffer, &data->image, format, data->layout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    vkCmdCopyBufferToImage(command_buffer->handle, source, data->image.handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, copy_count, copies);
+    vulkan_image_transition_layout(&context, command_buffer, &data->image, format, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    data->layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
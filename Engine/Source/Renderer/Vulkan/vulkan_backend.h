@@ -19,6 +19,13 @@ void vulkan_backend_draw_geometry(geometry_render_data render_data);
 
 void vulkan_backend_create_texture(u8 const* pixels, Texture* texture);
 void vulkan_backend_destroy_texture(Texture* texture);
+void vulkan_backend_update_texture(Texture* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels);
+void vulkan_backend_set_texture_base_level(Texture* texture, u32 base_level);
+
+b8 vulkan_backend_staging_acquire(u64 size, Staging_Region* region);
+void vulkan_backend_staging_cancel(Staging_Region* region);
+void vulkan_backend_create_texture_from_staging(Staging_Region* region, Texture* texture);
+b8 vulkan_backend_supports_texture_format(Texture_Format format);
 
 b8 vulkan_backend_create_material(Material* material);
 void vulkan_backend_destroy_material(Material* material);
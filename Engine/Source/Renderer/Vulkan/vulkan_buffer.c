@@ -5,12 +5,12 @@
 #include "memory/dynamic_allocator.h"
 #include "vulkan_device.h"
 #include "vulkan_command_buffer.h"
+#include "vulkan_memory.h"
 #include "vulkan_utils.h"
 
 static void* VKAPI_CALL allocation(void* user_data, size_t size, size_t alignment, VkSystemAllocationScope allocation_scope);
 static void* VKAPI_CALL reallocation(void* user_data, void* original, size_t size, size_t alignment, VkSystemAllocationScope allocation_scope);
 static void VKAPI_CALL free(void* user_data, void* memory);
-static void destroy_suballocation_tracker(vulkan_buffer* buffer);
 
 b8 vulkan_buffer_create(vulkan_context* context, u64 size, VkBufferUsageFlagBits usage, u32 memory_property, b8 bind_on_create, vulkan_buffer* buffer)
 {
@@ -19,11 +19,6 @@ b8 vulkan_buffer_create(vulkan_context* context, u64 size, VkBufferUsageFlagBits
     buffer->usage = usage;
     buffer->memory_property = memory_property;
 
-    buffer->suballocation.required_memory = 0;
-    freelist_create(&buffer->suballocation.required_memory, 0, buffer->size, 0);
-    buffer->suballocation.block = memory_system_allocate(buffer->suballocation.required_memory, MEMORY_TAG_RENDERER);
-    freelist_create(&buffer->suballocation.required_memory, buffer->suballocation.block, buffer->size, &buffer->suballocation.tracker);
-
     VkBufferCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     createInfo.pNext = 0;
@@ -37,35 +32,24 @@ b8 vulkan_buffer_create(vulkan_context* context, u64 size, VkBufferUsageFlagBits
 
     VkMemoryRequirements memory_requirements;
     vkGetBufferMemoryRequirements(context->device.handle, buffer->handle, &memory_requirements);
-    buffer->memory_index = context->find_memory_type_index(memory_requirements.memoryTypeBits, buffer->memory_property);
-    if (buffer->memory_index == -1)
+    if (!vulkan_memory_allocate(context, &context->memory, &memory_requirements, buffer->memory_property, DEVICE_MEMORY_KIND_LINEAR, &buffer->allocation))
     {
-        LOG_ERROR("vulkan_buffer_create: Failed to find memory type index");
-        destroy_suballocation_tracker(buffer);
+        LOG_ERROR("vulkan_buffer_create: Failed to allocate memory");
+        vkDestroyBuffer(context->device.handle, buffer->handle, context->allocator);
+        buffer->handle = 0;
         return FALSE;
     }
 
-    VkMemoryAllocateInfo allocate_info = {};
-    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocate_info.pNext = 0;
-    allocate_info.allocationSize = memory_requirements.size;
-    allocate_info.memoryTypeIndex = buffer->memory_index;
-    VULKAN_CHECK_RESULT(vkAllocateMemory(context->device.handle, &allocate_info, context->allocator, &buffer->device_memory));
-    VULKAN_CHECK_RESULT(vkBindBufferMemory(context->device.handle, buffer->handle, buffer->device_memory, 0));
+    VULKAN_CHECK_RESULT(vkBindBufferMemory(context->device.handle, buffer->handle, buffer->allocation.memory, buffer->allocation.offset));
 
     return TRUE;
 }
 void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer)
 {
-    if (buffer->suballocation.block)
-    {
-        destroy_suballocation_tracker(buffer);
-    }
-
-    if (buffer->device_memory)
+    if (buffer->freelist)
     {
-        vkFreeMemory(context->device.handle, buffer->device_memory, context->allocator);
-        buffer->device_memory = 0;
+        freelist_destroy(buffer->freelist);
+        buffer->freelist = 0;
     }
 
     if (buffer->handle)
@@ -74,46 +58,70 @@ void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer)
         buffer->handle = 0;
     }
 
+    vulkan_memory_free(context, &context->memory, &buffer->allocation);
+
     buffer->size = 0;
     buffer->usage = 0;
     buffer->locked = FALSE;
 }
 
-b8 vulkan_buffer_resize(vulkan_context* context, vulkan_buffer* buffer, u64 new_size, VkCommandPool pool, VkQueue queue)
+b8 vulkan_buffer_resize(vulkan_context* context, vulkan_buffer* buffer, u64 new_size, VkCommandPool pool, VkQueue queue, vulkan_buffer* old_buffer)
 {
-    if (new_size <= buffer->size)
+    if (new_size <= buffer->size || (buffer->freelist && new_size > INVALID_ID))
     {
         LOG_ERROR("vulkan_buffer_resize: Invalid input parameters");
         return FALSE;
     }
 
-    freelist_resize(&buffer->suballocation.tracker, new_size);
-
     vulkan_buffer new_buffer;
-    vulkan_buffer_create(context, new_size, buffer->usage, buffer->memory_property, TRUE, &new_buffer);
-    vulkan_buffer_copy_to_buffer(context, pool, 0, queue, new_buffer.handle, 0, buffer->handle, 0, buffer->size);
+    if (!vulkan_buffer_create(context, new_size, buffer->usage, buffer->memory_property, TRUE, &new_buffer))
+    {
+        LOG_ERROR("vulkan_buffer_resize: Failed to create the new buffer");
+        return FALSE;
+    }
 
-    vkDeviceWaitIdle(context->device.handle);
+    // The copy waits for the queue to be idle both before and after, so nothing reads the old buffer anymore.
+    vulkan_buffer_copy_to_buffer(context, pool, 0, queue, buffer->handle, 0, new_buffer.handle, 0, buffer->size);
 
-    buffer->handle = new_buffer.handle;
-    buffer->size = new_buffer.size;
-    buffer->device_memory = new_buffer.device_memory;
+    // The space added is free, and suballocations keep their offsets.
+    if (buffer->freelist)
+    {
+        freelist_resize(buffer->freelist, (u32)new_size);
+    }
+
+    if (old_buffer)
+    {
+        // The freelist stays with the buffer.
+        *old_buffer = *buffer;
+        old_buffer->freelist = 0;
+    }
+    else
+    {
+        vkDestroyBuffer(context->device.handle, buffer->handle, context->allocator);
+        vulkan_memory_free(context, &context->memory, &buffer->allocation);
+    }
 
-    vulkan_buffer_destroy(context, &new_buffer);
+    buffer->handle = new_buffer.handle;
+    buffer->allocation = new_buffer.allocation;
+    buffer->size = new_size;
     return TRUE;
 }
 
 void vulkan_buffer_bind(vulkan_context* context, vulkan_buffer* buffer, u64 offset)
 {
-    VULKAN_CHECK_RESULT(vkBindBufferMemory(context->device.handle, buffer->handle, buffer->device_memory, offset));
+    VULKAN_CHECK_RESULT(vkBindBufferMemory(context->device.handle, buffer->handle, buffer->allocation.memory, buffer->allocation.offset + offset));
 }
 
 void vulkan_buffer_upload_to_host_visible_memory(vulkan_context* context, vulkan_buffer* buffer, u64 offset, u64 size, u32 flags, void const* data)
 {
-    void* mapped;
-    VULKAN_CHECK_RESULT(vkMapMemory(context->device.handle, buffer->device_memory, 0, buffer->size, 0, &mapped));
-    memory_copy(mapped, data, size);
-    vkUnmapMemory(context->device.handle, buffer->device_memory);
+    if (!buffer->allocation.mapped)
+    {
+        LOG_ERROR("vulkan_buffer_upload_to_host_visible_memory: Buffer memory is not host visible");
+        return;
+    }
+
+    // Host visible memory is mapped for as long as it is allocated.
+    memory_system_copy((u8*)buffer->allocation.mapped + offset, data, size);
 }
 
 void vulkan_buffer_copy_to_buffer(
@@ -159,31 +167,46 @@ void vulkan_buffer_upload_to_device_local_memory(
     vulkan_buffer_destroy(context, &staging);
 }
 
-void vulkan_buffer_free_data(vulkan_buffer* buffer, u64 offset, u64 size) {
-    // TODO: Free this in the buffer.
-    // TODO: update free list with this range being free.
+b8 vulkan_buffer_enable_suballocation(vulkan_buffer* buffer)
+{
+    // Freelist offsets are 32 bit.
+    if (!buffer || buffer->freelist || buffer->size > INVALID_ID)
+    {
+        LOG_ERROR("vulkan_buffer_enable_suballocation: Invalid input parameters");
+        return FALSE;
+    }
+
+    buffer->freelist = freelist_create((u32)buffer->size);
+    return TRUE;
 }
 
 b8 vulkan_buffer_suballocate(vulkan_buffer* buffer, u64 size, u64* offset)
 {
-    if (!buffer || (size == 0) || !offset)
+    if (!buffer || !buffer->freelist || (size == 0) || !offset)
     {
         LOG_ERROR("vulkan_buffer_suballocate: Invalid input parameters");
         return FALSE;
     }
 
-    return freelist_allocate(&buffer->suballocation.tracker, size, offset);
+    u32 suballocation_offset;
+    if (!freelist_allocate(buffer->freelist, (u32)size, &suballocation_offset))
+    {
+        return FALSE;
+    }
+
+    *offset = suballocation_offset;
+    return TRUE;
 }
 
 b8 vulkan_buffer_free(vulkan_buffer* buffer, u64 size, u64 offset)
 {
-    if (!buffer || (size == 0))
+    if (!buffer || !buffer->freelist || (size == 0))
     {
         LOG_ERROR("vulkan_buffer_free: Invalid input parameters");
         return FALSE;
     }
 
-    return freelist_free(&buffer->suballocation.tracker, size, offset);
+    return freelist_free(buffer->freelist, (u32)offset, (u32)size);
 }
 
 void* VKAPI_CALL allocation(void* userData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
@@ -200,11 +223,3 @@ void VKAPI_CALL free(void* user_data, void* memory)
 {
     return memory_free(memory, 0, MEMORY_TAG_RENDERER);
 }
-
-void destroy_suballocation_tracker(vulkan_buffer* buffer)
-{
-    freelist_destroy(&buffer->suballocation.tracker);
-    memory_system_free(buffer->suballocation.block, buffer->suballocation.required_memory, MEMORY_TAG_RENDERER);
-    buffer->suballocation.required_memory = 0;
-    buffer->suballocation.block = 0;
-}
@@ -6,7 +6,15 @@
 b8 vulkan_buffer_create(vulkan_context* context, u64 size, VkBufferUsageFlagBits usage, u32 memory_property, b8 bind_on_create, vulkan_buffer* buffer);
 void vulkan_buffer_destroy(vulkan_context* context, vulkan_buffer* buffer);
 
-b8 vulkan_buffer_resize(vulkan_context* context, vulkan_buffer* buffer, u64 new_size, VkCommandPool pool, VkQueue queue);
+/**
+ * @brief Grows the buffer to _new_size_, keeping its contents and suballocations at their offsets. The buffer gets a
+ * new handle; the copy waits for _queue_ to be idle, so submitted work is done with the old one.
+ * @param old_buffer If not 0, receives the old handle and memory, which stay valid for command buffers still being
+ * recorded and are destroyed by the caller with vulkan_buffer_destroy once those have completed. If 0, they are
+ * destroyed right away.
+ * @return TRUE on success, otherwise FALSE, in which case the buffer is left as it was.
+ */
+b8 vulkan_buffer_resize(vulkan_context* context, vulkan_buffer* buffer, u64 new_size, VkCommandPool pool, VkQueue queue, vulkan_buffer* old_buffer);
 void vulkan_buffer_bind(vulkan_context* context, vulkan_buffer* buffer, u64 offset);
 
 void vulkan_buffer_upload_to_host_visible_memory(
@@ -37,7 +45,14 @@ void vulkan_buffer_upload_to_device_local_memory(
     u64 offset,
     u64 size,
     void const* data);
-void vulkan_buffer_free_data(vulkan_buffer* buffer, u64 offset, u64 size);
+
+/**
+ * @brief Starts tracking suballocations of the buffer, all of it free. Buffers whose space is handed out by
+ * vulkan_buffer_suballocate call this once after vulkan_buffer_create.
+ * @param buffer A pointer to the buffer. Its size must fit in 32 bits.
+ * @return TRUE on success, otherwise FALSE.
+ */
+b8 vulkan_buffer_enable_suballocation(vulkan_buffer* buffer);
 
 /**
  * @brief Sub-allocates space from the vulkan buffer.
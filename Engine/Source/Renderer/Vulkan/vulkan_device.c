@@ -90,6 +90,8 @@ b8 vulkan_device_create(vulkan_context* context)
     // TODO: should be configurable
     VkPhysicalDeviceFeatures physicalDeviceFeatures = {};
     physicalDeviceFeatures.samplerAnisotropy = VK_TRUE;
+    // Block compressed textures are used when the device has them.
+    physicalDeviceFeatures.textureCompressionBC = context->device.features.textureCompressionBC;
 
     VkDeviceCreateInfo deviceCreateInfo = {};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -1,12 +1,14 @@
 #include "vulkan_image.h"
 
 #include "vulkan_device.h"
+#include "vulkan_memory.h"
 #include "core/logger.h"
 
-void vulkan_image_create(vulkan_context* context, VkImageType imageType, u32 width, u32 height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memoryProperties, b32 createView, VkImageAspectFlags aspectFlags, vulkan_image* image)
+void vulkan_image_create(vulkan_context* context, VkImageType imageType, u32 width, u32 height, u32 mip_levels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memoryProperties, b32 createView, VkImageAspectFlags aspectFlags, vulkan_image* image)
 {
     image->width = width;
     image->height = height;
+    image->mip_levels = mip_levels;
 
     VkImageCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -17,7 +19,7 @@ void vulkan_image_create(vulkan_context* context, VkImageType imageType, u32 wid
     createInfo.extent.width = width;
     createInfo.extent.height = height;
     createInfo.extent.depth = 1;
-    createInfo.mipLevels = 1;
+    createInfo.mipLevels = mip_levels;
     createInfo.arrayLayers = 1;
     createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
     createInfo.tiling = tiling;
@@ -31,18 +33,12 @@ void vulkan_image_create(vulkan_context* context, VkImageType imageType, u32 wid
     VkMemoryRequirements memoryRequirements;
     vkGetImageMemoryRequirements(context->device.handle, image->handle, &memoryRequirements);
 
-    i32 memoryType = context->find_memory_type_index(memoryRequirements.memoryTypeBits, memoryProperties);
-    if (memoryType == -1) {
+    Device_Memory_Kind kind = tiling == VK_IMAGE_TILING_OPTIMAL ? DEVICE_MEMORY_KIND_OPTIMAL : DEVICE_MEMORY_KIND_LINEAR;
+    if (!vulkan_memory_allocate(context, &context->memory, &memoryRequirements, memoryProperties, kind, &image->allocation)) {
         LOG_ERROR("Required memory type not found. Image not valid");
     }
 
-    VkMemoryAllocateInfo allocateInfo = {};
-    allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocateInfo.pNext = NULL;
-    allocateInfo.allocationSize = memoryRequirements.size;
-    allocateInfo.memoryTypeIndex = memoryType;
-    VULKAN_CHECK_RESULT(vkAllocateMemory(context->device.handle, &allocateInfo, context->allocator, &image->memory));
-    VULKAN_CHECK_RESULT(vkBindImageMemory(context->device.handle, image->handle, image->memory, 0));
+    VULKAN_CHECK_RESULT(vkBindImageMemory(context->device.handle, image->handle, image->allocation.memory, image->allocation.offset));
 
     if (createView) {
         image->view = VK_NULL_HANDLE;
@@ -55,6 +51,11 @@ void vulkan_image_view_create(
     VkFormat format,
     vulkan_image* image,
     VkImageAspectFlags aspectFlags)
+{
+    image->view = vulkan_image_level_view_create(context, format, image, aspectFlags, 0);
+}
+
+VkImageView vulkan_image_level_view_create(vulkan_context* context, VkFormat format, vulkan_image* image, VkImageAspectFlags aspect_flags, u32 base_level)
 {
     VkImageViewCreateInfo createInfo = {};
     createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -67,12 +68,14 @@ void vulkan_image_view_create(
     createInfo.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
     createInfo.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
     createInfo.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-    createInfo.subresourceRange.aspectMask = aspectFlags;
-    createInfo.subresourceRange.baseMipLevel = 0;
-    createInfo.subresourceRange.levelCount = 1;
+    createInfo.subresourceRange.aspectMask = aspect_flags;
+    createInfo.subresourceRange.baseMipLevel = base_level;
+    createInfo.subresourceRange.levelCount = image->mip_levels - base_level;
     createInfo.subresourceRange.baseArrayLayer = 0;
     createInfo.subresourceRange.layerCount = 1;
-    VULKAN_CHECK_RESULT(vkCreateImageView(context->device.handle, &createInfo, context->allocator, &image->view));
+    VkImageView view;
+    VULKAN_CHECK_RESULT(vkCreateImageView(context->device.handle, &createInfo, context->allocator, &view));
+    return view;
 }
 
 void vulkan_image_destroy(vulkan_context* context, vulkan_image* image)
@@ -81,14 +84,11 @@ void vulkan_image_destroy(vulkan_context* context, vulkan_image* image)
         vkDestroyImageView(context->device.handle, image->view, context->allocator);
         image->view = VK_NULL_HANDLE;
     }
-    if (image->memory) {
-        vkFreeMemory(context->device.handle, image->memory, context->allocator);
-        image->memory = VK_NULL_HANDLE;
-    }
     if (image->handle) {
         vkDestroyImage(context->device.handle, image->handle, context->allocator);
         image->handle = VK_NULL_HANDLE;
     }
+    vulkan_memory_free(context, &context->memory, &image->allocation);
 }
 
 void vulkan_image_transition_layout(
@@ -108,6 +108,14 @@ void vulkan_image_transition_layout(
         dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
         src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
         dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    } else if (
+        old_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        && new_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+        // Frames submitted earlier may still sample the image.
+        src_access_mask = VK_ACCESS_SHADER_READ_BIT;
+        dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        src_stage_mask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        dst_stage_mask = VK_PIPELINE_STAGE_TRANSFER_BIT;
     } else if (
         old_layout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
         && new_layout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
@@ -132,27 +140,32 @@ void vulkan_image_transition_layout(
     barrier.image = image->handle;
     barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.levelCount = image->mip_levels;
     barrier.subresourceRange.baseArrayLayer = 0;
     barrier.subresourceRange.layerCount = 1;
     vkCmdPipelineBarrier(command_buffer->handle, src_stage_mask, dst_stage_mask, 0, 0, 0, 0, 0, 1, &barrier);
 }
 
-void vulkan_image_copy_from_buffer(vulkan_context* context, vulkan_command_buffer* command_buffer, vulkan_image* image, VkBuffer buffer)
+void vulkan_image_copy_from_buffer(vulkan_context* context, vulkan_command_buffer* command_buffer, vulkan_image* image, VkBuffer buffer, u64 const* level_offsets)
 {
-    VkBufferImageCopy copy = {};
-    copy.bufferOffset = 0;
-    copy.bufferRowLength = 0;
-    copy.bufferImageHeight = 0;
-    copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    copy.imageSubresource.mipLevel = 0;
-    copy.imageSubresource.baseArrayLayer = 0;
-    copy.imageSubresource.layerCount = 1;
-    copy.imageOffset.x = 0;
-    copy.imageOffset.y = 0;
-    copy.imageOffset.z = 0;
-    copy.imageExtent.width = image->width;
-    copy.imageExtent.height = image->height;
-    copy.imageExtent.depth = 1;
-    vkCmdCopyBufferToImage(command_buffer->handle, buffer, image->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+    // Enough levels for any 32 bit extent.
+    VkBufferImageCopy copies[32] = {};
+    for (u32 i = 0; i < image->mip_levels; ++i) {
+        VkBufferImageCopy* copy = &copies[i];
+        copy->bufferOffset = level_offsets[i];
+        copy->bufferRowLength = 0;
+        copy->bufferImageHeight = 0;
+        copy->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copy->imageSubresource.mipLevel = i;
+        copy->imageSubresource.baseArrayLayer = 0;
+        copy->imageSubresource.layerCount = 1;
+        copy->imageOffset.x = 0;
+        copy->imageOffset.y = 0;
+        copy->imageOffset.z = 0;
+        copy->imageExtent.width = MAX(1, image->width >> i);
+        copy->imageExtent.height = MAX(1, image->height >> i);
+        copy->imageExtent.depth = 1;
+    }
+
+    vkCmdCopyBufferToImage(command_buffer->handle, buffer, image->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, image->mip_levels, copies);
 }
@@ -2,7 +2,7 @@
 
 #include "vulkan_structures.h"
 
-void vulkan_image_create(vulkan_context* context, VkImageType imageType, u32 width, u32 height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memoryProperties, b32 createView, VkImageAspectFlags aspectFlags, vulkan_image* image);
+void vulkan_image_create(vulkan_context* context, VkImageType imageType, u32 width, u32 height, u32 mip_levels, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags memoryProperties, b32 createView, VkImageAspectFlags aspectFlags, vulkan_image* image);
 
 void vulkan_image_view_create(
     vulkan_context* context,
@@ -10,8 +10,17 @@ void vulkan_image_view_create(
     vulkan_image* image,
     VkImageAspectFlags aspectFlags);
 
+/**
+ * @brief Creates a view of the levels of _image_ from _base_level_ down. The caller destroys it.
+ */
+VkImageView vulkan_image_level_view_create(vulkan_context* context, VkFormat format, vulkan_image* image, VkImageAspectFlags aspect_flags, u32 base_level);
+
 void vulkan_image_destroy(vulkan_context* context, vulkan_image* image);
 
 void vulkan_image_transition_layout(vulkan_context* context, vulkan_command_buffer* command_buffer, vulkan_image* image, VkFormat format, VkImageLayout old_layout, VkImageLayout new_layout);
 
-void vulkan_image_copy_from_buffer(vulkan_context* context, vulkan_command_buffer* command_buffer, vulkan_image* image, VkBuffer buffer);
+/**
+ * @brief Copies every mip level of _image_ from _buffer_ with a single command, one region per level.
+ * @param level_offsets Where each of the image's mip_levels levels starts in _buffer_, tightly packed.
+ */
+void vulkan_image_copy_from_buffer(vulkan_context* context, vulkan_command_buffer* command_buffer, vulkan_image* image, VkBuffer buffer, u64 const* level_offsets);
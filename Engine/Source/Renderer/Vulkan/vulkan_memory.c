@@ -0,0 +1,278 @@
+#include "vulkan_memory.h"
+
+#include "core/logger.h"
+#include "systems/memory_system.h"
+#include "vulkan_utils.h"
+
+static b8 allocate_memory(vulkan_context* context, u32 memory_type, u64 size, VkDeviceMemory* memory, void** mapped);
+static void destroy_block(vulkan_context* context, vulkan_memory_allocator* allocator, u32 block_index);
+static void place(vulkan_context* context, vulkan_memory_allocator* allocator, u32 block_index, u64 offset, u64 size, vulkan_allocation* allocation);
+
+void vulkan_memory_create(vulkan_context* context, vulkan_memory_allocator* allocator)
+{
+    memory_system_zero(allocator, sizeof(*allocator));
+
+    VkPhysicalDeviceMemoryProperties const* properties = &context->device.memoryProperties;
+    for (u32 i = 0; i < properties->memoryHeapCount; ++i)
+    {
+        // Small heaps, like the host visible part of device memory on discrete GPUs, aren't taken up by a few blocks.
+        u64 block_size = properties->memoryHeaps[i].size / 8;
+        allocator->block_size[i] = block_size < VULKAN_MEMORY_BLOCK_SIZE ? block_size : VULKAN_MEMORY_BLOCK_SIZE;
+    }
+}
+
+void vulkan_memory_destroy(vulkan_context* context, vulkan_memory_allocator* allocator)
+{
+    for (u32 i = 0; i < VULKAN_MAX_MEMORY_BLOCKS; ++i)
+    {
+        if (allocator->blocks[i].ranges)
+        {
+            destroy_block(context, allocator, i);
+        }
+    }
+
+    VkPhysicalDeviceMemoryProperties const* properties = &context->device.memoryProperties;
+    for (u32 i = 0; i < properties->memoryHeapCount; ++i)
+    {
+        vulkan_memory_heap_stats const* stats = &allocator->heap_stats[i];
+        if (stats->allocation_count > 0 || stats->dedicated_count > 0)
+        {
+            LOG_WARNING(
+                "vulkan_memory_destroy: Heap %u still holds %u allocations and %u dedicated ones",
+                i,
+                stats->allocation_count,
+                stats->dedicated_count);
+        }
+
+        LOG_INFO("Vulkan memory heap %u: %u blocks of %llu bytes at peak", i, stats->peak_block_count, allocator->block_size[i]);
+    }
+
+    memory_system_zero(allocator, sizeof(*allocator));
+}
+
+i32 vulkan_memory_find_type(vulkan_context* context, vulkan_memory_allocator* allocator, u32 type_bits, VkMemoryPropertyFlags properties)
+{
+    for (u32 i = 0; i < allocator->lookup_count; ++i)
+    {
+        vulkan_memory_type_lookup const* lookup = &allocator->lookups[i];
+        if (lookup->type_bits == type_bits && lookup->properties == properties)
+        {
+            return lookup->index;
+        }
+    }
+
+    i32 index = -1;
+    VkPhysicalDeviceMemoryProperties const* memory_properties = &context->device.memoryProperties;
+    for (u32 i = 0; i < memory_properties->memoryTypeCount; ++i)
+    {
+        if ((type_bits & (1 << i)) && (memory_properties->memoryTypes[i].propertyFlags & properties) == properties)
+        {
+            index = i;
+            break;
+        }
+    }
+
+    // Once full, the oldest lookup makes room.
+    vulkan_memory_type_lookup* lookup = &allocator->lookups[allocator->next_lookup];
+    lookup->type_bits = type_bits;
+    lookup->properties = properties;
+    lookup->index = index;
+    allocator->next_lookup = (allocator->next_lookup + 1) % VULKAN_MEMORY_TYPE_CACHE_SIZE;
+    if (allocator->lookup_count < VULKAN_MEMORY_TYPE_CACHE_SIZE)
+    {
+        allocator->lookup_count++;
+    }
+
+    return index;
+}
+
+b8 vulkan_memory_allocate(
+    vulkan_context* context,
+    vulkan_memory_allocator* allocator,
+    VkMemoryRequirements const* requirements,
+    VkMemoryPropertyFlags properties,
+    Device_Memory_Kind kind,
+    vulkan_allocation* allocation)
+{
+    memory_system_zero(allocation, sizeof(*allocation));
+
+    i32 memory_type = vulkan_memory_find_type(context, allocator, requirements->memoryTypeBits, properties);
+    if (memory_type == -1)
+    {
+        LOG_ERROR("vulkan_memory_allocate: Failed to find memory type index");
+        return FALSE;
+    }
+
+    u32 heap_index = context->device.memoryProperties.memoryTypes[memory_type].heapIndex;
+    vulkan_memory_heap_stats* stats = &allocator->heap_stats[heap_index];
+    u64 block_size = allocator->block_size[heap_index];
+    if (requirements->size > block_size / 2)
+    {
+        if (!allocate_memory(context, memory_type, requirements->size, &allocation->memory, &allocation->mapped))
+        {
+            return FALSE;
+        }
+
+        allocation->offset = 0;
+        allocation->size = requirements->size;
+        allocation->memory_type = memory_type;
+        allocation->block_index = INVALID_ID;
+        stats->dedicated_count++;
+        stats->dedicated_size += requirements->size;
+        return TRUE;
+    }
+
+    u32 free_slot = INVALID_ID;
+    for (u32 i = 0; i < VULKAN_MAX_MEMORY_BLOCKS; ++i)
+    {
+        vulkan_memory_block* block = &allocator->blocks[i];
+        if (!block->ranges)
+        {
+            free_slot = free_slot == INVALID_ID ? i : free_slot;
+            continue;
+        }
+
+        u64 offset;
+        if (block->memory_type == (u32)memory_type &&
+            device_memory_block_allocate(block->ranges, requirements->size, requirements->alignment, kind, &offset))
+        {
+            place(context, allocator, i, offset, requirements->size, allocation);
+            return TRUE;
+        }
+    }
+
+    if (free_slot == INVALID_ID)
+    {
+        LOG_ERROR("vulkan_memory_allocate: All %u blocks are in use", VULKAN_MAX_MEMORY_BLOCKS);
+        return FALSE;
+    }
+
+    vulkan_memory_block* block = &allocator->blocks[free_slot];
+    if (!allocate_memory(context, memory_type, block_size, &block->memory, &block->mapped))
+    {
+        return FALSE;
+    }
+
+    block->memory_type = memory_type;
+    block->ranges = memory_system_allocate(sizeof(Device_Memory_Block), MEMORY_TAG_RENDERER);
+    device_memory_block_create(block_size, context->device.properties.limits.bufferImageGranularity, block->ranges);
+    stats->block_count++;
+    stats->block_size += block_size;
+    if (stats->block_count > stats->peak_block_count)
+    {
+        stats->peak_block_count = stats->block_count;
+    }
+
+    // At most half a block is asked for, so an empty block always has room.
+    u64 offset;
+    device_memory_block_allocate(block->ranges, requirements->size, requirements->alignment, kind, &offset);
+    place(context, allocator, free_slot, offset, requirements->size, allocation);
+    return TRUE;
+}
+
+void vulkan_memory_free(vulkan_context* context, vulkan_memory_allocator* allocator, vulkan_allocation* allocation)
+{
+    if (!allocation->memory)
+    {
+        return;
+    }
+
+    u32 heap_index = context->device.memoryProperties.memoryTypes[allocation->memory_type].heapIndex;
+    vulkan_memory_heap_stats* stats = &allocator->heap_stats[heap_index];
+    if (allocation->block_index == INVALID_ID)
+    {
+        vkFreeMemory(context->device.handle, allocation->memory, context->allocator);
+        stats->dedicated_count--;
+        stats->dedicated_size -= allocation->size;
+        memory_system_zero(allocation, sizeof(*allocation));
+        return;
+    }
+
+    vulkan_memory_block* block = &allocator->blocks[allocation->block_index];
+    if (device_memory_block_free(block->ranges, allocation->offset))
+    {
+        stats->used_size -= allocation->size;
+        stats->allocation_count--;
+    }
+
+    // One empty block per memory type is kept, so that resources created and destroyed in turn don't allocate a block
+    // each time.
+    if (block->ranges->allocation_count == 0)
+    {
+        for (u32 i = 0; i < VULKAN_MAX_MEMORY_BLOCKS; ++i)
+        {
+            vulkan_memory_block const* other = &allocator->blocks[i];
+            if (i != allocation->block_index && other->ranges && other->memory_type == block->memory_type &&
+                other->ranges->allocation_count == 0)
+            {
+                destroy_block(context, allocator, allocation->block_index);
+                break;
+            }
+        }
+    }
+
+    memory_system_zero(allocation, sizeof(*allocation));
+}
+
+vulkan_memory_heap_stats const* vulkan_memory_get_heap_stats(vulkan_context* context, vulkan_memory_allocator const* allocator, u32 heap_index)
+{
+    if (heap_index >= context->device.memoryProperties.memoryHeapCount)
+    {
+        return 0;
+    }
+
+    return &allocator->heap_stats[heap_index];
+}
+
+b8 allocate_memory(vulkan_context* context, u32 memory_type, u64 size, VkDeviceMemory* memory, void** mapped)
+{
+    VkMemoryAllocateInfo allocate_info = {};
+    allocate_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocate_info.pNext = 0;
+    allocate_info.allocationSize = size;
+    allocate_info.memoryTypeIndex = memory_type;
+    VkResult result = vkAllocateMemory(context->device.handle, &allocate_info, context->allocator, memory);
+    if (result != VK_SUCCESS)
+    {
+        LOG_ERROR("vulkan_memory_allocate: Failed to allocate %llu bytes of memory type %u: '%s'", size, memory_type, vulkan_result_string(result, TRUE));
+        *memory = VK_NULL_HANDLE;
+        return FALSE;
+    }
+
+    // Host visible memory stays mapped until it is freed, which unmaps it.
+    *mapped = 0;
+    if (context->device.memoryProperties.memoryTypes[memory_type].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+    {
+        VULKAN_CHECK_RESULT(vkMapMemory(context->device.handle, *memory, 0, VK_WHOLE_SIZE, 0, mapped));
+    }
+
+    return TRUE;
+}
+
+void destroy_block(vulkan_context* context, vulkan_memory_allocator* allocator, u32 block_index)
+{
+    vulkan_memory_block* block = &allocator->blocks[block_index];
+    u32 heap_index = context->device.memoryProperties.memoryTypes[block->memory_type].heapIndex;
+    vulkan_memory_heap_stats* stats = &allocator->heap_stats[heap_index];
+    stats->block_count--;
+    stats->block_size -= block->ranges->size;
+
+    vkFreeMemory(context->device.handle, block->memory, context->allocator);
+    memory_system_free(block->ranges, sizeof(Device_Memory_Block), MEMORY_TAG_RENDERER);
+    memory_system_zero(block, sizeof(*block));
+}
+
+void place(vulkan_context* context, vulkan_memory_allocator* allocator, u32 block_index, u64 offset, u64 size, vulkan_allocation* allocation)
+{
+    vulkan_memory_block const* block = &allocator->blocks[block_index];
+    allocation->memory = block->memory;
+    allocation->offset = offset;
+    allocation->size = size;
+    allocation->mapped = block->mapped ? (u8*)block->mapped + offset : 0;
+    allocation->memory_type = block->memory_type;
+    allocation->block_index = block_index;
+
+    u32 heap_index = context->device.memoryProperties.memoryTypes[block->memory_type].heapIndex;
+    allocator->heap_stats[heap_index].used_size += size;
+    allocator->heap_stats[heap_index].allocation_count++;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "vulkan_structures.h"
+
+/**
+ * @brief Sizes the blocks of every heap. Call once the device is created, before any buffer or image.
+ */
+void vulkan_memory_create(vulkan_context* context, vulkan_memory_allocator* allocator);
+
+/**
+ * @brief Frees every block and logs the usage of each heap. Resources should have been freed by now, so any that are
+ * left are logged.
+ */
+void vulkan_memory_destroy(vulkan_context* context, vulkan_memory_allocator* allocator);
+
+/**
+ * @brief Finds the first memory type in _type_bits_ that has all of _properties_. Lookups are remembered, so the
+ * types are only searched for the first lookup of each pair.
+ * @return The index of the memory type, or -1 if there is none.
+ */
+i32 vulkan_memory_find_type(vulkan_context* context, vulkan_memory_allocator* allocator, u32 type_bits, VkMemoryPropertyFlags properties);
+
+/**
+ * @brief Places a resource with _requirements_ in a block of a memory type with _properties_, creating the block if
+ * none has room. Resources larger than half a block get memory of their own instead.
+ * @param kind DEVICE_MEMORY_KIND_OPTIMAL for images with optimal tiling, which may not share a page with the others.
+ * @return TRUE on success, otherwise FALSE.
+ */
+b8 vulkan_memory_allocate(
+    vulkan_context* context,
+    vulkan_memory_allocator* allocator,
+    VkMemoryRequirements const* requirements,
+    VkMemoryPropertyFlags properties,
+    Device_Memory_Kind kind,
+    vulkan_allocation* allocation);
+
+/**
+ * @brief Frees an allocation made by vulkan_memory_allocate. The resource bound to it must be destroyed, or about to be.
+ */
+void vulkan_memory_free(vulkan_context* context, vulkan_memory_allocator* allocator, vulkan_allocation* allocation);
+
+/**
+ * @return The usage of heap _heap_index_, or 0 if the device has no such heap.
+ */
+vulkan_memory_heap_stats const* vulkan_memory_get_heap_stats(vulkan_context* context, vulkan_memory_allocator const* allocator, u32 heap_index);
@@ -0,0 +1,124 @@
+#include "vulkan_sampler.h"
+
+#include "core/hash.h"
+#include "core/logger.h"
+#include "systems/memory_system.h"
+
+#include <string.h>
+
+void vulkan_sampler_cache_create(vulkan_sampler_cache* cache)
+{
+    memory_system_zero(cache, sizeof(*cache));
+}
+
+void vulkan_sampler_cache_destroy(vulkan_context* context, vulkan_sampler_cache* cache)
+{
+    if (cache->sampler_count > 0)
+    {
+        LOG_WARNING("vulkan_sampler_cache_destroy: %u samplers are still referenced", cache->sampler_count);
+    }
+
+    for (u32 i = 0; i < VULKAN_MAX_SAMPLER_COUNT; ++i)
+    {
+        vulkan_sampler_entry* entry = &cache->entries[i];
+        if (entry->reference_count > 0)
+        {
+            vkDestroySampler(context->device.handle, entry->handle, context->allocator);
+        }
+    }
+
+    LOG_INFO("Vulkan samplers: %u at peak", cache->peak_sampler_count);
+    memory_system_zero(cache, sizeof(*cache));
+}
+
+void vulkan_sampler_state_default(vulkan_sampler_state* state)
+{
+    // Zeroed first, so that the padding and any field added later hash the same for equal states.
+    memory_system_zero(state, sizeof(*state));
+    state->mag_filter = VK_FILTER_LINEAR;
+    state->min_filter = VK_FILTER_LINEAR;
+    state->mipmap_mode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    state->address_mode_u = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    state->address_mode_v = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    state->address_mode_w = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    state->max_anisotropy = 1.f;
+    state->mip_lod_bias = 0.f;
+    state->min_lod = 0.f;
+    // Sampling stops at the last level of the image view, so one sampler serves textures of any mip count.
+    state->max_lod = VK_LOD_CLAMP_NONE;
+}
+
+VkSampler vulkan_sampler_acquire(vulkan_context* context, vulkan_sampler_cache* cache, vulkan_sampler_state const* state)
+{
+    u64 hash = hash_bytes(state, sizeof(*state), 0);
+    vulkan_sampler_entry* free_entry = 0;
+    for (u32 i = 0; i < VULKAN_MAX_SAMPLER_COUNT; ++i)
+    {
+        vulkan_sampler_entry* entry = &cache->entries[i];
+        if (entry->reference_count == 0)
+        {
+            free_entry = free_entry ? free_entry : entry;
+        }
+        else if (entry->hash == hash && memcmp(&entry->state, state, sizeof(*state)) == 0)
+        {
+            entry->reference_count++;
+            return entry->handle;
+        }
+    }
+
+    if (!free_entry)
+    {
+        LOG_ERROR("vulkan_sampler_acquire: All %u samplers are in use", VULKAN_MAX_SAMPLER_COUNT);
+        return VK_NULL_HANDLE;
+    }
+
+    VkSamplerCreateInfo sampler_create_info = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sampler_create_info.magFilter = state->mag_filter;
+    sampler_create_info.minFilter = state->min_filter;
+    sampler_create_info.mipmapMode = state->mipmap_mode;
+    sampler_create_info.addressModeU = state->address_mode_u;
+    sampler_create_info.addressModeV = state->address_mode_v;
+    sampler_create_info.addressModeW = state->address_mode_w;
+    sampler_create_info.mipLodBias = state->mip_lod_bias;
+    sampler_create_info.anisotropyEnable = state->max_anisotropy > 1.f ? VK_TRUE : VK_FALSE;
+    sampler_create_info.maxAnisotropy = state->max_anisotropy;
+    sampler_create_info.compareEnable = VK_FALSE;
+    sampler_create_info.compareOp = VK_COMPARE_OP_NEVER;
+    sampler_create_info.minLod = state->min_lod;
+    sampler_create_info.maxLod = state->max_lod;
+    sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+    sampler_create_info.unnormalizedCoordinates = VK_FALSE;
+    VULKAN_CHECK_RESULT(vkCreateSampler(context->device.handle, &sampler_create_info, context->allocator, &free_entry->handle));
+
+    free_entry->hash = hash;
+    free_entry->state = *state;
+    free_entry->reference_count = 1;
+    cache->sampler_count++;
+    cache->peak_sampler_count = cache->sampler_count > cache->peak_sampler_count ? cache->sampler_count : cache->peak_sampler_count;
+    return free_entry->handle;
+}
+
+void vulkan_sampler_release(vulkan_context* context, vulkan_sampler_cache* cache, VkSampler sampler)
+{
+    if (sampler == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    for (u32 i = 0; i < VULKAN_MAX_SAMPLER_COUNT; ++i)
+    {
+        vulkan_sampler_entry* entry = &cache->entries[i];
+        if (entry->reference_count > 0 && entry->handle == sampler)
+        {
+            if (--entry->reference_count == 0)
+            {
+                vkDestroySampler(context->device.handle, entry->handle, context->allocator);
+                entry->handle = VK_NULL_HANDLE;
+                cache->sampler_count--;
+            }
+            return;
+        }
+    }
+
+    LOG_WARNING("vulkan_sampler_release: The sampler wasn't acquired from the cache");
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "vulkan_structures.h"
+
+void vulkan_sampler_cache_create(vulkan_sampler_cache* cache);
+
+/**
+ * @brief Destroys every sampler left. Textures should have released theirs by now, so any that are left are logged.
+ */
+void vulkan_sampler_cache_destroy(vulkan_context* context, vulkan_sampler_cache* cache);
+
+/**
+ * @brief The state textures are sampled with by default: trilinear, repeating, over every level of the image view.
+ */
+void vulkan_sampler_state_default(vulkan_sampler_state* state);
+
+/**
+ * @brief Takes a reference to the sampler with _state_, creating it if no texture uses one yet.
+ * @return The sampler, or VK_NULL_HANDLE if VULKAN_MAX_SAMPLER_COUNT different ones are in use.
+ */
+VkSampler vulkan_sampler_acquire(vulkan_context* context, vulkan_sampler_cache* cache, vulkan_sampler_state const* state);
+
+/**
+ * @brief Releases a reference taken by vulkan_sampler_acquire. The sampler is destroyed with its last reference.
+ */
+void vulkan_sampler_release(vulkan_context* context, vulkan_sampler_cache* cache, VkSampler sampler);
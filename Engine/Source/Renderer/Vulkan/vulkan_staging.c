@@ -0,0 +1,160 @@
+#include "vulkan_staging.h"
+
+#include "core/logger.h"
+#include "systems/memory_system.h"
+#include "vulkan_buffer.h"
+#include "vulkan_command_buffer.h"
+
+static b8 release(vulkan_context* context, vulkan_staging* staging, Staging_Region* region, u32* slot);
+static void retire_completed(vulkan_context* context, vulkan_staging* staging, b8 wait_for_oldest);
+
+b8 vulkan_staging_create(vulkan_context* context, u64 size, vulkan_staging* staging)
+{
+    memory_zero(staging, sizeof(*staging));
+
+    // Copies into images need offsets aligned to the texel size, and run fastest at the device's preferred alignment.
+    u64 alignment = context->device.properties.limits.optimalBufferCopyOffsetAlignment;
+    if (alignment < 16)
+    {
+        alignment = 16;
+    }
+
+    if (!staging_ring_create(size, alignment, &staging->ring))
+    {
+        return FALSE;
+    }
+
+    VkMemoryPropertyFlagBits memory_properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+    if (!vulkan_buffer_create(context, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, memory_properties, TRUE, &staging->buffer))
+    {
+        LOG_ERROR("vulkan_staging_create: Failed to create the staging buffer");
+        return FALSE;
+    }
+
+    VkFenceCreateInfo fence_create_info = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    for (u32 i = 0; i < STAGING_RING_MAX_RELEASES; ++i)
+    {
+        VULKAN_CHECK_RESULT(vkCreateFence(context->device.handle, &fence_create_info, context->allocator, &staging->fences[i]));
+    }
+
+    return TRUE;
+}
+
+void vulkan_staging_destroy(vulkan_context* context, vulkan_staging* staging)
+{
+    while (staging_ring_oldest_release(&staging->ring) != INVALID_ID)
+    {
+        retire_completed(context, staging, TRUE);
+    }
+
+    for (u32 i = 0; i < STAGING_RING_MAX_RELEASES; ++i)
+    {
+        vkDestroyFence(context->device.handle, staging->fences[i], context->allocator);
+        staging->fences[i] = VK_NULL_HANDLE;
+    }
+
+    vulkan_buffer_destroy(context, &staging->buffer);
+}
+
+b8 vulkan_staging_acquire(vulkan_context* context, vulkan_staging* staging, u64 size, Staging_Region* region)
+{
+    if (size == 0 || size > staging->ring.capacity)
+    {
+        return FALSE;
+    }
+
+    retire_completed(context, staging, FALSE);
+    while (!staging_ring_allocate(&staging->ring, size, staging->buffer.allocation.mapped, region))
+    {
+        if (staging_ring_oldest_release(&staging->ring) == INVALID_ID)
+        {
+            // The space is held by regions that were acquired but not yet submitted.
+            LOG_ERROR("vulkan_staging_acquire: Staging ring exhausted by unsubmitted regions");
+            return FALSE;
+        }
+
+        retire_completed(context, staging, TRUE);
+    }
+
+    return TRUE;
+}
+
+void vulkan_staging_cancel(vulkan_context* context, vulkan_staging* staging, Staging_Region* region)
+{
+    u32 slot;
+    if (release(context, staging, region, &slot))
+    {
+        // Nothing was submitted, so the space can be reused as soon as everything before it is.
+        retire_completed(context, staging, FALSE);
+    }
+}
+
+b8 vulkan_staging_submit(vulkan_context* context, vulkan_staging* staging, Staging_Region* region, vulkan_command_buffer* command_buffer)
+{
+    u32 slot;
+    if (!release(context, staging, region, &slot))
+    {
+        // The commands read a region that is no longer tracked, so they are dropped rather than submitted.
+        vulkan_command_buffer_end(command_buffer);
+        vulkanCommandBufferFree(context, context->device.graphics_command_pool, command_buffer);
+        return FALSE;
+    }
+
+    vulkan_command_buffer_end(command_buffer);
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &command_buffer->handle;
+    VULKAN_CHECK_RESULT(vkQueueSubmit(context->device.queues.graphics.handle, 1, &submit_info, staging->fences[slot]));
+    vulkanCommandBufferUpdateSubmitted(command_buffer);
+    staging->command_buffers[slot] = *command_buffer;
+    return TRUE;
+}
+
+b8 release(vulkan_context* context, vulkan_staging* staging, Staging_Region* region, u32* slot)
+{
+    *slot = staging_ring_release(&staging->ring, region);
+    while (*slot == INVALID_ID && staging_ring_oldest_release(&staging->ring) != INVALID_ID
+        && region->sequence == staging->ring.released_count)
+    {
+        // Every release slot is in use, so the oldest upload is waited for.
+        retire_completed(context, staging, TRUE);
+        *slot = staging_ring_release(&staging->ring, region);
+    }
+
+    if (*slot == INVALID_ID)
+    {
+        LOG_ERROR("vulkan_staging: Failed to release a staging region");
+        return FALSE;
+    }
+
+    staging->command_buffers[*slot].handle = VK_NULL_HANDLE;
+    return TRUE;
+}
+
+void retire_completed(vulkan_context* context, vulkan_staging* staging, b8 wait_for_oldest)
+{
+    u32 slot;
+    while ((slot = staging_ring_oldest_release(&staging->ring)) != INVALID_ID)
+    {
+        vulkan_command_buffer* command_buffer = &staging->command_buffers[slot];
+        if (command_buffer->handle)
+        {
+            if (wait_for_oldest)
+            {
+                vkWaitForFences(context->device.handle, 1, &staging->fences[slot], VK_TRUE, UINT64_MAX);
+                wait_for_oldest = FALSE;
+            }
+            else if (vkGetFenceStatus(context->device.handle, staging->fences[slot]) != VK_SUCCESS)
+            {
+                return;
+            }
+
+            vkResetFences(context->device.handle, 1, &staging->fences[slot]);
+            vulkanCommandBufferFree(context, context->device.graphics_command_pool, command_buffer);
+        }
+
+        staging_ring_retire_oldest(&staging->ring);
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "vulkan_structures.h"
+
+/**
+ * @brief Creates the staging ring, a host visible and coherent buffer that stays mapped until it is destroyed.
+ */
+b8 vulkan_staging_create(vulkan_context* context, u64 size, vulkan_staging* staging);
+void vulkan_staging_destroy(vulkan_context* context, vulkan_staging* staging);
+
+/**
+ * @brief Takes a region of the ring, first reusing the space of completed uploads and then waiting for the oldest
+ * ones until enough is free.
+ * @return FALSE if _size_ is larger than the ring.
+ */
+b8 vulkan_staging_acquire(vulkan_context* context, vulkan_staging* staging, u64 size, Staging_Region* region);
+
+/**
+ * @brief Hands back a region that no upload reads.
+ */
+void vulkan_staging_cancel(vulkan_context* context, vulkan_staging* staging, Staging_Region* region);
+
+/**
+ * @brief Submits _command_buffer_, which reads _region_, without waiting for it. The region is reused once the
+ * submission has completed, and the command buffer freed then. If the region can't be released, the command buffer is
+ * freed without being submitted and FALSE is returned.
+ * @param command_buffer A single use command buffer allocated from the graphics command pool and still recording.
+ */
+b8 vulkan_staging_submit(vulkan_context* context, vulkan_staging* staging, Staging_Region* region, vulkan_command_buffer* command_buffer);
@@ -5,6 +5,7 @@
 #include "containers/freelist.h"
 #include "core/asserts.h"
 #include "renderer/renderer_types.h"
+#include "renderer/device_memory_block.h"
 
 #include <vulkan/vulkan.h>
 
@@ -54,12 +55,28 @@ typedef struct vulkan_device {
     VkFormat depthFormat;
 } vulkan_device;
 
+/**
+ * @brief Memory a buffer or image is bound to: a range of a block shared with other resources, or memory of its own.
+ */
+typedef struct vulkan_allocation
+{
+    VkDeviceMemory memory;
+    u64 offset;
+    u64 size;
+    /** @brief Where the range starts in host memory if its memory type is host visible, otherwise 0. */
+    void* mapped;
+    u32 memory_type;
+    /** @brief The block the range was placed in, or INVALID_ID for a dedicated allocation. */
+    u32 block_index;
+} vulkan_allocation;
+
 typedef struct vulkan_image {
     VkImage handle;
-    VkDeviceMemory memory;
+    vulkan_allocation allocation;
     VkImageView view;
     u32 width;
     u32 height;
+    u32 mip_levels;
 } vulkan_image;
 
 
@@ -129,14 +146,14 @@ typedef struct vulkan_ui_shader_global_ubo {
 } vulkan_ui_shader_global_ubo;
 
 /**
- * @brief Vulkan-specific ui material instance uniform buffer object for the ui shader. 
+ * @brief Push constants of the ui shader. Everything but the texture of a ui material is pushed per draw, so
+ * materials sharing a texture, such as entries of one atlas, share its descriptor set binding too.
  */
-typedef struct vulkan_ui_shader_instance_ubo {
+typedef struct vulkan_ui_shader_push_constants {
+    mat4 model;          // 64 bytes
     vec4 diffuse_color;  // 16 bytes
-    vec4 v_reserved0;    // 16 bytes, reserved for future use
-    vec4 v_reserved1;    // 16 bytes, reserved for future use
-    vec4 v_reserved2;    // 16 bytes, reserved for future use
-} vulkan_ui_shader_instance_ubo;
+    vec4 uv_rect;        // 16 bytes, the part of the diffuse map that is drawn as u0, v0, u1, v1
+} vulkan_ui_shader_push_constants;
 
 
 
@@ -147,20 +164,15 @@ typedef struct vulkan_ui_shader_instance_ubo {
 typedef struct vulkan_buffer
 {
     VkBuffer handle;
-    VkDeviceMemory device_memory;
+    vulkan_allocation allocation;
     VkDeviceSize size;
     VkBufferUsageFlags usage;
     VkMemoryPropertyFlags memory_property;
-    i32 memory_index;
     u32 alignment;
     b8 locked;
 
-    struct
-    {
-        freelist tracker;
-        u64 required_memory;
-        void* block;
-    } suballocation;
+    /** @brief Space handed out by vulkan_buffer_suballocate. 0 unless vulkan_buffer_enable_suballocation was called. */
+    Freelist* freelist;
     VkAllocationCallbacks allocator;
 } vulkan_buffer;
 
@@ -170,6 +182,20 @@ typedef struct vulkan_buffer
 
 #define VULKAN_MAX_MATERIAL_COUNT 1024
 #define VULKAN_MAX_GEOMETRY_COUNT 4096
+/** @brief Most geometry ranges moved by one compaction pass, which is one copy command. */
+#define VULKAN_GEOMETRY_DEFRAG_MAX_MOVES 64
+/** @brief Bytes a compaction pass moves at the start of a frame, before it stops. */
+#define VULKAN_GEOMETRY_DEFRAG_BYTES_PER_PASS MEBIBYTES(4)
+/** @brief Geometry buffers replaced by resizes that one frame slot can hold until its fence is waited for. */
+#define VULKAN_MAX_RETIRED_BUFFERS 8
+
+/** @brief A geometry buffer range that frames still in flight may read, freed once they have completed. */
+typedef struct vulkan_retired_range
+{
+    vulkan_buffer* buffer;
+    u64 size;
+    u64 offset;
+} vulkan_retired_range;
 
 
 
@@ -261,7 +287,7 @@ typedef struct vulkan_material_shader
 
 #define UI_SHADER_STAGE_COUNT 2
 #define VULKAN_UI_SHADER_SAMPLER_COUNT 1
-#define VULKAN_UI_SHADER_DESCRIPTOR_COUNT 2
+#define VULKAN_UI_SHADER_DESCRIPTOR_COUNT 1
 #define VULKAN_MAX_UI_COUNT 1024
 
 typedef struct vulkan_ui_shader_instance_state {
@@ -291,13 +317,16 @@ typedef struct vulkan_ui_shader
 
     VkDescriptorPool object_descriptor_pool;
     VkDescriptorSetLayout object_descriptor_set_layout;
-    // Object uniform buffers.
-    vulkan_buffer object_uniform_buffer;
     // TODO: manage a free list of some kind here instead.
     u32 object_uniform_buffer_index;
 
     Texture_Use sampler_uses[VULKAN_UI_SHADER_SAMPLER_COUNT];
 
+    // The texture bound for the draws of the current frame so far, and its generation. Materials drawing from the
+    // same texture skip the descriptor set bind.
+    struct Texture const* bound_texture;
+    u32 bound_texture_generation;
+
     // TODO: make dynamic
     vulkan_ui_shader_instance_state instance_states[VULKAN_MAX_UI_COUNT];
 
@@ -321,6 +350,117 @@ typedef struct vulkan_command_buffer
     VulkanCommandBufferState state;
 } vulkan_command_buffer;
 
+#define VULKAN_STAGING_RING_SIZE MEBIBYTES(64)
+
+/**
+ * @brief The staging ring textures are uploaded through. Mapped for as long as the renderer runs.
+ */
+typedef struct vulkan_staging
+{
+    vulkan_buffer buffer;
+    Staging_Ring ring;
+    /** @brief Signalled once the upload of the release in the same slot has completed. */
+    VkFence fences[STAGING_RING_MAX_RELEASES];
+    /** @brief The upload of each release slot. Not allocated for cancelled regions, which have nothing to wait for. */
+    vulkan_command_buffer command_buffers[STAGING_RING_MAX_RELEASES];
+} vulkan_staging;
+
+/** @brief Maximum number of distinct samplers. Drivers allow a few thousand at most, however many textures there are. */
+#define VULKAN_MAX_SAMPLER_COUNT 256
+
+/**
+ * @brief What a sampler samples with. Textures asking for equal states share one sampler.
+ */
+typedef struct vulkan_sampler_state
+{
+    VkFilter mag_filter;
+    VkFilter min_filter;
+    VkSamplerMipmapMode mipmap_mode;
+    VkSamplerAddressMode address_mode_u;
+    VkSamplerAddressMode address_mode_v;
+    VkSamplerAddressMode address_mode_w;
+    /** @brief Anisotropic filtering is off at 1 and below. */
+    f32 max_anisotropy;
+    f32 mip_lod_bias;
+    f32 min_lod;
+    f32 max_lod;
+} vulkan_sampler_state;
+
+typedef struct vulkan_sampler_entry
+{
+    /** @brief Hash of _state_, which lookups compare before the state itself. */
+    u64 hash;
+    vulkan_sampler_state state;
+    VkSampler handle;
+    /** @brief Textures using the sampler. The entry is free at 0. */
+    u32 reference_count;
+} vulkan_sampler_entry;
+
+/**
+ * @brief The samplers in use, each created once for every texture that samples with its state.
+ */
+typedef struct vulkan_sampler_cache
+{
+    u32 sampler_count;
+    u32 peak_sampler_count;
+    vulkan_sampler_entry entries[VULKAN_MAX_SAMPLER_COUNT];
+} vulkan_sampler_cache;
+
+/** @brief Maximum number of blocks over all memory types. */
+#define VULKAN_MAX_MEMORY_BLOCKS 64
+/** @brief Size of the blocks resources are placed in. Heaps smaller than eight blocks get smaller ones. */
+#define VULKAN_MEMORY_BLOCK_SIZE MEBIBYTES(64)
+/** @brief Number of memory type lookups remembered. */
+#define VULKAN_MEMORY_TYPE_CACHE_SIZE 16
+
+typedef struct vulkan_memory_block
+{
+    VkDeviceMemory memory;
+    /** @brief The whole block in host memory if its memory type is host visible, otherwise 0. */
+    void* mapped;
+    u32 memory_type;
+    /** @brief The allocations in the block. 0 for a free slot. */
+    Device_Memory_Block* ranges;
+} vulkan_memory_block;
+
+/**
+ * @brief Usage of one memory heap, over all of its memory types.
+ */
+typedef struct vulkan_memory_heap_stats
+{
+    u32 block_count;
+    /** @brief Bytes allocated from the heap for blocks. */
+    u64 block_size;
+    /** @brief Bytes of the blocks taken by resources. */
+    u64 used_size;
+    u32 dedicated_count;
+    u64 dedicated_size;
+    /** @brief Resources placed in blocks. */
+    u32 allocation_count;
+    u32 peak_block_count;
+} vulkan_memory_heap_stats;
+
+typedef struct vulkan_memory_type_lookup
+{
+    u32 type_bits;
+    VkMemoryPropertyFlags properties;
+    i32 index;
+} vulkan_memory_type_lookup;
+
+/**
+ * @brief Device memory of all buffers and images. Resources are placed in large blocks, one memory type per block,
+ * so that few vkAllocateMemory calls are made however many resources there are.
+ */
+typedef struct vulkan_memory_allocator
+{
+    u64 block_size[VK_MAX_MEMORY_HEAPS];
+    vulkan_memory_block blocks[VULKAN_MAX_MEMORY_BLOCKS];
+    vulkan_memory_heap_stats heap_stats[VK_MAX_MEMORY_HEAPS];
+    u32 lookup_count;
+    u32 next_lookup;
+    vulkan_memory_type_lookup lookups[VULKAN_MEMORY_TYPE_CACHE_SIZE];
+} vulkan_memory_allocator;
+
 
 
 
@@ -335,6 +475,8 @@ typedef struct vulkan_texture_resource
 {
     vulkan_image image;
     VkSampler sampler;
+    /** @brief Layout of every level between uploads. Undefined until the texture is first written. */
+    VkImageLayout layout;
 } vulkan_texture_resource;
 
 
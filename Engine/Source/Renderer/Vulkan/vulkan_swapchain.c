@@ -124,6 +124,11 @@ b8 create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swap
         && (image_count > context->device.swapchain_support.capabilities.maxImageCount)) {
         image_count = context->device.swapchain_support.capabilities.maxImageCount;
     }
+
+    // Per frame state is sized for VULKAN_MAX_FRAME_COUNT slots, one per image.
+    if (image_count > VULKAN_MAX_FRAME_COUNT) {
+        image_count = MAX(VULKAN_MAX_FRAME_COUNT, context->device.swapchain_support.capabilities.minImageCount);
+    }
     swapchain->frames_in_flight = image_count - 1;
 
     VkSwapchainCreateInfoKHR createInfo = {};
@@ -160,6 +165,10 @@ b8 create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swap
 
     u32 swapchainImageCount = 0;
     VULKAN_CHECK_RESULT(vkGetSwapchainImagesKHR(context->device.handle, swapchain->handle, &swapchainImageCount, NULL));
+    if (swapchainImageCount > VULKAN_MAX_FRAME_COUNT) {
+        LOG_ERROR("create: The swapchain has %u images, more than the %u frame slots", swapchainImageCount, VULKAN_MAX_FRAME_COUNT);
+        return FALSE;
+    }
     if (!swapchain->images.capacity) {
         DARRAY_RESERVE(swapchain->images, swapchainImageCount, MEMORY_TAG_RENDERER);
         swapchain->images.size = swapchainImageCount;
@@ -200,6 +209,7 @@ b8 create(vulkan_context* context, u32 width, u32 height, vulkan_swapchain* swap
         VK_IMAGE_TYPE_2D,
         swapchainExtent.width,
         swapchainExtent.height,
+        1,
         context->device.depthFormat,
         VK_IMAGE_TILING_OPTIMAL,
         VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
@@ -2,7 +2,7 @@
 
 #include "core/logger.h"
 #include "systems/memory_system.h"
-#include "systems/resource_system.h"
+#include "systems/resource_manager.h"
 
 char const* vulkan_result_string(VkResult result, b8 get_extended)
 {
@@ -148,7 +148,7 @@ b8 create_shader_module(
     string_format(filename, "assets/shaders/%s.%s.spv", name, stage_str);
 
     Resource_Data binary_resource;
-    if (!resource_system_load(filename, RESOURCE_TYPE_BINARY, &binary_resource)) {
+    if (!resource_manager_acquire(RESOURCE_TYPE_BINARY, filename, true, &binary_resource)) {
         LOG_ERROR("create_shader_module: Failed to load shader module '%s'", filename);
         return FALSE;
     }
@@ -160,7 +160,7 @@ b8 create_shader_module(
     stages[stage_index].module.create_info.pCode = (u32*)binary_resource.data;
     VULKAN_CHECK_RESULT(vkCreateShaderModule(context->device.handle, &stages[stage_index].module.create_info, context->allocator, &stages[stage_index].module.handle));
 
-    resource_system_unload(&binary_resource);
+    resource_manager_release(&binary_resource);
 
     stages[stage_index].create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     stages[stage_index].create_info.pNext = 0;
@@ -0,0 +1,112 @@
+#include "device_memory_block.h"
+
+#include "core/logger.h"
+
+static u64 align_up(u64 value, u64 alignment);
+static bool share_page(u64 first, u64 second, u64 granularity);
+
+bool device_memory_block_create(u64 size, u64 granularity, Device_Memory_Block* block)
+{
+    if (!block || size == 0 || granularity == 0 || (granularity & (granularity - 1)) != 0)
+    {
+        LOG_ERROR("device_memory_block_create: Invalid input parameters");
+        return false;
+    }
+
+    block->size = size;
+    block->granularity = granularity;
+    block->used = 0;
+    block->allocation_count = 0;
+    return true;
+}
+
+bool device_memory_block_allocate(Device_Memory_Block* block, u64 size, u64 alignment, Device_Memory_Kind kind, u64* offset)
+{
+    if (size == 0 || size > block->size || alignment == 0 || (alignment & (alignment - 1)) != 0 ||
+        block->allocation_count == DEVICE_MEMORY_BLOCK_MAX_ALLOCATIONS)
+    {
+        return false;
+    }
+
+    // Gap i lies between allocations i - 1 and i, the first one starting at 0 and the last one ending with the block.
+    for (u32 i = 0; i <= block->allocation_count; ++i)
+    {
+        Device_Memory_Range const* previous = i > 0 ? &block->allocations[i - 1] : 0;
+        Device_Memory_Range const* next = i < block->allocation_count ? &block->allocations[i] : 0;
+        u64 start = previous ? previous->offset + previous->size : 0;
+        u64 end = next ? next->offset : block->size;
+
+        u64 candidate = align_up(start, alignment);
+        if (previous && previous->kind != kind && share_page(start - 1, candidate, block->granularity))
+        {
+            candidate = align_up(candidate, block->granularity);
+        }
+
+        if (candidate > end || end - candidate < size)
+        {
+            continue;
+        }
+
+        // The end can't be moved, so a gap whose last page the next allocation shares only takes the same kind.
+        if (next && next->kind != kind && share_page(candidate + size - 1, next->offset, block->granularity))
+        {
+            continue;
+        }
+
+        for (u32 j = block->allocation_count; j > i; --j)
+        {
+            block->allocations[j] = block->allocations[j - 1];
+        }
+        block->allocations[i].offset = candidate;
+        block->allocations[i].size = size;
+        block->allocations[i].kind = kind;
+        block->allocation_count++;
+        block->used += size;
+        *offset = candidate;
+        return true;
+    }
+
+    return false;
+}
+
+bool device_memory_block_free(Device_Memory_Block* block, u64 offset)
+{
+    u32 low = 0;
+    u32 high = block->allocation_count;
+    while (low < high)
+    {
+        u32 middle = low + (high - low) / 2;
+        if (block->allocations[middle].offset < offset)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    if (low == block->allocation_count || block->allocations[low].offset != offset)
+    {
+        LOG_WARNING("device_memory_block_free: No allocation at offset %llu", offset);
+        return false;
+    }
+
+    block->used -= block->allocations[low].size;
+    block->allocation_count--;
+    for (u32 i = low; i < block->allocation_count; ++i)
+    {
+        block->allocations[i] = block->allocations[i + 1];
+    }
+    return true;
+}
+
+u64 align_up(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool share_page(u64 first, u64 second, u64 granularity)
+{
+    return (first & ~(granularity - 1)) == (second & ~(granularity - 1));
+}
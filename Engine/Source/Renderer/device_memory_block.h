@@ -0,0 +1,57 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Bookkeeping of one block of device memory that many resources are placed in, shared by the renderer backends.
+ * Allocations are kept sorted by offset and placed first fit, each at the alignment it asks for. Buffers and linear
+ * images on one side and optimal images on the other may not share a page of _granularity_ bytes, Vulkan's
+ * bufferImageGranularity, so an allocation next to one of the other kind is moved to the next page, or skips the gap.
+ * Only offsets are managed; the backend owns the memory. Not thread-safe; used from the thread that drives the renderer.
+ */
+
+/** @brief Maximum number of allocations in one block. Allocations that would need more go to another block. */
+#define DEVICE_MEMORY_BLOCK_MAX_ALLOCATIONS 4096
+
+typedef enum Device_Memory_Kind
+{
+    /** @brief Buffers and images with linear tiling. */
+    DEVICE_MEMORY_KIND_LINEAR,
+    /** @brief Images with optimal tiling. */
+    DEVICE_MEMORY_KIND_OPTIMAL
+} Device_Memory_Kind;
+
+typedef struct Device_Memory_Range
+{
+    u64 offset;
+    u64 size;
+    Device_Memory_Kind kind;
+} Device_Memory_Range;
+
+typedef struct Device_Memory_Block
+{
+    u64 size;
+    u64 granularity;
+    /** @brief Bytes taken by allocations, without the space skipped for alignment. */
+    u64 used;
+    u32 allocation_count;
+    /** @brief The allocations, sorted by offset. The space between them is free. */
+    Device_Memory_Range allocations[DEVICE_MEMORY_BLOCK_MAX_ALLOCATIONS];
+} Device_Memory_Block;
+
+/**
+ * @param granularity The page size that linear and optimal allocations may not share. Must be a power of two.
+ */
+LIB_API bool device_memory_block_create(u64 size, u64 granularity, Device_Memory_Block* block);
+
+/**
+ * @brief Places _size_ bytes in the first gap that holds them at _alignment_, which must be a power of two.
+ * @return false if no gap does, or the block holds DEVICE_MEMORY_BLOCK_MAX_ALLOCATIONS already.
+ */
+LIB_API bool device_memory_block_allocate(Device_Memory_Block* block, u64 size, u64 alignment, Device_Memory_Kind kind, u64* offset);
+
+/**
+ * @brief Frees the allocation at _offset_, which joins the gaps around it.
+ * @return false if no allocation starts at _offset_.
+ */
+LIB_API bool device_memory_block_free(Device_Memory_Block* block, u64 offset);
@@ -1,7 +1,7 @@
 #include "renderer.h"
 
 #include "core/logger.h"
-#include "systems/resource_system.h"
+#include "systems/resource_manager.h"
 #include "systems/memory_system.h"
 #include "renderer_utils.h"
 #include "vulkan_structure_initializers.h"
@@ -40,7 +40,7 @@ bool renderer_create_shader(Shader* shader)
     {
         char const* spv_path = DYNAMIC_ARRAY_AT_AS(shader->spv_paths, path_index, char const*);
         Resource_Data spv;
-        if (!resource_system_load(RESOURCE_TYPE_BINARY, spv_path, &spv))
+        if (!resource_manager_acquire(RESOURCE_TYPE_BINARY, spv_path, true, &spv))
         {
             LOG_FATAL("renderer_create_shader: Failed to load '%s' resource", spv_path);
             return false;
@@ -48,6 +48,8 @@ bool renderer_create_shader(Shader* shader)
 
         SpvReflectShaderModule reflect_module = {};
         SPV_REFLECT_CHECK_RESULT(spvReflectCreateShaderModule(spv.size, spv.data, &reflect_module));
+        // The reflection module keeps its own copy of the code.
+        resource_manager_release(&spv);
 
         VkShaderModuleCreateInfo module_create_info = shader_module_create_info(reflect_module._internal->spirv_size, reflect_module._internal->spirv_code);
         VkShaderModule module;
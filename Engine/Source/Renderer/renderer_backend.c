@@ -1,5 +1,6 @@
 #include "renderer_backend.h"
 #include "vulkan/vulkan_backend.h"
+#include "null/null_backend.h"
 #include "systems/memory_system.h"
 
 b8 renderer_backend_create(renderer_backend_type type, renderer_backend* backend)
@@ -16,6 +17,12 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* backend
             backend->draw_geometry = vulkan_backend_draw_geometry;
             backend->create_texture = vulkan_backend_create_texture;
             backend->destroy_texture = vulkan_backend_destroy_texture;
+            backend->update_texture = vulkan_backend_update_texture;
+            backend->set_texture_base_level = vulkan_backend_set_texture_base_level;
+            backend->staging_acquire = vulkan_backend_staging_acquire;
+            backend->staging_cancel = vulkan_backend_staging_cancel;
+            backend->create_texture_from_staging = vulkan_backend_create_texture_from_staging;
+            backend->supports_texture_format = vulkan_backend_supports_texture_format;
             backend->create_material = vulkan_backend_create_material;
             backend->destroy_material = vulkan_backend_destroy_material;
             backend->create_geometry = vulkan_backend_create_geometry;
@@ -24,6 +31,32 @@ b8 renderer_backend_create(renderer_backend_type type, renderer_backend* backend
             backend->end_renderpass = vulkan_backend_end_renderpass;
             backend->frameCount = 0;
             return TRUE;
+
+        case RENDERER_BACKEND_TYPE_NULL:
+            backend->startup = null_backend_startup;
+            backend->shutdown = null_backend_shutdown;
+            backend->begin_frame = null_backend_begin_frame;
+            backend->update_global_state = null_backend_update_global_state;
+            backend->update_global_ui_state = null_backend_update_global_ui_state;
+            backend->end_frame = null_backend_end_frame;
+            backend->resize = null_backend_on_resize;
+            backend->draw_geometry = null_backend_draw_geometry;
+            backend->create_texture = null_backend_create_texture;
+            backend->destroy_texture = null_backend_destroy_texture;
+            backend->update_texture = null_backend_update_texture;
+            backend->set_texture_base_level = null_backend_set_texture_base_level;
+            backend->staging_acquire = null_backend_staging_acquire;
+            backend->staging_cancel = null_backend_staging_cancel;
+            backend->create_texture_from_staging = null_backend_create_texture_from_staging;
+            backend->supports_texture_format = null_backend_supports_texture_format;
+            backend->create_material = null_backend_create_material;
+            backend->destroy_material = null_backend_destroy_material;
+            backend->create_geometry = null_backend_create_geometry;
+            backend->destroy_geometry = null_backend_destroy_geometry;
+            backend->begin_renderpass = null_backend_begin_renderpass;
+            backend->end_renderpass = null_backend_end_renderpass;
+            backend->frameCount = 0;
+            return TRUE;
     }
 
     return FALSE;
@@ -40,6 +73,12 @@ void renderer_backend_destroy(renderer_backend* backend)
     backend->draw_geometry = 0;
     backend->create_texture = 0;
     backend->destroy_texture = 0;
+    backend->update_texture = 0;
+    backend->set_texture_base_level = 0;
+    backend->staging_acquire = 0;
+    backend->staging_cancel = 0;
+    backend->create_texture_from_staging = 0;
+    backend->supports_texture_format = 0;
     backend->create_material = 0;
     backend->destroy_material = 0;
     backend->create_geometry = 0;
@@ -27,7 +27,7 @@ static renderer_system_state* system_state;
 static b8 renderer_begin_frame(float deltaTime);
 static b8 rendererEndFrame(float deltaTime);
 
-b8 renderer_system_startup(u64* memory_size, void* memory, char const* app_name)
+b8 renderer_system_startup(u64* memory_size, void* memory, char const* app_name, renderer_backend_type backend_type)
 {
     *memory_size = sizeof(*system_state);
     if (!memory) {
@@ -36,7 +36,10 @@ b8 renderer_system_startup(u64* memory_size, void* memory, char const* app_name)
 
     system_state = memory;
 
-    renderer_backend_create(RENDERER_BACKEND_TYPE_VULKAN, &system_state->backend);
+    if (!renderer_backend_create(backend_type, &system_state->backend)) {
+        LOG_FATAL("Unsupported renderer backend type %d. Shutting down", backend_type);
+        return FALSE;
+    }
 
     if (!system_state->backend.startup(&system_state->backend, app_name)) {
         LOG_FATAL("Failed to initialize renderer system_state->backend. Shutting down");
@@ -158,6 +161,36 @@ void renderer_frontend_destroy_texture(Texture* texture)
     system_state->backend.destroy_texture(texture);
 }
 
+void renderer_frontend_update_texture(Texture* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels)
+{
+    system_state->backend.update_texture(texture, regions, region_count, pixels);
+}
+
+void renderer_frontend_set_texture_base_level(Texture* texture, u32 base_level)
+{
+    system_state->backend.set_texture_base_level(texture, base_level);
+}
+
+b8 renderer_frontend_staging_acquire(u64 size, Staging_Region* region)
+{
+    return system_state->backend.staging_acquire(size, region);
+}
+
+void renderer_frontend_staging_cancel(Staging_Region* region)
+{
+    system_state->backend.staging_cancel(region);
+}
+
+void renderer_frontend_create_texture_from_staging(Staging_Region* region, Texture* texture)
+{
+    system_state->backend.create_texture_from_staging(region, texture);
+}
+
+b8 renderer_frontend_supports_texture_format(Texture_Format format)
+{
+    return system_state->backend.supports_texture_format(format);
+}
+
 void renderer_frontend_set_view(mat4s view)
 {
     glm_mat4_copy(view, system_state->view);
@@ -5,15 +5,55 @@
 
 struct platform_state;
 
-b8 renderer_system_startup(u64* memory_size, void* memory, char const* appName);
+b8 renderer_system_startup(u64* memory_size, void* memory, char const* appName, renderer_backend_type backend_type);
 void renderer_system_shutdown();
 
 b8 renderer_frontend_draw_frame(render_packet* packet);
 void renderer_frontend_resize(i16 width, i16 height);
 
+/**
+ * @brief Creates _texture_ from its mip_count levels in _pixels_, laid out by block_compression_layout from offset 0.
+ * With no _pixels_ the levels are left undefined, and are written with renderer_frontend_update_texture before the
+ * texture is drawn.
+ */
 void renderer_frontend_create_texture(u8 const* pixels, Texture* texture);
+/**
+ * @brief Destroys _texture_ once the frames in flight, which may sample it, have completed. Doesn't wait for them.
+ */
 void renderer_frontend_destroy_texture(Texture* texture);
 
+/**
+ * @brief Writes _regions_ of _texture_ and leaves the rest of it as it was. Draws recorded in the current frame see the
+ * new contents too.
+ * @param pixels The texture's levels laid out by block_compression_layout from offset 0. Only the regions are read.
+ */
+void renderer_frontend_update_texture(Texture* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels);
+
+/**
+ * @brief Samples _texture_ from level _base_level_ down only, so the levels above it can be left unwritten.
+ */
+void renderer_frontend_set_texture_base_level(Texture* texture, u32 base_level);
+
+/**
+ * @brief Takes a slice of the renderer's persistently mapped staging ring, which the caller fills, e.g. by decoding
+ * straight into it, and then consumes with exactly one renderer_frontend_create_texture_from_staging or
+ * renderer_frontend_staging_cancel. Slices are consumed in the order they were acquired.
+ * @return FALSE if _size_ doesn't fit the ring, in which case renderer_frontend_create_texture is used instead.
+ */
+b8 renderer_frontend_staging_acquire(u64 size, Staging_Region* region);
+void renderer_frontend_staging_cancel(Staging_Region* region);
+
+/**
+ * @brief Creates _texture_ from its mip_count levels written to _region_ in its format, laid out by
+ * block_compression_layout from the start of the region. The region is consumed.
+ */
+void renderer_frontend_create_texture_from_staging(Staging_Region* region, Texture* texture);
+
+/**
+ * @return TRUE if textures of _format_ can be created and sampled. RGBA8 always can.
+ */
+b8 renderer_frontend_supports_texture_format(Texture_Format format);
+
 // TODO: Remove from export
 LIB_API void renderer_frontend_set_view(mat4s view);
 
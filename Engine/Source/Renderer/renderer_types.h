@@ -3,6 +3,7 @@
 #include "defines.h"
 #include "containers/dynamic_array.h"
 #include "containers/hash_table.h"
+#include "renderer/staging_ring.h"
 #include "resources/resource_types.h"
 
 // #include "third_party/cglm/cglm.h"
@@ -218,9 +219,30 @@ typedef struct Texture
     u32 height;
     u8 channel_count;
     b8 has_transparency;
+    /** @brief Levels of the texture. Pixels handed to the backend hold all of them, laid out by block_compression_layout from offset 0. */
+    u32 mip_count;
+    /** @brief Format of the pixels handed to the backend, which the texture is sampled in. */
+    Texture_Format format;
+    /** @brief Bytes the uploaded levels take, 0 while none are. */
+    u64 size;
+    /** @brief The last frame the texture was drawn with, stamped by texture_system_mark_used. */
+    u64 last_used_frame;
     void* internal;
 } Texture;
 
+/**
+ * @brief A rectangle of one level of a texture, in texels. With block formats it starts on a block boundary, and ends
+ * on one or at the edge of the level.
+ */
+typedef struct Texture_Region
+{
+    u32 level;
+    u32 x;
+    u32 y;
+    u32 width;
+    u32 height;
+} Texture_Region;
+
 
 
 /**
@@ -375,7 +397,9 @@ typedef enum Descriptor_Type
 typedef enum renderer_backend_type {
     RENDERER_BACKEND_TYPE_VULKAN,
     RENDERER_BACKEND_TYPE_OPENGL,
-    RENDERER_BACKEND_TYPE_DIRECTX
+    RENDERER_BACKEND_TYPE_DIRECTX,
+    /** @brief Headless backend that only counts calls and bytes. Used for CPU-side benchmarking. */
+    RENDERER_BACKEND_TYPE_NULL
 } renderer_backend_type;
 
 typedef enum builtin_renderpass {
@@ -418,6 +442,13 @@ typedef struct renderer_backend {
 
     void (* create_texture)(u8 const* pixels, Texture* texture);
     void (* destroy_texture)(Texture* texture);
+    void (* update_texture)(Texture* texture, Texture_Region const* regions, u32 region_count, u8 const* pixels);
+    void (* set_texture_base_level)(Texture* texture, u32 base_level);
+
+    b8 (* staging_acquire)(u64 size, Staging_Region* region);
+    void (* staging_cancel)(Staging_Region* region);
+    void (* create_texture_from_staging)(Staging_Region* region, Texture* texture);
+    b8 (* supports_texture_format)(Texture_Format format);
 
     b8 (*begin_renderpass)(struct renderer_backend* backend, u8 renderpass_id);
     b8 (*end_renderpass)(struct renderer_backend* backend, u8 renderpass_id);
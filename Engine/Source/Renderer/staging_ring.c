@@ -0,0 +1,114 @@
+#include "staging_ring.h"
+
+#include "core/logger.h"
+#include "systems/memory_system.h"
+
+bool staging_ring_create(u64 capacity, u64 alignment, Staging_Ring* ring)
+{
+    if (!ring || alignment == 0 || (alignment & (alignment - 1)) != 0 || capacity == 0 || capacity % alignment != 0)
+    {
+        LOG_ERROR("staging_ring_create: Invalid input parameters");
+        return false;
+    }
+
+    memory_system_zero(ring, sizeof(*ring));
+    ring->capacity = capacity;
+    ring->alignment = alignment;
+    return true;
+}
+
+bool staging_ring_allocate(Staging_Ring* ring, u64 size, void* memory, Staging_Region* region)
+{
+    if (size == 0 || size > ring->capacity)
+    {
+        return false;
+    }
+
+    if (ring->used == 0)
+    {
+        // Restarting at 0 keeps the whole ring contiguous for the next region.
+        ring->head = 0;
+        ring->tail = 0;
+    }
+
+    u64 aligned_size = (size + ring->alignment - 1) & ~(ring->alignment - 1);
+    bool wrapped = ring->head < ring->tail || (ring->head == ring->tail && ring->used > 0);
+    u64 offset;
+    u64 reserved_size;
+    if (wrapped)
+    {
+        if (aligned_size > ring->tail - ring->head)
+        {
+            return false;
+        }
+
+        offset = ring->head;
+        reserved_size = aligned_size;
+    }
+    else if (aligned_size <= ring->capacity - ring->head)
+    {
+        offset = ring->head;
+        reserved_size = aligned_size;
+    }
+    else if (aligned_size <= ring->tail)
+    {
+        // The rest of the ring is too short, so it is skipped and retired together with this region.
+        offset = 0;
+        reserved_size = ring->capacity - ring->head + aligned_size;
+    }
+    else
+    {
+        return false;
+    }
+
+    ring->head = (offset + aligned_size) % ring->capacity;
+    ring->used += reserved_size;
+
+    region->memory = memory ? (u8*)memory + offset : 0;
+    region->offset = offset;
+    region->size = size;
+    region->reserved_size = reserved_size;
+    region->sequence = ring->allocated_count++;
+    return true;
+}
+
+u32 staging_ring_release(Staging_Ring* ring, Staging_Region const* region)
+{
+    if (region->sequence != ring->released_count)
+    {
+        LOG_ERROR("staging_ring_release: Regions must be released in the order they were allocated");
+        return INVALID_ID;
+    }
+
+    if (ring->release_count == STAGING_RING_MAX_RELEASES)
+    {
+        return INVALID_ID;
+    }
+
+    u32 slot = (ring->first_release + ring->release_count) % STAGING_RING_MAX_RELEASES;
+    u64 aligned_size = (region->size + ring->alignment - 1) & ~(ring->alignment - 1);
+    ring->releases[slot].end = (region->offset + aligned_size) % ring->capacity;
+    ring->releases[slot].reserved_size = region->reserved_size;
+    ring->release_count++;
+    ring->released_count++;
+    return slot;
+}
+
+u32 staging_ring_oldest_release(Staging_Ring const* ring)
+{
+    return ring->release_count > 0 ? ring->first_release : INVALID_ID;
+}
+
+void staging_ring_retire_oldest(Staging_Ring* ring)
+{
+    if (ring->release_count == 0)
+    {
+        return;
+    }
+
+    Staging_Ring_Release const* release = &ring->releases[ring->first_release];
+    ring->tail = release->end;
+    ring->used -= release->reserved_size;
+    ring->first_release = (ring->first_release + 1) % STAGING_RING_MAX_RELEASES;
+    ring->release_count--;
+}
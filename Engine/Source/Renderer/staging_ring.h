@@ -0,0 +1,84 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Bookkeeping of a ring of persistently mapped staging memory, shared by the renderer backends.
+ * Regions are allocated at the head and released in the order they were allocated, each release marking the point
+ * up to which the ring may be reused once the upload that reads the region has completed. Only offsets are managed;
+ * the backend owns the memory and whatever tells it that an upload has completed, e.g. one fence per release slot.
+ * Not thread-safe; used from the thread that drives the renderer.
+ */
+
+#define STAGING_RING_MAX_RELEASES 64
+
+/**
+ * @brief A slice of the renderer's staging memory that the CPU fills before an upload.
+ */
+typedef struct Staging_Region
+{
+    /** @brief The mapped memory of the slice, _size_ bytes long. */
+    void* memory;
+    /** @brief Offset of the slice in the backend's staging buffer. */
+    u64 offset;
+    u64 size;
+    /** @brief Bytes taken from the ring, including alignment and the tail skipped when wrapping. */
+    u64 reserved_size;
+    /** @brief Allocation order, which releases must follow. */
+    u64 sequence;
+} Staging_Region;
+
+typedef struct Staging_Ring_Release
+{
+    u64 end;
+    u64 reserved_size;
+} Staging_Ring_Release;
+
+typedef struct Staging_Ring
+{
+    u64 capacity;
+    u64 alignment;
+    /** @brief Where the next region starts. */
+    u64 head;
+    /** @brief Start of the oldest region that may still be in use. */
+    u64 tail;
+    /** @brief Bytes between tail and head, including skipped space. */
+    u64 used;
+
+    u64 allocated_count;
+    u64 released_count;
+
+    /** @brief Released regions whose uploads may still be reading them, oldest first. */
+    Staging_Ring_Release releases[STAGING_RING_MAX_RELEASES];
+    u32 first_release;
+    u32 release_count;
+} Staging_Ring;
+
+/**
+ * @param alignment The alignment of every region offset. Must be a power of two.
+ */
+LIB_API bool staging_ring_create(u64 capacity, u64 alignment, Staging_Ring* ring);
+
+/**
+ * @brief Takes a region of _size_ bytes at the head, wrapping to the start of the ring when the rest is too short.
+ * Fails without waiting when the space is still in use; the caller retires completed releases and tries again.
+ * @param memory The mapped start of the ring, or 0 to leave region->memory unset.
+ */
+LIB_API bool staging_ring_allocate(Staging_Ring* ring, u64 size, void* memory, Staging_Region* region);
+
+/**
+ * @brief Hands a region back once the upload reading it has been submitted, or when it is abandoned unused.
+ * @return The release slot, which the backend associates with whatever signals completion, or INVALID_ID when
+ * every slot is taken or _region_ isn't the oldest unreleased region.
+ */
+LIB_API u32 staging_ring_release(Staging_Ring* ring, Staging_Region const* region);
+
+/**
+ * @return The slot of the oldest pending release, or INVALID_ID if there is none.
+ */
+LIB_API u32 staging_ring_oldest_release(Staging_Ring const* ring);
+
+/**
+ * @brief Makes the space of the oldest pending release reusable. Called once its upload has completed.
+ */
+LIB_API void staging_ring_retire_oldest(Staging_Ring* ring);
@@ -1,4 +1,5 @@
 #include "defines.h"
+#include "containers/dynamic_array.h"
 #include "third_party/cglm/struct.h"
 
 typedef enum Renderpass_Clear_Flags
@@ -75,6 +76,34 @@ typedef struct Context
     vulkan_buffer object_vertex_buffer;
     vulkan_buffer object_index_buffer;
 
+    // Geometry buffers replaced by a resize, per frame slot. The frame recording in that slot may have drawn from them,
+    // so they are destroyed once the slot's fence has been waited for.
+    vulkan_buffer retired_buffers[VULKAN_MAX_FRAME_COUNT][VULKAN_MAX_RETIRED_BUFFERS];
+    u32 retired_buffer_counts[VULKAN_MAX_FRAME_COUNT];
+
+    // Geometry ranges given up by a reupload, a destroy or a compaction, per frame slot, as vulkan_retired_range. They
+    // go back to the buffers' freelists once the slot's fence has been waited for.
+    Dynamic_Array* retired_ranges[VULKAN_MAX_FRAME_COUNT];
+
+    // Textures destroyed while frames in flight may still sample them, per frame slot, as vulkan_texture_resource*.
+    Dynamic_Array* retired_textures[VULKAN_MAX_FRAME_COUNT];
+    // Texture views replaced by a change of base level, per frame slot, as VkImageView.
+    Dynamic_Array* retired_views[VULKAN_MAX_FRAME_COUNT];
+
+    // Command buffers of the compaction copies, per frame slot. Submitted ahead of the slot's frame, so its fence covers them.
+    vulkan_command_buffer defrag_command_buffers[VULKAN_MAX_FRAME_COUNT];
+
+    // Set from begin_frame until end_frame. In between frames, current_frame already names the slot of the next frame.
+    b8 frame_in_progress;
+
+    // Set when geometry leaves holes behind, and cleared once a compaction pass at the start of a frame finds nothing
+    // left to move.
+    b8 geometry_defrag_pending;
+
+    vulkan_memory_allocator memory;
+    vulkan_staging staging;
+    vulkan_sampler_cache sampler_cache;
+
     vulkan_swapchain swapchain;
     b8 recreating_swapchain;
     u32 current_image;
@@ -83,8 +112,8 @@ typedef struct Context
     DARRAY(VkSemaphore) image_available_semaphors;
     DARRAY(VkSemaphore) render_complete_semaphors;
 
-    VkFence fences_in_flight[2];
-    VkFence* images_in_flight[3];
+    VkFence fences_in_flight[VULKAN_MAX_FRAME_COUNT];
+    VkFence* images_in_flight[VULKAN_MAX_FRAME_COUNT];
 
     u32 current_frame;
 
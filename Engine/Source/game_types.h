@@ -2,6 +2,7 @@
 
 #include "defines.h"
 #include "core/application.h"
+#include "renderer/renderer_types.h"
 
 typedef struct game_instance
 {
@@ -12,6 +13,11 @@ typedef struct game_instance
         i16 width;
         i16 height;
         char* name;
+        // Zero-initialized configs get the vulkan backend
+        renderer_backend_type renderer_backend;
+        // Textures decoded while the engine starts up, so that the first frames don't wait for them. Up to 32 are preloaded.
+        char const* const* preload_texture_names;
+        u32 preload_texture_count;
     } application_config;
 
     b8 (* init)(struct game_instance* game);
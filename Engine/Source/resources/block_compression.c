@@ -0,0 +1,1494 @@
+#include "block_compression.h"
+
+#include "resources/mip_chain.h"
+#include "systems/job_system.h"
+#include "systems/memory_system.h"
+
+#include <math.h>
+
+// Jobs are cut from whole rows of blocks, at least this many blocks each so that small levels don't cost more to
+// schedule than to encode.
+#define MIN_BLOCKS_PER_JOB 256
+#define MAX_JOB_COUNT 64
+#define BC7_NORMAL_PARTITION_COUNT 8
+#define BC7_HIGH_PARTITION_COUNT 16
+#define BC7_PARTITION_COUNT 64
+
+/**
+ * @brief One RGBA8 level and the blocks it is encoded to or decoded from.
+ */
+typedef struct Block_Level
+{
+    u8* pixels;
+    u32 width;
+    u32 height;
+    u8* blocks;
+} Block_Level;
+
+/**
+ * @brief Rows of blocks of one level that are encoded together, on one thread.
+ */
+typedef struct Encode_Job
+{
+    Block_Level level;
+    u32 first_row;
+    u32 row_count;
+    Texture_Format format;
+    Block_Compression_Quality quality;
+} Encode_Job;
+
+/**
+ * @brief Texels of subset 1 of each BC7 two subset partition, one bit per texel in row order. The other texels are
+ * in subset 0.
+ */
+static u16 const bc7_partitions[BC7_PARTITION_COUNT] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80,
+    0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8, 0xFF00, 0xFFF0, 0xF000,
+    0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE,
+    0x088C, 0x3110, 0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C,
+    0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696, 0xA55A,
+    0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660,
+    0x0272, 0x04E4, 0x4E40, 0x2720, 0xC936, 0x936C, 0x39C6, 0x639C,
+    0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22
+};
+
+/** @brief The texel of subset 1 whose index is stored with one bit less, for each two subset partition. */
+static u8 const bc7_anchors[BC7_PARTITION_COUNT] = {
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 2, 8, 2, 2, 8, 8, 15,
+    2, 8, 2, 2, 8, 8, 2, 2,
+    15, 15, 6, 8, 2, 8, 15, 15,
+    2, 8, 2, 2, 2, 15, 15, 6,
+    6, 2, 6, 8, 15, 15, 2, 2,
+    15, 15, 15, 15, 15, 2, 2, 15
+};
+
+static u8 const bc7_weights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static u8 const bc7_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static void encode_job(void* params);
+static void load_block(Block_Level const* level, u32 block_x, u32 block_y, u8 texels[16][4]);
+static void store_block(Block_Level* level, u32 block_x, u32 block_y, u8 const texels[16][4]);
+static u32 refinement_count(Block_Compression_Quality quality);
+
+static void fit_axis(f32 const (*points)[4], u32 count, u32 channels, f32 mean[4], f32 axis[4]);
+static void fit_endpoints(f32 const (*points)[4], u32 count, u32 channels, f32 low[4], f32 high[4]);
+static void refine_endpoints(f32 const (*points)[4], f32 const* weights, u32 count, u32 channels, f32 low[4], f32 high[4]);
+
+static u16 pack_565(f32 const color[4]);
+static void unpack_565(u16 color, i32 rgb[3]);
+static void color_palette(u16 color0, u16 color1, bool three_color, i32 palette[4][4]);
+static void encode_color_block(u8 const texels[16][4], bool punchthrough, u32 refinements, u8* block);
+static void decode_color_block(u8 const* block, bool always_four_color, u8 texels[16][4]);
+static void alpha_palette(u8 alpha0, u8 alpha1, i32 palette[8]);
+static u32 evaluate_alpha_block(u8 const texels[16][4], u8 alpha0, u8 alpha1, u8 indices[16]);
+static void encode_alpha_block(u8 const texels[16][4], bool try_six_alpha, u8* block);
+static void decode_alpha_block(u8 const* block, u8 texels[16][4]);
+
+static void write_bits(u8 block[16], u32* position, u32 value, u32 count);
+static u32 read_bits(u8 const* block, u32* position, u32 count);
+static u32 quantize_endpoint_mode6(f32 const value[4], u32 p_bit, u8 quantized[4]);
+static u32 quantize_endpoint_mode1(f32 const value[4], u32 p_bit, u8 quantized[4]);
+static u8 expand_mode1(u8 quantized, u32 p_bit);
+static u32 encode_mode6(u8 const texels[16][4], Block_Compression_Quality quality, u8 block[16]);
+static u32 encode_mode1(u8 const texels[16][4], u32 partition, Block_Compression_Quality quality, u8 block[16]);
+static f32 subset_residual(f32 const moments[10]);
+static void encode_bc7_block(u8 const texels[16][4], Block_Compression_Quality quality, u8* block);
+static void decode_bc7_block(u8 const* block, u8 texels[16][4]);
+static bool block_has_transparency(u8 const* block, Texture_Format format);
+static u32 bc7_mode(u8 const* block);
+
+u32 block_compression_block_size(Texture_Format format)
+{
+    switch (format)
+    {
+        case TEXTURE_FORMAT_BC1:
+            return 8;
+        case TEXTURE_FORMAT_BC3:
+        case TEXTURE_FORMAT_BC7:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+u64 block_compression_level_size(Texture_Format format, u32 width, u32 height)
+{
+    u32 block_size = block_compression_block_size(format);
+    if (block_size == 0)
+    {
+        return (u64)width * height * 4;
+    }
+
+    return (u64)((width + 3) / 4) * ((height + 3) / 4) * block_size;
+}
+
+u64 block_compression_copy_region(Texture_Format format, u8 const* level, u32 level_width, u32 x, u32 y, u32 width, u32 height, u8* destination)
+{
+    // Rows of blocks are copied like rows of texels, with a block as the unit.
+    u32 unit = 1;
+    u32 unit_size = 4;
+    if (block_compression_block_size(format) > 0)
+    {
+        unit = 4;
+        unit_size = block_compression_block_size(format);
+    }
+
+    u64 level_pitch = (u64)((level_width + unit - 1) / unit) * unit_size;
+    u64 row_size = (u64)((width + unit - 1) / unit) * unit_size;
+    u32 row_count = (height + unit - 1) / unit;
+    u8 const* source = level + (u64)(y / unit) * level_pitch + (u64)(x / unit) * unit_size;
+    for (u32 i = 0; i < row_count; ++i)
+    {
+        memory_system_copy(destination + i * row_size, source + i * level_pitch, row_size);
+    }
+
+    return row_size * row_count;
+}
+
+u32 block_compression_layout(Texture_Format format, u32 width, u32 height, u64 offset, Cooked_Mip* mips)
+{
+    u32 mip_count = mip_chain_layout(width, height, offset, mips);
+    for (u32 i = 0; i < mip_count; ++i)
+    {
+        mips[i].offset = offset;
+        mips[i].size = block_compression_level_size(format, mips[i].width, mips[i].height);
+        offset = (offset + mips[i].size + MIP_ALIGNMENT - 1) & ~(u64)(MIP_ALIGNMENT - 1);
+    }
+
+    return mip_count;
+}
+
+u64 block_compression_chain_size(Texture_Format format, u32 width, u32 height, u32 mip_count)
+{
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 full_count = block_compression_layout(format, width, height, 0, mips);
+    u32 count = mip_count < full_count ? mip_count : full_count;
+    return count > 0 ? mips[count - 1].offset + mips[count - 1].size : 0;
+}
+
+Texture_Format block_compression_choose_format(Texture_Format requested, bool has_transparency)
+{
+    return requested == TEXTURE_FORMAT_BC1 && has_transparency ? TEXTURE_FORMAT_BC3 : requested;
+}
+
+void block_compression_encode(u8 const* chain, u32 width, u32 height, u32 mip_count, Texture_Format format, Block_Compression_Quality quality, u8* blocks)
+{
+    Cooked_Mip source_mips[COOKED_TEXTURE_MAX_MIPS];
+    Cooked_Mip block_mips[COOKED_TEXTURE_MAX_MIPS];
+    mip_chain_layout(width, height, 0, source_mips);
+    block_compression_layout(format, width, height, 0, block_mips);
+
+    u64 total_block_count = 0;
+    for (u32 i = 0; i < mip_count; ++i)
+    {
+        total_block_count += block_mips[i].size / block_compression_block_size(format);
+    }
+
+    // Levels don't depend on each other, so the jobs of every level run at once.
+    u64 blocks_per_job = (total_block_count + MAX_JOB_COUNT - 1) / MAX_JOB_COUNT;
+    blocks_per_job = blocks_per_job > MIN_BLOCKS_PER_JOB ? blocks_per_job : MIN_BLOCKS_PER_JOB;
+
+    Encode_Job jobs[MAX_JOB_COUNT];
+    u32 job_count = 0;
+    Job_Counter counter = {};
+    for (u32 i = 0; i < mip_count; ++i)
+    {
+        Block_Level level;
+        level.pixels = (u8*)chain + source_mips[i].offset;
+        level.width = source_mips[i].width;
+        level.height = source_mips[i].height;
+        level.blocks = blocks + block_mips[i].offset;
+
+        u32 blocks_x = (level.width + 3) / 4;
+        u32 blocks_y = (level.height + 3) / 4;
+        u32 rows_per_job = (u32)((blocks_per_job + blocks_x - 1) / blocks_x);
+        for (u32 row = 0; row < blocks_y; row += rows_per_job)
+        {
+            if (job_count == MAX_JOB_COUNT)
+            {
+                job_system_wait(&counter);
+                job_count = 0;
+            }
+
+            Encode_Job* job = &jobs[job_count++];
+            job->level = level;
+            job->first_row = row;
+            job->row_count = blocks_y - row < rows_per_job ? blocks_y - row : rows_per_job;
+            job->format = format;
+            job->quality = quality;
+            job_system_submit(encode_job, job, &counter);
+        }
+    }
+
+    job_system_wait(&counter);
+}
+
+void block_compression_decode(u8 const* blocks, u32 width, u32 height, u32 mip_count, Texture_Format format, u8* chain)
+{
+    Cooked_Mip pixel_mips[COOKED_TEXTURE_MAX_MIPS];
+    Cooked_Mip block_mips[COOKED_TEXTURE_MAX_MIPS];
+    mip_chain_layout(width, height, 0, pixel_mips);
+    block_compression_layout(format, width, height, 0, block_mips);
+
+    u32 block_size = block_compression_block_size(format);
+    for (u32 i = 0; i < mip_count; ++i)
+    {
+        Block_Level level;
+        level.pixels = chain + pixel_mips[i].offset;
+        level.width = pixel_mips[i].width;
+        level.height = pixel_mips[i].height;
+        level.blocks = (u8*)blocks + block_mips[i].offset;
+
+        u32 blocks_x = (level.width + 3) / 4;
+        u32 blocks_y = (level.height + 3) / 4;
+        for (u32 y = 0; y < blocks_y; ++y)
+        {
+            for (u32 x = 0; x < blocks_x; ++x)
+            {
+                u8 const* block = level.blocks + ((u64)y * blocks_x + x) * block_size;
+                u8 texels[16][4];
+                if (format == TEXTURE_FORMAT_BC1)
+                {
+                    decode_color_block(block, false, texels);
+                }
+                else if (format == TEXTURE_FORMAT_BC3)
+                {
+                    decode_color_block(block + 8, true, texels);
+                    decode_alpha_block(block, texels);
+                }
+                else
+                {
+                    decode_bc7_block(block, texels);
+                }
+
+                store_block(&level, x, y, texels);
+            }
+        }
+    }
+}
+
+bool block_compression_can_decode(u8 const* blocks, u32 width, u32 height, u32 mip_count, Texture_Format format)
+{
+    if (format != TEXTURE_FORMAT_BC7)
+    {
+        return true;
+    }
+
+    // Levels are padded to MIP_ALIGNMENT, which BC7 blocks already are, so the chain is a run of blocks.
+    u64 block_count = block_compression_chain_size(format, width, height, mip_count) / 16;
+    for (u64 i = 0; i < block_count; ++i)
+    {
+        u32 mode = bc7_mode(blocks + i * 16);
+        if (mode != 1 && mode != 6)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool block_compression_has_transparency(u8 const* blocks, u32 width, u32 height, Texture_Format format)
+{
+    u32 block_size = block_compression_block_size(format);
+    u64 block_count = (u64)((width + 3) / 4) * ((height + 3) / 4);
+    for (u64 i = 0; i < block_count; ++i)
+    {
+        if (block_has_transparency(blocks + i * block_size, format))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+f64 block_compression_psnr(u8 const* reference, u8 const* pixels, u64 pixel_count)
+{
+    u64 squared_error = 0;
+    for (u64 i = 0; i < pixel_count * 4; ++i)
+    {
+        i32 difference = (i32)reference[i] - (i32)pixels[i];
+        squared_error += (u64)(difference * difference);
+    }
+
+    if (squared_error == 0 || pixel_count == 0)
+    {
+        return 999.0;
+    }
+
+    f64 mean_squared_error = (f64)squared_error / (f64)(pixel_count * 4);
+    return 10.0 * log10(255.0 * 255.0 / mean_squared_error);
+}
+
+void encode_job(void* params)
+{
+    Encode_Job* job = params;
+    u32 block_size = block_compression_block_size(job->format);
+    u32 refinements = refinement_count(job->quality);
+    u32 blocks_x = (job->level.width + 3) / 4;
+    for (u32 y = job->first_row; y < job->first_row + job->row_count; ++y)
+    {
+        for (u32 x = 0; x < blocks_x; ++x)
+        {
+            // Built on the stack and copied out whole, as the destination may be slow to read.
+            u8 texels[16][4];
+            u8 block[16];
+            load_block(&job->level, x, y, texels);
+            if (job->format == TEXTURE_FORMAT_BC1)
+            {
+                encode_color_block(texels, true, refinements, block);
+            }
+            else if (job->format == TEXTURE_FORMAT_BC3)
+            {
+                encode_alpha_block(texels, job->quality != BLOCK_COMPRESSION_QUALITY_FAST, block);
+                encode_color_block(texels, false, refinements, block + 8);
+            }
+            else
+            {
+                encode_bc7_block(texels, job->quality, block);
+            }
+
+            memory_system_copy(job->level.blocks + ((u64)y * blocks_x + x) * block_size, block, block_size);
+        }
+    }
+}
+
+void load_block(Block_Level const* level, u32 block_x, u32 block_y, u8 texels[16][4])
+{
+    for (u32 y = 0; y < 4; ++y)
+    {
+        u32 source_y = block_y * 4 + y < level->height ? block_y * 4 + y : level->height - 1;
+        for (u32 x = 0; x < 4; ++x)
+        {
+            u32 source_x = block_x * 4 + x < level->width ? block_x * 4 + x : level->width - 1;
+            u8 const* texel = level->pixels + ((u64)source_y * level->width + source_x) * 4;
+            texels[y * 4 + x][0] = texel[0];
+            texels[y * 4 + x][1] = texel[1];
+            texels[y * 4 + x][2] = texel[2];
+            texels[y * 4 + x][3] = texel[3];
+        }
+    }
+}
+
+void store_block(Block_Level* level, u32 block_x, u32 block_y, u8 const texels[16][4])
+{
+    for (u32 y = 0; y < 4 && block_y * 4 + y < level->height; ++y)
+    {
+        for (u32 x = 0; x < 4 && block_x * 4 + x < level->width; ++x)
+        {
+            u8* texel = level->pixels + ((u64)(block_y * 4 + y) * level->width + block_x * 4 + x) * 4;
+            memory_system_copy(texel, texels[y * 4 + x], 4);
+        }
+    }
+}
+
+u32 refinement_count(Block_Compression_Quality quality)
+{
+    switch (quality)
+    {
+        case BLOCK_COMPRESSION_QUALITY_FAST:
+            return 0;
+        case BLOCK_COMPRESSION_QUALITY_NORMAL:
+            return 1;
+        default:
+            return 3;
+    }
+}
+
+void fit_axis(f32 const (*points)[4], u32 count, u32 channels, f32 mean[4], f32 axis[4])
+{
+    for (u32 c = 0; c < 4; ++c)
+    {
+        mean[c] = 0.0f;
+        axis[c] = 0.0f;
+    }
+    for (u32 i = 0; i < count; ++i)
+    {
+        for (u32 c = 0; c < channels; ++c)
+        {
+            mean[c] += points[i][c];
+        }
+    }
+    for (u32 c = 0; c < channels; ++c)
+    {
+        mean[c] /= (f32)count;
+    }
+
+    f32 covariance[4][4] = {};
+    for (u32 i = 0; i < count; ++i)
+    {
+        for (u32 a = 0; a < channels; ++a)
+        {
+            for (u32 b = 0; b < channels; ++b)
+            {
+                covariance[a][b] += (points[i][a] - mean[a]) * (points[i][b] - mean[b]);
+            }
+        }
+    }
+
+    // Power iteration from the column of the channel that varies most, which is never orthogonal to the axis.
+    u32 largest = 0;
+    for (u32 c = 1; c < channels; ++c)
+    {
+        largest = covariance[c][c] > covariance[largest][largest] ? c : largest;
+    }
+    if (covariance[largest][largest] <= 0.0f)
+    {
+        return;
+    }
+
+    f32 vector[4];
+    for (u32 c = 0; c < channels; ++c)
+    {
+        vector[c] = covariance[c][largest];
+    }
+    for (u32 iteration = 0; iteration < 8; ++iteration)
+    {
+        f32 next[4] = {};
+        f32 magnitude = 0.0f;
+        for (u32 a = 0; a < channels; ++a)
+        {
+            for (u32 b = 0; b < channels; ++b)
+            {
+                next[a] += covariance[a][b] * vector[b];
+            }
+            magnitude = fabsf(next[a]) > magnitude ? fabsf(next[a]) : magnitude;
+        }
+        if (magnitude <= 0.0f)
+        {
+            return;
+        }
+        for (u32 c = 0; c < channels; ++c)
+        {
+            vector[c] = next[c] / magnitude;
+        }
+    }
+
+    f32 length = 0.0f;
+    for (u32 c = 0; c < channels; ++c)
+    {
+        length += vector[c] * vector[c];
+    }
+    length = sqrtf(length);
+    for (u32 c = 0; c < channels; ++c)
+    {
+        axis[c] = vector[c] / length;
+    }
+}
+
+void fit_endpoints(f32 const (*points)[4], u32 count, u32 channels, f32 low[4], f32 high[4])
+{
+    f32 mean[4];
+    f32 axis[4];
+    fit_axis(points, count, channels, mean, axis);
+
+    f32 minimum = 0.0f;
+    f32 maximum = 0.0f;
+    for (u32 i = 0; i < count; ++i)
+    {
+        f32 t = 0.0f;
+        for (u32 c = 0; c < channels; ++c)
+        {
+            t += (points[i][c] - mean[c]) * axis[c];
+        }
+        minimum = t < minimum ? t : minimum;
+        maximum = t > maximum ? t : maximum;
+    }
+
+    for (u32 c = 0; c < 4; ++c)
+    {
+        low[c] = c < channels ? mean[c] + axis[c] * minimum : 255.0f;
+        high[c] = c < channels ? mean[c] + axis[c] * maximum : 255.0f;
+        low[c] = low[c] < 0.0f ? 0.0f : low[c] > 255.0f ? 255.0f : low[c];
+        high[c] = high[c] < 0.0f ? 0.0f : high[c] > 255.0f ? 255.0f : high[c];
+    }
+}
+
+void refine_endpoints(f32 const (*points)[4], f32 const* weights, u32 count, u32 channels, f32 low[4], f32 high[4])
+{
+    // Least squares fit of the endpoints to the points, given how far towards high each point's index lies.
+    f32 low_low = 0.0f;
+    f32 low_high = 0.0f;
+    f32 high_high = 0.0f;
+    f32 low_sum[4] = {};
+    f32 high_sum[4] = {};
+    for (u32 i = 0; i < count; ++i)
+    {
+        f32 w = weights[i];
+        f32 v = 1.0f - w;
+        low_low += v * v;
+        low_high += v * w;
+        high_high += w * w;
+        for (u32 c = 0; c < channels; ++c)
+        {
+            low_sum[c] += v * points[i][c];
+            high_sum[c] += w * points[i][c];
+        }
+    }
+
+    // Every point on the same index leaves the fit undetermined.
+    f32 determinant = low_low * high_high - low_high * low_high;
+    if (fabsf(determinant) < 1e-6f)
+    {
+        return;
+    }
+
+    for (u32 c = 0; c < channels; ++c)
+    {
+        f32 l = (high_high * low_sum[c] - low_high * high_sum[c]) / determinant;
+        f32 h = (low_low * high_sum[c] - low_high * low_sum[c]) / determinant;
+        low[c] = l < 0.0f ? 0.0f : l > 255.0f ? 255.0f : l;
+        high[c] = h < 0.0f ? 0.0f : h > 255.0f ? 255.0f : h;
+    }
+}
+
+u16 pack_565(f32 const color[4])
+{
+    u32 r = (u32)(color[0] * 31.0f / 255.0f + 0.5f);
+    u32 g = (u32)(color[1] * 63.0f / 255.0f + 0.5f);
+    u32 b = (u32)(color[2] * 31.0f / 255.0f + 0.5f);
+    return (u16)((r << 11) | (g << 5) | b);
+}
+
+void unpack_565(u16 color, i32 rgb[3])
+{
+    i32 r = (color >> 11) & 31;
+    i32 g = (color >> 5) & 63;
+    i32 b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+void color_palette(u16 color0, u16 color1, bool three_color, i32 palette[4][4])
+{
+    unpack_565(color0, palette[0]);
+    unpack_565(color1, palette[1]);
+    for (u32 c = 0; c < 3; ++c)
+    {
+        if (three_color)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        else
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+
+    palette[0][3] = 255;
+    palette[1][3] = 255;
+    palette[2][3] = 255;
+    palette[3][3] = three_color ? 0 : 255;
+}
+
+void encode_color_block(u8 const texels[16][4], bool punchthrough, u32 refinements, u8* block)
+{
+    // Texels under half alpha are only kept transparent by BC1's three colour mode, whose fourth entry is transparent black.
+    static f32 const index_weights[2][4] = { { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f }, { 0.0f, 1.0f, 0.5f, 0.0f } };
+    bool transparent[16];
+    f32 points[16][4];
+    u32 opaque_count = 0;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        transparent[i] = punchthrough && texels[i][3] < 128;
+        if (!transparent[i])
+        {
+            points[opaque_count][0] = texels[i][0];
+            points[opaque_count][1] = texels[i][1];
+            points[opaque_count][2] = texels[i][2];
+            opaque_count++;
+        }
+    }
+
+    bool three_color = opaque_count < 16;
+    u16 best_colors[2] = { 0, 0 };
+    u8 best_indices[16];
+    for (u32 i = 0; i < 16; ++i)
+    {
+        best_indices[i] = 3;
+    }
+
+    if (opaque_count > 0)
+    {
+        f32 low[4];
+        f32 high[4];
+        fit_endpoints(points, opaque_count, 3, low, high);
+        u32 best_error = 0xFFFFFFFF;
+        for (u32 iteration = 0;; ++iteration)
+        {
+            u16 colors[2] = { pack_565(low), pack_565(high) };
+            i32 palette[4][4];
+            color_palette(colors[0], colors[1], three_color, palette);
+
+            u8 indices[16];
+            f32 weights[16];
+            u32 weight_count = 0;
+            u32 error = 0;
+            for (u32 i = 0; i < 16; ++i)
+            {
+                indices[i] = 3;
+                if (transparent[i])
+                {
+                    continue;
+                }
+
+                u32 nearest_error = 0xFFFFFFFF;
+                for (u32 entry = 0; entry < (three_color ? 3u : 4u); ++entry)
+                {
+                    u32 entry_error = 0;
+                    for (u32 c = 0; c < 3; ++c)
+                    {
+                        i32 difference = (i32)texels[i][c] - palette[entry][c];
+                        entry_error += (u32)(difference * difference);
+                    }
+                    if (entry_error < nearest_error)
+                    {
+                        nearest_error = entry_error;
+                        indices[i] = (u8)entry;
+                    }
+                }
+                error += nearest_error;
+                weights[weight_count++] = index_weights[three_color][indices[i]];
+            }
+
+            if (error < best_error)
+            {
+                best_error = error;
+                best_colors[0] = colors[0];
+                best_colors[1] = colors[1];
+                memory_system_copy(best_indices, indices, sizeof(indices));
+            }
+
+            if (iteration == refinements || error == 0)
+            {
+                break;
+            }
+            refine_endpoints(points, weights, opaque_count, 3, low, high);
+        }
+    }
+
+    // The order of the colours selects the mode: three colour when the first isn't greater.
+    bool swap = three_color ? best_colors[0] > best_colors[1] : best_colors[0] < best_colors[1];
+    if (swap)
+    {
+        u16 color = best_colors[0];
+        best_colors[0] = best_colors[1];
+        best_colors[1] = color;
+    }
+
+    u32 index_bits = 0;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        u32 index = best_indices[i];
+        if (!three_color && best_colors[0] == best_colors[1])
+        {
+            // Equal colours decode in three colour mode, where only the first entries repeat them.
+            index = 0;
+        }
+        else if (swap && (index < 2 || !three_color))
+        {
+            // Swapping exchanges the endpoints and, with four colours, the two interpolated entries.
+            index ^= 1;
+        }
+        index_bits |= index << (i * 2);
+    }
+
+    block[0] = (u8)best_colors[0];
+    block[1] = (u8)(best_colors[0] >> 8);
+    block[2] = (u8)best_colors[1];
+    block[3] = (u8)(best_colors[1] >> 8);
+    block[4] = (u8)index_bits;
+    block[5] = (u8)(index_bits >> 8);
+    block[6] = (u8)(index_bits >> 16);
+    block[7] = (u8)(index_bits >> 24);
+}
+
+void decode_color_block(u8 const* block, bool always_four_color, u8 texels[16][4])
+{
+    u16 color0 = (u16)(block[0] | (block[1] << 8));
+    u16 color1 = (u16)(block[2] | (block[3] << 8));
+    u32 index_bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((u32)block[7] << 24);
+
+    i32 palette[4][4];
+    color_palette(color0, color1, !always_four_color && color0 <= color1, palette);
+    for (u32 i = 0; i < 16; ++i)
+    {
+        u32 index = (index_bits >> (i * 2)) & 3;
+        for (u32 c = 0; c < 4; ++c)
+        {
+            texels[i][c] = (u8)palette[index][c];
+        }
+    }
+}
+
+void alpha_palette(u8 alpha0, u8 alpha1, i32 palette[8])
+{
+    palette[0] = alpha0;
+    palette[1] = alpha1;
+    if (alpha0 > alpha1)
+    {
+        for (i32 i = 1; i < 7; ++i)
+        {
+            palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+        }
+    }
+    else
+    {
+        for (i32 i = 1; i < 5; ++i)
+        {
+            palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+u32 evaluate_alpha_block(u8 const texels[16][4], u8 alpha0, u8 alpha1, u8 indices[16])
+{
+    i32 palette[8];
+    alpha_palette(alpha0, alpha1, palette);
+
+    u32 error = 0;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        u32 nearest_error = 0xFFFFFFFF;
+        for (u32 entry = 0; entry < 8; ++entry)
+        {
+            i32 difference = (i32)texels[i][3] - palette[entry];
+            if ((u32)(difference * difference) < nearest_error)
+            {
+                nearest_error = (u32)(difference * difference);
+                indices[i] = (u8)entry;
+            }
+        }
+        error += nearest_error;
+    }
+
+    return error;
+}
+
+void encode_alpha_block(u8 const texels[16][4], bool try_six_alpha, u8* block)
+{
+    u8 minimum = 255;
+    u8 maximum = 0;
+    u8 inner_minimum = 255;
+    u8 inner_maximum = 0;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        u8 alpha = texels[i][3];
+        minimum = alpha < minimum ? alpha : minimum;
+        maximum = alpha > maximum ? alpha : maximum;
+        if (alpha != 0 && alpha != 255)
+        {
+            inner_minimum = alpha < inner_minimum ? alpha : inner_minimum;
+            inner_maximum = alpha > inner_maximum ? alpha : inner_maximum;
+        }
+    }
+
+    // Eight interpolated values span the block. Six span the values between the extremes, which the mode has exactly.
+    u8 alphas[2] = { maximum, minimum };
+    u8 indices[16];
+    u32 error = evaluate_alpha_block(texels, alphas[0], alphas[1], indices);
+    if (try_six_alpha && error > 0 && inner_minimum <= inner_maximum)
+    {
+        u8 six_indices[16];
+        if (evaluate_alpha_block(texels, inner_minimum, inner_maximum, six_indices) < error)
+        {
+            alphas[0] = inner_minimum;
+            alphas[1] = inner_maximum;
+            memory_system_copy(indices, six_indices, sizeof(indices));
+        }
+    }
+
+    u64 index_bits = 0;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        index_bits |= (u64)indices[i] << (i * 3);
+    }
+
+    block[0] = alphas[0];
+    block[1] = alphas[1];
+    for (u32 i = 0; i < 6; ++i)
+    {
+        block[2 + i] = (u8)(index_bits >> (i * 8));
+    }
+}
+
+void decode_alpha_block(u8 const* block, u8 texels[16][4])
+{
+    i32 palette[8];
+    alpha_palette(block[0], block[1], palette);
+
+    u64 index_bits = 0;
+    for (u32 i = 0; i < 6; ++i)
+    {
+        index_bits |= (u64)block[2 + i] << (i * 8);
+    }
+    for (u32 i = 0; i < 16; ++i)
+    {
+        texels[i][3] = (u8)palette[(index_bits >> (i * 3)) & 7];
+    }
+}
+
+void write_bits(u8 block[16], u32* position, u32 value, u32 count)
+{
+    for (u32 i = 0; i < count; ++i, ++*position)
+    {
+        block[*position >> 3] |= (u8)(((value >> i) & 1) << (*position & 7));
+    }
+}
+
+u32 read_bits(u8 const* block, u32* position, u32 count)
+{
+    u32 value = 0;
+    for (u32 i = 0; i < count; ++i, ++*position)
+    {
+        value |= (u32)((block[*position >> 3] >> (*position & 7)) & 1) << i;
+    }
+
+    return value;
+}
+
+u32 quantize_endpoint_mode6(f32 const value[4], u32 p_bit, u8 quantized[4])
+{
+    // Seven bits per channel with the p-bit appended make the eight bit endpoint.
+    u32 error = 0;
+    for (u32 c = 0; c < 4; ++c)
+    {
+        i32 q = (i32)((value[c] - (f32)p_bit) * 0.5f + 0.5f);
+        q = q < 0 ? 0 : q > 127 ? 127 : q;
+        quantized[c] = (u8)q;
+        i32 difference = (i32)(value[c] + 0.5f) - (q * 2 + (i32)p_bit);
+        error += (u32)(difference * difference);
+    }
+
+    return error;
+}
+
+u32 quantize_endpoint_mode1(f32 const value[4], u32 p_bit, u8 quantized[4])
+{
+    // Six bits per channel with the p-bit appended make seven, which expand to eight by repeating the top bit.
+    u32 error = 0;
+    for (u32 c = 0; c < 3; ++c)
+    {
+        i32 target = (i32)(value[c] + 0.5f);
+        i32 base = (i32)((value[c] * 127.0f / 255.0f - (f32)p_bit) * 0.5f + 0.5f);
+        u32 best_error = 0xFFFFFFFF;
+        for (i32 q = base - 1; q <= base + 1; ++q)
+        {
+            if (q < 0 || q > 63)
+            {
+                continue;
+            }
+
+            i32 difference = target - expand_mode1((u8)q, p_bit);
+            if ((u32)(difference * difference) < best_error)
+            {
+                best_error = (u32)(difference * difference);
+                quantized[c] = (u8)q;
+            }
+        }
+        error += best_error;
+    }
+
+    return error;
+}
+
+u8 expand_mode1(u8 quantized, u32 p_bit)
+{
+    u32 value = ((u32)quantized << 1) | p_bit;
+    return (u8)((value << 1) | (value >> 6));
+}
+
+u32 encode_mode6(u8 const texels[16][4], Block_Compression_Quality quality, u8 block[16])
+{
+    f32 points[16][4];
+    bool opaque = true;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        for (u32 c = 0; c < 4; ++c)
+        {
+            points[i][c] = texels[i][c];
+        }
+        opaque = opaque && texels[i][3] == 255;
+    }
+
+    f32 endpoints[2][4];
+    fit_endpoints(points, 16, 4, endpoints[0], endpoints[1]);
+
+    u32 refinements = refinement_count(quality);
+    u32 best_error = 0xFFFFFFFF;
+    u8 best_quantized[2][4];
+    u32 best_p_bits[2];
+    u8 best_indices[16];
+    for (u32 iteration = 0;; ++iteration)
+    {
+        // Each endpoint takes the p-bit closest to it, or every combination is tried at high quality. Opaque blocks
+        // keep both p-bits set, the only way the alpha endpoints reach 255 and the block stays opaque.
+        u32 combination_count = quality == BLOCK_COMPRESSION_QUALITY_HIGH && !opaque ? 4 : 1;
+        u32 closest_p_bits[2];
+        for (u32 e = 0; e < 2; ++e)
+        {
+            u8 scratch[4];
+            closest_p_bits[e] = quantize_endpoint_mode6(endpoints[e], 1, scratch) < quantize_endpoint_mode6(endpoints[e], 0, scratch);
+        }
+
+        u8 iteration_indices[16];
+        u32 iteration_error = 0xFFFFFFFF;
+        for (u32 combination = 0; combination < combination_count; ++combination)
+        {
+            u32 p_bits[2];
+            p_bits[0] = opaque ? 1 : combination_count == 1 ? closest_p_bits[0] : combination & 1;
+            p_bits[1] = opaque ? 1 : combination_count == 1 ? closest_p_bits[1] : combination >> 1;
+            u8 quantized[2][4];
+            quantize_endpoint_mode6(endpoints[0], p_bits[0], quantized[0]);
+            quantize_endpoint_mode6(endpoints[1], p_bits[1], quantized[1]);
+
+            i32 palette[16][4];
+            for (u32 entry = 0; entry < 16; ++entry)
+            {
+                for (u32 c = 0; c < 4; ++c)
+                {
+                    i32 e0 = quantized[0][c] * 2 + (i32)p_bits[0];
+                    i32 e1 = quantized[1][c] * 2 + (i32)p_bits[1];
+                    palette[entry][c] = ((64 - bc7_weights4[entry]) * e0 + bc7_weights4[entry] * e1 + 32) >> 6;
+                }
+            }
+
+            u8 indices[16];
+            u32 error = 0;
+            for (u32 i = 0; i < 16; ++i)
+            {
+                u32 nearest_error = 0xFFFFFFFF;
+                for (u32 entry = 0; entry < 16; ++entry)
+                {
+                    u32 entry_error = 0;
+                    for (u32 c = 0; c < 4; ++c)
+                    {
+                        i32 difference = (i32)texels[i][c] - palette[entry][c];
+                        entry_error += (u32)(difference * difference);
+                    }
+                    if (entry_error < nearest_error)
+                    {
+                        nearest_error = entry_error;
+                        indices[i] = (u8)entry;
+                    }
+                }
+                error += nearest_error;
+            }
+
+            if (error < iteration_error)
+            {
+                iteration_error = error;
+                memory_system_copy(iteration_indices, indices, sizeof(indices));
+            }
+            if (error < best_error)
+            {
+                best_error = error;
+                memory_system_copy(best_quantized, quantized, sizeof(quantized));
+                best_p_bits[0] = p_bits[0];
+                best_p_bits[1] = p_bits[1];
+                memory_system_copy(best_indices, indices, sizeof(indices));
+            }
+        }
+
+        if (iteration == refinements || best_error == 0)
+        {
+            break;
+        }
+
+        f32 weights[16];
+        for (u32 i = 0; i < 16; ++i)
+        {
+            weights[i] = bc7_weights4[iteration_indices[i]] / 64.0f;
+        }
+        refine_endpoints(points, weights, 16, 4, endpoints[0], endpoints[1]);
+    }
+
+    // The index of texel 0 is stored without its top bit, which swapping the endpoints clears.
+    if (best_indices[0] & 8)
+    {
+        u8 quantized[4];
+        memory_system_copy(quantized, best_quantized[0], sizeof(quantized));
+        memory_system_copy(best_quantized[0], best_quantized[1], sizeof(quantized));
+        memory_system_copy(best_quantized[1], quantized, sizeof(quantized));
+        u32 p_bit = best_p_bits[0];
+        best_p_bits[0] = best_p_bits[1];
+        best_p_bits[1] = p_bit;
+        for (u32 i = 0; i < 16; ++i)
+        {
+            best_indices[i] = 15 - best_indices[i];
+        }
+    }
+
+    memory_system_zero(block, 16);
+    u32 position = 0;
+    write_bits(block, &position, 1 << 6, 7);
+    for (u32 c = 0; c < 4; ++c)
+    {
+        write_bits(block, &position, best_quantized[0][c], 7);
+        write_bits(block, &position, best_quantized[1][c], 7);
+    }
+    write_bits(block, &position, best_p_bits[0], 1);
+    write_bits(block, &position, best_p_bits[1], 1);
+    for (u32 i = 0; i < 16; ++i)
+    {
+        write_bits(block, &position, best_indices[i], i == 0 ? 3 : 4);
+    }
+
+    return best_error;
+}
+
+u32 encode_mode1(u8 const texels[16][4], u32 partition, Block_Compression_Quality quality, u8 block[16])
+{
+    u16 mask = bc7_partitions[partition];
+    u8 anchors[2] = { 0, bc7_anchors[partition] };
+
+    f32 points[2][16][4];
+    u8 members[2][16];
+    u32 counts[2] = { 0, 0 };
+    for (u32 i = 0; i < 16; ++i)
+    {
+        u32 subset = (mask >> i) & 1;
+        for (u32 c = 0; c < 3; ++c)
+        {
+            points[subset][counts[subset]][c] = texels[i][c];
+        }
+        members[subset][counts[subset]++] = (u8)i;
+    }
+
+    u32 refinements = refinement_count(quality);
+    u32 total_error = 0;
+    u8 best_quantized[2][2][4];
+    u32 best_p_bits[2];
+    u8 indices[16];
+    for (u32 s = 0; s < 2; ++s)
+    {
+        f32 endpoints[2][4];
+        fit_endpoints(points[s], counts[s], 3, endpoints[0], endpoints[1]);
+
+        u32 best_error = 0xFFFFFFFF;
+        u8 best_indices[16];
+        for (u32 iteration = 0;; ++iteration)
+        {
+            // Both endpoints of a subset share one p-bit.
+            u8 scratch[4];
+            u32 shared_errors[2];
+            for (u32 p = 0; p < 2; ++p)
+            {
+                shared_errors[p] = quantize_endpoint_mode1(endpoints[0], p, scratch) + quantize_endpoint_mode1(endpoints[1], p, scratch);
+            }
+            u32 first_p = quality == BLOCK_COMPRESSION_QUALITY_HIGH ? 0 : shared_errors[1] < shared_errors[0];
+            u32 last_p = quality == BLOCK_COMPRESSION_QUALITY_HIGH ? 1 : first_p;
+
+            u8 iteration_indices[16];
+            u32 iteration_error = 0xFFFFFFFF;
+            for (u32 p = first_p; p <= last_p; ++p)
+            {
+                u8 quantized[2][4];
+                quantize_endpoint_mode1(endpoints[0], p, quantized[0]);
+                quantize_endpoint_mode1(endpoints[1], p, quantized[1]);
+
+                i32 expanded[2][3];
+                for (u32 c = 0; c < 3; ++c)
+                {
+                    expanded[0][c] = expand_mode1(quantized[0][c], p);
+                    expanded[1][c] = expand_mode1(quantized[1][c], p);
+                }
+
+                i32 palette[8][3];
+                for (u32 entry = 0; entry < 8; ++entry)
+                {
+                    for (u32 c = 0; c < 3; ++c)
+                    {
+                        palette[entry][c] = ((64 - bc7_weights3[entry]) * expanded[0][c] + bc7_weights3[entry] * expanded[1][c] + 32) >> 6;
+                    }
+                }
+
+                u8 subset_indices[16];
+                u32 error = 0;
+                for (u32 i = 0; i < counts[s]; ++i)
+                {
+                    u32 nearest_error = 0xFFFFFFFF;
+                    for (u32 entry = 0; entry < 8; ++entry)
+                    {
+                        u32 entry_error = 0;
+                        for (u32 c = 0; c < 3; ++c)
+                        {
+                            i32 difference = (i32)points[s][i][c] - palette[entry][c];
+                            entry_error += (u32)(difference * difference);
+                        }
+                        if (entry_error < nearest_error)
+                        {
+                            nearest_error = entry_error;
+                            subset_indices[i] = (u8)entry;
+                        }
+                    }
+                    error += nearest_error;
+                }
+
+                if (error < iteration_error)
+                {
+                    iteration_error = error;
+                    memory_system_copy(iteration_indices, subset_indices, sizeof(subset_indices));
+                }
+                if (error < best_error)
+                {
+                    best_error = error;
+                    memory_system_copy(best_quantized[s], quantized, sizeof(quantized));
+                    best_p_bits[s] = p;
+                    memory_system_copy(best_indices, subset_indices, sizeof(subset_indices));
+                }
+            }
+
+            if (iteration == refinements || best_error == 0)
+            {
+                break;
+            }
+
+            f32 weights[16];
+            for (u32 i = 0; i < counts[s]; ++i)
+            {
+                weights[i] = bc7_weights3[iteration_indices[i]] / 64.0f;
+            }
+            refine_endpoints(points[s], weights, counts[s], 3, endpoints[0], endpoints[1]);
+        }
+
+        // The anchor texel of each subset is stored without the top bit of its index, which swapping the endpoints clears.
+        bool swap = false;
+        for (u32 i = 0; i < counts[s]; ++i)
+        {
+            swap |= members[s][i] == anchors[s] && (best_indices[i] & 4);
+        }
+        if (swap)
+        {
+            u8 quantized[4];
+            memory_system_copy(quantized, best_quantized[s][0], sizeof(quantized));
+            memory_system_copy(best_quantized[s][0], best_quantized[s][1], sizeof(quantized));
+            memory_system_copy(best_quantized[s][1], quantized, sizeof(quantized));
+        }
+        for (u32 i = 0; i < counts[s]; ++i)
+        {
+            indices[members[s][i]] = swap ? 7 - best_indices[i] : best_indices[i];
+        }
+        total_error += best_error;
+    }
+
+    memory_system_zero(block, 16);
+    u32 position = 0;
+    write_bits(block, &position, 1 << 1, 2);
+    write_bits(block, &position, partition, 6);
+    for (u32 c = 0; c < 3; ++c)
+    {
+        for (u32 s = 0; s < 2; ++s)
+        {
+            write_bits(block, &position, best_quantized[s][0][c], 6);
+            write_bits(block, &position, best_quantized[s][1][c], 6);
+        }
+    }
+    write_bits(block, &position, best_p_bits[0], 1);
+    write_bits(block, &position, best_p_bits[1], 1);
+    for (u32 i = 0; i < 16; ++i)
+    {
+        write_bits(block, &position, indices[i], i == anchors[0] || i == anchors[1] ? 2 : 3);
+    }
+
+    return total_error;
+}
+
+f32 subset_residual(f32 const moments[10])
+{
+    // The spread of a subset off its principal axis, which a line of endpoints can't represent: the trace of its
+    // covariance less the largest eigenvalue.
+    if (moments[0] < 2.0f)
+    {
+        return 0.0f;
+    }
+
+    f32 covariance[3][3];
+    u32 product = 4;
+    for (u32 a = 0; a < 3; ++a)
+    {
+        for (u32 b = a; b < 3; ++b, ++product)
+        {
+            covariance[a][b] = moments[product] - moments[1 + a] * moments[1 + b] / moments[0];
+            covariance[b][a] = covariance[a][b];
+        }
+    }
+
+    u32 largest = 0;
+    for (u32 c = 1; c < 3; ++c)
+    {
+        largest = covariance[c][c] > covariance[largest][largest] ? c : largest;
+    }
+    f32 trace = covariance[0][0] + covariance[1][1] + covariance[2][2];
+    if (covariance[largest][largest] <= 0.0f)
+    {
+        return 0.0f;
+    }
+
+    f32 vector[3] = { covariance[0][largest], covariance[1][largest], covariance[2][largest] };
+    f32 next[3];
+    for (u32 iteration = 0; iteration < 4; ++iteration)
+    {
+        f32 magnitude = 0.0f;
+        for (u32 a = 0; a < 3; ++a)
+        {
+            next[a] = covariance[a][0] * vector[0] + covariance[a][1] * vector[1] + covariance[a][2] * vector[2];
+            magnitude = fabsf(next[a]) > magnitude ? fabsf(next[a]) : magnitude;
+        }
+        if (magnitude <= 0.0f)
+        {
+            return trace;
+        }
+        for (u32 a = 0; a < 3; ++a)
+        {
+            vector[a] = next[a] / magnitude;
+        }
+    }
+
+    // The Rayleigh quotient of the converged vector estimates the largest eigenvalue.
+    f32 numerator = 0.0f;
+    f32 denominator = 0.0f;
+    for (u32 a = 0; a < 3; ++a)
+    {
+        next[a] = covariance[a][0] * vector[0] + covariance[a][1] * vector[1] + covariance[a][2] * vector[2];
+        numerator += vector[a] * next[a];
+        denominator += vector[a] * vector[a];
+    }
+    f32 residual = trace - numerator / denominator;
+    return residual > 0.0f ? residual : 0.0f;
+}
+
+void encode_bc7_block(u8 const texels[16][4], Block_Compression_Quality quality, u8* block)
+{
+    u8 best[16];
+    u32 best_error = encode_mode6(texels, quality, best);
+
+    bool opaque = true;
+    for (u32 i = 0; i < 16; ++i)
+    {
+        opaque &= texels[i][3] == 255;
+    }
+
+    // Mode 1 has no alpha, and fits two colour lines where mode 6 fits one. The partitions whose subsets lie closest
+    // to a line are encoded in full.
+    if (opaque && best_error > 0 && quality != BLOCK_COMPRESSION_QUALITY_FAST)
+    {
+        // The count, sums and sums of products of each texel, so that a subset's are the sums over its texels and
+        // subset 0's are the block's less subset 1's.
+        f32 moments[16][10];
+        f32 block_moments[10] = {};
+        for (u32 i = 0; i < 16; ++i)
+        {
+            f32 r = texels[i][0];
+            f32 g = texels[i][1];
+            f32 b = texels[i][2];
+            f32 const texel_moments[10] = { 1.0f, r, g, b, r * r, r * g, r * b, g * g, g * b, b * b };
+            for (u32 m = 0; m < 10; ++m)
+            {
+                moments[i][m] = texel_moments[m];
+                block_moments[m] += texel_moments[m];
+            }
+        }
+
+        f32 residuals[BC7_PARTITION_COUNT];
+        for (u32 p = 0; p < BC7_PARTITION_COUNT; ++p)
+        {
+            f32 subset_moments[2][10] = {};
+            for (u32 i = 0; i < 16; ++i)
+            {
+                if ((bc7_partitions[p] >> i) & 1)
+                {
+                    for (u32 m = 0; m < 10; ++m)
+                    {
+                        subset_moments[1][m] += moments[i][m];
+                    }
+                }
+            }
+            for (u32 m = 0; m < 10; ++m)
+            {
+                subset_moments[0][m] = block_moments[m] - subset_moments[1][m];
+            }
+            residuals[p] = subset_residual(subset_moments[0]) + subset_residual(subset_moments[1]);
+        }
+
+        u32 candidate_count = quality == BLOCK_COMPRESSION_QUALITY_HIGH ? BC7_HIGH_PARTITION_COUNT : BC7_NORMAL_PARTITION_COUNT;
+        for (u32 candidate = 0; candidate < candidate_count; ++candidate)
+        {
+            u32 partition = 0;
+            for (u32 p = 1; p < BC7_PARTITION_COUNT; ++p)
+            {
+                partition = residuals[p] < residuals[partition] ? p : partition;
+            }
+            residuals[partition] = INFINITY;
+
+            u8 candidate_block[16];
+            u32 error = encode_mode1(texels, partition, quality, candidate_block);
+            if (error < best_error)
+            {
+                best_error = error;
+                memory_system_copy(best, candidate_block, sizeof(best));
+            }
+        }
+    }
+
+    memory_system_copy(block, best, sizeof(best));
+}
+
+void decode_bc7_block(u8 const* block, u8 texels[16][4])
+{
+    u32 position = 0;
+    if (block[0] & 0x40 && !(block[0] & 0x3F))
+    {
+        position = 7;
+        u8 endpoints[2][4];
+        for (u32 c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] = (u8)(read_bits(block, &position, 7) << 1);
+            endpoints[1][c] = (u8)(read_bits(block, &position, 7) << 1);
+        }
+        u32 p0 = read_bits(block, &position, 1);
+        u32 p1 = read_bits(block, &position, 1);
+        for (u32 c = 0; c < 4; ++c)
+        {
+            endpoints[0][c] |= p0;
+            endpoints[1][c] |= p1;
+        }
+
+        for (u32 i = 0; i < 16; ++i)
+        {
+            u32 weight = bc7_weights4[read_bits(block, &position, i == 0 ? 3 : 4)];
+            for (u32 c = 0; c < 4; ++c)
+            {
+                texels[i][c] = (u8)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+        }
+        return;
+    }
+
+    if ((block[0] & 3) == 2)
+    {
+        position = 2;
+        u32 partition = read_bits(block, &position, 6);
+        u8 quantized[2][2][3];
+        for (u32 c = 0; c < 3; ++c)
+        {
+            for (u32 s = 0; s < 2; ++s)
+            {
+                quantized[s][0][c] = (u8)read_bits(block, &position, 6);
+                quantized[s][1][c] = (u8)read_bits(block, &position, 6);
+            }
+        }
+        u32 p_bits[2];
+        p_bits[0] = read_bits(block, &position, 1);
+        p_bits[1] = read_bits(block, &position, 1);
+
+        for (u32 i = 0; i < 16; ++i)
+        {
+            u32 subset = (bc7_partitions[partition] >> i) & 1;
+            bool anchor = i == 0 || i == bc7_anchors[partition];
+            u32 weight = bc7_weights3[read_bits(block, &position, anchor ? 2 : 3)];
+            for (u32 c = 0; c < 3; ++c)
+            {
+                u32 e0 = expand_mode1(quantized[subset][0][c], p_bits[subset]);
+                u32 e1 = expand_mode1(quantized[subset][1][c], p_bits[subset]);
+                texels[i][c] = (u8)(((64 - weight) * e0 + weight * e1 + 32) >> 6);
+            }
+            texels[i][3] = 255;
+        }
+        return;
+    }
+
+    for (u32 i = 0; i < 16; ++i)
+    {
+        texels[i][0] = 255;
+        texels[i][1] = 0;
+        texels[i][2] = 255;
+        texels[i][3] = 255;
+    }
+}
+
+bool block_has_transparency(u8 const* block, Texture_Format format)
+{
+    if (format == TEXTURE_FORMAT_BC1)
+    {
+        // Only the 3-colour mode has a transparent index, and only if a texel uses it.
+        u16 color0 = (u16)(block[0] | (block[1] << 8));
+        u16 color1 = (u16)(block[2] | (block[3] << 8));
+        u32 index_bits = block[4] | (block[5] << 8) | (block[6] << 16) | ((u32)block[7] << 24);
+        for (u32 i = 0; color0 <= color1 && i < 16; ++i)
+        {
+            if (((index_bits >> (i * 2)) & 3) == 3)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (format == TEXTURE_FORMAT_BC3)
+    {
+        // Any endpoint under 255 is taken as used; the 6-alpha mode adds a 0 at index 6.
+        if (block[0] < 255 || block[1] < 255)
+        {
+            return true;
+        }
+
+        u64 index_bits = 0;
+        for (u32 i = 0; i < 6; ++i)
+        {
+            index_bits |= (u64)block[2 + i] << (i * 8);
+        }
+        for (u32 i = 0; block[0] <= block[1] && i < 16; ++i)
+        {
+            if (((index_bits >> (i * 3)) & 7) == 6)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Modes 0 to 3 are opaque; 4, 5 and 7 carry alpha but aren't decoded.
+    u32 mode = bc7_mode(block);
+    if (mode < 4)
+    {
+        return false;
+    }
+    if (mode != 6)
+    {
+        return true;
+    }
+
+    u8 texels[16][4];
+    decode_bc7_block(block, texels);
+    for (u32 i = 0; i < 16; ++i)
+    {
+        if (texels[i][3] < 255)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief The mode of a BC7 block is the index of the lowest set bit of its first byte. A block without one is reserved, mode 8.
+ */
+u32 bc7_mode(u8 const* block)
+{
+    u32 mode = 0;
+    while (mode < 8 && !(block[0] & (1 << mode)))
+    {
+        ++mode;
+    }
+
+    return mode;
+}
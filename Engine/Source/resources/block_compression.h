@@ -0,0 +1,95 @@
+#pragma once
+
+#include "defines.h"
+#include "resources/cooked_format.h"
+#include "resources/resource_types.h"
+
+/**
+ * CPU encoders and decoders for the BC1, BC3 and BC7 block formats, which store 4x4 texels in 8 or 16 bytes.
+ * Texels are encoded as they are, so sRGB images stay sRGB encoded. Blocks over the right and bottom edges of a level
+ * repeat its edge texels.
+ * Encoding is split into bands of block rows that run on the job system; without one everything runs on the calling
+ * thread. Nothing is allocated, so the cook tool can use the encoders without the memory system.
+ */
+
+/**
+ * @brief How hard the encoders search for the best endpoints.
+ */
+typedef enum Block_Compression_Quality
+{
+    /** @brief Endpoints along the principal axis of each block. BC7 uses mode 6 only. Meant for load time. */
+    BLOCK_COMPRESSION_QUALITY_FAST,
+    /** @brief Refines the endpoints once by least squares. BC7 also tries mode 1 with the 8 most promising partitions of opaque blocks. */
+    BLOCK_COMPRESSION_QUALITY_NORMAL,
+    /** @brief Refines the endpoints three times and tries every p-bit. BC7 tries mode 1 with the 16 most promising partitions. Meant for the cook tool. */
+    BLOCK_COMPRESSION_QUALITY_HIGH
+} Block_Compression_Quality;
+
+/**
+ * @return The bytes per 4x4 block of _format_, or 0 for RGBA8.
+ */
+LIB_API u32 block_compression_block_size(Texture_Format format);
+
+/**
+ * @return The size of a width x height level of _format_.
+ */
+LIB_API u64 block_compression_level_size(Texture_Format format, u32 width, u32 height);
+
+/**
+ * @brief Copies the width x height rectangle at _x_, _y_ of a level of _format_ that is _level_width_ texels wide into
+ * _destination_, tightly packed like a level of its own. With block formats the rectangle starts on a block boundary.
+ * @return The bytes written, which is block_compression_level_size of the rectangle.
+ */
+LIB_API u64 block_compression_copy_region(Texture_Format format, u8 const* level, u32 level_width, u32 x, u32 y, u32 width, u32 height, u8* destination);
+
+/**
+ * @brief Lays out a mip chain of _format_ like mip_chain_layout, which it matches for RGBA8: the same levels, each
+ * sized for the format and aligned to MIP_ALIGNMENT.
+ * @return The number of levels.
+ */
+LIB_API u32 block_compression_layout(Texture_Format format, u32 width, u32 height, u64 offset, Cooked_Mip* mips);
+
+/**
+ * @return The size of the first _mip_count_ levels of a chain of _format_ laid out from offset 0.
+ */
+LIB_API u64 block_compression_chain_size(Texture_Format format, u32 width, u32 height, u32 mip_count);
+
+/**
+ * @brief The format RGBA8 images are compressed to when _requested_ is asked for. BC1 only keeps 1-bit alpha, so
+ * images with transparency get BC3 instead.
+ */
+LIB_API Texture_Format block_compression_choose_format(Texture_Format requested, bool has_transparency);
+
+/**
+ * @brief Encodes the first _mip_count_ levels of an RGBA8 chain laid out by mip_chain_layout from offset 0 into a
+ * chain of _format_ laid out by block_compression_layout from offset 0. The levels are encoded in parallel.
+ * _blocks_ is only written, so it may be write-combined memory.
+ * @param format BC1, BC3 or BC7.
+ */
+LIB_API void block_compression_encode(u8 const* chain, u32 width, u32 height, u32 mip_count, Texture_Format format, Block_Compression_Quality quality, u8* blocks);
+
+/**
+ * @brief Checks that the first _mip_count_ levels of a chain of _format_ can be decoded. BC7 blocks are only decoded
+ * in the modes the encoder writes, 1 and 6, so a BC7 chain from another encoder may not be.
+ * @return TRUE if every block can be decoded; otherwise FALSE
+ */
+LIB_API bool block_compression_can_decode(u8 const* blocks, u32 width, u32 height, u32 mip_count, Texture_Format format);
+
+/**
+ * @brief Decodes the first _mip_count_ levels of a chain of _format_ into an RGBA8 chain laid out by mip_chain_layout.
+ * Check the chain with block_compression_can_decode first; blocks it rejects decode to opaque magenta.
+ */
+LIB_API void block_compression_decode(u8 const* blocks, u32 width, u32 height, u32 mip_count, Texture_Format format, u8* chain);
+
+/**
+ * @brief Scans a width x height level of _format_ for texels with alpha under 255 without decoding it to memory.
+ * BC7 blocks in modes the decoder doesn't cover count as transparent if their mode can carry alpha.
+ * @param format BC1, BC3 or BC7.
+ */
+LIB_API bool block_compression_has_transparency(u8 const* blocks, u32 width, u32 height, Texture_Format format);
+
+/**
+ * @return The peak signal to noise ratio in dB of _pixels_ against _reference_ over all four channels of
+ * _pixel_count_ RGBA8 pixels, or 999 if they are identical.
+ */
+LIB_API f64 block_compression_psnr(u8 const* reference, u8 const* pixels, u64 pixel_count);
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * On-disk layout of cooked assets, written by the cook tool and preferred by the loaders over the source files.
+ * The cooked form of the asset "textures/paving.png" is "cooked/textures/paving.png.ck" (see COOKED_PATH_FORMAT).
+ * Every cooked file starts with a Cooked_Header. Textures follow it with a Cooked_Texture and the pixels; configs
+ * have a payload holding their fixed-layout struct, which the loaders hand out in place from the mapping.
+ * All structs are naturally aligned and free of pointers, so nothing is parsed at load time.
+ */
+
+#define COOKED_MAGIC 0x4B4F4F43 // "COOK"
+/** @brief Bumped whenever a layout or a cooking step changes, which makes the cook tool redo every asset. */
+#define COOKED_VERSION 4
+#define COOKED_PATH_FORMAT "cooked/%s.ck"
+/** @brief Alignment of payloads from the start of the file. SPIR-V needs 4 bytes, SIMD copies of pixel rows 16. */
+#define COOKED_PAYLOAD_ALIGNMENT 64
+
+typedef enum Cooked_Type
+{
+    COOKED_TYPE_TEXTURE,
+    COOKED_TYPE_MATERIAL,
+    COOKED_TYPE_SPIRV,
+    COOKED_TYPE_SHADER_CONFIG
+} Cooked_Type;
+
+typedef struct Cooked_Header
+{
+    u32 magic;
+    u32 version;
+    u32 type;
+    u32 reserved;
+    /** @brief hash_bytes of the source file. The cook tool skips sources whose hash hasn't changed. */
+    u64 source_hash;
+    u64 payload_offset;
+    u64 payload_size;
+} Cooked_Header;
+
+#define COOKED_TEXTURE_MAX_MIPS 16
+
+typedef enum Cooked_Texture_Format
+{
+    /** @brief Tightly packed 8-bit sRGB RGBA. */
+    COOKED_TEXTURE_FORMAT_RGBA8,
+    /** @brief 4x4 blocks of sRGB texels, 8 bytes each, with 1-bit alpha. */
+    COOKED_TEXTURE_FORMAT_BC1,
+    /** @brief 4x4 blocks of sRGB texels, 16 bytes each, with interpolated alpha. */
+    COOKED_TEXTURE_FORMAT_BC3,
+    /** @brief 4x4 blocks of sRGB texels, 16 bytes each, with partitioned endpoints. */
+    COOKED_TEXTURE_FORMAT_BC7
+} Cooked_Texture_Format;
+
+typedef enum Cooked_Texture_Flags
+{
+    /** @brief At least one texel has an alpha below 255. */
+    COOKED_TEXTURE_FLAG_TRANSPARENT = 0x1
+} Cooked_Texture_Flags;
+
+typedef struct Cooked_Mip
+{
+    /** @brief Offset from the start of the file. */
+    u64 offset;
+    u64 size;
+    u32 width;
+    u32 height;
+} Cooked_Mip;
+
+/**
+ * @brief A texture with its full mip chain, largest level first. The payload holds every level.
+ */
+typedef struct Cooked_Texture
+{
+    Cooked_Header header;
+    u32 width;
+    u32 height;
+    u32 format;
+    u32 flags;
+    u32 channel_count;
+    u32 mip_count;
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+} Cooked_Texture;
+
+#define COOKED_NAME_MAX_LENGTH 128
+
+typedef enum Cooked_Material_Type
+{
+    COOKED_MATERIAL_TYPE_WORLD,
+    COOKED_MATERIAL_TYPE_UI
+} Cooked_Material_Type;
+
+/**
+ * @brief A material config, cooked from materials/<name>.json. Used at runtime as Material_Config_Resource.
+ */
+typedef struct Cooked_Material
+{
+    char version[8];
+    char name[COOKED_NAME_MAX_LENGTH];
+    char diffuse_texture_name[COOKED_NAME_MAX_LENGTH];
+    f32 diffuse_color[4];
+    /** @brief A Cooked_Material_Type. The values match Material_Type. */
+    u32 type;
+    u32 auto_release;
+} Cooked_Material;
+
+#define COOKED_SHADER_NAME_LENGTH 32
+#define COOKED_SHADER_BINARY_NAME_LENGTH 64
+#define COOKED_SHADER_MAX_STAGES 4
+#define COOKED_SHADER_MAX_ATTRIBUTES 16
+#define COOKED_SHADER_MAX_UNIFORMS 32
+
+typedef enum Cooked_Shader_Stage
+{
+    COOKED_SHADER_STAGE_VERTEX,
+    COOKED_SHADER_STAGE_FRAGMENT
+} Cooked_Shader_Stage;
+
+typedef enum Cooked_Attribute_Type
+{
+    COOKED_ATTRIBUTE_TYPE_VEC2,
+    COOKED_ATTRIBUTE_TYPE_VEC3,
+    COOKED_ATTRIBUTE_TYPE_VEC4
+} Cooked_Attribute_Type;
+
+typedef enum Cooked_Uniform_Type
+{
+    COOKED_UNIFORM_TYPE_VEC4,
+    COOKED_UNIFORM_TYPE_MAT4,
+    COOKED_UNIFORM_TYPE_SAMPLER
+} Cooked_Uniform_Type;
+
+typedef struct Cooked_Shader_Stage_Config
+{
+    /** @brief A Cooked_Shader_Stage. */
+    u32 stage;
+    /** @brief File name of the SPIR-V module, relative to shaders/spirv. */
+    char spv_binary[COOKED_SHADER_BINARY_NAME_LENGTH];
+} Cooked_Shader_Stage_Config;
+
+typedef struct Cooked_Vertex_Attribute
+{
+    char name[COOKED_SHADER_NAME_LENGTH];
+    /** @brief A Cooked_Attribute_Type. */
+    u32 type;
+    u32 size;
+} Cooked_Vertex_Attribute;
+
+typedef struct Cooked_Uniform
+{
+    char name[COOKED_SHADER_NAME_LENGTH];
+    /** @brief A Cooked_Uniform_Type. */
+    u32 type;
+    /** @brief Size in bytes; 0 for samplers. */
+    u32 size;
+    /** @brief Index of the uniform group in the config, which is its Descriptor_Set_Scope. */
+    u32 scope;
+} Cooked_Uniform;
+
+/**
+ * @brief A shader config, cooked from shaders/<name>_config.json. Used at runtime as Shader_Config_Resource.
+ */
+typedef struct Cooked_Shader_Config
+{
+    char name[COOKED_SHADER_NAME_LENGTH];
+    char renderpass_name[COOKED_SHADER_NAME_LENGTH];
+    u32 stage_count;
+    Cooked_Shader_Stage_Config stages[COOKED_SHADER_MAX_STAGES];
+    u32 attribute_count;
+    Cooked_Vertex_Attribute attributes[COOKED_SHADER_MAX_ATTRIBUTES];
+    u32 uniform_count;
+    Cooked_Uniform uniforms[COOKED_SHADER_MAX_UNIFORMS];
+    u32 per_material;
+    u32 per_object;
+    u32 max_descriptor_set_count;
+} Cooked_Shader_Config;
+
+/**
+ * @brief Returns the header of a mapped cooked file if it is intact, of the expected type and of the current version; otherwise 0.
+ * Files from an older cook are ignored, so the loaders fall back to the source files until the assets are recooked.
+ */
+static inline Cooked_Header const* cooked_validate(void const* data, u64 size, Cooked_Type type, u64 struct_size)
+{
+    Cooked_Header const* header = data;
+    if (!data || size < struct_size || struct_size < sizeof(*header))
+    {
+        return 0;
+    }
+
+    if (header->magic != COOKED_MAGIC || header->version != COOKED_VERSION || header->type != (u32)type)
+    {
+        return 0;
+    }
+
+    if (header->payload_offset > size || header->payload_size > size - header->payload_offset)
+    {
+        return 0;
+    }
+
+    return header;
+}
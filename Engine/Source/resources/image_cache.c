@@ -0,0 +1,306 @@
+#include "image_cache.h"
+
+#include "core/hash.h"
+#include "core/logger.h"
+#include "core/string_utils.h"
+#include "platform/platform.h"
+#include "resources/cooked_format.h"
+#include "resources/image_kernels.h"
+#include "resources/mip_chain.h"
+#include "systems/memory_system.h"
+
+#include <stdio.h>
+
+#define IMAGE_CACHE_MAGIC 0x43474D49 // "IMGC"
+/** @brief Bumped whenever decoding or the record layout changes, which invalidates every entry. */
+#define IMAGE_CACHE_VERSION 2
+#define IMAGE_CACHE_PATH_LENGTH 256
+
+/**
+ * @brief Everything besides the source contents that affects an entry. Hashed into its key.
+ */
+typedef struct Decode_Parameters
+{
+    u32 cache_version;
+    u32 cooked_version;
+    u32 format;
+    u32 generate_mips;
+    u32 mip_filter;
+} Decode_Parameters;
+
+/**
+ * @brief What a source file looked like when it was cached, stored at <directory>/<path hash>.src.
+ */
+typedef struct Path_Record
+{
+    u32 magic;
+    u32 version;
+    u64 source_size;
+    u64 modified_time;
+    u64 source_hash;
+    char disk_path[IMAGE_CACHE_PATH_LENGTH];
+} Path_Record;
+
+typedef struct Image_Cache_State
+{
+    Image_Cache_Config config;
+    char directory[IMAGE_CACHE_PATH_LENGTH];
+    Decode_Parameters parameters;
+    // Makes temporary file names unique across threads.
+    i64 volatile temporary_count;
+    Image_Cache_Stats stats;
+} Image_Cache_State;
+
+static Image_Cache_State state_storage;
+static Image_Cache_State* state;
+
+static bool find_entry(u64 source_hash, File_View* view);
+static void entry_path(u64 source_hash, char* path);
+static void record_path(char const* disk_path, char* path);
+static bool write_file(char const* path, void const* data, u64 size);
+static bool map_if_exists(char const* path, File_View* view);
+
+bool image_cache_startup(Image_Cache_Config config)
+{
+    if (!config.directory || string_length(config.directory) >= IMAGE_CACHE_PATH_LENGTH - 64)
+    {
+        LOG_ERROR("image_cache_startup: Invalid input parameters");
+        return false;
+    }
+
+    if (!filesystem_create_directories(config.directory))
+    {
+        LOG_WARNING("image_cache_startup: Failed to create '%s'. Images are decoded without a cache", config.directory);
+        return false;
+    }
+
+    memory_system_zero(&state_storage, sizeof(state_storage));
+    state = &state_storage;
+    state->config = config;
+    string_copy(state->directory, config.directory);
+    state->config.directory = state->directory;
+    state->parameters.cache_version = IMAGE_CACHE_VERSION;
+    state->parameters.cooked_version = COOKED_VERSION;
+    state->parameters.format = COOKED_TEXTURE_FORMAT_RGBA8;
+    state->parameters.generate_mips = config.generate_mips;
+    state->parameters.mip_filter = config.generate_mips ? config.mip_filter : 0;
+    return true;
+}
+
+void image_cache_shutdown()
+{
+    if (!state)
+    {
+        return;
+    }
+
+    LOG_INFO("Image cache: %lld path hits, %lld content hits, %lld misses, %lld stores",
+        state->stats.path_hits, state->stats.content_hits, state->stats.misses, state->stats.stores);
+    state = 0;
+}
+
+bool image_cache_is_enabled()
+{
+    return state != 0;
+}
+
+bool image_cache_find_by_path(char const* disk_path, File_View* view)
+{
+    if (!state || !disk_path || string_length(disk_path) >= IMAGE_CACHE_PATH_LENGTH)
+    {
+        return false;
+    }
+
+    u64 source_size;
+    u64 modified_time;
+    if (!filesystem_stat(disk_path, &source_size, &modified_time))
+    {
+        return false;
+    }
+
+    char path[IMAGE_CACHE_PATH_LENGTH];
+    record_path(disk_path, path);
+    File_View record_view;
+    if (!map_if_exists(path, &record_view))
+    {
+        return false;
+    }
+
+    // The path is compared too, so that colliding path hashes don't share a record.
+    Path_Record const* record = record_view.data;
+    bool unchanged = record_view.size == sizeof(*record) && record->magic == IMAGE_CACHE_MAGIC &&
+        record->version == IMAGE_CACHE_VERSION && record->source_size == source_size &&
+        record->modified_time == modified_time && string_equal(record->disk_path, disk_path);
+    u64 source_hash = unchanged ? record->source_hash : 0;
+    filesystem_unmap(&record_view);
+
+    if (!unchanged || !find_entry(source_hash, view))
+    {
+        return false;
+    }
+
+    platform_atomic_add(&state->stats.path_hits, 1);
+    return true;
+}
+
+bool image_cache_find(u64 source_hash, File_View* view)
+{
+    if (!state || !view)
+    {
+        return false;
+    }
+
+    bool found = find_entry(source_hash, view);
+    platform_atomic_add(found ? &state->stats.content_hits : &state->stats.misses, 1);
+    return found;
+}
+
+bool image_cache_store(u64 source_hash, u8 const* pixels, u32 width, u32 height, File_View* view)
+{
+    if (!state || !pixels || !view || width == 0 || height == 0)
+    {
+        return false;
+    }
+
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS] = {};
+    u64 payload_offset = (sizeof(Cooked_Texture) + COOKED_PAYLOAD_ALIGNMENT - 1) & ~(u64)(COOKED_PAYLOAD_ALIGNMENT - 1);
+    u32 mip_count = mip_chain_layout(width, height, payload_offset, mips);
+    if (!state->config.generate_mips)
+    {
+        mip_count = 1;
+    }
+
+    u64 size = mips[mip_count - 1].offset + mips[mip_count - 1].size;
+    u8* data = memory_system_allocate(size, MEMORY_TAG_RESOURCES);
+    memory_system_zero(data, sizeof(Cooked_Texture));
+
+    Cooked_Texture* texture = (Cooked_Texture*)data;
+    texture->header.magic = COOKED_MAGIC;
+    texture->header.version = COOKED_VERSION;
+    texture->header.type = COOKED_TYPE_TEXTURE;
+    texture->header.source_hash = source_hash;
+    texture->header.payload_offset = payload_offset;
+    texture->header.payload_size = size - payload_offset;
+    texture->width = width;
+    texture->height = height;
+    texture->format = COOKED_TEXTURE_FORMAT_RGBA8;
+    texture->channel_count = 4;
+    texture->mip_count = mip_count;
+    memory_system_copy(texture->mips, mips, mip_count * sizeof(mips[0]));
+    memory_system_copy(data + mips[0].offset, pixels, mips[0].size);
+
+    if (image_kernels_has_transparency(pixels, (u64)width * height))
+    {
+        texture->flags |= COOKED_TEXTURE_FLAG_TRANSPARENT;
+    }
+
+    mip_chain_generate(data, mips, mip_count, state->config.mip_filter);
+
+    char path[IMAGE_CACHE_PATH_LENGTH];
+    entry_path(source_hash, path);
+    bool written = write_file(path, data, size);
+    memory_system_free(data, size, MEMORY_TAG_RESOURCES);
+    if (!written || !filesystem_map(path, view))
+    {
+        LOG_WARNING("image_cache_store: Failed to write '%s'", path);
+        return false;
+    }
+
+    platform_atomic_add(&state->stats.stores, 1);
+    return true;
+}
+
+void image_cache_record_path(char const* disk_path, u64 source_hash)
+{
+    if (!state || !disk_path || string_length(disk_path) >= IMAGE_CACHE_PATH_LENGTH)
+    {
+        return;
+    }
+
+    Path_Record record = {};
+    record.magic = IMAGE_CACHE_MAGIC;
+    record.version = IMAGE_CACHE_VERSION;
+    record.source_hash = source_hash;
+    string_copy(record.disk_path, disk_path);
+    if (!filesystem_stat(disk_path, &record.source_size, &record.modified_time))
+    {
+        return;
+    }
+
+    char path[IMAGE_CACHE_PATH_LENGTH];
+    record_path(disk_path, path);
+    if (!write_file(path, &record, sizeof(record)))
+    {
+        LOG_WARNING("image_cache_record_path: Failed to write '%s'", path);
+    }
+}
+
+void image_cache_get_stats(Image_Cache_Stats* stats)
+{
+    if (state && stats)
+    {
+        *stats = state->stats;
+    }
+}
+
+bool find_entry(u64 source_hash, File_View* view)
+{
+    char path[IMAGE_CACHE_PATH_LENGTH];
+    entry_path(source_hash, path);
+    if (!map_if_exists(path, view))
+    {
+        return false;
+    }
+
+    Cooked_Header const* header = cooked_validate(view->data, view->size, COOKED_TYPE_TEXTURE, sizeof(Cooked_Texture));
+    if (!header || header->source_hash != source_hash)
+    {
+        LOG_WARNING("image_cache_find: Ignoring the invalid entry '%s'", path);
+        filesystem_unmap(view);
+        return false;
+    }
+
+    return true;
+}
+
+void entry_path(u64 source_hash, char* path)
+{
+    u64 key = hash_bytes(&state->parameters, sizeof(state->parameters), source_hash);
+    string_format(path, "%s/%016llx.img", state->directory, key);
+}
+
+void record_path(char const* disk_path, char* path)
+{
+    u64 key = hash_bytes(disk_path, string_length(disk_path), IMAGE_CACHE_VERSION);
+    string_format(path, "%s/%016llx.src", state->directory, key);
+}
+
+bool write_file(char const* path, void const* data, u64 size)
+{
+    // Written aside and renamed into place, so that readers never map a partial file.
+    char temporary_path[IMAGE_CACHE_PATH_LENGTH + 32];
+    string_format(temporary_path, "%s.%lld.tmp", path, platform_atomic_add(&state->temporary_count, 1));
+
+    File_Handle file;
+    if (!filesystem_open(temporary_path, FILE_ACCESS_MODE_WRITE_BINARY, &file))
+    {
+        return false;
+    }
+
+    bool result = filesystem_write(&file, size, data);
+    filesystem_close(&file);
+    result = result && filesystem_replace(temporary_path, path);
+    if (!result)
+    {
+        remove(temporary_path);
+    }
+
+    return result;
+}
+
+bool map_if_exists(char const* path, File_View* view)
+{
+    // Checked first, since filesystem_map reports missing files as errors and misses are expected.
+    u64 size;
+    return filesystem_size_of(path, &size) && size > 0 && filesystem_map(path, view);
+}
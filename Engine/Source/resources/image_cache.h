@@ -0,0 +1,66 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+#include "resources/mip_chain.h"
+
+/**
+ * On-disk cache of decoded images, so that source images are decoded once rather than on every run.
+ * Entries have the layout of a cooked texture (see resources/cooked_format.h) and are mapped in place. They are keyed
+ * by the hash_bytes of the source file combined with the decode parameters, and live at <directory>/<key>.img.
+ * A small record per source file, <directory>/<path hash>.src, remembers the size, modification time and hash the
+ * file had when it was cached. While the size and time are unchanged the entry is found without reading the source;
+ * otherwise the source is hashed and looked up by content.
+ */
+
+typedef struct Image_Cache_Config
+{
+    /** @brief Where entries are stored. Created if missing. */
+    char const* directory;
+    /** @brief Stores the full mip chain with every entry instead of level 0 only. Part of the key. */
+    bool generate_mips;
+    /** @brief The filter of the generated levels. Part of the key. */
+    Mip_Filter mip_filter;
+} Image_Cache_Config;
+
+typedef struct Image_Cache_Stats
+{
+    /** @brief Entries found through the size and modification time of the source, without reading it. */
+    i64 volatile path_hits;
+    /** @brief Entries found by hashing the source. */
+    i64 volatile content_hits;
+    i64 volatile misses;
+    i64 volatile stores;
+} Image_Cache_Stats;
+
+LIB_API bool image_cache_startup(Image_Cache_Config config);
+LIB_API void image_cache_shutdown();
+
+/**
+ * @brief Indicates if the cache was started. Every other function fails while it isn't.
+ */
+LIB_API bool image_cache_is_enabled();
+
+/**
+ * @brief Maps the entry of the source file at _disk_path_ if the file is unchanged since it was recorded.
+ * @param view Receives the mapping, to be released with filesystem_unmap.
+ */
+LIB_API bool image_cache_find_by_path(char const* disk_path, File_View* view);
+
+/**
+ * @brief Maps the entry of the source file whose contents have the given hash_bytes.
+ */
+LIB_API bool image_cache_find(u64 source_hash, File_View* view);
+
+/**
+ * @brief Writes an entry for tightly packed RGBA8 pixels decoded from a source with the given hash, and maps it.
+ * Concurrent stores of the same entry are safe; the last one wins.
+ */
+LIB_API bool image_cache_store(u64 source_hash, u8 const* pixels, u32 width, u32 height, File_View* view);
+
+/**
+ * @brief Remembers that the source file at _disk_path_ currently has the given hash, for image_cache_find_by_path.
+ */
+LIB_API void image_cache_record_path(char const* disk_path, u64 source_hash);
+
+LIB_API void image_cache_get_stats(Image_Cache_Stats* stats);
@@ -0,0 +1,892 @@
+#include "image_kernels.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <immintrin.h>
+#define IMAGE_KERNELS_SSE2
+#define IMAGE_KERNELS_AVX2
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define IMAGE_KERNELS_NEON
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// AVX2 kernels are compiled for AVX2 on their own and only called when the CPU has it.
+#if defined(IMAGE_KERNELS_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#else
+#define AVX2_FUNCTION
+#endif
+
+// linear_to_srgb looks colour up by the top bits of the float. Values below 2^-13 encode to 0, so the table covers
+// [2^-13, 1] with 2^10 entries per power of two.
+#define LINEAR_TO_SRGB_MIN 0x39000000u
+#define LINEAR_TO_SRGB_MAX 0x3F800000u
+#define LINEAR_TO_SRGB_SHIFT 13
+#define LINEAR_TO_SRGB_TABLE_SIZE (((LINEAR_TO_SRGB_MAX - LINEAR_TO_SRGB_MIN) >> LINEAR_TO_SRGB_SHIFT) + 1)
+
+typedef struct Image_Kernels
+{
+    bool (* has_transparency)(u8 const* pixels, u64 pixel_count);
+    void (* rgb_to_rgba)(u8 const* source, u8* destination, u64 pixel_count);
+    void (* linear_to_srgb)(f32 const* source, u8* destination, u64 pixel_count);
+    void (* premultiply_alpha)(u8* pixels, u64 pixel_count);
+    void (* swizzle)(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4]);
+    void (* blend_rows)(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count);
+    void (* downsample_row)(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count);
+} Image_Kernels;
+
+static Image_Kernels const* get_kernels();
+static bool is_supported(Image_Kernels_Isa isa);
+static bool cpu_has_avx2();
+static f32 const* srgb_to_linear_table();
+static u8 const* linear_to_srgb_table();
+static u8 encode_srgb(u8 const* table, f32 value);
+static u8 encode_alpha(f32 value);
+
+static bool has_transparency_scalar(u8 const* pixels, u64 pixel_count);
+static void rgb_to_rgba_scalar(u8 const* source, u8* destination, u64 pixel_count);
+static void linear_to_srgb_scalar(f32 const* source, u8* destination, u64 pixel_count);
+static void premultiply_alpha_scalar(u8* pixels, u64 pixel_count);
+static void swizzle_scalar(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4]);
+static void blend_rows_scalar(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count);
+static void downsample_row_scalar(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count);
+
+static Image_Kernels const scalar_kernels = {
+    has_transparency_scalar,
+    rgb_to_rgba_scalar,
+    linear_to_srgb_scalar,
+    premultiply_alpha_scalar,
+    swizzle_scalar,
+    blend_rows_scalar,
+    downsample_row_scalar
+};
+
+#ifdef IMAGE_KERNELS_SSE2
+static bool has_transparency_sse2(u8 const* pixels, u64 pixel_count);
+static void rgb_to_rgba_sse2(u8 const* source, u8* destination, u64 pixel_count);
+static void linear_to_srgb_sse2(f32 const* source, u8* destination, u64 pixel_count);
+static void premultiply_alpha_sse2(u8* pixels, u64 pixel_count);
+static void swizzle_sse2(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4]);
+static void blend_rows_sse2(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count);
+static void downsample_row_sse2(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count);
+
+static Image_Kernels const sse2_kernels = {
+    has_transparency_sse2,
+    rgb_to_rgba_sse2,
+    linear_to_srgb_sse2,
+    premultiply_alpha_sse2,
+    swizzle_sse2,
+    blend_rows_sse2,
+    downsample_row_sse2
+};
+#endif
+
+#ifdef IMAGE_KERNELS_AVX2
+static bool has_transparency_avx2(u8 const* pixels, u64 pixel_count);
+static void rgb_to_rgba_avx2(u8 const* source, u8* destination, u64 pixel_count);
+static void linear_to_srgb_avx2(f32 const* source, u8* destination, u64 pixel_count);
+static void premultiply_alpha_avx2(u8* pixels, u64 pixel_count);
+static void swizzle_avx2(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4]);
+static void blend_rows_avx2(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count);
+static void downsample_row_avx2(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count);
+
+static Image_Kernels const avx2_kernels = {
+    has_transparency_avx2,
+    rgb_to_rgba_avx2,
+    linear_to_srgb_avx2,
+    premultiply_alpha_avx2,
+    swizzle_avx2,
+    blend_rows_avx2,
+    downsample_row_avx2
+};
+#endif
+
+#ifdef IMAGE_KERNELS_NEON
+static bool has_transparency_neon(u8 const* pixels, u64 pixel_count);
+static void rgb_to_rgba_neon(u8 const* source, u8* destination, u64 pixel_count);
+static void linear_to_srgb_neon(f32 const* source, u8* destination, u64 pixel_count);
+static void premultiply_alpha_neon(u8* pixels, u64 pixel_count);
+static void swizzle_neon(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4]);
+static void blend_rows_neon(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count);
+static void downsample_row_neon(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count);
+
+static Image_Kernels const neon_kernels = {
+    has_transparency_neon,
+    rgb_to_rgba_neon,
+    linear_to_srgb_neon,
+    premultiply_alpha_neon,
+    swizzle_neon,
+    blend_rows_neon,
+    downsample_row_neon
+};
+#endif
+
+static Image_Kernels const* volatile selected_kernels;
+static Image_Kernels_Isa selected_isa;
+
+Image_Kernels_Isa image_kernels_get_isa()
+{
+    get_kernels();
+    return selected_isa;
+}
+
+Image_Kernels_Isa image_kernels_set_isa(Image_Kernels_Isa isa)
+{
+    if (isa >= IMAGE_KERNELS_ISA_ENUM_COUNT)
+    {
+        isa = IMAGE_KERNELS_ISA_ENUM_COUNT - 1;
+    }
+
+    while (!is_supported(isa))
+    {
+        isa--;
+    }
+
+    Image_Kernels const* kernels = &scalar_kernels;
+#ifdef IMAGE_KERNELS_SSE2
+    if (isa == IMAGE_KERNELS_ISA_SSE2)
+    {
+        kernels = &sse2_kernels;
+    }
+#endif
+#ifdef IMAGE_KERNELS_AVX2
+    if (isa == IMAGE_KERNELS_ISA_AVX2)
+    {
+        kernels = &avx2_kernels;
+    }
+#endif
+#ifdef IMAGE_KERNELS_NEON
+    if (isa == IMAGE_KERNELS_ISA_NEON)
+    {
+        kernels = &neon_kernels;
+    }
+#endif
+
+    selected_isa = isa;
+    selected_kernels = kernels;
+    return isa;
+}
+
+char const* image_kernels_isa_name(Image_Kernels_Isa isa)
+{
+    switch (isa)
+    {
+        case IMAGE_KERNELS_ISA_SCALAR: return "scalar";
+        case IMAGE_KERNELS_ISA_SSE2: return "sse2";
+        case IMAGE_KERNELS_ISA_AVX2: return "avx2";
+        case IMAGE_KERNELS_ISA_NEON: return "neon";
+        default: return "unknown";
+    }
+}
+
+bool image_kernels_has_transparency(u8 const* pixels, u64 pixel_count)
+{
+    return get_kernels()->has_transparency(pixels, pixel_count);
+}
+
+void image_kernels_rgb_to_rgba(u8 const* source, u8* destination, u64 pixel_count)
+{
+    get_kernels()->rgb_to_rgba(source, destination, pixel_count);
+}
+
+void image_kernels_srgb_to_linear(u8 const* source, f32* destination, u64 pixel_count)
+{
+    // A table lookup per channel for every instruction set; without gathers of bytes, vectors don't beat it.
+    f32 const* table = srgb_to_linear_table();
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        destination[i * 4 + 0] = table[source[i * 4 + 0]];
+        destination[i * 4 + 1] = table[source[i * 4 + 1]];
+        destination[i * 4 + 2] = table[source[i * 4 + 2]];
+        destination[i * 4 + 3] = source[i * 4 + 3] * (1.0f / 255.0f);
+    }
+}
+
+void image_kernels_linear_to_srgb(f32 const* source, u8* destination, u64 pixel_count)
+{
+    get_kernels()->linear_to_srgb(source, destination, pixel_count);
+}
+
+void image_kernels_premultiply_alpha(u8* pixels, u64 pixel_count)
+{
+    get_kernels()->premultiply_alpha(pixels, pixel_count);
+}
+
+void image_kernels_swizzle(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4])
+{
+    get_kernels()->swizzle(source, destination, pixel_count, order);
+}
+
+void image_kernels_blend_rows(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count)
+{
+    get_kernels()->blend_rows(rows, weights, row_count, destination, pixel_count);
+}
+
+void image_kernels_downsample_row(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count)
+{
+    get_kernels()->downsample_row(source, weights, tap_count, destination, pixel_count);
+}
+
+Image_Kernels const* get_kernels()
+{
+    // Picked on first use. Racing threads pick the same kernels, so no lock is needed.
+    if (!selected_kernels)
+    {
+        image_kernels_set_isa(IMAGE_KERNELS_ISA_ENUM_COUNT - 1);
+    }
+
+    return selected_kernels;
+}
+
+bool is_supported(Image_Kernels_Isa isa)
+{
+    switch (isa)
+    {
+        case IMAGE_KERNELS_ISA_SCALAR:
+            return true;
+#ifdef IMAGE_KERNELS_SSE2
+        case IMAGE_KERNELS_ISA_SSE2:
+            return true;
+#endif
+#ifdef IMAGE_KERNELS_AVX2
+        case IMAGE_KERNELS_ISA_AVX2:
+            return cpu_has_avx2();
+#endif
+#ifdef IMAGE_KERNELS_NEON
+        case IMAGE_KERNELS_ISA_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool cpu_has_avx2()
+{
+#if defined(IMAGE_KERNELS_AVX2) && defined(_MSC_VER) && !defined(__clang__)
+    i32 info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // The OS must save the YMM registers on context switches as well.
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(IMAGE_KERNELS_AVX2)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#else
+    return false;
+#endif
+}
+
+f32 const* srgb_to_linear_table()
+{
+    // Filled on first use. Racing threads write the same values, so no lock is needed.
+    static f32 table[256];
+    static bool volatile initialized = false;
+    if (!initialized)
+    {
+        for (u32 i = 0; i < 256; ++i)
+        {
+            f64 v = i / 255.0;
+            table[i] = (f32)(v <= 0.04045 ? v / 12.92 : pow((v + 0.055) / 1.055, 2.4));
+        }
+        initialized = true;
+    }
+
+    return table;
+}
+
+u8 const* linear_to_srgb_table()
+{
+    // Filled on first use. Racing threads write the same values, so no lock is needed.
+    // Three bytes of padding let AVX2 gather whole dwords at any index.
+    static u8 table[LINEAR_TO_SRGB_TABLE_SIZE + 3];
+    static bool volatile initialized = false;
+    if (!initialized)
+    {
+        for (u32 i = 0; i < LINEAR_TO_SRGB_TABLE_SIZE; ++i)
+        {
+            // Each entry encodes the middle of the range of floats that map to it.
+            u32 bits = LINEAR_TO_SRGB_MIN + (i << LINEAR_TO_SRGB_SHIFT) + (1u << (LINEAR_TO_SRGB_SHIFT - 1));
+            f32 value;
+            memcpy(&value, &bits, sizeof(value));
+            f64 v = value < 1.0f ? value : 1.0;
+            f64 encoded = v <= 0.0031308 ? v * 12.92 : 1.055 * pow(v, 1.0 / 2.4) - 0.055;
+            table[i] = (u8)(encoded * 255.0 + 0.5);
+        }
+        initialized = true;
+    }
+
+    return table;
+}
+
+u8 encode_srgb(u8 const* table, f32 value)
+{
+    // Written so that NaN clamps to the low end.
+    f32 const min = 1.0f / 8192.0f;
+    f32 v = value > min ? value : min;
+    v = v < 1.0f ? v : 1.0f;
+    u32 bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return table[(bits - LINEAR_TO_SRGB_MIN) >> LINEAR_TO_SRGB_SHIFT];
+}
+
+u8 encode_alpha(f32 value)
+{
+    f32 v = value > 0.0f ? value : 0.0f;
+    v = v < 1.0f ? v : 1.0f;
+    return (u8)(v * 255.0f + 0.5f);
+}
+
+bool has_transparency_scalar(u8 const* pixels, u64 pixel_count)
+{
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        if (pixels[i * 4 + 3] < 255)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void rgb_to_rgba_scalar(u8 const* source, u8* destination, u64 pixel_count)
+{
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        destination[i * 4 + 0] = source[i * 3 + 0];
+        destination[i * 4 + 1] = source[i * 3 + 1];
+        destination[i * 4 + 2] = source[i * 3 + 2];
+        destination[i * 4 + 3] = 255;
+    }
+}
+
+void linear_to_srgb_scalar(f32 const* source, u8* destination, u64 pixel_count)
+{
+    u8 const* table = linear_to_srgb_table();
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        destination[i * 4 + 0] = encode_srgb(table, source[i * 4 + 0]);
+        destination[i * 4 + 1] = encode_srgb(table, source[i * 4 + 1]);
+        destination[i * 4 + 2] = encode_srgb(table, source[i * 4 + 2]);
+        destination[i * 4 + 3] = encode_alpha(source[i * 4 + 3]);
+    }
+}
+
+void premultiply_alpha_scalar(u8* pixels, u64 pixel_count)
+{
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        u8* pixel = pixels + i * 4;
+        u32 alpha = pixel[3];
+        for (u32 c = 0; c < 3; ++c)
+        {
+            // Exactly rounded c * a / 255.
+            u32 t = pixel[c] * alpha + 128;
+            pixel[c] = (u8)((t + (t >> 8)) >> 8);
+        }
+    }
+}
+
+void swizzle_scalar(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4])
+{
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        u8 const* pixel = source + i * 4;
+        u8 swizzled[4] = { pixel[order[0]], pixel[order[1]], pixel[order[2]], pixel[order[3]] };
+        memcpy(destination + i * 4, swizzled, sizeof(swizzled));
+    }
+}
+
+void blend_rows_scalar(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count)
+{
+    for (u64 i = 0; i < pixel_count * 4; ++i)
+    {
+        f32 sum = 0.0f;
+        for (u32 r = 0; r < row_count; ++r)
+        {
+            sum += weights[r] * rows[r][i];
+        }
+        destination[i] = sum;
+    }
+}
+
+void downsample_row_scalar(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count)
+{
+    for (u64 x = 0; x < pixel_count; ++x)
+    {
+        for (u32 c = 0; c < 4; ++c)
+        {
+            f32 sum = 0.0f;
+            for (u32 k = 0; k < tap_count; ++k)
+            {
+                sum += weights[k] * source[(x * 2 + k) * 4 + c];
+            }
+            destination[x * 4 + c] = sum;
+        }
+    }
+}
+
+#ifdef IMAGE_KERNELS_SSE2
+bool has_transparency_sse2(u8 const* pixels, u64 pixel_count)
+{
+    // Alpha is the top byte of every dword. Colour bytes are forced to 255, so the AND of a block is all ones only if
+    // every alpha in it is.
+    __m128i const colour = _mm_set1_epi32(0x00FFFFFF);
+    __m128i const ones = _mm_set1_epi32(-1);
+    u64 i = 0;
+    for (; i + 16 <= pixel_count; i += 16)
+    {
+        u8 const* p = pixels + i * 4;
+        __m128i a = _mm_and_si128(_mm_loadu_si128((__m128i const*)p), _mm_loadu_si128((__m128i const*)(p + 16)));
+        __m128i b = _mm_and_si128(_mm_loadu_si128((__m128i const*)(p + 32)), _mm_loadu_si128((__m128i const*)(p + 48)));
+        __m128i all = _mm_or_si128(_mm_and_si128(a, b), colour);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(all, ones)) != 0xFFFF)
+        {
+            return true;
+        }
+    }
+
+    return has_transparency_scalar(pixels + i * 4, pixel_count - i);
+}
+
+void rgb_to_rgba_sse2(u8 const* source, u8* destination, u64 pixel_count)
+{
+    // Without a byte shuffle, four pixels are moved to the low dword of separate registers and recombined. A load reads
+    // four bytes past the twelve it uses, so the last pixels go through the scalar loop.
+    __m128i const alpha = _mm_set1_epi32((i32)0xFF000000);
+    u64 i = 0;
+    for (; i + 6 <= pixel_count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((__m128i const*)(source + i * 3));
+        __m128i p01 = _mm_unpacklo_epi32(v, _mm_srli_si128(v, 3));
+        __m128i p23 = _mm_unpacklo_epi32(_mm_srli_si128(v, 6), _mm_srli_si128(v, 9));
+        _mm_storeu_si128((__m128i*)(destination + i * 4), _mm_or_si128(_mm_unpacklo_epi64(p01, p23), alpha));
+    }
+
+    rgb_to_rgba_scalar(source + i * 3, destination + i * 4, pixel_count - i);
+}
+
+void linear_to_srgb_sse2(f32 const* source, u8* destination, u64 pixel_count)
+{
+    // One pixel per register: the clamp and the table index of every channel are computed at once, then colour is
+    // looked up and alpha taken from the scaled value. max returns its second operand for NaN, which clamps it.
+    u8 const* table = linear_to_srgb_table();
+    __m128 const min = _mm_set1_ps(1.0f / 8192.0f);
+    __m128 const zero = _mm_setzero_ps();
+    __m128 const one = _mm_set1_ps(1.0f);
+    __m128 const scale = _mm_set1_ps(255.0f);
+    __m128 const half = _mm_set1_ps(0.5f);
+    __m128i const table_start = _mm_set1_epi32(LINEAR_TO_SRGB_MIN);
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        __m128 v = _mm_loadu_ps(source + i * 4);
+        __m128 clamped = _mm_min_ps(_mm_max_ps(v, min), one);
+        __m128i index = _mm_srli_epi32(_mm_sub_epi32(_mm_castps_si128(clamped), table_start), LINEAR_TO_SRGB_SHIFT);
+        __m128i scaled = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(v, zero), one), scale), half));
+
+        u32 indices[4];
+        _mm_storeu_si128((__m128i*)indices, index);
+        u8* pixel = destination + i * 4;
+        pixel[0] = table[indices[0]];
+        pixel[1] = table[indices[1]];
+        pixel[2] = table[indices[2]];
+        pixel[3] = (u8)_mm_cvtsi128_si32(_mm_shuffle_epi32(scaled, _MM_SHUFFLE(3, 3, 3, 3)));
+    }
+}
+
+void premultiply_alpha_sse2(u8* pixels, u64 pixel_count)
+{
+    // Two pixels per register as 16 bit lanes. The alpha of each is broadcast to its colour lanes and alpha is
+    // multiplied by 255, which the exact division by 255 maps back to alpha.
+    __m128i const zero = _mm_setzero_si128();
+    __m128i const colour_lanes = _mm_set_epi16(0, -1, -1, -1, 0, -1, -1, -1);
+    __m128i const alpha_lanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    __m128i const bias = _mm_set1_epi16(128);
+    u64 i = 0;
+    for (; i + 4 <= pixel_count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((__m128i const*)(pixels + i * 4));
+        __m128i halves[2] = { _mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero) };
+        for (u32 h = 0; h < 2; ++h)
+        {
+            __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(halves[h], 0xFF), 0xFF);
+            alpha = _mm_or_si128(_mm_and_si128(alpha, colour_lanes), alpha_lanes);
+            __m128i t = _mm_add_epi16(_mm_mullo_epi16(halves[h], alpha), bias);
+            halves[h] = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+        }
+        _mm_storeu_si128((__m128i*)(pixels + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+    }
+
+    premultiply_alpha_scalar(pixels + i * 4, pixel_count - i);
+}
+
+void swizzle_sse2(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4])
+{
+    // Without a byte shuffle, each channel is shifted out of its source position and into its destination one.
+    __m128i const byte = _mm_set1_epi32(0xFF);
+    __m128i const shifts[4] = {
+        _mm_cvtsi32_si128(order[0] * 8),
+        _mm_cvtsi32_si128(order[1] * 8),
+        _mm_cvtsi32_si128(order[2] * 8),
+        _mm_cvtsi32_si128(order[3] * 8)
+    };
+    u64 i = 0;
+    for (; i + 4 <= pixel_count; i += 4)
+    {
+        __m128i v = _mm_loadu_si128((__m128i const*)(source + i * 4));
+        __m128i r = _mm_and_si128(_mm_srl_epi32(v, shifts[0]), byte);
+        r = _mm_or_si128(r, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(v, shifts[1]), byte), 8));
+        r = _mm_or_si128(r, _mm_slli_epi32(_mm_and_si128(_mm_srl_epi32(v, shifts[2]), byte), 16));
+        r = _mm_or_si128(r, _mm_slli_epi32(_mm_srl_epi32(v, shifts[3]), 24));
+        _mm_storeu_si128((__m128i*)(destination + i * 4), r);
+    }
+
+    swizzle_scalar(source + i * 4, destination + i * 4, pixel_count - i, order);
+}
+
+void blend_rows_sse2(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count)
+{
+    // One pixel per register, so the sums add up in the same order as the scalar ones.
+    for (u64 i = 0; i < pixel_count * 4; i += 4)
+    {
+        __m128 sum = _mm_setzero_ps();
+        for (u32 r = 0; r < row_count; ++r)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(weights[r]), _mm_loadu_ps(rows[r] + i)));
+        }
+        _mm_storeu_ps(destination + i, sum);
+    }
+}
+
+void downsample_row_sse2(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count)
+{
+    __m128 taps[IMAGE_KERNELS_MAX_TAPS];
+    for (u32 k = 0; k < tap_count; ++k)
+    {
+        taps[k] = _mm_set1_ps(weights[k]);
+    }
+
+    for (u64 x = 0; x < pixel_count; ++x)
+    {
+        f32 const* p = source + x * 8;
+        __m128 sum = _mm_setzero_ps();
+        for (u32 k = 0; k < tap_count; ++k)
+        {
+            sum = _mm_add_ps(sum, _mm_mul_ps(taps[k], _mm_loadu_ps(p + k * 4)));
+        }
+        _mm_storeu_ps(destination + x * 4, sum);
+    }
+}
+#endif
+
+#ifdef IMAGE_KERNELS_AVX2
+AVX2_FUNCTION bool has_transparency_avx2(u8 const* pixels, u64 pixel_count)
+{
+    __m256i const colour = _mm256_set1_epi32(0x00FFFFFF);
+    __m256i const ones = _mm256_set1_epi32(-1);
+    u64 i = 0;
+    for (; i + 32 <= pixel_count; i += 32)
+    {
+        u8 const* p = pixels + i * 4;
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256((__m256i const*)p), _mm256_loadu_si256((__m256i const*)(p + 32)));
+        __m256i b = _mm256_and_si256(_mm256_loadu_si256((__m256i const*)(p + 64)), _mm256_loadu_si256((__m256i const*)(p + 96)));
+        __m256i all = _mm256_or_si256(_mm256_and_si256(a, b), colour);
+        if ((u32)_mm256_movemask_epi8(_mm256_cmpeq_epi8(all, ones)) != 0xFFFFFFFF)
+        {
+            return true;
+        }
+    }
+
+    return has_transparency_scalar(pixels + i * 4, pixel_count - i);
+}
+
+AVX2_FUNCTION void rgb_to_rgba_avx2(u8 const* source, u8* destination, u64 pixel_count)
+{
+    // Each 128 bit lane takes four pixels from its own load, the upper one starting twelve bytes in. The upper load
+    // reads four bytes past the pixels it uses, so the last pixels go through the scalar loop.
+    __m256i const shuffle = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i const alpha = _mm256_set1_epi32((i32)0xFF000000);
+    u64 i = 0;
+    for (; i + 10 <= pixel_count; i += 8)
+    {
+        u8 const* p = source + i * 3;
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((__m128i const*)p)), _mm_loadu_si128((__m128i const*)(p + 12)), 1);
+        _mm256_storeu_si256((__m256i*)(destination + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha));
+    }
+
+    rgb_to_rgba_scalar(source + i * 3, destination + i * 4, pixel_count - i);
+}
+
+AVX2_FUNCTION void linear_to_srgb_avx2(f32 const* source, u8* destination, u64 pixel_count)
+{
+    // Two pixels per register. Colour is gathered from the table as dwords whose low byte is the entry, alpha blended
+    // in, and four registers are packed down to eight pixels.
+    u8 const* table = linear_to_srgb_table();
+    __m256 const min = _mm256_set1_ps(1.0f / 8192.0f);
+    __m256 const zero = _mm256_setzero_ps();
+    __m256 const one = _mm256_set1_ps(1.0f);
+    __m256 const scale = _mm256_set1_ps(255.0f);
+    __m256 const half = _mm256_set1_ps(0.5f);
+    __m256i const table_start = _mm256_set1_epi32(LINEAR_TO_SRGB_MIN);
+    __m256i const low_byte = _mm256_set1_epi32(0xFF);
+    __m256i const order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    u64 i = 0;
+    for (; i + 8 <= pixel_count; i += 8)
+    {
+        __m256i pairs[4];
+        for (u32 p = 0; p < 4; ++p)
+        {
+            __m256 v = _mm256_loadu_ps(source + (i + p * 2) * 4);
+            __m256 clamped = _mm256_min_ps(_mm256_max_ps(v, min), one);
+            __m256i index = _mm256_srli_epi32(_mm256_sub_epi32(_mm256_castps_si256(clamped), table_start), LINEAR_TO_SRGB_SHIFT);
+            __m256i colour = _mm256_and_si256(_mm256_i32gather_epi32((int const*)table, index, 1), low_byte);
+            __m256i alpha = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(v, zero), one), scale), half));
+            pairs[p] = _mm256_blend_epi32(colour, alpha, 0x88);
+        }
+
+        // The packs work per lane: the low lane ends up holding pixels 0, 2, 4, 6 and the high lane 1, 3, 5, 7.
+        __m256i words = _mm256_packus_epi32(pairs[0], pairs[1]);
+        __m256i bytes = _mm256_packus_epi16(words, _mm256_packus_epi32(pairs[2], pairs[3]));
+        _mm256_storeu_si256((__m256i*)(destination + i * 4), _mm256_permutevar8x32_epi32(bytes, order));
+    }
+
+    linear_to_srgb_sse2(source + i * 4, destination + i * 4, pixel_count - i);
+}
+
+AVX2_FUNCTION void premultiply_alpha_avx2(u8* pixels, u64 pixel_count)
+{
+    __m256i const zero = _mm256_setzero_si256();
+    __m256i const colour_lanes = _mm256_set_epi16(0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1, 0, -1, -1, -1);
+    __m256i const alpha_lanes = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    __m256i const bias = _mm256_set1_epi16(128);
+    u64 i = 0;
+    for (; i + 8 <= pixel_count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((__m256i const*)(pixels + i * 4));
+        __m256i halves[2] = { _mm256_unpacklo_epi8(v, zero), _mm256_unpackhi_epi8(v, zero) };
+        for (u32 h = 0; h < 2; ++h)
+        {
+            __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(halves[h], 0xFF), 0xFF);
+            alpha = _mm256_or_si256(_mm256_and_si256(alpha, colour_lanes), alpha_lanes);
+            __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(halves[h], alpha), bias);
+            halves[h] = _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+        }
+        _mm256_storeu_si256((__m256i*)(pixels + i * 4), _mm256_packus_epi16(halves[0], halves[1]));
+    }
+
+    premultiply_alpha_scalar(pixels + i * 4, pixel_count - i);
+}
+
+AVX2_FUNCTION void swizzle_avx2(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4])
+{
+    u8 indices[32];
+    for (u32 b = 0; b < 32; ++b)
+    {
+        indices[b] = (u8)((b & 12) + order[b & 3]);
+    }
+
+    __m256i const shuffle = _mm256_loadu_si256((__m256i const*)indices);
+    u64 i = 0;
+    for (; i + 8 <= pixel_count; i += 8)
+    {
+        __m256i v = _mm256_loadu_si256((__m256i const*)(source + i * 4));
+        _mm256_storeu_si256((__m256i*)(destination + i * 4), _mm256_shuffle_epi8(v, shuffle));
+    }
+
+    swizzle_scalar(source + i * 4, destination + i * 4, pixel_count - i, order);
+}
+
+AVX2_FUNCTION void blend_rows_avx2(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count)
+{
+    u64 i = 0;
+    for (; i + 8 <= pixel_count * 4; i += 8)
+    {
+        __m256 sum = _mm256_setzero_ps();
+        for (u32 r = 0; r < row_count; ++r)
+        {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(weights[r]), _mm256_loadu_ps(rows[r] + i)));
+        }
+        _mm256_storeu_ps(destination + i, sum);
+    }
+
+    if (i < pixel_count * 4)
+    {
+        // One pixel is left.
+        f32 const* tail[IMAGE_KERNELS_MAX_TAPS];
+        for (u32 r = 0; r < row_count; ++r)
+        {
+            tail[r] = rows[r] + i;
+        }
+        blend_rows_sse2(tail, weights, row_count, destination + i, 1);
+    }
+}
+
+AVX2_FUNCTION void downsample_row_avx2(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count)
+{
+    // Two output pixels per register, whose taps are two source pixels apart.
+    __m256 taps[IMAGE_KERNELS_MAX_TAPS];
+    for (u32 k = 0; k < tap_count; ++k)
+    {
+        taps[k] = _mm256_set1_ps(weights[k]);
+    }
+
+    u64 x = 0;
+    for (; x + 2 <= pixel_count; x += 2)
+    {
+        f32 const* p = source + x * 8;
+        __m256 sum = _mm256_setzero_ps();
+        for (u32 k = 0; k < tap_count; ++k)
+        {
+            __m256 pair = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(p + k * 4)), _mm_loadu_ps(p + k * 4 + 8), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(taps[k], pair));
+        }
+        _mm256_storeu_ps(destination + x * 4, sum);
+    }
+
+    downsample_row_sse2(source + x * 8, weights, tap_count, destination + x * 4, pixel_count - x);
+}
+#endif
+
+#ifdef IMAGE_KERNELS_NEON
+bool has_transparency_neon(u8 const* pixels, u64 pixel_count)
+{
+    uint32x4_t const colour = vdupq_n_u32(0x00FFFFFF);
+    u64 i = 0;
+    for (; i + 16 <= pixel_count; i += 16)
+    {
+        u8 const* p = pixels + i * 4;
+        uint32x4_t a = vandq_u32(vreinterpretq_u32_u8(vld1q_u8(p)), vreinterpretq_u32_u8(vld1q_u8(p + 16)));
+        uint32x4_t b = vandq_u32(vreinterpretq_u32_u8(vld1q_u8(p + 32)), vreinterpretq_u32_u8(vld1q_u8(p + 48)));
+        if (vminvq_u32(vorrq_u32(vandq_u32(a, b), colour)) != 0xFFFFFFFF)
+        {
+            return true;
+        }
+    }
+
+    return has_transparency_scalar(pixels + i * 4, pixel_count - i);
+}
+
+void rgb_to_rgba_neon(u8 const* source, u8* destination, u64 pixel_count)
+{
+    u64 i = 0;
+    for (; i + 16 <= pixel_count; i += 16)
+    {
+        uint8x16x3_t rgb = vld3q_u8(source + i * 3);
+        uint8x16x4_t rgba = { { rgb.val[0], rgb.val[1], rgb.val[2], vdupq_n_u8(255) } };
+        vst4q_u8(destination + i * 4, rgba);
+    }
+
+    rgb_to_rgba_scalar(source + i * 3, destination + i * 4, pixel_count - i);
+}
+
+void linear_to_srgb_neon(f32 const* source, u8* destination, u64 pixel_count)
+{
+    // As linear_to_srgb_sse2. maxnm returns the number when one operand is NaN, which clamps it.
+    u8 const* table = linear_to_srgb_table();
+    float32x4_t const min = vdupq_n_f32(1.0f / 8192.0f);
+    float32x4_t const zero = vdupq_n_f32(0.0f);
+    float32x4_t const one = vdupq_n_f32(1.0f);
+    uint32x4_t const table_start = vdupq_n_u32(LINEAR_TO_SRGB_MIN);
+    for (u64 i = 0; i < pixel_count; ++i)
+    {
+        float32x4_t v = vld1q_f32(source + i * 4);
+        float32x4_t clamped = vminq_f32(vmaxnmq_f32(v, min), one);
+        uint32x4_t index = vshrq_n_u32(vsubq_u32(vreinterpretq_u32_f32(clamped), table_start), LINEAR_TO_SRGB_SHIFT);
+        uint32x4_t scaled = vcvtq_u32_f32(vmlaq_n_f32(vdupq_n_f32(0.5f), vminq_f32(vmaxnmq_f32(v, zero), one), 255.0f));
+
+        u8* pixel = destination + i * 4;
+        pixel[0] = table[vgetq_lane_u32(index, 0)];
+        pixel[1] = table[vgetq_lane_u32(index, 1)];
+        pixel[2] = table[vgetq_lane_u32(index, 2)];
+        pixel[3] = (u8)vgetq_lane_u32(scaled, 3);
+    }
+}
+
+void premultiply_alpha_neon(u8* pixels, u64 pixel_count)
+{
+    u64 i = 0;
+    for (; i + 8 <= pixel_count; i += 8)
+    {
+        uint8x8x4_t v = vld4_u8(pixels + i * 4);
+        for (u32 c = 0; c < 3; ++c)
+        {
+            // (x + ((x + 128) >> 8) + 128) >> 8 is the exactly rounded x / 255.
+            uint16x8_t x = vmull_u8(v.val[c], v.val[3]);
+            v.val[c] = vraddhn_u16(x, vrshrq_n_u16(x, 8));
+        }
+        vst4_u8(pixels + i * 4, v);
+    }
+
+    premultiply_alpha_scalar(pixels + i * 4, pixel_count - i);
+}
+
+void swizzle_neon(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4])
+{
+    u8 indices[16];
+    for (u32 b = 0; b < 16; ++b)
+    {
+        indices[b] = (u8)((b & 12) + order[b & 3]);
+    }
+
+    uint8x16_t const shuffle = vld1q_u8(indices);
+    u64 i = 0;
+    for (; i + 4 <= pixel_count; i += 4)
+    {
+        vst1q_u8(destination + i * 4, vqtbl1q_u8(vld1q_u8(source + i * 4), shuffle));
+    }
+
+    swizzle_scalar(source + i * 4, destination + i * 4, pixel_count - i, order);
+}
+
+void blend_rows_neon(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count)
+{
+    // Multiplies and adds are kept separate, as fused ones would round differently from the scalar sums.
+    for (u64 i = 0; i < pixel_count * 4; i += 4)
+    {
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (u32 r = 0; r < row_count; ++r)
+        {
+            sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(rows[r] + i), weights[r]));
+        }
+        vst1q_f32(destination + i, sum);
+    }
+}
+
+void downsample_row_neon(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count)
+{
+    for (u64 x = 0; x < pixel_count; ++x)
+    {
+        f32 const* p = source + x * 8;
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        for (u32 k = 0; k < tap_count; ++k)
+        {
+            sum = vaddq_f32(sum, vmulq_n_f32(vld1q_f32(p + k * 4), weights[k]));
+        }
+        vst1q_f32(destination + x * 4, sum);
+    }
+}
+#endif
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Pixel kernels for RGBA8 images and their linear RGBA32F form, vectorised with SSE2, AVX2 or NEON where the CPU has
+ * them, with scalar fallbacks.
+ * The instruction set is picked on first use; AVX2 only when the CPU and the OS support it.
+ * Pointers need no particular alignment. Every kernel is thread-safe.
+ */
+
+/** @brief Most taps of a filter passed to image_kernels_blend_rows or image_kernels_downsample_row. */
+#define IMAGE_KERNELS_MAX_TAPS 16
+
+typedef enum Image_Kernels_Isa
+{
+    IMAGE_KERNELS_ISA_SCALAR,
+    IMAGE_KERNELS_ISA_SSE2,
+    IMAGE_KERNELS_ISA_AVX2,
+    IMAGE_KERNELS_ISA_NEON,
+    IMAGE_KERNELS_ISA_ENUM_COUNT
+} Image_Kernels_Isa;
+
+/**
+ * @return The instruction set the kernels use.
+ */
+LIB_API Image_Kernels_Isa image_kernels_get_isa();
+
+/**
+ * @brief Makes the kernels use _isa_, or the best supported one below it. Meant for tests and benchmarks comparing
+ * implementations; not to be called while kernels run on other threads.
+ * @return The instruction set now in use.
+ */
+LIB_API Image_Kernels_Isa image_kernels_set_isa(Image_Kernels_Isa isa);
+
+LIB_API char const* image_kernels_isa_name(Image_Kernels_Isa isa);
+
+/**
+ * @return true if any of the _pixel_count_ RGBA8 pixels has an alpha below 255.
+ */
+LIB_API bool image_kernels_has_transparency(u8 const* pixels, u64 pixel_count);
+
+/**
+ * @brief Expands RGB8 pixels to RGBA8 with an opaque alpha. _destination_ is only written, so it may be
+ * write-combined memory. The buffers must not overlap.
+ */
+LIB_API void image_kernels_rgb_to_rgba(u8 const* source, u8* destination, u64 pixel_count);
+
+/**
+ * @brief Converts sRGB encoded RGBA8 pixels to linear RGBA32F. Alpha is linear already and is only scaled to [0, 1].
+ */
+LIB_API void image_kernels_srgb_to_linear(u8 const* source, f32* destination, u64 pixel_count);
+
+/**
+ * @brief Converts linear RGBA32F pixels to sRGB encoded RGBA8, clamping to [0, 1]. Colour is within one level of the
+ * exactly rounded value; alpha is rounded to nearest.
+ */
+LIB_API void image_kernels_linear_to_srgb(f32 const* source, u8* destination, u64 pixel_count);
+
+/**
+ * @brief Multiplies the colour of RGBA8 pixels by their alpha in place, rounded to nearest.
+ */
+LIB_API void image_kernels_premultiply_alpha(u8* pixels, u64 pixel_count);
+
+/**
+ * @brief Reorders the channels of RGBA8 pixels: channel c of a destination pixel is channel order[c] of the source
+ * pixel, e.g. {2, 1, 0, 3} converts between RGBA and BGRA. _source_ and _destination_ may be the same buffer.
+ * @param order Four channel indices, each below 4.
+ */
+LIB_API void image_kernels_swizzle(u8 const* source, u8* destination, u64 pixel_count, u8 const order[4]);
+
+/**
+ * @brief Weighted sum of rows of RGBA32F pixels, the vertical pass of a separable filter:
+ * destination[i] = sum over r of weights[r] * rows[r][i].
+ * @param row_count At most IMAGE_KERNELS_MAX_TAPS.
+ */
+LIB_API void image_kernels_blend_rows(f32 const* const* rows, f32 const* weights, u32 row_count, f32* destination, u64 pixel_count);
+
+/**
+ * @brief Filters a row of RGBA32F pixels down to half its width, the horizontal pass of a separable filter:
+ * destination[x] = sum over k of weights[k] * source[2x + k].
+ * @param source 2 * pixel_count + tap_count - 2 pixels. Padding the edges is up to the caller.
+ * @param tap_count At most IMAGE_KERNELS_MAX_TAPS.
+ */
+LIB_API void image_kernels_downsample_row(f32 const* source, f32 const* weights, u32 tap_count, f32* destination, u64 pixel_count);
@@ -4,6 +4,7 @@
 #include "core/logger.h"
 #include "core/string_utils.h"
 #include "platform/filesystem.h"
+#include "resources/loaders/cooked_asset.h"
 #include "systems/memory_system.h"
 
 static bool load(char const* filename, Resource_Data* resource);
@@ -29,26 +30,39 @@ bool load(char const* filename, Resource_Data* resource)
 
     char path[256];
     memory_system_zero(path, sizeof(path));
-    string_format(path, "%s/%s/%s", ASSETS_DIR, "shaders/spirv", filename);
-    File_Handle handle;
-    if (!filesystem_open(path, FILE_ACCESS_MODE_READ_BINARY, &handle))
+    string_format(path, "%s/%s", "shaders/spirv", filename);
+    // The file is mapped rather than read, so the data is handed to the consumer without a copy.
+    // A cooked blob is preferred; its payload is handed out in place.
+    File_View view;
+    Cooked_Header const* header = cooked_asset_map(path, COOKED_TYPE_SPIRV, sizeof(Cooked_Header), 0, &view);
+    if (header && header->payload_size <= (u32)-1)
     {
-        LOG_FATAL("binary_loader load: Failed to open %s for binary reading", path);
+        resource->data = (u8*)view.data + header->payload_offset;
+        resource->size = (u32)header->payload_size;
+        resource->view = view;
+        return true;
+    }
+    else if (header)
+    {
+        filesystem_unmap(&view);
+    }
+
+    if (!filesystem_map_asset(path, &view))
+    {
+        LOG_FATAL("binary_loader load: Failed to map %s for binary reading", path);
         return false;
     }
 
-    u32 data_size = filesystem_size(&handle);
-    u8* data = memory_system_allocate(data_size, MEMORY_TAG_RESOURCES);
-    if (!filesystem_read(&handle, data, data_size))
+    if (view.size > (u32)-1)
     {
-        LOG_FATAL("binary_loader load: Failed to read %s", path);
-        filesystem_close(&handle);
+        LOG_FATAL("binary_loader load: %s is too large (%llu bytes)", path, view.size);
+        filesystem_unmap(&view);
         return false;
     }
 
-    filesystem_close(&handle);
-    resource->data = data;
-    resource->size = data_size;
+    resource->data = (void*)view.data;
+    resource->size = (u32)view.size;
+    resource->view = view;
     return true;
 }
 
@@ -59,7 +73,7 @@ void unload(Resource_Data* resource)
         LOG_WARNING("binary_loader unload: Invalid parameters");
     }
 
-    memory_system_free(resource->data, resource->size, MEMORY_TAG_RESOURCES);
+    filesystem_unmap(&resource->view);
     resource->data = 0;
     resource->size = 0;
 }
@@ -0,0 +1,26 @@
+#include "cooked_asset.h"
+
+#include "core/logger.h"
+#include "core/string_utils.h"
+
+Cooked_Header const* cooked_asset_map(char const* path, Cooked_Type type, u64 struct_size, u64 payload_size, File_View* view)
+{
+    char cooked_path[256];
+    string_format(cooked_path, COOKED_PATH_FORMAT, path);
+    File_Location location;
+    if (!filesystem_locate(cooked_path, &location) || !filesystem_map_asset(cooked_path, view))
+    {
+        return 0;
+    }
+
+    // Payloads handed out in place must keep the alignment their consumers rely on.
+    Cooked_Header const* header = cooked_validate(view->data, view->size, type, struct_size);
+    if (!header || header->payload_offset % COOKED_PAYLOAD_ALIGNMENT != 0 || (payload_size && header->payload_size != payload_size))
+    {
+        LOG_WARNING("cooked_asset_map: Ignoring outdated or malformed %s. Run the cook tool to update it", cooked_path);
+        filesystem_unmap(view);
+        return 0;
+    }
+
+    return header;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "defines.h"
+#include "platform/filesystem.h"
+#include "resources/cooked_format.h"
+
+/**
+ * @brief Maps the cooked form of the asset at _path_ (see COOKED_PATH_FORMAT) if one is mounted and current.
+ * Outdated or malformed files are reported and skipped, so the caller falls back to the source asset.
+ * @param struct_size The size of the fixed-layout struct expected at the start of the file.
+ * @param payload_size The exact payload size expected, or 0 to accept any.
+ * @return The header, with _view_ holding the mapping to be released with filesystem_unmap; otherwise 0 and nothing is mapped.
+ */
+Cooked_Header const* cooked_asset_map(char const* path, Cooked_Type type, u64 struct_size, u64 payload_size, File_View* view);
@@ -1,22 +1,93 @@
 #include "image_loader.h"
 
 #include "config.h"
+#include "core/hash.h"
 #include "core/logger.h"
 #include "core/string_utils.h"
+#include "platform/filesystem.h"
+#include "resources/cooked_format.h"
+#include "resources/image_cache.h"
+#include "resources/image_kernels.h"
+#include "resources/texture_container.h"
 #include "systems/memory_system.h"
 #include "third_party/stb_image.h"
 
+/**
+ * @brief Where the pixels of an image ended up: in a cooked texture, which is either the source itself or a mapped
+ * cache entry, in a KTX2 or DDS container viewed in place, or in a buffer decoded by stb_image.
+ */
+typedef struct Decoded_Image
+{
+    Cooked_Texture const* cooked;
+    File_View entry;
+    Texture_Container container;
+    u8* pixels;
+    u32 width;
+    u32 height;
+} Decoded_Image;
+
 static bool load(char const* filename, Resource_Data* resource);
 static void unload(Resource_Data* resource);
+static bool load_encoded(void const* data, u64 size, char const* disk_path, File_View* source, Resource_Data* resource);
+static bool decode(void const* data, u64 size, char const* disk_path, Decoded_Image* image);
+static bool copy_to_destination(Decoded_Image const* image, Image_Load_Options const* options, PFN_image_destination get_destination, void* user_data, Image_Load_Info* info);
+static bool create_image_resource(u8* pixels, i32 width, i32 height, Resource_Data* resource);
+static bool create_cooked_image_resource(Cooked_Texture const* texture, File_View* source, Resource_Data* resource);
+static bool create_cached_image_resource(File_View view, Resource_Data* resource);
+static bool create_container_image_resource(Texture_Container const* container, File_View* source, Resource_Data* resource);
+static bool container_has_transparency(Texture_Container const* container);
+static bool validate_cooked_texture(Cooked_Texture const* texture);
 
 Resource_Loader* image_loader_create()
 {
     Resource_Loader* loader = memory_system_allocate(sizeof(*loader), MEMORY_TAG_LOADERS);
     loader->load = load;
     loader->unload = unload;
+    loader->get_path = image_loader_get_path;
+    loader->load_from_memory = image_loader_load_from_memory;
     return loader;
 }
 
+void image_loader_get_path(char const* filename, char* path)
+{
+    // Texture names carry no extension. Cooked images win, then KTX2 and DDS containers, which upload as they are,
+    // then the source PNGs.
+    char source_path[256];
+    File_Location location;
+    if (string_index_of((char*)filename, '.') != -1)
+    {
+        string_format(source_path, "%s/%s", "textures", filename);
+    }
+    else
+    {
+        string_format(source_path, "%s/%s.png", "textures", filename);
+        string_format(path, COOKED_PATH_FORMAT, source_path);
+        if (filesystem_locate(path, &location))
+        {
+            return;
+        }
+
+        char const* const container_extensions[] = { "ktx2", "dds" };
+        for (u32 i = 0; i < 2; ++i)
+        {
+            string_format(path, "%s/%s.%s", "textures", filename, container_extensions[i]);
+            if (filesystem_locate(path, &location))
+            {
+                return;
+            }
+        }
+
+        string_copy(path, source_path);
+        return;
+    }
+
+    string_format(path, COOKED_PATH_FORMAT, source_path);
+    if (!filesystem_locate(path, &location))
+    {
+        string_copy(path, source_path);
+    }
+}
+
 bool load(char const* filename, Resource_Data* resource)
 {
     if (!filename || !resource)
@@ -26,38 +97,544 @@ bool load(char const* filename, Resource_Data* resource)
     }
 
     char path[256];
-    string_format(path, "%s/%s/%s", ASSETS_DIR, "materials", filename);
-    i32 required_channel_count = 4;
-    i32 width;
-    i32 height;
-    i32 channel_count;
-    u8* pixels = stbi_load(path, &width, &height, &channel_count, required_channel_count);
-    if (!pixels)
+    image_loader_get_path(filename, path);
+
+    // Unchanged loose sources are served from the image cache without being read.
+    File_Location location;
+    bool loose = filesystem_locate(path, &location) && !location.in_pack;
+    File_View view;
+    if (loose && image_cache_find_by_path(location.disk_path, &view))
+    {
+        return create_cached_image_resource(view, resource);
+    }
+
+    if (!filesystem_map_asset(path, &view))
     {
         LOG_FATAL("image_loader load: Failed to load image %s", path);
         return false;
     }
 
-    Image_Resource* image = memory_system_allocate(sizeof(*image), MEMORY_TAG_RESOURCES);
+    bool result = load_encoded(view.data, view.size, loose ? location.disk_path : 0, &view, resource);
+    if (view.data)
+    {
+        filesystem_unmap(&view);
+    }
+
+    return result;
+}
+
+bool image_loader_load_from_memory(void const* data, u64 size, Resource_Data* resource)
+{
+    if (!data || !resource)
+    {
+        LOG_FATAL("image_loader_load_from_memory: Invalid parameters");
+        return false;
+    }
+
+    return load_encoded(data, size, 0, 0, resource);
+}
+
+bool image_loader_load_into(char const* filename, Image_Load_Options const* options, PFN_image_destination get_destination, void* user_data, Image_Load_Info* info)
+{
+    if (!filename || !get_destination || !info)
+    {
+        LOG_FATAL("image_loader_load_into: Invalid parameters");
+        return false;
+    }
+
+    char path[256];
+    image_loader_get_path(filename, path);
+
+    File_Location location;
+    bool loose = filesystem_locate(path, &location) && !location.in_pack;
+    Decoded_Image image = {};
+    File_View source = {};
+    if (loose && image_cache_find_by_path(location.disk_path, &image.entry))
+    {
+        image.cooked = image.entry.data;
+    }
+    else if (!filesystem_map_asset(path, &source))
+    {
+        LOG_ERROR("image_loader_load_into: Failed to load image %s", path);
+        return false;
+    }
+    else if (!decode(source.data, source.size, loose ? location.disk_path : 0, &image))
+    {
+        filesystem_unmap(&source);
+        return false;
+    }
+
+    bool result = copy_to_destination(&image, options, get_destination, user_data, info);
+    if (image.entry.data)
+    {
+        filesystem_unmap(&image.entry);
+    }
+    if (image.pixels)
+    {
+        stbi_image_free(image.pixels);
+    }
+    if (source.data)
+    {
+        filesystem_unmap(&source);
+    }
+
+    return result;
+}
+
+/**
+ * @brief Creates an image resource from the bytes of an image file. _source_, if given, is the mapping holding _data_;
+ * the resource takes it over when its pixels can be used in place, and then clears it.
+ */
+bool load_encoded(void const* data, u64 size, char const* disk_path, File_View* source, Resource_Data* resource)
+{
+    Decoded_Image image = {};
+    if (!decode(data, size, disk_path, &image))
+    {
+        return false;
+    }
+
+    if (image.entry.data)
+    {
+        return create_cached_image_resource(image.entry, resource);
+    }
+
+    if (image.container.data)
+    {
+        return create_container_image_resource(&image.container, source, resource);
+    }
+
+    if (image.cooked)
+    {
+        return create_cooked_image_resource(image.cooked, source, resource);
+    }
+
+    return create_image_resource(image.pixels, image.width, image.height, resource);
+}
+
+bool decode(void const* data, u64 size, char const* disk_path, Decoded_Image* image)
+{
+    if (cooked_validate(data, size, COOKED_TYPE_TEXTURE, sizeof(Cooked_Texture)))
+    {
+        image->cooked = data;
+        return true;
+    }
+
+    // Containers already hold GPU formats, so they are neither decoded nor cached.
+    if (texture_container_detect(data, size))
+    {
+        return texture_container_parse(data, size, &image->container);
+    }
+
+    // Hashing is far cheaper than decoding, so the cache is looked up by content before anything is decoded.
+    u64 source_hash = 0;
+    if (image_cache_is_enabled())
+    {
+        source_hash = hash_bytes(data, size, 0);
+        if (image_cache_find(source_hash, &image->entry))
+        {
+            image_cache_record_path(disk_path, source_hash);
+            image->cooked = image->entry.data;
+            return true;
+        }
+    }
+
+    u32 width;
+    u32 height;
+    u8* pixels = image_loader_decode(data, size, &width, &height);
+    if (!pixels)
+    {
+        LOG_ERROR("decode: Failed to decode image: %s", stbi_failure_reason());
+        return false;
+    }
+
+    if (image_cache_store(source_hash, pixels, width, height, &image->entry))
+    {
+        stbi_image_free(pixels);
+        image_cache_record_path(disk_path, source_hash);
+        image->cooked = image->entry.data;
+        return true;
+    }
+
     image->pixels = pixels;
     image->width = width;
     image->height = height;
-    image->channel_count = channel_count;
+    return true;
+}
+
+bool copy_to_destination(Decoded_Image const* image, Image_Load_Options const* options, PFN_image_destination get_destination, void* user_data, Image_Load_Info* info)
+{
+    u8 const* pixels = image->pixels;
+    u32 width = image->width;
+    u32 height = image->height;
+    u32 mip_count = 1;
+    Texture_Format format = TEXTURE_FORMAT_RGBA8;
+    bool has_transparency = false;
+    if (image->cooked)
+    {
+        if (!validate_cooked_texture(image->cooked))
+        {
+            LOG_ERROR("image_loader_load_into: Cooked texture is malformed");
+            return false;
+        }
+
+        pixels = (u8 const*)image->cooked + image->cooked->header.payload_offset;
+        width = image->cooked->width;
+        height = image->cooked->height;
+        mip_count = image->cooked->mip_count;
+        format = (Texture_Format)image->cooked->format;
+        has_transparency = (image->cooked->flags & COOKED_TEXTURE_FLAG_TRANSPARENT) != 0;
+    }
+
+    // Container levels are copied from their views one at a time, since they aren't laid out like an upload.
+    Texture_Container const* container = 0;
+    if (image->container.data)
+    {
+        container = &image->container;
+        pixels = texture_container_view(container, 0, 0).data;
+        width = container->width;
+        height = container->height;
+        mip_count = container->mip_count;
+        format = container->format;
+        has_transparency = container_has_transparency(container);
+    }
+
+    // Decoded pixels are scanned here rather than in the destination, which may be write-combined and slow to read.
+    if (!image->cooked && !container)
+    {
+        has_transparency = image_kernels_has_transparency(pixels, (u64)width * height);
+    }
+
+    bool generates_mips = mip_count == 1 && format == TEXTURE_FORMAT_RGBA8 && options && options->generate_mips;
+    bool decodes_blocks = format != TEXTURE_FORMAT_RGBA8 && options && options->decode_blocks;
+    bool compresses = format == TEXTURE_FORMAT_RGBA8 && options && options->compress_to != TEXTURE_FORMAT_RGBA8;
+
+    // Converting a chain of container levels needs it laid out contiguously first.
+    u8* gathered = 0;
+    u64 gathered_size = 0;
+    if (container && mip_count > 1 && (decodes_blocks || compresses))
+    {
+        gathered_size = block_compression_chain_size(format, width, height, mip_count);
+        gathered = memory_system_allocate(gathered_size, MEMORY_TAG_TEXTURE);
+        if (!gathered)
+        {
+            LOG_ERROR("image_loader_load_into: Failed to allocate %llu bytes to gather levels into", gathered_size);
+            return false;
+        }
+
+        texture_container_copy_chain(container, 0, gathered);
+        pixels = gathered;
+        container = 0;
+    }
+
+    // As the destination may be slow to read, a missing chain is generated, and blocks are decoded, in a buffer of
+    // their own rather than in place.
+    u8* chain = 0;
+    u64 chain_size = 0;
+    if (generates_mips)
+    {
+        chain = mip_chain_create(pixels, width, height, options->mip_filter, &mip_count, &chain_size);
+        if (chain)
+        {
+            pixels = chain;
+            container = 0;
+        }
+        else
+        {
+            mip_count = 1;
+        }
+    }
+    else if (decodes_blocks)
+    {
+        if (!block_compression_can_decode(pixels, width, height, mip_count, format))
+        {
+            LOG_ERROR("image_loader_load_into: The image holds BC7 blocks in modes that can't be decoded");
+            if (gathered)
+            {
+                memory_system_free(gathered, gathered_size, MEMORY_TAG_TEXTURE);
+            }
+            return false;
+        }
+
+        chain_size = mip_chain_size(width, height, mip_count);
+        chain = memory_system_allocate(chain_size, MEMORY_TAG_TEXTURE);
+        if (!chain)
+        {
+            LOG_ERROR("image_loader_load_into: Failed to allocate %llu bytes to decode blocks into", chain_size);
+            if (gathered)
+            {
+                memory_system_free(gathered, gathered_size, MEMORY_TAG_TEXTURE);
+            }
+            return false;
+        }
+
+        block_compression_decode(pixels, width, height, mip_count, format, chain);
+        pixels = chain;
+        container = 0;
+        format = TEXTURE_FORMAT_RGBA8;
+    }
+
+    Texture_Format destination_format = format;
+    if (compresses)
+    {
+        destination_format = block_compression_choose_format(options->compress_to, has_transparency);
+    }
+
+    u64 size = block_compression_chain_size(destination_format, width, height, mip_count);
+    u8* destination = get_destination(width, height, size, user_data);
+    if (destination)
+    {
+        if (destination_format != format)
+        {
+            block_compression_encode(pixels, width, height, mip_count, destination_format, options->compression_quality, destination);
+        }
+        else if (container)
+        {
+            texture_container_copy_chain(container, 0, destination);
+        }
+        else
+        {
+            memory_system_copy(destination, pixels, size);
+        }
+        info->width = width;
+        info->height = height;
+        info->mip_count = mip_count;
+        info->format = destination_format;
+        info->has_transparency = has_transparency;
+    }
+
+    if (chain)
+    {
+        mip_chain_destroy(chain, chain_size);
+    }
+    if (gathered)
+    {
+        memory_system_free(gathered, gathered_size, MEMORY_TAG_TEXTURE);
+    }
+
+    return destination != 0;
+}
+
+u8* image_loader_decode(void const* data, u64 size, u32* width, u32* height)
+{
+    if (!data || size > 0x7FFFFFFF)
+    {
+        return 0;
+    }
+
+    i32 required_channel_count = 4;
+    i32 channel_count;
+    i32 image_width;
+    i32 image_height;
+    u8* pixels = stbi_load_from_memory(data, (i32)size, &image_width, &image_height, &channel_count, required_channel_count);
+    *width = pixels ? image_width : 0;
+    *height = pixels ? image_height : 0;
+    return pixels;
+}
+
+void image_loader_free_pixels(u8* pixels)
+{
     stbi_image_free(pixels);
+}
+
+bool create_image_resource(u8* pixels, i32 width, i32 height, Resource_Data* resource)
+{
+    // Pixels are owned by the resource and released in unload.
+    Image_Resource* image = memory_system_allocate(sizeof(*image), MEMORY_TAG_RESOURCES);
+    image->pixels = pixels;
+    image->width = width;
+    image->height = height;
+    image->channel_count = 4;
+    image->format = TEXTURE_FORMAT_RGBA8;
+    image->mip_count = 1;
+    image->cooked = false;
+    image->pixels_size = (u64)width * height * 4;
+
+    resource->data = image;
+    resource->size = sizeof(*image);
+    resource->memory_size = sizeof(*image) + image->pixels_size;
+    return true;
+}
+
+bool create_cooked_image_resource(Cooked_Texture const* texture, File_View* source, Resource_Data* resource)
+{
+    Cooked_Header const* header = &texture->header;
+    if (!validate_cooked_texture(texture))
+    {
+        LOG_ERROR("create_cooked_image_resource: Cooked texture is malformed");
+        return false;
+    }
+
+    // A mapped payload is used in place and unmapped on unload. Anything else may be a transient read buffer, so it is copied.
+    u8* pixels = (u8*)texture + header->payload_offset;
+    if (source)
+    {
+        resource->view = *source;
+        source->data = 0;
+    }
+    else
+    {
+        pixels = memory_system_allocate(header->payload_size, MEMORY_TAG_TEXTURE);
+        memory_system_copy(pixels, (u8 const*)texture + header->payload_offset, header->payload_size);
+    }
+
+    Image_Resource* image = memory_system_allocate(sizeof(*image), MEMORY_TAG_RESOURCES);
+    image->pixels = pixels;
+    image->width = texture->width;
+    image->height = texture->height;
+    image->channel_count = 4;
+    image->format = (Texture_Format)texture->format;
+    image->mip_count = texture->mip_count;
+    image->cooked = true;
+    image->has_transparency = (texture->flags & COOKED_TEXTURE_FLAG_TRANSPARENT) != 0;
+    image->pixels_size = header->payload_size;
+
+    resource->data = image;
+    resource->size = sizeof(*image);
+    resource->memory_size = sizeof(*image) + image->pixels_size;
+    return true;
+}
+
+bool create_cached_image_resource(File_View view, Resource_Data* resource)
+{
+    // Cache entries stay mapped for as long as the resource lives, so the pixels are used in place.
+    Cooked_Texture const* texture = view.data;
+    if (!validate_cooked_texture(texture))
+    {
+        LOG_ERROR("create_cached_image_resource: Cached image is malformed");
+        filesystem_unmap(&view);
+        return false;
+    }
+
+    Image_Resource* image = memory_system_allocate(sizeof(*image), MEMORY_TAG_RESOURCES);
+    image->pixels = (u8*)texture + texture->header.payload_offset;
+    image->width = texture->width;
+    image->height = texture->height;
+    image->channel_count = 4;
+    image->format = (Texture_Format)texture->format;
+    image->mip_count = texture->mip_count;
+    image->cooked = true;
+    image->has_transparency = (texture->flags & COOKED_TEXTURE_FLAG_TRANSPARENT) != 0;
+    image->pixels_size = texture->header.payload_size;
+
+    resource->data = image;
+    resource->size = sizeof(*image);
+    resource->memory_size = sizeof(*image) + image->pixels_size;
+    resource->view = view;
+    return true;
+}
+
+bool create_container_image_resource(Texture_Container const* container, File_View* source, Resource_Data* resource)
+{
+    // Textures have no layers.
+    if (container->layer_count > 1)
+    {
+        LOG_WARNING("create_container_image_resource: Only layer 0 of %u is loaded", container->layer_count);
+    }
+
+    // A mapped chain already laid out for upload, as a single-layer DDS of large enough levels is, is used in place and
+    // unmapped on unload. Otherwise layer 0 is gathered into the upload layout, which also outlives the source bytes.
+    u64 size = block_compression_chain_size(container->format, container->width, container->height, container->mip_count);
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    block_compression_layout(container->format, container->width, container->height, 0, mips);
+    u8* pixels = (u8*)texture_container_view(container, 0, 0).data;
+    bool in_place = source != 0;
+    for (u32 i = 0; in_place && i < container->mip_count; ++i)
+    {
+        in_place = texture_container_view(container, i, 0).data == pixels + mips[i].offset;
+    }
+
+    if (in_place)
+    {
+        resource->view = *source;
+        source->data = 0;
+    }
+    else
+    {
+        pixels = memory_system_allocate(size, MEMORY_TAG_TEXTURE);
+        texture_container_copy_chain(container, 0, pixels);
+    }
+
+    Image_Resource* image = memory_system_allocate(sizeof(*image), MEMORY_TAG_RESOURCES);
+    image->pixels = pixels;
+    image->width = container->width;
+    image->height = container->height;
+    image->channel_count = 4;
+    image->format = container->format;
+    image->mip_count = container->mip_count;
+    image->cooked = true;
+    image->has_transparency = container_has_transparency(container);
+    image->pixels_size = size;
 
     resource->data = image;
     resource->size = sizeof(*image);
+    resource->memory_size = sizeof(*image) + image->pixels_size;
     return true;
 }
 
+bool container_has_transparency(Texture_Container const* container)
+{
+    Texture_Container_View base = texture_container_view(container, 0, 0);
+    if (container->format == TEXTURE_FORMAT_RGBA8)
+    {
+        return image_kernels_has_transparency(base.data, (u64)base.width * base.height);
+    }
+
+    return block_compression_has_transparency(base.data, base.width, base.height, container->format);
+}
+
+bool validate_cooked_texture(Cooked_Texture const* texture)
+{
+    // The payload is the whole mip chain, level 0 first, laid out by block_compression_layout so that it uploads as is.
+    Cooked_Header const* header = &texture->header;
+    if (texture->format >= TEXTURE_FORMAT_ENUM_COUNT || texture->channel_count != 4 || texture->mip_count == 0 ||
+        texture->mip_count > COOKED_TEXTURE_MAX_MIPS || header->payload_offset % MIP_ALIGNMENT != 0)
+    {
+        return false;
+    }
+
+    Texture_Format format = (Texture_Format)texture->format;
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 mip_count = block_compression_layout(format, texture->width, texture->height, header->payload_offset, mips);
+    if (texture->mip_count > mip_count)
+    {
+        return false;
+    }
+
+    for (u32 i = 0; i < texture->mip_count; ++i)
+    {
+        if (texture->mips[i].offset != mips[i].offset || texture->mips[i].size != mips[i].size)
+        {
+            return false;
+        }
+    }
+
+    return header->payload_size >= block_compression_chain_size(format, texture->width, texture->height, texture->mip_count);
+}
+
 void unload(Resource_Data* resource)
 {
     if (!resource)
     {
         LOG_WARNING("image_loader unload: Invalid parameters");
+        return;
+    }
+
+    Image_Resource* image = resource->data;
+    if (resource->view.data)
+    {
+        filesystem_unmap(&resource->view);
+    }
+    else if (image && image->cooked)
+    {
+        memory_system_free(image->pixels, image->pixels_size, MEMORY_TAG_TEXTURE);
+    }
+    else if (image)
+    {
+        stbi_image_free(image->pixels);
     }
 
     memory_system_free(resource->data, resource->size, MEMORY_TAG_RESOURCES);
     resource->data = 0;
     resource->size = 0;
+    resource->memory_size = 0;
 }
@@ -1,5 +1,66 @@
 #pragma once
 
-#include "systems/resource_system.h"
+#include "resources/block_compression.h"
+#include "resources/mip_chain.h"
+#include "systems/resource_manager.h"
 
 Resource_Loader* image_loader_create();
+
+/**
+ * @brief Builds the asset path the image loader resolves _filename_ through: the cooked image when one is mounted,
+ * otherwise the source image. _path_ must hold at least 256 characters.
+ */
+void image_loader_get_path(char const* filename, char* path);
+
+/**
+ * @brief Decodes an image that has already been read into memory, e.g. by a batched read. Cooked images and KTX2 and
+ * DDS containers are recognized by their header.
+ * The result is released with the image loader's unload, like one produced by load.
+ */
+bool image_loader_load_from_memory(void const* data, u64 size, Resource_Data* resource);
+
+/**
+ * @brief Receives the size of an image being loaded by image_loader_load_into and returns where to write its levels,
+ * in the format it reports laid out by block_compression_layout from offset 0, or 0 to abort the load.
+ */
+typedef u8* (* PFN_image_destination)(u32 width, u32 height, u64 size, void* user_data);
+
+typedef struct Image_Load_Options
+{
+    /** @brief Generates the mip chain of images that don't carry one. Cooked chains are loaded either way. */
+    bool generate_mips;
+    Mip_Filter mip_filter;
+    /** @brief Block compresses RGBA8 images, which BC1 turns into BC3 for those with transparency. RGBA8 keeps them as they are. */
+    Texture_Format compress_to;
+    Block_Compression_Quality compression_quality;
+    /** @brief Decodes cooked block compressed images to RGBA8, for renderers that can't sample them. */
+    bool decode_blocks;
+} Image_Load_Options;
+
+typedef struct Image_Load_Info
+{
+    u32 width;
+    u32 height;
+    u32 mip_count;
+    Texture_Format format;
+    bool has_transparency;
+} Image_Load_Info;
+
+/**
+ * @brief Loads an image straight into memory provided by the caller, e.g. a slice of the renderer's staging ring,
+ * instead of into a resource. Cooked images, image cache entries and the levels of layer 0 of KTX2 and DDS containers are
+ * copied once from their mapping, without being decoded; source images
+ * are decoded and copied out of the decoder's buffer, which is freed right away. Generated chains are built in system
+ * memory and copied once as well, as the destination may be slow to read. Compressed blocks are encoded straight into
+ * the destination.
+ * @param options May be 0, which loads level 0 of images without a chain.
+ */
+bool image_loader_load_into(char const* filename, Image_Load_Options const* options, PFN_image_destination get_destination, void* user_data, Image_Load_Info* info);
+
+/**
+ * @brief Decodes an encoded image (PNG, JPEG, ...) to tightly packed RGBA8 pixels. Used by tools and benchmarks.
+ * @return The pixels, to be released with image_loader_free_pixels, or 0 on failure.
+ */
+LIB_API u8* image_loader_decode(void const* data, u64 size, u32* width, u32* height);
+
+LIB_API void image_loader_free_pixels(u8* pixels);
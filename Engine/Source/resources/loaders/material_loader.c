@@ -3,17 +3,22 @@
 #include "config.h"
 #include "core/logger.h"
 #include "core/string_utils.h"
+#include "platform/filesystem.h"
+#include "resources/loaders/cooked_asset.h"
 #include "systems/memory_system.h"
 #include "third_party/cJSON/cJSON.h"
 
 static bool load(char const* filename, Resource_Data* resource);
 static void unload(Resource_Data* resource);
+static bool parse_string(cJSON const* json, char const* key, char* destination, u64 capacity);
+static u32 get_dependencies(Resource_Data const* resource, Resource_Dependency* dependencies, u32 capacity);
 
 Resource_Loader* material_loader_create()
 {
     Resource_Loader* loader = memory_system_allocate(sizeof(*loader), MEMORY_TAG_LOADERS);
     loader->load = load;
     loader->unload = unload;
+    loader->get_dependencies = get_dependencies;
     return loader;
 }
 
@@ -21,131 +26,158 @@ bool load(char const* filename, Resource_Data* resource)
 {
     if (!filename || !resource)
     {
-        LOG_WARNING("material loader unload: Invalid parameters");
+        LOG_FATAL("material_loader load: Invalid parameters");
+        return false;
     }
 
     char path[256];
-    string_format(path, "%s/%s/%s", ASSETS_DIR, "materials", filename);
-    cJSON* json = cJSON_Parse(path);
-    if (!json)
+    string_format(path, "%s/%s", "materials", filename);
+    memory_system_zero(&resource->view, sizeof(resource->view));
+
+    // A cooked material is the config itself, used in place from the mapping.
+    File_View view;
+    Cooked_Header const* header = cooked_asset_map(path, COOKED_TYPE_MATERIAL, sizeof(Cooked_Header), sizeof(Material_Config_Resource), &view);
+    if (header)
     {
-        char const* error = cJSON_GetErrorPtr();
-        if (error)
-        {
-            LOG_FATAL("material_loader load: %s", error);
-            return false;
-        }
+        resource->data = (u8*)view.data + header->payload_offset;
+        resource->size = sizeof(Material_Config_Resource);
+        resource->view = view;
+        return true;
+    }
 
-        LOG_FATAL("material_loader load: Unknown parsing error");
+    if (!filesystem_map_asset(path, &view))
+    {
+        LOG_FATAL("material_loader load: Failed to open %s", path);
         return false;
     }
 
     Material_Config_Resource* config = memory_system_allocate(sizeof(*config), MEMORY_TAG_RESOURCES);
-    cJSON* version = cJSON_GetObjectItemCaseSensitive(json, "version");
-    if (cJSON_IsString(version) && version->valuestring)
-    {
-        string_copy(config->version, version->valuestring);
-    }
-    else
+    bool result = material_loader_parse(view.data, view.size, config);
+    filesystem_unmap(&view);
+    if (!result)
     {
-        LOG_FATAL("material_loader load: Failed to parse version");
+        LOG_FATAL("material_loader load: Failed to parse %s", path);
+        memory_system_free(config, sizeof(*config), MEMORY_TAG_RESOURCES);
         return false;
     }
 
-    cJSON* name = cJSON_GetObjectItemCaseSensitive(json, "name");
-    if (cJSON_IsString(name) && name->valuestring)
-    {
-        string_copy(config->name, name->valuestring);
-    }
-    else
+    resource->data = config;
+    resource->size = sizeof(*config);
+    return true;
+}
+
+bool material_loader_parse(void const* json_text, u64 size, Material_Config_Resource* config)
+{
+    cJSON* json = cJSON_ParseWithLength(json_text, size);
+    if (!json)
     {
-        LOG_FATAL("load: Failed to parse name");
+        char const* error = cJSON_GetErrorPtr();
+        LOG_ERROR("material_loader_parse: %s", error ? error : "Unknown parsing error");
         return false;
     }
 
-    u8 index = 0;
-    cJSON* elem = 0;
+    memory_system_zero(config, sizeof(*config));
+    bool result = parse_string(json, "version", config->version, sizeof(config->version)) &&
+        parse_string(json, "name", config->name, sizeof(config->name)) &&
+        parse_string(json, "diffuse_map_name", config->diffuse_texture_name, sizeof(config->diffuse_texture_name));
+
     cJSON* diffuse_color = cJSON_GetObjectItemCaseSensitive(json, "diffuse_color");
-    cJSON_ArrayForEach(elem, diffuse_color)
+    if (result && (!cJSON_IsArray(diffuse_color) || cJSON_GetArraySize(diffuse_color) != 4))
     {
-        if (cJSON_IsNumber(elem))
-        {
-            config->diffuse_colour.raw[index] = (float)elem->valuedouble;
-            index++;
-        }
-        else
+        LOG_ERROR("material_loader_parse: Failed to parse diffuse_color");
+        result = false;
+    }
+
+    for (u32 i = 0; result && i < 4; ++i)
+    {
+        cJSON* component = cJSON_GetArrayItem(diffuse_color, i);
+        if (!cJSON_IsNumber(component))
         {
-            LOG_FATAL("load: Failed to parse duffuse_color");
-            return false;
+            LOG_ERROR("material_loader_parse: Failed to parse diffuse_color");
+            result = false;
+            break;
         }
+
+        config->diffuse_color[i] = (f32)component->valuedouble;
     }
 
-    cJSON* diffuse_map_name = cJSON_GetObjectItemCaseSensitive(json, "diffuse_map_name");
-    if (cJSON_IsString(diffuse_map_name) && diffuse_map_name->valuestring)
+    cJSON* type = cJSON_GetObjectItemCaseSensitive(json, "type");
+    if (result && cJSON_IsString(type) && string_equal(type->valuestring, "world"))
     {
-        string_copy(config->diffuse_texture_name, diffuse_map_name->valuestring);
+        config->type = MATERIAL_TYPE_WORLD;
     }
-    else
+    else if (result && cJSON_IsString(type) && string_equal(type->valuestring, "ui"))
     {
-        LOG_FATAL("load: Failed to parse duffuse_map_name");
-        return false;
+        config->type = MATERIAL_TYPE_UI;
+    }
+    else if (result)
+    {
+        LOG_ERROR("material_loader_parse: Unknown material type");
+        result = false;
     }
 
-    cJSON* type = cJSON_GetObjectItemCaseSensitive(json, "type");
-    if (cJSON_IsString(type) && type->valuestring)
+    cJSON* auto_release = cJSON_GetObjectItemCaseSensitive(json, "auto_release");
+    if (result && cJSON_IsBool(auto_release))
     {
-        if (string_equal(type->valuestring, "world"))
-        {
-            config->type = MATERIAL_TYPE_WORLD;
-        }
-        else if (string_equal(type->valuestring, "ui"))
-        {
-            config->type = MATERIAL_TYPE_UI;
-        }
-        else
-        {
-            LOG_FATAL("load: Unknown material type");
-            return false;
-        }
+        config->auto_release = cJSON_IsTrue(auto_release) ? 1 : 0;
     }
-    else
+    else if (result)
+    {
+        LOG_ERROR("material_loader_parse: Failed to parse auto_release");
+        result = false;
+    }
+
+    cJSON_Delete(json);
+    return result;
+}
+
+bool parse_string(cJSON const* json, char const* key, char* destination, u64 capacity)
+{
+    cJSON* item = cJSON_GetObjectItemCaseSensitive(json, key);
+    if (!cJSON_IsString(item) || !item->valuestring || string_length(item->valuestring) >= capacity)
     {
-        LOG_FATAL("load: Failed to parse type");
+        LOG_ERROR("material_loader_parse: Failed to parse %s. It must be a string shorter than %llu characters", key, capacity);
         return false;
     }
 
-    cJSON* auto_release = cJSON_GetObjectItemCaseSensitive(json, "auto_release");
-    if (cJSON_IsBool(auto_release))
+    string_copy(destination, item->valuestring);
+    return true;
+}
+
+u32 get_dependencies(Resource_Data const* resource, Resource_Dependency* dependencies, u32 capacity)
+{
+    Material_Config_Resource const* config = resource->data;
+    if (!config->diffuse_texture_name[0])
     {
-        if (cJSON_IsTrue(auto_release))
-        {
-            config->auto_release = true;
-        }
-        else
-        {
-            config->auto_release = false;
-        }
+        return 0;
     }
-    else
+
+    if (capacity > 0)
     {
-        LOG_FATAL("load: Failed to parse auto_release");
-        return false;
+        dependencies[0].type = RESOURCE_TYPE_IMAGE;
+        string_copy(dependencies[0].name, config->diffuse_texture_name);
     }
 
-    cJSON_Delete(json);
-    resource->data = config;
-    resource->size = sizeof(*config);
-    return true;
+    return 1;
 }
 
 void unload(Resource_Data* resource)
 {
     if (!resource)
     {
-        LOG_WARNING("material loader unload: Invalid parameters");
+        LOG_WARNING("material_loader unload: Invalid parameters");
+        return;
+    }
+
+    if (resource->view.data)
+    {
+        filesystem_unmap(&resource->view);
+    }
+    else
+    {
+        memory_system_free(resource->data, resource->size, MEMORY_TAG_RESOURCES);
     }
 
-    memory_system_free(resource->data, resource->size, MEMORY_TAG_RESOURCES);
     resource->data = 0;
     resource->size = 0;
 }
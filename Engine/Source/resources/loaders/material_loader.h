@@ -1,5 +1,13 @@
 #pragma once
 
-#include "systems/resource_system.h"
+#include "systems/resource_manager.h"
+#include "resources/resource_types.h"
 
 Resource_Loader* material_loader_create();
+
+/**
+ * @brief Parses a material authored as JSON into its fixed layout. Used by the cook tool, and by the loader
+ * when no cooked material is mounted.
+ * @return TRUE on success; otherwise FALSE and the reason is logged.
+ */
+LIB_API bool material_loader_parse(void const* json, u64 size, Material_Config_Resource* config);
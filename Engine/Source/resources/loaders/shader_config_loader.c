@@ -3,19 +3,27 @@
 #include "config.h"
 #include "core/logger.h"
 #include "core/string_utils.h"
-#include "renderer/vulkan_structure_initializers.h"
+#include "platform/filesystem.h"
+#include "resources/loaders/cooked_asset.h"
 #include "systems/memory_system.h"
 #include "third_party/cJSON/cJSON.h"
-#include "third_party/cglm/struct.h"
 
 static bool load(char const* filename, Resource_Data* resource);
 static void unload(Resource_Data* resource);
+static bool parse_string(cJSON const* item, char const* key, char* destination, u64 capacity);
+static bool parse_bool(cJSON const* json, char const* key, u32* value);
+static bool parse_optional_u32(cJSON const* json, char const* key, u32 default_value, u32* value);
+static bool parse_stages(cJSON const* json, Shader_Config_Resource* config);
+static bool parse_attributes(cJSON const* json, Shader_Config_Resource* config);
+static bool parse_uniforms(cJSON const* json, Shader_Config_Resource* config);
+static u32 get_dependencies(Resource_Data const* resource, Resource_Dependency* dependencies, u32 capacity);
 
 Resource_Loader* shader_config_loader_create()
 {
     Resource_Loader* loader = memory_system_allocate(sizeof(*loader), MEMORY_TAG_LOADERS);
     loader->load = load;
     loader->unload = unload;
+    loader->get_dependencies = get_dependencies;
     return loader;
 }
 
@@ -28,259 +36,280 @@ bool load(char const* filename, Resource_Data* resource)
     }
 
     char path[256];
-    string_format(path, "%s/%s/%s", ASSETS_DIR, "shaders", filename);
-    cJSON* json = cJSON_Parse(path);
-    if (!json)
+    string_format(path, "%s/%s", "shaders", filename);
+    memory_system_zero(&resource->view, sizeof(resource->view));
+
+    // A cooked config is the config itself, used in place from the mapping.
+    File_View view;
+    Cooked_Header const* header = cooked_asset_map(path, COOKED_TYPE_SHADER_CONFIG, sizeof(Cooked_Header), sizeof(Shader_Config_Resource), &view);
+    if (header)
     {
-        char const* error = cJSON_GetErrorPtr();
-        if (error)
-        {
-            LOG_FATAL("shader_config_loader load: %s", error);
-            return false;
-        }
+        resource->data = (u8*)view.data + header->payload_offset;
+        resource->size = sizeof(Shader_Config_Resource);
+        resource->view = view;
+        return true;
+    }
 
-        LOG_FATAL("shader_config_loader load: Unknown parsing error");
+    if (!filesystem_map_asset(path, &view))
+    {
+        LOG_FATAL("shader_config_loader load: Failed to open %s", path);
         return false;
     }
 
     Shader_Config_Resource* config = memory_system_allocate(sizeof(*config), MEMORY_TAG_RESOURCES);
-
-    cJSON* name = cJSON_GetObjectItemCaseSensitive(json, "name");
-    if (cJSON_IsString(name) && name->valuestring)
+    bool result = shader_config_loader_parse(view.data, view.size, config);
+    filesystem_unmap(&view);
+    if (!result)
     {
-        strcpy(config->name, name->valuestring);
-    }
-    else
-    {
-        LOG_FATAL("shader_config_loader load: Failed to parse name");
+        LOG_FATAL("shader_config_loader load: Failed to parse %s", path);
+        memory_system_free(config, sizeof(*config), MEMORY_TAG_RESOURCES);
         return false;
     }
 
-    cJSON* renderpass = cJSON_GetObjectItemCaseSensitive(json, "renderpass");
-    if (cJSON_IsString(renderpass) && renderpass->valuestring)
-    {
-        strcpy(config->renderpass_name, renderpass->valuestring);
-    }
-    else
+    resource->data = config;
+    resource->size = sizeof(*config);
+    return true;
+}
+
+bool shader_config_loader_parse(void const* json_text, u64 size, Shader_Config_Resource* config)
+{
+    cJSON* json = cJSON_ParseWithLength(json_text, size);
+    if (!json)
     {
-        LOG_FATAL("shader_config_loader load: Failed to parse renderpass");
+        char const* error = cJSON_GetErrorPtr();
+        LOG_ERROR("shader_config_loader_parse: %s", error ? error : "Unknown parsing error");
         return false;
     }
 
-    config->stages = DYNAMIC_ARRAY_CREATE(VkShaderStageFlagBits);
-    cJSON* elem = 0;
-    cJSON* stages = cJSON_GetObjectItemCaseSensitive(json, "stages");
-    if (cJSON_IsArray(stages))
+    memory_system_zero(config, sizeof(*config));
+    bool result = parse_string(json, "name", config->name, sizeof(config->name)) &&
+        parse_string(json, "renderpass", config->renderpass_name, sizeof(config->renderpass_name)) &&
+        parse_stages(json, config) &&
+        parse_attributes(json, config) &&
+        parse_bool(json, "per-material", &config->per_material) &&
+        parse_bool(json, "per-object", &config->per_object) &&
+        parse_uniforms(json, config) &&
+        parse_optional_u32(json, "max-descriptor-sets", 1024, &config->max_descriptor_set_count);
+
+    cJSON_Delete(json);
+    return result;
+}
+
+bool parse_string(cJSON const* json, char const* key, char* destination, u64 capacity)
+{
+    cJSON* item = cJSON_GetObjectItemCaseSensitive(json, key);
+    if (!cJSON_IsString(item) || !item->valuestring || string_length(item->valuestring) >= capacity)
     {
-        cJSON_ArrayForEach(elem, stages)
-        {
-            if (cJSON_IsString(elem) && elem->valuestring)
-            {
-                if (string_equal(elem->valuestring, "vertex"))
-                {
-                    dynamic_array_push_back(config->stages, VK_SHADER_STAGE_VERTEX_BIT);
-                }
-                else if (string_equal(elem->valuestring, "fragment"))
-                {
-                    dynamic_array_push_back(config->stages, VK_SHADER_STAGE_FRAGMENT_BIT);
-                }
-                else
-                {
-                    LOG_FATAL("shader_config_loader load: Unsupported shader stage");
-                    return false;
-                }
-            }
-            else
-            {
-                LOG_FATAL("shader_config_loader load: Failed to parse stages");
-                return false;
-            }
-        }
+        LOG_ERROR("shader_config_loader_parse: Failed to parse %s. It must be a string shorter than %llu characters", key, capacity);
+        return false;
     }
-    else
+
+    string_copy(destination, item->valuestring);
+    return true;
+}
+
+bool parse_bool(cJSON const* json, char const* key, u32* value)
+{
+    cJSON* item = cJSON_GetObjectItemCaseSensitive(json, key);
+    if (!cJSON_IsBool(item))
     {
-        LOG_FATAL("shader_config_loader load: Failed to parse stages");
+        LOG_ERROR("shader_config_loader_parse: Failed to parse %s", key);
         return false;
     }
 
-    config->spv_binaries = DYNAMIC_ARRAY_CREATE(char const*);
-    cJSON* spv_binaries = cJSON_GetObjectItemCaseSensitive(json, "spv_binaries");
-    if (cJSON_IsArray(spv_binaries))
+    *value = cJSON_IsTrue(item) ? 1 : 0;
+    return true;
+}
+
+bool parse_optional_u32(cJSON const* json, char const* key, u32 default_value, u32* value)
+{
+    cJSON* item = cJSON_GetObjectItemCaseSensitive(json, key);
+    if (!item)
     {
-        cJSON_ArrayForEach(elem, spv_binaries)
-        {
-            if (cJSON_IsString(elem) && elem->valuestring)
-            {
-                DYNAMIC_ARRAY_PUSH(&config->spv_binaries, elem->valuestring);
-            }
-            else
-            {
-                LOG_FATAL("shader_config_loader load: Failed to parse spv binaries");
-                return false;
-            }
-        }
+        *value = default_value;
+        return true;
     }
-    else
+
+    if (!cJSON_IsNumber(item) || item->valuedouble < 1 || item->valuedouble > INVALID_ID - 1)
     {
-        LOG_FATAL("shader_config_loader load: Failed to parse spv binaries");
+        LOG_ERROR("shader_config_loader_parse: Failed to parse %s. It must be a positive integer", key);
         return false;
     }
 
-    ASSERT(config->stages->size == config->spv_binaries->size);
-
-    Dynamic_Array* vertex_binding_descriptions = DYNAMIC_ARRAY_CREATE(VkVertexInputBindingDescription);
-    Dynamic_Array* vertex_attribute_descriptions = DYNAMIC_ARRAY_CREATE(VkVertexInputAttributeDescription);
-    cJSON* attributes = cJSON_GetObjectItemCaseSensitive(json, "attributes");
-    if (cJSON_IsObject(attributes))
-    {
-        u32 i = 0;
-        cJSON_ArrayForEach(elem, attributes)
-        {
-            cJSON* item = cJSON_GetObjectItemCaseSensitive(elem, elem->string);
-            if (cJSON_IsString(item) && item->valuestring)
-            {
-                VkVertexInputBindingDescription binding;
-                VkVertexInputAttributeDescription attribute;
-                if (string_equal(item->valuestring, "vec2"))
-                {
-                    binding = vertex_input_binding_description(i, sizeof(vec2s));
-                    attribute = vertex_input_attribute_description(i, binding.binding, VK_FORMAT_R32G32_SFLOAT, 0);
-                }
-                else if (string_equal(item->valuestring, "vec3"))
-                {
-                    binding = vertex_input_binding_description(i, sizeof(vec3s));
-                    attribute = vertex_input_attribute_description(i, binding.binding, VK_FORMAT_R32G32B32_SFLOAT, 0);
-                }
-                else
-                {
-                    LOG_FATAL("shader_config_loader load: Failed to parse attributes");
-                    return false;
-                }
-
-                dynamic_array_push_back(vertex_binding_descriptions, &binding);
-                dynamic_array_push_back(vertex_attribute_descriptions, &attribute);
-            }
-            else
-            {
-                LOG_FATAL("shader_config_loader load: Failed to parse attributes");
-                return false;
-            }
-        }
+    *value = (u32)item->valuedouble;
+    return true;
+}
 
-        dynamic_array_destroy(vertex_binding_descriptions);
-        dynamic_array_destroy(vertex_attribute_descriptions);
-        config->vertex_input_state = pipeline_vertex_input_state_create_info(vertex_binding_descriptions->data, vertex_binding_descriptions->size, vertex_attribute_descriptions->data, vertex_attribute_descriptions->size);
-    }
-    else
+bool parse_stages(cJSON const* json, Shader_Config_Resource* config)
+{
+    cJSON* stages = cJSON_GetObjectItemCaseSensitive(json, "stages");
+    cJSON* spv_binaries = cJSON_GetObjectItemCaseSensitive(json, "spv_binaries");
+    if (!cJSON_IsArray(stages) || !cJSON_IsArray(spv_binaries) || cJSON_GetArraySize(stages) != cJSON_GetArraySize(spv_binaries) ||
+        cJSON_GetArraySize(stages) > COOKED_SHADER_MAX_STAGES)
     {
-        LOG_FATAL("shader_config_loader load: Failed to parse attributes");
+        LOG_ERROR("shader_config_loader_parse: Failed to parse stages. There must be one spv binary per stage, and at most %u stages", COOKED_SHADER_MAX_STAGES);
         return false;
     }
 
-    cJSON* per_material = cJSON_GetObjectItemCaseSensitive(json, "per-material");
-    if (cJSON_IsBool(per_material))
+    cJSON* stage = 0;
+    cJSON_ArrayForEach(stage, stages)
     {
-        if (cJSON_IsTrue(per_material))
+        Cooked_Shader_Stage_Config* stage_config = &config->stages[config->stage_count];
+        if (cJSON_IsString(stage) && string_equal(stage->valuestring, "vertex"))
         {
-            config->per_material = true;
+            stage_config->stage = COOKED_SHADER_STAGE_VERTEX;
+        }
+        else if (cJSON_IsString(stage) && string_equal(stage->valuestring, "fragment"))
+        {
+            stage_config->stage = COOKED_SHADER_STAGE_FRAGMENT;
         }
         else
         {
-            config->per_material = false;
+            LOG_ERROR("shader_config_loader_parse: Unsupported shader stage");
+            return false;
+        }
+
+        cJSON* binary = cJSON_GetArrayItem(spv_binaries, config->stage_count);
+        if (!cJSON_IsString(binary) || string_length(binary->valuestring) >= sizeof(stage_config->spv_binary))
+        {
+            LOG_ERROR("shader_config_loader_parse: Failed to parse spv binaries");
+            return false;
         }
+
+        string_copy(stage_config->spv_binary, binary->valuestring);
+        config->stage_count++;
     }
-    else
+
+    return true;
+}
+
+bool parse_attributes(cJSON const* json, Shader_Config_Resource* config)
+{
+    cJSON* attributes = cJSON_GetObjectItemCaseSensitive(json, "attributes");
+    if (!cJSON_IsObject(attributes) || cJSON_GetArraySize(attributes) > COOKED_SHADER_MAX_ATTRIBUTES)
     {
-        LOG_FATAL("shader_config_loader load: Failed to parse per-material");
+        LOG_ERROR("shader_config_loader_parse: Failed to parse attributes. At most %u are supported", COOKED_SHADER_MAX_ATTRIBUTES);
         return false;
     }
 
-    cJSON* per_object = cJSON_GetObjectItemCaseSensitive(json, "per-object");
-    if (cJSON_IsBool(per_object))
+    // Attributes are named members, in location order.
+    cJSON* attribute = 0;
+    cJSON_ArrayForEach(attribute, attributes)
     {
-        if (cJSON_IsTrue(per_object))
+        Cooked_Vertex_Attribute* attribute_config = &config->attributes[config->attribute_count];
+        if (!cJSON_IsString(attribute) || string_length(attribute->string) >= sizeof(attribute_config->name))
         {
-            config->per_object = true;
+            LOG_ERROR("shader_config_loader_parse: Failed to parse attributes");
+            return false;
+        }
+
+        if (string_equal(attribute->valuestring, "vec2"))
+        {
+            attribute_config->type = COOKED_ATTRIBUTE_TYPE_VEC2;
+            attribute_config->size = 8;
+        }
+        else if (string_equal(attribute->valuestring, "vec3"))
+        {
+            attribute_config->type = COOKED_ATTRIBUTE_TYPE_VEC3;
+            attribute_config->size = 12;
+        }
+        else if (string_equal(attribute->valuestring, "vec4"))
+        {
+            attribute_config->type = COOKED_ATTRIBUTE_TYPE_VEC4;
+            attribute_config->size = 16;
         }
         else
         {
-            config->per_object = false;
+            LOG_ERROR("shader_config_loader_parse: Unsupported attribute type %s", attribute->valuestring);
+            return false;
         }
+
+        string_copy(attribute_config->name, attribute->string);
+        config->attribute_count++;
     }
-    else
+
+    return true;
+}
+
+bool parse_uniforms(cJSON const* json, Shader_Config_Resource* config)
+{
+    // One object per descriptor set scope (frame, material, object), holding the uniforms by name.
+    cJSON* uniforms = cJSON_GetObjectItemCaseSensitive(json, "uniforms");
+    if (!cJSON_IsArray(uniforms))
     {
-        LOG_FATAL("shader_config_loader load: Failed to parse per-object");
+        LOG_ERROR("shader_config_loader_parse: Failed to parse uniforms");
         return false;
     }
 
-    config->uniforms = DYNAMIC_ARRAY_CREATE(Uniform_Config);
-    cJSON* uniforms = cJSON_GetObjectItemCaseSensitive(json, "uniforms");
-    if (cJSON_IsArray(uniforms))
+    u32 scope = 0;
+    cJSON* group = 0;
+    cJSON_ArrayForEach(group, uniforms)
     {
-        u8 i = 0;
-        cJSON_ArrayForEach(elem, uniforms)
+        if (!cJSON_IsObject(group))
         {
-            if (cJSON_IsObject(elem))
+            LOG_ERROR("shader_config_loader_parse: Failed to parse uniforms");
+            return false;
+        }
+
+        cJSON* uniform = 0;
+        cJSON_ArrayForEach(uniform, group)
+        {
+            if (config->uniform_count == COOKED_SHADER_MAX_UNIFORMS)
             {
-                cJSON* item = 0;
-                cJSON_ArrayForEach(item, elem)
-                {
-                    Uniform_Config uniform;
-                    strcpy(uniform.name, item->string);
-
-                    cJSON* item = cJSON_GetObjectItemCaseSensitive(elem, elem->string);
-                    if (cJSON_IsString(item) && item->valuestring)
-                    {
-                        if (string_equal(item->valuestring, "vec4"))
-                        {
-                            uniform.size = 16;
-                            uniform.type = UNIFORM_TYPE_VEC4;
-                        }
-                        else if (string_equal(item->valuestring, "mat4"))
-                        {
-                            uniform.size = 64;
-                            uniform.type = UNIFORM_TYPE_MAT4;
-                        }
-                        else if (string_equal(item->valuestring, "sampler"))
-                        {
-                            uniform.size = 0;
-                            uniform.type = UNIFORM_TYPE_SAMPLER;
-                        }
-                        else
-                        {
-                            LOG_FATAL("shader_config_loader load: Failed to parse uniforms");
-                            return false;
-                        }
-
-                        uniform.scope = DESCRIPTOR_SET_SCOPE_PER_FRAME + i;
-                        DYNAMIC_ARRAY_PUSH(&config->uniforms, uniform);
-                    }
-                    else
-                    {
-                        LOG_FATAL("shader_config_loader load: Failed to parse uniforms");
-                        return false;
-                    }
-                }
-
-                i++;
+                LOG_ERROR("shader_config_loader_parse: Too many uniforms. At most %u are supported", COOKED_SHADER_MAX_UNIFORMS);
+                return false;
+            }
+
+            Uniform_Config* uniform_config = &config->uniforms[config->uniform_count];
+            if (!cJSON_IsString(uniform) || string_length(uniform->string) >= sizeof(uniform_config->name))
+            {
+                LOG_ERROR("shader_config_loader_parse: Failed to parse uniforms");
+                return false;
+            }
+
+            if (string_equal(uniform->valuestring, "vec4"))
+            {
+                uniform_config->type = COOKED_UNIFORM_TYPE_VEC4;
+                uniform_config->size = 16;
+            }
+            else if (string_equal(uniform->valuestring, "mat4"))
+            {
+                uniform_config->type = COOKED_UNIFORM_TYPE_MAT4;
+                uniform_config->size = 64;
+            }
+            else if (string_equal(uniform->valuestring, "sampler"))
+            {
+                uniform_config->type = COOKED_UNIFORM_TYPE_SAMPLER;
+                uniform_config->size = 0;
             }
             else
             {
-                LOG_FATAL("shader_config_loader load: Failed to parse uniforms");
+                LOG_ERROR("shader_config_loader_parse: Unsupported uniform type %s", uniform->valuestring);
                 return false;
             }
+
+            string_copy(uniform_config->name, uniform->string);
+            uniform_config->scope = DESCRIPTOR_SET_SCOPE_PER_FRAME + scope;
+            config->uniform_count++;
         }
+
+        scope++;
     }
-    else
+
+    return true;
+}
+
+u32 get_dependencies(Resource_Data const* resource, Resource_Dependency* dependencies, u32 capacity)
+{
+    // Each stage needs its SPIR-V binary.
+    Shader_Config_Resource const* config = resource->data;
+    for (u32 i = 0; i < config->stage_count && i < capacity; ++i)
     {
-        LOG_FATAL("shader_config_loader load: Failed to parse uniforms");
-        return false;
+        dependencies[i].type = RESOURCE_TYPE_BINARY;
+        string_copy(dependencies[i].name, config->stages[i].spv_binary);
     }
 
-    cJSON_Delete(json);
-
-    resource->size = sizeof(*config);
-    resource->data = config;
+    return config->stage_count;
 }
 
 void unload(Resource_Data* resource)
@@ -288,11 +317,18 @@ void unload(Resource_Data* resource)
     if (!resource)
     {
         LOG_WARNING("shader_config_loader unload: Invalid parameters");
+        return;
+    }
+
+    if (resource->view.data)
+    {
+        filesystem_unmap(&resource->view);
+    }
+    else
+    {
+        memory_system_free(resource->data, resource->size, MEMORY_TAG_RESOURCES);
     }
 
-    dynamic_array_destroy(((Shader_Config_Resource*)resource->data)->attributes);
-    dynamic_array_destroy(((Shader_Config_Resource*)resource->data)->attributes);
-    dynamic_array_destroy(((Shader_Config_Resource*)resource->data)->spv_binaries);
-    dynamic_array_destroy(((Shader_Config_Resource*)resource->data)->stages);
-    memory_system_free(resource->data, resource->size, MEMORY_TAG_RESOURCES);
+    resource->data = 0;
+    resource->size = 0;
 }
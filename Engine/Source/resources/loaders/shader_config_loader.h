@@ -3,3 +3,10 @@
 #include "resources/resource_types.h"
 
 Resource_Loader* shader_config_loader_create();
+
+/**
+ * @brief Parses a shader config authored as JSON into its fixed layout. Used by the cook tool, and by the loader
+ * when no cooked config is mounted.
+ * @return TRUE on success; otherwise FALSE and the reason is logged.
+ */
+LIB_API bool shader_config_loader_parse(void const* json, u64 size, Shader_Config_Resource* config);
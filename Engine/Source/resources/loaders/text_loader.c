@@ -23,26 +23,24 @@ bool load(char const* filename, Resource_Data* resource)
     }
 
     char path[256];
-    string_format(path, "%s/%s", ASSETS_DIR, filename);
-    File_Handle handle;
-    if (!filesystem_open(path, FILE_ACCESS_MODE_READ, &handle))
+    string_format(path, "%s", filename);
+    // Mapped without a copy. The text is not null-terminated, so consumers must respect resource->size.
+    File_View view;
+    if (!filesystem_map_asset(path, &view))
     {
-        LOG_FATAL("text loader load: Failed to open %s for text reading", path);
+        LOG_FATAL("text loader load: Failed to map %s for text reading", path);
         return false;
     }
 
-    u32 data_size = filesystem_size(&handle);
-    u8* data = memory_system_allocate(data_size, MEMORY_TAG_RESOURCES);
-    if (!filesystem_read(&handle, data, data_size))
+    if (view.size > (u32)-1)
     {
-        LOG_FATAL("text loader load: Failed to read %s", path);
-        filesystem_close(&handle);
+        LOG_FATAL("text loader load: %s is too large (%llu bytes)", path, view.size);
+        filesystem_unmap(&view);
         return false;
     }
 
-    filesystem_close(&handle);
-    resource->data = data;
-    resource->size = data_size;
+    resource->data = (void*)view.data;
+    resource->size = (u32)view.size;
     return true;
 }
 
@@ -53,7 +51,10 @@ void unload(Resource_Data* resource)
         LOG_WARNING("text loader unload: Invalid parameters");
     }
 
-    memory_system_free(resource->data, resource->size, MEMORY_TAG_RESOURCES);
+    File_View view;
+    view.data = resource->data;
+    view.size = resource->size;
+    filesystem_unmap(&view);
     resource->data = 0;
     resource->size = 0;
 }
@@ -0,0 +1,333 @@
+#include "mip_chain.h"
+
+#include "core/logger.h"
+#include "resources/image_kernels.h"
+#include "systems/job_system.h"
+#include "systems/memory_system.h"
+
+#include <math.h>
+
+// Output texels filtered at a time, which keeps the converted source rows on the stack.
+#define DOWNSAMPLE_SPAN 64
+#define MAX_TAP_COUNT 8
+#define SPAN_SOURCE_WIDTH (DOWNSAMPLE_SPAN * 2 + MAX_TAP_COUNT - 2)
+// Levels smaller than this are filtered on the calling thread, as splitting them costs more than it saves.
+#define MIP_CHAIN_JOB_TEXELS (128 * 128)
+#define MIP_CHAIN_MAX_BANDS 32
+
+/**
+ * @brief A separable filter halving an image. Tap k of output texel x reads source texel 2x + first_tap + k, the same
+ * weights applying across and down.
+ */
+typedef struct Mip_Kernel
+{
+    u32 tap_count;
+    i32 first_tap;
+    f32 weights[MAX_TAP_COUNT];
+} Mip_Kernel;
+
+/**
+ * @brief Rows of one level that are filtered together, on one thread, across columns first_column to
+ * first_column + column_count - 1.
+ */
+typedef struct Downsample_Band
+{
+    u8 const* source;
+    u32 source_width;
+    u32 source_height;
+    u8* destination;
+    u32 width;
+    u32 height;
+    u32 first_row;
+    u32 row_count;
+    u32 first_column;
+    u32 column_count;
+    Mip_Kernel const* kernel;
+} Downsample_Band;
+
+static Mip_Kernel const* get_kernel(Mip_Filter filter);
+static u32 get_max_band_count();
+static void filter_level(Downsample_Band const* level, u32 max_band_count);
+static bool footprint(Mip_Kernel const* kernel, u32 source_first, u32 source_count, u32 size, u32* first, u32* count);
+static f64 bessel_i0(f64 x);
+static void downsample_job(void* params);
+static void downsample(Downsample_Band const* band);
+static void convert_span(u8 const* row, u32 row_width, i32 start, u32 count, f32* linear);
+
+u32 mip_chain_layout(u32 width, u32 height, u64 offset, Cooked_Mip* mips)
+{
+    u32 mip_count = 1;
+    while (mip_count < COOKED_TEXTURE_MAX_MIPS && ((width >> mip_count) || (height >> mip_count)))
+    {
+        mip_count++;
+    }
+
+    for (u32 i = 0; i < mip_count; ++i)
+    {
+        mips[i].width = width >> i ? width >> i : 1;
+        mips[i].height = height >> i ? height >> i : 1;
+        mips[i].size = (u64)mips[i].width * mips[i].height * 4;
+        mips[i].offset = offset;
+        offset = (offset + mips[i].size + MIP_ALIGNMENT - 1) & ~(u64)(MIP_ALIGNMENT - 1);
+    }
+
+    return mip_count;
+}
+
+u64 mip_chain_size(u32 width, u32 height, u32 mip_count)
+{
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 full_count = mip_chain_layout(width, height, 0, mips);
+    u32 count = mip_count < full_count ? mip_count : full_count;
+    return count > 0 ? mips[count - 1].offset + mips[count - 1].size : 0;
+}
+
+u32 mip_chain_level_for_size(u32 width, u32 height, u32 mip_count, u32 size)
+{
+    u32 longer = width > height ? width : height;
+    u32 level = 0;
+    while (level + 1 < mip_count && (longer >> (level + 1)) >= size)
+    {
+        level++;
+    }
+
+    return level;
+}
+
+void mip_chain_generate(u8* base, Cooked_Mip const* mips, u32 mip_count, Mip_Filter filter)
+{
+    Mip_Kernel const* kernel = get_kernel(filter);
+    u32 max_band_count = get_max_band_count();
+    for (u32 i = 1; i < mip_count; ++i)
+    {
+        Downsample_Band level = {};
+        level.source = base + mips[i - 1].offset;
+        level.source_width = mips[i - 1].width;
+        level.source_height = mips[i - 1].height;
+        level.destination = base + mips[i].offset;
+        level.width = mips[i].width;
+        level.height = mips[i].height;
+        level.row_count = mips[i].height;
+        level.column_count = mips[i].width;
+        level.kernel = kernel;
+        filter_level(&level, max_band_count);
+    }
+}
+
+u32 mip_chain_generate_region(u8* base, Cooked_Mip const* mips, u32 mip_count, Mip_Filter filter, Mip_Region* regions)
+{
+    Mip_Kernel const* kernel = get_kernel(filter);
+    u32 max_band_count = get_max_band_count();
+    for (u32 i = 1; i < mip_count; ++i)
+    {
+        Downsample_Band level = {};
+        level.source = base + mips[i - 1].offset;
+        level.source_width = mips[i - 1].width;
+        level.source_height = mips[i - 1].height;
+        level.destination = base + mips[i].offset;
+        level.width = mips[i].width;
+        level.height = mips[i].height;
+        level.kernel = kernel;
+
+        // Texels past the end of a level with an odd size may be read by no texel below it.
+        Mip_Region const* source = &regions[i - 1];
+        if (!footprint(kernel, source->x, source->width, level.width, &level.first_column, &level.column_count) ||
+            !footprint(kernel, source->y, source->height, level.height, &level.first_row, &level.row_count))
+        {
+            return i;
+        }
+
+        filter_level(&level, max_band_count);
+        regions[i].x = level.first_column;
+        regions[i].y = level.first_row;
+        regions[i].width = level.column_count;
+        regions[i].height = level.row_count;
+    }
+
+    return mip_count;
+}
+
+u8* mip_chain_create(u8 const* pixels, u32 width, u32 height, Mip_Filter filter, u32* mip_count, u64* size)
+{
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    *mip_count = mip_chain_layout(width, height, 0, mips);
+    *size = mips[*mip_count - 1].offset + mips[*mip_count - 1].size;
+
+    u8* chain = memory_system_allocate(*size, MEMORY_TAG_TEXTURE);
+    if (!chain)
+    {
+        LOG_ERROR("mip_chain_create: Failed to allocate %llu bytes", *size);
+        return 0;
+    }
+
+    memory_system_copy(chain, pixels, mips[0].size);
+    mip_chain_generate(chain, mips, *mip_count, filter);
+    return chain;
+}
+
+void mip_chain_destroy(u8* chain, u64 size)
+{
+    memory_system_free(chain, size, MEMORY_TAG_TEXTURE);
+}
+
+Mip_Kernel const* get_kernel(Mip_Filter filter)
+{
+    static Mip_Kernel const box = { 2, 0, { 0.5f, 0.5f } };
+    if (filter == MIP_FILTER_BOX)
+    {
+        return &box;
+    }
+
+    // Filled on first use. Racing threads write the same values, so no lock is needed.
+    static Mip_Kernel kaiser;
+    static bool volatile initialized = false;
+    if (!initialized)
+    {
+        // The taps sit 0.5 to 3.5 texels either side of the centre of the output texel. Each weighs a sinc cut off at
+        // the new Nyquist frequency, under a Kaiser window that reaches zero 4 texels out.
+        f64 const pi = 3.14159265358979323846;
+        f64 const beta = 4.0;
+        f64 weights[MAX_TAP_COUNT];
+        f64 total = 0.0;
+        for (u32 k = 0; k < MAX_TAP_COUNT; ++k)
+        {
+            f64 distance = k - 3.5;
+            f64 sinc = sin(pi * distance * 0.5) / (pi * distance * 0.5);
+            f64 t = distance / 4.0;
+            weights[k] = sinc * bessel_i0(beta * sqrt(1.0 - t * t)) / bessel_i0(beta);
+            total += weights[k];
+        }
+
+        kaiser.tap_count = MAX_TAP_COUNT;
+        kaiser.first_tap = -3;
+        for (u32 k = 0; k < MAX_TAP_COUNT; ++k)
+        {
+            kaiser.weights[k] = (f32)(weights[k] / total);
+        }
+        initialized = true;
+    }
+
+    return &kaiser;
+}
+
+u32 get_max_band_count()
+{
+    u32 max_band_count = job_system_worker_count() + 1;
+    return max_band_count < MIP_CHAIN_MAX_BANDS ? max_band_count : MIP_CHAIN_MAX_BANDS;
+}
+
+void filter_level(Downsample_Band const* level, u32 max_band_count)
+{
+    u32 band_count = (u64)level->column_count * level->row_count >= MIP_CHAIN_JOB_TEXELS ? max_band_count : 1;
+    band_count = band_count < level->row_count ? band_count : level->row_count;
+    if (band_count <= 1)
+    {
+        downsample(level);
+        return;
+    }
+
+    // Every level reads the one above it, so only the rows of a level are split and the levels run in order.
+    Downsample_Band bands[MIP_CHAIN_MAX_BANDS];
+    Job_Counter counter = {};
+    u32 first_row = level->first_row;
+    for (u32 b = 0; b < band_count; ++b)
+    {
+        bands[b] = *level;
+        bands[b].first_row = first_row;
+        bands[b].row_count = level->first_row + (u32)((u64)level->row_count * (b + 1) / band_count) - first_row;
+        first_row += bands[b].row_count;
+        job_system_submit(downsample_job, &bands[b], &counter);
+    }
+    job_system_wait(&counter);
+}
+
+bool footprint(Mip_Kernel const* kernel, u32 source_first, u32 source_count, u32 size, u32* first, u32* count)
+{
+    // Texel x reads source texels 2x + first_tap up to 2x + first_tap + tap_count - 1, so the texels reading the source
+    // span run from the first whose last tap reaches it to the last whose first tap doesn't pass it. Halving rounds
+    // down, negative values included.
+    i32 low = (i32)source_first - kernel->first_tap - (i32)kernel->tap_count + 2;
+    i32 high = (i32)(source_first + source_count) - 1 - kernel->first_tap;
+    low = low >= 0 ? low / 2 : -((1 - low) / 2);
+    high = high >= 0 ? high / 2 : -((1 - high) / 2);
+    low = low > 0 ? low : 0;
+    high = high < (i32)size - 1 ? high : (i32)size - 1;
+    if (source_count == 0 || low > high)
+    {
+        return false;
+    }
+
+    *first = (u32)low;
+    *count = (u32)(high - low + 1);
+    return true;
+}
+
+f64 bessel_i0(f64 x)
+{
+    // The power series converges quickly for the small arguments of a window.
+    f64 sum = 1.0;
+    f64 term = 1.0;
+    for (u32 k = 1; k < 32 && term > sum * 1e-12; ++k)
+    {
+        f64 factor = x * 0.5 / k;
+        term *= factor * factor;
+        sum += term;
+    }
+
+    return sum;
+}
+
+void downsample_job(void* params)
+{
+    downsample(params);
+}
+
+void downsample(Downsample_Band const* band)
+{
+    // The source rows under a span of output texels are converted to linear, blended down to one row and filtered
+    // across. Texels beyond the edges of the level repeat the edge texels.
+    Mip_Kernel const* kernel = band->kernel;
+    f32 rows[MAX_TAP_COUNT][SPAN_SOURCE_WIDTH * 4];
+    f32 const* row_pointers[MAX_TAP_COUNT];
+    f32 column[SPAN_SOURCE_WIDTH * 4];
+    f32 filtered[DOWNSAMPLE_SPAN * 4];
+    for (u32 y = band->first_row; y < band->first_row + band->row_count; ++y)
+    {
+        u32 x_end = band->first_column + band->column_count;
+        for (u32 x_start = band->first_column; x_start < x_end; x_start += DOWNSAMPLE_SPAN)
+        {
+            u32 count = x_end - x_start < DOWNSAMPLE_SPAN ? x_end - x_start : DOWNSAMPLE_SPAN;
+            i32 source_x = (i32)(x_start * 2) + kernel->first_tap;
+            u32 source_count = count * 2 + kernel->tap_count - 2;
+            for (u32 k = 0; k < kernel->tap_count; ++k)
+            {
+                i32 source_y = (i32)(y * 2) + kernel->first_tap + (i32)k;
+                source_y = source_y < 0 ? 0 : source_y >= (i32)band->source_height ? (i32)band->source_height - 1 : source_y;
+                convert_span(band->source + (u64)source_y * band->source_width * 4, band->source_width, source_x, source_count, rows[k]);
+                row_pointers[k] = rows[k];
+            }
+
+            image_kernels_blend_rows(row_pointers, kernel->weights, kernel->tap_count, column, source_count);
+            image_kernels_downsample_row(column, kernel->weights, kernel->tap_count, filtered, count);
+            image_kernels_linear_to_srgb(filtered, band->destination + ((u64)y * band->width + x_start) * 4, count);
+        }
+    }
+}
+
+void convert_span(u8 const* row, u32 row_width, i32 start, u32 count, f32* linear)
+{
+    // Spans always overlap the row, as they start left of its end and reach right of its start.
+    i32 end = start + (i32)count;
+    i32 first = start > 0 ? start : 0;
+    i32 last = end < (i32)row_width ? end : (i32)row_width;
+    image_kernels_srgb_to_linear(row + (u64)first * 4, linear + (first - start) * 4, (u64)(last - first));
+
+    for (i32 x = start; x < first; ++x)
+    {
+        memory_system_copy(linear + (x - start) * 4, linear + (first - start) * 4, 4 * sizeof(f32));
+    }
+    for (i32 x = last; x < end; ++x)
+    {
+        memory_system_copy(linear + (x - start) * 4, linear + (last - 1 - start) * 4, 4 * sizeof(f32));
+    }
+}
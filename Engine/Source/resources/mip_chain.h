@@ -0,0 +1,73 @@
+#pragma once
+
+#include "defines.h"
+#include "resources/cooked_format.h"
+
+/** @brief Alignment of every level from the start of its file, so rows of any level can be copied with aligned SIMD loads. */
+#define MIP_ALIGNMENT 16
+
+/**
+ * @brief How each level is filtered from the one above it. Both filter colour in linear space, so mips keep the
+ * brightness of the image.
+ */
+typedef enum Mip_Filter
+{
+    /** @brief Averages 2x2 texels. Cheapest, slightly blurry and prone to aliasing fine patterns. */
+    MIP_FILTER_BOX,
+    /** @brief A Kaiser windowed sinc over 8x8 texels. Sharper and with less aliasing, at several times the cost. */
+    MIP_FILTER_KAISER
+} Mip_Filter;
+
+/**
+ * @brief Texels of one level, width x height of them from column x and row y.
+ */
+typedef struct Mip_Region
+{
+    u32 x;
+    u32 y;
+    u32 width;
+    u32 height;
+} Mip_Region;
+
+/**
+ * @brief Lays out the full mip chain of a width x height RGBA8 image down to 1x1, at most COOKED_TEXTURE_MAX_MIPS levels.
+ * @param offset Where level 0 starts. Must be a multiple of MIP_ALIGNMENT.
+ * @param mips Receives the levels, largest first.
+ * @return The number of levels.
+ */
+LIB_API u32 mip_chain_layout(u32 width, u32 height, u64 offset, Cooked_Mip* mips);
+
+/**
+ * @return The size of the first _mip_count_ levels of the chain laid out from offset 0.
+ */
+LIB_API u64 mip_chain_size(u32 width, u32 height, u32 mip_count);
+
+/**
+ * @brief Picks the smallest of the first _mip_count_ levels whose longer side is still at least _size_ texels, or the
+ * last of them if none is that small. Level 0 is picked for sizes larger than the image.
+ */
+LIB_API u32 mip_chain_level_for_size(u32 width, u32 height, u32 mip_count, u32 size);
+
+/**
+ * @brief Fills levels 1 and up from level 0, each level filtered from the one above it. Large levels are split into
+ * bands of rows that run on the job system; without one, or for small levels, everything runs on the calling thread.
+ * @param base The address that the offsets of _mips_ are relative to.
+ */
+LIB_API void mip_chain_generate(u8* base, Cooked_Mip const* mips, u32 mip_count, Mip_Filter filter);
+
+/**
+ * @brief Refilters only the texels of levels 1 and up that read _regions_[0] of level 0, after it was rewritten.
+ * @param regions Holds the rewritten region of level 0 and receives the refiltered region of each level below it.
+ * @return The number of levels with a region, from level 0. The levels past them read nothing that changed.
+ */
+LIB_API u32 mip_chain_generate_region(u8* base, Cooked_Mip const* mips, u32 mip_count, Mip_Filter filter, Mip_Region* regions);
+
+/**
+ * @brief Builds the full chain of a single level image in a new allocation, laid out from offset 0.
+ * @param mip_count Receives the number of levels.
+ * @param size Receives the size of the allocation.
+ * @return The chain, to be released with mip_chain_destroy, or 0 if it couldn't be allocated.
+ */
+LIB_API u8* mip_chain_create(u8 const* pixels, u32 width, u32 height, Mip_Filter filter, u32* mip_count, u64* size);
+
+LIB_API void mip_chain_destroy(u8* chain, u64 size);
@@ -2,6 +2,7 @@
 
 #include "defines.h"
 #include "containers/dynamic_array.h"
+#include "resources/cooked_format.h"
 
 // #include "third_party/cglm/struct.h"
 
@@ -14,32 +15,27 @@
 
 
 
-typedef struct Shader_Config_Resource
-{
-    char name[32];
-    char renderpass_name[32];
-
-    Dynamic_Array* stages;
-    Dynamic_Array* spv_binaries;
-
-    VkPipelineVertexInputStateCreateInfo vertex_input_state;
-
-
-
-
-    bool per_material;
-    bool per_object;
-
-    // Dynamic_Array* attributes;
-    Dynamic_Array* uniforms;
+/**
+ * @brief Fixed layout without pointers, so a cooked shader config is used in place from its mapping.
+ */
+typedef Cooked_Shader_Config Shader_Config_Resource;
 
-    u32 max_descriptor_set_count;
-} Shader_Config_Resource;
 
 
 
 
 
+/**
+ * @brief How the texels of an image or texture are stored. The values match Cooked_Texture_Format.
+ */
+typedef enum Texture_Format
+{
+    TEXTURE_FORMAT_RGBA8 = COOKED_TEXTURE_FORMAT_RGBA8,
+    TEXTURE_FORMAT_BC1 = COOKED_TEXTURE_FORMAT_BC1,
+    TEXTURE_FORMAT_BC3 = COOKED_TEXTURE_FORMAT_BC3,
+    TEXTURE_FORMAT_BC7 = COOKED_TEXTURE_FORMAT_BC7,
+    TEXTURE_FORMAT_ENUM_COUNT
+} Texture_Format;
 
 typedef struct Image_Resource
 {
@@ -47,6 +43,19 @@ typedef struct Image_Resource
     u32 width;
     u32 height;
     u8 channel_count;
+    /** @brief Format of pixels. Decoded images are RGBA8; cooked ones and KTX2 or DDS containers may be block compressed. */
+    Texture_Format format;
+    /** @brief Number of levels in pixels, largest first. Decoded images have one. */
+    u32 mip_count;
+    /**
+     * @brief Set when the image came from a cooked file or a KTX2 or DDS container, whose transparency is known without
+     * scanning the pixels again. Its pixels are then allocated by the loader or, when Resource_Data::view is set, point
+     * into that mapping, rather than coming from stb_image.
+     */
+    bool cooked;
+    bool has_transparency;
+    /** @brief Size of the pixel block of a cooked or container image, which holds every level. */
+    u64 pixels_size;
 } Image_Resource;
 
 #define TEXTURE_NAME_MAX_LENGTH 128
@@ -63,6 +72,8 @@ typedef struct Texture_Map
 {
     Texture* texture;
     Texture_Use use;
+    /** @brief The part of the texture that is mapped, as u0, v0, u1, v1. 0, 0, 1, 1 unless it's an atlas entry. */
+    f32 uv_rect[4];
 } Texture_Map;
 
 // #define MAX_MATERIAL_NAME_LENGTH 128
@@ -73,15 +84,11 @@ typedef enum Material_Type
     MATERIAL_TYPE_UI
 } Material_Type;
 
-// typedef struct Material_Config_Resource
-// {
-//     char version[4];
-//     char name[MAX_MATERIAL_NAME_LENGTH];
-//     vec4s diffuse_colour;
-//     char diffuse_texture_name[TEXTURE_NAME_MAX_LENGTH];
-//     Material_Type type;
-//     bool auto_release;
-// } Material_Config_Resource;
+/**
+ * @brief Fixed layout without pointers, so a cooked material is used in place from its mapping.
+ * type holds a Material_Type.
+ */
+typedef Cooked_Material Material_Config_Resource;
 
 
 
@@ -106,28 +113,7 @@ typedef struct Geometry
 
 
 
-// typedef struct Vertex_Attribute_Config
-// {
-//     char name[32];
-//     u8 size;
-//     VkFormat type;
-// } Vertex_Attribute_Config;
-
-typedef enum Uniform_Type
-{
-    UNIFORM_TYPE_VEC4,
-    UNIFORM_TYPE_MAT4,
-    UNIFORM_TYPE_SAMPLER
-} Uniform_Type;
-
-
-
-typedef struct Uniform_Config
-{
-    char name[32];
-    u8 size;
-    Uniform_Type type;
-    Descriptor_Set_Scope scope;
-} Uniform_Config;
+typedef Cooked_Vertex_Attribute Vertex_Attribute_Config;
+typedef Cooked_Uniform Uniform_Config;
 
 
@@ -0,0 +1,182 @@
+#include "texture_atlas.h"
+
+#include "systems/memory_system.h"
+
+/**
+ * @brief Finds how low a rect placed at the left edge of node _index_ can go.
+ * @return false if it would run past the right or bottom edge of the atlas.
+ */
+static bool fit(Texture_Atlas_Packer const* packer, u32 index, u32 width, u32 height, u32* y);
+static void remove_node(Texture_Atlas_Packer* packer, u32 index);
+
+void texture_atlas_packer_create(u32 width, u32 height, u32 padding, Texture_Atlas_Packer* packer)
+{
+    packer->width = width;
+    packer->height = height;
+    packer->padding = padding;
+    packer->used_area = 0;
+    packer->node_count = 1;
+    packer->nodes[0].x = 0;
+    packer->nodes[0].y = 0;
+    packer->nodes[0].width = width;
+}
+
+bool texture_atlas_packer_insert(Texture_Atlas_Packer* packer, u32 width, u32 height, Texture_Atlas_Rect* rect)
+{
+    if (width == 0 || height == 0 || packer->node_count == TEXTURE_ATLAS_MAX_NODES)
+    {
+        return false;
+    }
+
+    u32 padded_width = width + packer->padding * 2;
+    u32 padded_height = height + packer->padding * 2;
+
+    // Bottom left: the lowest top edge wins, then the narrowest span, which leaves wider ones for wider rects.
+    u32 best_index = INVALID_ID;
+    u32 best_y = 0;
+    u32 best_top = INVALID_ID;
+    u32 best_width = INVALID_ID;
+    for (u32 i = 0; i < packer->node_count; ++i)
+    {
+        u32 y;
+        if (fit(packer, i, padded_width, padded_height, &y))
+        {
+            u32 top = y + padded_height;
+            if (top < best_top || (top == best_top && packer->nodes[i].width < best_width))
+            {
+                best_index = i;
+                best_y = y;
+                best_top = top;
+                best_width = packer->nodes[i].width;
+            }
+        }
+    }
+
+    if (best_index == INVALID_ID)
+    {
+        return false;
+    }
+
+    // The new span goes in front of the ones it covers, which are then cut back to where it ends.
+    for (u32 i = packer->node_count; i > best_index; --i)
+    {
+        packer->nodes[i] = packer->nodes[i - 1];
+    }
+    packer->node_count++;
+
+    Texture_Atlas_Node* node = &packer->nodes[best_index];
+    node->y = best_top;
+    node->width = padded_width;
+    u32 end = node->x + padded_width;
+
+    u32 next = best_index + 1;
+    while (next < packer->node_count && packer->nodes[next].x < end)
+    {
+        Texture_Atlas_Node* covered = &packer->nodes[next];
+        u32 covered_end = covered->x + covered->width;
+        if (covered_end <= end)
+        {
+            remove_node(packer, next);
+            continue;
+        }
+
+        covered->width = covered_end - end;
+        covered->x = end;
+        break;
+    }
+
+    rect->x = node->x + packer->padding;
+    rect->y = best_y + packer->padding;
+    rect->width = width;
+    rect->height = height;
+
+    // Spans of equal height are joined, which keeps the skyline short.
+    for (u32 i = 0; i + 1 < packer->node_count;)
+    {
+        if (packer->nodes[i].y == packer->nodes[i + 1].y)
+        {
+            packer->nodes[i].width += packer->nodes[i + 1].width;
+            remove_node(packer, i + 1);
+        }
+        else
+        {
+            ++i;
+        }
+    }
+
+    packer->used_area += (u64)padded_width * padded_height;
+    return true;
+}
+
+f32 texture_atlas_packer_occupancy(Texture_Atlas_Packer const* packer)
+{
+    return (f32)((f64)packer->used_area / ((f64)packer->width * packer->height));
+}
+
+void texture_atlas_blit(u8* atlas, u32 atlas_width, Texture_Atlas_Rect const* rect, u32 padding, u8 const* pixels)
+{
+    u64 stride = (u64)atlas_width * 4;
+    for (u32 row = 0; row < rect->height; ++row)
+    {
+        u8* destination = atlas + (rect->y + row) * stride + (u64)rect->x * 4;
+        memory_system_copy(destination, pixels + (u64)row * rect->width * 4, (u64)rect->width * 4);
+        for (u32 i = 1; i <= padding; ++i)
+        {
+            memory_system_copy(destination - i * 4, destination, 4);
+            memory_system_copy(destination + (u64)(rect->width - 1 + i) * 4, destination + (u64)(rect->width - 1) * 4, 4);
+        }
+    }
+
+    // The padded first and last rows are repeated outwards, which fills the corners too.
+    u64 span = (u64)(rect->width + padding * 2) * 4;
+    u8* first = atlas + rect->y * stride + (u64)(rect->x - padding) * 4;
+    u8* last = first + (rect->height - 1) * stride;
+    for (u32 i = 1; i <= padding; ++i)
+    {
+        memory_system_copy(first - i * stride, first, span);
+        memory_system_copy(last + i * stride, last, span);
+    }
+}
+
+void texture_atlas_uv_rect(Texture_Atlas_Rect const* rect, u32 atlas_width, u32 atlas_height, f32* uv_rect)
+{
+    uv_rect[0] = (f32)rect->x / atlas_width;
+    uv_rect[1] = (f32)rect->y / atlas_height;
+    uv_rect[2] = (f32)(rect->x + rect->width) / atlas_width;
+    uv_rect[3] = (f32)(rect->y + rect->height) / atlas_height;
+}
+
+bool fit(Texture_Atlas_Packer const* packer, u32 index, u32 width, u32 height, u32* y)
+{
+    u32 x = packer->nodes[index].x;
+    if (x + width > packer->width)
+    {
+        return false;
+    }
+
+    // The rect rests on the highest span under it.
+    u32 top = 0;
+    u32 width_left = width;
+    for (u32 i = index; width_left > 0; ++i)
+    {
+        Texture_Atlas_Node const* node = &packer->nodes[i];
+        top = node->y > top ? node->y : top;
+        if (top + height > packer->height)
+        {
+            return false;
+        }
+        width_left -= node->width < width_left ? node->width : width_left;
+    }
+
+    *y = top;
+    return true;
+}
+
+void remove_node(Texture_Atlas_Packer* packer, u32 index)
+{
+    for (u32 i = index; i + 1 < packer->node_count; ++i)
+    {
+        packer->nodes[i] = packer->nodes[i + 1];
+    }
+    packer->node_count--;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "defines.h"
+
+/**
+ * Packing of many small RGBA8 images into one texture, so that everything drawn from them shares one binding.
+ * Rects are placed by a skyline packer: the atlas keeps the top edge of what has been placed in each column span and
+ * every new rect goes where its top ends up lowest. Rects can be added at any time, each keeping its place. Every rect
+ * is surrounded by _padding_ texels, filled with its own edge texels, so that filtering and the first mips near its
+ * border don't pick up its neighbours.
+ */
+
+/** @brief Maximum number of skyline segments. Inserts that would need more fail. */
+#define TEXTURE_ATLAS_MAX_NODES 512
+
+/**
+ * @brief Texels of an entry within the atlas, padding excluded.
+ */
+typedef struct Texture_Atlas_Rect
+{
+    u32 x;
+    u32 y;
+    u32 width;
+    u32 height;
+} Texture_Atlas_Rect;
+
+/**
+ * @brief One span of the skyline: columns x to x + width - 1 are in use from row 0 up to row y - 1.
+ */
+typedef struct Texture_Atlas_Node
+{
+    u32 x;
+    u32 y;
+    u32 width;
+} Texture_Atlas_Node;
+
+typedef struct Texture_Atlas_Packer
+{
+    u32 width;
+    u32 height;
+    u32 padding;
+    /** @brief Texels taken by inserted rects, padding included. */
+    u64 used_area;
+    u32 node_count;
+    /** @brief The skyline, sorted by x and covering the whole width. */
+    Texture_Atlas_Node nodes[TEXTURE_ATLAS_MAX_NODES];
+} Texture_Atlas_Packer;
+
+LIB_API void texture_atlas_packer_create(u32 width, u32 height, u32 padding, Texture_Atlas_Packer* packer);
+
+/**
+ * @brief Places a width x height rect with _padding_ texels around it.
+ * @return true on success. If the rect doesn't fit, false is returned and the packer is left as it was.
+ */
+LIB_API bool texture_atlas_packer_insert(Texture_Atlas_Packer* packer, u32 width, u32 height, Texture_Atlas_Rect* rect);
+
+/**
+ * @return The share of the atlas taken by inserted rects and their padding, from 0 to 1.
+ */
+LIB_API f32 texture_atlas_packer_occupancy(Texture_Atlas_Packer const* packer);
+
+/**
+ * @brief Copies a rect->width x rect->height RGBA8 image into its rect of the atlas and extrudes its edge texels
+ * into the _padding_ texels around it, corners included.
+ * @param atlas RGBA8 pixels of the whole atlas, atlas_width texels per row.
+ */
+LIB_API void texture_atlas_blit(u8* atlas, u32 atlas_width, Texture_Atlas_Rect const* rect, u32 padding, u8 const* pixels);
+
+/**
+ * @brief Texture coordinates of _rect_ as u0, v0, u1, v1, with v growing from the first row of the atlas.
+ */
+LIB_API void texture_atlas_uv_rect(Texture_Atlas_Rect const* rect, u32 atlas_width, u32 atlas_height, f32* uv_rect);
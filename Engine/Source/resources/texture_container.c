@@ -0,0 +1,352 @@
+#include "texture_container.h"
+
+#include "core/logger.h"
+#include "resources/block_compression.h"
+#include "systems/memory_system.h"
+
+#define KTX2_HEADER_SIZE 80
+#define KTX2_LEVEL_INDEX_ENTRY_SIZE 24
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_HEADER_SIZE 124
+#define DDS_PIXEL_FORMAT_SIZE 32
+#define DDS_DX10_HEADER_SIZE 20
+#define DDS_FOURCC(a, b, c, d) ((u32)(a) | ((u32)(b) << 8) | ((u32)(c) << 16) | ((u32)(d) << 24))
+
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_DEPTH 0x800000
+#define DDPF_ALPHAPIXELS 0x1
+#define DDPF_FOURCC 0x4
+#define DDPF_RGB 0x40
+#define DDSCAPS2_CUBEMAP 0x200
+#define DDSCAPS2_VOLUME 0x200000
+
+#define DXGI_FORMAT_R8G8B8A8_UNORM 28
+#define DXGI_FORMAT_R8G8B8A8_UNORM_SRGB 29
+#define DXGI_FORMAT_BC1_UNORM 71
+#define DXGI_FORMAT_BC1_UNORM_SRGB 72
+#define DXGI_FORMAT_BC3_UNORM 77
+#define DXGI_FORMAT_BC3_UNORM_SRGB 78
+#define DXGI_FORMAT_BC7_UNORM 98
+#define DXGI_FORMAT_BC7_UNORM_SRGB 99
+#define D3D10_RESOURCE_DIMENSION_TEXTURE3D 4
+#define D3D11_RESOURCE_MISC_TEXTURECUBE 0x4
+
+static u8 const ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+static bool is_ktx2(u8 const* data, u64 size);
+static bool parse_ktx2(u8 const* data, u64 size, Texture_Container* container);
+static bool parse_dds(u8 const* data, u64 size, Texture_Container* container);
+static bool ktx2_format(u32 vk_format, Texture_Format* format);
+static bool dxgi_format(u32 dxgi_format, Texture_Format* format);
+static u32 read_u32(u8 const* data);
+static u64 read_u64(u8 const* data);
+
+bool texture_container_detect(void const* data, u64 size)
+{
+    return is_ktx2(data, size) || (size >= 4 && read_u32(data) == DDS_MAGIC);
+}
+
+bool texture_container_parse(void const* data, u64 size, Texture_Container* container)
+{
+    memory_system_zero(container, sizeof(*container));
+    container->data = data;
+    if (is_ktx2(data, size))
+    {
+        container->type = TEXTURE_CONTAINER_TYPE_KTX2;
+        return parse_ktx2(data, size, container);
+    }
+
+    if (size >= 4 && read_u32(data) == DDS_MAGIC)
+    {
+        container->type = TEXTURE_CONTAINER_TYPE_DDS;
+        return parse_dds(data, size, container);
+    }
+
+    LOG_WARNING("texture_container_parse: Neither a KTX2 nor a DDS file");
+    return false;
+}
+
+Texture_Container_View texture_container_view(Texture_Container const* container, u32 level, u32 layer)
+{
+    Texture_Container_View view = {};
+    if (level >= container->mip_count || layer >= container->layer_count)
+    {
+        return view;
+    }
+
+    view.width = container->width >> level ? container->width >> level : 1;
+    view.height = container->height >> level ? container->height >> level : 1;
+    view.size = block_compression_level_size(container->format, view.width, view.height);
+    view.data = container->data + container->level_offsets[level] + layer * container->layer_strides[level];
+    return view;
+}
+
+void texture_container_copy_chain(Texture_Container const* container, u32 layer, u8* chain)
+{
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    block_compression_layout(container->format, container->width, container->height, 0, mips);
+    for (u32 i = 0; i < container->mip_count; ++i)
+    {
+        Texture_Container_View view = texture_container_view(container, i, layer);
+        memory_system_copy(chain + mips[i].offset, view.data, view.size);
+    }
+}
+
+bool is_ktx2(u8 const* data, u64 size)
+{
+    if (size < sizeof(ktx2_identifier))
+    {
+        return false;
+    }
+
+    for (u32 i = 0; i < sizeof(ktx2_identifier); ++i)
+    {
+        if (data[i] != ktx2_identifier[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool parse_ktx2(u8 const* data, u64 size, Texture_Container* container)
+{
+    if (size < KTX2_HEADER_SIZE)
+    {
+        LOG_WARNING("parse_ktx2: File is truncated");
+        return false;
+    }
+
+    // The header is the identifier followed by u32 vkFormat, typeSize, pixelWidth, pixelHeight, pixelDepth, layerCount,
+    // faceCount, levelCount and supercompressionScheme, then the data format, key/value and supercompression indices.
+    u32 vk_format = read_u32(data + 12);
+    u32 width = read_u32(data + 20);
+    u32 height = read_u32(data + 24);
+    u32 depth = read_u32(data + 28);
+    u32 layer_count = read_u32(data + 32);
+    u32 face_count = read_u32(data + 36);
+    u32 level_count = read_u32(data + 40);
+    u32 supercompression = read_u32(data + 44);
+    if (!ktx2_format(vk_format, &container->format))
+    {
+        LOG_WARNING("parse_ktx2: Unsupported VkFormat %u", vk_format);
+        return false;
+    }
+    if (supercompression != 0)
+    {
+        LOG_WARNING("parse_ktx2: Supercompression scheme %u isn't supported", supercompression);
+        return false;
+    }
+    if (width == 0 || depth > 1 || (face_count != 1 && face_count != 6) || layer_count > 0xFFFF)
+    {
+        LOG_WARNING("parse_ktx2: Only 2D textures, arrays and cube maps are supported");
+        return false;
+    }
+
+    // A level count of 0 asks the loader to generate the chain, which the texture system does for single levels anyway.
+    level_count = level_count ? level_count : 1;
+    if (size < KTX2_HEADER_SIZE + (u64)level_count * KTX2_LEVEL_INDEX_ENTRY_SIZE)
+    {
+        LOG_WARNING("parse_ktx2: Level index is truncated");
+        return false;
+    }
+
+    container->width = width;
+    container->height = height ? height : 1;
+    container->layer_count = (layer_count ? layer_count : 1) * face_count;
+
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 full_count = block_compression_layout(container->format, container->width, container->height, 0, mips);
+    if (level_count > full_count && full_count < COOKED_TEXTURE_MAX_MIPS)
+    {
+        LOG_WARNING("parse_ktx2: %u levels don't fit a %ux%u texture", level_count, container->width, container->height);
+        return false;
+    }
+
+    container->mip_count = level_count < full_count ? level_count : full_count;
+    for (u32 i = 0; i < container->mip_count; ++i)
+    {
+        u8 const* entry = data + KTX2_HEADER_SIZE + (u64)i * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+        u64 offset = read_u64(entry);
+        u64 length = read_u64(entry + 8);
+        if (offset > size || length > size - offset || length < mips[i].size * container->layer_count)
+        {
+            LOG_WARNING("parse_ktx2: Level %u lies outside the file", i);
+            return false;
+        }
+
+        container->level_offsets[i] = offset;
+        container->layer_strides[i] = mips[i].size;
+    }
+
+    return true;
+}
+
+bool parse_dds(u8 const* data, u64 size, Texture_Container* container)
+{
+    if (size < 4 + DDS_HEADER_SIZE || read_u32(data + 4) != DDS_HEADER_SIZE || read_u32(data + 76) != DDS_PIXEL_FORMAT_SIZE)
+    {
+        LOG_WARNING("parse_dds: Header is truncated or malformed");
+        return false;
+    }
+
+    // DDS_HEADER after the magic: dwSize, dwFlags, dwHeight, dwWidth, dwPitchOrLinearSize, dwDepth, dwMipMapCount,
+    // 11 reserved words, the DDS_PIXELFORMAT at 76 and the caps at 108.
+    u32 flags = read_u32(data + 8);
+    u32 height = read_u32(data + 12);
+    u32 width = read_u32(data + 16);
+    u32 depth = read_u32(data + 24);
+    u32 level_count = flags & DDSD_MIPMAPCOUNT ? read_u32(data + 28) : 1;
+    u32 pixel_flags = read_u32(data + 80);
+    u32 four_cc = read_u32(data + 84);
+    u32 caps2 = read_u32(data + 112);
+    if (width == 0 || height == 0 || (caps2 & DDSCAPS2_VOLUME) || ((flags & DDSD_DEPTH) && depth > 1))
+    {
+        LOG_WARNING("parse_dds: Only 2D textures, arrays and cube maps are supported");
+        return false;
+    }
+
+    u64 data_offset = 4 + DDS_HEADER_SIZE;
+    u32 layer_count = caps2 & DDSCAPS2_CUBEMAP ? 6 : 1;
+    bool supported = true;
+    if ((pixel_flags & DDPF_FOURCC) && four_cc == DDS_FOURCC('D', 'X', '1', '0'))
+    {
+        if (size < data_offset + DDS_DX10_HEADER_SIZE)
+        {
+            LOG_WARNING("parse_dds: DX10 header is truncated");
+            return false;
+        }
+
+        // DDS_HEADER_DXT10: dxgiFormat, resourceDimension, miscFlag, arraySize, miscFlags2.
+        u32 format = read_u32(data + data_offset);
+        u32 dimension = read_u32(data + data_offset + 4);
+        u32 misc_flags = read_u32(data + data_offset + 8);
+        u32 array_size = read_u32(data + data_offset + 12);
+        if (dimension == D3D10_RESOURCE_DIMENSION_TEXTURE3D || array_size > 0xFFFF)
+        {
+            LOG_WARNING("parse_dds: Only 2D textures, arrays and cube maps are supported");
+            return false;
+        }
+
+        supported = dxgi_format(format, &container->format);
+        layer_count = (array_size ? array_size : 1) * (misc_flags & D3D11_RESOURCE_MISC_TEXTURECUBE ? 6 : 1);
+        data_offset += DDS_DX10_HEADER_SIZE;
+    }
+    else if (pixel_flags & DDPF_FOURCC)
+    {
+        supported = four_cc == DDS_FOURCC('D', 'X', 'T', '1') || four_cc == DDS_FOURCC('D', 'X', 'T', '5');
+        container->format = four_cc == DDS_FOURCC('D', 'X', 'T', '1') ? TEXTURE_FORMAT_BC1 : TEXTURE_FORMAT_BC3;
+    }
+    else
+    {
+        // Uncompressed pixels are only taken in RGBA byte order; BGRA would need a swizzle.
+        supported = (pixel_flags & DDPF_RGB) && (pixel_flags & DDPF_ALPHAPIXELS) && read_u32(data + 88) == 32 &&
+            read_u32(data + 92) == 0x000000FF && read_u32(data + 96) == 0x0000FF00 &&
+            read_u32(data + 100) == 0x00FF0000 && read_u32(data + 104) == 0xFF000000;
+        container->format = TEXTURE_FORMAT_RGBA8;
+    }
+
+    if (!supported)
+    {
+        LOG_WARNING("parse_dds: Unsupported pixel format");
+        return false;
+    }
+
+    container->width = width;
+    container->height = height;
+    container->layer_count = layer_count;
+
+    // Each layer holds its whole chain, tightly packed, so the layer stride covers every level in the file.
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 full_count = block_compression_layout(container->format, width, height, 0, mips);
+    level_count = level_count ? level_count : 1;
+    if (level_count > full_count)
+    {
+        LOG_WARNING("parse_dds: %u levels don't fit a %ux%u texture", level_count, width, height);
+        return false;
+    }
+
+    u64 layer_size = 0;
+    for (u32 i = 0; i < level_count; ++i)
+    {
+        container->level_offsets[i] = data_offset + layer_size;
+        layer_size += mips[i].size;
+    }
+    for (u32 i = 0; i < level_count; ++i)
+    {
+        container->layer_strides[i] = layer_size;
+    }
+
+    if (data_offset > size || layer_size * layer_count > size - data_offset)
+    {
+        LOG_WARNING("parse_dds: Pixel data is truncated");
+        return false;
+    }
+
+    container->mip_count = level_count;
+    return true;
+}
+
+bool ktx2_format(u32 vk_format, Texture_Format* format)
+{
+    switch (vk_format)
+    {
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            *format = TEXTURE_FORMAT_RGBA8;
+            return true;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            *format = TEXTURE_FORMAT_BC1;
+            return true;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+            *format = TEXTURE_FORMAT_BC3;
+            return true;
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            *format = TEXTURE_FORMAT_BC7;
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool dxgi_format(u32 dxgi_format, Texture_Format* format)
+{
+    switch (dxgi_format)
+    {
+        case DXGI_FORMAT_R8G8B8A8_UNORM:
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+            *format = TEXTURE_FORMAT_RGBA8;
+            return true;
+        case DXGI_FORMAT_BC1_UNORM:
+        case DXGI_FORMAT_BC1_UNORM_SRGB:
+            *format = TEXTURE_FORMAT_BC1;
+            return true;
+        case DXGI_FORMAT_BC3_UNORM:
+        case DXGI_FORMAT_BC3_UNORM_SRGB:
+            *format = TEXTURE_FORMAT_BC3;
+            return true;
+        case DXGI_FORMAT_BC7_UNORM:
+        case DXGI_FORMAT_BC7_UNORM_SRGB:
+            *format = TEXTURE_FORMAT_BC7;
+            return true;
+        default:
+            return false;
+    }
+}
+
+u32 read_u32(u8 const* data)
+{
+    // Both formats are little-endian; reading bytewise also keeps unaligned buffers safe.
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((u32)data[3] << 24);
+}
+
+u64 read_u64(u8 const* data)
+{
+    return read_u32(data) | ((u64)read_u32(data + 4) << 32);
+}
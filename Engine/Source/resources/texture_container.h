@@ -0,0 +1,68 @@
+#pragma once
+
+#include "defines.h"
+#include "resources/cooked_format.h"
+#include "resources/resource_types.h"
+
+/**
+ * Parsers for KTX2 and DDS files holding textures in a format the renderer samples as is: RGBA8, BC1, BC3 or BC7.
+ * sRGB variants are accepted as their plain form, like everything else the engine loads. Levels and array layers are
+ * handed out as views into the file bytes, so nothing is decoded or copied until they are uploaded.
+ * Supercompressed KTX2 files, volume textures and other formats are rejected.
+ */
+
+typedef enum Texture_Container_Type
+{
+    TEXTURE_CONTAINER_TYPE_KTX2,
+    TEXTURE_CONTAINER_TYPE_DDS
+} Texture_Container_Type;
+
+/**
+ * @brief A parsed container. It points into the bytes it was parsed from, which must outlive it.
+ */
+typedef struct Texture_Container
+{
+    u8 const* data;
+    Texture_Container_Type type;
+    Texture_Format format;
+    u32 width;
+    u32 height;
+    u32 mip_count;
+    /** @brief Array layers times cube faces, faces varying fastest. */
+    u32 layer_count;
+    /** @brief Offset of layer 0 of each level from _data_. */
+    u64 level_offsets[COOKED_TEXTURE_MAX_MIPS];
+    /** @brief Distance between consecutive layers of each level. KTX2 keeps the layers of a level together, DDS the levels of a layer. */
+    u64 layer_strides[COOKED_TEXTURE_MAX_MIPS];
+} Texture_Container;
+
+/**
+ * @brief One level of one layer, in place in the container.
+ */
+typedef struct Texture_Container_View
+{
+    u8 const* data;
+    u64 size;
+    u32 width;
+    u32 height;
+} Texture_Container_View;
+
+/**
+ * @brief Indicates if _data_ starts like a KTX2 or DDS file. Cheap enough to call on every image.
+ */
+LIB_API bool texture_container_detect(void const* data, u64 size);
+
+/**
+ * @brief Parses the headers of a KTX2 or DDS file and checks that every level lies within _size_.
+ * Levels past COOKED_TEXTURE_MAX_MIPS are ignored.
+ * @return true on success. Malformed or unsupported containers log why they were rejected.
+ */
+LIB_API bool texture_container_parse(void const* data, u64 size, Texture_Container* container);
+
+LIB_API Texture_Container_View texture_container_view(Texture_Container const* container, u32 level, u32 layer);
+
+/**
+ * @brief Copies every level of _layer_ into _chain_, laid out by block_compression_layout from offset 0, which is how
+ * the texture upload path expects them. _chain_ is only written, so it may be write-combined memory.
+ */
+LIB_API void texture_container_copy_chain(Texture_Container const* container, u32 layer, u8* chain);
@@ -26,7 +26,7 @@ typedef struct geometry_system_state {
 static geometry_system_state* system_state;
 
 static b8 create_default_geometries(geometry_system_state* state);
-static b8 create_geometry(geometry_system_configuration config, Geometry* geometry);
+static b8 create_geometry(Geometry_Config config, Geometry* geometry);
 static void destroy_geometry(Geometry* geometry);
 
 b8 geometry_system_startup(u64* required_memory_size_in_bytes, void* memory, Geometry_System_Config config)
@@ -75,7 +75,7 @@ Geometry* geometry_system_acquire_by_id(u32 id)
     return 0;
 }
 
-Geometry* geometry_system_acquire_from_config(geometry_system_configuration config, b8 auto_release)
+Geometry* geometry_system_acquire_from_config(Geometry_Config config, b8 auto_release)
 {
     for (u32 i = 0; i < system_state->config.max_geometry_count; ++i) {
         if (system_state->geometry_references[i].geometry.id == INVALID_ID) {
@@ -134,7 +134,7 @@ Geometry* geometry_system_get_default_2d()
     return 0;
 }
 
-b8 create_geometry(geometry_system_configuration config, Geometry* geometry)
+b8 create_geometry(Geometry_Config config, Geometry* geometry)
 {
     if (!renderer_frontend_create_geometry(geometry, config.vertex_size_in_bytes, config.vertex_count, config.vertices, config.index_size_in_bytes, config.index_count, config.indices)) {
         system_state->geometry_references[geometry->id].reference_count = 0;
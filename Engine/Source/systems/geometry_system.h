@@ -44,14 +44,14 @@ Geometry* geometry_system_acquire_by_id(u32 id);
  * @param auto_release Indicates if the acquired geometry should be unloaded when its reference count reaches 0.
  * @return A pointer to the acquired geometry or nullptr if failed. 
  */
-Geometry* geometry_system_acquire_from_config(geometry_system_configuration config, b8 auto_release);
+LIB_API Geometry* geometry_system_acquire_from_config(Geometry_Config config, b8 auto_release);
 
 /**
  * @brief Releases a reference to the provided geometry.
  * 
  * @param geometry The geometry to be released.
  */
-void geometry_system_release(Geometry* geometry);
+LIB_API void geometry_system_release(Geometry* geometry);
 
 /**
  * @brief Obtains a pointer to the default geometry.
@@ -82,4 +82,4 @@ Geometry* geometry_system_get_default_2d();
  * @param material_name The name of the material to be used.
  * @return A geometry configuration which can then be fed into geometry_system_acquire_from_config().
  */
-geometry_system_configuration geometry_system_generate_plane_config(f32 width, f32 height, u32 x_segment_count, u32 y_segment_count, f32 tile_x, f32 tile_y, char const* name, char const* material_name);
+LIB_API Geometry_Config geometry_system_generate_plane_config(f32 width, f32 height, u32 x_segment_count, u32 y_segment_count, f32 tile_x, f32 tile_y, char const* name, char const* material_name);
@@ -0,0 +1,207 @@
+#include "job_system.h"
+
+#include "core/logger.h"
+#include "platform/platform.h"
+
+typedef struct Job
+{
+    PFN_job_entry entry;
+    void* params;
+    Job_Counter* counter;
+} Job;
+
+typedef struct Job_System_State
+{
+    Job_System_Config config;
+    b8 running;
+
+    platform_thread* workers;
+
+    Job* jobs;
+    u32 head;
+    u32 count;
+    platform_mutex queue_mutex;
+    // Signalled once per queued job and once per worker on shutdown.
+    platform_semaphore queue_semaphore;
+} Job_System_State;
+
+static Job_System_State* state;
+
+static u32 worker_loop(void* params);
+static b8 pop_job(Job* job);
+static void run_job(Job* job);
+
+b8 job_system_startup(u64* required_memory, void* block, Job_System_Config config)
+{
+    if (config.max_job_count == 0)
+    {
+        LOG_FATAL("job_system_startup: Invalid input parameters");
+        return FALSE;
+    }
+
+    u64 state_required_memory = sizeof(*state);
+    u64 workers_required_memory = config.worker_count * sizeof(*state->workers);
+    u64 jobs_required_memory = config.max_job_count * sizeof(*state->jobs);
+    *required_memory = state_required_memory + workers_required_memory + jobs_required_memory;
+    if (!block)
+    {
+        return TRUE;
+    }
+
+    state = block;
+    state->config = config;
+    state->running = TRUE;
+    state->workers = (platform_thread*)((char*)state + state_required_memory);
+    state->jobs = (Job*)((char*)state->workers + workers_required_memory);
+    state->head = 0;
+    state->count = 0;
+
+    if (!platform_mutex_create(&state->queue_mutex) || !platform_semaphore_create(0, &state->queue_semaphore))
+    {
+        LOG_FATAL("job_system_startup: Failed to create synchronization objects");
+        return FALSE;
+    }
+
+    for (u32 i = 0; i < config.worker_count; ++i)
+    {
+        if (!platform_thread_create(worker_loop, 0, &state->workers[i]))
+        {
+            LOG_FATAL("job_system_startup: Failed to create worker thread %u", i);
+            return FALSE;
+        }
+    }
+
+    LOG_INFO("job_system_startup: Started %u worker threads", config.worker_count);
+    return TRUE;
+}
+
+void job_system_shutdown()
+{
+    if (state)
+    {
+        platform_mutex_lock(&state->queue_mutex);
+        state->running = FALSE;
+        platform_mutex_unlock(&state->queue_mutex);
+
+        for (u32 i = 0; i < state->config.worker_count; ++i)
+        {
+            platform_semaphore_signal(&state->queue_semaphore);
+        }
+
+        for (u32 i = 0; i < state->config.worker_count; ++i)
+        {
+            platform_thread_destroy(&state->workers[i]);
+        }
+
+        platform_semaphore_destroy(&state->queue_semaphore);
+        platform_mutex_destroy(&state->queue_mutex);
+        state = 0;
+    }
+}
+
+b8 job_system_submit(PFN_job_entry entry, void* params, Job_Counter* counter)
+{
+    if (!entry)
+    {
+        LOG_ERROR("job_system_submit: Invalid input parameters");
+        return FALSE;
+    }
+
+    Job job;
+    job.entry = entry;
+    job.params = params;
+    job.counter = counter;
+    if (counter)
+    {
+        platform_atomic_add(&counter->value, 1);
+    }
+
+    if (state && state->config.worker_count > 0)
+    {
+        platform_mutex_lock(&state->queue_mutex);
+        if (state->running && state->count < state->config.max_job_count)
+        {
+            state->jobs[(state->head + state->count) % state->config.max_job_count] = job;
+            state->count++;
+            platform_mutex_unlock(&state->queue_mutex);
+            platform_semaphore_signal(&state->queue_semaphore);
+            return TRUE;
+        }
+        platform_mutex_unlock(&state->queue_mutex);
+    }
+
+    run_job(&job);
+    return TRUE;
+}
+
+void job_system_wait(Job_Counter* counter)
+{
+    while (counter->value > 0)
+    {
+        Job job;
+        if (state && pop_job(&job))
+        {
+            run_job(&job);
+        }
+        else
+        {
+            platformSleep(0);
+        }
+    }
+}
+
+u32 job_system_worker_count()
+{
+    return state ? state->config.worker_count : 0;
+}
+
+u32 worker_loop(void* params)
+{
+    for (;;)
+    {
+        platform_semaphore_wait(&state->queue_semaphore);
+
+        Job job;
+        if (pop_job(&job))
+        {
+            run_job(&job);
+            continue;
+        }
+
+        // The job was taken by a waiting thread, or the system is shutting down.
+        platform_mutex_lock(&state->queue_mutex);
+        b8 running = state->running;
+        platform_mutex_unlock(&state->queue_mutex);
+        if (!running)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+b8 pop_job(Job* job)
+{
+    platform_mutex_lock(&state->queue_mutex);
+    if (state->count == 0)
+    {
+        platform_mutex_unlock(&state->queue_mutex);
+        return FALSE;
+    }
+
+    *job = state->jobs[state->head];
+    state->head = (state->head + 1) % state->config.max_job_count;
+    state->count--;
+    platform_mutex_unlock(&state->queue_mutex);
+    return TRUE;
+}
+
+void run_job(Job* job)
+{
+    job->entry(job->params);
+    if (job->counter)
+    {
+        platform_atomic_add(&job->counter->value, -1);
+    }
+}
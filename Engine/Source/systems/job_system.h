@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defines.h"
+
+typedef void (* PFN_job_entry)(void* params);
+
+/**
+ * @brief Number of unfinished jobs submitted with this counter. Zero-initialize before the first submit.
+ */
+typedef struct Job_Counter
+{
+    i64 volatile value;
+} Job_Counter;
+
+typedef struct Job_System_Config
+{
+    /** @brief Number of worker threads. 0 runs every job on the submitting thread. */
+    u32 worker_count;
+    /** @brief Capacity of the job queue. Jobs submitted to a full queue run on the submitting thread. */
+    u32 max_job_count;
+} Job_System_Config;
+
+LIB_API b8 job_system_startup(u64* required_memory, void* block, Job_System_Config config);
+LIB_API void job_system_shutdown();
+
+/**
+ * @brief Queues _entry_ to run on a worker thread.
+ * @param counter Optional. Incremented now and decremented once the job has finished.
+ */
+LIB_API b8 job_system_submit(PFN_job_entry entry, void* params, Job_Counter* counter);
+
+/**
+ * @brief Blocks until all jobs submitted with _counter_ have finished. The calling thread runs queued jobs while it waits.
+ */
+LIB_API void job_system_wait(Job_Counter* counter);
+
+LIB_API u32 job_system_worker_count();
@@ -1,7 +1,10 @@
 #include "material_system.h"
 
+#include "core/string_utils.h"
 #include "memory_system.h"
-#include "resource_system.h"
+#include "resource_batch.h"
+#include "resource_manager.h"
+#include "resources/resource_types.h"
 
 
 // #include "containers/hash_table.h"
@@ -36,6 +39,8 @@ static Material_System_State* state;
 
 
 static bool load_from_config(const char* filename);
+static void config_from_resource(Material_Config_Resource const* resource, Material_Config* config);
+static void on_batch_resource_ready(Resource_Data const* resource, u32 request_index, void* user_data);
 
 bool material_system_startup(Material_System_Config* config)
 {
@@ -104,19 +109,21 @@ void material_system_shutdown()
 Material* material_system_acquire(char const* name)
 {
     Resource_Data mat_resource;
-    if (!resource_system_load(name, RESOURCE_TYPE_MATERIAL, &mat_resource))
+    if (!resource_manager_acquire(RESOURCE_TYPE_MATERIAL, name, true, &mat_resource))
     {
         LOG_ERROR("material_system_acquire: Failed to load material resource, returning nullptr");
         return 0;
     }
 
-    Material* material;
+    Material* material = 0;
     if (mat_resource.data)
     {
-        material = material_system_acquire_from_config(*(Material_Config*)mat_resource.data);
+        Material_Config config;
+        config_from_resource(mat_resource.data, &config);
+        material = material_system_acquire_from_config(config);
     }
 
-    resource_system_unload(&mat_resource);
+    resource_manager_release(&mat_resource);
 
     if (!material)
     {
@@ -127,6 +134,84 @@ Material* material_system_acquire(char const* name)
     return material;
 }
 
+bool material_system_acquire_batch(char const* const* names, u32 count, Material** materials)
+{
+    if (!names || !materials)
+    {
+        LOG_ERROR("material_system_acquire_batch: Invalid parameters");
+        return false;
+    }
+
+    Resource_Batch_Request* requests = memory_system_allocate(count * sizeof(*requests), MEMORY_TAG_RESOURCES);
+    Resource_Data* resources = memory_system_allocate(count * sizeof(*resources), MEMORY_TAG_RESOURCES);
+    for (u32 i = 0; i < count; ++i)
+    {
+        requests[i].type = RESOURCE_TYPE_MATERIAL;
+        requests[i].name = names[i];
+        materials[i] = 0;
+    }
+
+    Resource_Batch_Stats stats;
+    bool result = resource_batch_acquire(requests, count, true, on_batch_resource_ready, materials, resources, &stats);
+    resource_batch_log_stats(&stats);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        // The callback runs once per material, so repeated names are acquired here.
+        if (!materials[i] && resources[i].data)
+        {
+            Material_Config config;
+            config_from_resource(resources[i].data, &config);
+            materials[i] = material_system_acquire_from_config(config);
+        }
+
+        if (!materials[i])
+        {
+            LOG_ERROR("material_system_acquire_batch: Failed to acquire material '%s'", names[i]);
+            result = false;
+        }
+
+        if (resources[i].data)
+        {
+            resource_manager_release(&resources[i]);
+        }
+    }
+
+    memory_system_free(requests, count * sizeof(*requests), MEMORY_TAG_RESOURCES);
+    memory_system_free(resources, count * sizeof(*resources), MEMORY_TAG_RESOURCES);
+    return result;
+}
+
+void on_batch_resource_ready(Resource_Data const* resource, u32 request_index, void* user_data)
+{
+    // Creating the material acquires its texture, which the batch has just decoded into the resource cache,
+    // so the upload happens here while the rest of the batch is still reading and decoding.
+    Material** materials = user_data;
+    if (resource->type == RESOURCE_TYPE_MATERIAL && request_index != INVALID_ID)
+    {
+        Material_Config config;
+        config_from_resource(resource->data, &config);
+        materials[request_index] = material_system_acquire_from_config(config);
+    }
+}
+
+/**
+ * @brief The loader hands out the cooked on-disk record, whose layout differs from Material_Config,
+ * so the fields are copied across one by one rather than reinterpreting the data.
+ */
+void config_from_resource(Material_Config_Resource const* resource, Material_Config* config)
+{
+    memory_system_zero(config, sizeof(*config));
+    string_ncopy(config->name, resource->name, sizeof(config->name) - 1);
+    string_ncopy(config->diffuse_texture_name, resource->diffuse_texture_name, sizeof(config->diffuse_texture_name) - 1);
+    config->type = (Material_Type)resource->type;
+    config->diffuse_color.x = resource->diffuse_color[0];
+    config->diffuse_color.y = resource->diffuse_color[1];
+    config->diffuse_color.z = resource->diffuse_color[2];
+    config->diffuse_color.w = resource->diffuse_color[3];
+    config->auto_release = resource->auto_release != 0;
+}
+
 Material* material_system_acquire_from_config(Material_Config config)
 {
     // Return default material.
@@ -247,9 +332,17 @@ b8 load_material(Material_Config config, Material* m)
     glm_vec4_copy(config.diffuse_color, m->diffuse_color);
 
     // Diffuse map
+    m->diffuse_map.uv_rect[2] = 1.0f;
+    m->diffuse_map.uv_rect[3] = 1.0f;
     if (string_length(config.diffuse_texture_name) > 0) {
         m->diffuse_map.use = TEXTURE_USE_MAP_DIFFUSE;
-        m->diffuse_map.texture = texture_system_acquire(config.diffuse_texture_name, TRUE);
+        // Atlas entries are named "<atlas>:<entry>" and map their part of the atlas texture.
+        if (string_index_of(config.diffuse_texture_name, TEXTURE_ATLAS_ENTRY_SEPARATOR) > 0) {
+            m->diffuse_map.texture = texture_system_acquire_atlas_entry(config.diffuse_texture_name, m->diffuse_map.uv_rect);
+        } else {
+            // Textures stream in, so the material is drawn with the mip tail until the larger levels arrive.
+            m->diffuse_map.texture = texture_system_acquire_streamed(config.diffuse_texture_name, 0.0f, TRUE);
+        }
         if (!m->diffuse_map.texture) {
             LOG_WARNING("Unable to load texture '%s' for material '%s', using default.", config.diffuse_texture_name, m->name);
             m->diffuse_map.texture = texture_system_get_default_texture();
@@ -301,6 +394,8 @@ b8 create_default_material()
 
     state->default_material.diffuse_map.use = TEXTURE_USE_MAP_DIFFUSE;
     state->default_material.diffuse_map.texture = texture_system_get_default_texture();
+    state->default_material.diffuse_map.uv_rect[2] = 1.0f;
+    state->default_material.diffuse_map.uv_rect[3] = 1.0f;
 
     if (!renderer_frontend_create_material(&state->default_material)) {
         LOG_FATAL("create_default_material: Failed to acquire renderer resources for default texture");
@@ -24,8 +24,16 @@ typedef struct Material_System_Config
 bool material_system_startup(Material_System_Config* config);
 void material_system_shutdown();
 
-Material* material_system_acquire(char const* name);
-Material* material_system_acquire_from_config(Material_Config config);
-void material_system_release(char const* name);
+LIB_API Material* material_system_acquire(char const* name);
+LIB_API Material* material_system_acquire_from_config(Material_Config config);
+
+/**
+ * @brief Acquires several materials at once. Their files and the textures they use are read, decoded and uploaded
+ * in one pipeline (see resource_batch_acquire), and textures shared between materials are loaded once.
+ * @param materials Receives one material per name, or 0 for the ones that failed to load.
+ * @return TRUE if every material was acquired; otherwise FALSE.
+ */
+LIB_API bool material_system_acquire_batch(char const* const* names, u32 count, Material** materials);
+LIB_API void material_system_release(char const* name);
 
 Material* material_system_get_default_material();
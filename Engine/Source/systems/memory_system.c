@@ -22,6 +22,9 @@ typedef struct memory_system_state
     u64 allocator_required_memory;
     dynamic_allocator allocator;
     void* allocator_block;
+
+    // Systems start up on worker threads, so allocations must be serialized.
+    platform_mutex allocation_mutex;
 } memory_system_state;
 
 static memory_system_state* state;
@@ -70,6 +73,12 @@ b8 memory_system_startup(memory_system_configuration config)
     state->allocator_required_memory = allocator_required_memory;
     state->allocator_block = (void*)((char*)block + state_required_memory);
     platform_zero_memory(&state->stats, sizeof(state->stats));
+    if (!platform_mutex_create(&state->allocation_mutex))
+    {
+        LOG_FATAL("memory_system_startup: Failed to create allocation mutex");
+        return FALSE;
+    }
+
     if (!dynamic_allocator_create(&state->allocator_required_memory, state->allocator_block, config.tracked_memory, &state->allocator))
     {
         LOG_FATAL("memory_system_startup: Failed to create internal dynamic allocator");
@@ -85,6 +94,7 @@ void memory_system_shutdown()
     if (state)
     {
         dynamic_allocator_destroy(&state->allocator);
+        platform_mutex_destroy(&state->allocation_mutex);
         platform_free(state, FALSE);
     }
 
@@ -100,10 +110,12 @@ void* memory_system_allocate(u64 size, memory_tag tag)
 
     if (state)
     {
+        platform_mutex_lock(&state->allocation_mutex);
         state->stats.allocated_memory += size;
         state->stats.allocated_memory_by_tags[tag] += size;
         state->allocation_count++;
         void* block = dynamic_allocator_allocate(&state->allocator, size);
+        platform_mutex_unlock(&state->allocation_mutex);
         if (!block)
         {
             LOG_FATAL("memory_system_allocate: Failed to allocate required memory");
@@ -127,15 +139,19 @@ void memory_system_free(void* block, u64 size, memory_tag tag)
 
     if (state)
     {
+        platform_mutex_lock(&state->allocation_mutex);
         state->stats.allocated_memory -= size;
         state->stats.allocated_memory_by_tags[tag] -= size;
-        if (!dynamic_allocator_free(&state->allocator, block, size))
+        b8 result = dynamic_allocator_free(&state->allocator, block, size);
+        platform_mutex_unlock(&state->allocation_mutex);
+        if (!result)
         {
             LOG_FATAL("memory_system_free: Failed to free the block of memory");
 
             // TODO: Report error
-            return;
         }
+
+        return;
     }
 
     LOG_WARNING("memory_system_free: Called before the system is initialized");
@@ -0,0 +1,560 @@
+#include "resource_batch.h"
+
+#include "containers/dynamic_array.h"
+#include "core/hash.h"
+#include "core/logger.h"
+#include "core/string_utils.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "systems/job_system.h"
+#include "systems/memory_system.h"
+
+#define MAX_DEPENDENCY_COUNT 16
+
+typedef enum Node_State
+{
+    NODE_STATE_PENDING,
+    NODE_STATE_READING,
+    NODE_STATE_DECODING,
+    NODE_STATE_LOADED, // acquired, waiting for dependencies
+    NODE_STATE_READY,
+    NODE_STATE_FAILED
+} Node_State;
+
+/**
+ * @brief One resource of the dependency graph. Allocated individually, so that decode jobs can hold on to it while the graph grows.
+ */
+typedef struct Batch_Node
+{
+    Resource_Type type;
+    char name[RESOURCE_NAME_MAX_LENGTH];
+    u64 hash;
+    u32 request_index;
+    Node_State state;
+    u32 pending_dependency_count;
+
+    Resource_Loader const* loader;
+    Resource_Data data;
+
+    // Input of the decode job: either a read buffer or a mapping of a pack entry.
+    char disk_path[256];
+    void* buffer;
+    u64 buffer_size;
+    File_View view;
+
+    // Written by the decode job, which publishes them by setting decoded.
+    bool decode_succeeded;
+    f64 decode_seconds;
+    i32 volatile decoded;
+} Batch_Node;
+
+typedef struct Batch_Edge
+{
+    Batch_Node* dependent;
+    Batch_Node* dependency;
+} Batch_Edge;
+
+/**
+ * @brief Reads submitted together. A new wave starts whenever resources are discovered while others are in flight.
+ */
+typedef struct Batch_Wave
+{
+    File_Read_Batch batch;
+    File_Read_Request* requests;
+    Batch_Node** nodes;
+    u32 capacity;
+    u32 count;
+    u32 consumed_count;
+} Batch_Wave;
+
+typedef struct Batch
+{
+    Dynamic_Array* nodes;
+    Dynamic_Array* edges;
+    Dynamic_Array* waves;
+    bool auto_release;
+    PFN_resource_batch_on_ready on_ready;
+    void* user_data;
+    Resource_Batch_Stats stats;
+} Batch;
+
+static Batch_Node* add_node(Batch* batch, Resource_Type type, char const* name, u32 request_index);
+static void start_pending(Batch* batch);
+static bool poll_waves(Batch* batch);
+static bool collect_decoded(Batch* batch);
+static bool resolve_ready(Batch* batch);
+static bool break_cycle(Batch* batch);
+static void on_loaded(Batch* batch, Batch_Node* node);
+static void finish(Batch* batch, Batch_Node* node, Node_State state);
+static void release_input(Batch_Node* node);
+static void decode_job(void* params);
+static void load_job(void* params);
+
+bool resource_batch_acquire(Resource_Batch_Request const* requests, u32 count, bool auto_release, PFN_resource_batch_on_ready on_ready,
+    void* user_data, Resource_Data* resources, Resource_Batch_Stats* stats)
+{
+    if (!requests || !resources)
+    {
+        LOG_ERROR("resource_batch_acquire: Invalid parameters");
+        return false;
+    }
+
+    f64 start_time = platform_get_absolute_time();
+    Batch batch = {};
+    batch.nodes = DYNAMIC_ARRAY_CREATE(Batch_Node*);
+    batch.edges = DYNAMIC_ARRAY_CREATE(Batch_Edge);
+    batch.waves = DYNAMIC_ARRAY_CREATE(Batch_Wave*);
+    batch.auto_release = auto_release;
+    batch.on_ready = on_ready;
+    batch.user_data = user_data;
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        add_node(&batch, requests[i].type, requests[i].name, i);
+    }
+
+    // Every pass starts what can be started and collects what has finished, so reads, decodes and callbacks overlap.
+    u32 done_count = 0;
+    while (done_count < batch.nodes->size || batch.waves->size > 0)
+    {
+        start_pending(&batch);
+        bool progressed = poll_waves(&batch);
+        progressed = collect_decoded(&batch) || progressed;
+        progressed = resolve_ready(&batch) || progressed;
+
+        done_count = 0;
+        for (u32 i = 0; i < batch.nodes->size; ++i)
+        {
+            Node_State state = DYNAMIC_ARRAY_AT_AS(batch.nodes, i, Batch_Node*)->state;
+            done_count += state == NODE_STATE_READY || state == NODE_STATE_FAILED;
+        }
+
+        if (!progressed && batch.waves->size == 0 && !break_cycle(&batch))
+        {
+            break;
+        }
+
+        if (!progressed && (done_count < batch.nodes->size || batch.waves->size > 0))
+        {
+            platformSleep(0);
+        }
+    }
+
+    // Every request takes its own reference. The batch then drops the ones it held while loading, which leaves
+    // dependencies cached rather than acquired.
+    bool result = true;
+    for (u32 i = 0; i < count; ++i)
+    {
+        memory_system_zero(&resources[i], sizeof(resources[i]));
+        result = resource_manager_acquire_if_loaded(requests[i].type, requests[i].name, auto_release, &resources[i]) && result;
+    }
+
+    for (u32 i = 0; i < batch.nodes->size; ++i)
+    {
+        Batch_Node* node = DYNAMIC_ARRAY_AT_AS(batch.nodes, i, Batch_Node*);
+        if (node->state == NODE_STATE_READY)
+        {
+            resource_manager_release(&node->data);
+        }
+
+        memory_system_free(node, sizeof(*node), MEMORY_TAG_RESOURCES);
+    }
+
+    dynamic_array_destroy(batch.nodes);
+    dynamic_array_destroy(batch.edges);
+    dynamic_array_destroy(batch.waves);
+
+    batch.stats.seconds = platform_get_absolute_time() - start_time;
+    if (stats)
+    {
+        *stats = batch.stats;
+    }
+
+    return result;
+}
+
+void resource_batch_log_stats(Resource_Batch_Stats const* stats)
+{
+    static char const* const stage_names[RESOURCE_BATCH_STAGE_ENUM_COUNT] = { "I/O", "decode", "upload" };
+
+    LOG_INFO("Resource batch: %u resources (%u cached, %u shared, %u failed) in %.3f ms",
+        stats->resource_count, stats->cached_count, stats->duplicate_count, stats->failed_count, stats->seconds * 1000.0);
+    for (u32 i = 0; i < RESOURCE_BATCH_STAGE_ENUM_COUNT; ++i)
+    {
+        Resource_Batch_Stage_Stats const* stage = &stats->stages[i];
+        f64 seconds = stage->seconds > 0.0 ? stage->seconds : 1e-9;
+        f64 mebibytes = stage->size / (f64)(MEBIBYTES(1));
+        LOG_INFO("  %-8s %5u items %10.3f MiB %9.3f ms  %9.1f items/s %9.1f MiB/s", stage_names[i], stage->count,
+            mebibytes, stage->seconds * 1000.0, stage->count / seconds, mebibytes / seconds);
+    }
+}
+
+Batch_Node* add_node(Batch* batch, Resource_Type type, char const* name, u32 request_index)
+{
+    u64 hash = hash_bytes(name, string_length(name), type);
+    for (u32 i = 0; i < batch->nodes->size; ++i)
+    {
+        Batch_Node* node = DYNAMIC_ARRAY_AT_AS(batch->nodes, i, Batch_Node*);
+        if (node->hash == hash && node->type == type && string_equal(node->name, name))
+        {
+            batch->stats.duplicate_count++;
+            if (node->request_index == INVALID_ID)
+            {
+                node->request_index = request_index;
+            }
+
+            return node;
+        }
+    }
+
+    Batch_Node* node = memory_system_allocate(sizeof(*node), MEMORY_TAG_RESOURCES);
+    memory_system_zero(node, sizeof(*node));
+    node->type = type;
+    node->hash = hash;
+    node->request_index = request_index;
+    node->state = NODE_STATE_PENDING;
+    node->loader = resource_manager_get_loader(type);
+    if (!node->loader || string_length(name) >= RESOURCE_NAME_MAX_LENGTH)
+    {
+        LOG_ERROR("resource_batch_acquire: Can't load '%s'", name);
+        node->state = NODE_STATE_FAILED;
+        batch->stats.failed_count++;
+    }
+    else
+    {
+        string_copy(node->name, name);
+    }
+
+    dynamic_array_push_back(batch->nodes, &node);
+    batch->stats.resource_count++;
+    return node;
+}
+
+void start_pending(Batch* batch)
+{
+    // Dependencies discovered on the way are started by the next pass, so the wave can be sized now.
+    Batch_Wave* wave = 0;
+    u32 node_count = batch->nodes->size;
+    for (u32 i = 0; i < node_count; ++i)
+    {
+        Batch_Node* node = DYNAMIC_ARRAY_AT_AS(batch->nodes, i, Batch_Node*);
+        if (node->state != NODE_STATE_PENDING)
+        {
+            continue;
+        }
+
+        if (resource_manager_acquire_if_loaded(node->type, node->name, true, &node->data))
+        {
+            batch->stats.cached_count++;
+            on_loaded(batch, node);
+            continue;
+        }
+
+        // Loaders that can't decode from memory read for themselves on a worker.
+        if (!node->loader->get_path || !node->loader->load_from_memory)
+        {
+            node->state = NODE_STATE_DECODING;
+            job_system_submit(load_job, node, 0);
+            continue;
+        }
+
+        char path[RESOURCE_NAME_MAX_LENGTH];
+        File_Location location;
+        node->loader->get_path(node->name, path);
+        if (!filesystem_locate(path, &location))
+        {
+            LOG_ERROR("resource_batch_acquire: Failed to find '%s'", path);
+            finish(batch, node, NODE_STATE_FAILED);
+            continue;
+        }
+
+        // Pack entries are already mapped, so they go straight to decoding.
+        if (location.in_pack)
+        {
+            if (!filesystem_map_asset(path, &node->view))
+            {
+                finish(batch, node, NODE_STATE_FAILED);
+                continue;
+            }
+
+            node->state = NODE_STATE_DECODING;
+            job_system_submit(decode_job, node, 0);
+            continue;
+        }
+
+        if (!wave)
+        {
+            wave = memory_system_allocate(sizeof(*wave), MEMORY_TAG_RESOURCES);
+            memory_system_zero(wave, sizeof(*wave));
+            wave->capacity = node_count - i;
+            wave->requests = memory_system_allocate(wave->capacity * sizeof(*wave->requests), MEMORY_TAG_RESOURCES);
+            wave->nodes = memory_system_allocate(wave->capacity * sizeof(*wave->nodes), MEMORY_TAG_RESOURCES);
+            memory_system_zero(wave->requests, wave->capacity * sizeof(*wave->requests));
+        }
+
+        string_copy(node->disk_path, location.disk_path);
+        node->buffer_size = location.size;
+        node->buffer = memory_system_allocate(location.size ? location.size : 1, MEMORY_TAG_RESOURCES);
+
+        File_Read_Request* request = &wave->requests[wave->count];
+        request->path = node->disk_path;
+        request->offset = 0;
+        request->size = location.size;
+        request->buffer = node->buffer;
+        wave->nodes[wave->count] = node;
+        wave->count++;
+        node->state = NODE_STATE_READING;
+    }
+
+    if (wave && filesystem_read_batch_submit(wave->requests, wave->count, &wave->batch))
+    {
+        dynamic_array_push_back(batch->waves, &wave);
+    }
+    else if (wave)
+    {
+        for (u32 i = 0; i < wave->count; ++i)
+        {
+            release_input(wave->nodes[i]);
+            finish(batch, wave->nodes[i], NODE_STATE_FAILED);
+        }
+
+        memory_system_free(wave->requests, wave->capacity * sizeof(*wave->requests), MEMORY_TAG_RESOURCES);
+        memory_system_free(wave->nodes, wave->capacity * sizeof(*wave->nodes), MEMORY_TAG_RESOURCES);
+        memory_system_free(wave, sizeof(*wave), MEMORY_TAG_RESOURCES);
+    }
+}
+
+bool poll_waves(Batch* batch)
+{
+    bool progressed = false;
+    for (u32 i = 0; i < batch->waves->size;)
+    {
+        Batch_Wave* wave = DYNAMIC_ARRAY_AT_AS(batch->waves, i, Batch_Wave*);
+        filesystem_read_batch_poll(&wave->batch);
+        for (u32 j = 0; j < wave->count; ++j)
+        {
+            File_Read_Request* request = &wave->requests[j];
+            Batch_Node* node = wave->nodes[j];
+            if (node->state != NODE_STATE_READING || !request->completed)
+            {
+                continue;
+            }
+
+            progressed = true;
+            wave->consumed_count++;
+            if (!request->succeeded || request->bytes_read != request->size)
+            {
+                LOG_ERROR("resource_batch_acquire: Failed to read '%s'", request->path);
+                release_input(node);
+                finish(batch, node, NODE_STATE_FAILED);
+                continue;
+            }
+
+            batch->stats.stages[RESOURCE_BATCH_STAGE_IO].count++;
+            batch->stats.stages[RESOURCE_BATCH_STAGE_IO].size += request->bytes_read;
+            batch->stats.stages[RESOURCE_BATCH_STAGE_IO].seconds += request->seconds;
+            node->state = NODE_STATE_DECODING;
+            job_system_submit(decode_job, node, 0);
+        }
+
+        if (wave->consumed_count < wave->count)
+        {
+            ++i;
+            continue;
+        }
+
+        // Every read has completed, so waiting only releases the wave.
+        filesystem_read_batch_wait(&wave->batch);
+        memory_system_free(wave->requests, wave->capacity * sizeof(*wave->requests), MEMORY_TAG_RESOURCES);
+        memory_system_free(wave->nodes, wave->capacity * sizeof(*wave->nodes), MEMORY_TAG_RESOURCES);
+        memory_system_free(wave, sizeof(*wave), MEMORY_TAG_RESOURCES);
+
+        Batch_Wave* last;
+        dynamic_array_pop(batch->waves, &last);
+        if (i < batch->waves->size)
+        {
+            DYNAMIC_ARRAY_AT_AS(batch->waves, i, Batch_Wave*) = last;
+        }
+    }
+
+    return progressed;
+}
+
+bool collect_decoded(Batch* batch)
+{
+    bool progressed = false;
+    for (u32 i = 0; i < batch->nodes->size; ++i)
+    {
+        Batch_Node* node = DYNAMIC_ARRAY_AT_AS(batch->nodes, i, Batch_Node*);
+        if (node->state != NODE_STATE_DECODING || !platform_atomic_load_acquire(&node->decoded))
+        {
+            continue;
+        }
+
+        progressed = true;
+        release_input(node);
+        batch->stats.stages[RESOURCE_BATCH_STAGE_DECODE].seconds += node->decode_seconds;
+        if (!node->decode_succeeded)
+        {
+            LOG_ERROR("resource_batch_acquire: Failed to load '%s'", node->name);
+            finish(batch, node, NODE_STATE_FAILED);
+            continue;
+        }
+
+        batch->stats.stages[RESOURCE_BATCH_STAGE_DECODE].count++;
+        batch->stats.stages[RESOURCE_BATCH_STAGE_DECODE].size += node->data.memory_size ? node->data.memory_size : node->data.size;
+        if (!resource_manager_acquire_loaded(node->type, node->name, true, &node->data))
+        {
+            finish(batch, node, NODE_STATE_FAILED);
+            continue;
+        }
+
+        on_loaded(batch, node);
+    }
+
+    return progressed;
+}
+
+bool resolve_ready(Batch* batch)
+{
+    // Readiness propagates from dependencies to dependents, so repeat until nothing changes.
+    bool progressed = false;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (u32 i = 0; i < batch->nodes->size; ++i)
+        {
+            Batch_Node* node = DYNAMIC_ARRAY_AT_AS(batch->nodes, i, Batch_Node*);
+            if (node->state == NODE_STATE_LOADED && node->pending_dependency_count == 0)
+            {
+                finish(batch, node, NODE_STATE_READY);
+                changed = true;
+                progressed = true;
+            }
+        }
+    }
+
+    return progressed;
+}
+
+bool break_cycle(Batch* batch)
+{
+    // With nothing in flight, loaded resources that still wait can only be waiting on each other.
+    Batch_Node* waiting = 0;
+    for (u32 i = 0; i < batch->nodes->size; ++i)
+    {
+        Batch_Node* node = DYNAMIC_ARRAY_AT_AS(batch->nodes, i, Batch_Node*);
+        if (node->state == NODE_STATE_PENDING || node->state == NODE_STATE_READING || node->state == NODE_STATE_DECODING)
+        {
+            return true;
+        }
+
+        if (node->state == NODE_STATE_LOADED && !waiting)
+        {
+            waiting = node;
+        }
+    }
+
+    if (!waiting)
+    {
+        return false;
+    }
+
+    LOG_WARNING("resource_batch_acquire: '%s' is part of a dependency cycle", waiting->name);
+    waiting->pending_dependency_count = 0;
+    return true;
+}
+
+void on_loaded(Batch* batch, Batch_Node* node)
+{
+    node->state = NODE_STATE_LOADED;
+    if (!node->loader->get_dependencies)
+    {
+        return;
+    }
+
+    Resource_Dependency dependencies[MAX_DEPENDENCY_COUNT];
+    u32 count = node->loader->get_dependencies(&node->data, dependencies, MAX_DEPENDENCY_COUNT);
+    if (count > MAX_DEPENDENCY_COUNT)
+    {
+        LOG_WARNING("resource_batch_acquire: '%s' has %u dependencies. Only the first %u are loaded ahead", node->name, count, MAX_DEPENDENCY_COUNT);
+        count = MAX_DEPENDENCY_COUNT;
+    }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        Batch_Node* dependency = add_node(batch, dependencies[i].type, dependencies[i].name, INVALID_ID);
+        if (dependency == node || dependency->state == NODE_STATE_READY || dependency->state == NODE_STATE_FAILED)
+        {
+            continue;
+        }
+
+        Batch_Edge edge = { node, dependency };
+        dynamic_array_push_back(batch->edges, &edge);
+        node->pending_dependency_count++;
+    }
+}
+
+void finish(Batch* batch, Batch_Node* node, Node_State state)
+{
+    node->state = state;
+    if (state == NODE_STATE_FAILED)
+    {
+        batch->stats.failed_count++;
+    }
+    else if (batch->on_ready)
+    {
+        f64 start_time = platform_get_absolute_time();
+        batch->on_ready(&node->data, node->request_index, batch->user_data);
+        Resource_Batch_Stage_Stats* upload = &batch->stats.stages[RESOURCE_BATCH_STAGE_UPLOAD];
+        upload->seconds += platform_get_absolute_time() - start_time;
+        upload->count++;
+        upload->size += node->data.memory_size ? node->data.memory_size : node->data.size;
+    }
+
+    // A failed dependency doesn't hold its dependents back; they fall back as they would without a batch.
+    for (u32 i = 0; i < batch->edges->size; ++i)
+    {
+        Batch_Edge* edge = dynamic_array_at(batch->edges, i);
+        if (edge->dependency == node)
+        {
+            edge->dependent->pending_dependency_count--;
+            edge->dependency = 0;
+        }
+    }
+}
+
+void release_input(Batch_Node* node)
+{
+    if (node->buffer)
+    {
+        memory_system_free(node->buffer, node->buffer_size ? node->buffer_size : 1, MEMORY_TAG_RESOURCES);
+        node->buffer = 0;
+    }
+
+    if (node->view.data)
+    {
+        filesystem_unmap(&node->view);
+    }
+}
+
+void decode_job(void* params)
+{
+    Batch_Node* node = params;
+    f64 start_time = platform_get_absolute_time();
+    void const* data = node->buffer ? node->buffer : node->view.data;
+    u64 size = node->buffer ? node->buffer_size : node->view.size;
+    node->decode_succeeded = node->loader->load_from_memory(data, size, &node->data);
+    node->decode_seconds = platform_get_absolute_time() - start_time;
+    platform_atomic_store_release(&node->decoded, 1);
+}
+
+void load_job(void* params)
+{
+    Batch_Node* node = params;
+    f64 start_time = platform_get_absolute_time();
+    node->decode_succeeded = node->loader->load(node->name, &node->data);
+    node->decode_seconds = platform_get_absolute_time() - start_time;
+    platform_atomic_store_release(&node->decoded, 1);
+}
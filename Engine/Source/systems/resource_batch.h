@@ -0,0 +1,65 @@
+#pragma once
+
+#include "defines.h"
+#include "systems/resource_manager.h"
+
+typedef enum Resource_Batch_Stage
+{
+    /** @brief Reading files ahead of decoding. */
+    RESOURCE_BATCH_STAGE_IO,
+    /** @brief Building resources on worker threads, including loaders that read for themselves. */
+    RESOURCE_BATCH_STAGE_DECODE,
+    /** @brief The on_ready callbacks on the calling thread, where consumers create GPU objects. */
+    RESOURCE_BATCH_STAGE_UPLOAD,
+    RESOURCE_BATCH_STAGE_ENUM_COUNT
+} Resource_Batch_Stage;
+
+typedef struct Resource_Batch_Stage_Stats
+{
+    u32 count;
+    u64 size;
+    /** @brief Time spent in the stage. The summed time of its work, which for I/O is the time taken by each read. */
+    f64 seconds;
+} Resource_Batch_Stage_Stats;
+
+typedef struct Resource_Batch_Stats
+{
+    Resource_Batch_Stage_Stats stages[RESOURCE_BATCH_STAGE_ENUM_COUNT];
+    /** @brief Distinct resources of the batch, requested or depended on. */
+    u32 resource_count;
+    /** @brief Requests and dependencies that named a resource already in the batch. */
+    u32 duplicate_count;
+    /** @brief Resources that were already loaded or cached. */
+    u32 cached_count;
+    u32 failed_count;
+    f64 seconds;
+} Resource_Batch_Stats;
+
+typedef struct Resource_Batch_Request
+{
+    Resource_Type type;
+    char const* name;
+} Resource_Batch_Request;
+
+/**
+ * @brief Called on the acquiring thread once a resource and everything it depends on are loaded. Dependencies are
+ * reported before their dependents, and each resource once, however often it is named.
+ * @param request_index The first request naming the resource, or INVALID_ID for a dependency.
+ */
+typedef void (* PFN_resource_batch_on_ready)(Resource_Data const* resource, u32 request_index, void* user_data);
+
+/**
+ * @brief Acquires many resources at once, together with their dependencies (see Resource_Loader.get_dependencies).
+ * Shared dependencies are loaded once. Files are read in batches, decoded on the job system as their reads complete,
+ * and handed to _on_ready_ while other resources are still in flight.
+ * Dependencies stay cached by the resource manager, but only the requested resources stay acquired.
+ * @param auto_release Passed to resource_manager_acquire for the requested resources.
+ * @param on_ready Optional.
+ * @param resources Receives one acquired resource per request, to be released with resource_manager_release. Zeroed for failed ones.
+ * @param stats Optional.
+ * @return TRUE if every requested resource was acquired; otherwise FALSE.
+ */
+LIB_API bool resource_batch_acquire(Resource_Batch_Request const* requests, u32 count, bool auto_release, PFN_resource_batch_on_ready on_ready,
+    void* user_data, Resource_Data* resources, Resource_Batch_Stats* stats);
+
+LIB_API void resource_batch_log_stats(Resource_Batch_Stats const* stats);
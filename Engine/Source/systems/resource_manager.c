@@ -1,403 +1,511 @@
 #include "resource_manager.h"
 
-#include "containers/hash_table.h"
+#include "core/hash.h"
 #include "core/logger.h"
-#include "core/math_utils.h"
 #include "core/string_utils.h"
-#include "memory/linear_allocator.h"
 #include "resources/loaders.h"
 #include "systems/memory_system.h"
 
-typedef struct Material_Resource
-{
-    bool empty;
-    char* name;
-    char* filename;
-    u32 id;
-    u32 backend_id;
-    Material_Type type;
-    vec4s diffuse_color;
-    Texture_Map diffuse_map;
-} Material_Resource;
-
-typedef enum Resource_Type
-{
-    RESOURCE_TYPE_TEXT,
-    RESOURCE_TYPE_BINARY,
-    RESOURCE_TYPE_IMAGE,
-    RESOURCE_TYPE_MATERIAL,
-    RESOURCE_TYPE_SHADER_CONFIG,
-    RESOURCE_TYPE_STATIC_MESH,
-    RESOURCE_TYPE_ENUM_COUNT
-} Resource_Type;
-
-typedef struct Resource
-{
-    char const* filepath;
-    Resource_Type type;
-    u32 reference_count;
-    u32 slot; // index in the corresponding resource array
-    bool auto_release; // if reference_count reaches zero
-} Resource;
+#define EMPTY_SLOT INVALID_ID
 
 typedef struct Resource_Entry
 {
-    void* resource;
-    // Resource resource;
+    char filename[RESOURCE_NAME_MAX_LENGTH];
+    Resource_Type type;
+    u64 hash;
+    u32 reference_count;
+    bool auto_release; // if the resource may be cached once reference_count reaches zero
+    bool cached;
+    u64 memory_size;
+    Resource_Data data;
+
+    // Links in the cache of the type while reference_count is zero, and in the free list while the entry is unused.
+    struct Resource_Entry* previous;
+    struct Resource_Entry* next;
 } Resource_Entry;
 
 /**
- * @brief LUT containing references to all resources.
- * A non-shrinkable (but growable) hash table.
- * The keys are resource file paths.
- * Open addressing collision resolution. Double probing.
+ * @brief Released resources of one type, most recently released first. The tail is evicted first.
  */
-typedef struct Resource_Lookup_Table
+typedef struct Resource_Cache
 {
-    u32 size;
-    u32 used;
-    Resource_Entry* entries;
-} Resource_Lookup_Table;
+    Resource_Entry* head;
+    Resource_Entry* tail;
+    u64 budget;
+    Resource_Cache_Stats stats;
+} Resource_Cache;
 
 typedef struct Resource_System_State
 {
-    Linear_Allocator* allocator;
-    Hash_Table* lut;
-    Resource_Loader* loaders[RESOURCE_TYPE_ENUM_COUNT];
-} Resource_System_State;
-
+    Resource_System_Config config;
+    Resource_Loader const* loaders[RESOURCE_TYPE_ENUM_COUNT];
+    bool owns_loader[RESOURCE_TYPE_ENUM_COUNT];
+    Resource_Cache caches[RESOURCE_TYPE_ENUM_COUNT];
 
+    Resource_Entry* entries;
+    Resource_Entry* free_entries;
+
+    /**
+     * @brief Entry indices keyed by type and filename. Linear probing with backward-shift deletion, so no tombstones
+     * accumulate as resources are evicted. Sized to stay at most half full.
+     */
+    u32* slots;
+    u32 slot_mask;
+} Resource_System_State;
 
 static Resource_System_State* state;
 
-static bool load_resource(char const* filepath);
-
-
-/**
- * @brief Finds the entry that contains a given key, if the key is in the table, or 0.
- */
-static Resource_Entry* lookup_table_find_by_hash(Resource_Lookup_Table* lut, u32 hash_key);
-
-/**
- * @brief Finds the first empty entry corresponding the key, or 0.
- */
-static Resource_Entry* lookup_table_find_empty(Resource_Lookup_Table* lut, u32 hash_key);
-
-/**
- * @brief Check if the table contains a given key.
- */
-static bool lookup_table_contains(Resource_Lookup_Table* lut, u32 hash_key);
-
-/**
- * @brief Doubles the table size.
- */
-static bool lookup_table_resize(Resource_Lookup_Table* lut, u32 new_size);
-
-/**
- * @brief Insert a new resource into the table.
- */
-static bool lookup_table_insert(Resource_Lookup_Table* lut, u32 hash_key, Resource* resource);
-
-/**
- * @brief Searching for the next available entry for inserting a new resource.
- */
-static u32 lookup_table_probe(u32 hash_key, u32 i, u32 lut_size);
-
-static i32 find_empty_slot(Resource_Type type);
-static i32 find_empty_material_slot();
-
-
-static bool load_material_config(char const* filename, Material_Config* material);
-
-#define INITIAL_LOOKUP_TABLE_SIZE 1024
-
-bool resource_manager_startup()
+static u64 hash_key(Resource_Type type, char const* filename);
+static Resource_Entry* find_entry(Resource_Type type, char const* filename);
+static void insert_entry(Resource_Entry* entry);
+static void remove_entry(Resource_Entry* entry);
+static Resource_Entry* take_free_entry(Resource_Type type);
+static void add_entry(Resource_Entry* entry, Resource_Type type, char const* filename);
+static void reference_entry(Resource_Entry* entry, bool auto_release, Resource_Data* resource);
+static bool validate_request(char const* function, Resource_Type type, char const* filename, Resource_Data* resource);
+static void cache_push(Resource_Entry* entry);
+static void cache_remove(Resource_Entry* entry);
+static void trim_cache(Resource_Type type);
+static void evict(Resource_Entry* entry);
+static void unload_entry(Resource_Entry* entry);
+
+bool resource_manager_startup(u64* required_memory, void* block, Resource_System_Config config)
 {
-    if (!linear_allocator_create(1024 * 1024/*1 MiB*/, state->allocator))
+    if (config.max_resource_count == 0)
     {
-        LOG_FATAL("resource_manager_startup: Failed to create allocator");
+        LOG_FATAL("resource_manager_startup: Invalid input parameters");
         return false;
     }
 
-    state->lut = HASH_TABLE_CREATE(Resource_Entry, INITIAL_LOOKUP_TABLE_SIZE);
-    for (u32 i = 0; i < state->lut->size; ++i)
+    u32 slot_count = 1;
+    while (slot_count < config.max_resource_count * 2)
     {
-        state->lut->entries[i].is_empty = true;
-        state->lut->entries[i].in_probe = false;
-        state->lut->entries[i].resource.auto_release = true;
+        slot_count <<= 1;
     }
 
-    for (u32 i; i < MAX_MATERIAL_RESOURCE_COUNT; ++i)
+    u64 state_required_memory = sizeof(*state);
+    u64 entries_required_memory = config.max_resource_count * sizeof(*state->entries);
+    u64 slots_required_memory = slot_count * sizeof(*state->slots);
+    *required_memory = state_required_memory + entries_required_memory + slots_required_memory;
+    if (!block)
     {
-        state->resources.materials[i].empty = true;
+        return true;
     }
 
+    memory_system_zero(block, *required_memory);
+    state = block;
+    state->config = config;
+    state->entries = (Resource_Entry*)((u8*)state + state_required_memory);
+    state->slots = (u32*)((u8*)state->entries + entries_required_memory);
+    state->slot_mask = slot_count - 1;
+    for (u32 i = 0; i < slot_count; ++i)
+    {
+        state->slots[i] = EMPTY_SLOT;
+    }
 
+    for (u32 i = config.max_resource_count; i > 0; --i)
+    {
+        state->entries[i - 1].next = state->free_entries;
+        state->free_entries = &state->entries[i - 1];
+    }
 
+    for (u32 i = 0; i < RESOURCE_TYPE_ENUM_COUNT; ++i)
+    {
+        state->caches[i].budget = config.cache_budgets[i];
+        state->loaders[i] = config.loaders[i];
+    }
 
+    Resource_Loader* (* const builtin_loaders[RESOURCE_TYPE_ENUM_COUNT])() = {
+        [RESOURCE_TYPE_TEXT] = text_loader_create,
+        [RESOURCE_TYPE_BINARY] = binary_loader_create,
+        [RESOURCE_TYPE_IMAGE] = image_loader_create,
+        [RESOURCE_TYPE_MATERIAL] = material_loader_create,
+        [RESOURCE_TYPE_SHADER_CONFIG] = shader_config_loader_create
+    };
 
+    for (u32 i = 0; i < RESOURCE_TYPE_ENUM_COUNT; ++i)
+    {
+        if (!state->loaders[i] && builtin_loaders[i])
+        {
+            state->loaders[i] = builtin_loaders[i]();
+            state->owns_loader[i] = true;
+        }
+    }
 
-
-    state->loaders[RESOURCE_TYPE_TEXT] = text_loader_create();
-    state->loaders[RESOURCE_TYPE_BINARY] = binary_loader_create();
-    state->loaders[RESOURCE_TYPE_IMAGE] = image_loader_create();
-    state->loaders[RESOURCE_TYPE_MATERIAL] = material_loader_create();
-    state->loaders[RESOURCE_TYPE_SHADER_CONFIG] = shader_config_loader_create();
     return true;
 }
 
 void resource_manager_shutdown()
 {
-    if (state)
+    if (!state)
     {
-        for (u32 i = 0; i < RESOURCE_TYPE_ENUM_COUNT; ++i)
-        {
-            memory_system_free(&state->loaders[i], MEMORY_TAG_LOADERS);
-        }
-
-        memory_system_free(state, sizeof(*state), MEMORY_TAG_SYSTEMS);
-        state = 0;
+        LOG_WARNING("resource_manager_shutdown: Resource manager hasn't been started up yet");
+        return;
     }
 
-    LOG_WARNING("resource_manager_shutdown: Resource system hasn't been started up yet");
-}
-
+    for (u32 i = 0; i < state->config.max_resource_count; ++i)
+    {
+        Resource_Entry* entry = &state->entries[i];
+        if (entry->filename[0])
+        {
+            if (entry->reference_count)
+            {
+                LOG_WARNING("resource_manager_shutdown: '%s' is still referenced %u times", entry->filename, entry->reference_count);
+            }
 
+            unload_entry(entry);
+        }
+    }
 
-bool load_resource(char const* filepath)
-{
-    Resource_Entry entry;
-    entry.hash_key = DJB2_hash(filepath);
-    if (string_equal(filepath, "materials"))
-    {
-        // entry.resource.type = RESOURCE_TYPE_MATERIAL;
-        // for (u32 i = 0; i < MAX_MATERIAL_RESOURCE_COUNT; ++i)
-        // {
-        //     if (state->resources.materials[i].empty)
-        //     {
-        //         entry.resource.slot = i;
-        //         state->resources.materials[i].empty = false;
-        //     }
-        // }
-
-        Material_Resource* resource = linear_allocator_allocate(state->allocator, sizeof(*resource));
-        if (!resource)
+    for (u32 i = 0; i < RESOURCE_TYPE_ENUM_COUNT; ++i)
+    {
+        Resource_Cache_Stats* stats = &state->caches[i].stats;
+        if (stats->hits || stats->misses)
         {
-            LOG_FATAL("load_resource: Failed to allocate memory for resource");
-            return false;
+            LOG_INFO("resource_manager_shutdown: Type %u: %llu hits, %llu misses, %llu evictions", i, stats->hits, stats->misses, stats->evictions);
         }
 
-        if (!state->loaders[entry.resource.type]->load(filepath, resource))
+        if (state->owns_loader[i])
         {
-            LOG_FATAL("load_resource: Failed to load resource");
-            return false;
+            memory_system_free((void*)state->loaders[i], sizeof(Resource_Loader), MEMORY_TAG_LOADERS);
         }
     }
-    else
+
+    state = 0;
+}
+
+bool resource_manager_acquire(Resource_Type type, char const* filename, bool auto_release, Resource_Data* resource)
+{
+    if (!validate_request("resource_manager_acquire", type, filename, resource))
     {
-        // other resource types
+        return false;
     }
 
-    if (!lookup_table_insert(state->lut, entry.hash_key, &entry.resource))
+    Resource_Cache* cache = &state->caches[type];
+    Resource_Entry* entry = find_entry(type, filename);
+    if (entry)
     {
-        LOG_FATAL("load_resource: Failed to insert new entry");
+        cache->stats.hits++;
+        reference_entry(entry, auto_release, resource);
+        return true;
+    }
+
+    cache->stats.misses++;
+    entry = take_free_entry(type);
+    if (!entry)
+    {
+        LOG_ERROR("resource_manager_acquire: Too many resources loaded. Failed to load '%s'", filename);
         return false;
     }
 
+    memory_system_zero(&entry->data, sizeof(entry->data));
+    if (!state->loaders[type]->load(filename, &entry->data))
+    {
+        LOG_ERROR("resource_manager_acquire: Failed to load '%s'", filename);
+        return false;
+    }
+
+    add_entry(entry, type, filename);
+    reference_entry(entry, auto_release, resource);
     return true;
 }
 
-void resource_manager_unload(Resource_Data* resource)
+bool resource_manager_acquire_if_loaded(Resource_Type type, char const* filename, bool auto_release, Resource_Data* resource)
 {
-    if (!resource)
+    if (!validate_request("resource_manager_acquire_if_loaded", type, filename, resource))
     {
-        LOG_FATAL("resource_manager_unload: Invalid parameters");
-        return;
+        return false;
     }
 
-    if (state)
+    Resource_Entry* entry = find_entry(type, filename);
+    if (!entry)
     {
-        state->loaders[resource->type]->unload(resource);
+        return false;
     }
 
-    LOG_WARNING("resource_manager_load: Resource system hasn't been started up yet");
+    state->caches[type].stats.hits++;
+    reference_entry(entry, auto_release, resource);
+    return true;
 }
 
-bool resource_manager_acquire(char const* filepath, bool auto_release, void* resource)
+bool resource_manager_acquire_loaded(Resource_Type type, char const* filename, bool auto_release, Resource_Data* resource)
 {
-    if (!state)
+    if (!validate_request("resource_manager_acquire_loaded", type, filename, resource))
     {
-        LOG_FATAL("resource_manager_acquire: Resource manager hasn't been started up yet");
         return false;
     }
 
-    if (!filepath)
+    // Loaded twice, e.g. by overlapping batches. The first copy wins.
+    Resource_Cache* cache = &state->caches[type];
+    Resource_Entry* entry = find_entry(type, filename);
+    if (entry)
     {
-        LOG_FATAL("resource_manager_acquire: Invalid parameters");
-        return false;
+        state->loaders[type]->unload(resource);
+        cache->stats.hits++;
+        reference_entry(entry, auto_release, resource);
+        return true;
     }
 
-    u32 hash_key = DJB2_hash(filepath);
-    Resource_Entry* entry = lookup_table_find_by_hash(state->lut, hash_key);
+    cache->stats.misses++;
+    entry = take_free_entry(type);
     if (!entry)
     {
-        if (!load_resource(filepath))
-        {
-            LOG_FATAL("resource_manager_acquire: Failed to load resource");
-            return false;
-        }
+        LOG_ERROR("resource_manager_acquire_loaded: Too many resources loaded. Failed to add '%s'", filename);
+        state->loaders[type]->unload(resource);
+        return false;
+    }
 
-        entry = lookup_table_find_by_hash(state->lut, hash_key);
+    entry->data = *resource;
+    add_entry(entry, type, filename);
+    reference_entry(entry, auto_release, resource);
+    return true;
+}
+
+Resource_Loader const* resource_manager_get_loader(Resource_Type type)
+{
+    return state && type < RESOURCE_TYPE_ENUM_COUNT ? state->loaders[type] : 0;
+}
+
+void resource_manager_release(Resource_Data* resource)
+{
+    if (!state)
+    {
+        LOG_WARNING("resource_manager_release: Resource manager hasn't been started up yet");
+        return;
     }
 
-    if (!entry)
+    if (!resource || resource->type >= RESOURCE_TYPE_ENUM_COUNT || !resource->filename)
     {
-        LOG_FATAL("resource_manager_acquire: Failed to acquire resource");
-        return false;
+        LOG_WARNING("resource_manager_release: Invalid parameters");
+        return;
     }
 
-    if (!auto_release && entry->resource.auto_release)
+    Resource_Entry* entry = find_entry(resource->type, resource->filename);
+    if (!entry || entry->reference_count == 0)
     {
-        entry->resource.auto_release = auto_release;
+        LOG_WARNING("resource_manager_release: '%s' isn't acquired", resource->filename);
+        return;
     }
 
-    entry->resource.reference_count++;
-    resource = // materials[entry->slot];
+    entry->reference_count--;
+    if (entry->reference_count == 0 && entry->auto_release)
+    {
+        cache_push(entry);
+        trim_cache(entry->type);
+    }
 
-    return true;
+    resource->data = 0;
+    resource->size = 0;
 }
 
+void resource_manager_get_cache_stats(Resource_Type type, Resource_Cache_Stats* stats)
+{
+    if (!state || type >= RESOURCE_TYPE_ENUM_COUNT || !stats)
+    {
+        LOG_WARNING("resource_manager_get_cache_stats: Invalid parameters");
+        return;
+    }
 
-Resource_Entry* lookup_table_find_by_hash(Resource_Lookup_Table* lut, u32 hash_key)
+    *stats = state->caches[type].stats;
+}
+
+bool validate_request(char const* function, Resource_Type type, char const* filename, Resource_Data* resource)
 {
-    for (u32 i = 0; i < lut->size; ++i)
+    if (!state)
     {
-        Resource_Entry* entry = lut->entries + lookup_table_probe(hash_key, i, lut->size);
-        if (entry->hash_key == hash_key)
-        {
-            return entry;
-        }
+        LOG_FATAL("%s: Resource manager hasn't been started up yet", function);
+        return false;
+    }
 
-        if (!entry->in_probe)
-        {
-            break;
-        }
+    if (type >= RESOURCE_TYPE_ENUM_COUNT || !filename || !resource || string_length(filename) >= RESOURCE_NAME_MAX_LENGTH)
+    {
+        LOG_FATAL("%s: Invalid parameters", function);
+        return false;
     }
 
-    return 0;
+    if (!state->loaders[type])
+    {
+        LOG_FATAL("%s: No loader for resource type %u", function, type);
+        return false;
+    }
+
+    return true;
 }
 
-Resource_Entry* lookup_table_find_empty(Resource_Lookup_Table* lut, u32 hash_key)
+Resource_Entry* take_free_entry(Resource_Type type)
 {
-    for (u32 i = 0; i < lut->size; ++i)
+    // When every entry is in use, the least recently released resource of this type makes room.
+    if (!state->free_entries && state->caches[type].tail)
     {
-        Resource_Entry* entry = lut->entries + lookup_table_probe(hash_key, i, lut->size);
-        if (entry->is_empty)
-        {
-            return entry;
-        }
+        evict(state->caches[type].tail);
     }
 
-    return 0;
+    return state->free_entries;
 }
 
-bool lookup_table_contains(Resource_Lookup_Table* lut, u32 hash_key)
+void add_entry(Resource_Entry* entry, Resource_Type type, char const* filename)
 {
-    Resource_Entry* entry = lookup_table_find_by_hash(lut, hash_key);
-    return !!entry;
+    state->free_entries = entry->next;
+    string_copy(entry->filename, filename);
+    entry->type = type;
+    entry->hash = hash_key(type, filename);
+    entry->reference_count = 0;
+    entry->auto_release = true;
+    entry->cached = false;
+    entry->memory_size = entry->data.memory_size ? entry->data.memory_size : entry->data.size;
+    entry->previous = 0;
+    entry->next = 0;
+    insert_entry(entry);
+    state->caches[type].stats.resident_size += entry->memory_size;
+
+    // A new resource may push the type over budget, at the expense of cached ones.
+    trim_cache(type);
 }
 
-bool lookup_table_resize(Resource_Lookup_Table* lut, u32 new_size)
+void reference_entry(Resource_Entry* entry, bool auto_release, Resource_Data* resource)
 {
-    u32 old_size = lut->size;
-    Resource_Entry* old_entries = lut->entries;
-
-    lut->size = new_size;
-    lut->used = 0;
-    lut->entries = memory_system_allocate(lut->size * sizeof(*lut->entries), MEMORY_TAG_RESOURCES);
-    if (!lut->entries)
+    if (entry->cached)
     {
-        LOG_FATAL("lookup_table_resize: Failed to allocate memory for new entries")
-        return false;
+        cache_remove(entry);
     }
 
-    for (u32 i = 0; i < lut->size; ++i)
-    {
-        state->lut->entries[i].is_empty = true;
-        state->lut->entries[i].in_probe = false;
-        state->lut->entries[i].resource.auto_release = true;
-    }
+    entry->reference_count++;
+    entry->auto_release = entry->auto_release && auto_release;
+
+    *resource = entry->data;
+    resource->filename = entry->filename;
+    resource->type = entry->type;
+    resource->auto_release = entry->auto_release;
+}
 
-    for (u32 i = 0; i < old_size; ++i)
+u64 hash_key(Resource_Type type, char const* filename)
+{
+    return hash_bytes(filename, string_length(filename), type);
+}
+
+Resource_Entry* find_entry(Resource_Type type, char const* filename)
+{
+    u64 hash = hash_key(type, filename);
+    for (u32 i = hash & state->slot_mask; state->slots[i] != EMPTY_SLOT; i = (i + 1) & state->slot_mask)
     {
-        if (!old_buckets[i].is_empty)
+        Resource_Entry* entry = &state->entries[state->slots[i]];
+        if (entry->hash == hash && entry->type == type && string_equal(entry->filename, filename))
         {
-            lookup_table_insert(lut, old_entries[i].hash_key, &old_entries[i].resource);
+            return entry;
         }
     }
 
-    memory_system_free(old_entries, old_size * sizeof(*old_entries), MEMORY_TAG_RESOURCES);
+    return 0;
 }
 
-bool lookup_table_insert(Resource_Lookup_Table* lut, u32 hash_key, Resource* resource)
+void insert_entry(Resource_Entry* entry)
 {
-    if (lookup_table_contains(lut, hash_key))
+    u32 i = entry->hash & state->slot_mask;
+    while (state->slots[i] != EMPTY_SLOT)
     {
-        LOG_WARNING("lookup_table_insert: Entry already exists");
-        return false;
+        i = (i + 1) & state->slot_mask;
     }
 
-    Resource_Entry* entry = lookup_table_find_empty(lut, hash_key);
-    if (!entry->in_probe)
+    state->slots[i] = (u32)(entry - state->entries);
+}
+
+void remove_entry(Resource_Entry* entry)
+{
+    u32 index = (u32)(entry - state->entries);
+    u32 i = entry->hash & state->slot_mask;
+    while (state->slots[i] != index)
     {
-        lut->used++;
+        i = (i + 1) & state->slot_mask;
     }
 
-    entry->is_empty = false;
-    entry->in_probe = true;
-    entry->hash_key = hash_key;
-    memory_system_copy(&entry->resource, resource, sizeof(*resource));
-
-    if ((lut->used > lut->size / 2) && !lookup_table_resize(state->lut, state->lut->size * 2))
+    // Later entries of the probe sequence move back into the hole, unless that would put them before their home slot.
+    state->slots[i] = EMPTY_SLOT;
+    for (u32 j = (i + 1) & state->slot_mask; state->slots[j] != EMPTY_SLOT; j = (j + 1) & state->slot_mask)
     {
-        LOG_WARNING("lookup_table_insert: Failed to resize lookup table. Ok?");
+        u32 home = state->entries[state->slots[j]].hash & state->slot_mask;
+        bool movable = i <= j ? (home <= i || home > j) : (home <= i && home > j);
+        if (movable)
+        {
+            state->slots[i] = state->slots[j];
+            state->slots[j] = EMPTY_SLOT;
+            i = j;
+        }
     }
-
-    return true;
 }
 
-u32 lookup_table_probe(u32 hash_key, u32 i, u32 map_size)
+void cache_push(Resource_Entry* entry)
 {
-    return (hash_key + i * ((hash_key << 1) | 1)) & (map_size - 1);
-}
+    Resource_Cache* cache = &state->caches[entry->type];
+    entry->previous = 0;
+    entry->next = cache->head;
+    if (cache->head)
+    {
+        cache->head->previous = entry;
+    }
+    else
+    {
+        cache->tail = entry;
+    }
 
-bool load_material_config(char const* filename, Material_Config* material)
-{
-    return true;
+    cache->head = entry;
+    entry->cached = true;
+    cache->stats.cached_size += entry->memory_size;
+    cache->stats.cached_count++;
 }
 
-i32 find_empty_slot(Resource_Type type)
+void cache_remove(Resource_Entry* entry)
 {
-    switch (type)
+    Resource_Cache* cache = &state->caches[entry->type];
+    if (entry->previous)
     {
-        case RESOURCE_TYPE_MATERIAL:
-            return find_empty_material_slot();
+        entry->previous->next = entry->next;
+    }
+    else
+    {
+        cache->head = entry->next;
+    }
 
-        default:
-            return -1;
+    if (entry->next)
+    {
+        entry->next->previous = entry->previous;
     }
+    else
+    {
+        cache->tail = entry->previous;
+    }
+
+    entry->previous = 0;
+    entry->next = 0;
+    entry->cached = false;
+    cache->stats.cached_size -= entry->memory_size;
+    cache->stats.cached_count--;
 }
 
-i32 find_empty_material_slot()
+void trim_cache(Resource_Type type)
 {
-    for (u32 i = 0; i < state->materials.count; ++i)
+    // Referenced resources can't be evicted, so a type may stay over budget until they are released.
+    Resource_Cache* cache = &state->caches[type];
+    while (cache->stats.resident_size > cache->budget && cache->tail)
     {
-        if (state->materials.empty_slots[i])
-        {
-            state->materials.empty_slots[i] = false;
-            return i;
-        }
+        evict(cache->tail);
     }
+}
 
-    return -1;
+void evict(Resource_Entry* entry)
+{
+    state->caches[entry->type].stats.evictions++;
+    cache_remove(entry);
+    unload_entry(entry);
+}
+
+void unload_entry(Resource_Entry* entry)
+{
+    state->loaders[entry->type]->unload(&entry->data);
+    state->caches[entry->type].stats.resident_size -= entry->memory_size;
+    remove_entry(entry);
+
+    entry->filename[0] = 0;
+    entry->reference_count = 0;
+    entry->next = state->free_entries;
+    state->free_entries = entry;
 }
@@ -1,15 +1,20 @@
 #pragma once
 
 #include "defines.h"
+#include "platform/filesystem.h"
 // #include "resources/resource_types.h"
 #include "third_party/cglm/struct.h"
 
-typedef struct Resource_System_Config
+typedef enum Resource_Type
 {
-    u32 initial_resource_lookup_table_size;
-} Resource_System_Config;
-
-
+    RESOURCE_TYPE_TEXT,
+    RESOURCE_TYPE_BINARY,
+    RESOURCE_TYPE_IMAGE,
+    RESOURCE_TYPE_MATERIAL,
+    RESOURCE_TYPE_SHADER_CONFIG,
+    RESOURCE_TYPE_STATIC_MESH,
+    RESOURCE_TYPE_ENUM_COUNT
+} Resource_Type;
 
 // typedef struct Resource_Reference
 // {
@@ -26,17 +31,70 @@ typedef struct Resource_Data
     char const* name;
     u32 generation;
     bool auto_release;
-    // Resource_Type type;
+    Resource_Type type;
     u32 size;
     void* data;
+    /** @brief Bytes the resource keeps in memory, when it owns more than _size_ bytes at _data_. 0 means _size_. */
+    u64 memory_size;
+    /** @brief The mapping data points into, when a loader hands out file contents in place. Released by the loader's unload. */
+    File_View view;
 } Resource_Data;
 
+#define RESOURCE_NAME_MAX_LENGTH 256
+
+/**
+ * @brief A resource that must be loaded before another one can be used, e.g. the texture of a material.
+ */
+typedef struct Resource_Dependency
+{
+    Resource_Type type;
+    char name[RESOURCE_NAME_MAX_LENGTH];
+} Resource_Dependency;
+
 typedef struct Resource_Loader
 {
     bool (* load)(char const* filename, Resource_Data* resource);
     void (* unload)(Resource_Data* resource);
+
+    /**
+     * @brief Optional, together with load_from_memory. Builds the asset path load reads, so that batches can read
+     * the file ahead and decode it separately. _path_ holds RESOURCE_NAME_MAX_LENGTH characters.
+     */
+    void (* get_path)(char const* filename, char* path);
+    /** @brief Optional. Builds the resource from the contents of the file at get_path. Must be thread-safe. */
+    bool (* load_from_memory)(void const* data, u64 size, Resource_Data* resource);
+    /** @brief Optional. Writes up to _capacity_ dependencies of a loaded resource and returns how many it has. */
+    u32 (* get_dependencies)(Resource_Data const* resource, Resource_Dependency* dependencies, u32 capacity);
 } Resource_Loader;
 
+typedef struct Resource_System_Config
+{
+    /** @brief Maximum number of resources loaded at once, referenced or cached. */
+    u32 max_resource_count;
+    /**
+     * @brief Bytes of loaded data each type may keep resident. Released resources stay cached until their type exceeds
+     * its budget; then the least recently released ones are unloaded. 0 unloads them as soon as they are released.
+     */
+    u64 cache_budgets[RESOURCE_TYPE_ENUM_COUNT];
+    /** @brief Loaders used instead of the built-in ones. Zero entries get the built-in loader of the type. */
+    Resource_Loader const* loaders[RESOURCE_TYPE_ENUM_COUNT];
+} Resource_System_Config;
+
+typedef struct Resource_Cache_Stats
+{
+    /** @brief Acquires served by a resource that was already loaded, referenced or cached. */
+    u64 hits;
+    /** @brief Acquires that had to load the resource. */
+    u64 misses;
+    /** @brief Released resources unloaded to bring their type back under budget. */
+    u64 evictions;
+    /** @brief Bytes of all loaded resources of the type. */
+    u64 resident_size;
+    /** @brief Bytes of released resources that are kept for reuse. */
+    u64 cached_size;
+    u32 cached_count;
+} Resource_Cache_Stats;
+
 typedef struct Material_Config
 {
     char name[MAX_MATERIAL_NAME_LENGTH];
@@ -45,18 +103,39 @@ typedef struct Material_Config
     Material_Type type;
     vec4s diffuse_color;
     Texture_Map diffuse_map;
+    char diffuse_texture_name[TEXTURE_NAME_MAX_LENGTH];
+    bool auto_release;
 } Material_Config;
 
-bool resource_manager_startup();
-void resource_manager_shutdown();
+LIB_API bool resource_manager_startup(u64* required_memory, void* block, Resource_System_Config config);
+LIB_API void resource_manager_shutdown();
 
+/**
+ * @brief Acquires a reference to a resource, loading it only if it isn't loaded or cached already.
+ * @param auto_release Indicates if the resource may be cached and evicted once its last reference is released.
+ * Otherwise it stays loaded until shutdown. A single acquire without it pins the resource.
+ * @param resource Receives a view of the loaded data. It stays valid until the matching release.
+ */
+LIB_API bool resource_manager_acquire(Resource_Type type, char const* filename, bool auto_release, Resource_Data* resource);
 
-bool resource_manager_load(char const* filename, u32 slot, void* resource);
-void resource_manager_unload(Resource_Data* resource);
+/**
+ * @brief Releases a reference taken by resource_manager_acquire. The last release moves an auto-released resource
+ * into the cache of its type.
+ */
+LIB_API void resource_manager_release(Resource_Data* resource);
 
-void* resource_manager_acquire(char const* filepath, bool auto_release);
+/**
+ * @brief Like resource_manager_acquire, but never loads. Returns false if the resource isn't loaded or cached.
+ */
+LIB_API bool resource_manager_acquire_if_loaded(Resource_Type type, char const* filename, bool auto_release, Resource_Data* resource);
 
 /**
- * @brief Returns the slot (index) of the resource in the corresponding array.
+ * @brief Hands a resource built outside the manager with the type's loader (e.g. decoded by a batch) to the manager
+ * and acquires it. If the resource was loaded in the meantime, the given copy is unloaded and the loaded one acquired.
+ * @param resource The loaded data on input; the acquired view on output.
  */
-u32 resource_manager_get_reference(char const* name);
\ No newline at end of file
+LIB_API bool resource_manager_acquire_loaded(Resource_Type type, char const* filename, bool auto_release, Resource_Data* resource);
+
+LIB_API Resource_Loader const* resource_manager_get_loader(Resource_Type type);
+
+LIB_API void resource_manager_get_cache_stats(Resource_Type type, Resource_Cache_Stats* stats);
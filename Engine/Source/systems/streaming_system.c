@@ -0,0 +1,760 @@
+#include "streaming_system.h"
+
+#include "core/logger.h"
+#include "core/string_utils.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "systems/job_system.h"
+#include "systems/memory_system.h"
+
+// Read waves in flight at once. A new one is submitted per update while one is free.
+#define STREAM_WAVE_COUNT 4
+
+typedef enum Request_State
+{
+    REQUEST_STATE_FREE,
+    REQUEST_STATE_QUEUED,
+    REQUEST_STATE_READING,
+    REQUEST_STATE_DECODING,
+    REQUEST_STATE_READY
+} Request_State;
+
+typedef struct Stream_Request
+{
+    Resource_Type type;
+    char name[RESOURCE_NAME_MAX_LENGTH];
+    f32 priority;
+    // Breaks ties between equal priorities in request order.
+    u64 sequence;
+    u32 generation;
+    Request_State state;
+    bool cancelled;
+    u32 heap_index;
+    u32 next_free;
+
+    PFN_stream_on_loaded on_loaded;
+    void* user_data;
+    Resource_Loader const* loader;
+    Resource_Data data;
+
+    // Input of the decode job: either a read buffer or a mapping of a pack entry.
+    char disk_path[256];
+    void* buffer;
+    u64 buffer_size;
+    File_View view;
+
+    // Written by the decode job, or by the update that gave up on the read.
+    bool decode_succeeded;
+    i32 volatile decoded;
+} Stream_Request;
+
+/**
+ * @brief A binary max-heap of request indices, ordered by priority.
+ */
+typedef struct Stream_Heap
+{
+    u32* items;
+    u32 count;
+} Stream_Heap;
+
+typedef struct Stream_Wave
+{
+    File_Read_Batch batch;
+    File_Read_Request* reads;
+    // INVALID_ID once the read was consumed, since the request may be reused while the wave is in flight.
+    u32* request_indices;
+    u32 count;
+    u32 consumed_count;
+    bool in_use;
+} Stream_Wave;
+
+typedef struct Streaming_System_State
+{
+    Streaming_System_Config config;
+    Stream_Request* requests;
+    u32 free_request;
+    u64 next_sequence;
+
+    Stream_Heap queue;
+    Stream_Heap ready;
+    // Requests being read or decoded.
+    u32* loading;
+    u32 loading_count;
+
+    Stream_Wave waves[STREAM_WAVE_COUNT];
+    Job_Counter decode_counter;
+    Streaming_Stats stats;
+} Streaming_System_State;
+
+static Streaming_System_State* state;
+
+static Stream_Request* find_request(Stream_Handle handle);
+static void set_priority(Stream_Request* request, f32 priority);
+static void poll_waves();
+static void collect_decoded();
+static void deliver_ready();
+static void start_queued();
+static void make_ready(u32 index);
+static void fail_request(u32 index);
+static void free_request(u32 index);
+static void release_input(Stream_Request* request);
+static Stream_Wave* acquire_wave();
+static void decode_job(void* params);
+static void load_job(void* params);
+
+static bool heap_before(u32 a, u32 b);
+static void heap_swap(Stream_Heap* heap, u32 a, u32 b);
+static void heap_sift_up(Stream_Heap* heap, u32 position);
+static void heap_sift_down(Stream_Heap* heap, u32 position);
+static void heap_push(Stream_Heap* heap, u32 index);
+static void heap_remove(Stream_Heap* heap, u32 position);
+
+bool streaming_system_startup(u64* required_memory, void* block, Streaming_System_Config config)
+{
+    if (config.max_request_count == 0 || config.max_in_flight_count == 0)
+    {
+        LOG_FATAL("streaming_system_startup: Invalid input parameters");
+        return false;
+    }
+
+    u64 state_required_memory = sizeof(*state);
+    u64 requests_required_memory = config.max_request_count * sizeof(*state->requests);
+    u64 heap_required_memory = config.max_request_count * sizeof(u32);
+    u64 loading_required_memory = config.max_in_flight_count * sizeof(u32);
+    u64 wave_required_memory = config.max_in_flight_count * (sizeof(File_Read_Request) + sizeof(u32));
+    *required_memory = state_required_memory + requests_required_memory + 2 * heap_required_memory + loading_required_memory +
+        STREAM_WAVE_COUNT * wave_required_memory;
+    if (!block)
+    {
+        return true;
+    }
+
+    memory_system_zero(block, *required_memory);
+    state = block;
+    state->config = config;
+
+    u8* memory = (u8*)state + state_required_memory;
+    state->requests = (Stream_Request*)memory;
+    memory += requests_required_memory;
+    state->queue.items = (u32*)memory;
+    memory += heap_required_memory;
+    state->ready.items = (u32*)memory;
+    memory += heap_required_memory;
+    state->loading = (u32*)memory;
+    memory += loading_required_memory;
+    for (u32 i = 0; i < STREAM_WAVE_COUNT; ++i)
+    {
+        state->waves[i].reads = (File_Read_Request*)memory;
+        memory += config.max_in_flight_count * sizeof(File_Read_Request);
+        state->waves[i].request_indices = (u32*)memory;
+        memory += config.max_in_flight_count * sizeof(u32);
+    }
+
+    state->free_request = INVALID_ID;
+    for (u32 i = config.max_request_count; i > 0; --i)
+    {
+        state->requests[i - 1].next_free = state->free_request;
+        state->free_request = i - 1;
+    }
+
+    return true;
+}
+
+void streaming_system_shutdown()
+{
+    if (!state)
+    {
+        return;
+    }
+
+    // Nothing is handed over anymore, but reads and decodes in flight still write into the requests.
+    for (u32 i = 0; i < STREAM_WAVE_COUNT; ++i)
+    {
+        if (state->waves[i].in_use)
+        {
+            filesystem_read_batch_wait(&state->waves[i].batch);
+        }
+    }
+
+    job_system_wait(&state->decode_counter);
+
+    for (u32 i = 0; i < state->config.max_request_count; ++i)
+    {
+        Stream_Request* request = &state->requests[i];
+        release_input(request);
+        if (request->state == REQUEST_STATE_READY)
+        {
+            resource_manager_release(&request->data);
+        }
+        else if (request->state == REQUEST_STATE_DECODING && request->decode_succeeded)
+        {
+            request->loader->unload(&request->data);
+        }
+    }
+
+    LOG_INFO("Streaming: %llu delivered, %llu failed, %llu cancelled, %.3f MiB read, %.3f MiB uploaded",
+        state->stats.delivered_count, state->stats.failed_count, state->stats.cancelled_count,
+        state->stats.io_size / (f64)(MEBIBYTES(1)), state->stats.upload_size / (f64)(MEBIBYTES(1)));
+    state = 0;
+}
+
+Stream_Handle streaming_system_request(Resource_Type type, char const* name, f32 priority, PFN_stream_on_loaded on_loaded,
+    void* user_data)
+{
+    Stream_Handle handle = { INVALID_ID, 0 };
+    if (!state || type >= RESOURCE_TYPE_ENUM_COUNT || !name || !on_loaded)
+    {
+        LOG_ERROR("streaming_system_request: Invalid input parameters");
+        return handle;
+    }
+
+    Resource_Loader const* loader = resource_manager_get_loader(type);
+    if (!loader || string_length(name) >= RESOURCE_NAME_MAX_LENGTH)
+    {
+        LOG_ERROR("streaming_system_request: Can't load '%s'", name);
+        return handle;
+    }
+
+    if (state->free_request == INVALID_ID)
+    {
+        LOG_ERROR("streaming_system_request: Too many requests. Increase max_request_count");
+        return handle;
+    }
+
+    u32 index = state->free_request;
+    Stream_Request* request = &state->requests[index];
+    state->free_request = request->next_free;
+
+    u32 generation = request->generation;
+    memory_system_zero(request, sizeof(*request));
+    request->type = type;
+    string_copy(request->name, name);
+    request->priority = priority;
+    request->sequence = state->next_sequence++;
+    request->generation = generation;
+    request->state = REQUEST_STATE_QUEUED;
+    request->on_loaded = on_loaded;
+    request->user_data = user_data;
+    request->loader = loader;
+    heap_push(&state->queue, index);
+
+    handle.index = index;
+    handle.generation = generation;
+    return handle;
+}
+
+bool streaming_system_promote(Stream_Handle handle, f32 priority)
+{
+    Stream_Request* request = find_request(handle);
+    if (!request)
+    {
+        return false;
+    }
+
+    if (priority > request->priority)
+    {
+        set_priority(request, priority);
+    }
+
+    return true;
+}
+
+bool streaming_system_demote(Stream_Handle handle, f32 priority)
+{
+    Stream_Request* request = find_request(handle);
+    if (!request)
+    {
+        return false;
+    }
+
+    if (priority < request->priority)
+    {
+        set_priority(request, priority);
+    }
+
+    return true;
+}
+
+bool streaming_system_cancel(Stream_Handle handle)
+{
+    Stream_Request* request = find_request(handle);
+    if (!request)
+    {
+        return false;
+    }
+
+    state->stats.cancelled_count++;
+    switch (request->state)
+    {
+        case REQUEST_STATE_QUEUED:
+            heap_remove(&state->queue, request->heap_index);
+            free_request(handle.index);
+            break;
+        case REQUEST_STATE_READY:
+            heap_remove(&state->ready, request->heap_index);
+            resource_manager_release(&request->data);
+            free_request(handle.index);
+            break;
+        default:
+            // Finished by collect_decoded, which frees the request.
+            request->cancelled = true;
+            break;
+    }
+
+    return true;
+}
+
+Stream_State streaming_system_get_state(Stream_Handle handle)
+{
+    Stream_Request* request = find_request(handle);
+    if (!request)
+    {
+        return STREAM_STATE_NONE;
+    }
+
+    switch (request->state)
+    {
+        case REQUEST_STATE_QUEUED:
+            return STREAM_STATE_QUEUED;
+        case REQUEST_STATE_READY:
+            return STREAM_STATE_READY;
+        default:
+            return STREAM_STATE_LOADING;
+    }
+}
+
+void streaming_system_update()
+{
+    if (!state)
+    {
+        return;
+    }
+
+    state->stats.frame_io_size = 0;
+    state->stats.frame_upload_size = 0;
+
+    poll_waves();
+    collect_decoded();
+    deliver_ready();
+    start_queued();
+}
+
+void streaming_system_get_stats(Streaming_Stats* stats)
+{
+    if (!state || !stats)
+    {
+        return;
+    }
+
+    *stats = state->stats;
+    stats->queued_count = state->queue.count;
+    stats->loading_count = state->loading_count;
+    stats->ready_count = state->ready.count;
+}
+
+Stream_Request* find_request(Stream_Handle handle)
+{
+    if (!state || handle.index >= state->config.max_request_count)
+    {
+        return 0;
+    }
+
+    Stream_Request* request = &state->requests[handle.index];
+    if (request->state == REQUEST_STATE_FREE || request->cancelled || request->generation != handle.generation)
+    {
+        return 0;
+    }
+
+    return request;
+}
+
+void set_priority(Stream_Request* request, f32 priority)
+{
+    request->priority = priority;
+    if (request->state == REQUEST_STATE_QUEUED)
+    {
+        heap_sift_up(&state->queue, request->heap_index);
+        heap_sift_down(&state->queue, request->heap_index);
+    }
+    else if (request->state == REQUEST_STATE_READY)
+    {
+        heap_sift_up(&state->ready, request->heap_index);
+        heap_sift_down(&state->ready, request->heap_index);
+    }
+}
+
+void poll_waves()
+{
+    for (u32 i = 0; i < STREAM_WAVE_COUNT; ++i)
+    {
+        Stream_Wave* wave = &state->waves[i];
+        if (!wave->in_use)
+        {
+            continue;
+        }
+
+        filesystem_read_batch_poll(&wave->batch);
+        for (u32 j = 0; j < wave->count; ++j)
+        {
+            File_Read_Request* read = &wave->reads[j];
+            if (wave->request_indices[j] == INVALID_ID || !read->completed)
+            {
+                continue;
+            }
+
+            Stream_Request* request = &state->requests[wave->request_indices[j]];
+            wave->request_indices[j] = INVALID_ID;
+            wave->consumed_count++;
+            request->state = REQUEST_STATE_DECODING;
+
+            bool succeeded = read->succeeded && read->bytes_read == read->size;
+            if (!succeeded || request->cancelled)
+            {
+                if (!succeeded)
+                {
+                    LOG_ERROR("streaming_system_update: Failed to read '%s'", read->path);
+                }
+
+                release_input(request);
+                platform_atomic_store_release(&request->decoded, 1);
+                continue;
+            }
+
+            job_system_submit(decode_job, request, &state->decode_counter);
+        }
+
+        if (wave->consumed_count == wave->count)
+        {
+            // Every read has completed, so waiting only releases the wave.
+            filesystem_read_batch_wait(&wave->batch);
+            wave->in_use = false;
+        }
+    }
+}
+
+void collect_decoded()
+{
+    for (u32 i = 0; i < state->loading_count;)
+    {
+        u32 index = state->loading[i];
+        Stream_Request* request = &state->requests[index];
+        if (request->state != REQUEST_STATE_DECODING || !platform_atomic_load_acquire(&request->decoded))
+        {
+            ++i;
+            continue;
+        }
+
+        state->loading[i] = state->loading[--state->loading_count];
+        release_input(request);
+
+        bool acquired = request->decode_succeeded &&
+            resource_manager_acquire_loaded(request->type, request->name, true, &request->data);
+        if (!request->decode_succeeded && !request->cancelled)
+        {
+            LOG_ERROR("streaming_system_update: Failed to load '%s'", request->name);
+        }
+
+        if (request->cancelled)
+        {
+            // The work is done already, so the resource is kept in the cache in case it's wanted again.
+            if (acquired)
+            {
+                resource_manager_release(&request->data);
+            }
+
+            free_request(index);
+        }
+        else if (acquired)
+        {
+            make_ready(index);
+        }
+        else
+        {
+            fail_request(index);
+        }
+    }
+}
+
+void deliver_ready()
+{
+    u64 upload_size = 0;
+    while (state->ready.count > 0)
+    {
+        u32 index = state->ready.items[0];
+        Stream_Request* request = &state->requests[index];
+        u64 size = request->data.memory_size ? request->data.memory_size : request->data.size;
+        if (state->config.upload_budget && upload_size > 0 && upload_size + size > state->config.upload_budget)
+        {
+            break;
+        }
+
+        heap_remove(&state->ready, 0);
+        upload_size += size;
+
+        // The request is freed first, so that the callback may stream more.
+        Resource_Data data = request->data;
+        PFN_stream_on_loaded on_loaded = request->on_loaded;
+        void* user_data = request->user_data;
+        free_request(index);
+
+        state->stats.delivered_count++;
+        on_loaded(&data, true, user_data);
+    }
+
+    state->stats.frame_upload_size = upload_size;
+    state->stats.upload_size += upload_size;
+}
+
+void start_queued()
+{
+    u64 io_size = 0;
+    Stream_Wave* wave = 0;
+    while (state->queue.count > 0 && state->loading_count < state->config.max_in_flight_count)
+    {
+        u32 index = state->queue.items[0];
+        Stream_Request* request = &state->requests[index];
+
+        // Resources that are loaded or cached already take no I/O.
+        if (resource_manager_acquire_if_loaded(request->type, request->name, true, &request->data))
+        {
+            heap_remove(&state->queue, 0);
+            make_ready(index);
+            continue;
+        }
+
+        // Loaders that can't decode from memory read for themselves on a worker. Their size is unknown up front.
+        if (!request->loader->get_path || !request->loader->load_from_memory)
+        {
+            heap_remove(&state->queue, 0);
+            request->state = REQUEST_STATE_DECODING;
+            state->loading[state->loading_count++] = index;
+            job_system_submit(load_job, request, &state->decode_counter);
+            continue;
+        }
+
+        char path[RESOURCE_NAME_MAX_LENGTH];
+        File_Location location;
+        request->loader->get_path(request->name, path);
+        if (!filesystem_locate(path, &location))
+        {
+            LOG_ERROR("streaming_system_update: Failed to find '%s'", path);
+            heap_remove(&state->queue, 0);
+            fail_request(index);
+            continue;
+        }
+
+        // Later requests wait for the next update rather than jumping ahead, so priorities hold.
+        if (state->config.io_budget && io_size > 0 && io_size + location.size > state->config.io_budget)
+        {
+            break;
+        }
+
+        if (!location.in_pack && !wave && !(wave = acquire_wave()))
+        {
+            break;
+        }
+
+        heap_remove(&state->queue, 0);
+        io_size += location.size;
+        state->loading[state->loading_count++] = index;
+
+        // Pack entries are already mapped, so they go straight to decoding.
+        if (location.in_pack)
+        {
+            request->state = REQUEST_STATE_DECODING;
+            if (!filesystem_map_asset(path, &request->view))
+            {
+                platform_atomic_store_release(&request->decoded, 1);
+                continue;
+            }
+
+            job_system_submit(decode_job, request, &state->decode_counter);
+            continue;
+        }
+
+        string_copy(request->disk_path, location.disk_path);
+        request->buffer_size = location.size;
+        request->buffer = memory_system_allocate(location.size ? location.size : 1, MEMORY_TAG_RESOURCES);
+        request->state = REQUEST_STATE_READING;
+
+        File_Read_Request* read = &wave->reads[wave->count];
+        memory_system_zero(read, sizeof(*read));
+        read->path = request->disk_path;
+        read->offset = 0;
+        read->size = location.size;
+        read->buffer = request->buffer;
+        wave->request_indices[wave->count] = index;
+        wave->count++;
+    }
+
+    if (wave && wave->count > 0 && filesystem_read_batch_submit(wave->reads, wave->count, &wave->batch))
+    {
+        wave->in_use = true;
+    }
+    else if (wave)
+    {
+        // Failed reads are reported by the next collect_decoded.
+        for (u32 i = 0; i < wave->count; ++i)
+        {
+            Stream_Request* request = &state->requests[wave->request_indices[i]];
+            release_input(request);
+            request->state = REQUEST_STATE_DECODING;
+            platform_atomic_store_release(&request->decoded, 1);
+        }
+    }
+
+    state->stats.frame_io_size = io_size;
+    state->stats.io_size += io_size;
+}
+
+void make_ready(u32 index)
+{
+    state->requests[index].state = REQUEST_STATE_READY;
+    heap_push(&state->ready, index);
+}
+
+void fail_request(u32 index)
+{
+    Stream_Request* request = &state->requests[index];
+    PFN_stream_on_loaded on_loaded = request->on_loaded;
+    void* user_data = request->user_data;
+    free_request(index);
+
+    state->stats.failed_count++;
+    Resource_Data data = {};
+    on_loaded(&data, false, user_data);
+}
+
+void free_request(u32 index)
+{
+    Stream_Request* request = &state->requests[index];
+    request->state = REQUEST_STATE_FREE;
+    request->generation++;
+    request->next_free = state->free_request;
+    state->free_request = index;
+}
+
+void release_input(Stream_Request* request)
+{
+    if (request->buffer)
+    {
+        memory_system_free(request->buffer, request->buffer_size ? request->buffer_size : 1, MEMORY_TAG_RESOURCES);
+        request->buffer = 0;
+    }
+
+    if (request->view.data)
+    {
+        filesystem_unmap(&request->view);
+    }
+}
+
+Stream_Wave* acquire_wave()
+{
+    for (u32 i = 0; i < STREAM_WAVE_COUNT; ++i)
+    {
+        Stream_Wave* wave = &state->waves[i];
+        if (!wave->in_use)
+        {
+            wave->count = 0;
+            wave->consumed_count = 0;
+            return wave;
+        }
+    }
+
+    return 0;
+}
+
+void decode_job(void* params)
+{
+    Stream_Request* request = params;
+    void const* data = request->buffer ? request->buffer : request->view.data;
+    u64 size = request->buffer ? request->buffer_size : request->view.size;
+    request->decode_succeeded = request->loader->load_from_memory(data, size, &request->data);
+    platform_atomic_store_release(&request->decoded, 1);
+}
+
+void load_job(void* params)
+{
+    Stream_Request* request = params;
+    request->decode_succeeded = request->loader->load(request->name, &request->data);
+    platform_atomic_store_release(&request->decoded, 1);
+}
+
+bool heap_before(u32 a, u32 b)
+{
+    Stream_Request const* first = &state->requests[a];
+    Stream_Request const* second = &state->requests[b];
+    return first->priority > second->priority || (first->priority == second->priority && first->sequence < second->sequence);
+}
+
+void heap_swap(Stream_Heap* heap, u32 a, u32 b)
+{
+    u32 index = heap->items[a];
+    heap->items[a] = heap->items[b];
+    heap->items[b] = index;
+    state->requests[heap->items[a]].heap_index = a;
+    state->requests[heap->items[b]].heap_index = b;
+}
+
+void heap_sift_up(Stream_Heap* heap, u32 position)
+{
+    while (position > 0)
+    {
+        u32 parent = (position - 1) / 2;
+        if (!heap_before(heap->items[position], heap->items[parent]))
+        {
+            break;
+        }
+
+        heap_swap(heap, position, parent);
+        position = parent;
+    }
+}
+
+void heap_sift_down(Stream_Heap* heap, u32 position)
+{
+    while (true)
+    {
+        u32 first = position;
+        u32 left = position * 2 + 1;
+        u32 right = left + 1;
+        if (left < heap->count && heap_before(heap->items[left], heap->items[first]))
+        {
+            first = left;
+        }
+
+        if (right < heap->count && heap_before(heap->items[right], heap->items[first]))
+        {
+            first = right;
+        }
+
+        if (first == position)
+        {
+            break;
+        }
+
+        heap_swap(heap, position, first);
+        position = first;
+    }
+}
+
+void heap_push(Stream_Heap* heap, u32 index)
+{
+    heap->items[heap->count] = index;
+    state->requests[index].heap_index = heap->count;
+    heap->count++;
+    heap_sift_up(heap, heap->count - 1);
+}
+
+void heap_remove(Stream_Heap* heap, u32 position)
+{
+    heap->count--;
+    if (position == heap->count)
+    {
+        return;
+    }
+
+    heap_swap(heap, position, heap->count);
+    heap_sift_up(heap, position);
+    heap_sift_down(heap, position);
+}
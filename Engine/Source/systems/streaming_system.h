@@ -0,0 +1,104 @@
+#pragma once
+
+#include "defines.h"
+#include "systems/resource_manager.h"
+
+/**
+ * @brief Identifies a streaming request. Stale once the request was delivered, failed or cancelled.
+ */
+typedef struct Stream_Handle
+{
+    u32 index;
+    u32 generation;
+} Stream_Handle;
+
+typedef enum Stream_State
+{
+    /** @brief Unknown handle, or the request was delivered, failed or cancelled. */
+    STREAM_STATE_NONE,
+    /** @brief Waiting in the priority queue for I/O budget. */
+    STREAM_STATE_QUEUED,
+    /** @brief Being read or decoded. */
+    STREAM_STATE_LOADING,
+    /** @brief Loaded, waiting for upload budget. */
+    STREAM_STATE_READY
+} Stream_State;
+
+/**
+ * @brief Called from streaming_system_update once the resource is loaded and its turn in the upload budget has come.
+ * The callback receives the request's reference and releases it with resource_manager_release when it's done.
+ * @param resource Zeroed if the resource failed to load.
+ */
+typedef void (* PFN_stream_on_loaded)(Resource_Data* resource, bool succeeded, void* user_data);
+
+typedef struct Streaming_System_Config
+{
+    /** @brief Maximum number of requests queued, loading or waiting for upload at once. */
+    u32 max_request_count;
+    /** @brief Maximum number of requests being read or decoded at once. */
+    u32 max_in_flight_count;
+    /** @brief Bytes of files to start reading per update. 0 disables the budget. */
+    u64 io_budget;
+    /** @brief Bytes of loaded resources to hand to their callbacks per update. 0 disables the budget. */
+    u64 upload_budget;
+} Streaming_System_Config;
+
+typedef struct Streaming_Stats
+{
+    u32 queued_count;
+    u32 loading_count;
+    u32 ready_count;
+    /** @brief Bytes started reading and handed over by the last update. */
+    u64 frame_io_size;
+    u64 frame_upload_size;
+
+    u64 io_size;
+    u64 upload_size;
+    u64 delivered_count;
+    u64 failed_count;
+    u64 cancelled_count;
+} Streaming_Stats;
+
+LIB_API bool streaming_system_startup(u64* required_memory, void* block, Streaming_System_Config config);
+LIB_API void streaming_system_shutdown();
+
+/**
+ * @brief Queues a resource to be loaded in the background. Higher priorities are loaded and handed over first, e.g.
+ * the screen-space size of what uses the resource, or the negated distance to the camera. Dependencies of the
+ * resource aren't followed; stream them as requests of their own.
+ * @param on_loaded Called exactly once unless the request is cancelled.
+ * @return The handle of the request, or one with index INVALID_ID if the queue is full.
+ */
+LIB_API Stream_Handle streaming_system_request(Resource_Type type, char const* name, f32 priority, PFN_stream_on_loaded on_loaded,
+    void* user_data);
+
+/**
+ * @brief Raises the priority of a request to at least _priority_. It reorders both the I/O and the upload queue;
+ * a request being loaded keeps the new priority for its upload.
+ * @return false if the handle is stale.
+ */
+LIB_API bool streaming_system_promote(Stream_Handle handle, f32 priority);
+
+/**
+ * @brief Lowers the priority of a request to at most _priority_.
+ * @return false if the handle is stale.
+ */
+LIB_API bool streaming_system_demote(Stream_Handle handle, f32 priority);
+
+/**
+ * @brief Drops a request that is no longer wanted; its callback is never called. A resource that is already being
+ * read or decoded is still finished, then released into the resource manager's cache instead of being handed over.
+ * @return false if the handle is stale.
+ */
+LIB_API bool streaming_system_cancel(Stream_Handle handle);
+
+LIB_API Stream_State streaming_system_get_state(Stream_Handle handle);
+
+/**
+ * @brief Advances streaming by one frame: collects finished reads and decodes, hands loaded resources to their
+ * callbacks in priority order within the upload budget and starts the most important queued loads within the I/O
+ * budget. Each budget admits at least one item per update, so that items larger than the budget still progress.
+ */
+LIB_API void streaming_system_update();
+
+LIB_API void streaming_system_get_stats(Streaming_Stats* stats);
@@ -1,11 +1,22 @@
 #include "texture_system.h"
 
+#include "containers/dynamic_array.h"
 #include "containers/hash_table.h"
 #include "core/logger.h"
 #include "core/string_utils.h"
+#include "platform/platform.h"
 #include "renderer/renderer_frontend.h"
+#include "resources/block_compression.h"
+#include "resources/image_kernels.h"
+#include "resources/loaders/image_loader.h"
 #include "systems/memory_system.h"
-#include "systems/resource_system.h"
+#include "systems/resource_manager.h"
+#include "systems/streaming_system.h"
+
+#include <stdlib.h>
+
+/** @brief Textures drawn in this many of the last frames are never evicted, as they would only be uploaded again. */
+#define TEXTURE_RESIDENCY_KEEP_FRAMES 3
 
 typedef struct Texture_Reference
 {
@@ -14,17 +25,148 @@ typedef struct Texture_Reference
     b8 auto_release;
 } Texture_Reference;
 
+/**
+ * @brief An atlas texture and the copy of its pixels that entries are packed into.
+ */
+typedef struct Texture_Atlas
+{
+    char name[TEXTURE_NAME_MAX_LENGTH];
+    /** @brief Id of the atlas texture, or INVALID_ID if the slot is free. */
+    u32 texture_id;
+    Texture_Atlas_Packer packer;
+    /** @brief The RGBA8 mip chain of the atlas, laid out from offset 0. */
+    u8* pixels;
+    u64 pixels_size;
+    u32 mip_count;
+    /** @brief Texture_Atlas_Rect of each entry by name. */
+    Hash_Table* entries;
+    /** @brief Mip_Region of level 0 taken by each entry added since the last flush, padding included. */
+    Dynamic_Array* dirty_regions;
+} Texture_Atlas;
+
+/**
+ * @brief A texture whose levels are uploaded smallest first, from a chain kept in system memory.
+ */
+typedef struct Texture_Stream
+{
+    /** @brief Id of the streamed texture, or INVALID_ID if the slot is free. */
+    u32 texture_id;
+    /** @brief The image load, with index INVALID_ID once it's over. */
+    Stream_Handle handle;
+    /** @brief The chain in the format the texture is sampled in, laid out from offset 0. Null until the image is loaded. */
+    u8* chain;
+    u64 chain_size;
+    u32 width;
+    u32 height;
+    Texture_Format format;
+    u32 mip_count;
+    b8 has_transparency;
+    /** @brief The largest level uploaded, or INVALID_ID before any is. */
+    u32 resident_level;
+    /** @brief The level the texture's image starts at, or INVALID_ID before it has one. Levels from resident_level down are written. */
+    u32 image_level;
+    /** @brief The largest level wanted, which levels are streamed in down to. */
+    u32 target_level;
+    /** @brief The resolution asked for, 0 for every level. */
+    u32 target_size;
+} Texture_Stream;
+
+/**
+ * @brief What the memory budget can do with a texture, and whether it did.
+ */
+typedef struct Texture_Residency
+{
+    /** @brief Set for textures loaded whole from an image, which can be destroyed and loaded again. */
+    b8 reloadable;
+    /** @brief Index of the texture's stream, or INVALID_ID if it isn't streamed. */
+    u32 stream_index;
+    /** @brief Set while the texture is evicted, or downgraded if it's streamed. */
+    b8 evicted;
+    /** @brief Size and generation of an evicted texture, which it gets back, and goes on from, once it's loaded again. */
+    u64 evicted_size;
+    u32 evicted_generation;
+} Texture_Residency;
+
 typedef struct Texture_System_State
 {
     Texture_System_Config config;
     Texture* registered_textures;
     hashtable texture_references;
     Texture default_texture;
+    Texture_Ingest_Stats ingest_stats;
+    /** @brief Set when the renderer samples every block format, otherwise cooked blocks are decoded. */
+    b8 blocks_supported;
+    Texture_Atlas atlases[TEXTURE_SYSTEM_MAX_ATLAS_COUNT];
+    Texture_Stream* streams;
+    /** @brief The stream texture_system_update looks at first, which rotates so that every stream gets its turn. */
+    u32 stream_cursor;
+    /** @brief Residency of each texture, by id. */
+    Texture_Residency* residencies;
+    /** @brief Room for the id of every texture, which eviction candidates are sorted in. */
+    u32* eviction_candidates;
+    Texture_Residency_Stats residency_stats;
+    /** @brief Number of textures evicted or downgraded, which are looked for only while there are any. */
+    u32 evicted_count;
+    /** @brief Counts texture_system_update calls. Textures are stamped with it when drawn. */
+    u64 frame;
 } Texture_System_State;
 
+/**
+ * @brief The staging slice an image is loaded into by image_loader_load_into.
+ */
+typedef struct Staging_Destination
+{
+    Staging_Region region;
+    b8 too_large;
+} Staging_Destination;
+
+/**
+ * @brief The pixels texture_system_acquire_from_pixels creates a texture from.
+ */
+typedef struct Pixel_Source
+{
+    u32 width;
+    u32 height;
+    u8 channel_count;
+    u8 const* pixels;
+} Pixel_Source;
+
+/**
+ * @brief Gives a texture acquired for the first time its contents.
+ * @return TRUE if the texture was created; otherwise FALSE
+ */
+typedef b8 (* PFN_create_texture)(char const* name, Texture* t, void* params);
+
 static Texture_System_State* state;
 
+static Texture* acquire_texture(char const* name, b8 auto_release, PFN_create_texture create, void* params);
+static b8 create_loaded_texture(char const* name, Texture* t, void* params);
+static b8 create_pixel_texture(char const* name, Texture* t, void* params);
+static b8 create_streamed_texture(char const* name, Texture* t, void* params);
 static b8 create_texture(char const* name, Texture* t);
+static void create_texture_from_pixels(char const* name, u32 width, u32 height, u8 channel_count, Texture_Format format, u32 mip_count, u8 const* pixels, b8 has_transparency, Texture* t);
+static void create_texture_from_chain(char const* name, u32 width, u32 height, Texture_Format format, u32 mip_count, u8 const* chain, b8 has_transparency, Texture* t);
+static void create_texture_from_level(char const* name, u32 width, u32 height, u8 const* pixels, b8 has_transparency, Texture* t);
+static void create_texture_from_rgb(char const* name, u32 width, u32 height, u8 const* pixels, Texture* t);
+static void create_texture_from_staging(char const* name, u32 width, u32 height, Texture_Format format, u32 mip_count, b8 has_transparency, Staging_Region* region, Texture* t);
+static Texture_Format get_sampled_format(Texture_Format format, b8 has_transparency);
+static b8 can_convert(char const* name, Image_Resource const* image, Texture_Format format);
+static u32 prepare_texture(char const* name, u32 width, u32 height, u8 channel_count, Texture_Format format, u32 mip_count, b8 has_transparency, Texture* temp_texture, Texture* t);
+static void commit_texture(Texture* temp_texture, u32 current_generation, Texture* t);
+static u8* acquire_staging(u32 width, u32 height, u64 size, void* user_data);
+static void record_ingest(f64 start_time, Texture const* t, b8 direct);
+static Texture_Atlas* find_atlas(char const* name);
+static void flush_atlas(Texture_Atlas* atlas);
+static b8 start_stream(char const* name, f32 priority, Texture* t);
+static void on_stream_loaded(Resource_Data* resource, bool succeeded, void* user_data);
+static Texture_Stream* find_stream(char const* name);
+static void upload_stream(Texture_Stream* stream, u32 level);
+static void end_stream(u32 texture_id);
+static u32 get_stream_target_level(Texture_Stream const* stream);
+static void enforce_budget();
+static u64 restore_textures(u64 upload_budget);
+static int compare_last_used(void const* a, void const* b);
+static void reset_residency(u32 texture_id);
 static void destroy_texture(Texture* t);
 static b8 create_default_textures();
 static void destroy_default_textures();
@@ -40,7 +182,10 @@ b8 texture_system_startup(u64* required_memory, void* block, Texture_System_Conf
     u64 state_struct_required_memory = sizeof(*state);
     u64 textures_reqired_memory = config.max_texture_count * sizeof(*state->registered_textures);
     u64 texture_references_required_memory = config.max_texture_count * sizeof(Texture_Reference);
-    *required_memory = state_struct_required_memory + textures_reqired_memory + texture_references_required_memory;
+    u64 streams_required_memory = config.max_streamed_count * sizeof(Texture_Stream);
+    u64 residencies_required_memory = config.max_texture_count * (sizeof(Texture_Residency) + sizeof(u32));
+    *required_memory = state_struct_required_memory + textures_reqired_memory + texture_references_required_memory + streams_required_memory +
+        residencies_required_memory;
     if (!block)
     {
         return TRUE;
@@ -50,12 +195,48 @@ b8 texture_system_startup(u64* required_memory, void* block, Texture_System_Conf
     state->config = config;
     state->registered_textures = (char*)state + state_struct_required_memory;
 
+    // One device feature covers every block format, so they are either all sampled or all decoded.
+    state->blocks_supported = renderer_frontend_supports_texture_format(TEXTURE_FORMAT_BC1) &&
+        renderer_frontend_supports_texture_format(TEXTURE_FORMAT_BC3) && renderer_frontend_supports_texture_format(TEXTURE_FORMAT_BC7);
+    if (!state->blocks_supported && config.compression != TEXTURE_FORMAT_RGBA8)
+    {
+        LOG_WARNING("texture_system_startup: The renderer can't sample block compressed textures. Textures stay uncompressed");
+        state->config.compression = TEXTURE_FORMAT_RGBA8;
+    }
+
     for (u32 i = 0; i < state->config.max_texture_count; ++i)
     {
         state->registered_textures[i].id = INVALID_ID;
         state->registered_textures[i].generation = INVALID_ID;
+        state->registered_textures[i].size = 0;
+        state->registered_textures[i].last_used_frame = 0;
     }
 
+    for (u32 i = 0; i < TEXTURE_SYSTEM_MAX_ATLAS_COUNT; ++i)
+    {
+        state->atlases[i].texture_id = INVALID_ID;
+    }
+
+    state->streams = (Texture_Stream*)((char*)state->registered_textures + textures_reqired_memory + texture_references_required_memory);
+    for (u32 i = 0; i < config.max_streamed_count; ++i)
+    {
+        state->streams[i].texture_id = INVALID_ID;
+        state->streams[i].chain = 0;
+    }
+    state->stream_cursor = 0;
+
+    state->residencies = (Texture_Residency*)((char*)state->streams + streams_required_memory);
+    state->eviction_candidates = (u32*)(state->residencies + config.max_texture_count);
+    for (u32 i = 0; i < config.max_texture_count; ++i)
+    {
+        state->residencies[i].evicted = FALSE;
+        reset_residency(i);
+    }
+    memory_system_zero(&state->residency_stats, sizeof(state->residency_stats));
+    state->residency_stats.budget = config.memory_budget;
+    state->evicted_count = 0;
+    state->frame = 0;
+
     void* texture_references_block = (char*)state->registered_textures + textures_reqired_memory;
     hashtable_create(sizeof(Texture_Reference), config.max_texture_count, texture_references_block, FALSE, &state->texture_references);
     Texture_Reference invalid_ref;
@@ -72,6 +253,43 @@ void texture_system_shutdown()
 {
     if (state)
     {
+        Texture_Ingest_Stats* stats = &state->ingest_stats;
+        if (stats->texture_count > 0)
+        {
+            LOG_INFO("Texture ingest: %llu textures (%llu loaded into staging memory, %llu block compressed), %.1f MiB in %.1f ms, %.1f MB/s",
+                stats->texture_count, stats->direct_count, stats->compressed_count, stats->size / (1024.0 * 1024.0),
+                stats->seconds * 1000.0, stats->seconds > 0.0 ? stats->size / stats->seconds / 1e6 : 0.0);
+        }
+        if (stats->streamed_count > 0)
+        {
+            LOG_INFO("Texture streaming: %llu textures, %llu level upgrades, %.1f MiB uploaded",
+                stats->streamed_count, stats->stream_upgrade_count, stats->stream_upload_size / (1024.0 * 1024.0));
+        }
+        Texture_Residency_Stats* residency_stats = &state->residency_stats;
+        if (residency_stats->budget > 0)
+        {
+            LOG_INFO("Texture residency: %.1f MiB at peak of a %.1f MiB budget, %llu evictions, %llu downgrades, %llu re-uploads",
+                residency_stats->peak_resident_size / (1024.0 * 1024.0), residency_stats->budget / (1024.0 * 1024.0),
+                residency_stats->eviction_count, residency_stats->downgrade_count, residency_stats->reupload_count);
+        }
+
+        for (u32 i = 0; i < state->config.max_streamed_count; ++i)
+        {
+            end_stream(state->streams[i].texture_id);
+        }
+
+        for (u32 i = 0; i < TEXTURE_SYSTEM_MAX_ATLAS_COUNT; ++i)
+        {
+            Texture_Atlas* atlas = &state->atlases[i];
+            if (atlas->texture_id != INVALID_ID)
+            {
+                memory_system_free(atlas->pixels, atlas->pixels_size, MEMORY_TAG_TEXTURE);
+                hash_table_destroy(atlas->entries);
+                dynamic_array_destroy(atlas->dirty_regions);
+                atlas->texture_id = INVALID_ID;
+            }
+        }
+
         for (u32 i = 0; i < state->config.max_texture_count; ++i)
         {
             Texture* t = &state->registered_textures[i];
@@ -88,53 +306,19 @@ void texture_system_shutdown()
 
 Texture* texture_system_acquire(char const* name, b8 auto_release)
 {
-    Texture_Reference ref;
-    if (state && hashtable_get(&state->texture_references, name, &ref))
-    {
-        if (ref.reference_count == 0)
-        {
-            ref.auto_release = auto_release;
-        }
-        ref.reference_count++;
-
-        if (ref.internal_id == INVALID_ID)
-        {
-            Texture* tex = 0;
-            for (u32 i = 0; i < state->config.max_texture_count; ++i)
-            {
-                if (state->registered_textures[i].id == INVALID_ID)
-                {
-                    tex = &state->registered_textures[i];
-                    tex->id = i;
-                    ref.internal_id = tex->id;
-                    break;
-                }
-            }
-
-            if (!tex || ref.internal_id == INVALID_ID)
-            {
-                LOG_FATAL("texture_system_acquire: Texture system cannot hold anymore textures");
-                return 0;
-            }
-
-            if (!create_texture(name, tex))
-            {
-                return 0;
-            }
-
-            LOG_TRACE("texture_system_acquire: Texture '%s' created. reference_count %llu", name, ref.reference_count);
-        }
-        else
-        {
-            LOG_TRACE("texture_system_acquire: Texture '%s' acquired. reference_count %llu", name, ref.reference_count);
-        }
+    return acquire_texture(name, auto_release, create_loaded_texture, 0);
+}
 
-        hashtable_set(&state->texture_references, name, &ref);
-        return &state->registered_textures[ref.internal_id];
+Texture* texture_system_acquire_from_pixels(char const* name, u32 width, u32 height, u8 channel_count, u8 const* pixels, b8 auto_release)
+{
+    if (!pixels || width == 0 || height == 0 || (channel_count != 3 && channel_count != 4))
+    {
+        LOG_ERROR("texture_system_acquire_from_pixels: Invalid parameters for texture '%s'. Only 3 and 4 channel images are supported", name);
+        return 0;
     }
 
-    LOG_ERROR("texture_system_acquire: Failed to acquire texture '%s'. NULL will be returned", name);
-    return 0;
+    Pixel_Source source = { width, height, channel_count, pixels };
+    return acquire_texture(name, auto_release, create_pixel_texture, &source);
 }
 
 void texture_system_release(char const* name)
@@ -155,6 +339,8 @@ void texture_system_release(char const* name)
         if (ref.reference_count == 0 && ref.auto_release)
         {
             Texture* t = &state->registered_textures[ref.internal_id];
+            end_stream(t->id);
+            reset_residency(t->id);
             destroy_texture(t);
 
             ref.internal_id = INVALID_ID;
@@ -174,71 +360,1068 @@ void texture_system_release(char const* name)
     LOG_ERROR("texture_system_release: Failed to release texture '%s'", name_copy);
 }
 
-Texture* texture_system_get_default_texture()
+Texture* texture_system_acquire_streamed(char const* name, f32 priority, b8 auto_release)
 {
-    if (state) {
-        return &state->default_texture;
+    return acquire_texture(name, auto_release, create_streamed_texture, &priority);
+}
+
+void texture_system_set_stream_resolution(char const* name, u32 resolution)
+{
+    Texture_Stream* stream = find_stream(name);
+    if (!stream)
+    {
+        LOG_WARNING("texture_system_set_stream_resolution: Texture '%s' isn't streamed", name);
+        return;
     }
 
-    LOG_ERROR("texture_system_get_default_texture: Texture system not initialized. NULL will be returned");
-    return 0;
+    // Until the image is loaded only the resolution is kept, and the level is picked once the chain is known. Downgraded
+    // textures get theirs when they are restored.
+    stream->target_size = resolution;
+    if (stream->chain && !state->residencies[stream->texture_id].evicted)
+    {
+        stream->target_level = get_stream_target_level(stream);
+    }
 }
 
-b8 create_texture(char const* name, Texture* t)
+u32 texture_system_drop_mips(char const* name, u32 count)
 {
-    Resource_Data resource;
-    if (!resource_system_load(name, RESOURCE_TYPE_IMAGE, &resource))
+    Texture_Stream* stream = find_stream(name);
+    if (!stream || stream->resident_level == INVALID_ID)
     {
-        LOG_ERROR("create_texture: Failed to load image resource for texture '%s'", name);
-        return FALSE;
+        return 0;
     }
 
-    image_resource_data* resource_data = (image_resource_data*)resource.data;
-    Texture temp_texture;
-    temp_texture.width = resource_data->width;
-    temp_texture.height = resource_data->height;
-    temp_texture.channel_count = resource_data->channel_count;
-    temp_texture.generation = INVALID_ID;
+    u32 level = stream->resident_level + count;
+    level = level < stream->mip_count ? level : stream->mip_count - 1;
+    u32 dropped = level - stream->resident_level;
+    stream->target_level = level > stream->target_level ? level : stream->target_level;
+    if (dropped > 0)
+    {
+        upload_stream(stream, level);
+    }
+
+    return dropped;
+}
+
+void texture_system_update()
+{
+    if (!state)
+    {
+        return;
+    }
+
+    state->frame++;
+
+    // Eviction comes first, so that what it frees goes to the textures that are drawn. Those that were evicted and are
+    // drawn again share the upload budget with streamed levels.
+    u64 budget = state->config.stream_upload_budget;
+    u64 uploaded = 0;
+    if (state->residency_stats.budget > 0)
+    {
+        enforce_budget();
+        uploaded = restore_textures(budget);
+    }
+
+    // Every stream goes up by one level per update until the budget runs out. The budget admits at least one upload,
+    // so that levels larger than it still progress, and the next update starts where this one stopped. Levels that
+    // would take the textures past the memory budget wait until it has room.
+    u64 memory_budget = state->residency_stats.budget;
+    u32 count = state->config.max_streamed_count;
+    for (u32 i = 0; i < count; ++i)
+    {
+        u32 index = (state->stream_cursor + i) % count;
+        Texture_Stream* stream = &state->streams[index];
+        if (stream->texture_id == INVALID_ID || stream->resident_level == INVALID_ID || stream->resident_level <= stream->target_level)
+        {
+            continue;
+        }
+
+        // A level past the top of the texture's image takes a new one, from the largest level wanted, which the levels
+        // below are written into again. Otherwise only the level is written, and the memory taken stays the same.
+        Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+        block_compression_layout(stream->format, stream->width, stream->height, 0, mips);
+        u32 level = stream->resident_level - 1;
+        b8 in_place = level >= stream->image_level;
+        u64 size = in_place ? mips[level].size : stream->chain_size - mips[level].offset;
+        if (budget > 0 && uploaded > 0 && uploaded + size > budget)
+        {
+            state->stream_cursor = index;
+            return;
+        }
+
+        u64 resident_size = state->residency_stats.resident_size - state->registered_textures[stream->texture_id].size;
+        if (!in_place && memory_budget > 0 && resident_size + stream->chain_size - mips[stream->target_level].offset > memory_budget)
+        {
+            continue;
+        }
+
+        upload_stream(stream, level);
+        state->ingest_stats.stream_upgrade_count++;
+        uploaded += size;
+    }
+}
+
+Texture* texture_system_create_atlas(char const* name, u32 width, u32 height, u32 padding)
+{
+    Texture_Reference ref;
+    if (!state || width == 0 || height == 0 || !hashtable_get(&state->texture_references, name, &ref))
+    {
+        LOG_ERROR("texture_system_create_atlas: Failed to create atlas '%s'. NULL will be returned", name);
+        return 0;
+    }
 
-    string_ncopy(temp_texture.name, name, TEXTURE_NAME_MAX_LENGTH);
+    if (ref.internal_id != INVALID_ID)
+    {
+        LOG_ERROR("texture_system_create_atlas: Texture '%s' already exists. NULL will be returned", name);
+        return 0;
+    }
 
-    u32 total_size = temp_texture.width * temp_texture.height * temp_texture.channel_count;
-    b8 has_transparency = FALSE;
-    for (u32 i = 0; i < total_size; i += temp_texture.channel_count)
+    Texture_Atlas* atlas = 0;
+    for (u32 i = 0; i < TEXTURE_SYSTEM_MAX_ATLAS_COUNT; ++i)
     {
-        u8 alpha = resource_data->pixels[i + 3];
-        if (alpha < 255)
+        if (state->atlases[i].texture_id == INVALID_ID)
         {
-            has_transparency = TRUE;
+            atlas = &state->atlases[i];
             break;
         }
     }
-    temp_texture.has_transparency = has_transparency;
 
-    u32 current_generation = t->generation;
-    t->generation = INVALID_ID;
+    Texture* tex = 0;
+    for (u32 i = 0; atlas && i < state->config.max_texture_count; ++i)
+    {
+        if (state->registered_textures[i].id == INVALID_ID)
+        {
+            tex = &state->registered_textures[i];
+            tex->id = i;
+            break;
+        }
+    }
 
-    renderer_frontend_create_texture(resource_data->pixels, &temp_texture);
+    if (!tex)
+    {
+        LOG_FATAL("texture_system_create_atlas: Texture system cannot hold anymore atlases");
+        return 0;
+    }
 
-    Texture old = *t;
-    *t = temp_texture;
-    renderer_frontend_destroy_texture(&old);
+    string_ncopy(atlas->name, name, TEXTURE_NAME_MAX_LENGTH);
+    atlas->texture_id = tex->id;
+    texture_atlas_packer_create(width, height, padding, &atlas->packer);
+    atlas->entries = HASH_TABLE_CREATE(Texture_Atlas_Rect, 64);
+    atlas->dirty_regions = DYNAMIC_ARRAY_CREATE(Mip_Region);
 
-    if (current_generation == INVALID_ID)
+    // Texels of level l are 2^l texels of level 0 wide and sampled bilinearly, so they reach up to 2^(l + 1) - 1
+    // texels past an entry. Only the levels whose reach stays within the padding are kept.
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 full_mip_count = mip_chain_layout(width, height, 0, mips);
+    atlas->mip_count = 1;
+    while (state->config.generate_mips && atlas->mip_count < full_mip_count && (2u << atlas->mip_count) <= padding + 1)
     {
-        t->generation = 0;
+        atlas->mip_count++;
     }
-    else
+    atlas->pixels_size = mip_chain_size(width, height, atlas->mip_count);
+    atlas->pixels = memory_system_allocate(atlas->pixels_size, MEMORY_TAG_TEXTURE);
+    memory_system_zero(atlas->pixels, atlas->pixels_size);
+
+    // Atlases stay RGBA8, as blocks would mix neighbouring entries. The image is created once, and flushes write only
+    // the entries added to it.
+    create_texture_from_pixels(name, width, height, 4, TEXTURE_FORMAT_RGBA8, atlas->mip_count, atlas->pixels, TRUE, tex);
+
+    // The atlas holds a reference of its own, so releasing the materials drawn from it never destroys it.
+    ref.internal_id = tex->id;
+    ref.reference_count = 1;
+    ref.auto_release = FALSE;
+    hashtable_set(&state->texture_references, name, &ref);
+
+    LOG_TRACE("texture_system_create_atlas: Atlas '%s' created, %ux%u with %u texels of padding", name, width, height, padding);
+    return tex;
+}
+
+b8 texture_system_atlas_add(char const* atlas_name, char const* entry_name, u32 width, u32 height, u8 const* pixels)
+{
+    Texture_Atlas* atlas = find_atlas(atlas_name);
+    if (!atlas || !pixels)
     {
-        t->generation = current_generation + 1;
+        LOG_ERROR("texture_system_atlas_add: Failed to add '%s' to atlas '%s'", entry_name, atlas_name);
+        return FALSE;
+    }
+
+    if (hash_table_at(atlas->entries, entry_name))
+    {
+        return TRUE;
+    }
+
+    Texture_Atlas_Rect rect;
+    if (!texture_atlas_packer_insert(&atlas->packer, width, height, &rect))
+    {
+        LOG_WARNING("texture_system_atlas_add: Atlas '%s' has no room for '%s' (%ux%u), %.0f%% of it is taken",
+            atlas_name, entry_name, width, height, texture_atlas_packer_occupancy(&atlas->packer) * 100.0f);
+        return FALSE;
     }
 
-    resource_system_unload(&resource);
+    texture_atlas_blit(atlas->pixels, atlas->packer.width, &rect, atlas->packer.padding, pixels);
+    hash_table_insert(atlas->entries, entry_name, &rect);
+    Mip_Region region = { rect.x - atlas->packer.padding, rect.y - atlas->packer.padding,
+        rect.width + atlas->packer.padding * 2, rect.height + atlas->packer.padding * 2 };
+    dynamic_array_push_back(atlas->dirty_regions, &region);
     return TRUE;
 }
 
+b8 texture_system_atlas_add_image(char const* atlas_name, char const* image_name)
+{
+    Resource_Data resource;
+    if (!resource_manager_acquire(RESOURCE_TYPE_IMAGE, image_name, true, &resource))
+    {
+        LOG_ERROR("texture_system_atlas_add_image: Failed to load image '%s'", image_name);
+        return FALSE;
+    }
+
+    // Level 0 comes first in every image. Blocks are decoded, as the atlas is RGBA8.
+    Image_Resource* image = (Image_Resource*)resource.data;
+    u8 const* pixels = image->pixels;
+    u8* decoded = 0;
+    u64 decoded_size = (u64)image->width * image->height * 4;
+    if (!can_convert(image_name, image, TEXTURE_FORMAT_RGBA8))
+    {
+        resource_manager_release(&resource);
+        return FALSE;
+    }
+
+    if (image->format != TEXTURE_FORMAT_RGBA8)
+    {
+        decoded = memory_system_allocate(decoded_size, MEMORY_TAG_TEXTURE);
+        block_compression_decode(image->pixels, image->width, image->height, 1, image->format, decoded);
+        pixels = decoded;
+    }
+
+    b8 added = texture_system_atlas_add(atlas_name, image_name, image->width, image->height, pixels);
+    if (decoded)
+    {
+        memory_system_free(decoded, decoded_size, MEMORY_TAG_TEXTURE);
+    }
+    resource_manager_release(&resource);
+    return added;
+}
+
+void texture_system_atlas_flush(char const* atlas_name)
+{
+    Texture_Atlas* atlas = find_atlas(atlas_name);
+    if (!atlas)
+    {
+        LOG_ERROR("texture_system_atlas_flush: Atlas '%s' doesn't exist", atlas_name);
+        return;
+    }
+
+    if (atlas->dirty_regions->size > 0)
+    {
+        flush_atlas(atlas);
+    }
+}
+
+Texture* texture_system_acquire_atlas_entry(char const* name, f32* uv_rect)
+{
+    char atlas_name[TEXTURE_NAME_MAX_LENGTH];
+    string_ncopy(atlas_name, name, TEXTURE_NAME_MAX_LENGTH);
+    i32 separator = string_index_of(atlas_name, TEXTURE_ATLAS_ENTRY_SEPARATOR);
+    Texture_Atlas* atlas = 0;
+    Texture_Atlas_Rect* rect = 0;
+    if (separator > 0)
+    {
+        atlas_name[separator] = '\0';
+        atlas = find_atlas(atlas_name);
+        rect = atlas ? hash_table_at(atlas->entries, atlas_name + separator + 1) : 0;
+    }
+
+    if (!rect)
+    {
+        LOG_ERROR("texture_system_acquire_atlas_entry: Failed to find atlas entry '%s'. NULL will be returned", name);
+        return 0;
+    }
+
+    if (atlas->dirty_regions->size > 0)
+    {
+        flush_atlas(atlas);
+    }
+
+    texture_atlas_uv_rect(rect, atlas->packer.width, atlas->packer.height, uv_rect);
+    return texture_system_acquire(atlas_name, FALSE);
+}
+
+void texture_system_mark_used(Texture* t)
+{
+    if (state && t)
+    {
+        t->last_used_frame = state->frame;
+    }
+}
+
+void texture_system_get_ingest_stats(Texture_Ingest_Stats* stats)
+{
+    if (state && stats)
+    {
+        *stats = state->ingest_stats;
+    }
+}
+
+void texture_system_get_residency_stats(Texture_Residency_Stats* stats)
+{
+    if (state && stats)
+    {
+        *stats = state->residency_stats;
+    }
+}
+
+Texture* texture_system_get_default_texture()
+{
+    if (state) {
+        return &state->default_texture;
+    }
+
+    LOG_ERROR("texture_system_get_default_texture: Texture system not initialized. NULL will be returned");
+    return 0;
+}
+
+/**
+ * @brief Takes a reference to the texture, which _create_ makes on first use. Each way of acquiring differs only in that callback.
+ */
+Texture* acquire_texture(char const* name, b8 auto_release, PFN_create_texture create, void* params)
+{
+    Texture_Reference ref;
+    if (state && hashtable_get(&state->texture_references, name, &ref))
+    {
+        if (ref.reference_count == 0)
+        {
+            ref.auto_release = auto_release;
+        }
+        ref.reference_count++;
+
+        if (ref.internal_id == INVALID_ID)
+        {
+            Texture* tex = 0;
+            for (u32 i = 0; i < state->config.max_texture_count; ++i)
+            {
+                if (state->registered_textures[i].id == INVALID_ID)
+                {
+                    tex = &state->registered_textures[i];
+                    tex->id = i;
+                    ref.internal_id = tex->id;
+                    break;
+                }
+            }
+
+            if (!tex || ref.internal_id == INVALID_ID)
+            {
+                LOG_FATAL("acquire_texture: Texture system cannot hold anymore textures");
+                return 0;
+            }
+
+            if (!create(name, tex, params))
+            {
+                return 0;
+            }
+
+            LOG_TRACE("acquire_texture: Texture '%s' created. reference_count %llu", name, ref.reference_count);
+        }
+        else
+        {
+            LOG_TRACE("acquire_texture: Texture '%s' acquired. reference_count %llu", name, ref.reference_count);
+        }
+
+        hashtable_set(&state->texture_references, name, &ref);
+        return &state->registered_textures[ref.internal_id];
+    }
+
+    LOG_ERROR("acquire_texture: Failed to acquire texture '%s'. NULL will be returned", name);
+    return 0;
+}
+
+b8 create_loaded_texture(char const* name, Texture* t, void* params)
+{
+    if (!create_texture(name, t))
+    {
+        return FALSE;
+    }
+
+    state->residencies[t->id].reloadable = TRUE;
+    return TRUE;
+}
+
+b8 create_pixel_texture(char const* name, Texture* t, void* params)
+{
+    Pixel_Source const* source = params;
+    if (source->channel_count == 3)
+    {
+        create_texture_from_rgb(name, source->width, source->height, source->pixels, t);
+    }
+    else
+    {
+        b8 has_transparency = image_kernels_has_transparency(source->pixels, (u64)source->width * source->height);
+        create_texture_from_level(name, source->width, source->height, source->pixels, has_transparency, t);
+    }
+
+    return TRUE;
+}
+
+b8 create_streamed_texture(char const* name, Texture* t, void* params)
+{
+    f32 priority = *(f32 const*)params;
+    if (start_stream(name, priority, t))
+    {
+        return TRUE;
+    }
+
+    return create_loaded_texture(name, t, 0);
+}
+
+b8 create_texture(char const* name, Texture* t)
+{
+    f64 start_time = platform_get_absolute_time();
+
+    // Images that are already loaded, e.g. by a batch or the streaming system, are uploaded from their resource.
+    // Otherwise the image goes straight into the renderer's staging ring, without a copy being kept in between.
+    Resource_Data resource;
+    b8 loaded = resource_manager_acquire_if_loaded(RESOURCE_TYPE_IMAGE, name, true, &resource);
+    if (!loaded && state->config.load_into_staging)
+    {
+        Staging_Destination destination = {};
+        Image_Load_Options options = {};
+        options.generate_mips = state->config.generate_mips;
+        options.mip_filter = state->config.mip_filter;
+        options.compress_to = state->config.compression;
+        options.compression_quality = state->config.compression_quality;
+        options.decode_blocks = !state->blocks_supported;
+        Image_Load_Info info;
+        if (image_loader_load_into(name, &options, acquire_staging, &destination, &info))
+        {
+            create_texture_from_staging(name, info.width, info.height, info.format, info.mip_count, info.has_transparency, &destination.region, t);
+            record_ingest(start_time, t, TRUE);
+            return TRUE;
+        }
+
+        if (!destination.too_large)
+        {
+            LOG_ERROR("create_texture: Failed to load image for texture '%s'", name);
+            return FALSE;
+        }
+    }
+
+    if (!loaded && !resource_manager_acquire(RESOURCE_TYPE_IMAGE, name, true, &resource))
+    {
+        LOG_ERROR("create_texture: Failed to load image resource for texture '%s'", name);
+        return FALSE;
+    }
+
+    Image_Resource* resource_data = (Image_Resource*)resource.data;
+    // Cooked images carry the transparency flag, so only decoded ones are scanned.
+    b8 has_transparency = resource_data->cooked
+        ? resource_data->has_transparency
+        : image_kernels_has_transparency(resource_data->pixels, (u64)resource_data->width * resource_data->height);
+    if (!can_convert(name, resource_data, get_sampled_format(resource_data->format, has_transparency)))
+    {
+        resource_manager_release(&resource);
+        return FALSE;
+    }
+
+    // Cooked chains and blocks are uploaded as they are; single level images get theirs generated.
+    if (resource_data->mip_count > 1 || resource_data->format != TEXTURE_FORMAT_RGBA8)
+    {
+        create_texture_from_chain(name, resource_data->width, resource_data->height, resource_data->format, resource_data->mip_count, resource_data->pixels, has_transparency, t);
+    }
+    else
+    {
+        create_texture_from_level(name, resource_data->width, resource_data->height, resource_data->pixels, has_transparency, t);
+    }
+    record_ingest(start_time, t, FALSE);
+
+    resource_manager_release(&resource);
+    return TRUE;
+}
+
+void create_texture_from_pixels(char const* name, u32 width, u32 height, u8 channel_count, Texture_Format format, u32 mip_count, u8 const* pixels, b8 has_transparency, Texture* t)
+{
+    Texture temp_texture;
+    u32 current_generation = prepare_texture(name, width, height, channel_count, format, mip_count, has_transparency, &temp_texture, t);
+    renderer_frontend_create_texture(pixels, &temp_texture);
+    commit_texture(&temp_texture, current_generation, t);
+}
+
+void create_texture_from_level(char const* name, u32 width, u32 height, u8 const* pixels, b8 has_transparency, Texture* t)
+{
+    u32 mip_count = 1;
+    u64 chain_size = 0;
+    u8* chain = 0;
+    if (state->config.generate_mips)
+    {
+        chain = mip_chain_create(pixels, width, height, state->config.mip_filter, &mip_count, &chain_size);
+    }
+
+    if (!chain)
+    {
+        create_texture_from_chain(name, width, height, TEXTURE_FORMAT_RGBA8, 1, pixels, has_transparency, t);
+        return;
+    }
+
+    create_texture_from_chain(name, width, height, TEXTURE_FORMAT_RGBA8, mip_count, chain, has_transparency, t);
+    mip_chain_destroy(chain, chain_size);
+}
+
+void create_texture_from_chain(char const* name, u32 width, u32 height, Texture_Format format, u32 mip_count, u8 const* chain, b8 has_transparency, Texture* t)
+{
+    // RGBA8 chains are compressed as configured, and blocks the renderer can't sample are decoded. Either is written
+    // straight into the staging ring, or through a temporary buffer if it can't hold the result.
+    Texture_Format texture_format = get_sampled_format(format, has_transparency);
+    if (texture_format == format)
+    {
+        create_texture_from_pixels(name, width, height, 4, format, mip_count, chain, has_transparency, t);
+        return;
+    }
+
+    u64 size = block_compression_chain_size(texture_format, width, height, mip_count);
+    Staging_Region region;
+    b8 staged = renderer_frontend_staging_acquire(size, &region);
+    u8* converted = staged ? region.memory : memory_system_allocate(size, MEMORY_TAG_TEXTURE);
+    if (texture_format == TEXTURE_FORMAT_RGBA8)
+    {
+        block_compression_decode(chain, width, height, mip_count, format, converted);
+    }
+    else
+    {
+        block_compression_encode(chain, width, height, mip_count, texture_format, state->config.compression_quality, converted);
+    }
+
+    if (staged)
+    {
+        create_texture_from_staging(name, width, height, texture_format, mip_count, has_transparency, &region, t);
+        return;
+    }
+
+    create_texture_from_pixels(name, width, height, 4, texture_format, mip_count, converted, has_transparency, t);
+    memory_system_free(converted, size, MEMORY_TAG_TEXTURE);
+}
+
+void create_texture_from_rgb(char const* name, u32 width, u32 height, u8 const* pixels, Texture* t)
+{
+    // Expanded straight into the staging ring, which is only written, or through a temporary buffer if it can't hold
+    // the image. Mips are generated and blocks encoded from the temporary buffer, as the staging ring is slow to read.
+    u64 pixel_count = (u64)width * height;
+    Staging_Region region;
+    b8 compressed = state->config.compression != TEXTURE_FORMAT_RGBA8;
+    if (!state->config.generate_mips && !compressed && renderer_frontend_staging_acquire(pixel_count * 4, &region))
+    {
+        image_kernels_rgb_to_rgba(pixels, region.memory, pixel_count);
+        create_texture_from_staging(name, width, height, TEXTURE_FORMAT_RGBA8, 1, FALSE, &region, t);
+        return;
+    }
+
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 mip_count = state->config.generate_mips ? mip_chain_layout(width, height, 0, mips) : 1;
+    u64 size = mip_chain_size(width, height, mip_count);
+    u8* rgba = memory_system_allocate(size, MEMORY_TAG_TEXTURE);
+    image_kernels_rgb_to_rgba(pixels, rgba, pixel_count);
+    if (mip_count > 1)
+    {
+        mip_chain_generate(rgba, mips, mip_count, state->config.mip_filter);
+    }
+    create_texture_from_chain(name, width, height, TEXTURE_FORMAT_RGBA8, mip_count, rgba, FALSE, t);
+    memory_system_free(rgba, size, MEMORY_TAG_TEXTURE);
+}
+
+void create_texture_from_staging(char const* name, u32 width, u32 height, Texture_Format format, u32 mip_count, b8 has_transparency, Staging_Region* region, Texture* t)
+{
+    Texture temp_texture;
+    u32 current_generation = prepare_texture(name, width, height, 4, format, mip_count, has_transparency, &temp_texture, t);
+    renderer_frontend_create_texture_from_staging(region, &temp_texture);
+    commit_texture(&temp_texture, current_generation, t);
+}
+
+Texture_Format get_sampled_format(Texture_Format format, b8 has_transparency)
+{
+    return format == TEXTURE_FORMAT_RGBA8
+        ? block_compression_choose_format(state->config.compression, has_transparency)
+        : state->blocks_supported ? format : TEXTURE_FORMAT_RGBA8;
+}
+
+/**
+ * @brief Checks that _image_ can be converted to _format_. Blocks are decoded on the CPU, which only knows the BC7 modes
+ * the encoder writes, so BC7 files from other encoders need a renderer that samples them.
+ */
+b8 can_convert(char const* name, Image_Resource const* image, Texture_Format format)
+{
+    if (format != TEXTURE_FORMAT_RGBA8 || image->format == TEXTURE_FORMAT_RGBA8 ||
+        block_compression_can_decode(image->pixels, image->width, image->height, image->mip_count, image->format))
+    {
+        return TRUE;
+    }
+
+    LOG_ERROR("can_convert: '%s' holds BC7 blocks in modes that can't be decoded", name);
+    return FALSE;
+}
+
+u32 prepare_texture(char const* name, u32 width, u32 height, u8 channel_count, Texture_Format format, u32 mip_count, b8 has_transparency, Texture* temp_texture, Texture* t)
+{
+    // The id carries over, so a texture that is created again is still found by whatever cached it.
+    temp_texture->id = t->id;
+    temp_texture->width = width;
+    temp_texture->height = height;
+    temp_texture->channel_count = channel_count;
+    temp_texture->format = format;
+    temp_texture->mip_count = mip_count;
+    temp_texture->size = block_compression_chain_size(format, width, height, mip_count);
+    // New textures count as drawn when they are created, so that they aren't the first to be evicted.
+    temp_texture->last_used_frame = t->last_used_frame > 0 ? t->last_used_frame : state->frame;
+    temp_texture->generation = INVALID_ID;
+
+    string_ncopy(temp_texture->name, name, TEXTURE_NAME_MAX_LENGTH);
+
+    temp_texture->has_transparency = has_transparency;
+
+    u32 current_generation = t->generation;
+    t->generation = INVALID_ID;
+    return current_generation;
+}
+
+void commit_texture(Texture* temp_texture, u32 current_generation, Texture* t)
+{
+    Texture old = *t;
+    *t = *temp_texture;
+    renderer_frontend_destroy_texture(&old);
+
+    Texture_Residency_Stats* stats = &state->residency_stats;
+    stats->resident_size = stats->resident_size - old.size + t->size;
+    stats->peak_resident_size = stats->resident_size > stats->peak_resident_size ? stats->resident_size : stats->peak_resident_size;
+
+    if (current_generation == INVALID_ID)
+    {
+        t->generation = 0;
+    }
+    else
+    {
+        t->generation = current_generation + 1;
+    }
+}
+
+u8* acquire_staging(u32 width, u32 height, u64 size, void* user_data)
+{
+    Staging_Destination* destination = user_data;
+    if (!renderer_frontend_staging_acquire(size, &destination->region))
+    {
+        destination->too_large = TRUE;
+        return 0;
+    }
+
+    return destination->region.memory;
+}
+
+void record_ingest(f64 start_time, Texture const* t, b8 direct)
+{
+    state->ingest_stats.texture_count++;
+    state->ingest_stats.direct_count += direct ? 1 : 0;
+    state->ingest_stats.compressed_count += t->format != TEXTURE_FORMAT_RGBA8 ? 1 : 0;
+    state->ingest_stats.size += block_compression_chain_size(t->format, t->width, t->height, t->mip_count);
+    state->ingest_stats.seconds += platform_get_absolute_time() - start_time;
+}
+
+Texture_Atlas* find_atlas(char const* name)
+{
+    for (u32 i = 0; state && i < TEXTURE_SYSTEM_MAX_ATLAS_COUNT; ++i)
+    {
+        if (state->atlases[i].texture_id != INVALID_ID && string_equal(state->atlases[i].name, name))
+        {
+            return &state->atlases[i];
+        }
+    }
+
+    return 0;
+}
+
+void flush_atlas(Texture_Atlas* atlas)
+{
+    // Only the texels of each level that the new entries reach are filtered and written. All of them are filtered
+    // before any is written, as the levels under overlapping regions read each other's texels.
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    mip_chain_layout(atlas->packer.width, atlas->packer.height, 0, mips);
+    Dynamic_Array* regions = DYNAMIC_ARRAY_CREATE(Texture_Region);
+    for (u32 i = 0; i < atlas->dirty_regions->size; ++i)
+    {
+        Mip_Region levels[COOKED_TEXTURE_MAX_MIPS];
+        levels[0] = DYNAMIC_ARRAY_AT_AS(atlas->dirty_regions, i, Mip_Region);
+        u32 level_count = mip_chain_generate_region(atlas->pixels, mips, atlas->mip_count, MIP_FILTER_BOX, levels);
+        for (u32 level = 0; level < level_count; ++level)
+        {
+            Texture_Region region;
+            region.level = level;
+            region.x = levels[level].x;
+            region.y = levels[level].y;
+            region.width = levels[level].width;
+            region.height = levels[level].height;
+            dynamic_array_push_back(regions, &region);
+        }
+    }
+
+    // The image and its view stay, so materials drawing from the atlas keep their descriptors.
+    Texture* t = &state->registered_textures[atlas->texture_id];
+    renderer_frontend_update_texture(t, (Texture_Region const*)regions->data, regions->size, atlas->pixels);
+    dynamic_array_destroy(regions);
+    dynamic_array_resize(atlas->dirty_regions, 0);
+}
+
+b8 start_stream(char const* name, f32 priority, Texture* t)
+{
+    Texture_Stream* stream = 0;
+    for (u32 i = 0; i < state->config.max_streamed_count; ++i)
+    {
+        if (state->streams[i].texture_id == INVALID_ID)
+        {
+            stream = &state->streams[i];
+            break;
+        }
+    }
+
+    if (!stream)
+    {
+        return FALSE;
+    }
+
+    u64 index = stream - state->streams;
+    stream->handle = streaming_system_request(RESOURCE_TYPE_IMAGE, name, priority, on_stream_loaded, (void*)index);
+    if (stream->handle.index == INVALID_ID)
+    {
+        return FALSE;
+    }
+
+    // The texture is drawn with the default one until its tail is uploaded.
+    string_ncopy(t->name, name, TEXTURE_NAME_MAX_LENGTH);
+    t->generation = INVALID_ID;
+    t->internal = 0;
+    stream->texture_id = t->id;
+    stream->chain = 0;
+    state->residencies[t->id].stream_index = (u32)index;
+    stream->resident_level = INVALID_ID;
+    stream->image_level = INVALID_ID;
+    stream->target_level = 0;
+    stream->target_size = 0;
+    return TRUE;
+}
+
+void on_stream_loaded(Resource_Data* resource, bool succeeded, void* user_data)
+{
+    Texture_Stream* stream = &state->streams[(u64)user_data];
+    stream->handle.index = INVALID_ID;
+    if (!succeeded)
+    {
+        // The texture keeps being drawn with the default one.
+        LOG_ERROR("on_stream_loaded: Failed to load image for texture '%s'", state->registered_textures[stream->texture_id].name);
+        state->residencies[stream->texture_id].stream_index = INVALID_ID;
+        stream->texture_id = INVALID_ID;
+        return;
+    }
+
+    Image_Resource* image = (Image_Resource*)resource->data;
+    b8 has_transparency = image->cooked
+        ? image->has_transparency
+        : image_kernels_has_transparency(image->pixels, (u64)image->width * image->height);
+    if (!can_convert(state->registered_textures[stream->texture_id].name, image, get_sampled_format(image->format, has_transparency)))
+    {
+        resource_manager_release(resource);
+        state->residencies[stream->texture_id].stream_index = INVALID_ID;
+        stream->texture_id = INVALID_ID;
+        return;
+    }
+
+    // Single level images get their chain generated, like those that are loaded whole.
+    u8 const* chain = image->pixels;
+    u32 mip_count = image->mip_count;
+    u8* generated = 0;
+    u64 generated_size = 0;
+    if (mip_count == 1 && image->format == TEXTURE_FORMAT_RGBA8 && state->config.generate_mips)
+    {
+        generated = mip_chain_create(image->pixels, image->width, image->height, state->config.mip_filter, &mip_count, &generated_size);
+        chain = generated ? generated : chain;
+        mip_count = generated ? mip_count : 1;
+    }
+
+    // The chain is converted once, so that every upload copies it as it is.
+    Texture_Format format = get_sampled_format(image->format, has_transparency);
+    stream->chain_size = block_compression_chain_size(format, image->width, image->height, mip_count);
+    stream->chain = memory_system_allocate(stream->chain_size, MEMORY_TAG_TEXTURE);
+    if (format == image->format)
+    {
+        memory_system_copy(stream->chain, chain, stream->chain_size);
+    }
+    else if (format == TEXTURE_FORMAT_RGBA8)
+    {
+        block_compression_decode(chain, image->width, image->height, mip_count, image->format, stream->chain);
+    }
+    else
+    {
+        block_compression_encode(chain, image->width, image->height, mip_count, format, state->config.compression_quality, stream->chain);
+    }
+
+    stream->width = image->width;
+    stream->height = image->height;
+    stream->format = format;
+    stream->mip_count = mip_count;
+    stream->has_transparency = has_transparency;
+    stream->target_level = get_stream_target_level(stream);
+    if (generated)
+    {
+        mip_chain_destroy(generated, generated_size);
+    }
+    resource_manager_release(resource);
+
+    // The tail goes up right away, so the texture is drawn with its own colours from the next frame on.
+    u32 tail_level = mip_chain_level_for_size(stream->width, stream->height, mip_count, state->config.stream_tail_size);
+    upload_stream(stream, tail_level > stream->target_level ? tail_level : stream->target_level);
+    state->ingest_stats.streamed_count++;
+}
+
+Texture_Stream* find_stream(char const* name)
+{
+    Texture_Reference ref;
+    if (!state || !hashtable_get(&state->texture_references, name, &ref) || ref.internal_id == INVALID_ID)
+    {
+        return 0;
+    }
+
+    for (u32 i = 0; i < state->config.max_streamed_count; ++i)
+    {
+        if (state->streams[i].texture_id == ref.internal_id)
+        {
+            return &state->streams[i];
+        }
+    }
+
+    return 0;
+}
+
+void upload_stream(Texture_Stream* stream, u32 level)
+{
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    block_compression_layout(stream->format, stream->width, stream->height, 0, mips);
+    Texture* t = &state->registered_textures[stream->texture_id];
+
+    // Upgrades write only the new levels into the image the texture has. Downgrades, which free memory, and upgrades
+    // past the top of the image create one, from the largest level wanted so that the upgrades after it write into it.
+    b8 in_place = stream->resident_level != INVALID_ID && level < stream->resident_level && level >= stream->image_level;
+    u32 end_level = in_place ? stream->resident_level : stream->mip_count;
+    Texture temp_texture;
+    u32 current_generation = 0;
+    if (!in_place)
+    {
+        b8 downgrade = stream->resident_level != INVALID_ID && level > stream->resident_level;
+        stream->image_level = downgrade || level < stream->target_level ? level : stream->target_level;
+        current_generation = prepare_texture(t->name, mips[stream->image_level].width, mips[stream->image_level].height, 4, stream->format,
+            stream->mip_count - stream->image_level, stream->has_transparency, &temp_texture, t);
+        renderer_frontend_create_texture(0, &temp_texture);
+    }
+    Texture* target = in_place ? t : &temp_texture;
+
+    // The levels from the image's first down are laid out like a chain of their own, starting at its offset.
+    Texture_Region regions[COOKED_TEXTURE_MAX_MIPS];
+    u32 region_count = 0;
+    for (u32 i = level; i < end_level; ++i)
+    {
+        Texture_Region* region = &regions[region_count++];
+        region->level = i - stream->image_level;
+        region->x = 0;
+        region->y = 0;
+        region->width = mips[i].width;
+        region->height = mips[i].height;
+        state->ingest_stats.stream_upload_size += mips[i].size;
+    }
+    renderer_frontend_update_texture(target, regions, region_count, stream->chain + mips[stream->image_level].offset);
+
+    // The view leaves out the levels above, which are not written yet.
+    if (in_place || level > stream->image_level)
+    {
+        renderer_frontend_set_texture_base_level(target, level - stream->image_level);
+    }
+    if (!in_place)
+    {
+        commit_texture(&temp_texture, current_generation, t);
+    }
+    stream->resident_level = level;
+}
+
+void end_stream(u32 texture_id)
+{
+    for (u32 i = 0; texture_id != INVALID_ID && i < state->config.max_streamed_count; ++i)
+    {
+        Texture_Stream* stream = &state->streams[i];
+        if (stream->texture_id != texture_id)
+        {
+            continue;
+        }
+
+        // A load still under way is dropped, and never reaches on_stream_loaded.
+        if (stream->handle.index != INVALID_ID)
+        {
+            streaming_system_cancel(stream->handle);
+        }
+        if (stream->chain)
+        {
+            memory_system_free(stream->chain, stream->chain_size, MEMORY_TAG_TEXTURE);
+            stream->chain = 0;
+        }
+        state->residencies[texture_id].stream_index = INVALID_ID;
+        stream->texture_id = INVALID_ID;
+        return;
+    }
+}
+
+u32 get_stream_target_level(Texture_Stream const* stream)
+{
+    return stream->target_size > 0 ? mip_chain_level_for_size(stream->width, stream->height, stream->mip_count, stream->target_size) : 0;
+}
+
+void enforce_budget()
+{
+    Texture_Residency_Stats* stats = &state->residency_stats;
+    if (stats->resident_size <= stats->budget)
+    {
+        return;
+    }
+
+    // Candidates are the textures that weren't drawn lately and can be brought back: those loaded whole from an image,
+    // and streamed ones with levels above their smallest.
+    u32 candidate_count = 0;
+    for (u32 i = 0; i < state->config.max_texture_count; ++i)
+    {
+        Texture const* t = &state->registered_textures[i];
+        Texture_Residency const* residency = &state->residencies[i];
+        if (t->id == INVALID_ID || t->size == 0 || t->last_used_frame + TEXTURE_RESIDENCY_KEEP_FRAMES > state->frame)
+        {
+            continue;
+        }
+
+        b8 downgradable = residency->stream_index != INVALID_ID &&
+            state->streams[residency->stream_index].resident_level + 1 < state->streams[residency->stream_index].mip_count;
+        if (residency->reloadable || downgradable)
+        {
+            state->eviction_candidates[candidate_count++] = i;
+        }
+    }
+
+    if (candidate_count == 0)
+    {
+        return;
+    }
+
+    // The least recently drawn go first, until the textures fit. Neither downgrades nor evictions wait for the GPU, as
+    // the renderer destroys what they replace once the frames in flight have completed.
+    qsort(state->eviction_candidates, candidate_count, sizeof(*state->eviction_candidates), compare_last_used);
+    for (u32 i = 0; i < candidate_count && stats->resident_size > stats->budget; ++i)
+    {
+        Texture* t = &state->registered_textures[state->eviction_candidates[i]];
+        Texture_Residency* residency = &state->residencies[t->id];
+        if (residency->stream_index != INVALID_ID)
+        {
+            // Streamed textures drop to their tail, or a level further once they are there, so they are still drawn
+            // with their own colours.
+            Texture_Stream* stream = &state->streams[residency->stream_index];
+            u32 tail_level = mip_chain_level_for_size(stream->width, stream->height, stream->mip_count, state->config.stream_tail_size);
+            u32 level = tail_level > stream->resident_level ? tail_level : stream->resident_level + 1;
+            stream->target_level = level;
+            upload_stream(stream, level);
+            stats->downgrade_count++;
+        }
+        else
+        {
+            // The backend clears what it destroys, so it gets a copy and the texture keeps its name and id.
+            Texture victim = *t;
+            renderer_frontend_destroy_texture(&victim);
+            residency->evicted_size = t->size;
+            residency->evicted_generation = t->generation;
+            stats->resident_size -= t->size;
+            t->size = 0;
+            t->internal = 0;
+            t->generation = INVALID_ID;
+            stats->eviction_count++;
+        }
+
+        if (!residency->evicted)
+        {
+            residency->evicted = TRUE;
+            state->evicted_count++;
+        }
+    }
+}
+
+u64 restore_textures(u64 upload_budget)
+{
+    Texture_Residency_Stats* stats = &state->residency_stats;
+    u64 uploaded = 0;
+    for (u32 i = 0; state->evicted_count > 0 && i < state->config.max_texture_count; ++i)
+    {
+        Texture* t = &state->registered_textures[i];
+        Texture_Residency* residency = &state->residencies[i];
+        if (!residency->evicted || t->last_used_frame + TEXTURE_RESIDENCY_KEEP_FRAMES <= state->frame)
+        {
+            continue;
+        }
+
+        if (residency->stream_index != INVALID_ID)
+        {
+            // Its levels come back one per update, like those of any stream.
+            Texture_Stream* stream = &state->streams[residency->stream_index];
+            stream->target_level = get_stream_target_level(stream);
+            stats->reupload_count++;
+        }
+        else
+        {
+            u64 size = residency->evicted_size;
+            if (stats->resident_size + size > stats->budget || (upload_budget > 0 && uploaded > 0 && uploaded + size > upload_budget))
+            {
+                continue;
+            }
+
+            char name[TEXTURE_NAME_MAX_LENGTH];
+            string_ncopy(name, t->name, TEXTURE_NAME_MAX_LENGTH);
+            if (create_texture(name, t))
+            {
+                // The generation goes on from where it was, so that descriptors written before the eviction are updated.
+                t->generation = residency->evicted_generation + 1;
+                uploaded += t->size;
+                stats->reupload_count++;
+            }
+            else
+            {
+                // The texture keeps being drawn with the default one.
+                residency->reloadable = FALSE;
+            }
+        }
+
+        residency->evicted = FALSE;
+        state->evicted_count--;
+    }
+
+    return uploaded;
+}
+
+int compare_last_used(void const* a, void const* b)
+{
+    u64 a_frame = state->registered_textures[*(u32 const*)a].last_used_frame;
+    u64 b_frame = state->registered_textures[*(u32 const*)b].last_used_frame;
+    return a_frame < b_frame ? -1 : a_frame > b_frame;
+}
+
+void reset_residency(u32 texture_id)
+{
+    Texture_Residency* residency = &state->residencies[texture_id];
+    if (residency->evicted)
+    {
+        state->evicted_count--;
+    }
+
+    residency->reloadable = FALSE;
+    residency->stream_index = INVALID_ID;
+    residency->evicted = FALSE;
+    residency->evicted_size = 0;
+    residency->evicted_generation = INVALID_ID;
+}
+
 void destroy_texture(Texture* t)
 {
+    state->residency_stats.resident_size -= t->size;
     renderer_frontend_destroy_texture(t);
 
     memory_zero(t->name, sizeof(char) * TEXTURE_NAME_MAX_LENGTH);
@@ -277,9 +1460,15 @@ b8 create_default_textures()
     state->default_texture.width = dimension;
     state->default_texture.height = dimension;
     state->default_texture.channel_count = 4;
+    state->default_texture.format = TEXTURE_FORMAT_RGBA8;
+    // The checkerboard is one texel per square, which every mip would blur to grey.
+    state->default_texture.mip_count = 1;
     state->default_texture.generation = INVALID_ID;
     state->default_texture.has_transparency = FALSE;
+    state->default_texture.size = block_compression_chain_size(TEXTURE_FORMAT_RGBA8, dimension, dimension, 1);
+    state->default_texture.last_used_frame = 0;
     renderer_frontend_create_texture(pixels, &state->default_texture);
+    state->residency_stats.resident_size += state->default_texture.size;
 
     // Set to invalid id since this is a default texture
     state->default_texture.generation = INVALID_ID;
@@ -1,16 +1,182 @@
 #pragma once
 
+#include "resources/block_compression.h"
+#include "resources/mip_chain.h"
 #include "resources/resources.h"
+#include "resources/texture_atlas.h"
 
 typedef struct Texture_System_Config
 {
     u32 max_texture_count;
+    /** @brief Loads images that aren't already resources straight into the renderer's staging ring. */
+    b8 load_into_staging;
+    /** @brief Generates the mip chain of images that don't carry one, so that every texture is sampled with mips. */
+    b8 generate_mips;
+    Mip_Filter mip_filter;
+    /**
+     * @brief The block format uncompressed images are encoded to when textures are created from them, or RGBA8 to keep
+     * them uncompressed. Ignored if the renderer can't sample block formats.
+     */
+    Texture_Format compression;
+    Block_Compression_Quality compression_quality;
+    /** @brief Maximum number of textures streamed at once, see texture_system_acquire_streamed. */
+    u32 max_streamed_count;
+    /** @brief Longer side of the largest level of a streamed texture that is uploaded as soon as its image is loaded. */
+    u32 stream_tail_size;
+    /** @brief Bytes of streamed levels to upload per texture_system_update. 0 disables the budget. */
+    u64 stream_upload_budget;
+    /**
+     * @brief Bytes the textures may take together. Past it, the least recently drawn ones are evicted, or downgraded
+     * to fewer levels if they are streamed, until they fit again. 0 disables the budget.
+     */
+    u64 memory_budget;
 } Texture_System_Config;
 
+/**
+ * @brief Totals over the textures created from images, each timed from the start of its load to the submission of
+ * its upload.
+ */
+typedef struct Texture_Ingest_Stats
+{
+    u64 texture_count;
+    /** @brief Textures loaded into staging memory without an image resource in between. */
+    u64 direct_count;
+    /** @brief Textures created in a block format, whether cooked that way or encoded on load. */
+    u64 compressed_count;
+    /** @brief Size of the uploaded levels, compressed where the textures are. */
+    u64 size;
+    f64 seconds;
+    /** @brief Textures streamed in, which aren't counted above. */
+    u64 streamed_count;
+    /** @brief Uploads of streamed textures that added levels. */
+    u64 stream_upgrade_count;
+    /** @brief Size of every upload of streamed textures. Upgrades write the new level, new images every level uploaded. */
+    u64 stream_upload_size;
+} Texture_Ingest_Stats;
+
+/**
+ * @brief Memory taken by textures and what the budget did about it.
+ */
+typedef struct Texture_Residency_Stats
+{
+    /** @brief Bytes taken by the levels of every texture, as uploaded. */
+    u64 resident_size;
+    /** @brief The most resident_size has been. */
+    u64 peak_resident_size;
+    u64 budget;
+    /** @brief Textures destroyed to stay within the budget, which are drawn with the default one until used again. */
+    u64 eviction_count;
+    /** @brief Streamed textures whose largest levels were dropped to stay within the budget. */
+    u64 downgrade_count;
+    /** @brief Evicted or downgraded textures that were uploaded again once they were drawn. */
+    u64 reupload_count;
+} Texture_Residency_Stats;
+
 #define DEFAULT_TEXTURE_NAME "default"
 
+/** @brief Maximum number of atlases the texture system holds at once. */
+#define TEXTURE_SYSTEM_MAX_ATLAS_COUNT 8
+/** @brief Separates the atlas name from the entry name in the names of atlas entries, e.g. "ui:health_icon". */
+#define TEXTURE_ATLAS_ENTRY_SEPARATOR ':'
+
 b8 texture_system_startup(u64* required_memory, void* block, Texture_System_Config config);
 void texture_system_shutdown();
-Texture* texture_system_acquire(char const* name, b8 auto_release);
-void texture_system_release(char const* name);
+LIB_API Texture* texture_system_acquire(char const* name, b8 auto_release);
+
+/**
+ * @brief Acquires a texture created from the provided pixels instead of an image file.
+ * If a texture with the same name already exists, a reference to it is returned and _pixels_ is ignored.
+ *
+ * @param name The texture name. Later acquires by this name return the same texture.
+ * @param width The width in pixels.
+ * @param height The height in pixels.
+ * @param channel_count The number of channels per pixel, 3 or 4. RGB pixels are expanded to opaque RGBA.
+ * @param pixels The pixel data of level 0; the other levels are generated if the system is configured to. The texture
+ * system does not take ownership of it.
+ * @param auto_release Indicates if the texture should be destroyed when its reference count reaches 0.
+ * @return A pointer to the acquired texture or NULL if failed.
+ */
+LIB_API Texture* texture_system_acquire_from_pixels(char const* name, u32 width, u32 height, u8 channel_count, u8 const* pixels, b8 auto_release);
+LIB_API void texture_system_release(char const* name);
+
+/**
+ * @brief Acquires a texture whose image is loaded in the background by the streaming system. It is drawn with the
+ * default texture until its image is loaded. Then the levels from the one stream_tail_size texels large down are
+ * uploaded at once, and the larger ones one per texture_system_update, each upload bumping the generation. Its width,
+ * height and mip_count describe the levels that are resident.
+ * The chain stays in system memory, in the format the texture is sampled in, so that levels can be dropped and
+ * uploaded again without reading the image again. If no more textures can be streamed, the texture is loaded whole.
+ *
+ * @param priority The priority of the image load, see streaming_system_request.
+ * @return A pointer to the acquired texture or NULL if failed.
+ */
+LIB_API Texture* texture_system_acquire_streamed(char const* name, f32 priority, b8 auto_release);
+
+/**
+ * @brief Sets how large a streamed texture is drawn: levels are streamed in down to the smallest one whose longer side
+ * is at least _resolution_ texels. 0, the default, streams in every level. Resident levels aren't dropped by it.
+ */
+LIB_API void texture_system_set_stream_resolution(char const* name, u32 resolution);
+
+/**
+ * @brief Drops up to _count_ of the largest resident levels of a streamed texture, to free memory. The smallest level
+ * is always kept. Dropped levels stay out until texture_system_set_stream_resolution asks for them again.
+ * @return The number of levels dropped, 0 for textures that aren't streamed.
+ */
+LIB_API u32 texture_system_drop_mips(char const* name, u32 count);
+
+/**
+ * @brief Starts a new frame. Keeps textures within memory_budget, uploads those evicted that were drawn since, and the
+ * next level of streamed textures, within stream_upload_budget. Called once per frame, after streaming_system_update has
+ * handed over the images loaded.
+ */
+LIB_API void texture_system_update();
+
+/**
+ * @brief Stamps _t_ as drawn in the current frame, which keeps it from being evicted and has it uploaded again if it
+ * was. Called by the renderer whenever it binds a material's textures, including those it draws with the default one.
+ */
+LIB_API void texture_system_mark_used(Texture* t);
+
+/**
+ * @brief Creates an empty RGBA8 texture that images are packed into with texture_system_atlas_add, so that everything
+ * drawn from them shares one texture. The atlas is a texture like any other under _name_ and stays until shutdown.
+ * Atlases are never block compressed, and get only the mips that their padding keeps entries from bleeding into.
+ *
+ * @param padding Texels kept around every entry, filled with the entry's edge texels.
+ * @return A pointer to the atlas texture or NULL if failed.
+ */
+LIB_API Texture* texture_system_create_atlas(char const* name, u32 width, u32 height, u32 padding);
+
+/**
+ * @brief Packs an image into an atlas under _entry_name_. The atlas texture is updated by texture_system_atlas_flush,
+ * so that many entries can be added at the cost of one upload. Entries that exist already are left as they are.
+ *
+ * @param pixels RGBA8 pixels, width x height of them. The texture system does not take ownership of them.
+ * @return true on success, false if the atlas doesn't exist or is too full to take the image.
+ */
+LIB_API b8 texture_system_atlas_add(char const* atlas_name, char const* entry_name, u32 width, u32 height, u8 const* pixels);
+
+/**
+ * @brief Packs the image resource _image_name_ into an atlas under the same name, as texture_system_atlas_add does.
+ */
+LIB_API b8 texture_system_atlas_add_image(char const* atlas_name, char const* image_name);
+
+/**
+ * @brief Writes the entries added since the last flush, and the texels of the smaller levels they reach, into the
+ * atlas texture. The texture keeps its image, id and generation.
+ */
+LIB_API void texture_system_atlas_flush(char const* atlas_name);
+
+/**
+ * @brief Acquires the atlas holding an entry named "<atlas name>:<entry name>", flushing it first if it has entries
+ * that weren't uploaded yet. The reference is released with texture_system_release on the atlas texture's name.
+ *
+ * @param uv_rect Receives the texture coordinates of the entry as u0, v0, u1, v1.
+ * @return A pointer to the atlas texture or NULL if there is no such entry.
+ */
+LIB_API Texture* texture_system_acquire_atlas_entry(char const* name, f32* uv_rect);
 Texture* texture_system_get_default_texture();
+
+LIB_API void texture_system_get_ingest_stats(Texture_Ingest_Stats* stats);
+LIB_API void texture_system_get_residency_stats(Texture_Residency_Stats* stats);
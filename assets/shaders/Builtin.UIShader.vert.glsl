@@ -12,6 +12,8 @@ layout(push_constant) uniform push_constants {
 	
 	// Only guaranteed a total of 128 bytes.
 	mat4 model; // 64 bytes
+	vec4 diffuse_colour; // 16 bytes
+	vec4 uv_rect; // 16 bytes, the part of the diffuse map that is drawn as u0, v0, u1, v1
 } u_push_constants;
 
 layout(location = 0) out int out_mode;
@@ -19,11 +21,14 @@ layout(location = 0) out int out_mode;
 // Data Transfer Object
 layout(location = 1) out struct dto {
 	vec2 tex_coord;
+	vec4 diffuse_colour;
 } out_dto;
 
 void main() {
 	// NOTE: intentionally flip y texture coorinate. This, along with flipped ortho matrix, puts [0, 0] in the top-left 
 	// instead of bottom-left and adjusts texture coordinates to show in the right direction..
-	out_dto.tex_coord = vec2(in_texcoord.x, 1.0 - in_texcoord.y);
+	vec2 tex_coord = vec2(in_texcoord.x, 1.0 - in_texcoord.y);
+	out_dto.tex_coord = mix(u_push_constants.uv_rect.xy, u_push_constants.uv_rect.zw, tex_coord);
+	out_dto.diffuse_colour = u_push_constants.diffuse_colour;
 	gl_Position = global_ubo.projection * global_ubo.view * u_push_constants.model * vec4(in_position, 0.0, 1.0);
 }
\ No newline at end of file
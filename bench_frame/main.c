@@ -0,0 +1,446 @@
+#include <core/application.h>
+#include <core/logger.h>
+#include <core/string_utils.h>
+#include <game_types.h>
+#include <renderer/null/null_backend.h>
+#include <systems/geometry_system.h>
+#include <systems/material_system.h>
+#include <systems/memory_system.h>
+#include <systems/texture_system.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief Headless frame benchmark.
+ * Boots the engine with the null renderer and no window, builds a synthetic scene and renders a fixed number of frames.
+ * Writes a JSON report with phase timings, allocation counts and renderer statistics.
+ *
+ * Usage: bench_frame [--geometries N] [--materials N] [--textures N] [--texture-size N] [--segments N] [--frames N] [--warmup N] [--out path]
+ */
+
+typedef struct Bench_Config
+{
+    u32 geometry_count;
+    u32 material_count;
+    u32 texture_count;
+    u32 texture_size;
+    u32 plane_segments;
+    u32 frame_count;
+    u32 warmup_frame_count;
+    char const* output_path;
+} Bench_Config;
+
+typedef struct Bench_State
+{
+    Bench_Config config;
+
+    Texture** textures;
+    Material** materials;
+    Geometry** geometries;
+    geometry_render_data* render_data;
+
+    f64 scene_build_time;
+    u64 scene_build_allocation_count;
+
+    f64 update_time;
+} Bench_State;
+
+// Read by bench_init, since the game state is allocated by the engine during application_init.
+static Bench_Config bench_config;
+
+static char const* command_names[NULL_COMMAND_TYPE_ENUM_COUNT] = {
+    "begin_frame",
+    "end_frame",
+    "resize",
+    "update_global_state",
+    "update_global_ui_state",
+    "draw_geometry",
+    "create_texture",
+    "destroy_texture",
+    "begin_renderpass",
+    "end_renderpass",
+    "create_material",
+    "destroy_material",
+    "create_geometry",
+    "destroy_geometry"
+};
+
+static f64 get_time();
+static b8 parse_arguments(int argc, char** argv, Bench_Config* config);
+static int compare_f64(void const* lhs, void const* rhs);
+
+static b8 bench_init(game_instance* instance);
+static b8 bench_update(game_instance* instance, f64 delta_time);
+static b8 bench_render(game_instance* instance, f64 delta_time);
+static void bench_resize(game_instance* instance, u32 width, u32 height);
+
+static b8 build_scene(Bench_State* state);
+static void destroy_scene(Bench_State* state);
+
+int main(int argc, char** argv)
+{
+    if (!parse_arguments(argc, argv, &bench_config))
+    {
+        return EXIT_FAILURE;
+    }
+    Bench_Config config = bench_config;
+
+    game_instance instance = {};
+    instance.application_config.name = "bench_frame";
+    instance.application_config.renderer_backend = RENDERER_BACKEND_TYPE_NULL;
+    instance.init = bench_init;
+    instance.on_update = bench_update;
+    instance.on_render = bench_render;
+    instance.on_resize = bench_resize;
+    instance.required_memory = sizeof(Bench_State);
+
+    f64 startup_start = get_time();
+    if (!application_init(&instance))
+    {
+        LOG_FATAL("main: Failed to initialize application");
+        return EXIT_FAILURE;
+    }
+
+    Bench_State* state = instance.internal;
+    f64 scene_build_time = state->scene_build_time;
+    u64 scene_build_allocation_count = state->scene_build_allocation_count;
+    f64 startup_time = get_time() - startup_start - scene_build_time;
+    u64 startup_allocation_count = memory_system_allocation_count() - scene_build_allocation_count;
+
+    // Allocated up front so the frame loop measures only engine allocations.
+    u32 total_frame_count = config.warmup_frame_count + config.frame_count;
+    f64* frame_times = memory_system_allocate(sizeof(f64) * config.frame_count, MEMORY_TAG_GAME);
+
+    render_packet packet;
+    packet.delta_time = 1.0 / 60.0;
+    packet.geometry_count = state->config.geometry_count;
+    packet.render_data = state->render_data;
+    packet.ui_geometry_count = 0;
+    packet.ui_render_data = 0;
+
+    u64 frames_allocation_start = 0;
+    f64 step_time = 0.0;
+    for (u32 i = 0; i < total_frame_count; ++i)
+    {
+        if (i == config.warmup_frame_count)
+        {
+            null_backend_reset_stats();
+            frames_allocation_start = memory_system_allocation_count();
+            state->update_time = 0.0;
+            step_time = 0.0;
+        }
+
+        f64 frame_start = get_time();
+        if (!application_step(&packet))
+        {
+            LOG_FATAL("main: Frame %u failed", i);
+            return EXIT_FAILURE;
+        }
+        f64 frame_time = get_time() - frame_start;
+
+        if (i >= config.warmup_frame_count)
+        {
+            frame_times[i - config.warmup_frame_count] = frame_time;
+            step_time += frame_time;
+        }
+    }
+
+    u64 frames_allocation_count = memory_system_allocation_count() - frames_allocation_start;
+    f64 update_time = state->update_time;
+
+    Null_Backend_Stats stats;
+    null_backend_get_stats(&stats);
+
+    qsort(frame_times, config.frame_count, sizeof(f64), compare_f64);
+    f64 frame_min = config.frame_count ? frame_times[0] : 0.0;
+    f64 frame_max = config.frame_count ? frame_times[config.frame_count - 1] : 0.0;
+    f64 frame_median = config.frame_count ? frame_times[config.frame_count / 2] : 0.0;
+    f64 frame_p99 = config.frame_count ? frame_times[(u32)((config.frame_count - 1) * 0.99)] : 0.0;
+    f64 frame_mean = config.frame_count ? step_time / config.frame_count : 0.0;
+    memory_system_free(frame_times, sizeof(f64) * config.frame_count, MEMORY_TAG_GAME);
+
+    f64 teardown_start = get_time();
+    // Game state lives in engine memory and must not be touched after this.
+    destroy_scene(state);
+    application_shutdown();
+    state = 0;
+    f64 shutdown_time = get_time() - teardown_start;
+
+    FILE* file = fopen(config.output_path, "w");
+    if (!file)
+    {
+        fprintf(stderr, "main: Failed to open '%s' for writing\n", config.output_path);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(file, "{\n");
+    fprintf(file, "  \"config\": { \"geometries\": %u, \"materials\": %u, \"textures\": %u, \"texture_size\": %u, \"plane_segments\": %u, \"frames\": %u, \"warmup_frames\": %u },\n",
+        config.geometry_count, config.material_count, config.texture_count, config.texture_size, config.plane_segments, config.frame_count, config.warmup_frame_count);
+    fprintf(file, "  \"phases_ms\": { \"startup\": %.4f, \"scene_build\": %.4f, \"frames\": %.4f, \"shutdown\": %.4f },\n",
+        startup_time * 1000.0, scene_build_time * 1000.0, step_time * 1000.0, shutdown_time * 1000.0);
+    fprintf(file, "  \"frame_ms\": { \"mean\": %.6f, \"median\": %.6f, \"min\": %.6f, \"p99\": %.6f, \"max\": %.6f, \"update_mean\": %.6f, \"draw_mean\": %.6f },\n",
+        frame_mean * 1000.0, frame_median * 1000.0, frame_min * 1000.0, frame_p99 * 1000.0, frame_max * 1000.0,
+        config.frame_count ? update_time * 1000.0 / config.frame_count : 0.0,
+        config.frame_count ? (step_time - update_time) * 1000.0 / config.frame_count : 0.0);
+    fprintf(file, "  \"allocations\": { \"startup\": %llu, \"scene_build\": %llu, \"frames\": %llu, \"per_frame\": %.3f },\n",
+        startup_allocation_count, scene_build_allocation_count, frames_allocation_count,
+        config.frame_count ? (f64)frames_allocation_count / config.frame_count : 0.0);
+    fprintf(file, "  \"renderer\": {\n");
+    fprintf(file, "    \"frame_count\": %llu,\n", stats.frame_count);
+    fprintf(file, "    \"drawn_index_count\": %llu,\n", stats.drawn_index_count);
+    fprintf(file, "    \"drawn_vertex_count\": %llu,\n", stats.drawn_vertex_count);
+    fprintf(file, "    \"calls\": {");
+    for (u32 i = 0; i < NULL_COMMAND_TYPE_ENUM_COUNT; ++i)
+    {
+        fprintf(file, "%s \"%s\": %llu", i == 0 ? "" : ",", command_names[i], stats.call_counts[i]);
+    }
+    fprintf(file, " }\n");
+    fprintf(file, "  }\n");
+    fprintf(file, "}\n");
+    fclose(file);
+
+    printf("bench_frame: %u frames, median %.4f ms, %.3f allocations/frame. Report written to '%s'\n",
+        config.frame_count, frame_median * 1000.0, config.frame_count ? (f64)frames_allocation_count / config.frame_count : 0.0, config.output_path);
+
+    return 0;
+}
+
+b8 bench_init(game_instance* instance)
+{
+    Bench_State* state = instance->internal;
+    state->config = bench_config;
+
+    u64 allocation_start = memory_system_allocation_count();
+    f64 start = get_time();
+    if (!build_scene(state))
+    {
+        LOG_FATAL("bench_init: Failed to build the scene");
+        return FALSE;
+    }
+    state->scene_build_time = get_time() - start;
+    state->scene_build_allocation_count = memory_system_allocation_count() - allocation_start;
+
+    return TRUE;
+}
+
+b8 bench_update(game_instance* instance, f64 delta_time)
+{
+    Bench_State* state = instance->internal;
+    f64 start = get_time();
+
+    // Moves every object a little so the frame has some per-object CPU work, like a real game update.
+    for (u32 i = 0; i < state->config.geometry_count; ++i)
+    {
+        state->render_data[i].world[3][1] += (f32)delta_time;
+    }
+
+    state->update_time += get_time() - start;
+    return TRUE;
+}
+
+b8 bench_render(game_instance* instance, f64 delta_time)
+{
+    // The scene is submitted through the render packet, so there is nothing to do here.
+    return TRUE;
+}
+
+void bench_resize(game_instance* instance, u32 width, u32 height)
+{
+}
+
+b8 build_scene(Bench_State* state)
+{
+    Bench_Config* config = &state->config;
+
+    state->textures = memory_system_allocate(sizeof(Texture*) * config->texture_count, MEMORY_TAG_GAME);
+    state->materials = memory_system_allocate(sizeof(Material*) * config->material_count, MEMORY_TAG_GAME);
+    state->geometries = memory_system_allocate(sizeof(Geometry*) * config->geometry_count, MEMORY_TAG_GAME);
+    state->render_data = memory_system_allocate(sizeof(geometry_render_data) * config->geometry_count, MEMORY_TAG_GAME);
+
+    u32 pixel_count = config->texture_size * config->texture_size;
+    u8* pixels = memory_system_allocate(pixel_count * 4, MEMORY_TAG_TEXTURE);
+    for (u32 i = 0; i < config->texture_count; ++i)
+    {
+        // Different content per texture so nothing can be deduplicated.
+        for (u32 p = 0; p < pixel_count; ++p)
+        {
+            pixels[p * 4 + 0] = (u8)(p + i);
+            pixels[p * 4 + 1] = (u8)(p >> 8);
+            pixels[p * 4 + 2] = (u8)(i * 31);
+            pixels[p * 4 + 3] = 255;
+        }
+
+        char name[TEXTURE_NAME_MAX_LENGTH];
+        string_format(name, "bench_texture_%u", i);
+        state->textures[i] = texture_system_acquire_from_pixels(name, config->texture_size, config->texture_size, 4, pixels, TRUE);
+        if (!state->textures[i])
+        {
+            LOG_ERROR("build_scene: Failed to create texture '%s'", name);
+            memory_system_free(pixels, pixel_count * 4, MEMORY_TAG_TEXTURE);
+            return FALSE;
+        }
+    }
+    memory_system_free(pixels, pixel_count * 4, MEMORY_TAG_TEXTURE);
+
+    for (u32 i = 0; i < config->material_count; ++i)
+    {
+        Material_Config material_config = {};
+        string_format(material_config.name, "bench_material_%u", i);
+        string_format(material_config.diffuse_texture_name, "bench_texture_%u", i % config->texture_count);
+        material_config.type = MATERIAL_TYPE_WORLD;
+        material_config.diffuse_color = (vec4s){ 1.f, 1.f, 1.f, 1.f };
+        material_config.auto_release = TRUE;
+
+        state->materials[i] = material_system_acquire_from_config(material_config);
+        if (!state->materials[i])
+        {
+            LOG_ERROR("build_scene: Failed to create material '%s'", material_config.name);
+            return FALSE;
+        }
+    }
+
+    for (u32 i = 0; i < config->geometry_count; ++i)
+    {
+        char name[GEOMETRY_MAX_NAME_LENGTH];
+        char material_name[MAX_MATERIAL_NAME_LENGTH];
+        string_format(name, "bench_geometry_%u", i);
+        string_format(material_name, "bench_material_%u", i % config->material_count);
+
+        Geometry_Config geometry_config = geometry_system_generate_plane_config(4.f, 4.f, config->plane_segments, config->plane_segments, 1.f, 1.f, name, material_name);
+        state->geometries[i] = geometry_system_acquire_from_config(geometry_config, TRUE);
+        memory_system_free(geometry_config.vertices, sizeof(vertex_3d) * geometry_config.vertex_count, MEMORY_TAG_ARRAY);
+        memory_system_free(geometry_config.indices, sizeof(u32) * geometry_config.index_count, MEMORY_TAG_ARRAY);
+        if (!state->geometries[i])
+        {
+            LOG_ERROR("build_scene: Failed to create geometry '%s'", name);
+            return FALSE;
+        }
+
+        geometry_render_data* data = &state->render_data[i];
+        data->geometry = state->geometries[i];
+        glm_mat4_identity(data->world);
+        data->world[3][0] = (f32)(i % 64) * 5.f;
+        data->world[3][2] = (f32)(i / 64) * 5.f;
+    }
+
+    return TRUE;
+}
+
+void destroy_scene(Bench_State* state)
+{
+    Bench_Config* config = &state->config;
+
+    for (u32 i = 0; i < config->geometry_count; ++i)
+    {
+        geometry_system_release(state->geometries[i]);
+    }
+
+    for (u32 i = 0; i < config->material_count; ++i)
+    {
+        material_system_release(state->materials[i]->name);
+    }
+
+    for (u32 i = 0; i < config->texture_count; ++i)
+    {
+        texture_system_release(state->textures[i]->name);
+    }
+
+    memory_system_free(state->render_data, sizeof(geometry_render_data) * config->geometry_count, MEMORY_TAG_GAME);
+    memory_system_free(state->geometries, sizeof(Geometry*) * config->geometry_count, MEMORY_TAG_GAME);
+    memory_system_free(state->materials, sizeof(Material*) * config->material_count, MEMORY_TAG_GAME);
+    memory_system_free(state->textures, sizeof(Texture*) * config->texture_count, MEMORY_TAG_GAME);
+}
+
+f64 get_time()
+{
+    // Timed with the C runtime so measurements do not go through the engine being measured.
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (f64)now.tv_sec + (f64)now.tv_nsec * 1e-9;
+}
+
+b8 parse_arguments(int argc, char** argv, Bench_Config* config)
+{
+    config->geometry_count = 1000;
+    config->material_count = 100;
+    config->texture_count = 32;
+    config->texture_size = 256;
+    config->plane_segments = 4;
+    config->frame_count = 1000;
+    config->warmup_frame_count = 10;
+    config->output_path = "bench_frame.json";
+
+    for (int i = 1; i < argc; ++i)
+    {
+        char const* arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            fprintf(stderr, "parse_arguments: Missing value for '%s'\n", arg);
+            return FALSE;
+        }
+
+        char const* value = argv[++i];
+        if (strcmp(arg, "--geometries") == 0)
+        {
+            config->geometry_count = (u32)strtoul(value, 0, 10);
+        }
+        else if (strcmp(arg, "--materials") == 0)
+        {
+            config->material_count = (u32)strtoul(value, 0, 10);
+        }
+        else if (strcmp(arg, "--textures") == 0)
+        {
+            config->texture_count = (u32)strtoul(value, 0, 10);
+        }
+        else if (strcmp(arg, "--texture-size") == 0)
+        {
+            config->texture_size = (u32)strtoul(value, 0, 10);
+        }
+        else if (strcmp(arg, "--segments") == 0)
+        {
+            config->plane_segments = (u32)strtoul(value, 0, 10);
+        }
+        else if (strcmp(arg, "--frames") == 0)
+        {
+            config->frame_count = (u32)strtoul(value, 0, 10);
+        }
+        else if (strcmp(arg, "--warmup") == 0)
+        {
+            config->warmup_frame_count = (u32)strtoul(value, 0, 10);
+        }
+        else if (strcmp(arg, "--out") == 0)
+        {
+            config->output_path = value;
+        }
+        else
+        {
+            fprintf(stderr, "parse_arguments: Unknown argument '%s'\n", arg);
+            return FALSE;
+        }
+    }
+
+    if (config->geometry_count == 0 || config->material_count == 0 || config->texture_count == 0 || config->texture_size == 0 || config->plane_segments == 0)
+    {
+        fprintf(stderr, "parse_arguments: Scene sizes must be non-zero\n");
+        return FALSE;
+    }
+
+    // The engine reserves a few slots for default and test resources.
+    if (config->geometry_count > NULL_MAX_GEOMETRY_COUNT - 64 || config->material_count > NULL_MAX_MATERIAL_COUNT - 64)
+    {
+        fprintf(stderr, "parse_arguments: At most %u geometries and %u materials are supported\n", NULL_MAX_GEOMETRY_COUNT - 64, NULL_MAX_MATERIAL_COUNT - 64);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+int compare_f64(void const* lhs, void const* rhs)
+{
+    f64 a = *(f64 const*)lhs;
+    f64 b = *(f64 const*)rhs;
+    return (a > b) - (a < b);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <defines.h>
+#include <resources/block_compression.h>
+#include <resources/cooked_format.h>
+
+/**
+ * @brief The cooked form of one asset, allocated with malloc. Its Cooked_Header is complete except for source_hash,
+ * which the driver fills in before writing.
+ */
+typedef struct Cook_Output
+{
+    u8* data;
+    u64 size;
+} Cook_Output;
+
+/**
+ * @brief Totals over the textures block compressed so far, for the summary printed after a cook.
+ */
+typedef struct Cook_Texture_Stats
+{
+    u32 texture_count;
+    u64 pixel_count;
+    f64 encode_seconds;
+    /** @brief Sum of the PSNR of every base level against its source, in dB. */
+    f64 psnr_sum;
+} Cook_Texture_Stats;
+
+/**
+ * @brief Sets the block format textures are cooked to, RGBA8 to leave them uncompressed, and how hard the encoders
+ * search. Textures with transparency requested as BC1 are cooked to BC3.
+ */
+void cook_texture_configure(Texture_Format format, Block_Compression_Quality quality);
+void cook_texture_get_stats(Cook_Texture_Stats* stats);
+
+b8 cook_texture(char const* path, u8 const* source, u64 source_size, Cook_Output* output);
+b8 cook_material(char const* path, u8 const* source, u64 source_size, Cook_Output* output);
+b8 cook_shader_config(char const* path, u8 const* source, u64 source_size, Cook_Output* output);
+b8 cook_spirv(char const* path, u8 const* source, u64 source_size, Cook_Output* output);
+
+/**
+ * @brief Allocates a zeroed output of _size_ bytes and fills in the header fields common to every type.
+ */
+u8* cook_output_allocate(Cook_Output* output, Cooked_Type type, u64 size, u64 payload_offset, u64 payload_size);
+
+u64 cook_align_up(u64 value, u64 alignment);
@@ -0,0 +1,34 @@
+#include "cook.h"
+
+#include <resources/loaders/material_loader.h>
+#include <resources/loaders/shader_config_loader.h>
+
+#include <stdio.h>
+
+// Configs are parsed by the same code the loaders fall back to, so cooked and source assets load identically.
+
+b8 cook_material(char const* path, u8 const* source, u64 source_size, Cook_Output* output)
+{
+    u8* data = cook_output_allocate(output, COOKED_TYPE_MATERIAL, COOKED_PAYLOAD_ALIGNMENT + sizeof(Material_Config_Resource),
+        COOKED_PAYLOAD_ALIGNMENT, sizeof(Material_Config_Resource));
+    if (!material_loader_parse(source, source_size, (Material_Config_Resource*)(data + COOKED_PAYLOAD_ALIGNMENT)))
+    {
+        fprintf(stderr, "cook_material: '%s' is not a valid material\n", path);
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+b8 cook_shader_config(char const* path, u8 const* source, u64 source_size, Cook_Output* output)
+{
+    u8* data = cook_output_allocate(output, COOKED_TYPE_SHADER_CONFIG, COOKED_PAYLOAD_ALIGNMENT + sizeof(Shader_Config_Resource),
+        COOKED_PAYLOAD_ALIGNMENT, sizeof(Shader_Config_Resource));
+    if (!shader_config_loader_parse(source, source_size, (Shader_Config_Resource*)(data + COOKED_PAYLOAD_ALIGNMENT)))
+    {
+        fprintf(stderr, "cook_shader_config: '%s' is not a valid shader config\n", path);
+        return FALSE;
+    }
+
+    return TRUE;
+}
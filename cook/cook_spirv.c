@@ -0,0 +1,25 @@
+#include "cook.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define SPIRV_MAGIC 0x07230203
+
+b8 cook_spirv(char const* path, u8 const* source, u64 source_size, Cook_Output* output)
+{
+    u32 magic = 0;
+    if (source_size >= sizeof(magic))
+    {
+        memcpy(&magic, source, sizeof(magic));
+    }
+
+    if (source_size % 4 != 0 || magic != SPIRV_MAGIC)
+    {
+        fprintf(stderr, "cook_spirv: '%s' is not a SPIR-V module\n", path);
+        return FALSE;
+    }
+
+    u8* data = cook_output_allocate(output, COOKED_TYPE_SPIRV, COOKED_PAYLOAD_ALIGNMENT + source_size, COOKED_PAYLOAD_ALIGNMENT, source_size);
+    memcpy(data + COOKED_PAYLOAD_ALIGNMENT, source, source_size);
+    return TRUE;
+}
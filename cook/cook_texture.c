@@ -0,0 +1,94 @@
+#include "cook.h"
+
+#include <core/clock.h>
+#include <resources/image_kernels.h>
+#include <resources/loaders/image_loader.h>
+#include <resources/mip_chain.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static Texture_Format cook_format = TEXTURE_FORMAT_BC7;
+static Block_Compression_Quality cook_quality = BLOCK_COMPRESSION_QUALITY_NORMAL;
+static Cook_Texture_Stats cook_stats;
+
+void cook_texture_configure(Texture_Format format, Block_Compression_Quality quality)
+{
+    cook_format = format;
+    cook_quality = quality;
+}
+
+void cook_texture_get_stats(Cook_Texture_Stats* stats)
+{
+    *stats = cook_stats;
+}
+
+b8 cook_texture(char const* path, u8 const* source, u64 source_size, Cook_Output* output)
+{
+    u32 width;
+    u32 height;
+    u8* pixels = image_loader_decode(source, source_size, &width, &height);
+    if (!pixels)
+    {
+        fprintf(stderr, "cook_texture: Failed to decode '%s'\n", path);
+        return FALSE;
+    }
+
+    // The RGBA8 chain is built first, since the block formats are encoded from every level of it.
+    Cooked_Mip rgba_mips[COOKED_TEXTURE_MAX_MIPS] = {};
+    u32 mip_count = mip_chain_layout(width, height, 0, rgba_mips);
+    u64 rgba_size = mip_chain_size(width, height, mip_count);
+    u8* chain = malloc(rgba_size);
+    memcpy(chain, pixels, rgba_mips[0].size);
+    image_loader_free_pixels(pixels);
+
+    b8 has_transparency = image_kernels_has_transparency(chain, (u64)width * height);
+
+    // Cooking runs offline, so it affords the sharper filter.
+    mip_chain_generate(chain, rgba_mips, mip_count, MIP_FILTER_KAISER);
+
+    Texture_Format format = block_compression_choose_format(cook_format, has_transparency);
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS] = {};
+    u64 payload_offset = cook_align_up(sizeof(Cooked_Texture), COOKED_PAYLOAD_ALIGNMENT);
+    block_compression_layout(format, width, height, payload_offset, mips);
+
+    u64 payload_size = mips[mip_count - 1].offset + mips[mip_count - 1].size - payload_offset;
+    u8* data = cook_output_allocate(output, COOKED_TYPE_TEXTURE, payload_offset + payload_size, payload_offset, payload_size);
+    Cooked_Texture* texture = (Cooked_Texture*)data;
+    texture->width = width;
+    texture->height = height;
+    texture->format = format;
+    texture->channel_count = 4;
+    texture->mip_count = mip_count;
+    memcpy(texture->mips, mips, sizeof(mips));
+    if (has_transparency)
+    {
+        texture->flags |= COOKED_TEXTURE_FLAG_TRANSPARENT;
+    }
+
+    if (format == TEXTURE_FORMAT_RGBA8)
+    {
+        memcpy(data + payload_offset, chain, rgba_size);
+        free(chain);
+        return TRUE;
+    }
+
+    clock encode_time;
+    clock_start(&encode_time);
+    block_compression_encode(chain, width, height, mip_count, format, cook_quality, data + payload_offset);
+    clock_update(&encode_time);
+
+    // Decoding the base level back shows what the encoder lost.
+    u8* decoded = malloc(rgba_mips[0].size);
+    block_compression_decode(data + payload_offset, width, height, 1, format, decoded);
+    f64 psnr = block_compression_psnr(chain, decoded, (u64)width * height);
+    free(decoded);
+    free(chain);
+
+    cook_stats.texture_count++;
+    cook_stats.pixel_count += rgba_size / 4;
+    cook_stats.encode_seconds += encode_time.elapsed;
+    cook_stats.psnr_sum += psnr;
+    return TRUE;
+}
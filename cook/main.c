@@ -0,0 +1,434 @@
+#include "cook.h"
+
+#include <core/hash.h>
+#include <platform/platform.h>
+#include <systems/job_system.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief Converts source assets into the cooked formats of resources/cooked_format.h, which the loaders prefer at runtime.
+ * - textures/<name>.png: a full mip chain and a transparency flag, block compressed to --texture-format (bc7 by
+ *   default; bc1 falls back to bc3 for textures with transparency) at --quality (normal by default)
+ * - materials/<name>.json: a fixed-layout Cooked_Material
+ * - shaders/<name>_config.json: a fixed-layout Cooked_Shader_Config
+ * - <any>.spv: the SPIR-V words behind an aligned header
+ * Outputs go to <assets directory>/cooked/<source path>.ck. A source is only recooked when its content hash or
+ * COOKED_VERSION changed since the last cook, unless --force is given.
+ *
+ * Textures are encoded on the job system, one worker per extra processor.
+ *
+ * Usage: cook [--force] [--texture-format rgba8|bc1|bc3|bc7] [--quality fast|normal|high] <assets directory>
+ */
+
+typedef b8 (* PFN_cook)(char const* path, u8 const* source, u64 source_size, Cook_Output* output);
+
+typedef struct Cook_Stats
+{
+    u32 cooked;
+    u32 up_to_date;
+    u32 failed;
+} Cook_Stats;
+
+static b8 parse_texture_format(char const* name, Texture_Format* format);
+static b8 parse_quality(char const* name, Block_Compression_Quality* quality);
+static b8 walk(char const* root, char const* relative_path, b8 force, Cook_Stats* stats);
+static void cook_file(char const* root, char const* relative_path, b8 force, Cook_Stats* stats);
+static PFN_cook find_cooker(char const* relative_path, Cooked_Type* type);
+static b8 ends_with(char const* str, char const* suffix);
+static b8 starts_with(char const* str, char const* prefix);
+static u8* read_file(char const* path, u64* size);
+static b8 is_up_to_date(char const* output_path, Cooked_Type type, u64 source_hash);
+static void make_parent_directories(char const* path);
+
+int main(int argc, char** argv)
+{
+    b8 force = FALSE;
+    Texture_Format texture_format = TEXTURE_FORMAT_BC7;
+    Block_Compression_Quality quality = BLOCK_COMPRESSION_QUALITY_NORMAL;
+    b8 valid = argc >= 2;
+    for (i32 i = 1; valid && i < argc - 1; ++i)
+    {
+        if (strcmp(argv[i], "--force") == 0)
+        {
+            force = TRUE;
+        }
+        else if (strcmp(argv[i], "--texture-format") == 0 && i + 1 < argc - 1)
+        {
+            valid = parse_texture_format(argv[++i], &texture_format);
+        }
+        else if (strcmp(argv[i], "--quality") == 0 && i + 1 < argc - 1)
+        {
+            valid = parse_quality(argv[++i], &quality);
+        }
+        else
+        {
+            valid = FALSE;
+        }
+    }
+
+    if (!valid)
+    {
+        fprintf(stderr, "Usage: cook [--force] [--texture-format rgba8|bc1|bc3|bc7] [--quality fast|normal|high] <assets directory>\n");
+        return 1;
+    }
+
+    cook_texture_configure(texture_format, quality);
+
+    u32 processor_count = platform_get_processor_count();
+    Job_System_Config job_system_config;
+    job_system_config.worker_count = processor_count > 1 ? processor_count - 1 : 0;
+    job_system_config.max_job_count = 256;
+    u64 job_system_memory;
+    job_system_startup(&job_system_memory, 0, job_system_config);
+    void* job_system_block = malloc(job_system_memory);
+    if (!job_system_startup(&job_system_memory, job_system_block, job_system_config))
+    {
+        fprintf(stderr, "cook: Failed to start the job system\n");
+        free(job_system_block);
+        return 1;
+    }
+
+    Cook_Stats stats = {};
+    b8 result = walk(argv[argc - 1], "", force, &stats);
+    job_system_shutdown();
+    free(job_system_block);
+    if (!result)
+    {
+        return 1;
+    }
+
+    printf("cook: %u cooked, %u up to date, %u failed\n", stats.cooked, stats.up_to_date, stats.failed);
+
+    Cook_Texture_Stats texture_stats;
+    cook_texture_get_stats(&texture_stats);
+    if (texture_stats.texture_count && texture_stats.encode_seconds > 0.0)
+    {
+        printf("cook: %u textures block compressed at %.2f MPix/s, mean PSNR %.2f dB\n", texture_stats.texture_count,
+            texture_stats.pixel_count / texture_stats.encode_seconds / 1000000.0, texture_stats.psnr_sum / texture_stats.texture_count);
+    }
+
+    return stats.failed ? 1 : 0;
+}
+
+b8 parse_texture_format(char const* name, Texture_Format* format)
+{
+    char const* const names[TEXTURE_FORMAT_ENUM_COUNT] = { "rgba8", "bc1", "bc3", "bc7" };
+    for (u32 i = 0; i < TEXTURE_FORMAT_ENUM_COUNT; ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *format = (Texture_Format)i;
+            return TRUE;
+        }
+    }
+
+    fprintf(stderr, "cook: Unknown texture format '%s'\n", name);
+    return FALSE;
+}
+
+b8 parse_quality(char const* name, Block_Compression_Quality* quality)
+{
+    char const* const names[] = { "fast", "normal", "high" };
+    for (u32 i = 0; i < 3; ++i)
+    {
+        if (strcmp(name, names[i]) == 0)
+        {
+            *quality = (Block_Compression_Quality)i;
+            return TRUE;
+        }
+    }
+
+    fprintf(stderr, "cook: Unknown quality '%s'\n", name);
+    return FALSE;
+}
+
+b8 walk(char const* root, char const* relative_path, b8 force, Cook_Stats* stats)
+{
+    // The output directory is never cooked again.
+    if (strcmp(relative_path, "cooked") == 0)
+    {
+        return TRUE;
+    }
+
+    char directory[1024];
+    snprintf(directory, sizeof(directory), "%s%s%s", root, relative_path[0] ? "/" : "", relative_path);
+
+#if defined(_WIN32)
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s/*", directory);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "cook: Failed to open directory '%s'\n", directory);
+        return FALSE;
+    }
+
+    b8 result = TRUE;
+    do
+    {
+        if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0)
+        {
+            continue;
+        }
+
+        char child[1024];
+        snprintf(child, sizeof(child), "%s%s%s", relative_path, relative_path[0] ? "/" : "", data.cFileName);
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            result = walk(root, child, force, stats);
+        }
+        else
+        {
+            cook_file(root, child, force, stats);
+        }
+    } while (result && FindNextFileA(find, &data));
+
+    FindClose(find);
+    return result;
+#else
+    DIR* dir = opendir(directory);
+    if (!dir)
+    {
+        fprintf(stderr, "cook: Failed to open directory '%s'\n", directory);
+        return FALSE;
+    }
+
+    b8 result = TRUE;
+    struct dirent* item;
+    while (result && (item = readdir(dir)))
+    {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        char child[1024];
+        char child_disk_path[2048];
+        snprintf(child, sizeof(child), "%s%s%s", relative_path, relative_path[0] ? "/" : "", item->d_name);
+        snprintf(child_disk_path, sizeof(child_disk_path), "%s/%s", root, child);
+
+        struct stat info;
+        if (stat(child_disk_path, &info) != 0)
+        {
+            fprintf(stderr, "cook: Failed to stat '%s'\n", child_disk_path);
+            result = FALSE;
+        }
+        else if (S_ISDIR(info.st_mode))
+        {
+            result = walk(root, child, force, stats);
+        }
+        else if (S_ISREG(info.st_mode))
+        {
+            cook_file(root, child, force, stats);
+        }
+    }
+
+    closedir(dir);
+    return result;
+#endif
+}
+
+void cook_file(char const* root, char const* relative_path, b8 force, Cook_Stats* stats)
+{
+    Cooked_Type type;
+    PFN_cook cooker = find_cooker(relative_path, &type);
+    if (!cooker)
+    {
+        return;
+    }
+
+    char source_path[2048];
+    char output_relative_path[2048];
+    char output_path[4096];
+    snprintf(source_path, sizeof(source_path), "%s/%s", root, relative_path);
+    snprintf(output_relative_path, sizeof(output_relative_path), COOKED_PATH_FORMAT, relative_path);
+    snprintf(output_path, sizeof(output_path), "%s/%s", root, output_relative_path);
+
+    u64 source_size;
+    u8* source = read_file(source_path, &source_size);
+    if (!source)
+    {
+        stats->failed++;
+        return;
+    }
+
+    u64 source_hash = hash_bytes(source, source_size, 0);
+    if (!force && is_up_to_date(output_path, type, source_hash))
+    {
+        stats->up_to_date++;
+        free(source);
+        return;
+    }
+
+    Cook_Output output = {};
+    b8 result = cooker(relative_path, source, source_size, &output);
+    free(source);
+    if (!result)
+    {
+        fprintf(stderr, "cook: Failed to cook '%s'\n", relative_path);
+        stats->failed++;
+        return;
+    }
+
+    ((Cooked_Header*)output.data)->source_hash = source_hash;
+
+    make_parent_directories(output_path);
+    FILE* file = fopen(output_path, "wb");
+    if (!file)
+    {
+        fprintf(stderr, "cook: Failed to open '%s' for writing\n", output_path);
+        stats->failed++;
+        free(output.data);
+        return;
+    }
+
+    result = fwrite(output.data, 1, output.size, file) == output.size;
+    result = fclose(file) == 0 && result;
+    free(output.data);
+    if (!result)
+    {
+        fprintf(stderr, "cook: Failed to write '%s'\n", output_path);
+        remove(output_path);
+        stats->failed++;
+        return;
+    }
+
+    printf("cook: %s -> %s (%llu bytes)\n", relative_path, output_relative_path, (unsigned long long)output.size);
+    stats->cooked++;
+}
+
+PFN_cook find_cooker(char const* relative_path, Cooked_Type* type)
+{
+    if (starts_with(relative_path, "textures/") && (ends_with(relative_path, ".png") || ends_with(relative_path, ".jpg") ||
+        ends_with(relative_path, ".tga") || ends_with(relative_path, ".bmp")))
+    {
+        *type = COOKED_TYPE_TEXTURE;
+        return cook_texture;
+    }
+
+    if (starts_with(relative_path, "materials/") && ends_with(relative_path, ".json"))
+    {
+        *type = COOKED_TYPE_MATERIAL;
+        return cook_material;
+    }
+
+    if (starts_with(relative_path, "shaders/") && ends_with(relative_path, "_config.json"))
+    {
+        *type = COOKED_TYPE_SHADER_CONFIG;
+        return cook_shader_config;
+    }
+
+    if (ends_with(relative_path, ".spv"))
+    {
+        *type = COOKED_TYPE_SPIRV;
+        return cook_spirv;
+    }
+
+    return 0;
+}
+
+b8 ends_with(char const* str, char const* suffix)
+{
+    size_t length = strlen(str);
+    size_t suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(str + length - suffix_length, suffix) == 0;
+}
+
+b8 starts_with(char const* str, char const* prefix)
+{
+    return strncmp(str, prefix, strlen(prefix)) == 0;
+}
+
+u8* read_file(char const* path, u64* size)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file)
+    {
+        fprintf(stderr, "cook: Failed to open '%s'\n", path);
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    u8* data = length >= 0 ? malloc(length ? length : 1) : 0;
+    if (!data || fread(data, 1, length, file) != (size_t)length)
+    {
+        fprintf(stderr, "cook: Failed to read '%s'\n", path);
+        free(data);
+        fclose(file);
+        return 0;
+    }
+
+    fclose(file);
+    *size = length;
+    return data;
+}
+
+b8 is_up_to_date(char const* output_path, Cooked_Type type, u64 source_hash)
+{
+    FILE* file = fopen(output_path, "rb");
+    if (!file)
+    {
+        return FALSE;
+    }
+
+    Cooked_Header header;
+    b8 read = fread(&header, sizeof(header), 1, file) == 1;
+    fclose(file);
+    return read && header.magic == COOKED_MAGIC && header.version == COOKED_VERSION && header.type == (u32)type &&
+        header.source_hash == source_hash;
+}
+
+void make_parent_directories(char const* path)
+{
+    char directory[4096];
+    snprintf(directory, sizeof(directory), "%s", path);
+    for (char* c = directory + 1; *c; ++c)
+    {
+        if (*c != '/' && *c != '\\')
+        {
+            continue;
+        }
+
+        // Creating a directory that already exists fails harmlessly; the final fopen reports real problems.
+        char separator = *c;
+        *c = 0;
+#if defined(_WIN32)
+        CreateDirectoryA(directory, 0);
+#else
+        mkdir(directory, 0755);
+#endif
+        *c = separator;
+    }
+}
+
+u8* cook_output_allocate(Cook_Output* output, Cooked_Type type, u64 size, u64 payload_offset, u64 payload_size)
+{
+    output->data = calloc(1, size);
+    output->size = size;
+
+    Cooked_Header* header = (Cooked_Header*)output->data;
+    header->magic = COOKED_MAGIC;
+    header->version = COOKED_VERSION;
+    header->type = type;
+    header->payload_offset = payload_offset;
+    header->payload_size = payload_size;
+    return output->data;
+}
+
+u64 cook_align_up(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
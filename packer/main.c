@@ -0,0 +1,342 @@
+#include <core/compression.h>
+#include <platform/pack_format.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @brief Builds a pack archive from a directory of assets.
+ * Every file below the input directory is stored under its path relative to that directory.
+ * Existing .pack files are skipped, so the archive can be written into the directory it packs.
+ * With --compress, each file is stored LZ-compressed when that saves at least an eighth of its size.
+ *
+ * Usage: packer [--compress] <input directory> <output file>
+ */
+
+typedef struct Pack_File
+{
+    char* path;
+    char* disk_path;
+    u64 size;
+    Pack_Entry entry;
+
+    // Stored payload, compressed or not
+    u8* data;
+} Pack_File;
+
+typedef struct Pack_File_List
+{
+    Pack_File* files;
+    u32 count;
+    u32 capacity;
+} Pack_File_List;
+
+static b8 collect_files(char const* root, char const* relative_path, Pack_File_List* list);
+static b8 add_file(char const* root, char const* relative_path, u64 size, Pack_File_List* list);
+static b8 ends_with(char const* str, char const* suffix);
+static int compare_files(void const* lhs, void const* rhs);
+static u64 align_up(u64 value, u64 alignment);
+static b8 load_file(Pack_File* file, b8 compress);
+static b8 write_pack(char const* output_path, Pack_File_List* list);
+
+int main(int argc, char** argv)
+{
+    b8 compress = argc == 4 && strcmp(argv[1], "--compress") == 0;
+    if (argc != 3 && !compress)
+    {
+        fprintf(stderr, "Usage: packer [--compress] <input directory> <output file>\n");
+        return 1;
+    }
+
+    char const* input_path = argv[argc - 2];
+    char const* output_path = argv[argc - 1];
+    Pack_File_List list = {};
+    if (!collect_files(input_path, "", &list))
+    {
+        return 1;
+    }
+
+    for (u32 i = 0; i < list.count; ++i)
+    {
+        if (!load_file(&list.files[i], compress))
+        {
+            return 1;
+        }
+    }
+
+    qsort(list.files, list.count, sizeof(*list.files), compare_files);
+    for (u32 i = 1; i < list.count; ++i)
+    {
+        if (list.files[i].entry.path_hash == list.files[i - 1].entry.path_hash)
+        {
+            fprintf(stderr, "packer: Hash collision between '%s' and '%s'. Rename one of them\n", list.files[i - 1].path, list.files[i].path);
+            return 1;
+        }
+    }
+
+    if (!write_pack(output_path, &list))
+    {
+        return 1;
+    }
+
+    for (u32 i = 0; i < list.count; ++i)
+    {
+        free(list.files[i].path);
+        free(list.files[i].disk_path);
+        free(list.files[i].data);
+    }
+    free(list.files);
+    return 0;
+}
+
+b8 collect_files(char const* root, char const* relative_path, Pack_File_List* list)
+{
+    char directory[1024];
+    snprintf(directory, sizeof(directory), "%s%s%s", root, relative_path[0] ? "/" : "", relative_path);
+
+#if defined(_WIN32)
+    char pattern[1024];
+    snprintf(pattern, sizeof(pattern), "%s/*", directory);
+    WIN32_FIND_DATAA data;
+    HANDLE find = FindFirstFileA(pattern, &data);
+    if (find == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "packer: Failed to open directory '%s'\n", directory);
+        return FALSE;
+    }
+
+    b8 result = TRUE;
+    do
+    {
+        if (strcmp(data.cFileName, ".") == 0 || strcmp(data.cFileName, "..") == 0)
+        {
+            continue;
+        }
+
+        char child[1024];
+        snprintf(child, sizeof(child), "%s%s%s", relative_path, relative_path[0] ? "/" : "", data.cFileName);
+        if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            result = collect_files(root, child, list);
+        }
+        else
+        {
+            result = add_file(root, child, ((u64)data.nFileSizeHigh << 32) | data.nFileSizeLow, list);
+        }
+    } while (result && FindNextFileA(find, &data));
+
+    FindClose(find);
+    return result;
+#else
+    DIR* dir = opendir(directory);
+    if (!dir)
+    {
+        fprintf(stderr, "packer: Failed to open directory '%s'\n", directory);
+        return FALSE;
+    }
+
+    b8 result = TRUE;
+    struct dirent* item;
+    while (result && (item = readdir(dir)))
+    {
+        if (strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        char child[1024];
+        char child_disk_path[2048];
+        snprintf(child, sizeof(child), "%s%s%s", relative_path, relative_path[0] ? "/" : "", item->d_name);
+        snprintf(child_disk_path, sizeof(child_disk_path), "%s/%s", root, child);
+
+        struct stat info;
+        if (stat(child_disk_path, &info) != 0)
+        {
+            fprintf(stderr, "packer: Failed to stat '%s'\n", child_disk_path);
+            result = FALSE;
+        }
+        else if (S_ISDIR(info.st_mode))
+        {
+            result = collect_files(root, child, list);
+        }
+        else if (S_ISREG(info.st_mode))
+        {
+            result = add_file(root, child, info.st_size, list);
+        }
+    }
+
+    closedir(dir);
+    return result;
+#endif
+}
+
+b8 add_file(char const* root, char const* relative_path, u64 size, Pack_File_List* list)
+{
+    if (ends_with(relative_path, ".pack"))
+    {
+        return TRUE;
+    }
+
+    if (list->count == list->capacity)
+    {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->files = realloc(list->files, list->capacity * sizeof(*list->files));
+    }
+
+    Pack_File* file = &list->files[list->count++];
+    memset(file, 0, sizeof(*file));
+    file->path = malloc(strlen(relative_path) + 1);
+    strcpy(file->path, relative_path);
+    file->disk_path = malloc(strlen(root) + strlen(relative_path) + 2);
+    sprintf(file->disk_path, "%s/%s", root, relative_path);
+    file->size = size;
+    file->entry.path_hash = pack_hash_path(relative_path);
+    file->entry.size = size;
+    file->entry.stored_size = size;
+    file->entry.compression = PACK_COMPRESSION_NONE;
+    return TRUE;
+}
+
+b8 ends_with(char const* str, char const* suffix)
+{
+    size_t length = strlen(str);
+    size_t suffix_length = strlen(suffix);
+    return length >= suffix_length && strcmp(str + length - suffix_length, suffix) == 0;
+}
+
+int compare_files(void const* lhs, void const* rhs)
+{
+    u64 a = ((Pack_File const*)lhs)->entry.path_hash;
+    u64 b = ((Pack_File const*)rhs)->entry.path_hash;
+    return (a > b) - (a < b);
+}
+
+u64 align_up(u64 value, u64 alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+b8 load_file(Pack_File* file, b8 compress)
+{
+    FILE* input = fopen(file->disk_path, "rb");
+    if (!input)
+    {
+        fprintf(stderr, "packer: Failed to open '%s'\n", file->disk_path);
+        return FALSE;
+    }
+
+    u8* data = malloc(file->size ? file->size : 1);
+    b8 read = fread(data, 1, file->size, input) == file->size;
+    fclose(input);
+    if (!read)
+    {
+        fprintf(stderr, "packer: Failed to read '%s'\n", file->disk_path);
+        free(data);
+        return FALSE;
+    }
+
+    file->data = data;
+    if (!compress || file->size == 0)
+    {
+        return TRUE;
+    }
+
+    u64 capacity = compression_lz_bound(file->size);
+    u8* compressed = malloc(capacity);
+    u64 compressed_size = compression_lz_compress(data, file->size, compressed, capacity);
+    if (compressed_size == 0 || compressed_size > file->size - file->size / 8)
+    {
+        // Already compressed formats (PNG, ...) are stored as is, so they can still be used in place.
+        free(compressed);
+        return TRUE;
+    }
+
+    free(data);
+    file->data = compressed;
+    file->entry.stored_size = compressed_size;
+    file->entry.compression = PACK_COMPRESSION_LZ;
+    return TRUE;
+}
+
+b8 write_pack(char const* output_path, Pack_File_List* list)
+{
+    Pack_Header header = {};
+    header.magic = PACK_MAGIC;
+    header.version = PACK_VERSION;
+    header.entry_count = list->count;
+    header.alignment = PACK_ALIGNMENT;
+    header.toc_offset = sizeof(header);
+    header.string_table_offset = header.toc_offset + (u64)list->count * sizeof(Pack_Entry);
+
+    u64 string_table_size = 0;
+    for (u32 i = 0; i < list->count; ++i)
+    {
+        list->files[i].entry.path_offset = (u32)string_table_size;
+        string_table_size += strlen(list->files[i].path) + 1;
+    }
+    header.string_table_size = string_table_size;
+
+    u64 offset = align_up(header.string_table_offset + string_table_size, PACK_ALIGNMENT);
+    for (u32 i = 0; i < list->count; ++i)
+    {
+        list->files[i].entry.offset = offset;
+        offset = align_up(offset + list->files[i].entry.stored_size, PACK_ALIGNMENT);
+    }
+
+    FILE* output = fopen(output_path, "wb");
+    if (!output)
+    {
+        fprintf(stderr, "packer: Failed to open '%s' for writing\n", output_path);
+        return FALSE;
+    }
+
+    fwrite(&header, sizeof(header), 1, output);
+    for (u32 i = 0; i < list->count; ++i)
+    {
+        fwrite(&list->files[i].entry, sizeof(Pack_Entry), 1, output);
+    }
+    for (u32 i = 0; i < list->count; ++i)
+    {
+        fwrite(list->files[i].path, strlen(list->files[i].path) + 1, 1, output);
+    }
+
+    static u8 zeros[PACK_ALIGNMENT];
+    u64 written = header.string_table_offset + string_table_size;
+    u64 payload_size = 0;
+    b8 result = TRUE;
+    for (u32 i = 0; i < list->count && result; ++i)
+    {
+        Pack_File* file = &list->files[i];
+        fwrite(zeros, file->entry.offset - written, 1, output);
+        written = file->entry.offset;
+
+        if (fwrite(file->data, 1, file->entry.stored_size, output) != file->entry.stored_size)
+        {
+            fprintf(stderr, "packer: Failed to write '%s'\n", file->path);
+            result = FALSE;
+        }
+
+        written += file->entry.stored_size;
+        payload_size += file->entry.stored_size;
+    }
+
+    if (fclose(output) != 0)
+    {
+        result = FALSE;
+    }
+
+    if (result)
+    {
+        printf("packer: Wrote %u files (%llu bytes of payload) to '%s'\n", list->count, (unsigned long long)payload_size, output_path);
+    }
+
+    return result;
+}
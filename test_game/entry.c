@@ -2,6 +2,9 @@
 
 #include <entry.h>
 
+// Textures referenced by the game's materials.
+static char const* preload_texture_names[] = { "paving", "cobblestone" };
+
 b8 create_game_instance(game_instance* instance)
 {
     instance->application_config.x = 100;
@@ -9,6 +12,8 @@ b8 create_game_instance(game_instance* instance)
     instance->application_config.width = 1280;
     instance->application_config.height = 720;
     instance->application_config.name = "Game";
+    instance->application_config.preload_texture_names = preload_texture_names;
+    instance->application_config.preload_texture_count = sizeof(preload_texture_names) / sizeof(*preload_texture_names);
 
     instance->init = game_init;
     instance->on_update = game_update;
@@ -0,0 +1,87 @@
+#include "dynamic_array_benchmarks.h"
+
+#include "test_manager.h"
+
+#include <containers/dynamic_array.h>
+
+#define ELEMENT_COUNT 4096
+
+static void dynamic_array_benchmark_push_back(benchmark_state* state);
+static void dynamic_array_benchmark_push_back_reserved(benchmark_state* state);
+static void dynamic_array_benchmark_at(benchmark_state* state);
+
+void dynamic_array_register_benchmarks()
+{
+    test_manager_register_benchmark(dynamic_array_benchmark_push_back, "dynamic_array_push_back_4096");
+    test_manager_register_benchmark(dynamic_array_benchmark_push_back_reserved, "dynamic_array_push_back_reserved_4096");
+    test_manager_register_benchmark(dynamic_array_benchmark_at, "dynamic_array_at_4096");
+}
+
+void dynamic_array_benchmark_push_back(benchmark_state* state)
+{
+    state->items_per_iteration = ELEMENT_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        benchmark_pause_timing(state);
+        Dynamic_Array* array = DYNAMIC_ARRAY_CREATE(u64);
+        benchmark_resume_timing(state);
+
+        for (u64 e = 0; e < ELEMENT_COUNT; ++e)
+        {
+            dynamic_array_push_back(array, &e);
+        }
+        BENCHMARK_CLOBBER();
+
+        benchmark_pause_timing(state);
+        dynamic_array_destroy(array);
+        benchmark_resume_timing(state);
+    }
+}
+
+void dynamic_array_benchmark_push_back_reserved(benchmark_state* state)
+{
+    state->items_per_iteration = ELEMENT_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        benchmark_pause_timing(state);
+        Dynamic_Array* array = DYNAMIC_ARRAY_CREATE(u64);
+        dynamic_array_reserve(array, ELEMENT_COUNT);
+        benchmark_resume_timing(state);
+
+        for (u64 e = 0; e < ELEMENT_COUNT; ++e)
+        {
+            dynamic_array_push_back(array, &e);
+        }
+        BENCHMARK_CLOBBER();
+
+        benchmark_pause_timing(state);
+        dynamic_array_destroy(array);
+        benchmark_resume_timing(state);
+    }
+}
+
+void dynamic_array_benchmark_at(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    Dynamic_Array* array = DYNAMIC_ARRAY_CREATE(u64);
+    for (u64 e = 0; e < ELEMENT_COUNT; ++e)
+    {
+        dynamic_array_push_back(array, &e);
+    }
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = ELEMENT_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        u64 sum = 0;
+        for (u32 e = 0; e < ELEMENT_COUNT; ++e)
+        {
+            sum += DYNAMIC_ARRAY_AT_AS(array, e, u64);
+        }
+        BENCHMARK_DO_NOT_OPTIMIZE(sum);
+    }
+
+    benchmark_pause_timing(state);
+    dynamic_array_destroy(array);
+    benchmark_resume_timing(state);
+}
@@ -0,0 +1,63 @@
+#include "dynamic_array_tests.h"
+
+#include <containers/dynamic_array.h>
+#include <systems/memory_system.h>
+#include "expect.h"
+#include "test_fixtures.h"
+#include "test_manager.h"
+
+static u8 dynamic_array_test_push_back_and_at();
+static u8 dynamic_array_test_pop();
+
+void dynamic_array_register_tests()
+{
+    test_manager_register_test(dynamic_array_test_push_back_and_at, "dynamic_array_test_push_back_and_at");
+    test_manager_register_test(dynamic_array_test_pop, "dynamic_array_test_pop");
+}
+
+u8 dynamic_array_test_push_back_and_at()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(1));
+    Dynamic_Array* array = DYNAMIC_ARRAY_CREATE(u64);
+
+    // Enough elements to grow the array a few times, each of which must land at its own index.
+    for (u64 i = 0; i < 100; ++i)
+    {
+        u64 value = i * 1000;
+        dynamic_array_push_back(array, &value);
+    }
+    EXPECT_EQUAL(array->size, 100);
+
+    for (u32 i = 0; i < 100; ++i)
+    {
+        EXPECT_EQUAL(DYNAMIC_ARRAY_AT_AS(array, i, u64), (u64)i * 1000);
+    }
+
+    dynamic_array_destroy(array);
+    memory_system_shutdown();
+    return TRUE;
+}
+
+u8 dynamic_array_test_pop()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(1));
+    Dynamic_Array* array = DYNAMIC_ARRAY_CREATE(u64);
+    for (u64 i = 0; i < 3; ++i)
+    {
+        dynamic_array_push_back(array, &i);
+    }
+
+    u64 value = 0;
+    dynamic_array_pop(array, &value);
+    EXPECT_EQUAL(value, 2);
+    EXPECT_EQUAL(array->size, 2);
+
+    // The popped element may be discarded.
+    dynamic_array_pop(array, 0);
+    EXPECT_EQUAL(array->size, 1);
+    EXPECT_EQUAL(DYNAMIC_ARRAY_AT_AS(array, 0, u64), 0);
+
+    dynamic_array_destroy(array);
+    memory_system_shutdown();
+    return TRUE;
+}
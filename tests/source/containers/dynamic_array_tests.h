@@ -0,0 +1,3 @@
+#pragma once
+
+void dynamic_array_register_tests();
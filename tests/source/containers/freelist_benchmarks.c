@@ -0,0 +1,77 @@
+#include "freelist_benchmarks.h"
+
+#include "test_manager.h"
+
+#include <containers/freelist.h>
+
+#define BLOCK_COUNT 256
+#define BLOCK_SIZE 64
+
+static void freelist_benchmark_allocate_free_in_order(benchmark_state* state);
+static void freelist_benchmark_allocate_free_interleaved(benchmark_state* state);
+
+void freelist_register_benchmarks()
+{
+    test_manager_register_benchmark(freelist_benchmark_allocate_free_in_order, "freelist_allocate_free_in_order_256");
+    test_manager_register_benchmark(freelist_benchmark_allocate_free_interleaved, "freelist_allocate_free_interleaved_256");
+}
+
+void freelist_benchmark_allocate_free_in_order(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    Freelist* list = freelist_create(BLOCK_COUNT * BLOCK_SIZE);
+    benchmark_resume_timing(state);
+
+    u32 offsets[BLOCK_COUNT];
+    state->items_per_iteration = BLOCK_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        for (u32 b = 0; b < BLOCK_COUNT; ++b)
+        {
+            freelist_allocate(list, BLOCK_SIZE, &offsets[b]);
+        }
+        BENCHMARK_CLOBBER();
+
+        for (u32 b = 0; b < BLOCK_COUNT; ++b)
+        {
+            freelist_free(list, offsets[b], BLOCK_SIZE);
+        }
+    }
+
+    benchmark_pause_timing(state);
+    freelist_destroy(list);
+    benchmark_resume_timing(state);
+}
+
+void freelist_benchmark_allocate_free_interleaved(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    Freelist* list = freelist_create(BLOCK_COUNT * BLOCK_SIZE);
+    benchmark_resume_timing(state);
+
+    // Freeing every other block first fragments the list, so the second half frees have to coalesce.
+    u32 offsets[BLOCK_COUNT];
+    state->items_per_iteration = BLOCK_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        for (u32 b = 0; b < BLOCK_COUNT; ++b)
+        {
+            freelist_allocate(list, BLOCK_SIZE, &offsets[b]);
+        }
+        BENCHMARK_CLOBBER();
+
+        for (u32 b = 0; b < BLOCK_COUNT; b += 2)
+        {
+            freelist_free(list, offsets[b], BLOCK_SIZE);
+        }
+
+        for (u32 b = 1; b < BLOCK_COUNT; b += 2)
+        {
+            freelist_free(list, offsets[b], BLOCK_SIZE);
+        }
+    }
+
+    benchmark_pause_timing(state);
+    freelist_destroy(list);
+    benchmark_resume_timing(state);
+}
@@ -3,33 +3,117 @@
 #include <containers/freelist.h>
 #include <systems/memory_system.h>
 #include "expect.h"
+#include "test_fixtures.h"
 #include "test_manager.h"
 
 static u8 freelist_test_create_and_destroy();
+static u8 freelist_test_resize();
+static u8 freelist_test_free_space();
+static u8 freelist_test_free_below_first_block();
 
 void freelist_register_tests()
 {
     test_manager_register_test(freelist_test_create_and_destroy, "freelist_test_create_and_destroy");
-
+    test_manager_register_test(freelist_test_resize, "freelist_test_resize");
+    test_manager_register_test(freelist_test_free_space, "freelist_test_free_space");
+    test_manager_register_test(freelist_test_free_below_first_block, "freelist_test_free_below_first_block");
 }
 
 u8 freelist_test_create_and_destroy()
 {
-    freelist list;
-    u64 required_memory;
+    test_fixtures_start_memory_system(MEBIBYTES(1));
     u32 size = 1024;
-    freelist_create(&required_memory, 0, size, 0);
+    Freelist* list = freelist_create(size);
+    EXPECT_NOT_EQUAL(list, 0);
+    EXPECT_EQUAL(list->total_size, size);
+    EXPECT_EQUAL(freelist_free_space(list), size);
+    EXPECT_EQUAL(freelist_largest_free_block(list), size);
+
+    freelist_destroy(list);
+    memory_system_shutdown();
+    return TRUE;
+}
+
+u8 freelist_test_resize()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(1));
+    Freelist* list = freelist_create(256);
+    u32 first;
+    u32 second;
+    expect_to_be_true(freelist_allocate(list, 128, &first));
+    expect_to_be_true(freelist_allocate(list, 64, &second));
+    expect_to_be_false(freelist_allocate(list, 128, &second));
+
+    // The space added joins the free block at the end.
+    expect_to_be_false(freelist_resize(list, 128));
+    expect_to_be_true(freelist_resize(list, 320));
+    u32 third;
+    expect_to_be_true(freelist_allocate(list, 128, &third));
+    EXPECT_EQUAL(third, 192);
+
+    // A full list grows as well.
+    expect_to_be_true(freelist_resize(list, 384));
+    u32 fourth;
+    expect_to_be_true(freelist_allocate(list, 64, &fourth));
+    EXPECT_EQUAL(fourth, 320);
+    expect_to_be_false(freelist_allocate(list, 1, &fourth));
+
+    freelist_destroy(list);
+    memory_system_shutdown();
+    return TRUE;
+}
+
+u8 freelist_test_free_space()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(1));
+    Freelist* list = freelist_create(256);
+    u32 offsets[4];
+    for (u32 i = 0; i < 4; ++i)
+    {
+        expect_to_be_true(freelist_allocate(list, 64, &offsets[i]));
+    }
+    EXPECT_EQUAL(freelist_free_space(list), 0);
+    EXPECT_EQUAL(freelist_largest_free_block(list), 0);
+
+    // Two holes that aren't next to each other hold 128 bytes, but no more than 64 at once.
+    expect_to_be_true(freelist_free(list, offsets[0], 64));
+    expect_to_be_true(freelist_free(list, offsets[2], 64));
+    EXPECT_EQUAL(freelist_free_space(list), 128);
+    EXPECT_EQUAL(freelist_largest_free_block(list), 64);
+
+    expect_to_be_true(freelist_free(list, offsets[1], 64));
+    EXPECT_EQUAL(freelist_largest_free_block(list), 192);
+
+    freelist_destroy(list);
+    memory_system_shutdown();
+    return TRUE;
+}
+
+u8 freelist_test_free_below_first_block()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(1));
+    Freelist* list = freelist_create(256);
+    u32 offsets[4];
+    for (u32 i = 0; i < 4; ++i)
+    {
+        expect_to_be_true(freelist_allocate(list, 64, &offsets[i]));
+    }
 
-    void* memory = memory_allocate(required_memory, MEMORY_TAG_APPLICATION);
-    freelist_create(&required_memory, memory, size, &list);
-    EXPECT_NOT_EQUAL(memory, 0);
+    // The second block freed lies below the only free block, so it becomes the new head of the list.
+    expect_to_be_true(freelist_free(list, offsets[2], 64));
+    expect_to_be_true(freelist_free(list, offsets[0], 64));
+    EXPECT_EQUAL(freelist_free_space(list), 128);
+    EXPECT_EQUAL(freelist_largest_free_block(list), 64);
 
-    u64 space = freelist_free_space(&list);
-    EXPECT_EQUAL(size, space);
+    // Freeing the block between them joins all three.
+    expect_to_be_true(freelist_free(list, offsets[1], 64));
+    EXPECT_EQUAL(freelist_largest_free_block(list), 192);
 
-    freelist_destroy(&list);
-    EXPECT_EQUAL(list.internal, 0);
+    u32 offset;
+    expect_to_be_true(freelist_allocate(list, 192, &offset));
+    EXPECT_EQUAL(offset, 0);
 
-    memory_free(memory, required_memory, MEMORY_TAG_APPLICATION);
+    freelist_destroy(list);
+    memory_system_shutdown();
     return TRUE;
 }
@@ -0,0 +1,105 @@
+#include "hash_table_benchmarks.h"
+
+#include "test_manager.h"
+
+#include <containers/hash_table.h>
+#include <core/string_utils.h>
+
+#define KEY_COUNT 1024
+#define KEY_LENGTH 16
+
+static char keys[KEY_COUNT][KEY_LENGTH];
+static char missing_keys[KEY_COUNT][KEY_LENGTH];
+
+static void generate_keys();
+static void hash_table_benchmark_insert(benchmark_state* state);
+static void hash_table_benchmark_lookup_hit(benchmark_state* state);
+static void hash_table_benchmark_lookup_miss(benchmark_state* state);
+
+void hash_table_register_benchmarks()
+{
+    generate_keys();
+    test_manager_register_benchmark(hash_table_benchmark_insert, "hash_table_insert_1024");
+    test_manager_register_benchmark(hash_table_benchmark_lookup_hit, "hash_table_lookup_hit_1024");
+    test_manager_register_benchmark(hash_table_benchmark_lookup_miss, "hash_table_lookup_miss_1024");
+}
+
+void generate_keys()
+{
+    for (u32 i = 0; i < KEY_COUNT; ++i)
+    {
+        string_format(keys[i], "key_%u", i);
+        string_format(missing_keys[i], "missing_%u", i);
+    }
+}
+
+void hash_table_benchmark_insert(benchmark_state* state)
+{
+    state->items_per_iteration = KEY_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        benchmark_pause_timing(state);
+        Hash_Table* table = HASH_TABLE_CREATE(u64, 16);
+        benchmark_resume_timing(state);
+
+        for (u64 k = 0; k < KEY_COUNT; ++k)
+        {
+            hash_table_insert(table, keys[k], &k);
+        }
+        BENCHMARK_CLOBBER();
+
+        benchmark_pause_timing(state);
+        hash_table_destroy(table);
+        benchmark_resume_timing(state);
+    }
+}
+
+void hash_table_benchmark_lookup_hit(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    Hash_Table* table = HASH_TABLE_CREATE(u64, KEY_COUNT * 2);
+    for (u64 k = 0; k < KEY_COUNT; ++k)
+    {
+        hash_table_insert(table, keys[k], &k);
+    }
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = KEY_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        for (u32 k = 0; k < KEY_COUNT; ++k)
+        {
+            void* value = hash_table_at(table, keys[k]);
+            BENCHMARK_DO_NOT_OPTIMIZE(value);
+        }
+    }
+
+    benchmark_pause_timing(state);
+    hash_table_destroy(table);
+    benchmark_resume_timing(state);
+}
+
+void hash_table_benchmark_lookup_miss(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    Hash_Table* table = HASH_TABLE_CREATE(u64, KEY_COUNT * 2);
+    for (u64 k = 0; k < KEY_COUNT; ++k)
+    {
+        hash_table_insert(table, keys[k], &k);
+    }
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = KEY_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        for (u32 k = 0; k < KEY_COUNT; ++k)
+        {
+            void* value = hash_table_at(table, missing_keys[k]);
+            BENCHMARK_DO_NOT_OPTIMIZE(value);
+        }
+    }
+
+    benchmark_pause_timing(state);
+    hash_table_destroy(table);
+    benchmark_resume_timing(state);
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void hash_table_register_benchmarks();
@@ -0,0 +1,121 @@
+#include "compression_benchmarks.h"
+
+#include "../test_manager.h"
+
+#include <config.h>
+#include <core/compression.h>
+#include <core/logger.h>
+#include <core/string_utils.h>
+#include <platform/filesystem.h>
+#include <resources/loaders/image_loader.h>
+#include <systems/memory_system.h>
+
+// The texture set the benchmark runs on, decoded to RGBA8 as a cooked texture would store it.
+static char const* texture_names[] = { "cobblestone.png", "orange_lines_512.png", "paving.png", "paving2.png" };
+#define TEXTURE_COUNT (sizeof(texture_names) / sizeof(*texture_names))
+
+typedef struct Compression_Corpus
+{
+    b8 loaded;
+    u8* pixels;
+    u64 size;
+    u8* compressed;
+    u64 compressed_capacity;
+    u64 compressed_size;
+    u8* output;
+} Compression_Corpus;
+
+static Compression_Corpus corpus;
+
+static void load_corpus();
+static void compression_benchmark_decompress_textures(benchmark_state* state);
+static void compression_benchmark_compress_textures(benchmark_state* state);
+
+void compression_register_benchmarks()
+{
+    // items_per_second in the report is bytes of decompressed output per second.
+    test_manager_register_benchmark(compression_benchmark_decompress_textures, "lz_decompress_textures_rgba8");
+    test_manager_register_benchmark(compression_benchmark_compress_textures, "lz_compress_textures_rgba8");
+}
+
+void compression_benchmark_decompress_textures(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    load_corpus();
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = corpus.size;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        compression_lz_decompress(corpus.compressed, corpus.compressed_size, corpus.output, corpus.size);
+        BENCHMARK_CLOBBER();
+    }
+}
+
+void compression_benchmark_compress_textures(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    load_corpus();
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = corpus.size;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        u64 size = compression_lz_compress(corpus.pixels, corpus.size, corpus.compressed, corpus.compressed_capacity);
+        BENCHMARK_DO_NOT_OPTIMIZE(size);
+    }
+}
+
+void load_corpus()
+{
+    if (corpus.loaded)
+    {
+        return;
+    }
+
+    u8* images[TEXTURE_COUNT] = {};
+    u64 sizes[TEXTURE_COUNT] = {};
+    for (u32 i = 0; i < TEXTURE_COUNT; ++i)
+    {
+        char path[256];
+        string_format(path, "%s/%s/%s", ASSETS_DIR, "textures", texture_names[i]);
+        File_View view;
+        if (!filesystem_map(path, &view))
+        {
+            continue;
+        }
+
+        u32 width;
+        u32 height;
+        images[i] = image_loader_decode(view.data, view.size, &width, &height);
+        sizes[i] = (u64)width * height * 4;
+        corpus.size += sizes[i];
+        filesystem_unmap(&view);
+    }
+
+    if (corpus.size == 0)
+    {
+        LOG_WARNING("load_corpus: No textures found in %s/textures. Benchmarking an empty corpus", ASSETS_DIR);
+    }
+
+    // One extra page keeps the allocations non-empty.
+    corpus.pixels = memory_system_allocate(corpus.size + 4096, MEMORY_TAG_UNKNOWN);
+    corpus.output = memory_system_allocate(corpus.size + 4096, MEMORY_TAG_UNKNOWN);
+    u64 offset = 0;
+    for (u32 i = 0; i < TEXTURE_COUNT; ++i)
+    {
+        if (images[i])
+        {
+            memory_system_copy(corpus.pixels + offset, images[i], sizes[i]);
+            offset += sizes[i];
+            image_loader_free_pixels(images[i]);
+        }
+    }
+
+    corpus.compressed_capacity = compression_lz_bound(corpus.size);
+    corpus.compressed = memory_system_allocate(corpus.compressed_capacity, MEMORY_TAG_UNKNOWN);
+    corpus.compressed_size = compression_lz_compress(corpus.pixels, corpus.size, corpus.compressed, corpus.compressed_capacity);
+    LOG_INFO("load_corpus: %llu bytes of RGBA8 pixels compress to %llu bytes (ratio %.3f)",
+        corpus.size, corpus.compressed_size, corpus.size ? (f64)corpus.compressed_size / corpus.size : 0.0);
+    corpus.loaded = TRUE;
+}
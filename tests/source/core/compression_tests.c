@@ -0,0 +1,110 @@
+#include "compression_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <core/compression.h>
+
+#include <string.h>
+
+#define BUFFER_SIZE (256 * 1024)
+
+static u8 data[BUFFER_SIZE];
+static u8 compressed[BUFFER_SIZE + BUFFER_SIZE / 255 + 16];
+static u8 output[BUFFER_SIZE + 1];
+
+static u8 compression_test_round_trip_patterns();
+static u8 compression_test_empty_and_tiny_inputs();
+static u8 compression_test_rejects_corrupt_input();
+
+static u8 round_trip(u8 const* source, u64 size);
+
+void compression_register_tests()
+{
+    test_manager_register_test(compression_test_round_trip_patterns, "compression_test_round_trip_patterns");
+    test_manager_register_test(compression_test_empty_and_tiny_inputs, "compression_test_empty_and_tiny_inputs");
+    test_manager_register_test(compression_test_rejects_corrupt_input, "compression_test_rejects_corrupt_input");
+}
+
+u8 compression_test_round_trip_patterns()
+{
+    // Incompressible
+    u32 seed = 12345;
+    for (u32 i = 0; i < BUFFER_SIZE; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (u8)(seed >> 24);
+    }
+    expect_to_be_true(round_trip(data, BUFFER_SIZE));
+
+    // Repeating RGBA pixel: offsets shorter than a wild copy
+    for (u32 i = 0; i < BUFFER_SIZE; ++i)
+    {
+        data[i] = (u8)(i % 4 == 3 ? 255 : i % 4 * 40);
+    }
+    expect_to_be_true(round_trip(data, BUFFER_SIZE));
+
+    // Long runs and long literals, to exercise the extended length encoding
+    for (u32 i = 0; i < BUFFER_SIZE; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = (i / 4096) % 2 ? 7 : (u8)(seed >> 24);
+    }
+    expect_to_be_true(round_trip(data, BUFFER_SIZE));
+
+    return TRUE;
+}
+
+u8 compression_test_empty_and_tiny_inputs()
+{
+    for (u32 i = 0; i < 32; ++i)
+    {
+        data[i] = (u8)(i % 3);
+    }
+
+    for (u64 size = 0; size <= 32; ++size)
+    {
+        expect_to_be_true(round_trip(data, size));
+    }
+
+    return TRUE;
+}
+
+u8 compression_test_rejects_corrupt_input()
+{
+    u64 size = 4096;
+    for (u32 i = 0; i < size; ++i)
+    {
+        data[i] = (u8)(i % 17);
+    }
+
+    u64 compressed_size = compression_lz_compress(data, size, compressed, sizeof(compressed));
+    EXPECT_NOT_EQUAL(compressed_size, 0);
+
+    // Wrong destination size
+    expect_to_be_false(compression_lz_decompress(compressed, compressed_size, output, size - 1));
+    expect_to_be_false(compression_lz_decompress(compressed, compressed_size, output, size + 1));
+
+    // Truncated stream
+    expect_to_be_false(compression_lz_decompress(compressed, compressed_size - 1, output, size));
+
+    // An offset pointing before the start of the output: literal "a", then a match 2 bytes back
+    u8 bad_offset[] = { 0x10, 'a', 0x02, 0x00, 0x00 };
+    expect_to_be_false(compression_lz_decompress(bad_offset, sizeof(bad_offset), output, 5));
+
+    return TRUE;
+}
+
+u8 round_trip(u8 const* source, u64 size)
+{
+    u64 compressed_size = compression_lz_compress(source, size, compressed, sizeof(compressed));
+    b8 result = compressed_size > 0
+        && compression_lz_decompress(compressed, compressed_size, output, size)
+        && memcmp(output, source, size) == 0;
+    if (!result)
+    {
+        LOG_ERROR("round_trip: Failed for %llu bytes", size);
+    }
+
+    return result;
+}
@@ -1,13 +1,68 @@
 #include "test_manager.h"
 
 #include "memory/linear_allocator_tests.h"
+#include "memory/linear_allocator_benchmarks.h"
+#include "memory/dynamic_allocator_benchmarks.h"
 #include "containers/hashtable_tests.h"
-#include "containers/freelist.h"
+#include "containers/hash_table_benchmarks.h"
+#include "containers/freelist_tests.h"
+#include "containers/freelist_benchmarks.h"
+#include "containers/dynamic_array_tests.h"
+#include "containers/dynamic_array_benchmarks.h"
+#include "core/compression_tests.h"
+#include "core/compression_benchmarks.h"
+#include "resources/config_loader_tests.h"
+#include "resources/image_cache_tests.h"
+#include "resources/image_kernels_tests.h"
+#include "resources/image_kernels_benchmarks.h"
+#include "resources/block_compression_tests.h"
+#include "resources/block_compression_benchmarks.h"
+#include "resources/mip_chain_tests.h"
+#include "resources/texture_container_tests.h"
+#include "resources/texture_atlas_tests.h"
+#include "platform/filesystem_tests.h"
+#include "renderer/staging_ring_tests.h"
+#include "renderer/device_memory_block_tests.h"
+#include "systems/resource_batch_tests.h"
+#include "systems/resource_manager_tests.h"
+#include "systems/streaming_system_tests.h"
 
 #include <core/logger.h>
+#include <systems/memory_system.h>
 
-int main()
+#include <string.h>
+
+int main(int argc, char** argv)
 {
+    // tests --bench [output.json] runs the benchmarks instead of the tests.
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+    {
+        // The benchmarked containers allocate through the memory system.
+        memory_system_configuration memory_system_config = {};
+        memory_system_config.tracked_memory = GIBIBYTES(1);
+        if (!memory_system_startup(memory_system_config))
+        {
+            LOG_FATAL("main: Failed to initialize memory system");
+            return 1;
+        }
+
+        test_manager_init();
+        hash_table_register_benchmarks();
+        freelist_register_benchmarks();
+        dynamic_array_register_benchmarks();
+        linear_allocator_register_benchmarks();
+        dynamic_allocator_register_benchmarks();
+        compression_register_benchmarks();
+        image_kernels_register_benchmarks();
+        block_compression_register_benchmarks();
+
+        LOG_DEBUG("Starting benchmarks...");
+        test_manager_run_benchmarks(argc > 2 ? argv[2] : "benchmarks.json");
+
+        memory_system_shutdown();
+        return 0;
+    }
+
     // Always initalize the test manager first.
     test_manager_init();
 
@@ -15,6 +70,21 @@ int main()
     linear_allocator_register_tests();
     hashtable_register_tests();
     freelist_register_tests();
+    dynamic_array_register_tests();
+    compression_register_tests();
+    config_loader_register_tests();
+    image_cache_register_tests();
+    image_kernels_register_tests();
+    mip_chain_register_tests();
+    block_compression_register_tests();
+    texture_container_register_tests();
+    texture_atlas_register_tests();
+    filesystem_register_tests();
+    staging_ring_register_tests();
+    device_memory_block_register_tests();
+    resource_manager_register_tests();
+    resource_batch_register_tests();
+    streaming_system_register_tests();
 
 
     LOG_DEBUG("Starting tests...");
@@ -0,0 +1,90 @@
+#include "dynamic_allocator_benchmarks.h"
+
+#include "../test_manager.h"
+
+#include <memory/dynamic_allocator.h>
+#include <systems/memory_system.h>
+
+#define ALLOCATION_COUNT 512
+
+static u64 allocation_size(u32 index);
+static void dynamic_allocator_benchmark_allocate_free_lifo(benchmark_state* state);
+static void dynamic_allocator_benchmark_allocate_free_fifo(benchmark_state* state);
+
+void dynamic_allocator_register_benchmarks()
+{
+    test_manager_register_benchmark(dynamic_allocator_benchmark_allocate_free_lifo, "dynamic_allocator_allocate_free_lifo_512");
+    test_manager_register_benchmark(dynamic_allocator_benchmark_allocate_free_fifo, "dynamic_allocator_allocate_free_fifo_512");
+}
+
+u64 allocation_size(u32 index)
+{
+    // Mixed small sizes, as seen from containers and strings.
+    return 16 + (index % 8) * 24;
+}
+
+void dynamic_allocator_benchmark_allocate_free_lifo(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    u64 tracked_memory = ALLOCATION_COUNT * allocation_size(7);
+    u64 required_memory = 0;
+    dynamic_allocator_create(&required_memory, 0, tracked_memory, 0);
+    void* block = memory_system_allocate(required_memory, MEMORY_TAG_APPLICATION);
+    dynamic_allocator allocator;
+    dynamic_allocator_create(&required_memory, block, tracked_memory, &allocator);
+    benchmark_resume_timing(state);
+
+    void* blocks[ALLOCATION_COUNT];
+    state->items_per_iteration = ALLOCATION_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        for (u32 a = 0; a < ALLOCATION_COUNT; ++a)
+        {
+            blocks[a] = dynamic_allocator_allocate(&allocator, allocation_size(a));
+        }
+        BENCHMARK_CLOBBER();
+
+        for (u32 a = ALLOCATION_COUNT; a > 0; --a)
+        {
+            dynamic_allocator_free(&allocator, blocks[a - 1], allocation_size(a - 1));
+        }
+    }
+
+    benchmark_pause_timing(state);
+    dynamic_allocator_destroy(&allocator);
+    memory_system_free(block, required_memory, MEMORY_TAG_APPLICATION);
+    benchmark_resume_timing(state);
+}
+
+void dynamic_allocator_benchmark_allocate_free_fifo(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    u64 tracked_memory = ALLOCATION_COUNT * allocation_size(7);
+    u64 required_memory = 0;
+    dynamic_allocator_create(&required_memory, 0, tracked_memory, 0);
+    void* block = memory_system_allocate(required_memory, MEMORY_TAG_APPLICATION);
+    dynamic_allocator allocator;
+    dynamic_allocator_create(&required_memory, block, tracked_memory, &allocator);
+    benchmark_resume_timing(state);
+
+    void* blocks[ALLOCATION_COUNT];
+    state->items_per_iteration = ALLOCATION_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        for (u32 a = 0; a < ALLOCATION_COUNT; ++a)
+        {
+            blocks[a] = dynamic_allocator_allocate(&allocator, allocation_size(a));
+        }
+        BENCHMARK_CLOBBER();
+
+        for (u32 a = 0; a < ALLOCATION_COUNT; ++a)
+        {
+            dynamic_allocator_free(&allocator, blocks[a], allocation_size(a));
+        }
+    }
+
+    benchmark_pause_timing(state);
+    dynamic_allocator_destroy(&allocator);
+    memory_system_free(block, required_memory, MEMORY_TAG_APPLICATION);
+    benchmark_resume_timing(state);
+}
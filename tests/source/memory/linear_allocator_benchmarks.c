@@ -0,0 +1,42 @@
+#include "linear_allocator_benchmarks.h"
+
+#include "../test_manager.h"
+
+#include <memory/linear_allocator.h>
+
+#define ALLOCATION_COUNT 1024
+#define ALLOCATION_SIZE 32
+
+static void linear_allocator_benchmark_allocate(benchmark_state* state);
+
+void linear_allocator_register_benchmarks()
+{
+    test_manager_register_benchmark(linear_allocator_benchmark_allocate, "linear_allocator_allocate_1024");
+}
+
+void linear_allocator_benchmark_allocate(benchmark_state* state)
+{
+    benchmark_pause_timing(state);
+    Linear_Allocator allocator;
+    linear_allocator_create(ALLOCATION_COUNT * ALLOCATION_SIZE, &allocator);
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = ALLOCATION_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        for (u32 a = 0; a < ALLOCATION_COUNT; ++a)
+        {
+            void* block = linear_allocator_allocate(&allocator, ALLOCATION_SIZE);
+            BENCHMARK_DO_NOT_OPTIMIZE(block);
+        }
+
+        // Resetting also zeroes the whole block, so it is measured separately.
+        benchmark_pause_timing(state);
+        linear_allocator_free(&allocator);
+        benchmark_resume_timing(state);
+    }
+
+    benchmark_pause_timing(state);
+    linear_allocator_destroy(&allocator);
+    benchmark_resume_timing(state);
+}
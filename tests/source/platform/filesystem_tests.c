@@ -0,0 +1,93 @@
+#include "filesystem_tests.h"
+
+#include "../expect.h"
+#include "../test_fixtures.h"
+#include "../test_manager.h"
+
+#include <platform/filesystem.h>
+#include <systems/memory_system.h>
+
+#include <string.h>
+
+#define TEST_FILE_PATH "filesystem_test.bin"
+#define TEST_FILE_SIZE 4096
+// More requests than a batch keeps in flight at once, so that finished reads make room for queued ones.
+#define SLICE_REQUEST_COUNT 80
+
+static u8 contents[TEST_FILE_SIZE];
+static u8 buffers[SLICE_REQUEST_COUNT + 3][TEST_FILE_SIZE];
+
+static u8 filesystem_test_read_batch_completes_every_request();
+
+void filesystem_register_tests()
+{
+    test_manager_register_test(filesystem_test_read_batch_completes_every_request, "filesystem_test_read_batch_completes_every_request");
+}
+
+u8 filesystem_test_read_batch_completes_every_request()
+{
+    // The batch state is a memory_system allocation.
+    test_fixtures_start_memory_system(MEBIBYTES(1));
+
+    for (u32 i = 0; i < TEST_FILE_SIZE; ++i)
+    {
+        contents[i] = (u8)(i * 7 + i / 256);
+    }
+
+    File_Handle file;
+    expect_to_be_true(filesystem_open(TEST_FILE_PATH, FILE_ACCESS_MODE_WRITE_BINARY, &file));
+    expect_to_be_true(filesystem_write(&file, TEST_FILE_SIZE, contents));
+    filesystem_close(&file);
+
+    File_Read_Request requests[SLICE_REQUEST_COUNT + 3] = {};
+    requests[0].path = TEST_FILE_PATH;
+    requests[0].size = TEST_FILE_SIZE;
+    requests[1].path = TEST_FILE_PATH;
+    requests[1].size = 0;
+    requests[2].path = "filesystem_test_missing.bin";
+    requests[2].size = 16;
+    for (u32 i = 0; i < SLICE_REQUEST_COUNT; ++i)
+    {
+        requests[3 + i].path = TEST_FILE_PATH;
+        requests[3 + i].offset = i * 37;
+        requests[3 + i].size = 100 + i;
+    }
+
+    for (u32 i = 0; i < SLICE_REQUEST_COUNT + 3; ++i)
+    {
+        requests[i].buffer = buffers[i];
+    }
+
+    File_Read_Batch batch;
+    expect_to_be_true(filesystem_read_batch_submit(requests, SLICE_REQUEST_COUNT + 3, &batch));
+    u32 completed_count = filesystem_read_batch_poll(&batch);
+    expect_to_be_true(completed_count <= SLICE_REQUEST_COUNT + 3);
+
+    // The missing file fails the batch, but not the other requests.
+    expect_to_be_false(filesystem_read_batch_wait(&batch));
+
+    for (u32 i = 0; i < SLICE_REQUEST_COUNT + 3; ++i)
+    {
+        expect_to_be_true(requests[i].completed);
+    }
+
+    expect_to_be_true(requests[0].succeeded);
+    EXPECT_EQUAL(requests[0].bytes_read, TEST_FILE_SIZE);
+    expect_to_be_true(memcmp(buffers[0], contents, TEST_FILE_SIZE) == 0);
+
+    expect_to_be_true(requests[1].succeeded);
+    EXPECT_EQUAL(requests[1].bytes_read, 0);
+
+    expect_to_be_false(requests[2].succeeded);
+
+    for (u32 i = 0; i < SLICE_REQUEST_COUNT; ++i)
+    {
+        File_Read_Request const* request = &requests[3 + i];
+        expect_to_be_true(request->succeeded);
+        EXPECT_EQUAL(request->bytes_read, request->size);
+        expect_to_be_true(memcmp(request->buffer, contents + request->offset, request->size) == 0);
+    }
+
+    memory_system_shutdown();
+    return TRUE;
+}
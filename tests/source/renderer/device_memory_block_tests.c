@@ -0,0 +1,114 @@
+#include "device_memory_block_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <renderer/device_memory_block.h>
+
+static u8 device_memory_block_test_aligns_and_reuses_gaps();
+static u8 device_memory_block_test_keeps_kinds_on_separate_pages();
+static u8 device_memory_block_test_rejects_what_doesnt_fit();
+
+void device_memory_block_register_tests()
+{
+    test_manager_register_test(device_memory_block_test_aligns_and_reuses_gaps, "device_memory_block_test_aligns_and_reuses_gaps");
+    test_manager_register_test(device_memory_block_test_keeps_kinds_on_separate_pages, "device_memory_block_test_keeps_kinds_on_separate_pages");
+    test_manager_register_test(device_memory_block_test_rejects_what_doesnt_fit, "device_memory_block_test_rejects_what_doesnt_fit");
+}
+
+u8 device_memory_block_test_aligns_and_reuses_gaps()
+{
+    static Device_Memory_Block block;
+    expect_to_be_true(device_memory_block_create(1024, 1, &block));
+
+    u64 first;
+    u64 second;
+    u64 third;
+    expect_to_be_true(device_memory_block_allocate(&block, 100, 16, DEVICE_MEMORY_KIND_LINEAR, &first));
+    expect_to_be_true(device_memory_block_allocate(&block, 100, 256, DEVICE_MEMORY_KIND_LINEAR, &second));
+    expect_to_be_true(device_memory_block_allocate(&block, 50, 16, DEVICE_MEMORY_KIND_LINEAR, &third));
+    EXPECT_EQUAL(first, 0);
+    EXPECT_EQUAL(second, 256);
+    // First fit: the space skipped to align the second allocation is used.
+    EXPECT_EQUAL(third, 112);
+    EXPECT_EQUAL(block.used, 250);
+
+    // Freeing the first allocation joins its space with the gap after it.
+    expect_to_be_true(device_memory_block_free(&block, first));
+    u64 fourth;
+    expect_to_be_true(device_memory_block_allocate(&block, 112, 16, DEVICE_MEMORY_KIND_LINEAR, &fourth));
+    EXPECT_EQUAL(fourth, 0);
+
+    expect_to_be_false(device_memory_block_free(&block, 8));
+    expect_to_be_true(device_memory_block_free(&block, second));
+    expect_to_be_true(device_memory_block_free(&block, third));
+    expect_to_be_true(device_memory_block_free(&block, fourth));
+    EXPECT_EQUAL(block.allocation_count, 0);
+    EXPECT_EQUAL(block.used, 0);
+    return TRUE;
+}
+
+u8 device_memory_block_test_keeps_kinds_on_separate_pages()
+{
+    static Device_Memory_Block block;
+    expect_to_be_true(device_memory_block_create(4096, 1024, &block));
+
+    // An image after a buffer starts on the next page, while allocations of the same kind share pages.
+    u64 buffer;
+    u64 image;
+    u64 other_buffer;
+    u64 other_image;
+    expect_to_be_true(device_memory_block_allocate(&block, 100, 16, DEVICE_MEMORY_KIND_LINEAR, &buffer));
+    expect_to_be_true(device_memory_block_allocate(&block, 100, 16, DEVICE_MEMORY_KIND_OPTIMAL, &image));
+    expect_to_be_true(device_memory_block_allocate(&block, 100, 16, DEVICE_MEMORY_KIND_LINEAR, &other_buffer));
+    expect_to_be_true(device_memory_block_allocate(&block, 100, 16, DEVICE_MEMORY_KIND_OPTIMAL, &other_image));
+    EXPECT_EQUAL(buffer, 0);
+    EXPECT_EQUAL(image, 1024);
+    EXPECT_EQUAL(other_buffer, 112);
+    EXPECT_EQUAL(other_image, 1136);
+
+    // A gap that ends on a page of an image only takes a buffer that ends before that page.
+    static Device_Memory_Block images;
+    expect_to_be_true(device_memory_block_create(4096, 1024, &images));
+    u64 first_image;
+    u64 second_image;
+    expect_to_be_true(device_memory_block_allocate(&images, 1100, 16, DEVICE_MEMORY_KIND_OPTIMAL, &first_image));
+    expect_to_be_true(device_memory_block_allocate(&images, 100, 16, DEVICE_MEMORY_KIND_OPTIMAL, &second_image));
+    EXPECT_EQUAL(second_image, 1104);
+    expect_to_be_true(device_memory_block_free(&images, first_image));
+
+    u64 large_buffer;
+    u64 small_buffer;
+    expect_to_be_true(device_memory_block_allocate(&images, 1050, 16, DEVICE_MEMORY_KIND_LINEAR, &large_buffer));
+    expect_to_be_true(device_memory_block_allocate(&images, 100, 16, DEVICE_MEMORY_KIND_LINEAR, &small_buffer));
+    EXPECT_EQUAL(large_buffer, 2048);
+    EXPECT_EQUAL(small_buffer, 0);
+    return TRUE;
+}
+
+u8 device_memory_block_test_rejects_what_doesnt_fit()
+{
+    static Device_Memory_Block block;
+    expect_to_be_false(device_memory_block_create(1024, 3, &block));
+    expect_to_be_true(device_memory_block_create(1024, 1, &block));
+
+    u64 offset;
+    expect_to_be_false(device_memory_block_allocate(&block, 1025, 1, DEVICE_MEMORY_KIND_LINEAR, &offset));
+    expect_to_be_false(device_memory_block_allocate(&block, 16, 3, DEVICE_MEMORY_KIND_LINEAR, &offset));
+    expect_to_be_true(device_memory_block_allocate(&block, 1000, 1, DEVICE_MEMORY_KIND_LINEAR, &offset));
+
+    // 24 bytes are left, but not at an alignment of 64.
+    expect_to_be_false(device_memory_block_allocate(&block, 16, 64, DEVICE_MEMORY_KIND_LINEAR, &offset));
+    expect_to_be_true(device_memory_block_allocate(&block, 16, 8, DEVICE_MEMORY_KIND_LINEAR, &offset));
+    EXPECT_EQUAL(offset, 1000);
+
+    // Every allocation takes a slot, however small.
+    static Device_Memory_Block small_block;
+    expect_to_be_true(device_memory_block_create(DEVICE_MEMORY_BLOCK_MAX_ALLOCATIONS + 1, 1, &small_block));
+    for (u32 i = 0; i < DEVICE_MEMORY_BLOCK_MAX_ALLOCATIONS; ++i)
+    {
+        expect_to_be_true(device_memory_block_allocate(&small_block, 1, 1, DEVICE_MEMORY_KIND_LINEAR, &offset));
+    }
+    expect_to_be_false(device_memory_block_allocate(&small_block, 1, 1, DEVICE_MEMORY_KIND_LINEAR, &offset));
+    return TRUE;
+}
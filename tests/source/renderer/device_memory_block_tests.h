@@ -0,0 +1,3 @@
+#pragma once
+
+void device_memory_block_register_tests();
@@ -0,0 +1,99 @@
+#include "staging_ring_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <renderer/staging_ring.h>
+
+static u8 staging_ring_test_wraps_and_reuses_retired_space();
+static u8 staging_ring_test_releases_follow_allocation_order();
+
+void staging_ring_register_tests()
+{
+    test_manager_register_test(staging_ring_test_wraps_and_reuses_retired_space, "staging_ring_test_wraps_and_reuses_retired_space");
+    test_manager_register_test(staging_ring_test_releases_follow_allocation_order, "staging_ring_test_releases_follow_allocation_order");
+}
+
+u8 staging_ring_test_wraps_and_reuses_retired_space()
+{
+    static u8 memory[256];
+    Staging_Ring ring;
+    expect_to_be_true(staging_ring_create(sizeof(memory), 16, &ring));
+
+    Staging_Region first;
+    Staging_Region second;
+    Staging_Region third;
+    Staging_Region fourth;
+    expect_to_be_true(staging_ring_allocate(&ring, 100, memory, &first));
+    expect_to_be_true(staging_ring_allocate(&ring, 100, memory, &second));
+    EXPECT_EQUAL(first.offset, 0);
+    EXPECT_EQUAL(second.offset, 112);
+    expect_to_be_true(second.memory == memory + 112);
+
+    // Only 32 bytes are left before the end and the start is still in use.
+    expect_to_be_false(staging_ring_allocate(&ring, 64, memory, &third));
+    EXPECT_NOT_EQUAL(staging_ring_release(&ring, &first), INVALID_ID);
+    expect_to_be_false(staging_ring_allocate(&ring, 64, memory, &third));
+    staging_ring_retire_oldest(&ring);
+
+    // Wraps to the start, skipping the short tail of the ring.
+    expect_to_be_true(staging_ring_allocate(&ring, 64, memory, &third));
+    EXPECT_EQUAL(third.offset, 0);
+    expect_to_be_true(staging_ring_allocate(&ring, 48, memory, &fourth));
+    EXPECT_EQUAL(fourth.offset, 64);
+    EXPECT_EQUAL(ring.used, ring.capacity);
+
+    Staging_Region extra;
+    expect_to_be_false(staging_ring_allocate(&ring, 16, memory, &extra));
+
+    EXPECT_NOT_EQUAL(staging_ring_release(&ring, &second), INVALID_ID);
+    EXPECT_NOT_EQUAL(staging_ring_release(&ring, &third), INVALID_ID);
+    EXPECT_NOT_EQUAL(staging_ring_release(&ring, &fourth), INVALID_ID);
+    while (staging_ring_oldest_release(&ring) != INVALID_ID)
+    {
+        staging_ring_retire_oldest(&ring);
+    }
+
+    EXPECT_EQUAL(ring.used, 0);
+    expect_to_be_true(staging_ring_allocate(&ring, sizeof(memory), memory, &extra));
+    EXPECT_EQUAL(extra.offset, 0);
+    expect_to_be_false(staging_ring_allocate(&ring, sizeof(memory) + 1, memory, &extra));
+    return TRUE;
+}
+
+u8 staging_ring_test_releases_follow_allocation_order()
+{
+    Staging_Ring ring;
+    expect_to_be_true(staging_ring_create(64 * 1024, 16, &ring));
+
+    Staging_Region first;
+    Staging_Region second;
+    expect_to_be_true(staging_ring_allocate(&ring, 16, 0, &first));
+    expect_to_be_true(staging_ring_allocate(&ring, 16, 0, &second));
+    expect_to_be_true(first.memory == 0);
+
+    EXPECT_EQUAL(staging_ring_release(&ring, &second), INVALID_ID);
+    u32 first_slot = staging_ring_release(&ring, &first);
+    u32 second_slot = staging_ring_release(&ring, &second);
+    EXPECT_NOT_EQUAL(first_slot, INVALID_ID);
+    EXPECT_NOT_EQUAL(second_slot, INVALID_ID);
+    EXPECT_EQUAL(staging_ring_oldest_release(&ring), first_slot);
+    staging_ring_retire_oldest(&ring);
+    EXPECT_EQUAL(staging_ring_oldest_release(&ring), second_slot);
+    staging_ring_retire_oldest(&ring);
+    EXPECT_EQUAL(staging_ring_oldest_release(&ring), INVALID_ID);
+
+    // Once every release slot waits for its upload, further releases fail until the oldest is retired.
+    Staging_Region region;
+    for (u32 i = 0; i < STAGING_RING_MAX_RELEASES; ++i)
+    {
+        expect_to_be_true(staging_ring_allocate(&ring, 16, 0, &region));
+        EXPECT_NOT_EQUAL(staging_ring_release(&ring, &region), INVALID_ID);
+    }
+
+    expect_to_be_true(staging_ring_allocate(&ring, 16, 0, &region));
+    EXPECT_EQUAL(staging_ring_release(&ring, &region), INVALID_ID);
+    staging_ring_retire_oldest(&ring);
+    EXPECT_NOT_EQUAL(staging_ring_release(&ring, &region), INVALID_ID);
+    return TRUE;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void staging_ring_register_tests();
@@ -0,0 +1,92 @@
+#include "block_compression_benchmarks.h"
+
+#include "../test_manager.h"
+
+#include <core/logger.h>
+#include <resources/block_compression.h>
+#include <systems/memory_system.h>
+
+// A 1K image of gradients and texture-like noise. The benchmarks don't start the job system, so the encoders run on
+// one thread and items_per_second is pixels per second per core.
+#define IMAGE_WIDTH 1024
+#define IMAGE_HEIGHT 1024
+#define PIXEL_COUNT ((u64)IMAGE_WIDTH * IMAGE_HEIGHT)
+
+typedef struct Encode_Images
+{
+    b8 loaded;
+    u8* rgba;
+    u8* blocks;
+    u8* decoded;
+} Encode_Images;
+
+static Encode_Images images;
+
+static void load_images();
+static void run_encode(benchmark_state* state, Texture_Format format, Block_Compression_Quality quality);
+
+#define DEFINE_ENCODE_BENCHMARK(name, format, quality)                                 \
+    static void block_compression_benchmark_##name(benchmark_state* state)           \
+    {                                                                                  \
+        run_encode(state, format, quality);                                            \
+    }
+
+DEFINE_ENCODE_BENCHMARK(bc1_fast, TEXTURE_FORMAT_BC1, BLOCK_COMPRESSION_QUALITY_FAST)
+DEFINE_ENCODE_BENCHMARK(bc1_high, TEXTURE_FORMAT_BC1, BLOCK_COMPRESSION_QUALITY_HIGH)
+DEFINE_ENCODE_BENCHMARK(bc3_fast, TEXTURE_FORMAT_BC3, BLOCK_COMPRESSION_QUALITY_FAST)
+DEFINE_ENCODE_BENCHMARK(bc7_fast, TEXTURE_FORMAT_BC7, BLOCK_COMPRESSION_QUALITY_FAST)
+DEFINE_ENCODE_BENCHMARK(bc7_normal, TEXTURE_FORMAT_BC7, BLOCK_COMPRESSION_QUALITY_NORMAL)
+DEFINE_ENCODE_BENCHMARK(bc7_high, TEXTURE_FORMAT_BC7, BLOCK_COMPRESSION_QUALITY_HIGH)
+
+void block_compression_register_benchmarks()
+{
+    // items_per_second in the report is pixels per second. The PSNR of each is logged when it starts.
+    test_manager_register_benchmark(block_compression_benchmark_bc1_fast, "block_compression_encode_bc1_fast_1k");
+    test_manager_register_benchmark(block_compression_benchmark_bc1_high, "block_compression_encode_bc1_high_1k");
+    test_manager_register_benchmark(block_compression_benchmark_bc3_fast, "block_compression_encode_bc3_fast_1k");
+    test_manager_register_benchmark(block_compression_benchmark_bc7_fast, "block_compression_encode_bc7_fast_1k");
+    test_manager_register_benchmark(block_compression_benchmark_bc7_normal, "block_compression_encode_bc7_normal_1k");
+    test_manager_register_benchmark(block_compression_benchmark_bc7_high, "block_compression_encode_bc7_high_1k");
+}
+
+void run_encode(benchmark_state* state, Texture_Format format, Block_Compression_Quality quality)
+{
+    benchmark_pause_timing(state);
+    load_images();
+    block_compression_encode(images.rgba, IMAGE_WIDTH, IMAGE_HEIGHT, 1, format, quality, images.blocks);
+    block_compression_decode(images.blocks, IMAGE_WIDTH, IMAGE_HEIGHT, 1, format, images.decoded);
+    LOG_INFO("run_encode: Format %u at quality %u has a PSNR of %.2f dB", format, quality, block_compression_psnr(images.rgba, images.decoded, PIXEL_COUNT));
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = PIXEL_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        block_compression_encode(images.rgba, IMAGE_WIDTH, IMAGE_HEIGHT, 1, format, quality, images.blocks);
+        BENCHMARK_CLOBBER();
+    }
+}
+
+void load_images()
+{
+    if (images.loaded)
+    {
+        return;
+    }
+
+    images.rgba = memory_system_allocate(PIXEL_COUNT * 4, MEMORY_TAG_TEXTURE);
+    images.blocks = memory_system_allocate(PIXEL_COUNT, MEMORY_TAG_TEXTURE);
+    images.decoded = memory_system_allocate(PIXEL_COUNT * 4, MEMORY_TAG_TEXTURE);
+
+    u32 seed = 1;
+    for (u64 i = 0; i < PIXEL_COUNT; ++i)
+    {
+        u32 x = (u32)(i % IMAGE_WIDTH);
+        u32 y = (u32)(i / IMAGE_WIDTH);
+        seed = seed * 1664525 + 1013904223;
+        u32 noise = (seed >> 24) & 15;
+        u8 pixel[4] = { (u8)(x / 4 + noise), (u8)(y / 4 + noise), (u8)(((x / 16) ^ (y / 16)) * 8), 255 };
+        memory_system_copy(images.rgba + i * 4, pixel, 4);
+    }
+
+    images.loaded = TRUE;
+}
@@ -0,0 +1,319 @@
+#include "block_compression_tests.h"
+
+#include "expect.h"
+#include "test_manager.h"
+
+#include <resources/block_compression.h>
+#include <resources/mip_chain.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+// Sizes that aren't multiples of 4, so the edge blocks repeat texels.
+#define IMAGE_WIDTH 70
+#define IMAGE_HEIGHT 46
+
+static u8* create_test_chain(u32* mip_count, u64* size);
+static f64 round_trip_psnr(u8 const* chain, u32 mip_count, u64 size, Texture_Format format, Block_Compression_Quality quality);
+
+static u8 block_compression_test_layout();
+static u8 block_compression_test_choose_format();
+static u8 block_compression_test_solid_colour();
+static u8 block_compression_test_bc1_punchthrough();
+static u8 block_compression_test_psnr();
+static u8 block_compression_test_quality_tiers();
+static u8 block_compression_test_has_transparency();
+static u8 block_compression_test_can_decode();
+static u8 block_compression_test_copy_region();
+
+void block_compression_register_tests()
+{
+    test_manager_register_test(block_compression_test_layout, "block_compression_test_layout");
+    test_manager_register_test(block_compression_test_choose_format, "block_compression_test_choose_format");
+    test_manager_register_test(block_compression_test_solid_colour, "block_compression_test_solid_colour");
+    test_manager_register_test(block_compression_test_bc1_punchthrough, "block_compression_test_bc1_punchthrough");
+    test_manager_register_test(block_compression_test_psnr, "block_compression_test_psnr");
+    test_manager_register_test(block_compression_test_quality_tiers, "block_compression_test_quality_tiers");
+    test_manager_register_test(block_compression_test_has_transparency, "block_compression_test_has_transparency");
+    test_manager_register_test(block_compression_test_can_decode, "block_compression_test_can_decode");
+    test_manager_register_test(block_compression_test_copy_region, "block_compression_test_copy_region");
+}
+
+u8* create_test_chain(u32* mip_count, u64* size)
+{
+    // Smooth gradients with a little noise and a varying alpha, down to a 1x1 level.
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    *mip_count = mip_chain_layout(IMAGE_WIDTH, IMAGE_HEIGHT, 0, mips);
+    *size = mip_chain_size(IMAGE_WIDTH, IMAGE_HEIGHT, *mip_count);
+    u8* chain = malloc(*size);
+
+    u32 seed = 12345;
+    for (u32 level = 0; level < *mip_count; ++level)
+    {
+        u8* pixels = chain + mips[level].offset;
+        for (u32 y = 0; y < mips[level].height; ++y)
+        {
+            for (u32 x = 0; x < mips[level].width; ++x)
+            {
+                seed = seed * 1664525 + 1013904223;
+                u32 noise = (seed >> 24) & 7;
+                u8* pixel = pixels + ((u64)y * mips[level].width + x) * 4;
+                pixel[0] = (u8)(x * 255 / mips[level].width + noise);
+                pixel[1] = (u8)(y * 200 / mips[level].height + noise);
+                pixel[2] = (u8)(128 + (x + y) % 64);
+                pixel[3] = (u8)(255 - x * 2);
+            }
+        }
+    }
+
+    return chain;
+}
+
+f64 round_trip_psnr(u8 const* chain, u32 mip_count, u64 size, Texture_Format format, Block_Compression_Quality quality)
+{
+    u8* blocks = malloc(block_compression_chain_size(format, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count));
+    u8* decoded = malloc(size);
+    block_compression_encode(chain, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count, format, quality, blocks);
+    block_compression_decode(blocks, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count, format, decoded);
+
+    // The small levels are mostly noise, so only the base level is measured.
+    f64 psnr = block_compression_psnr(chain, decoded, (u64)IMAGE_WIDTH * IMAGE_HEIGHT);
+
+    free(decoded);
+    free(blocks);
+    return psnr;
+}
+
+u8 block_compression_test_layout()
+{
+    EXPECT_EQUAL(block_compression_block_size(TEXTURE_FORMAT_RGBA8), 0);
+    EXPECT_EQUAL(block_compression_block_size(TEXTURE_FORMAT_BC1), 8);
+    EXPECT_EQUAL(block_compression_block_size(TEXTURE_FORMAT_BC3), 16);
+    EXPECT_EQUAL(block_compression_block_size(TEXTURE_FORMAT_BC7), 16);
+
+    // 5x3 is 2x1 blocks, then 2x1 and 1x1 levels take a block each.
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 mip_count = block_compression_layout(TEXTURE_FORMAT_BC1, 5, 3, 64, mips);
+    EXPECT_EQUAL(mip_count, 3);
+    EXPECT_EQUAL(mips[0].offset, 64);
+    EXPECT_EQUAL(mips[0].size, 16);
+    EXPECT_EQUAL(mips[1].width, 2);
+    EXPECT_EQUAL(mips[1].offset, 80);
+    EXPECT_EQUAL(mips[1].size, 8);
+    EXPECT_EQUAL(mips[2].offset, 96);
+    EXPECT_EQUAL(block_compression_chain_size(TEXTURE_FORMAT_BC1, 5, 3, 3), 40);
+    EXPECT_EQUAL(block_compression_chain_size(TEXTURE_FORMAT_BC7, 5, 3, 1), 32);
+
+    // RGBA8 is laid out like any other mip chain.
+    Cooked_Mip rgba_mips[COOKED_TEXTURE_MAX_MIPS];
+    mip_count = block_compression_layout(TEXTURE_FORMAT_RGBA8, 37, 9, 16, mips);
+    EXPECT_EQUAL(mip_count, mip_chain_layout(37, 9, 16, rgba_mips));
+    for (u32 i = 0; i < mip_count; ++i)
+    {
+        EXPECT_EQUAL(mips[i].offset, rgba_mips[i].offset);
+        EXPECT_EQUAL(mips[i].size, rgba_mips[i].size);
+    }
+    EXPECT_EQUAL(block_compression_chain_size(TEXTURE_FORMAT_RGBA8, 37, 9, 4), mip_chain_size(37, 9, 4));
+    return TRUE;
+}
+
+u8 block_compression_test_choose_format()
+{
+    EXPECT_EQUAL(block_compression_choose_format(TEXTURE_FORMAT_BC1, false), TEXTURE_FORMAT_BC1);
+    EXPECT_EQUAL(block_compression_choose_format(TEXTURE_FORMAT_BC1, true), TEXTURE_FORMAT_BC3);
+    EXPECT_EQUAL(block_compression_choose_format(TEXTURE_FORMAT_BC7, true), TEXTURE_FORMAT_BC7);
+    EXPECT_EQUAL(block_compression_choose_format(TEXTURE_FORMAT_RGBA8, true), TEXTURE_FORMAT_RGBA8);
+    return TRUE;
+}
+
+u8 block_compression_test_solid_colour()
+{
+    // The colour is exact in 565. BC7 shares a p-bit between the colour and the opaque alpha, so it may be a level off.
+    u8 pixels[6 * 5 * 4];
+    u8 const colour[4] = { 66, 130, 206, 255 };
+    for (u32 i = 0; i < sizeof(pixels); ++i)
+    {
+        pixels[i] = colour[i % 4];
+    }
+
+    Texture_Format const formats[] = { TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3, TEXTURE_FORMAT_BC7 };
+    for (u32 f = 0; f < 3; ++f)
+    {
+        for (u32 quality = BLOCK_COMPRESSION_QUALITY_FAST; quality <= BLOCK_COMPRESSION_QUALITY_HIGH; ++quality)
+        {
+            u8 blocks[4 * 16];
+            u8 decoded[sizeof(pixels)];
+            block_compression_encode(pixels, 6, 5, 1, formats[f], quality, blocks);
+            block_compression_decode(blocks, 6, 5, 1, formats[f], decoded);
+            for (u32 i = 0; i < sizeof(pixels); ++i)
+            {
+                i32 tolerance = formats[f] == TEXTURE_FORMAT_BC7 ? 1 : 0;
+                expect_to_be_true(abs((i32)decoded[i] - (i32)pixels[i]) <= tolerance);
+            }
+        }
+    }
+    return TRUE;
+}
+
+u8 block_compression_test_bc1_punchthrough()
+{
+    // Texels under half alpha come back transparent black, the rest opaque.
+    u8 pixels[4 * 4 * 4];
+    for (u32 i = 0; i < 16; ++i)
+    {
+        pixels[i * 4 + 0] = (u8)(i * 16);
+        pixels[i * 4 + 1] = 40;
+        pixels[i * 4 + 2] = (u8)(255 - i * 16);
+        pixels[i * 4 + 3] = i % 3 == 0 ? 20 : 230;
+    }
+
+    u8 block[8];
+    u8 decoded[sizeof(pixels)];
+    block_compression_encode(pixels, 4, 4, 1, TEXTURE_FORMAT_BC1, BLOCK_COMPRESSION_QUALITY_NORMAL, block);
+    block_compression_decode(block, 4, 4, 1, TEXTURE_FORMAT_BC1, decoded);
+    for (u32 i = 0; i < 16; ++i)
+    {
+        if (i % 3 == 0)
+        {
+            EXPECT_EQUAL(decoded[i * 4 + 0], 0);
+            EXPECT_EQUAL(decoded[i * 4 + 3], 0);
+        }
+        else
+        {
+            EXPECT_EQUAL(decoded[i * 4 + 3], 255);
+            expect_to_be_true(abs((i32)decoded[i * 4] - (i32)pixels[i * 4]) < 40);
+        }
+    }
+    return TRUE;
+}
+
+u8 block_compression_test_psnr()
+{
+    u32 mip_count;
+    u64 size;
+    u8* chain = create_test_chain(&mip_count, &size);
+    EXPECT_EQUAL(mip_count, 7);
+    expect_to_be_true(block_compression_psnr(chain, chain, size / 4) >= 999.0);
+
+    // BC1 has no alpha to speak of, so it is checked on an opaque copy.
+    u8* opaque = malloc(size);
+    for (u64 i = 0; i < size; ++i)
+    {
+        opaque[i] = i % 4 == 3 ? 255 : chain[i];
+    }
+
+    expect_to_be_true(round_trip_psnr(opaque, mip_count, size, TEXTURE_FORMAT_BC1, BLOCK_COMPRESSION_QUALITY_NORMAL) > 37.0);
+    expect_to_be_true(round_trip_psnr(chain, mip_count, size, TEXTURE_FORMAT_BC3, BLOCK_COMPRESSION_QUALITY_NORMAL) > 37.0);
+    expect_to_be_true(round_trip_psnr(chain, mip_count, size, TEXTURE_FORMAT_BC7, BLOCK_COMPRESSION_QUALITY_NORMAL) > 38.0);
+
+    free(opaque);
+    free(chain);
+    return TRUE;
+}
+
+u8 block_compression_test_quality_tiers()
+{
+    // Each tier starts from the endpoints the one below ends with and searches more, so on an opaque image it does no
+    // worse beyond the odd block where a refinement takes another path.
+    u32 mip_count;
+    u64 size;
+    u8* chain = create_test_chain(&mip_count, &size);
+    for (u64 i = 3; i < size; i += 4)
+    {
+        chain[i] = 255;
+    }
+
+    Texture_Format const formats[] = { TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC7 };
+    for (u32 f = 0; f < 2; ++f)
+    {
+        f64 fast = round_trip_psnr(chain, mip_count, size, formats[f], BLOCK_COMPRESSION_QUALITY_FAST);
+        f64 normal = round_trip_psnr(chain, mip_count, size, formats[f], BLOCK_COMPRESSION_QUALITY_NORMAL);
+        f64 high = round_trip_psnr(chain, mip_count, size, formats[f], BLOCK_COMPRESSION_QUALITY_HIGH);
+        expect_to_be_true(normal >= fast - 0.05);
+        expect_to_be_true(high >= normal - 0.05);
+    }
+
+    free(chain);
+    return TRUE;
+}
+
+u8 block_compression_test_has_transparency()
+{
+    // An opaque 8x4 image, then the same with one translucent texel in the second block.
+    u8 pixels[8 * 4 * 4];
+    for (u32 i = 0; i < 8 * 4; ++i)
+    {
+        pixels[i * 4 + 0] = (u8)(i * 8);
+        pixels[i * 4 + 1] = 90;
+        pixels[i * 4 + 2] = (u8)(255 - i * 8);
+        pixels[i * 4 + 3] = 255;
+    }
+
+    Texture_Format const formats[] = { TEXTURE_FORMAT_BC1, TEXTURE_FORMAT_BC3, TEXTURE_FORMAT_BC7 };
+    for (u32 f = 0; f < 3; ++f)
+    {
+        u8 blocks[2 * 16];
+        pixels[(1 * 8 + 6) * 4 + 3] = 255;
+        block_compression_encode(pixels, 8, 4, 1, formats[f], BLOCK_COMPRESSION_QUALITY_FAST, blocks);
+        expect_to_be_false(block_compression_has_transparency(blocks, 8, 4, formats[f]));
+
+        pixels[(1 * 8 + 6) * 4 + 3] = 0;
+        block_compression_encode(pixels, 8, 4, 1, formats[f], BLOCK_COMPRESSION_QUALITY_FAST, blocks);
+        expect_to_be_true(block_compression_has_transparency(blocks, 8, 4, formats[f]));
+    }
+    return TRUE;
+}
+
+u8 block_compression_test_can_decode()
+{
+    u32 mip_count;
+    u64 size;
+    u8* chain = create_test_chain(&mip_count, &size);
+    u64 blocks_size = block_compression_chain_size(TEXTURE_FORMAT_BC7, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count);
+    u8* blocks = malloc(blocks_size);
+
+    // Whatever the encoder writes decodes, but a block in a mode it never uses, here mode 5, doesn't.
+    block_compression_encode(chain, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count, TEXTURE_FORMAT_BC7, BLOCK_COMPRESSION_QUALITY_HIGH, blocks);
+    expect_to_be_true(block_compression_can_decode(blocks, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count, TEXTURE_FORMAT_BC7));
+    blocks[blocks_size - 16] = 0x20;
+    expect_to_be_false(block_compression_can_decode(blocks, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count, TEXTURE_FORMAT_BC7));
+    expect_to_be_true(block_compression_can_decode(blocks, IMAGE_WIDTH, IMAGE_HEIGHT, mip_count - 1, TEXTURE_FORMAT_BC7));
+
+    free(blocks);
+    free(chain);
+    return TRUE;
+}
+
+u8 block_compression_test_copy_region()
+{
+    u32 mip_count;
+    u64 size;
+    u8* chain = create_test_chain(&mip_count, &size);
+    u8 region[8 * 8 * 4];
+
+    // Texel rows of RGBA8 are packed one after another.
+    u64 written = block_compression_copy_region(TEXTURE_FORMAT_RGBA8, chain, IMAGE_WIDTH, 2, 3, 5, 4, region);
+    EXPECT_EQUAL(5 * 4 * 4, written);
+    for (u32 y = 0; y < 4; ++y)
+    {
+        expect_to_be_true(memcmp(region + y * 5 * 4, chain + ((3 + y) * IMAGE_WIDTH + 2) * 4, 5 * 4) == 0);
+    }
+
+    // Block formats copy rows of blocks, and a region reaching the edge of the level takes its partial blocks.
+    u32 blocks_x = (IMAGE_WIDTH + 3) / 4;
+    u64 blocks_size = block_compression_chain_size(TEXTURE_FORMAT_BC1, IMAGE_WIDTH, IMAGE_HEIGHT, 1);
+    u8* blocks = malloc(blocks_size);
+    block_compression_encode(chain, IMAGE_WIDTH, IMAGE_HEIGHT, 1, TEXTURE_FORMAT_BC1, BLOCK_COMPRESSION_QUALITY_FAST, blocks);
+    written = block_compression_copy_region(TEXTURE_FORMAT_BC1, blocks, IMAGE_WIDTH, 4, 8, 8, 8, region);
+    EXPECT_EQUAL(2 * 2 * 8, written);
+    expect_to_be_true(memcmp(region, blocks + (2 * blocks_x + 1) * 8, 2 * 8) == 0);
+    expect_to_be_true(memcmp(region + 2 * 8, blocks + (3 * blocks_x + 1) * 8, 2 * 8) == 0);
+
+    written = block_compression_copy_region(TEXTURE_FORMAT_BC1, blocks, IMAGE_WIDTH, 68, 44, 2, 2, region);
+    EXPECT_EQUAL(8, written);
+    expect_to_be_true(memcmp(region, blocks + (11 * blocks_x + 17) * 8, 8) == 0);
+
+    free(blocks);
+    free(chain);
+    return TRUE;
+}
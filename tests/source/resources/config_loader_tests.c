@@ -0,0 +1,77 @@
+#include "config_loader_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <resources/loaders/material_loader.h>
+#include <resources/loaders/shader_config_loader.h>
+
+#include <string.h>
+
+static char const material_json[] =
+    "{ \"version\": \"0.1\", \"name\": \"test_material\", \"diffuse_color\": [ 1.0, 0.5, 0.25, 1.0 ],"
+    "  \"diffuse_map_name\": \"paving\", \"type\": \"ui\", \"auto_release\": true }";
+
+static char const shader_config_json[] =
+    "{ \"name\": \"builtin_material\", \"renderpass\": \"renderpass_builtin_world\","
+    "  \"stages\": [ \"vertex\", \"fragment\" ], \"spv_binaries\": [ \"vert.spv\", \"frag.spv\" ],"
+    "  \"attributes\": { \"in_position\": \"vec3\", \"in_texcoord\": \"vec2\" },"
+    "  \"per-material\": true, \"per-object\": false, \"max-descriptor-sets\": 256,"
+    "  \"uniforms\": [ { \"view\": \"mat4\", \"projection\": \"mat4\" }, { \"diffuse_colour\": \"vec4\", \"diffuse_sampler\": \"sampler\" } ] }";
+
+static Material_Config_Resource material;
+static Shader_Config_Resource shader_config;
+
+static u8 config_loader_test_parses_material();
+static u8 config_loader_test_parses_shader_config();
+static u8 config_loader_test_rejects_invalid_configs();
+
+void config_loader_register_tests()
+{
+    test_manager_register_test(config_loader_test_parses_material, "config_loader_test_parses_material");
+    test_manager_register_test(config_loader_test_parses_shader_config, "config_loader_test_parses_shader_config");
+    test_manager_register_test(config_loader_test_rejects_invalid_configs, "config_loader_test_rejects_invalid_configs");
+}
+
+u8 config_loader_test_parses_material()
+{
+    expect_to_be_true(material_loader_parse(material_json, sizeof(material_json) - 1, &material));
+    expect_to_be_true(strcmp(material.name, "test_material") == 0);
+    expect_to_be_true(strcmp(material.diffuse_texture_name, "paving") == 0);
+    expect_float_to_be(0.25f, material.diffuse_color[2]);
+    EXPECT_EQUAL(MATERIAL_TYPE_UI, material.type);
+    EXPECT_EQUAL(1, material.auto_release);
+    return TRUE;
+}
+
+u8 config_loader_test_parses_shader_config()
+{
+    expect_to_be_true(shader_config_loader_parse(shader_config_json, sizeof(shader_config_json) - 1, &shader_config));
+    expect_to_be_true(strcmp(shader_config.renderpass_name, "renderpass_builtin_world") == 0);
+    EXPECT_EQUAL(2, shader_config.stage_count);
+    EXPECT_EQUAL(COOKED_SHADER_STAGE_FRAGMENT, shader_config.stages[1].stage);
+    expect_to_be_true(strcmp(shader_config.stages[1].spv_binary, "frag.spv") == 0);
+    EXPECT_EQUAL(2, shader_config.attribute_count);
+    EXPECT_EQUAL(COOKED_ATTRIBUTE_TYPE_VEC3, shader_config.attributes[0].type);
+    EXPECT_EQUAL(4, shader_config.uniform_count);
+    EXPECT_EQUAL(COOKED_UNIFORM_TYPE_SAMPLER, shader_config.uniforms[3].type);
+    EXPECT_EQUAL(1, shader_config.uniforms[3].scope);
+    EXPECT_EQUAL(1, shader_config.per_material);
+    EXPECT_EQUAL(0, shader_config.per_object);
+    EXPECT_EQUAL(256, shader_config.max_descriptor_set_count);
+    return TRUE;
+}
+
+u8 config_loader_test_rejects_invalid_configs()
+{
+    char const unknown_type[] = "{ \"version\": \"0.1\", \"name\": \"m\", \"diffuse_color\": [ 1, 1, 1, 1 ], \"diffuse_map_name\": \"t\", \"type\": \"sky\", \"auto_release\": true }";
+    char const short_color[] = "{ \"version\": \"0.1\", \"name\": \"m\", \"diffuse_color\": [ 1, 1 ], \"diffuse_map_name\": \"t\", \"type\": \"ui\", \"auto_release\": true }";
+    char const missing_binary[] = "{ \"name\": \"s\", \"renderpass\": \"r\", \"stages\": [ \"vertex\", \"fragment\" ], \"spv_binaries\": [ \"vert.spv\" ] }";
+    char const truncated[] = "{ \"name\": ";
+
+    expect_to_be_false(material_loader_parse(unknown_type, sizeof(unknown_type) - 1, &material));
+    expect_to_be_false(material_loader_parse(short_color, sizeof(short_color) - 1, &material));
+    expect_to_be_false(shader_config_loader_parse(missing_binary, sizeof(missing_binary) - 1, &shader_config));
+    expect_to_be_false(shader_config_loader_parse(truncated, sizeof(truncated) - 1, &shader_config));
+    return TRUE;
+}
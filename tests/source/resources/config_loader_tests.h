@@ -0,0 +1,3 @@
+#pragma once
+
+void config_loader_register_tests();
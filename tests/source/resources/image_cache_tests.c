@@ -0,0 +1,139 @@
+#include "image_cache_tests.h"
+
+#include "../expect.h"
+#include "../test_fixtures.h"
+#include "../test_manager.h"
+
+#include <platform/filesystem.h>
+#include <resources/cooked_format.h>
+#include <resources/image_cache.h>
+#include <systems/memory_system.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_DIRECTORY "image_cache_test"
+#define SOURCE_PATH TEST_DIRECTORY "/source.png"
+
+static u8 pixels[4 * 2 * 4];
+
+static bool start(bool generate_mips);
+static void stop();
+static bool write_source(char const* contents);
+
+static u8 image_cache_test_stores_mapped_mip_chain();
+static u8 image_cache_test_path_record_follows_source();
+
+void image_cache_register_tests()
+{
+    test_manager_register_test(image_cache_test_stores_mapped_mip_chain, "image_cache_test_stores_mapped_mip_chain");
+    test_manager_register_test(image_cache_test_path_record_follows_source, "image_cache_test_path_record_follows_source");
+}
+
+bool start(bool generate_mips)
+{
+    // Entries are built in memory_system allocations.
+    test_fixtures_start_memory_system(MEBIBYTES(16));
+
+    Image_Cache_Config config = {};
+    config.directory = TEST_DIRECTORY "/cache";
+    config.generate_mips = generate_mips;
+    return image_cache_startup(config);
+}
+
+void stop()
+{
+    image_cache_shutdown();
+    memory_system_shutdown();
+}
+
+bool write_source(char const* contents)
+{
+    File_Handle file;
+    if (!filesystem_open(SOURCE_PATH, FILE_ACCESS_MODE_WRITE_BINARY, &file))
+    {
+        return false;
+    }
+
+    bool result = filesystem_write(&file, strlen(contents), contents);
+    filesystem_close(&file);
+    return result;
+}
+
+u8 image_cache_test_stores_mapped_mip_chain()
+{
+    expect_to_be_true(start(true));
+
+    // A 4x2 image, opaque but for one texel.
+    memset(pixels, 255, sizeof(pixels));
+    pixels[7] = 0;
+    u64 source_hash = 0x1234;
+
+    File_View view;
+    expect_to_be_true(image_cache_store(source_hash, pixels, 4, 2, &view));
+    filesystem_unmap(&view);
+
+    expect_to_be_true(image_cache_find(source_hash, &view));
+    Cooked_Texture const* texture = view.data;
+    EXPECT_EQUAL(texture->width, 4);
+    EXPECT_EQUAL(texture->height, 2);
+    EXPECT_EQUAL(texture->mip_count, 3);
+    EXPECT_EQUAL(texture->mips[2].width, 1);
+    EXPECT_EQUAL(texture->mips[2].height, 1);
+    expect_to_be_true((texture->flags & COOKED_TEXTURE_FLAG_TRANSPARENT) != 0);
+    expect_to_be_true(memcmp((u8 const*)view.data + texture->mips[0].offset, pixels, sizeof(pixels)) == 0);
+    EXPECT_EQUAL(view.size, texture->mips[2].offset + texture->mips[2].size);
+    filesystem_unmap(&view);
+
+    // Another source hash is another entry.
+    expect_to_be_false(image_cache_find(source_hash + 1, &view));
+
+    Image_Cache_Stats stats;
+    image_cache_get_stats(&stats);
+    EXPECT_EQUAL(stats.stores, 1);
+    EXPECT_EQUAL(stats.content_hits, 1);
+    EXPECT_EQUAL(stats.misses, 1);
+
+    stop();
+
+    // Without mips, the same source is a separate entry of a single level.
+    expect_to_be_true(start(false));
+    expect_to_be_true(image_cache_store(source_hash, pixels, 4, 2, &view));
+    EXPECT_EQUAL(((Cooked_Texture const*)view.data)->mip_count, 1);
+    filesystem_unmap(&view);
+    stop();
+
+    expect_to_be_true(start(true));
+    expect_to_be_true(image_cache_find(source_hash, &view));
+    EXPECT_EQUAL(((Cooked_Texture const*)view.data)->mip_count, 3);
+    filesystem_unmap(&view);
+    stop();
+    return TRUE;
+}
+
+u8 image_cache_test_path_record_follows_source()
+{
+    expect_to_be_true(start(false));
+    expect_to_be_true(write_source("first"));
+
+    memset(pixels, 255, sizeof(pixels));
+    File_View view;
+    expect_to_be_true(image_cache_store(1, pixels, 4, 2, &view));
+    filesystem_unmap(&view);
+
+    image_cache_record_path(SOURCE_PATH, 1);
+    expect_to_be_true(image_cache_find_by_path(SOURCE_PATH, &view));
+    filesystem_unmap(&view);
+
+    // A changed size invalidates the record without hashing, and the caller falls back to the contents.
+    expect_to_be_true(write_source("second"));
+    expect_to_be_false(image_cache_find_by_path(SOURCE_PATH, &view));
+
+    Image_Cache_Stats stats;
+    image_cache_get_stats(&stats);
+    EXPECT_EQUAL(stats.path_hits, 1);
+
+    stop();
+    remove(SOURCE_PATH);
+    return TRUE;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void image_cache_register_tests();
@@ -0,0 +1,167 @@
+#include "image_kernels_benchmarks.h"
+
+#include "../test_manager.h"
+
+#include <core/logger.h>
+#include <resources/image_kernels.h>
+#include <systems/memory_system.h>
+
+// A 4K image. Only its last pixel is transparent, so the transparency scan reads all of it.
+#define IMAGE_WIDTH 3840
+#define IMAGE_HEIGHT 2160
+#define PIXEL_COUNT ((u64)IMAGE_WIDTH * IMAGE_HEIGHT)
+
+typedef struct Kernel_Images
+{
+    b8 loaded;
+    u8* rgba;
+    u8* rgb;
+    f32* linear;
+    u8* output;
+} Kernel_Images;
+
+static Kernel_Images images;
+
+static void load_images();
+static void run_has_transparency(benchmark_state* state, Image_Kernels_Isa isa);
+static void run_rgb_to_rgba(benchmark_state* state, Image_Kernels_Isa isa);
+static void run_linear_to_srgb(benchmark_state* state, Image_Kernels_Isa isa);
+static void run_premultiply_alpha(benchmark_state* state, Image_Kernels_Isa isa);
+static void run_swizzle(benchmark_state* state, Image_Kernels_Isa isa);
+
+// Every kernel is measured with the scalar fallback and with the best instruction set of the machine.
+#define DEFINE_ISA_BENCHMARKS(kernel)                                                  \
+    static void image_kernels_benchmark_##kernel##_scalar(benchmark_state* state)     \
+    {                                                                                  \
+        run_##kernel(state, IMAGE_KERNELS_ISA_SCALAR);                                 \
+    }                                                                                  \
+    static void image_kernels_benchmark_##kernel##_simd(benchmark_state* state)       \
+    {                                                                                  \
+        run_##kernel(state, IMAGE_KERNELS_ISA_ENUM_COUNT - 1);                         \
+    }
+
+DEFINE_ISA_BENCHMARKS(has_transparency)
+DEFINE_ISA_BENCHMARKS(rgb_to_rgba)
+DEFINE_ISA_BENCHMARKS(linear_to_srgb)
+DEFINE_ISA_BENCHMARKS(premultiply_alpha)
+DEFINE_ISA_BENCHMARKS(swizzle)
+
+void image_kernels_register_benchmarks()
+{
+    // items_per_second in the report is pixels per second.
+    test_manager_register_benchmark(image_kernels_benchmark_has_transparency_scalar, "image_kernels_has_transparency_4k_scalar");
+    test_manager_register_benchmark(image_kernels_benchmark_has_transparency_simd, "image_kernels_has_transparency_4k_simd");
+    test_manager_register_benchmark(image_kernels_benchmark_rgb_to_rgba_scalar, "image_kernels_rgb_to_rgba_4k_scalar");
+    test_manager_register_benchmark(image_kernels_benchmark_rgb_to_rgba_simd, "image_kernels_rgb_to_rgba_4k_simd");
+    test_manager_register_benchmark(image_kernels_benchmark_linear_to_srgb_scalar, "image_kernels_linear_to_srgb_4k_scalar");
+    test_manager_register_benchmark(image_kernels_benchmark_linear_to_srgb_simd, "image_kernels_linear_to_srgb_4k_simd");
+    test_manager_register_benchmark(image_kernels_benchmark_premultiply_alpha_scalar, "image_kernels_premultiply_alpha_4k_scalar");
+    test_manager_register_benchmark(image_kernels_benchmark_premultiply_alpha_simd, "image_kernels_premultiply_alpha_4k_simd");
+    test_manager_register_benchmark(image_kernels_benchmark_swizzle_scalar, "image_kernels_swizzle_4k_scalar");
+    test_manager_register_benchmark(image_kernels_benchmark_swizzle_simd, "image_kernels_swizzle_4k_simd");
+}
+
+void run_has_transparency(benchmark_state* state, Image_Kernels_Isa isa)
+{
+    benchmark_pause_timing(state);
+    load_images();
+    image_kernels_set_isa(isa);
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = PIXEL_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        bool has_transparency = image_kernels_has_transparency(images.rgba, PIXEL_COUNT);
+        BENCHMARK_DO_NOT_OPTIMIZE(has_transparency);
+    }
+}
+
+void run_rgb_to_rgba(benchmark_state* state, Image_Kernels_Isa isa)
+{
+    benchmark_pause_timing(state);
+    load_images();
+    image_kernels_set_isa(isa);
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = PIXEL_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        image_kernels_rgb_to_rgba(images.rgb, images.output, PIXEL_COUNT);
+        BENCHMARK_CLOBBER();
+    }
+}
+
+void run_linear_to_srgb(benchmark_state* state, Image_Kernels_Isa isa)
+{
+    benchmark_pause_timing(state);
+    load_images();
+    image_kernels_set_isa(isa);
+    benchmark_resume_timing(state);
+
+    state->items_per_iteration = PIXEL_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        image_kernels_linear_to_srgb(images.linear, images.output, PIXEL_COUNT);
+        BENCHMARK_CLOBBER();
+    }
+}
+
+void run_premultiply_alpha(benchmark_state* state, Image_Kernels_Isa isa)
+{
+    benchmark_pause_timing(state);
+    load_images();
+    image_kernels_set_isa(isa);
+    memory_system_copy(images.output, images.rgba, PIXEL_COUNT * 4);
+    benchmark_resume_timing(state);
+
+    // Premultiplying repeatedly keeps darkening the same image, which costs the same every time.
+    state->items_per_iteration = PIXEL_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        image_kernels_premultiply_alpha(images.output, PIXEL_COUNT);
+        BENCHMARK_CLOBBER();
+    }
+}
+
+void run_swizzle(benchmark_state* state, Image_Kernels_Isa isa)
+{
+    benchmark_pause_timing(state);
+    load_images();
+    image_kernels_set_isa(isa);
+    benchmark_resume_timing(state);
+
+    u8 const bgra_order[4] = { 2, 1, 0, 3 };
+    state->items_per_iteration = PIXEL_COUNT;
+    for (u64 i = 0; i < state->iterations; ++i)
+    {
+        image_kernels_swizzle(images.rgba, images.output, PIXEL_COUNT, bgra_order);
+        BENCHMARK_CLOBBER();
+    }
+}
+
+void load_images()
+{
+    if (images.loaded)
+    {
+        return;
+    }
+
+    images.rgba = memory_system_allocate(PIXEL_COUNT * 4, MEMORY_TAG_TEXTURE);
+    images.rgb = memory_system_allocate(PIXEL_COUNT * 3, MEMORY_TAG_TEXTURE);
+    images.linear = memory_system_allocate(PIXEL_COUNT * 4 * sizeof(f32), MEMORY_TAG_TEXTURE);
+    images.output = memory_system_allocate(PIXEL_COUNT * 4, MEMORY_TAG_TEXTURE);
+
+    for (u64 i = 0; i < PIXEL_COUNT; ++i)
+    {
+        u32 x = (u32)(i % IMAGE_WIDTH);
+        u32 y = (u32)(i / IMAGE_WIDTH);
+        u8 pixel[4] = { (u8)x, (u8)y, (u8)(x ^ y), 255 };
+        memory_system_copy(images.rgba + i * 4, pixel, 4);
+        memory_system_copy(images.rgb + i * 3, pixel, 3);
+    }
+    images.rgba[PIXEL_COUNT * 4 - 1] = 254;
+    image_kernels_srgb_to_linear(images.rgba, images.linear, PIXEL_COUNT);
+
+    LOG_INFO("load_images: SIMD image kernels use %s", image_kernels_isa_name(image_kernels_set_isa(IMAGE_KERNELS_ISA_ENUM_COUNT - 1)));
+    images.loaded = TRUE;
+}
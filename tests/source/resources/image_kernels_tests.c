@@ -0,0 +1,170 @@
+#include "image_kernels_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <resources/image_kernels.h>
+
+#include <string.h>
+
+// Enough pixels for a few full vectors of every instruction set plus each possible scalar tail.
+#define MAX_PIXEL_COUNT 75
+
+static u8 rgba[MAX_PIXEL_COUNT * 4];
+static u8 rgb[MAX_PIXEL_COUNT * 3];
+static f32 linear[MAX_PIXEL_COUNT * 4];
+static u8 expected[MAX_PIXEL_COUNT * 4];
+static u8 actual[MAX_PIXEL_COUNT * 4];
+static f32 linear_rows[5][MAX_PIXEL_COUNT * 4];
+static f32 filtered_expected[MAX_PIXEL_COUNT * 4];
+static f32 filtered_actual[MAX_PIXEL_COUNT * 4];
+
+static void fill_inputs();
+static u8 image_kernels_test_simd_matches_scalar();
+static u8 image_kernels_test_conversions_round();
+
+void image_kernels_register_tests()
+{
+    test_manager_register_test(image_kernels_test_simd_matches_scalar, "image_kernels_test_simd_matches_scalar");
+    test_manager_register_test(image_kernels_test_conversions_round, "image_kernels_test_conversions_round");
+}
+
+void fill_inputs()
+{
+    u32 seed = 12345;
+    for (u32 i = 0; i < MAX_PIXEL_COUNT * 4; ++i)
+    {
+        seed = seed * 1664525 + 1013904223;
+        rgba[i] = (u8)(seed >> 24);
+        // Covers out of range values and the low end, which the sRGB encoding treats separately.
+        linear[i] = (f32)(seed >> 8) / (1 << 24) * 1.2f - 0.1f;
+    }
+    for (u32 i = 0; i < MAX_PIXEL_COUNT * 3; ++i)
+    {
+        rgb[i] = (u8)(i * 7);
+    }
+    for (u32 r = 0; r < 5; ++r)
+    {
+        for (u32 i = 0; i < MAX_PIXEL_COUNT * 4; ++i)
+        {
+            linear_rows[r][i] = linear[(i + r * 13) % (MAX_PIXEL_COUNT * 4)];
+        }
+    }
+}
+
+u8 image_kernels_test_simd_matches_scalar()
+{
+    fill_inputs();
+    u8 const order[4] = { 2, 0, 3, 1 };
+    f32 const weights[5] = { -0.05f, 0.25f, 0.6f, 0.25f, -0.05f };
+    f32 const* rows[5] = { linear_rows[0], linear_rows[1], linear_rows[2], linear_rows[3], linear_rows[4] };
+    Image_Kernels_Isa original = image_kernels_get_isa();
+    for (u32 isa = IMAGE_KERNELS_ISA_SCALAR + 1; isa < IMAGE_KERNELS_ISA_ENUM_COUNT; ++isa)
+    {
+        for (u32 count = 0; count <= MAX_PIXEL_COUNT; ++count)
+        {
+            u8 opaque[MAX_PIXEL_COUNT * 4];
+            memset(opaque, 255, sizeof(opaque));
+            if (count > 0)
+            {
+                opaque[(count - 1) * 4 + 3] = 254;
+            }
+
+            image_kernels_set_isa(IMAGE_KERNELS_ISA_SCALAR);
+            bool expected_transparency = image_kernels_has_transparency(opaque, count);
+            bool expected_opaque = image_kernels_has_transparency(opaque, count ? count - 1 : 0);
+            image_kernels_set_isa(isa);
+            EXPECT_EQUAL(image_kernels_has_transparency(opaque, count), expected_transparency);
+            EXPECT_EQUAL(image_kernels_has_transparency(opaque, count ? count - 1 : 0), expected_opaque);
+
+            image_kernels_set_isa(IMAGE_KERNELS_ISA_SCALAR);
+            image_kernels_rgb_to_rgba(rgb, expected, count);
+            image_kernels_set_isa(isa);
+            image_kernels_rgb_to_rgba(rgb, actual, count);
+            EXPECT_EQUAL(memcmp(actual, expected, count * 4), 0);
+
+            image_kernels_set_isa(IMAGE_KERNELS_ISA_SCALAR);
+            image_kernels_linear_to_srgb(linear, expected, count);
+            image_kernels_set_isa(isa);
+            image_kernels_linear_to_srgb(linear, actual, count);
+            EXPECT_EQUAL(memcmp(actual, expected, count * 4), 0);
+
+            image_kernels_set_isa(IMAGE_KERNELS_ISA_SCALAR);
+            memcpy(expected, rgba, count * 4);
+            image_kernels_premultiply_alpha(expected, count);
+            image_kernels_set_isa(isa);
+            memcpy(actual, rgba, count * 4);
+            image_kernels_premultiply_alpha(actual, count);
+            EXPECT_EQUAL(memcmp(actual, expected, count * 4), 0);
+
+            // In place, as the destination may be the source.
+            image_kernels_set_isa(IMAGE_KERNELS_ISA_SCALAR);
+            image_kernels_swizzle(rgba, expected, count, order);
+            image_kernels_set_isa(isa);
+            memcpy(actual, rgba, count * 4);
+            image_kernels_swizzle(actual, actual, count, order);
+            EXPECT_EQUAL(memcmp(actual, expected, count * 4), 0);
+
+            // The filters may sum in another order or fuse, so they are only close to the scalar result.
+            image_kernels_set_isa(IMAGE_KERNELS_ISA_SCALAR);
+            image_kernels_blend_rows(rows, weights, 5, filtered_expected, count);
+            image_kernels_set_isa(isa);
+            image_kernels_blend_rows(rows, weights, 5, filtered_actual, count);
+            for (u32 i = 0; i < count * 4; ++i)
+            {
+                expect_float_to_be(filtered_expected[i], filtered_actual[i]);
+            }
+
+            // Each output reads two source pixels further, so a third of the pixels fits the source.
+            u32 downsampled_count = count / 3;
+            image_kernels_set_isa(IMAGE_KERNELS_ISA_SCALAR);
+            image_kernels_downsample_row(linear, weights, 5, filtered_expected, downsampled_count);
+            image_kernels_set_isa(isa);
+            image_kernels_downsample_row(linear, weights, 5, filtered_actual, downsampled_count);
+            for (u32 i = 0; i < downsampled_count * 4; ++i)
+            {
+                expect_float_to_be(filtered_expected[i], filtered_actual[i]);
+            }
+        }
+    }
+
+    image_kernels_set_isa(original);
+    return TRUE;
+}
+
+u8 image_kernels_test_conversions_round()
+{
+    // Every sRGB value survives the trip through linear.
+    u8 values[256 * 4];
+    f32 decoded[256 * 4];
+    u8 encoded[256 * 4];
+    for (u32 i = 0; i < 256 * 4; ++i)
+    {
+        values[i] = (u8)(i / 4);
+    }
+    image_kernels_srgb_to_linear(values, decoded, 256);
+    image_kernels_linear_to_srgb(decoded, encoded, 256);
+    EXPECT_EQUAL(memcmp(encoded, values, sizeof(values)), 0);
+    expect_float_to_be(decoded[255 * 4], 1.0f);
+    expect_float_to_be(decoded[128 * 4], 0.2158605f);
+
+    u8 pixels[] = {
+        200, 100, 1, 128,
+        255, 0, 77, 255,
+        255, 255, 255, 0
+    };
+    u8 const premultiplied[] = {
+        100, 50, 1, 128,
+        255, 0, 77, 255,
+        0, 0, 0, 0
+    };
+    image_kernels_premultiply_alpha(pixels, 3);
+    EXPECT_EQUAL(memcmp(pixels, premultiplied, sizeof(pixels)), 0);
+
+    u8 const bgra_order[4] = { 2, 1, 0, 3 };
+    u8 bgra[4];
+    image_kernels_swizzle(premultiplied, bgra, 1, bgra_order);
+    EXPECT_EQUAL(bgra[0], 1);
+    EXPECT_EQUAL(bgra[2], 100);
+    return TRUE;
+}
@@ -0,0 +1,191 @@
+#include "mip_chain_tests.h"
+
+#include "../expect.h"
+#include "../test_fixtures.h"
+#include "../test_manager.h"
+
+#include <resources/mip_chain.h>
+#include <systems/memory_system.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool near(u8 actual, u8 expected);
+
+static u8 mip_chain_test_layout();
+static u8 mip_chain_test_level_for_size();
+static u8 mip_chain_test_box_averages_in_linear_space();
+static u8 mip_chain_test_kaiser_keeps_flat_images();
+static u8 mip_chain_test_region_matches_whole_chain();
+
+void mip_chain_register_tests()
+{
+    test_manager_register_test(mip_chain_test_layout, "mip_chain_test_layout");
+    test_manager_register_test(mip_chain_test_level_for_size, "mip_chain_test_level_for_size");
+    test_manager_register_test(mip_chain_test_box_averages_in_linear_space, "mip_chain_test_box_averages_in_linear_space");
+    test_manager_register_test(mip_chain_test_kaiser_keeps_flat_images, "mip_chain_test_kaiser_keeps_flat_images");
+    test_manager_register_test(mip_chain_test_region_matches_whole_chain, "mip_chain_test_region_matches_whole_chain");
+}
+
+bool near(u8 actual, u8 expected)
+{
+    // The sRGB encoding is within one level of exact.
+    return abs((i32)actual - (i32)expected) <= 1;
+}
+
+u8 mip_chain_test_layout()
+{
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 mip_count = mip_chain_layout(5, 3, 64, mips);
+    EXPECT_EQUAL(mip_count, 3);
+    EXPECT_EQUAL(mips[0].offset, 64);
+    EXPECT_EQUAL(mips[0].size, 5 * 3 * 4);
+    EXPECT_EQUAL(mips[1].width, 2);
+    EXPECT_EQUAL(mips[1].height, 1);
+    EXPECT_EQUAL(mips[1].offset, 128);
+    EXPECT_EQUAL(mips[2].width, 1);
+    EXPECT_EQUAL(mips[2].height, 1);
+    EXPECT_EQUAL(mips[2].offset, 144);
+    EXPECT_EQUAL(mip_chain_size(5, 3, 3), 144 - 64 + 4);
+    EXPECT_EQUAL(mip_chain_size(5, 3, 1), 5 * 3 * 4);
+    return TRUE;
+}
+
+u8 mip_chain_test_level_for_size()
+{
+    // 1024x256 has 11 levels, the longer side halving from 1024 to 1.
+    EXPECT_EQUAL(mip_chain_level_for_size(1024, 256, 11, 64), 4);
+    EXPECT_EQUAL(mip_chain_level_for_size(1024, 256, 11, 65), 3);
+    EXPECT_EQUAL(mip_chain_level_for_size(256, 1024, 11, 1), 10);
+    EXPECT_EQUAL(mip_chain_level_for_size(1024, 256, 11, 4096), 0);
+
+    // Chains cut short stop at their last level.
+    EXPECT_EQUAL(mip_chain_level_for_size(1024, 256, 3, 64), 2);
+    EXPECT_EQUAL(mip_chain_level_for_size(1024, 256, 1, 64), 0);
+    return TRUE;
+}
+
+u8 mip_chain_test_box_averages_in_linear_space()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(16));
+
+    // Black and white average to half the light, which sRGB encodes as 188 rather than 128. Alpha is linear.
+    u8 const pixels[] = {
+        0, 0, 0, 0,         255, 255, 255, 255,
+        255, 255, 255, 255, 0, 0, 0, 0
+    };
+    u32 mip_count;
+    u64 size;
+    u8* chain = mip_chain_create(pixels, 2, 2, MIP_FILTER_BOX, &mip_count, &size);
+    expect_to_be_true(chain != 0);
+    EXPECT_EQUAL(mip_count, 2);
+    EXPECT_EQUAL(size, mip_chain_size(2, 2, 2));
+
+    u8 const* texel = chain + 16;
+    expect_to_be_true(near(texel[0], 188));
+    expect_to_be_true(near(texel[1], 188));
+    expect_to_be_true(near(texel[2], 188));
+    expect_to_be_true(near(texel[3], 128));
+
+    mip_chain_destroy(chain, size);
+    memory_system_shutdown();
+    return TRUE;
+}
+
+u8 mip_chain_test_kaiser_keeps_flat_images()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(16));
+
+    // The weights are normalized and the edges clamped, so a flat image stays flat at every level and at the edges.
+    u32 const width = 160;
+    u32 const height = 6;
+    u8 const colour[4] = { 30, 120, 200, 77 };
+    u8* pixels = malloc(width * height * 4);
+    for (u32 i = 0; i < width * height * 4; ++i)
+    {
+        pixels[i] = colour[i % 4];
+    }
+
+    u32 mip_count;
+    u64 size;
+    u8* chain = mip_chain_create(pixels, width, height, MIP_FILTER_KAISER, &mip_count, &size);
+    expect_to_be_true(chain != 0);
+    EXPECT_EQUAL(mip_count, 8);
+
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    mip_chain_layout(width, height, 0, mips);
+    for (u32 level = 1; level < mip_count; ++level)
+    {
+        u8 const* texels = chain + mips[level].offset;
+        for (u64 i = 0; i < mips[level].size; ++i)
+        {
+            expect_to_be_true(near(texels[i], colour[i % 4]));
+        }
+    }
+
+    mip_chain_destroy(chain, size);
+    free(pixels);
+    memory_system_shutdown();
+    return TRUE;
+}
+
+u8 mip_chain_test_region_matches_whole_chain()
+{
+    test_fixtures_start_memory_system(MEBIBYTES(16));
+
+    // Refiltering what a rewritten rect reaches gives the same chain as refiltering everything, for both kernels and
+    // for rects in the middle and at the edges of odd sized levels.
+    u32 const width = 101;
+    u32 const height = 67;
+    Mip_Region const rects[] = { { 40, 20, 13, 9 }, { 0, 0, 1, 1 }, { 90, 60, 11, 7 } };
+    u8* pixels = malloc(width * height * 4);
+    for (u32 i = 0; i < width * height * 4; ++i)
+    {
+        pixels[i] = (u8)rand();
+    }
+
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    u32 mip_count = mip_chain_layout(width, height, 0, mips);
+    for (Mip_Filter filter = MIP_FILTER_BOX; filter <= MIP_FILTER_KAISER; ++filter)
+    {
+        for (u32 r = 0; r < sizeof(rects) / sizeof(rects[0]); ++r)
+        {
+            u32 chain_mip_count;
+            u64 size;
+            u8* whole = mip_chain_create(pixels, width, height, filter, &chain_mip_count, &size);
+            u8* region = mip_chain_create(pixels, width, height, filter, &chain_mip_count, &size);
+            expect_to_be_true(whole != 0 && region != 0);
+
+            for (u32 y = rects[r].y; y < rects[r].y + rects[r].height; ++y)
+            {
+                for (u32 x = rects[r].x; x < rects[r].x + rects[r].width; ++x)
+                {
+                    for (u32 c = 0; c < 4; ++c)
+                    {
+                        whole[((u64)y * width + x) * 4 + c] = (u8)(x * 7 + y * 3 + c * 50);
+                        region[((u64)y * width + x) * 4 + c] = (u8)(x * 7 + y * 3 + c * 50);
+                    }
+                }
+            }
+
+            Mip_Region regions[COOKED_TEXTURE_MAX_MIPS];
+            regions[0] = rects[r];
+            u32 region_count = mip_chain_generate_region(region, mips, mip_count, filter, regions);
+            mip_chain_generate(whole, mips, mip_count, filter);
+            expect_to_be_true(region_count > 1);
+            for (u32 level = 1; level < region_count; ++level)
+            {
+                expect_to_be_true(regions[level].x + regions[level].width <= mips[level].width);
+                expect_to_be_true(regions[level].y + regions[level].height <= mips[level].height);
+            }
+            EXPECT_EQUAL(memcmp(whole, region, size), 0);
+
+            mip_chain_destroy(whole, size);
+            mip_chain_destroy(region, size);
+        }
+    }
+
+    free(pixels);
+    memory_system_shutdown();
+    return TRUE;
+}
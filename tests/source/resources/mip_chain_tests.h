@@ -0,0 +1,3 @@
+#pragma once
+
+void mip_chain_register_tests();
@@ -0,0 +1,159 @@
+#include "texture_atlas_tests.h"
+
+#include "../expect.h"
+#include "../test_manager.h"
+
+#include <resources/texture_atlas.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+static bool overlaps(Texture_Atlas_Rect const* a, Texture_Atlas_Rect const* b, u32 padding);
+
+static u8 texture_atlas_test_packs_without_overlap();
+static u8 texture_atlas_test_keeps_padding();
+static u8 texture_atlas_test_rejects_what_does_not_fit();
+static u8 texture_atlas_test_blit_extrudes_edges();
+static u8 texture_atlas_test_uv_rect();
+
+void texture_atlas_register_tests()
+{
+    test_manager_register_test(texture_atlas_test_packs_without_overlap, "texture_atlas_test_packs_without_overlap");
+    test_manager_register_test(texture_atlas_test_keeps_padding, "texture_atlas_test_keeps_padding");
+    test_manager_register_test(texture_atlas_test_rejects_what_does_not_fit, "texture_atlas_test_rejects_what_does_not_fit");
+    test_manager_register_test(texture_atlas_test_blit_extrudes_edges, "texture_atlas_test_blit_extrudes_edges");
+    test_manager_register_test(texture_atlas_test_uv_rect, "texture_atlas_test_uv_rect");
+}
+
+bool overlaps(Texture_Atlas_Rect const* a, Texture_Atlas_Rect const* b, u32 padding)
+{
+    // Rects overlap if their padded areas do.
+    return a->x < b->x + b->width + padding * 2 && b->x < a->x + a->width + padding * 2 &&
+        a->y < b->y + b->height + padding * 2 && b->y < a->y + a->height + padding * 2;
+}
+
+u8 texture_atlas_test_packs_without_overlap()
+{
+    // Icon sized rects are inserted one at a time until the atlas is full.
+    static Texture_Atlas_Packer packer;
+    texture_atlas_packer_create(256, 256, 0, &packer);
+    static Texture_Atlas_Rect rects[1024];
+    u32 count = 0;
+    srand(7);
+    for (u32 attempt = 0; attempt < 1024; ++attempt)
+    {
+        u32 width = 8 + rand() % 25;
+        u32 height = 8 + rand() % 25;
+        if (texture_atlas_packer_insert(&packer, width, height, &rects[count]))
+        {
+            EXPECT_EQUAL(rects[count].width, width);
+            EXPECT_EQUAL(rects[count].height, height);
+            expect_to_be_true(rects[count].x + width <= 256 && rects[count].y + height <= 256);
+            count++;
+        }
+    }
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        for (u32 j = i + 1; j < count; ++j)
+        {
+            expect_to_be_false(overlaps(&rects[i], &rects[j], 0));
+        }
+    }
+
+    // The skyline wastes what is left under overhangs, but mixed icons still fill most of the atlas.
+    expect_to_be_true(count > 100);
+    expect_to_be_true(texture_atlas_packer_occupancy(&packer) > 0.8f);
+    return TRUE;
+}
+
+u8 texture_atlas_test_keeps_padding()
+{
+    static Texture_Atlas_Packer packer;
+    texture_atlas_packer_create(128, 128, 2, &packer);
+    Texture_Atlas_Rect rects[64];
+    u32 count = 0;
+    while (count < 64 && texture_atlas_packer_insert(&packer, 10 + count % 7, 12 - count % 5, &rects[count]))
+    {
+        // The padding stays within the atlas.
+        expect_to_be_true(rects[count].x >= 2 && rects[count].y >= 2);
+        expect_to_be_true(rects[count].x + rects[count].width + 2 <= 128);
+        expect_to_be_true(rects[count].y + rects[count].height + 2 <= 128);
+        count++;
+    }
+    expect_to_be_true(count > 20);
+
+    for (u32 i = 0; i < count; ++i)
+    {
+        for (u32 j = i + 1; j < count; ++j)
+        {
+            expect_to_be_false(overlaps(&rects[i], &rects[j], 2));
+        }
+    }
+    return TRUE;
+}
+
+u8 texture_atlas_test_rejects_what_does_not_fit()
+{
+    static Texture_Atlas_Packer packer;
+    texture_atlas_packer_create(64, 64, 1, &packer);
+    Texture_Atlas_Rect rect;
+    expect_to_be_false(texture_atlas_packer_insert(&packer, 63, 10, &rect));
+    expect_to_be_false(texture_atlas_packer_insert(&packer, 0, 10, &rect));
+    expect_to_be_true(texture_atlas_packer_insert(&packer, 62, 40, &rect));
+
+    // A failed insert leaves the packer as it was, so smaller rects still go in.
+    static Texture_Atlas_Packer before;
+    before = packer;
+    expect_to_be_false(texture_atlas_packer_insert(&packer, 20, 30, &rect));
+    expect_to_be_true(memcmp(&before, &packer, sizeof(packer)) == 0);
+    expect_to_be_true(texture_atlas_packer_insert(&packer, 20, 20, &rect));
+    EXPECT_EQUAL(rect.x, 1);
+    EXPECT_EQUAL(rect.y, 43);
+    return TRUE;
+}
+
+u8 texture_atlas_test_blit_extrudes_edges()
+{
+    // A 3x2 image with distinct texels, blitted at (2, 2) with 2 texels of padding into an 8x7 atlas.
+    u8 atlas[8 * 7 * 4];
+    memset(atlas, 0xEE, sizeof(atlas));
+    u8 pixels[3 * 2 * 4];
+    for (u32 i = 0; i < 6; ++i)
+    {
+        memset(pixels + i * 4, i + 1, 4);
+    }
+    Texture_Atlas_Rect rect = { 2, 2, 3, 2 };
+    texture_atlas_blit(atlas, 8, &rect, 2, pixels);
+
+    // Every texel within the padding repeats the closest texel of the image.
+    for (u32 y = 0; y < 7; ++y)
+    {
+        for (u32 x = 0; x < 8; ++x)
+        {
+            u8 texel = atlas[(y * 8 + x) * 4];
+            if (x > 6 || y > 5)
+            {
+                EXPECT_EQUAL(texel, 0xEE);
+                continue;
+            }
+
+            u32 source_x = x < 2 ? 0 : x > 4 ? 2 : x - 2;
+            u32 source_y = y < 2 ? 0 : y > 3 ? 1 : y - 2;
+            EXPECT_EQUAL(texel, source_y * 3 + source_x + 1);
+        }
+    }
+    return TRUE;
+}
+
+u8 texture_atlas_test_uv_rect()
+{
+    Texture_Atlas_Rect rect = { 16, 32, 64, 16 };
+    f32 uv_rect[4];
+    texture_atlas_uv_rect(&rect, 128, 64, uv_rect);
+    expect_float_to_be(0.125f, uv_rect[0]);
+    expect_float_to_be(0.5f, uv_rect[1]);
+    expect_float_to_be(0.625f, uv_rect[2]);
+    expect_float_to_be(0.75f, uv_rect[3]);
+    return TRUE;
+}
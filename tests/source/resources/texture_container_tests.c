@@ -0,0 +1,268 @@
+#include "texture_container_tests.h"
+
+#include "expect.h"
+#include "test_manager.h"
+
+#include <resources/block_compression.h>
+#include <resources/texture_container.h>
+
+#include <string.h>
+
+// Containers are built in memory. Every level of every layer is filled with its own marker byte, so views and copies
+// can be checked for where they point.
+#define MARKER(level, layer) (u8)(0x10 * ((level) + 1) + (layer))
+
+static void write_u32(u8* data, u32 value);
+static void write_u64(u8* data, u64 value);
+static u64 build_ktx2(u8* data, u32 vk_format, u32 width, u32 height, u32 layer_count, u32 level_count);
+static u64 build_dds_dx10(u8* data, u32 dxgi_format, u32 width, u32 height, u32 array_size, u32 level_count);
+static void build_dds_header(u8* data, u32 width, u32 height, u32 level_count, u32 pixel_flags, u32 four_cc);
+
+static u8 texture_container_test_detect();
+static u8 texture_container_test_ktx2_levels();
+static u8 texture_container_test_dds_levels();
+static u8 texture_container_test_dds_legacy_formats();
+static u8 texture_container_test_rejects_malformed();
+
+void texture_container_register_tests()
+{
+    test_manager_register_test(texture_container_test_detect, "texture_container_test_detect");
+    test_manager_register_test(texture_container_test_ktx2_levels, "texture_container_test_ktx2_levels");
+    test_manager_register_test(texture_container_test_dds_levels, "texture_container_test_dds_levels");
+    test_manager_register_test(texture_container_test_dds_legacy_formats, "texture_container_test_dds_legacy_formats");
+    test_manager_register_test(texture_container_test_rejects_malformed, "texture_container_test_rejects_malformed");
+}
+
+void write_u32(u8* data, u32 value)
+{
+    for (u32 i = 0; i < 4; ++i)
+    {
+        data[i] = (u8)(value >> (i * 8));
+    }
+}
+
+void write_u64(u8* data, u64 value)
+{
+    write_u32(data, (u32)value);
+    write_u32(data + 4, (u32)(value >> 32));
+}
+
+u64 build_ktx2(u8* data, u32 vk_format, u32 width, u32 height, u32 layer_count, u32 level_count)
+{
+    u8 const identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+    memset(data, 0, 80);
+    memcpy(data, identifier, sizeof(identifier));
+    write_u32(data + 12, vk_format);
+    write_u32(data + 16, 1);
+    write_u32(data + 20, width);
+    write_u32(data + 24, height);
+    write_u32(data + 32, layer_count);
+    write_u32(data + 36, 1);
+    write_u32(data + 40, level_count);
+
+    // Levels are stored smallest first, each holding all of its layers.
+    Texture_Format format = vk_format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK ? TEXTURE_FORMAT_BC1 : TEXTURE_FORMAT_RGBA8;
+    u64 offset = 80 + level_count * 24;
+    for (u32 level = level_count; level-- > 0;)
+    {
+        u32 level_width = width >> level ? width >> level : 1;
+        u32 level_height = height >> level ? height >> level : 1;
+        u64 layer_size = block_compression_level_size(format, level_width, level_height);
+        write_u64(data + 80 + level * 24, offset);
+        write_u64(data + 80 + level * 24 + 8, layer_size * layer_count);
+        write_u64(data + 80 + level * 24 + 16, layer_size * layer_count);
+        for (u32 layer = 0; layer < layer_count; ++layer)
+        {
+            memset(data + offset, MARKER(level, layer), layer_size);
+            offset += layer_size;
+        }
+    }
+
+    return offset;
+}
+
+void build_dds_header(u8* data, u32 width, u32 height, u32 level_count, u32 pixel_flags, u32 four_cc)
+{
+    memset(data, 0, 128);
+    memcpy(data, "DDS ", 4);
+    write_u32(data + 4, 124);
+    write_u32(data + 8, 0x1007 | 0x20000);
+    write_u32(data + 12, height);
+    write_u32(data + 16, width);
+    write_u32(data + 28, level_count);
+    write_u32(data + 76, 32);
+    write_u32(data + 80, pixel_flags);
+    write_u32(data + 84, four_cc);
+    write_u32(data + 108, 0x1000);
+}
+
+u64 build_dds_dx10(u8* data, u32 dxgi_format, u32 width, u32 height, u32 array_size, u32 level_count)
+{
+    build_dds_header(data, width, height, level_count, 0x4, 0x30315844);
+    memset(data + 128, 0, 20);
+    write_u32(data + 128, dxgi_format);
+    write_u32(data + 132, 3);
+    write_u32(data + 140, array_size);
+
+    // Layers are stored one after the other, each holding all of its levels.
+    Texture_Format format = dxgi_format == 98 ? TEXTURE_FORMAT_BC7 : TEXTURE_FORMAT_RGBA8;
+    u64 offset = 148;
+    for (u32 layer = 0; layer < array_size; ++layer)
+    {
+        for (u32 level = 0; level < level_count; ++level)
+        {
+            u32 level_width = width >> level ? width >> level : 1;
+            u32 level_height = height >> level ? height >> level : 1;
+            u64 size = block_compression_level_size(format, level_width, level_height);
+            memset(data + offset, MARKER(level, layer), size);
+            offset += size;
+        }
+    }
+
+    return offset;
+}
+
+u8 texture_container_test_detect()
+{
+    u8 data[512];
+    u64 size = build_ktx2(data, VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4, 1, 1);
+    expect_to_be_true(texture_container_detect(data, size));
+    expect_to_be_false(texture_container_detect(data, 11));
+
+    size = build_dds_dx10(data, 98, 4, 4, 1, 1);
+    expect_to_be_true(texture_container_detect(data, size));
+
+    u8 const png[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    expect_to_be_false(texture_container_detect(png, sizeof(png)));
+    return TRUE;
+}
+
+u8 texture_container_test_ktx2_levels()
+{
+    // 8x4 BC1 with two layers: levels of 2, 1 and 1 blocks.
+    u8 data[512];
+    u64 size = build_ktx2(data, VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4, 2, 3);
+    Texture_Container container;
+    expect_to_be_true(texture_container_parse(data, size, &container));
+    EXPECT_EQUAL(container.type, TEXTURE_CONTAINER_TYPE_KTX2);
+    EXPECT_EQUAL(container.format, TEXTURE_FORMAT_BC1);
+    EXPECT_EQUAL(container.width, 8);
+    EXPECT_EQUAL(container.height, 4);
+    EXPECT_EQUAL(container.mip_count, 3);
+    EXPECT_EQUAL(container.layer_count, 2);
+
+    // Views point into the file itself.
+    Texture_Container_View view = texture_container_view(&container, 0, 1);
+    EXPECT_EQUAL(view.size, 16);
+    EXPECT_EQUAL(view.width, 8);
+    expect_to_be_true(view.data > data && view.data + view.size <= data + size);
+    EXPECT_EQUAL(view.data[0], MARKER(0, 1));
+    view = texture_container_view(&container, 2, 0);
+    EXPECT_EQUAL(view.width, 2);
+    EXPECT_EQUAL(view.height, 1);
+    EXPECT_EQUAL(view.data[7], MARKER(2, 0));
+    expect_to_be_true(texture_container_view(&container, 3, 0).data == 0);
+    expect_to_be_true(texture_container_view(&container, 0, 2).data == 0);
+
+    // Copied chains come out in the upload layout.
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    block_compression_layout(TEXTURE_FORMAT_BC1, 8, 4, 0, mips);
+    u8 chain[256] = {};
+    texture_container_copy_chain(&container, 1, chain);
+    for (u32 level = 0; level < 3; ++level)
+    {
+        for (u64 i = 0; i < mips[level].size; ++i)
+        {
+            EXPECT_EQUAL(chain[mips[level].offset + i], MARKER(level, 1));
+        }
+    }
+    return TRUE;
+}
+
+u8 texture_container_test_dds_levels()
+{
+    // 4x4 BC7 array of two layers with levels of one block each.
+    u8 data[512];
+    u64 size = build_dds_dx10(data, 98, 4, 4, 2, 3);
+    Texture_Container container;
+    expect_to_be_true(texture_container_parse(data, size, &container));
+    EXPECT_EQUAL(container.type, TEXTURE_CONTAINER_TYPE_DDS);
+    EXPECT_EQUAL(container.format, TEXTURE_FORMAT_BC7);
+    EXPECT_EQUAL(container.mip_count, 3);
+    EXPECT_EQUAL(container.layer_count, 2);
+
+    Texture_Container_View view = texture_container_view(&container, 1, 1);
+    expect_to_be_true(view.data == data + 148 + 48 + 16);
+    EXPECT_EQUAL(view.size, 16);
+    EXPECT_EQUAL(view.data[0], MARKER(1, 1));
+
+    Cooked_Mip mips[COOKED_TEXTURE_MAX_MIPS];
+    block_compression_layout(TEXTURE_FORMAT_BC7, 4, 4, 0, mips);
+    u8 chain[256] = {};
+    texture_container_copy_chain(&container, 0, chain);
+    for (u32 level = 0; level < 3; ++level)
+    {
+        EXPECT_EQUAL(chain[mips[level].offset], MARKER(level, 0));
+        EXPECT_EQUAL(chain[mips[level].offset + 15], MARKER(level, 0));
+    }
+    return TRUE;
+}
+
+u8 texture_container_test_dds_legacy_formats()
+{
+    // DXT5 without a DX10 header.
+    u8 data[512];
+    build_dds_header(data, 8, 8, 1, 0x4, 0x35545844);
+    Texture_Container container;
+    expect_to_be_true(texture_container_parse(data, 128 + 64, &container));
+    EXPECT_EQUAL(container.format, TEXTURE_FORMAT_BC3);
+    EXPECT_EQUAL(container.level_offsets[0], 128);
+
+    // Uncompressed RGBA in byte order is taken, BGRA isn't.
+    build_dds_header(data, 2, 2, 1, 0x41, 0);
+    write_u32(data + 88, 32);
+    write_u32(data + 92, 0x000000FF);
+    write_u32(data + 96, 0x0000FF00);
+    write_u32(data + 100, 0x00FF0000);
+    write_u32(data + 104, 0xFF000000);
+    expect_to_be_true(texture_container_parse(data, 128 + 16, &container));
+    EXPECT_EQUAL(container.format, TEXTURE_FORMAT_RGBA8);
+    write_u32(data + 92, 0x00FF0000);
+    write_u32(data + 100, 0x000000FF);
+    expect_to_be_false(texture_container_parse(data, 128 + 16, &container));
+    return TRUE;
+}
+
+u8 texture_container_test_rejects_malformed()
+{
+    u8 data[512];
+    Texture_Container container;
+
+    // Truncated level data.
+    u64 size = build_ktx2(data, VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4, 2, 3);
+    expect_to_be_false(texture_container_parse(data, size - 1, &container));
+
+    // Supercompressed.
+    build_ktx2(data, VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4, 1, 1);
+    write_u32(data + 44, 1);
+    expect_to_be_false(texture_container_parse(data, size, &container));
+
+    // A format the renderer can't sample.
+    size = build_ktx2(data, VK_FORMAT_R16G16B16A16_SFLOAT, 8, 4, 1, 1);
+    expect_to_be_false(texture_container_parse(data, size, &container));
+
+    // More levels than the size allows.
+    size = build_ktx2(data, VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 8, 4, 1, 3);
+    write_u32(data + 40, 5);
+    expect_to_be_false(texture_container_parse(data, sizeof(data), &container));
+
+    // A volume texture.
+    size = build_dds_dx10(data, 98, 4, 4, 1, 1);
+    write_u32(data + 132, 4);
+    expect_to_be_false(texture_container_parse(data, size, &container));
+
+    // Truncated DDS layers.
+    size = build_dds_dx10(data, 98, 4, 4, 2, 1);
+    expect_to_be_false(texture_container_parse(data, size - 16, &container));
+    return TRUE;
+}
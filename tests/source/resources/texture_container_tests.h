@@ -0,0 +1,3 @@
+#pragma once
+
+void texture_container_register_tests();
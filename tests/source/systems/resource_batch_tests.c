@@ -0,0 +1,172 @@
+#include "resource_batch_tests.h"
+
+#include "../expect.h"
+#include "../test_fixtures.h"
+#include "../test_manager.h"
+
+#include <systems/memory_system.h>
+#include <systems/resource_batch.h>
+
+#include <string.h>
+
+#define MAX_LOG_COUNT 16
+
+typedef struct Fake_Material
+{
+    char const* name;
+    char const* textures[2];
+} Fake_Material;
+
+static Fake_Material const fake_materials[] = {
+    { "m1", { "t1", "t2" } },
+    { "m2", { "t2", 0 } },
+    { "m3", { "missing", 0 } }
+};
+
+static u32 image_load_count;
+static u32 material_load_count;
+static char ready_names[MAX_LOG_COUNT][8];
+static u32 ready_request_indices[MAX_LOG_COUNT];
+static u32 ready_count;
+
+static bool fake_material_load(char const* filename, Resource_Data* resource);
+static u32 fake_material_get_dependencies(Resource_Data const* resource, Resource_Dependency* dependencies, u32 capacity);
+static bool fake_image_load(char const* filename, Resource_Data* resource);
+static void fake_unload(Resource_Data* resource);
+static void on_ready(Resource_Data const* resource, u32 request_index, void* user_data);
+static u32 ready_position(char const* name);
+
+static u8 resource_batch_test_loads_shared_dependencies_once();
+
+void resource_batch_register_tests()
+{
+    test_manager_register_test(resource_batch_test_loads_shared_dependencies_once, "resource_batch_test_loads_shared_dependencies_once");
+}
+
+bool fake_material_load(char const* filename, Resource_Data* resource)
+{
+    material_load_count++;
+    for (u32 i = 0; i < sizeof(fake_materials) / sizeof(fake_materials[0]); ++i)
+    {
+        if (strcmp(fake_materials[i].name, filename) == 0)
+        {
+            resource->data = (void*)&fake_materials[i];
+            resource->size = sizeof(fake_materials[i]);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+u32 fake_material_get_dependencies(Resource_Data const* resource, Resource_Dependency* dependencies, u32 capacity)
+{
+    Fake_Material const* material = resource->data;
+    u32 count = 0;
+    for (u32 i = 0; i < 2 && material->textures[i] && count < capacity; ++i)
+    {
+        dependencies[count].type = RESOURCE_TYPE_IMAGE;
+        strcpy(dependencies[count].name, material->textures[i]);
+        count++;
+    }
+
+    return count;
+}
+
+bool fake_image_load(char const* filename, Resource_Data* resource)
+{
+    image_load_count++;
+    resource->data = (void*)filename;
+    resource->size = 64;
+    return strcmp(filename, "missing") != 0;
+}
+
+void fake_unload(Resource_Data* resource)
+{
+    resource->data = 0;
+    resource->size = 0;
+}
+
+void on_ready(Resource_Data const* resource, u32 request_index, void* user_data)
+{
+    if (ready_count < MAX_LOG_COUNT)
+    {
+        strncpy(ready_names[ready_count], resource->filename, sizeof(ready_names[0]) - 1);
+        ready_request_indices[ready_count] = request_index;
+        ready_count++;
+    }
+}
+
+u32 ready_position(char const* name)
+{
+    for (u32 i = 0; i < ready_count; ++i)
+    {
+        if (strcmp(ready_names[i], name) == 0)
+        {
+            return i;
+        }
+    }
+
+    return INVALID_ID;
+}
+
+u8 resource_batch_test_loads_shared_dependencies_once()
+{
+    // The batch allocates its graph through the memory system.
+    expect_to_be_true(test_fixtures_start_memory_system(MEBIBYTES(16)));
+
+    static Resource_Loader const material_loader = { fake_material_load, fake_unload, 0, 0, fake_material_get_dependencies };
+    static Resource_Loader const image_loader = { fake_image_load, fake_unload };
+    Resource_System_Config config = test_fixtures_resource_config(&image_loader, 1024, 16);
+    config.loaders[RESOURCE_TYPE_MATERIAL] = &material_loader;
+    expect_to_be_true(test_fixtures_start_resource_manager(config));
+
+    Resource_Batch_Request requests[] = {
+        { RESOURCE_TYPE_MATERIAL, "m1" },
+        { RESOURCE_TYPE_MATERIAL, "m2" },
+        { RESOURCE_TYPE_MATERIAL, "m1" },
+        { RESOURCE_TYPE_MATERIAL, "m3" }
+    };
+
+    Resource_Data resources[4];
+    Resource_Batch_Stats stats;
+    expect_to_be_true(resource_batch_acquire(requests, 4, true, on_ready, 0, resources, &stats));
+
+    // m1, m2, m3, t1, t2 and the missing image, each loaded once.
+    EXPECT_EQUAL(material_load_count, 3);
+    EXPECT_EQUAL(image_load_count, 3);
+    EXPECT_EQUAL(stats.resource_count, 6);
+    EXPECT_EQUAL(stats.duplicate_count, 2);
+    EXPECT_EQUAL(stats.failed_count, 1);
+    EXPECT_EQUAL(stats.stages[RESOURCE_BATCH_STAGE_DECODE].count, 5);
+    EXPECT_EQUAL(stats.stages[RESOURCE_BATCH_STAGE_UPLOAD].count, 5);
+
+    // Dependencies are ready before their dependents, and a failed one doesn't hold its dependent back.
+    EXPECT_EQUAL(ready_count, 5);
+    expect_to_be_true(ready_position("t1") < ready_position("m1"));
+    expect_to_be_true(ready_position("t2") < ready_position("m1"));
+    expect_to_be_true(ready_position("t2") < ready_position("m2"));
+    EXPECT_EQUAL(ready_request_indices[ready_position("m3")], 3);
+    EXPECT_EQUAL(ready_request_indices[ready_position("t1")], INVALID_ID);
+
+    expect_to_be_true(resources[0].data == &fake_materials[0]);
+    expect_to_be_true(resources[2].data == &fake_materials[0]);
+    expect_to_be_true(resources[3].data == &fake_materials[2]);
+
+    // Only the requests hold references. Textures stay cached for the next acquire.
+    Resource_Cache_Stats image_stats;
+    resource_manager_get_cache_stats(RESOURCE_TYPE_IMAGE, &image_stats);
+    EXPECT_EQUAL(image_stats.cached_count, 2);
+    for (u32 i = 0; i < 4; ++i)
+    {
+        resource_manager_release(&resources[i]);
+    }
+
+    Resource_Cache_Stats material_stats;
+    resource_manager_get_cache_stats(RESOURCE_TYPE_MATERIAL, &material_stats);
+    EXPECT_EQUAL(material_stats.cached_count, 3);
+
+    resource_manager_shutdown();
+    memory_system_shutdown();
+    return TRUE;
+}
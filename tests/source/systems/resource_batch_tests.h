@@ -0,0 +1,3 @@
+#pragma once
+
+void resource_batch_register_tests();
@@ -0,0 +1,201 @@
+#include "resource_manager_tests.h"
+
+#include "../expect.h"
+#include "../test_fixtures.h"
+#include "../test_manager.h"
+
+#include <systems/resource_manager.h>
+
+#include <string.h>
+
+#define FAKE_RESOURCE_SIZE 100
+
+static u8 fake_data[FAKE_RESOURCE_SIZE];
+static u32 load_count;
+static u32 unload_count;
+
+static bool fake_load(char const* filename, Resource_Data* resource);
+static void fake_unload(Resource_Data* resource);
+static bool start(u64 budget, u32 max_resource_count);
+
+static u8 resource_manager_test_reacquire_hits_cache();
+static u8 resource_manager_test_evicts_least_recently_released();
+static u8 resource_manager_test_referenced_and_pinned_are_not_evicted();
+static u8 resource_manager_test_zero_budget_unloads_on_release();
+static u8 resource_manager_test_full_table_evicts_to_make_room();
+
+void resource_manager_register_tests()
+{
+    test_manager_register_test(resource_manager_test_reacquire_hits_cache, "resource_manager_test_reacquire_hits_cache");
+    test_manager_register_test(resource_manager_test_evicts_least_recently_released, "resource_manager_test_evicts_least_recently_released");
+    test_manager_register_test(resource_manager_test_referenced_and_pinned_are_not_evicted, "resource_manager_test_referenced_and_pinned_are_not_evicted");
+    test_manager_register_test(resource_manager_test_zero_budget_unloads_on_release, "resource_manager_test_zero_budget_unloads_on_release");
+    test_manager_register_test(resource_manager_test_full_table_evicts_to_make_room, "resource_manager_test_full_table_evicts_to_make_room");
+}
+
+bool fake_load(char const* filename, Resource_Data* resource)
+{
+    load_count++;
+    resource->data = fake_data;
+    resource->size = FAKE_RESOURCE_SIZE;
+    return strcmp(filename, "missing") != 0;
+}
+
+void fake_unload(Resource_Data* resource)
+{
+    unload_count++;
+    resource->data = 0;
+    resource->size = 0;
+}
+
+bool start(u64 budget, u32 max_resource_count)
+{
+    static Resource_Loader const fake_loader = { fake_load, fake_unload };
+
+    load_count = 0;
+    unload_count = 0;
+    return test_fixtures_start_resource_manager(test_fixtures_resource_config(&fake_loader, budget, max_resource_count));
+}
+
+u8 resource_manager_test_reacquire_hits_cache()
+{
+    expect_to_be_true(start(10 * FAKE_RESOURCE_SIZE, 16));
+
+    Resource_Data resource;
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "paving", true, &resource));
+    expect_to_be_true(resource.data == fake_data);
+    resource_manager_release(&resource);
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "paving", true, &resource));
+    resource_manager_release(&resource);
+
+    // Same name, different type: a separate resource.
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_MATERIAL, "paving", true, &resource));
+    resource_manager_release(&resource);
+
+    // A failed load is a miss, but isn't cached.
+    expect_to_be_false(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "missing", true, &resource));
+
+    Resource_Cache_Stats stats;
+    resource_manager_get_cache_stats(RESOURCE_TYPE_IMAGE, &stats);
+    EXPECT_EQUAL(stats.hits, 1);
+    EXPECT_EQUAL(stats.misses, 2);
+    EXPECT_EQUAL(stats.evictions, 0);
+    EXPECT_EQUAL(stats.cached_count, 1);
+    EXPECT_EQUAL(stats.cached_size, FAKE_RESOURCE_SIZE);
+    EXPECT_EQUAL(stats.resident_size, FAKE_RESOURCE_SIZE);
+    EXPECT_EQUAL(load_count, 3);
+    EXPECT_EQUAL(unload_count, 0);
+
+    resource_manager_shutdown();
+    EXPECT_EQUAL(unload_count, 2);
+    return TRUE;
+}
+
+u8 resource_manager_test_evicts_least_recently_released()
+{
+    expect_to_be_true(start(2 * FAKE_RESOURCE_SIZE, 16));
+
+    Resource_Data a;
+    Resource_Data b;
+    Resource_Data c;
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "a", true, &a));
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "b", true, &b));
+    resource_manager_release(&a);
+    resource_manager_release(&b);
+
+    // Touching a makes b the least recently released, so loading c evicts b.
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "a", true, &a));
+    resource_manager_release(&a);
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "c", true, &c));
+    EXPECT_EQUAL(unload_count, 1);
+
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "a", true, &a));
+    EXPECT_EQUAL(load_count, 3);
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "b", true, &b));
+    EXPECT_EQUAL(load_count, 4);
+
+    Resource_Cache_Stats stats;
+    resource_manager_get_cache_stats(RESOURCE_TYPE_IMAGE, &stats);
+    EXPECT_EQUAL(stats.hits, 2);
+    EXPECT_EQUAL(stats.misses, 4);
+    EXPECT_EQUAL(stats.evictions, 1);
+    EXPECT_EQUAL(stats.resident_size, 3 * FAKE_RESOURCE_SIZE);
+
+    resource_manager_shutdown();
+    return TRUE;
+}
+
+u8 resource_manager_test_referenced_and_pinned_are_not_evicted()
+{
+    expect_to_be_true(start(FAKE_RESOURCE_SIZE, 16));
+
+    Resource_Data referenced;
+    Resource_Data pinned;
+    Resource_Data other;
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_TEXT, "referenced", true, &referenced));
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_TEXT, "pinned", false, &pinned));
+    resource_manager_release(&pinned);
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_TEXT, "other", true, &other));
+    resource_manager_release(&other);
+
+    // Over budget, but only the released, auto-released resource can go.
+    EXPECT_EQUAL(unload_count, 1);
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_TEXT, "pinned", true, &pinned));
+    expect_to_be_false(pinned.auto_release);
+    EXPECT_EQUAL(load_count, 3);
+
+    // Other types have budgets of their own.
+    Resource_Cache_Stats stats;
+    resource_manager_get_cache_stats(RESOURCE_TYPE_BINARY, &stats);
+    EXPECT_EQUAL(stats.resident_size, 0);
+
+    resource_manager_shutdown();
+    return TRUE;
+}
+
+u8 resource_manager_test_zero_budget_unloads_on_release()
+{
+    expect_to_be_true(start(0, 16));
+
+    Resource_Data resource;
+    Resource_Data second;
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_BINARY, "vert.spv", true, &resource));
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_BINARY, "vert.spv", true, &second));
+    resource_manager_release(&resource);
+    EXPECT_EQUAL(unload_count, 0);
+    resource_manager_release(&second);
+    EXPECT_EQUAL(unload_count, 1);
+
+    // A release without a matching acquire is ignored.
+    resource_manager_release(&second);
+    EXPECT_EQUAL(unload_count, 1);
+
+    resource_manager_shutdown();
+    return TRUE;
+}
+
+u8 resource_manager_test_full_table_evicts_to_make_room()
+{
+    expect_to_be_true(start(100 * FAKE_RESOURCE_SIZE, 2));
+
+    Resource_Data a;
+    Resource_Data b;
+    Resource_Data c;
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "a", true, &a));
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "b", true, &b));
+    expect_to_be_false(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "c", true, &c));
+
+    resource_manager_release(&a);
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "c", true, &c));
+    EXPECT_EQUAL(unload_count, 1);
+
+    // b and c still resolve after a was removed from the table.
+    resource_manager_release(&b);
+    resource_manager_release(&c);
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "b", true, &b));
+    expect_to_be_true(resource_manager_acquire(RESOURCE_TYPE_IMAGE, "c", true, &c));
+    EXPECT_EQUAL(load_count, 3);
+
+    resource_manager_shutdown();
+    return TRUE;
+}
@@ -0,0 +1,3 @@
+#pragma once
+
+void resource_manager_register_tests();
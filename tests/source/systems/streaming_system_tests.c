@@ -0,0 +1,191 @@
+#include "streaming_system_tests.h"
+
+#include "../expect.h"
+#include "../test_fixtures.h"
+#include "../test_manager.h"
+
+#include <systems/resource_manager.h>
+#include <systems/streaming_system.h>
+
+#include <string.h>
+
+#define FAKE_RESOURCE_SIZE 100
+#define MAX_LOG_COUNT 8
+
+static u8 streaming_block[64 * 1024];
+static char delivered_names[MAX_LOG_COUNT][8];
+static u32 delivered_count;
+static u32 failed_count;
+
+static bool fake_load(char const* filename, Resource_Data* resource);
+static void fake_unload(Resource_Data* resource);
+static void on_loaded(Resource_Data* resource, bool succeeded, void* user_data);
+static bool start(u32 max_in_flight_count, u64 upload_budget);
+static void stop();
+
+static u8 streaming_system_test_delivers_by_priority_within_upload_budget();
+static u8 streaming_system_test_cancel_and_demote();
+
+void streaming_system_register_tests()
+{
+    test_manager_register_test(streaming_system_test_delivers_by_priority_within_upload_budget, "streaming_system_test_delivers_by_priority_within_upload_budget");
+    test_manager_register_test(streaming_system_test_cancel_and_demote, "streaming_system_test_cancel_and_demote");
+}
+
+bool fake_load(char const* filename, Resource_Data* resource)
+{
+    resource->data = (void*)filename;
+    resource->size = FAKE_RESOURCE_SIZE;
+    return strcmp(filename, "missing") != 0;
+}
+
+void fake_unload(Resource_Data* resource)
+{
+    resource->data = 0;
+    resource->size = 0;
+}
+
+void on_loaded(Resource_Data* resource, bool succeeded, void* user_data)
+{
+    if (!succeeded)
+    {
+        failed_count++;
+        return;
+    }
+
+    if (delivered_count < MAX_LOG_COUNT)
+    {
+        strncpy(delivered_names[delivered_count], resource->filename, sizeof(delivered_names[0]) - 1);
+    }
+
+    delivered_count++;
+    resource_manager_release(resource);
+}
+
+bool start(u32 max_in_flight_count, u64 upload_budget)
+{
+    static Resource_Loader const fake_loader = { fake_load, fake_unload };
+    if (!test_fixtures_start_resource_manager(test_fixtures_resource_config(&fake_loader, 1024, 16)))
+    {
+        return false;
+    }
+
+    u64 required_memory;
+    Streaming_System_Config config = {};
+    config.max_request_count = 16;
+    config.max_in_flight_count = max_in_flight_count;
+    config.upload_budget = upload_budget;
+    streaming_system_startup(&required_memory, 0, config);
+    if (required_memory > sizeof(streaming_block))
+    {
+        return false;
+    }
+
+    delivered_count = 0;
+    failed_count = 0;
+    return streaming_system_startup(&required_memory, streaming_block, config);
+}
+
+void stop()
+{
+    streaming_system_shutdown();
+    resource_manager_shutdown();
+}
+
+u8 streaming_system_test_delivers_by_priority_within_upload_budget()
+{
+    // One resource fits the budget per update, and the first one always goes through.
+    expect_to_be_true(start(16, FAKE_RESOURCE_SIZE + FAKE_RESOURCE_SIZE / 2));
+
+    streaming_system_request(RESOURCE_TYPE_IMAGE, "near", 1.0f, on_loaded, 0);
+    Stream_Handle far = streaming_system_request(RESOURCE_TYPE_IMAGE, "far", 0.5f, on_loaded, 0);
+    streaming_system_request(RESOURCE_TYPE_IMAGE, "big", 4.0f, on_loaded, 0);
+    streaming_system_request(RESOURCE_TYPE_IMAGE, "missing", 2.0f, on_loaded, 0);
+    EXPECT_EQUAL(streaming_system_get_state(far), STREAM_STATE_QUEUED);
+
+    // Loads start, then complete by the next update, which hands over the most important one.
+    streaming_system_update();
+    EXPECT_EQUAL(delivered_count, 0);
+    EXPECT_EQUAL(streaming_system_get_state(far), STREAM_STATE_LOADING);
+
+    streaming_system_update();
+    EXPECT_EQUAL(delivered_count, 1);
+    EXPECT_EQUAL(failed_count, 1);
+    EXPECT_EQUAL(streaming_system_get_state(far), STREAM_STATE_READY);
+
+    Streaming_Stats stats;
+    streaming_system_get_stats(&stats);
+    EXPECT_EQUAL(stats.frame_upload_size, FAKE_RESOURCE_SIZE);
+    EXPECT_EQUAL(stats.ready_count, 2);
+
+    streaming_system_update();
+    streaming_system_update();
+    EXPECT_EQUAL(delivered_count, 3);
+    expect_to_be_true(strcmp(delivered_names[0], "big") == 0);
+    expect_to_be_true(strcmp(delivered_names[1], "near") == 0);
+    expect_to_be_true(strcmp(delivered_names[2], "far") == 0);
+
+    // Delivered handles are stale.
+    EXPECT_EQUAL(streaming_system_get_state(far), STREAM_STATE_NONE);
+    expect_to_be_false(streaming_system_promote(far, 10.0f));
+
+    streaming_system_get_stats(&stats);
+    EXPECT_EQUAL(stats.delivered_count, 3);
+    EXPECT_EQUAL(stats.failed_count, 1);
+    EXPECT_EQUAL(stats.upload_size, 3 * FAKE_RESOURCE_SIZE);
+
+    stop();
+    return TRUE;
+}
+
+u8 streaming_system_test_cancel_and_demote()
+{
+    // One load at a time, so the queue order decides what loads next.
+    expect_to_be_true(start(1, 0));
+
+    Stream_Handle a = streaming_system_request(RESOURCE_TYPE_IMAGE, "a", 1.0f, on_loaded, 0);
+    Stream_Handle b = streaming_system_request(RESOURCE_TYPE_IMAGE, "b", 2.0f, on_loaded, 0);
+    Stream_Handle c = streaming_system_request(RESOURCE_TYPE_IMAGE, "c", 3.0f, on_loaded, 0);
+    Stream_Handle d = streaming_system_request(RESOURCE_TYPE_IMAGE, "d", 0.0f, on_loaded, 0);
+
+    expect_to_be_true(streaming_system_cancel(c));
+    expect_to_be_false(streaming_system_cancel(c));
+    expect_to_be_true(streaming_system_demote(b, 0.5f));
+    expect_to_be_true(streaming_system_promote(d, 5.0f));
+
+    // Promoting to a lower priority and demoting to a higher one change nothing.
+    expect_to_be_true(streaming_system_promote(a, 0.0f));
+    expect_to_be_true(streaming_system_demote(b, 4.0f));
+
+    for (u32 i = 0; i < 8; ++i)
+    {
+        streaming_system_update();
+    }
+
+    EXPECT_EQUAL(delivered_count, 3);
+    expect_to_be_true(strcmp(delivered_names[0], "d") == 0);
+    expect_to_be_true(strcmp(delivered_names[1], "a") == 0);
+    expect_to_be_true(strcmp(delivered_names[2], "b") == 0);
+
+    // A request cancelled while loading is finished into the cache rather than handed over.
+    Stream_Handle e = streaming_system_request(RESOURCE_TYPE_IMAGE, "e", 1.0f, on_loaded, 0);
+    streaming_system_update();
+    EXPECT_EQUAL(streaming_system_get_state(e), STREAM_STATE_LOADING);
+    expect_to_be_true(streaming_system_cancel(e));
+    streaming_system_update();
+    streaming_system_update();
+    EXPECT_EQUAL(delivered_count, 3);
+
+    Resource_Data data;
+    expect_to_be_true(resource_manager_acquire_if_loaded(RESOURCE_TYPE_IMAGE, "e", true, &data));
+    resource_manager_release(&data);
+
+    Streaming_Stats stats;
+    streaming_system_get_stats(&stats);
+    EXPECT_EQUAL(stats.cancelled_count, 2);
+    EXPECT_EQUAL(stats.queued_count, 0);
+    EXPECT_EQUAL(stats.loading_count, 0);
+
+    stop();
+    return TRUE;
+}
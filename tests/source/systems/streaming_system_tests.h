@@ -0,0 +1,3 @@
+#pragma once
+
+void streaming_system_register_tests();
@@ -0,0 +1,32 @@
+#include "test_fixtures.h"
+
+#include <systems/memory_system.h>
+
+static u8 resource_manager_block[64 * 1024];
+
+bool test_fixtures_start_memory_system(u64 tracked_memory)
+{
+    memory_system_configuration memory_system_config = {};
+    memory_system_config.tracked_memory = tracked_memory;
+    return memory_system_startup(memory_system_config);
+}
+
+Resource_System_Config test_fixtures_resource_config(Resource_Loader const* loader, u64 budget, u32 max_resource_count)
+{
+    Resource_System_Config config = {};
+    config.max_resource_count = max_resource_count;
+    for (u32 i = 0; i < RESOURCE_TYPE_ENUM_COUNT; ++i)
+    {
+        config.cache_budgets[i] = budget;
+        config.loaders[i] = loader;
+    }
+
+    return config;
+}
+
+bool test_fixtures_start_resource_manager(Resource_System_Config config)
+{
+    u64 required_memory;
+    resource_manager_startup(&required_memory, 0, config);
+    return required_memory <= sizeof(resource_manager_block) && resource_manager_startup(&required_memory, resource_manager_block, config);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <defines.h>
+#include <systems/resource_manager.h>
+
+/**
+ * @brief Starts the memory system for a test. The test stops it with memory_system_shutdown.
+ * @return TRUE if successful; otherwise FALSE
+ */
+bool test_fixtures_start_memory_system(u64 tracked_memory);
+
+/**
+ * @return A resource manager config with _loader_ for every resource type, each allowed to cache _budget_ bytes.
+ */
+Resource_System_Config test_fixtures_resource_config(Resource_Loader const* loader, u64 budget, u32 max_resource_count);
+
+/**
+ * @brief Starts the resource manager in a block shared by the tests, so it doesn't need the memory system.
+ * The test stops it with resource_manager_shutdown.
+ * @return TRUE if the manager fits the block and started; otherwise FALSE
+ */
+bool test_fixtures_start_resource_manager(Resource_System_Config config);
@@ -5,16 +5,48 @@
 #include <core/string_utils.h>
 #include <core/clock.h>
 
+#include <stdio.h>
+#include <stdlib.h>
+
+// Minimum time spent warming up before iterations are calibrated.
+#define BENCHMARK_WARMUP_TIME 0.1
+// Target duration of a single sample.
+#define BENCHMARK_SAMPLE_TIME 0.02
+#define BENCHMARK_SAMPLE_COUNT 21
+#define BENCHMARK_MAX_ITERATIONS (1ull << 32)
+
 typedef struct test_entry {
     PFN_test func;
     char* desc;
 } test_entry;
 
+typedef struct benchmark_entry {
+    PFN_benchmark func;
+    char* desc;
+} benchmark_entry;
+
+typedef struct benchmark_result {
+    u64 iterations;
+    u64 items_per_iteration;
+    f64 median_ns;
+    f64 mad_ns;
+    f64 min_ns;
+    f64 max_ns;
+} benchmark_result;
+
 static DARRAY(test_entry) tests;
+static DARRAY(benchmark_entry) benchmarks;
+
+static void const* volatile benchmark_sink;
+
+static f64 run_benchmark_once(PFN_benchmark func, u64 iterations, u64* items_per_iteration);
+static void run_benchmark(PFN_benchmark func, benchmark_result* result);
+static int compare_f64(void const* lhs, void const* rhs);
 
 void test_manager_init()
 {
     DARRAY_INIT(tests, MEMORY_TAG_APPLICATION);
+    DARRAY_INIT(benchmarks, MEMORY_TAG_APPLICATION);
 }
 
 void test_manager_register_test(u8 (* PFN_test)(), char* desc)
@@ -64,3 +96,144 @@ void test_manager_run_tests()
 
     DARRAY_DESTROY(tests);
 }
+
+void test_manager_register_benchmark(PFN_benchmark func, char* desc)
+{
+    benchmark_entry e;
+    e.func = func;
+    e.desc = desc;
+    DARRAY_PUSH(benchmarks, e);
+}
+
+void test_manager_run_benchmarks(char const* output_path)
+{
+    FILE* file = 0;
+    if (output_path) {
+        file = fopen(output_path, "w");
+        if (!file) {
+            LOG_ERROR("test_manager_run_benchmarks: Failed to open '%s'. Results are only logged", output_path);
+        }
+    }
+
+    if (file) {
+        fprintf(file, "{\n  \"benchmarks\": [\n");
+    }
+
+    u32 count = benchmarks.size;
+    for (u32 i = 0; i < count; ++i) {
+        benchmark_result result;
+        run_benchmark(benchmarks.data[i].func, &result);
+
+        f64 items_per_second = result.items_per_iteration && result.median_ns > 0.0 ? result.items_per_iteration * 1e9 / result.median_ns : 0.0;
+        LOG_INFO("[BENCH] %s: %.2f ns/iter (MAD %.2f ns, %.2f%%), %llu iterations x %d samples",
+            benchmarks.data[i].desc, result.median_ns, result.mad_ns, result.median_ns > 0.0 ? 100.0 * result.mad_ns / result.median_ns : 0.0,
+            result.iterations, BENCHMARK_SAMPLE_COUNT);
+
+        if (file) {
+            fprintf(file, "    { \"name\": \"%s\", \"iterations\": %llu, \"samples\": %d, \"median_ns\": %.3f, \"mad_ns\": %.3f, \"min_ns\": %.3f, \"max_ns\": %.3f, \"items_per_second\": %.1f }%s\n",
+                benchmarks.data[i].desc, result.iterations, BENCHMARK_SAMPLE_COUNT, result.median_ns, result.mad_ns, result.min_ns, result.max_ns,
+                items_per_second, i + 1 < count ? "," : "");
+        }
+    }
+
+    if (file) {
+        fprintf(file, "  ]\n}\n");
+        fclose(file);
+        LOG_INFO("Benchmark results written to '%s'", output_path);
+    }
+
+    DARRAY_DESTROY(benchmarks);
+}
+
+void benchmark_pause_timing(benchmark_state* state)
+{
+    clock c;
+    clock_start(&c);
+    state->pause_start = c.start;
+}
+
+void benchmark_resume_timing(benchmark_state* state)
+{
+    clock c;
+    clock_start(&c);
+    state->paused_time += c.start - state->pause_start;
+}
+
+void benchmark_escape(void const* p)
+{
+    benchmark_sink = p;
+}
+
+f64 run_benchmark_once(PFN_benchmark func, u64 iterations, u64* items_per_iteration)
+{
+    benchmark_state state;
+    state.iterations = iterations;
+    state.items_per_iteration = 0;
+    state.paused_time = 0.0;
+    state.pause_start = 0.0;
+
+    clock timer;
+    clock_start(&timer);
+    func(&state);
+    clock_update(&timer);
+
+    *items_per_iteration = state.items_per_iteration;
+    f64 elapsed = timer.elapsed - state.paused_time;
+    return elapsed > 0.0 ? elapsed : 0.0;
+}
+
+void run_benchmark(PFN_benchmark func, benchmark_result* result)
+{
+    u64 items_per_iteration = 0;
+
+    // Warmup, growing the iteration count until a run takes a measurable amount of time.
+    u64 iterations = 1;
+    f64 warmup_time = 0.0;
+    f64 elapsed = 0.0;
+    for (;;) {
+        elapsed = run_benchmark_once(func, iterations, &items_per_iteration);
+        warmup_time += elapsed;
+        if ((elapsed >= BENCHMARK_SAMPLE_TIME * 0.1 && warmup_time >= BENCHMARK_WARMUP_TIME) || iterations >= BENCHMARK_MAX_ITERATIONS) {
+            break;
+        }
+
+        if (elapsed < BENCHMARK_SAMPLE_TIME * 0.1) {
+            iterations *= 10;
+        }
+    }
+
+    // Scale so one sample takes about BENCHMARK_SAMPLE_TIME.
+    f64 per_iteration = elapsed / iterations;
+    if (per_iteration > 0.0) {
+        f64 scaled = BENCHMARK_SAMPLE_TIME / per_iteration;
+        iterations = scaled < 1.0 ? 1 : (scaled > BENCHMARK_MAX_ITERATIONS ? BENCHMARK_MAX_ITERATIONS : (u64)scaled);
+    }
+
+    f64 samples[BENCHMARK_SAMPLE_COUNT];
+    for (u32 i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i) {
+        samples[i] = run_benchmark_once(func, iterations, &items_per_iteration) * 1e9 / iterations;
+    }
+
+    qsort(samples, BENCHMARK_SAMPLE_COUNT, sizeof(f64), compare_f64);
+    f64 median = samples[BENCHMARK_SAMPLE_COUNT / 2];
+
+    f64 deviations[BENCHMARK_SAMPLE_COUNT];
+    for (u32 i = 0; i < BENCHMARK_SAMPLE_COUNT; ++i) {
+        deviations[i] = samples[i] > median ? samples[i] - median : median - samples[i];
+    }
+    qsort(deviations, BENCHMARK_SAMPLE_COUNT, sizeof(f64), compare_f64);
+
+    result->iterations = iterations;
+    result->items_per_iteration = items_per_iteration;
+    result->median_ns = median;
+    result->mad_ns = deviations[BENCHMARK_SAMPLE_COUNT / 2];
+    result->min_ns = samples[0];
+    result->max_ns = samples[BENCHMARK_SAMPLE_COUNT - 1];
+}
+
+int compare_f64(void const* lhs, void const* rhs)
+{
+    f64 a = *(f64 const*)lhs;
+    f64 b = *(f64 const*)rhs;
+    return (a > b) - (a < b);
+}
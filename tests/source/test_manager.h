@@ -6,8 +6,53 @@
 
 typedef u8 (* PFN_test)();
 
+/**
+ * @brief State passed to a benchmark function.
+ * The function must run its measured body exactly _iterations_ times.
+ * Setup and teardown can be excluded from the measurement with benchmark_pause_timing()/benchmark_resume_timing().
+ */
+typedef struct benchmark_state {
+    u64 iterations;
+    /** @brief Optional. Work items per iteration (elements, bytes, ...), used to report throughput. */
+    u64 items_per_iteration;
+
+    f64 paused_time;
+    f64 pause_start;
+} benchmark_state;
+
+typedef void (* PFN_benchmark)(benchmark_state* state);
+
 void test_manager_init();
 
 void test_manager_register_test(PFN_test, char* desc);
 
 void test_manager_run_tests();
+
+/**
+ * @brief Registers a benchmark. Benchmarks only run through test_manager_run_benchmarks().
+ */
+void test_manager_register_benchmark(PFN_benchmark, char* desc);
+
+/**
+ * @brief Runs all registered benchmarks: warmup, iteration count scaled to a fixed sample time, then a fixed number of samples.
+ * Reports median and median absolute deviation (MAD) per iteration.
+ * @param output_path Path of the JSON report, or 0 to only log results. One benchmark per line, so reports can be diffed against a stored baseline.
+ */
+void test_manager_run_benchmarks(char const* output_path);
+
+void benchmark_pause_timing(benchmark_state* state);
+void benchmark_resume_timing(benchmark_state* state);
+
+/**
+ * @brief Makes the compiler assume the memory at _p_ is read, so computations producing it are not optimized away.
+ */
+void benchmark_escape(void const* p);
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BENCHMARK_DO_NOT_OPTIMIZE(value) benchmark_escape(&(value))
+#define BENCHMARK_CLOBBER() _ReadWriteBarrier()
+#else
+#define BENCHMARK_DO_NOT_OPTIMIZE(value) __asm__ volatile("" : : "g"(&(value)) : "memory")
+#define BENCHMARK_CLOBBER() __asm__ volatile("" : : : "memory")
+#endif